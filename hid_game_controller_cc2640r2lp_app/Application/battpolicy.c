@@ -0,0 +1,175 @@
+/******************************************************************************
+
+ @file       battpolicy.c
+
+ @brief This file contains the Battery Scaling Policy for the BLE Game
+        Controller. As the battery drains the report rate, connection
+        interval and TX power are stepped down to extend the runtime.
+        The policy only depends on the C library so it can be built and
+        exercised on a host.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Battery-aware scaling of the report rate, connection
+                        interval and TX power. Plain C without stack or RTOS
+                        dependencies.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stddef.h>
+
+#include "battpolicy.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Largest slave latency allowed by the Core specification
+#define BATTPOLICY_MAX_SLAVE_LATENCY      499
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Full rate until the battery is nearly empty
+static const battPolicyStep_t battPolicyPerformance[] =
+{
+    { 100,  80,  0,  0,   5 },
+    {  20, 120, 12, 24,   0 },
+    {  10, 160, 24, 40,  -6 }
+};
+
+// Default profile
+static const battPolicyStep_t battPolicyBalanced[] =
+{
+    { 100,  80,  0,  0,   5 },
+    {  50, 120, 12, 24,   0 },
+    {  25, 160, 24, 40,  -6 },
+    {  10, 240, 40, 80, -12 }
+};
+
+// Longest runtime, reduced rate even on a full battery
+static const battPolicyStep_t battPolicyEconomy[] =
+{
+    { 100, 120, 12,  24,   0 },
+    {  60, 160, 24,  40,  -3 },
+    {  30, 240, 40,  80,  -9 },
+    {  15, 320, 80, 120, -12 }
+};
+
+// Indexed by BATTPOLICY_PROFILE_*
+static const battPolicyProfile_t battPolicyProfiles[BATTPOLICY_NUM_PROFILES] =
+{
+    { battPolicyPerformance,
+      sizeof(battPolicyPerformance) / sizeof(battPolicyStep_t), 5, 5 },
+    { battPolicyBalanced,
+      sizeof(battPolicyBalanced) / sizeof(battPolicyStep_t), 5, 10 },
+    { battPolicyEconomy,
+      sizeof(battPolicyEconomy) / sizeof(battPolicyStep_t), 5, 15 }
+};
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      BattPolicy_getProfile
+ *
+ * @brief   Get a policy profile.
+ *
+ * @param   profile - BATTPOLICY_PROFILE_*
+ *
+ * @return  pointer to the profile, NULL if unknown
+ */
+const battPolicyProfile_t *BattPolicy_getProfile(uint8_t profile)
+{
+    if (profile >= BATTPOLICY_NUM_PROFILES)
+    {
+        return NULL;
+    }
+
+    return &battPolicyProfiles[profile];
+}
+
+/*********************************************************************
+ * @fn      BattPolicy_selectStep
+ *
+ * @brief   Select the step for a battery level.
+ *
+ * @param   pProfile - policy profile
+ * @param   level - battery level in percent
+ * @param   curStep - step in use, BATTPOLICY_STEP_NONE if none
+ *
+ * @return  index of the step to use
+ */
+uint8_t BattPolicy_selectStep(const battPolicyProfile_t *pProfile,
+                              uint8_t level, uint8_t curStep)
+{
+    const battPolicyStep_t *pSteps = pProfile->pSteps;
+    uint8_t step = (curStep < pProfile->numSteps) ? curStep : 0;
+
+    // Draining, move down as soon as a threshold is reached
+    while (((step + 1) < pProfile->numSteps) &&
+           (level <= pSteps[step + 1].level))
+    {
+        step++;
+    }
+
+    // Recovering (charger, cold battery warming up), move up only on a
+    // clear rise above the threshold of the current step
+    while ((step > 0) &&
+           ((uint16_t)level > (uint16_t)pSteps[step].level + pProfile->hysteresis))
+    {
+        step--;
+    }
+
+    return step;
+}
+
+/*********************************************************************
+ * @fn      BattPolicy_maxSlaveLatency
+ *
+ * @brief   Get the largest slave latency that still fits in a
+ *          supervision timeout at a connection interval. The timeout
+ *          must be larger than (1 + latency) * interval * 2.
+ *
+ * @param   connInterval - connection interval in units of 1.25 ms
+ * @param   connTimeout - supervision timeout in units of 10 ms
+ *
+ * @return  slave latency in connection events
+ */
+uint16_t BattPolicy_maxSlaveLatency(uint16_t connInterval,
+                                    uint16_t connTimeout)
+{
+    // In units of 1.25 ms: (1 + latency) * interval < timeout * 4
+    uint32_t events;
+
+    if ((connInterval == 0) || (connTimeout == 0))
+    {
+        return 0;
+    }
+
+    events = ((uint32_t)connTimeout * 4 - 1) / connInterval;
+
+    if (events <= 1)
+    {
+        return 0;
+    }
+
+    if ((events - 1) > BATTPOLICY_MAX_SLAVE_LATENCY)
+    {
+        return BATTPOLICY_MAX_SLAVE_LATENCY;
+    }
+
+    return (uint16_t)(events - 1);
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,128 @@
+/******************************************************************************
+
+ @file       battpolicy.h
+
+ @brief This file contains the Battery Scaling Policy definitions and
+        prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Battery-aware scaling of the report rate, connection
+                        interval and TX power. Plain C without stack or RTOS
+                        dependencies.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef BATTPOLICY_H
+#define BATTPOLICY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Policy profiles
+#define BATTPOLICY_PROFILE_PERFORMANCE    0  // Keep full rate as long as possible
+#define BATTPOLICY_PROFILE_BALANCED       1
+#define BATTPOLICY_PROFILE_ECONOMY        2  // Trade latency for runtime early
+#define BATTPOLICY_NUM_PROFILES           3
+
+// No step applied yet, the next BattPolicy_selectStep always reports a change
+#define BATTPOLICY_STEP_NONE              0xFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// One scaling step, applies while the battery level is at or below level
+typedef struct
+{
+    uint8_t  level;            // Threshold in percent
+    uint16_t samplePeriod;     // Minimum report period in ms
+    uint16_t minConnInterval;  // Units of 1.25 ms, 0 = keep negotiated
+    uint16_t maxConnInterval;  // Units of 1.25 ms, 0 = keep negotiated
+    int8_t   maxTxPower;       // TX power cap in dBm
+} battPolicyStep_t;
+
+// Policy profile, steps are ordered from full battery to empty
+typedef struct
+{
+    const battPolicyStep_t *pSteps;
+    uint8_t numSteps;
+    uint8_t hysteresis;        // Percent above a threshold to step back up
+    uint8_t criticalLevel;     // Battery service critical level in percent
+} battPolicyProfile_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      BattPolicy_getProfile
+ *
+ * @brief   Get a policy profile.
+ *
+ * @param   profile - BATTPOLICY_PROFILE_*
+ *
+ * @return  pointer to the profile, NULL if unknown
+ */
+const battPolicyProfile_t *BattPolicy_getProfile(uint8_t profile);
+
+/*********************************************************************
+ * @fn      BattPolicy_selectStep
+ *
+ * @brief   Select the step for a battery level. A step is entered once
+ *          the level reaches its threshold and left again only when the
+ *          level is more than the profile hysteresis above it.
+ *
+ * @param   pProfile - policy profile
+ * @param   level - battery level in percent
+ * @param   curStep - step in use, BATTPOLICY_STEP_NONE if none
+ *
+ * @return  index of the step to use
+ */
+uint8_t BattPolicy_selectStep(const battPolicyProfile_t *pProfile,
+                              uint8_t level, uint8_t curStep);
+
+/*********************************************************************
+ * @fn      BattPolicy_maxSlaveLatency
+ *
+ * @brief   Get the largest slave latency that still fits in a
+ *          supervision timeout at a connection interval.
+ *
+ * @param   connInterval - connection interval in units of 1.25 ms
+ * @param   connTimeout - supervision timeout in units of 10 ms
+ *
+ * @return  slave latency in connection events
+ */
+uint16_t BattPolicy_maxSlaveLatency(uint16_t connInterval,
+                                    uint16_t connTimeout);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATTPOLICY_H */
@@ -71,6 +71,8 @@
 #include "util.h"
 #include "board_key.h"
 #include "Board.h"
+#include "inputtrace.h"
+#include "profprobe.h"
 
 /*********************************************************************
  * TYPEDEFS
@@ -134,20 +136,9 @@ void Board_initKeys(keysPressedCB_t appKeyCB)
     hKeyPins = PIN_open(&keyPins, keyPinsCfg);
     PIN_registerIntCb(hKeyPins, Board_keyCallback);
 
-    PIN_setConfig(hKeyPins, PIN_BM_IRQ, Board_BTN1        | PIN_IRQ_NEGEDGE);
-    PIN_setConfig(hKeyPins, PIN_BM_IRQ, Board_BTN2        | PIN_IRQ_NEGEDGE);
-    PIN_setConfig(hKeyPins, PIN_BM_IRQ, EDUBP_MKII_BTN1   | PIN_IRQ_NEGEDGE);
-    PIN_setConfig(hKeyPins, PIN_BM_IRQ, EDUBP_MKII_BTN2   | PIN_IRQ_NEGEDGE);
+    Board_enableKeys(TRUE);
 
 
-#ifdef POWER_SAVING
-    //Enable wakeup
-    PIN_setConfig(hKeyPins, PINCC26XX_BM_WAKEUP, Board_BTN1       | PINCC26XX_WAKEUP_NEGEDGE);
-    PIN_setConfig(hKeyPins, PINCC26XX_BM_WAKEUP, Board_BTN2       | PINCC26XX_WAKEUP_NEGEDGE);
-    PIN_setConfig(hKeyPins, PINCC26XX_BM_WAKEUP, EDUBP_MKII_BTN1  | PINCC26XX_WAKEUP_NEGEDGE);
-    PIN_setConfig(hKeyPins, PINCC26XX_BM_WAKEUP, EDUBP_MKII_BTN2  | PINCC26XX_WAKEUP_NEGEDGE);
-#endif //POWER_SAVING
-
     // Setup keycallback for keys
     Util_constructClock(&keyChangeClock, Board_keyChangeHandler,
                       KEY_DEBOUNCE_TIMEOUT, 0, false, 0);
@@ -156,6 +147,44 @@ void Board_initKeys(keysPressedCB_t appKeyCB)
     appKeyChangeHandler = appKeyCB;
 }
 
+/*********************************************************************
+ * @fn      Board_enableKeys
+ *
+ * @brief   Arm or disarm the key interrupts and, with POWER_SAVING, the
+ *          wakeup from standby on a key press.
+ *
+ * @param   enable - TRUE to arm
+ *
+ * @return  none
+ */
+void Board_enableKeys(uint8_t enable)
+{
+    // Both edges, the gamepad report holds the buttons until released
+    uint32_t irq = enable ? PIN_IRQ_BOTHEDGES : PIN_IRQ_DIS;
+#ifdef POWER_SAVING
+    uint32_t wakeup = enable ? PINCC26XX_WAKEUP_NEGEDGE : PINCC26XX_NO_WAKEUP;
+#endif //POWER_SAVING
+
+    PIN_setConfig(hKeyPins, PIN_BM_IRQ, Board_BTN1        | irq);
+    PIN_setConfig(hKeyPins, PIN_BM_IRQ, Board_BTN2        | irq);
+    PIN_setConfig(hKeyPins, PIN_BM_IRQ, EDUBP_MKII_BTN1   | irq);
+    PIN_setConfig(hKeyPins, PIN_BM_IRQ, EDUBP_MKII_BTN2   | irq);
+
+#ifdef POWER_SAVING
+    //Enable wakeup
+    PIN_setConfig(hKeyPins, PINCC26XX_BM_WAKEUP, Board_BTN1       | wakeup);
+    PIN_setConfig(hKeyPins, PINCC26XX_BM_WAKEUP, Board_BTN2       | wakeup);
+    PIN_setConfig(hKeyPins, PINCC26XX_BM_WAKEUP, EDUBP_MKII_BTN1  | wakeup);
+    PIN_setConfig(hKeyPins, PINCC26XX_BM_WAKEUP, EDUBP_MKII_BTN2  | wakeup);
+#endif //POWER_SAVING
+
+    if (!enable)
+    {
+        // Nothing is reported for a key released while disarmed
+        Util_stopClock(&keyChangeClock);
+    }
+}
+
 /*********************************************************************
  * @fn      Board_keyCallback
  *
@@ -167,6 +196,8 @@ void Board_initKeys(keysPressedCB_t appKeyCB)
  */
 static void Board_keyCallback(PIN_Handle hPin, PIN_Id pinId)
 {
+    PROF_ENTER(KEY_CALLBACK);
+
     keysPressed = 0;
 
     if (PIN_getInputValue(EDUBP_MKII_BTN1) == 0)
@@ -189,7 +220,11 @@ static void Board_keyCallback(PIN_Handle hPin, PIN_Id pinId)
         keysPressed |= KEY_START;
     }
 
+    INPUT_TRACE_KEYS(keysPressed);
+
     Util_startClock(&keyChangeClock);
+
+    PROF_EXIT(KEY_CALLBACK);
 }
 
 /*********************************************************************
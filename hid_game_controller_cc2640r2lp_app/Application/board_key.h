@@ -102,6 +102,18 @@ typedef void (*keysPressedCB_t)(uint8_t keysPressed);
  */
 void Board_initKeys(keysPressedCB_t appKeyCB);
 
+/*********************************************************************
+ * @fn      Board_enableKeys
+ *
+ * @brief   Arm or disarm the key interrupts and, with POWER_SAVING, the
+ *          wakeup from standby on a key press.
+ *
+ * @param   enable - TRUE to arm
+ *
+ * @return  none
+ */
+void Board_enableKeys(uint8_t enable);
+
 /*********************************************************************
 *********************************************************************/
 
@@ -0,0 +1,399 @@
+/******************************************************************************
+
+ @file       cfgstore.c
+
+ @brief This file contains the Configuration Store for the BLE Game
+        Controller. The application registers its settings as items: a
+        value in RAM, which the application reads directly, and an SNV
+        record. A record holds a header with the layout version, the
+        length and a CRC, so a record of an older layout, a torn or a
+        corrupted one is not loaded and the item keeps its default.
+        Changes only update RAM; the first one starts a clock and all the
+        changes made until it expires are written in a single flush, run
+        by the application task while it is not held back, so a setting
+        switched back and forth costs one write, or none at all.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Configuration items kept in RAM and persisted in
+                        SNV as versioned records with a CRC, changes
+                        written together in one deferred flush.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include <ti/sysbios/knl/Clock.h>
+
+#include <icall.h>
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+#include "osal_snv.h"
+
+#include "util.h"
+#include "cfgstore.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// CRC-16/CCITT
+#define CFG_CRC_POLY                      0x1021
+#define CFG_CRC_INIT                      0xFFFF
+
+// Record header fields
+#define CFG_RECORD_VERSION                0
+#define CFG_RECORD_LEN                    1
+#define CFG_RECORD_CRC                    2
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Item table of the application
+static const cfgItem_t *pCfgItems = NULL;
+static uint8_t cfgNumItems = 0;
+static cfgFlushCB_t pfnCfgFlush = NULL;
+
+// Items changed since the last flush, one bit per item
+static uint8_t cfgDirty = 0;
+
+// Flush delay expired, and flush held back
+static volatile uint8_t cfgDue = FALSE;
+static volatile uint8_t cfgHold = FALSE;
+
+// Record being read or written
+static uint8_t cfgRecord[CFG_RECORD_HDR_LEN + CFG_MAX_ITEM_LEN];
+
+static cfgStats_t cfgStats;
+
+// Flush delay clock
+static Clock_Struct cfgClock;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void Cfg_clockHandler(UArg arg);
+static uint16_t Cfg_crc(const cfgItem_t *pItem, const uint8_t *pValue);
+static uint8_t Cfg_recordValid(const cfgItem_t *pItem);
+static uint8_t Cfg_write(const cfgItem_t *pItem);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Cfg_init
+ *
+ * @brief   Load the items from SNV. An item keeps its default when its
+ *          record is missing, of another version or length, fails the
+ *          CRC or the value check.
+ *
+ * @param   pItems - items, kept by the store
+ * @param   numItems - number of items, up to CFG_MAX_ITEMS
+ * @param   pfnFlush - called when the flush is due
+ *
+ * @return  none
+ */
+void Cfg_init(const cfgItem_t *pItems, uint8_t numItems,
+              cfgFlushCB_t pfnFlush)
+{
+    const cfgItem_t *pItem;
+    uint8_t i;
+
+    pCfgItems = pItems;
+    cfgNumItems = (numItems > CFG_MAX_ITEMS) ? CFG_MAX_ITEMS : numItems;
+    pfnCfgFlush = pfnFlush;
+    cfgDirty = 0;
+    cfgDue = FALSE;
+    cfgHold = FALSE;
+    memset(&cfgStats, 0, sizeof(cfgStats));
+
+    for (i = 0; i < cfgNumItems; i++)
+    {
+        pItem = &pCfgItems[i];
+
+        // Nothing stored yet
+        if ((pItem->len > CFG_MAX_ITEM_LEN) ||
+            (osal_snv_read(pItem->nvId, CFG_RECORD_HDR_LEN + pItem->len,
+                           cfgRecord) != SUCCESS))
+        {
+            continue;
+        }
+
+        if (Cfg_recordValid(pItem) &&
+            ((pItem->pfnValid == NULL) ||
+             pItem->pfnValid(&cfgRecord[CFG_RECORD_HDR_LEN])))
+        {
+            memcpy(pItem->pValue, &cfgRecord[CFG_RECORD_HDR_LEN], pItem->len);
+            cfgStats.loaded++;
+        }
+        else
+        {
+            cfgStats.rejected++;
+        }
+    }
+
+    Util_constructClock(&cfgClock, Cfg_clockHandler, CFG_FLUSH_DELAY, 0,
+                        false, 0);
+}
+
+/*********************************************************************
+ * @fn      Cfg_set
+ *
+ * @brief   Change the value of an item in RAM. The first change starts
+ *          the flush delay, the next ones go with the same flush.
+ *
+ * @param   item - index in the item table
+ * @param   pValue - new value, the item length
+ *
+ * @return  SUCCESS, INVALIDPARAMETER for an unknown item or a value the
+ *          check rejects
+ */
+uint8_t Cfg_set(uint8_t item, const void *pValue)
+{
+    const cfgItem_t *pItem;
+
+    if (item >= cfgNumItems)
+    {
+        return INVALIDPARAMETER;
+    }
+
+    pItem = &pCfgItems[item];
+
+    if ((pItem->pfnValid != NULL) && !pItem->pfnValid(pValue))
+    {
+        return INVALIDPARAMETER;
+    }
+
+    if (memcmp(pItem->pValue, pValue, pItem->len) == 0)
+    {
+        return SUCCESS;
+    }
+
+    memcpy(pItem->pValue, pValue, pItem->len);
+    cfgStats.changes++;
+
+    // A flush is pending already, or held back, the change goes with it
+    if (cfgDirty)
+    {
+        cfgStats.coalesced++;
+    }
+    else
+    {
+        Util_startClock(&cfgClock);
+    }
+
+    cfgDirty |= BV(item);
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Cfg_setHold
+ *
+ * @brief   Hold the flush back, e.g. during active play. A flush that
+ *          came due while held is requested when the hold ends.
+ *
+ * @param   hold - TRUE to hold
+ *
+ * @return  none
+ */
+void Cfg_setHold(uint8_t hold)
+{
+    cfgHold = hold;
+
+    if (!hold && cfgDue && (pfnCfgFlush != NULL))
+    {
+        pfnCfgFlush();
+    }
+}
+
+/*********************************************************************
+ * @fn      Cfg_flush
+ *
+ * @brief   Write the changed items now. A record that SNV already holds
+ *          is not written again.
+ *
+ * @return  none
+ */
+void Cfg_flush(void)
+{
+    uint8_t i;
+
+    Util_stopClock(&cfgClock);
+    cfgDue = FALSE;
+
+    if (!cfgDirty)
+    {
+        return;
+    }
+
+    cfgStats.flushes++;
+
+    for (i = 0; i < cfgNumItems; i++)
+    {
+        if ((cfgDirty & BV(i)) && Cfg_write(&pCfgItems[i]))
+        {
+            cfgDirty &= ~BV(i);
+        }
+    }
+
+    // Try the refused writes again after another delay
+    if (cfgDirty)
+    {
+        Util_startClock(&cfgClock);
+    }
+}
+
+/*********************************************************************
+ * @fn      Cfg_getStats
+ *
+ * @brief   Get the store statistics.
+ *
+ * @param   pStats - statistics are copied here
+ *
+ * @return  none
+ */
+void Cfg_getStats(cfgStats_t *pStats)
+{
+    *pStats = cfgStats;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Cfg_clockHandler
+ *
+ * @brief   Flush delay expired, request the flush unless held.
+ *
+ * @param   arg - not used
+ *
+ * @return  none
+ */
+static void Cfg_clockHandler(UArg arg)
+{
+    cfgDue = TRUE;
+
+    if (!cfgHold && (pfnCfgFlush != NULL))
+    {
+        pfnCfgFlush();
+    }
+}
+
+/*********************************************************************
+ * @fn      Cfg_crc
+ *
+ * @brief   CRC-16/CCITT of a record: the item ID, version and length and
+ *          the value. The ID keeps a record written under another ID
+ *          from being taken.
+ *
+ * @param   pItem - item
+ * @param   pValue - value
+ *
+ * @return  CRC
+ */
+static uint16_t Cfg_crc(const cfgItem_t *pItem, const uint8_t *pValue)
+{
+    uint16_t crc = CFG_CRC_INIT;
+    uint8_t hdr[3];
+    uint8_t i;
+    uint8_t j;
+    uint8_t byte;
+
+    hdr[0] = pItem->nvId;
+    hdr[1] = pItem->version;
+    hdr[2] = pItem->len;
+
+    for (i = 0; i < sizeof(hdr) + pItem->len; i++)
+    {
+        byte = (i < sizeof(hdr)) ? hdr[i] : pValue[i - sizeof(hdr)];
+        crc ^= (uint16_t)byte << 8;
+
+        for (j = 0; j < 8; j++)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ CFG_CRC_POLY) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/*********************************************************************
+ * @fn      Cfg_recordValid
+ *
+ * @brief   Check the record read into cfgRecord against an item.
+ *
+ * @param   pItem - item
+ *
+ * @return  TRUE if the version, length and CRC match
+ */
+static uint8_t Cfg_recordValid(const cfgItem_t *pItem)
+{
+    uint16_t crc = Cfg_crc(pItem, &cfgRecord[CFG_RECORD_HDR_LEN]);
+
+    return ((cfgRecord[CFG_RECORD_VERSION] == pItem->version) &&
+            (cfgRecord[CFG_RECORD_LEN] == pItem->len) &&
+            (cfgRecord[CFG_RECORD_CRC] == LO_UINT16(crc)) &&
+            (cfgRecord[CFG_RECORD_CRC + 1] == HI_UINT16(crc)));
+}
+
+/*********************************************************************
+ * @fn      Cfg_write
+ *
+ * @brief   Write the record of an item, unless SNV holds its value. SNV
+ *          appends the record and takes it once complete, a write cut
+ *          short by a reset leaves the previous record in place.
+ *
+ * @param   pItem - item
+ *
+ * @return  TRUE if SNV holds the value
+ */
+static uint8_t Cfg_write(const cfgItem_t *pItem)
+{
+    uint8_t len = CFG_RECORD_HDR_LEN + pItem->len;
+    uint16_t crc;
+
+    // Switched back to the stored value
+    if ((osal_snv_read(pItem->nvId, len, cfgRecord) == SUCCESS) &&
+        Cfg_recordValid(pItem) &&
+        (memcmp(&cfgRecord[CFG_RECORD_HDR_LEN], pItem->pValue,
+                pItem->len) == 0))
+    {
+        cfgStats.unchanged++;
+
+        return TRUE;
+    }
+
+    crc = Cfg_crc(pItem, pItem->pValue);
+
+    cfgRecord[CFG_RECORD_VERSION] = pItem->version;
+    cfgRecord[CFG_RECORD_LEN] = pItem->len;
+    cfgRecord[CFG_RECORD_CRC] = LO_UINT16(crc);
+    cfgRecord[CFG_RECORD_CRC + 1] = HI_UINT16(crc);
+    memcpy(&cfgRecord[CFG_RECORD_HDR_LEN], pItem->pValue, pItem->len);
+
+    if (osal_snv_write(pItem->nvId, len, cfgRecord) != SUCCESS)
+    {
+        cfgStats.failures++;
+
+        return FALSE;
+    }
+
+    cfgStats.writes++;
+    cfgStats.bytes += len;
+
+    return TRUE;
+}
+
+/*********************************************************************
+*********************************************************************/
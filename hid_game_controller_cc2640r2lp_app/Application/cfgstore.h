@@ -0,0 +1,164 @@
+/******************************************************************************
+
+ @file       cfgstore.h
+
+ @brief This file contains the Configuration Store definitions and
+        prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Configuration items kept in RAM and persisted in
+                        SNV as versioned records with a CRC, changes
+                        written together in one deferred flush.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef CFGSTORE_H
+#define CFGSTORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Delay from the first change to the flush in ms, the changes made in the
+// meantime are written with it
+#define CFG_FLUSH_DELAY                   5000
+
+// Items and the longest value
+#define CFG_MAX_ITEMS                     8
+#define CFG_MAX_ITEM_LEN                  32
+
+// Record header in SNV: version, value length and CRC-16 of the item ID,
+// the version, the length and the value, followed by the value
+#define CFG_RECORD_HDR_LEN                4
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Value check, TRUE if the value can be used
+typedef uint8_t (*cfgValidCB_t)(const void *pValue);
+
+// Called from the clock context when Cfg_flush should run
+typedef void (*cfgFlushCB_t)(void);
+
+// Configuration item
+typedef struct
+{
+    uint8_t nvId;           // SNV item ID, BLE_NVID_CUST_START to _END
+    uint8_t version;        // Layout version, other versions are not loaded
+    uint8_t len;            // Value length, up to CFG_MAX_ITEM_LEN
+    void *pValue;           // Value in RAM, holds the default until loaded
+    cfgValidCB_t pfnValid;  // Value check, NULL to take any value
+} cfgItem_t;
+
+// Store statistics
+typedef struct
+{
+    uint8_t  loaded;        // Items loaded from SNV at init
+    uint8_t  rejected;      // Records with a bad CRC, version, length or value
+    uint32_t changes;       // Changed values
+    uint32_t coalesced;     // Changes made while a flush was pending
+    uint32_t flushes;       // Flushes run
+    uint32_t writes;        // Records written
+    uint32_t unchanged;     // Records not written, SNV holds the value
+    uint32_t bytes;         // Bytes written
+    uint32_t failures;      // Writes SNV refused, retried at the next flush
+} cfgStats_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Cfg_init
+ *
+ * @brief   Load the items from SNV. An item keeps its default when its
+ *          record is missing, of another version or length, fails the
+ *          CRC or the value check.
+ *
+ * @param   pItems - items, kept by the store
+ * @param   numItems - number of items, up to CFG_MAX_ITEMS
+ * @param   pfnFlush - called when the flush is due
+ *
+ * @return  none
+ */
+void Cfg_init(const cfgItem_t *pItems, uint8_t numItems,
+              cfgFlushCB_t pfnFlush);
+
+/*********************************************************************
+ * @fn      Cfg_set
+ *
+ * @brief   Change the value of an item in RAM. The first change starts
+ *          the flush delay, the next ones go with the same flush.
+ *
+ * @param   item - index in the item table
+ * @param   pValue - new value, the item length
+ *
+ * @return  SUCCESS, INVALIDPARAMETER for an unknown item or a value the
+ *          check rejects
+ */
+uint8_t Cfg_set(uint8_t item, const void *pValue);
+
+/*********************************************************************
+ * @fn      Cfg_setHold
+ *
+ * @brief   Hold the flush back, e.g. during active play. A flush that
+ *          came due while held is requested when the hold ends.
+ *
+ * @param   hold - TRUE to hold
+ *
+ * @return  none
+ */
+void Cfg_setHold(uint8_t hold);
+
+/*********************************************************************
+ * @fn      Cfg_flush
+ *
+ * @brief   Write the changed items now. A record that SNV already holds
+ *          is not written again.
+ *
+ * @return  none
+ */
+void Cfg_flush(void);
+
+/*********************************************************************
+ * @fn      Cfg_getStats
+ *
+ * @brief   Get the store statistics.
+ *
+ * @param   pStats - statistics are copied here
+ *
+ * @return  none
+ */
+void Cfg_getStats(cfgStats_t *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFGSTORE_H */
@@ -0,0 +1,491 @@
+/******************************************************************************
+
+ @file       dashboard.c
+
+ @brief This file contains the Status Dashboard for the BLE Game Controller.
+        It shows the controller state on the LCD of the BoosterPack MKII:
+        power and connection state, link quality, battery, protocol and
+        input modes, the input report rate, the key to report latency
+        percentiles and the cost of drawing a frame.
+
+        The labels are written once, a refresh only writes the values and
+        the LCD Text Display sends the cells that changed. Refreshes come
+        from a clock, which caps the frame rate.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Status dashboard on the LCD of the BoosterPack MKII:
+                        connection, battery, report rate, input latency
+                        percentiles, link quality and the drawing cost,
+                        refreshed at a capped rate.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ti/sysbios/knl/Clock.h>
+
+#include <icall.h>
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "util.h"
+#include "hiddev.h"
+#include "powergov.h"
+#include "linkmonitor.h"
+#include "tilt.h"
+#include "dashboard.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Rows, and the column and width of the values
+#define DASH_ROW_TITLE                    0
+#define DASH_ROW_STATE                    2
+#define DASH_ROW_LINK                     3
+#define DASH_ROW_BATT                     4
+#define DASH_ROW_MODE                     5
+#define DASH_ROW_RATE                     7
+#define DASH_ROW_LAT                      8     // P50, P90 and P99 below
+#define DASH_ROW_DRAW                     12
+#define DASH_ROW_FRAME                    13
+#define DASH_ROW_CELLS                    14
+
+#define DASH_VALUE_COL                    8
+#define DASH_VALUE_WIDTH                  (LCDTEXT_COLS - DASH_VALUE_COL)
+
+// Battery levels shown in yellow and red
+#define DASH_BATT_LOW                     50
+#define DASH_BATT_CRITICAL                20
+
+// Latency percentiles shown
+#define DASH_NUM_PERCENTILES              3
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static dashStatusCB_t pfnDashStatusCB = NULL;
+static lcdTextWakeCB_t pfnDashWakeCB = NULL;
+
+// Refresh clock
+static Clock_Struct dashClock;
+
+static uint8_t dashActive = FALSE;
+static volatile uint8_t dashRefreshDue = FALSE;
+static uint8_t dashFlushPending = FALSE;
+
+// Reports sent and clock ticks at the last refresh, for the report rate
+static uint32_t dashLastReports;
+static uint32_t dashLastTick;
+
+// Latency histogram
+static uint16_t dashLatCounts[DASH_LAT_BUCKETS];
+static uint16_t dashLatTotal = 0;
+
+static const char * const dashPowerNames[POWERGOV_NUM_STATES] =
+{
+    "SLEEP", "ADVERTISING", "IDLE", "ACTIVE", "SUSPENDED"
+};
+
+static const uint8_t dashPowerColors[POWERGOV_NUM_STATES] =
+{
+    LCDTEXT_COLOR_WHITE, LCDTEXT_COLOR_YELLOW, LCDTEXT_COLOR_GREEN,
+    LCDTEXT_COLOR_GREEN, LCDTEXT_COLOR_WHITE
+};
+
+static const char * const dashLinkNames[] =
+{
+    "GOOD", "MARGINAL", "DEGRADED"
+};
+
+static const uint8_t dashLinkColors[] =
+{
+    LCDTEXT_COLOR_GREEN, LCDTEXT_COLOR_YELLOW, LCDTEXT_COLOR_RED
+};
+
+static const char * const dashTiltNames[TILT_NUM_MODES] =
+{
+    "", " +TILT", " TILT"
+};
+
+static const uint8_t dashPercentiles[DASH_NUM_PERCENTILES] = { 50, 90, 99 };
+
+static const char * const dashLatLabels[DASH_NUM_PERCENTILES] =
+{
+    "LAT P50", "    P90", "    P99"
+};
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void Dash_clockHandler(UArg arg);
+static void Dash_refresh(void);
+static uint8_t Dash_percentile(uint8_t percent);
+static char *Dash_append(char *p, const char *pStr);
+static char *Dash_appendNum(char *p, uint32_t value);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Dash_init
+ *
+ * @brief   Set up the LCD, draw the labels and start the refresh clock.
+ *
+ * @param   pfnStatus - fills in the state at a refresh
+ * @param   pfnWake - called when Dash_process should run
+ *
+ * @return  none
+ */
+void Dash_init(dashStatusCB_t pfnStatus, lcdTextWakeCB_t pfnWake)
+{
+    uint8_t i;
+
+    pfnDashStatusCB = pfnStatus;
+    pfnDashWakeCB = pfnWake;
+
+    LcdText_init(pfnWake);
+
+    LcdText_puts(DASH_ROW_TITLE, 1, "BLE GAME CONTROLLER", 0,
+                 LCDTEXT_COLOR_WHITE);
+    LcdText_puts(DASH_ROW_STATE, 0, "STATE", 0, LCDTEXT_COLOR_WHITE);
+    LcdText_puts(DASH_ROW_LINK, 0, "LINK", 0, LCDTEXT_COLOR_WHITE);
+    LcdText_puts(DASH_ROW_BATT, 0, "BATT", 0, LCDTEXT_COLOR_WHITE);
+    LcdText_puts(DASH_ROW_MODE, 0, "MODE", 0, LCDTEXT_COLOR_WHITE);
+    LcdText_puts(DASH_ROW_RATE, 0, "RATE", 0, LCDTEXT_COLOR_WHITE);
+    LcdText_puts(DASH_ROW_DRAW, 0, "DRAW", 0, LCDTEXT_COLOR_WHITE);
+    LcdText_puts(DASH_ROW_FRAME, 0, "FRAME", 0, LCDTEXT_COLOR_WHITE);
+    LcdText_puts(DASH_ROW_CELLS, 0, "CELLS", 0, LCDTEXT_COLOR_WHITE);
+
+    for (i = 0; i < DASH_NUM_PERCENTILES; i++)
+    {
+        LcdText_puts(DASH_ROW_LAT + i, 0, dashLatLabels[i], 0,
+                     LCDTEXT_COLOR_WHITE);
+    }
+
+    dashLastReports = 0;
+    dashLastTick = Clock_getTicks();
+
+    Util_constructClock(&dashClock, Dash_clockHandler, DASH_PERIOD, 0, false,
+                        0);
+
+    Dash_setActive(TRUE);
+}
+
+/*********************************************************************
+ * @fn      Dash_process
+ *
+ * @brief   Refresh the values when due and run a slice of the drawing.
+ *
+ * @return  none
+ */
+void Dash_process(void)
+{
+    if (dashRefreshDue)
+    {
+        dashRefreshDue = FALSE;
+
+        if (dashActive)
+        {
+            Util_restartClock(&dashClock, DASH_PERIOD);
+        }
+
+        Dash_refresh();
+        dashFlushPending = TRUE;
+    }
+
+    LcdText_process();
+
+    // A refresh during a frame is drawn after it
+    if (dashFlushPending)
+    {
+        dashFlushPending = !LcdText_flush();
+    }
+}
+
+/*********************************************************************
+ * @fn      Dash_setActive
+ *
+ * @brief   Start or stop the refresh. The state is drawn once more when
+ *          it stops, nothing is drawn after.
+ *
+ * @param   active - TRUE to refresh
+ *
+ * @return  none
+ */
+void Dash_setActive(uint8_t active)
+{
+    if (!active)
+    {
+        Util_stopClock(&dashClock);
+    }
+
+    dashActive = active;
+    dashRefreshDue = TRUE;
+    pfnDashWakeCB();
+}
+
+/*********************************************************************
+ * @fn      Dash_addLatency
+ *
+ * @brief   Add an input latency sample to the histogram.
+ *
+ * @param   us - input to report time, in us
+ *
+ * @return  none
+ */
+void Dash_addLatency(uint32_t us)
+{
+    uint32_t bucket = us / DASH_LAT_BUCKET_US;
+    uint8_t i;
+
+    if (bucket >= DASH_LAT_BUCKETS)
+    {
+        bucket = DASH_LAT_BUCKETS - 1;
+    }
+
+    dashLatCounts[bucket]++;
+
+    if (++dashLatTotal >= DASH_LAT_WINDOW)
+    {
+        dashLatTotal = 0;
+
+        for (i = 0; i < DASH_LAT_BUCKETS; i++)
+        {
+            dashLatCounts[i] /= 2;
+            dashLatTotal += dashLatCounts[i];
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Dash_clockHandler
+ *
+ * @brief   Refresh clock callback, in the clock context.
+ *
+ * @param   arg - ignored
+ *
+ * @return  none
+ */
+static void Dash_clockHandler(UArg arg)
+{
+    dashRefreshDue = TRUE;
+    pfnDashWakeCB();
+}
+
+/*********************************************************************
+ * @fn      Dash_refresh
+ *
+ * @brief   Write the values. Unchanged values leave the cells as they are.
+ *
+ * @return  none
+ */
+static void Dash_refresh(void)
+{
+    dashStatus_t status;
+    lcdTextStats_t stats;
+    char text[LCDTEXT_COLS + 1];
+    char *p;
+    uint32_t now = Clock_getTicks();
+    uint32_t elapsedMs = ((now - dashLastTick) * Clock_tickPeriod) / 1000;
+    uint8_t bucket;
+    uint8_t color;
+    uint8_t i;
+
+    pfnDashStatusCB(&status);
+    LcdText_getStats(&stats);
+
+    if (status.powerState < POWERGOV_NUM_STATES)
+    {
+        LcdText_puts(DASH_ROW_STATE, DASH_VALUE_COL,
+                     dashPowerNames[status.powerState], DASH_VALUE_WIDTH,
+                     dashPowerColors[status.powerState]);
+    }
+
+    if (status.connected && (status.linkState <= LINKMON_STATE_DEGRADED))
+    {
+        LcdText_puts(DASH_ROW_LINK, DASH_VALUE_COL,
+                     dashLinkNames[status.linkState], DASH_VALUE_WIDTH,
+                     dashLinkColors[status.linkState]);
+    }
+    else
+    {
+        LcdText_puts(DASH_ROW_LINK, DASH_VALUE_COL, "--", DASH_VALUE_WIDTH,
+                     LCDTEXT_COLOR_WHITE);
+    }
+
+    p = Dash_append(Dash_appendNum(text, status.battLevel), "%");
+    color = (status.battLevel < DASH_BATT_CRITICAL) ? LCDTEXT_COLOR_RED :
+            (status.battLevel < DASH_BATT_LOW) ? LCDTEXT_COLOR_YELLOW :
+            LCDTEXT_COLOR_GREEN;
+    LcdText_puts(DASH_ROW_BATT, DASH_VALUE_COL, text, DASH_VALUE_WIDTH, color);
+
+    p = Dash_append(text, (status.protocolMode == HID_PROTOCOL_MODE_BOOT) ?
+                    "BOOT" : "RPT");
+    p = Dash_append(p, status.pointerMode ? " PTR" : " PAD");
+    if (status.tiltMode < TILT_NUM_MODES)
+    {
+        p = Dash_append(p, dashTiltNames[status.tiltMode]);
+    }
+    LcdText_puts(DASH_ROW_MODE, DASH_VALUE_COL, text, DASH_VALUE_WIDTH,
+                 LCDTEXT_COLOR_WHITE);
+
+    // Reports per second since the last refresh
+    p = Dash_appendNum(text, (elapsedMs != 0) ?
+                       ((status.reportsSent - dashLastReports) * 1000 +
+                        elapsedMs / 2) / elapsedMs : 0);
+    p = Dash_append(p, "/S");
+    LcdText_puts(DASH_ROW_RATE, DASH_VALUE_COL, text, DASH_VALUE_WIDTH,
+                 LCDTEXT_COLOR_WHITE);
+    dashLastReports = status.reportsSent;
+    dashLastTick = now;
+
+    // Upper edge of the bucket holding the percentile
+    for (i = 0; i < DASH_NUM_PERCENTILES; i++)
+    {
+        if (dashLatTotal == 0)
+        {
+            p = Dash_append(text, "--");
+        }
+        else
+        {
+            bucket = Dash_percentile(dashPercentiles[i]);
+            p = Dash_append(text, (bucket == DASH_LAT_BUCKETS - 1) ? ">" : "");
+            p = Dash_appendNum(p, ((uint32_t)(bucket + (bucket <
+                                   DASH_LAT_BUCKETS - 1)) *
+                                   DASH_LAT_BUCKET_US) / 1000);
+            p = Dash_append(p, "MS");
+        }
+
+        LcdText_puts(DASH_ROW_LAT + i, DASH_VALUE_COL, text, DASH_VALUE_WIDTH,
+                     LCDTEXT_COLOR_WHITE);
+    }
+
+    // Slice time of the last frame and the longest, its start to end time
+    // with the transfers and the cells it sent
+    if (stats.frames == 0)
+    {
+        p = Dash_append(text, "--");
+    }
+    else
+    {
+        p = Dash_append(Dash_appendNum(text, stats.lastCpuUs), "/");
+        p = Dash_append(Dash_appendNum(p, stats.maxCpuUs), "US");
+    }
+    LcdText_puts(DASH_ROW_DRAW, DASH_VALUE_COL, text, DASH_VALUE_WIDTH,
+                 LCDTEXT_COLOR_WHITE);
+
+    if (stats.frames == 0)
+    {
+        p = Dash_append(text, "--");
+    }
+    else
+    {
+        p = Dash_append(Dash_appendNum(text, stats.lastFrameUs / 1000),
+                        "MS");
+    }
+    LcdText_puts(DASH_ROW_FRAME, DASH_VALUE_COL, text, DASH_VALUE_WIDTH,
+                 LCDTEXT_COLOR_WHITE);
+
+    if (stats.frames == 0)
+    {
+        p = Dash_append(text, "--");
+    }
+    else
+    {
+        p = Dash_appendNum(text, stats.lastCells);
+    }
+    LcdText_puts(DASH_ROW_CELLS, DASH_VALUE_COL, text, DASH_VALUE_WIDTH,
+                 LCDTEXT_COLOR_WHITE);
+}
+
+/*********************************************************************
+ * @fn      Dash_percentile
+ *
+ * @brief   Bucket of the latency histogram holding a percentile.
+ *
+ * @param   percent - percentile, 1 to 100
+ *
+ * @return  Bucket, 0 to DASH_LAT_BUCKETS - 1
+ */
+static uint8_t Dash_percentile(uint8_t percent)
+{
+    uint32_t rank = ((uint32_t)dashLatTotal * percent + 99) / 100;
+    uint32_t sum = 0;
+    uint8_t i;
+
+    for (i = 0; i < DASH_LAT_BUCKETS - 1; i++)
+    {
+        sum += dashLatCounts[i];
+        if (sum >= rank)
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/*********************************************************************
+ * @fn      Dash_append
+ *
+ * @brief   Copy a string, for building a value.
+ *
+ * @param   p - end of the value so far
+ * @param   pStr - string
+ *
+ * @return  New end of the value, terminated
+ */
+static char *Dash_append(char *p, const char *pStr)
+{
+    while (*pStr != '\0')
+    {
+        *p++ = *pStr++;
+    }
+
+    *p = '\0';
+
+    return p;
+}
+
+/*********************************************************************
+ * @fn      Dash_appendNum
+ *
+ * @brief   Write a number in decimal, for building a value.
+ *
+ * @param   p - end of the value so far
+ * @param   value - number
+ *
+ * @return  New end of the value, terminated
+ */
+static char *Dash_appendNum(char *p, uint32_t value)
+{
+    char digits[10];
+    uint8_t n = 0;
+
+    do
+    {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    while (n != 0)
+    {
+        *p++ = digits[--n];
+    }
+
+    *p = '\0';
+
+    return p;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,131 @@
+/******************************************************************************
+
+ @file       dashboard.h
+
+ @brief This file contains the Status Dashboard definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Status dashboard on the LCD of the BoosterPack MKII:
+                        connection, battery, report rate, input latency
+                        percentiles, link quality and the drawing cost,
+                        refreshed at a capped rate.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+#include "lcdtext.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Refresh period in ms, no more frames are drawn
+#define DASH_PERIOD                       250
+
+// Input latency histogram: bucket width in us and number of buckets, the
+// last one takes all the longer latencies. The counts are halved once
+// their sum reaches the window, recent input weighs most.
+#define DASH_LAT_BUCKET_US                4000
+#define DASH_LAT_BUCKETS                  32
+#define DASH_LAT_WINDOW                   256
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// State shown, read at every refresh
+typedef struct
+{
+    uint8_t  powerState;    // POWERGOV_STATE_*
+    uint8_t  connected;     // TRUE while connected
+    uint8_t  linkState;     // LINKMON_STATE_*, while connected
+    uint8_t  battLevel;     // Battery level in percent
+    uint8_t  protocolMode;  // HID_PROTOCOL_MODE_*
+    uint8_t  pointerMode;   // TRUE in pointer mode
+    uint8_t  tiltMode;      // TILT_MODE_*
+    uint32_t reportsSent;   // Input reports sent
+} dashStatus_t;
+
+// Called from the application task to fill in the state
+typedef void (*dashStatusCB_t)(dashStatus_t *pStatus);
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Dash_init
+ *
+ * @brief   Set up the LCD, draw the labels and start the refresh clock.
+ *
+ * @param   pfnStatus - fills in the state at a refresh
+ * @param   pfnWake - called when Dash_process should run
+ *
+ * @return  none
+ */
+void Dash_init(dashStatusCB_t pfnStatus, lcdTextWakeCB_t pfnWake);
+
+/*********************************************************************
+ * @fn      Dash_process
+ *
+ * @brief   Refresh the values when due and run a slice of the drawing.
+ *
+ * @return  none
+ */
+void Dash_process(void);
+
+/*********************************************************************
+ * @fn      Dash_setActive
+ *
+ * @brief   Start or stop the refresh. The state is drawn once more when
+ *          it stops, nothing is drawn after.
+ *
+ * @param   active - TRUE to refresh
+ *
+ * @return  none
+ */
+void Dash_setActive(uint8_t active);
+
+/*********************************************************************
+ * @fn      Dash_addLatency
+ *
+ * @brief   Add an input latency sample to the histogram.
+ *
+ * @param   us - input to report time, in us
+ *
+ * @return  none
+ */
+void Dash_addLatency(uint32_t us);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DASHBOARD_H */
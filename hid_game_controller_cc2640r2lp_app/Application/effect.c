@@ -0,0 +1,398 @@
+/******************************************************************************
+
+ @file       effect.c
+
+ @brief This file contains the Effect Engine for the BLE Game Controller.
+        It plays the feedback effects of the host on the buzzer of the
+        BoosterPack MKII: a tone on a GPTimer PWM output, with the strength
+        set by the duty cycle and stepped through the attack and fade from
+        a clock. Queued effects follow each other from the clock too, so
+        the application task only starts and stops effects.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Buzzer feedback effects of the host, tones with an
+                        attack and fade envelope played on a GPTimer PWM
+                        output from a clock, with a small effect queue.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/drivers/PWM.h>
+
+#include <icall.h>
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "util.h"
+#include "Board.h"
+#include "effect.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Tone of the PWM output until the first effect, in Hz
+#define EFFECT_DEFAULT_FREQ               2000
+
+// Duty cycle of full strength, a square wave is loudest at half duty
+#define EFFECT_DUTY_MAX                   (PWM_DUTY_FRACTION_MAX / 2)
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static PWM_Handle effectPwm = NULL;
+
+// TRUE while the PWM output runs
+static uint8_t effectRunning = FALSE;
+
+// Strength last set on the output
+static uint8_t effectDuty = 0;
+
+// Effect in play and the time into it, in ms
+static effect_t effectCur;
+static uint16_t effectTime = 0;
+static uint8_t effectPlaying = FALSE;
+
+// Effects waiting, a ring from effectHead
+static effect_t effectQueue[EFFECT_QUEUE_LEN];
+static uint8_t effectHead = 0;
+static uint8_t effectCount = 0;
+
+// Step clock
+static Clock_Struct effectClock;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void Effect_clockHandler(UArg arg);
+static void Effect_begin(const effect_t *pEffect);
+static void Effect_step(void);
+static void Effect_next(void);
+static void Effect_setLevel(uint8_t level);
+static void Effect_silence(void);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Effect_init
+ *
+ * @brief   Open the PWM output of the buzzer and construct the step
+ *          clock. The buzzer stays silent.
+ *
+ * @return  none
+ */
+void Effect_init(void)
+{
+    PWM_Params params;
+
+    PWM_init();
+    PWM_Params_init(&params);
+    params.idleLevel = PWM_IDLE_LOW;
+    params.periodUnits = PWM_PERIOD_HZ;
+    params.periodValue = EFFECT_DEFAULT_FREQ;
+    params.dutyUnits = PWM_DUTY_FRACTION;
+    params.dutyValue = 0;
+
+    // Without the output the effects still play out silently
+    effectPwm = PWM_open(EDUBP_MKII_BUZZER_PWM, &params);
+
+    effectPlaying = FALSE;
+    effectHead = 0;
+    effectCount = 0;
+
+    Util_constructClock(&effectClock, Effect_clockHandler,
+                        EFFECT_STEP_PERIOD, 0, false, 0);
+}
+
+/*********************************************************************
+ * @fn      Effect_play
+ *
+ * @brief   Play an effect at once or after the queued ones. The attack
+ *          and fade are shortened to fit the duration.
+ *
+ * @param   pEffect - effect
+ * @param   mode - EFFECT_PLAY_NOW or EFFECT_PLAY_QUEUED
+ *
+ * @return  SUCCESS, INVALIDPARAMETER for a frequency or duration out of
+ *          the limits, or bleNoResources when the queue is full
+ */
+uint8_t Effect_play(const effect_t *pEffect, uint8_t mode)
+{
+    UInt key;
+
+    if ((pEffect->freq < EFFECT_MIN_FREQ) ||
+        (pEffect->freq > EFFECT_MAX_FREQ) ||
+        (pEffect->duration == 0) ||
+        (pEffect->duration > EFFECT_MAX_DURATION))
+    {
+        return INVALIDPARAMETER;
+    }
+
+    if (mode == EFFECT_PLAY_NOW)
+    {
+        // The clock is stopped first, the handler does not run while the
+        // effect changes
+        Util_stopClock(&effectClock);
+        effectCount = 0;
+    }
+    else
+    {
+        // The clock handler can end the effect in play between the check
+        // and the queueing otherwise
+        key = Hwi_disable();
+
+        if (effectPlaying)
+        {
+            if (effectCount == EFFECT_QUEUE_LEN)
+            {
+                Hwi_restore(key);
+
+                return bleNoResources;
+            }
+
+            effectQueue[(effectHead + effectCount) % EFFECT_QUEUE_LEN] =
+                *pEffect;
+            effectCount++;
+            Hwi_restore(key);
+
+            return SUCCESS;
+        }
+
+        Hwi_restore(key);
+    }
+
+    Effect_begin(pEffect);
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      Effect_stop
+ *
+ * @brief   Silence the buzzer, drop the queued effects and stop the PWM
+ *          output.
+ *
+ * @return  none
+ */
+void Effect_stop(void)
+{
+    Util_stopClock(&effectClock);
+
+    effectCount = 0;
+    effectPlaying = FALSE;
+    Effect_silence();
+}
+
+/*********************************************************************
+ * @fn      Effect_level
+ *
+ * @brief   Strength of an effect at a time into it.
+ *
+ * @param   pEffect - effect, with an envelope that fits the duration
+ * @param   time - time since the start of the effect, in ms
+ * @param   pHold - time the strength holds, in ms, 0 at the end
+ *
+ * @return  Strength, 0 to EFFECT_LEVEL_MAX
+ */
+uint8_t Effect_level(const effect_t *pEffect, uint16_t time, uint16_t *pHold)
+{
+    uint16_t fadeStart = pEffect->duration - pEffect->fade;
+    uint16_t left;
+
+    if (time >= pEffect->duration)
+    {
+        *pHold = 0;
+        return 0;
+    }
+
+    // Rise from silence over the attack
+    if (time < pEffect->attack)
+    {
+        left = pEffect->attack - time;
+        *pHold = (left > EFFECT_STEP_PERIOD) ? EFFECT_STEP_PERIOD : left;
+
+        return (uint8_t)(((uint32_t)pEffect->level * time) /
+                         pEffect->attack);
+    }
+
+    // Full strength up to the fade
+    if (time < fadeStart)
+    {
+        *pHold = fadeStart - time;
+
+        return pEffect->level;
+    }
+
+    // Fall to silence at the end
+    left = pEffect->duration - time;
+    *pHold = (left > EFFECT_STEP_PERIOD) ? EFFECT_STEP_PERIOD : left;
+
+    return (uint8_t)(((uint32_t)pEffect->level * left) / pEffect->fade);
+}
+
+/*********************************************************************
+ * @fn      Effect_clockHandler
+ *
+ * @brief   Step clock callback, in the clock context.
+ *
+ * @param   arg - ignored
+ *
+ * @return  none
+ */
+static void Effect_clockHandler(UArg arg)
+{
+    Effect_step();
+}
+
+/*********************************************************************
+ * @fn      Effect_begin
+ *
+ * @brief   Start an effect: fit the envelope to the duration and tune the
+ *          output to its frequency.
+ *
+ * @param   pEffect - effect
+ *
+ * @return  none
+ */
+static void Effect_begin(const effect_t *pEffect)
+{
+    effectCur = *pEffect;
+    effectTime = 0;
+    effectPlaying = TRUE;
+
+    if (effectCur.attack > effectCur.duration)
+    {
+        effectCur.attack = effectCur.duration;
+    }
+
+    if (effectCur.fade > effectCur.duration - effectCur.attack)
+    {
+        effectCur.fade = effectCur.duration - effectCur.attack;
+    }
+
+    if (effectPwm != NULL)
+    {
+        // The duty is kept in timer counts, it is set again for the new
+        // period
+        Effect_setLevel(0);
+        PWM_setPeriod(effectPwm, effectCur.freq);
+
+        if (!effectRunning)
+        {
+            PWM_start(effectPwm);
+            effectRunning = TRUE;
+        }
+    }
+
+    Effect_step();
+}
+
+/*********************************************************************
+ * @fn      Effect_step
+ *
+ * @brief   Set the strength of the current time of the effect and wait
+ *          for its next change, or go on to the next effect at the end.
+ *
+ * @return  none
+ */
+static void Effect_step(void)
+{
+    uint16_t hold;
+    uint8_t level = Effect_level(&effectCur, effectTime, &hold);
+
+    if (hold == 0)
+    {
+        Effect_next();
+        return;
+    }
+
+    Effect_setLevel(level);
+
+    effectTime += hold;
+    Util_restartClock(&effectClock, hold);
+}
+
+/*********************************************************************
+ * @fn      Effect_next
+ *
+ * @brief   Start the next queued effect, or silence the buzzer when there
+ *          is none.
+ *
+ * @return  none
+ */
+static void Effect_next(void)
+{
+    effect_t next;
+    UInt key = Hwi_disable();
+
+    if (effectCount == 0)
+    {
+        effectPlaying = FALSE;
+        Hwi_restore(key);
+
+        Effect_silence();
+        return;
+    }
+
+    next = effectQueue[effectHead];
+    effectHead = (effectHead + 1) % EFFECT_QUEUE_LEN;
+    effectCount--;
+    Hwi_restore(key);
+
+    Effect_begin(&next);
+}
+
+/*********************************************************************
+ * @fn      Effect_setLevel
+ *
+ * @brief   Set the duty cycle of a strength. The output is only written
+ *          when the strength changes.
+ *
+ * @param   level - strength, 0 to EFFECT_LEVEL_MAX
+ *
+ * @return  none
+ */
+static void Effect_setLevel(uint8_t level)
+{
+    if ((level != effectDuty) && (effectPwm != NULL))
+    {
+        PWM_setDuty(effectPwm,
+                    (uint32_t)(((uint64_t)EFFECT_DUTY_MAX * level) /
+                               EFFECT_LEVEL_MAX));
+        effectDuty = level;
+    }
+}
+
+/*********************************************************************
+ * @fn      Effect_silence
+ *
+ * @brief   Silence the buzzer and stop the PWM output, the GPTimer can
+ *          power down.
+ *
+ * @return  none
+ */
+static void Effect_silence(void)
+{
+    Effect_setLevel(0);
+
+    if (effectRunning)
+    {
+        PWM_stop(effectPwm);
+        effectRunning = FALSE;
+    }
+}
+
+/*********************************************************************
+*********************************************************************/
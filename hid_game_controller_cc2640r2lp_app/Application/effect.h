@@ -0,0 +1,136 @@
+/******************************************************************************
+
+ @file       effect.h
+
+ @brief This file contains the Effect Engine definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Buzzer feedback effects of the host, tones with an
+                        attack and fade envelope played on a GPTimer PWM
+                        output from a clock, with a small effect queue.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef EFFECT_H
+#define EFFECT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Tone frequency limits, in Hz
+#define EFFECT_MIN_FREQ                   50
+#define EFFECT_MAX_FREQ                   10000
+
+// Longest effect, in ms
+#define EFFECT_MAX_DURATION               10000
+
+// Full strength of an effect
+#define EFFECT_LEVEL_MAX                  255
+
+// Attack and fade step, in ms
+#define EFFECT_STEP_PERIOD                10
+
+// Effects waiting behind the one in play
+#define EFFECT_QUEUE_LEN                  4
+
+// Play modes
+#define EFFECT_PLAY_NOW                   0   // Drop the queue and play
+#define EFFECT_PLAY_QUEUED                1   // Play after the queued ones
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Effect: a tone, the strength rises over the attack and falls over the
+// fade at the end of the duration
+typedef struct
+{
+    uint16_t freq;                          // Tone frequency in Hz
+    uint16_t duration;                      // Length in ms
+    uint16_t attack;                        // Rise time in ms
+    uint16_t fade;                          // Fall time in ms
+    uint8_t  level;                         // Strength, 0 is a pause
+} effect_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Effect_init
+ *
+ * @brief   Open the PWM output of the buzzer and construct the step
+ *          clock. The buzzer stays silent.
+ *
+ * @return  none
+ */
+void Effect_init(void);
+
+/*********************************************************************
+ * @fn      Effect_play
+ *
+ * @brief   Play an effect at once or after the queued ones. The attack
+ *          and fade are shortened to fit the duration.
+ *
+ * @param   pEffect - effect
+ * @param   mode - EFFECT_PLAY_NOW or EFFECT_PLAY_QUEUED
+ *
+ * @return  SUCCESS, INVALIDPARAMETER for a frequency or duration out of
+ *          the limits, or bleNoResources when the queue is full
+ */
+uint8_t Effect_play(const effect_t *pEffect, uint8_t mode);
+
+/*********************************************************************
+ * @fn      Effect_stop
+ *
+ * @brief   Silence the buzzer, drop the queued effects and stop the PWM
+ *          output.
+ *
+ * @return  none
+ */
+void Effect_stop(void);
+
+/*********************************************************************
+ * @fn      Effect_level
+ *
+ * @brief   Strength of an effect at a time into it.
+ *
+ * @param   pEffect - effect, with an envelope that fits the duration
+ * @param   time - time since the start of the effect, in ms
+ * @param   pHold - time the strength holds, in ms, 0 at the end
+ *
+ * @return  Strength, 0 to EFFECT_LEVEL_MAX
+ */
+uint8_t Effect_level(const effect_t *pEffect, uint16_t time, uint16_t *pHold);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EFFECT_H */
@@ -63,6 +63,7 @@
 #include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Event.h>
 #include <ti/sysbios/knl/Queue.h>
+#include <xdc/runtime/Timestamp.h>
 #include <ti/drivers/ADC.h>
 #include <ti/display/Display.h>
 #include <icall.h>
@@ -73,12 +74,25 @@
 #include "devinfoservice.h"
 #include "battservice.h"
 #include "hidkbdservice.h"
+#include "diagservice.h"
 #include "hiddev.h"
 #include "ll_common.h"
 
 #include "peripheral.h"
 #include "board_key.h"
-#include "board.h"
+#include "Board.h"
+#include "linkmonitor.h"
+#include "powergov.h"
+#include "battpolicy.h"
+#include "memmonitor.h"
+#include "inputtrace.h"
+#include "profprobe.h"
+#include "pointer.h"
+#include "tilt.h"
+#include "ledseq.h"
+#include "effect.h"
+#include "dashboard.h"
+#include "cfgstore.h"
 
 
 /*********************************************************************
@@ -90,20 +104,13 @@
 // Selected HID LED bitmaps
 #define LED_NUM_LOCK                0x01
 #define LED_CAPS_LOCK               0x02
+#define LED_SCROLL_LOCK             0x04
 
 // Selected HID mouse button values
 #define MOUSE_BUTTON_1              0x01
+#define MOUSE_BUTTON_2              0x02
 #define MOUSE_BUTTON_NONE           0x00
 
-// HID keyboard input report length
-#define HID_KEYBOARD_IN_RPT_LEN     8
-
-// HID LED output report length
-#define HID_LED_OUT_RPT_LEN         1
-
-// HID mouse input report length
-#define HID_MOUSE_IN_RPT_LEN        5
-
 /*********************************************************************
  * CONSTANTS
  */
@@ -126,10 +133,41 @@
 // request is enabled.
 #define DEFAULT_DESIRED_CONN_TIMEOUT          500
 
+// Fallback parameter sets offered when the central turns down the desired
+// ones above. Many centrals limit slave latency to 30 and the interval to
+// 15 ms or more, HID devices are usually allowed down to 11.25 ms.
+#define FALLBACK1_CONN_INTERVAL               9
+#define FALLBACK1_SLAVE_LATENCY               30
+#define FALLBACK2_MIN_CONN_INTERVAL           12
+#define FALLBACK2_MAX_CONN_INTERVAL           24
+#define FALLBACK2_SLAVE_LATENCY               15
+#define FALLBACK3_MIN_CONN_INTERVAL           24
+#define FALLBACK3_MAX_CONN_INTERVAL           40
+#define FALLBACK3_SLAVE_LATENCY               4
+
 // Whether to enable automatic parameter update request when a connection is
 // formed.
 #define DEFAULT_ENABLE_UPDATE_REQUEST         GAPROLE_LINK_PARAM_UPDATE_INITIATE_BOTH_PARAMS
 
+// Slave latency requested while the link monitor reports a degraded link.
+// The effective connection interval is interval * (latency + 1), so dropping
+// the latency gives the link more chances to deliver each report.
+#define DEGRADED_LINK_SLAVE_LATENCY           0
+
+// Connection parameters requested while the host has suspended the HID
+// device. Nothing is reported until a key wakes the host, so the link only
+// has to be kept alive (units of 1.25 ms, latency in events, timeout 10 ms).
+#define SUSPEND_MIN_CONN_INTERVAL             80
+#define SUSPEND_MAX_CONN_INTERVAL             160
+#define SUSPEND_SLAVE_LATENCY                 4
+#define SUSPEND_CONN_TIMEOUT                  600
+
+// Application overrides of the connection parameters, the suspend one
+// takes precedence over the others
+#define LINK_OVERRIDE_DEGRADED                0x01
+#define LINK_OVERRIDE_BATT                    0x02
+#define LINK_OVERRIDE_SUSPEND                 0x04
+
 // Connection Pause Peripheral time value (in seconds)
 #define DEFAULT_CONN_PAUSE_PERIPHERAL         10
 
@@ -145,10 +183,13 @@
 // Default GAP bonding I/O capabilities
 #define DEFAULT_IO_CAPABILITIES               GAPBOND_IO_CAP_NO_INPUT_NO_OUTPUT
 
-// Battery level is critical when it is less than this %
-#define DEFAULT_BATT_CRITICAL_LEVEL           6
+// Battery scaling profile, BATTPOLICY_PROFILE_*. The profile also sets the
+// battery critical level.
+#define DEFAULT_BATT_POLICY_PROFILE           BATTPOLICY_PROFILE_BALANCED
 
-// Key bindings, can be modified to any HID value.
+// Default key bindings, can be modified to any HID value up to
+// KEY_BINDING_MAX, the logical maximum of the keyboard report. The
+// bindings in use are kept in the configuration store.
 
 #define KEY_UP_HID_BINDING                    HID_KEYBOARD_UP_ARROW
 #define KEY_DOWN_HID_BINDING                  HID_KEYBOARD_DOWN_ARROW
@@ -160,27 +201,163 @@
 #define KEY_Z_HID_BINDING                     HID_KEYBOARD_Z
 #define KEY_X_HID_BINDING                     HID_KEYBOARD_X
 
-//#define USE_HID_MOUSE
-
+// Gamepad button bindings, bit of the gamepad report buttons
+#define KEY_Z_GAMEPAD_BINDING                 0x01  // Button 1
+#define KEY_X_GAMEPAD_BINDING                 0x02  // Button 2
+#define KEY_SELECT_GAMEPAD_BINDING            0x04  // Button 3
+#define KEY_START_GAMEPAD_BINDING             0x08  // Button 4
+
+// Consumer control bindings, used while SELECT is held (media chord)
+#define KEY_UP_CONSUMER_BINDING               HID_CONSUMER_VOLUME_UP
+#define KEY_DOWN_CONSUMER_BINDING             HID_CONSUMER_VOLUME_DOWN
+#define KEY_LEFT_CONSUMER_BINDING             HID_CONSUMER_SCAN_PREV_TRK
+#define KEY_RIGHT_CONSUMER_BINDING            HID_CONSUMER_SCAN_NEXT_TRK
+#define KEY_START_CONSUMER_BINDING            HID_CONSUMER_PLAY_PAUSE
+
+// Pointer mode, the joystick moves the mouse pointer and Z and X are the
+// mouse buttons. SELECT + X switches it on and off.
+#define DEFAULT_POINTER_MODE                  FALSE
+#define KEY_Z_MOUSE_BINDING                   MOUSE_BUTTON_1
+#define KEY_X_MOUSE_BINDING                   MOUSE_BUTTON_2
+
+// Shortest pointer motion period in ms, the connection interval otherwise
+#define POINTER_MIN_PERIOD                    8
+
+// Tilt mode, the accelerometer steers the gamepad axes and the pointer,
+// with the joystick or in its place. SELECT + Z steps through off, fuse
+// and override, the pose held when it is switched on is neutral.
+#define DEFAULT_TILT_MODE                     TILT_MODE_OFF
+
+// Lights output report period unit in ms
+#define LIGHT_PERIOD_UNIT                     20
+
+// Effect output report commands, and the attack and fade unit in ms
+#define EFFECT_CMD_STOP                       0   // Silence, drop the queue
+#define EFFECT_CMD_PLAY                       1   // Drop the queue and play
+#define EFFECT_CMD_QUEUE                      2   // Play after the queue
+#define EFFECT_ENVELOPE_UNIT                  10
+
+// Keyboard lock LEDs on the RGB LED while the host sets no lights pattern:
+// caps lock red, scroll lock green and num lock blue, dimmed
+#define KBD_LED_LEVEL                         64
+
+// Joystick ADC readings: rest position of each axis, full deflection and
+// dead zone around the rest position, the default of the band at the end
+// stops that presses the arrow keys
+#define JOYSTICK_X_CENTER                     1534
+#define JOYSTICK_Y_CENTER                     1555
+#define JOYSTICK_ADC_MAX                      3106
+#define JOYSTICK_DEADZONE                     20
+#define JOYSTICK_DEADZONE_MAX                 512
+#define JOYSTICK_AXIS_MAX                     127
+
+// Keyboard report logical maximum
+#define KEY_BINDING_MAX                       0x65
+
+// Configuration items, indexes of cfgItems. The GAP role takes the first
+// custom SNV ID, a version is stepped when the layout of its item changes.
+#define CFG_ITEM_KEYMAP                       0
+#define CFG_ITEM_INPUT                        1
+#define CFG_ITEM_CONN_PARAMS                  2
+#define CFG_ITEM_ADV_PARAMS                   3
+#define CFG_ITEM_MODES                        4
+#define CFG_ITEM_GATT_LAYOUT                  5
+
+#define CFG_NVID_KEYMAP                       (BLE_NVID_CUST_START + 1)
+#define CFG_NVID_INPUT                        (BLE_NVID_CUST_START + 2)
+#define CFG_NVID_CONN_PARAMS                  (BLE_NVID_CUST_START + 3)
+#define CFG_NVID_ADV_PARAMS                   (BLE_NVID_CUST_START + 4)
+#define CFG_NVID_MODES                        (BLE_NVID_CUST_START + 5)
+#define CFG_NVID_GATT_LAYOUT                  (BLE_NVID_CUST_START + 6)
+
+#define CFG_KEYMAP_VERSION                    1
+#define CFG_INPUT_VERSION                     1
+#define CFG_CONN_PARAMS_VERSION               1
+#define CFG_ADV_PARAMS_VERSION                1
+#define CFG_MODES_VERSION                     1
+#define CFG_GATT_LAYOUT_VERSION               1
+
+// Attribute table version, stepped when a service adds, removes or moves an
+// attribute. With the CRC of the generated report layout it tells bonded
+// hosts, through Service Changed, that their cached handles are stale.
+#define GATT_LAYOUT_VERSION                   1
+#define GATT_LAYOUT                           (((uint32_t)GATT_LAYOUT_VERSION << 16) | \
+                                               HID_LAYOUT_CRC)
+
+// Connection handle selecting every bond record
+#define BOND_ALL_RECORDS                      0xFFFF
+
+// Range of the connection parameters taken from the store (units of
+// 1.25 ms, latency in events, timeout 10 ms)
+#define CFG_CONN_INTERVAL_MIN                 6
+#define CFG_CONN_INTERVAL_MAX                 3200
+#define CFG_SLAVE_LATENCY_MAX                 499
+#define CFG_CONN_TIMEOUT_MIN                  10
+#define CFG_CONN_TIMEOUT_MAX                  3200
+
+// Range of the advertising intervals taken from the store (units of
+// 625 us)
+#define CFG_ADV_INTERVAL_MIN                  32
+#define CFG_ADV_INTERVAL_MAX                  16384
 
 
 // Task configuration
 #define HIDGAMECONTROLLER_TASK_PRIORITY               1
 
 #ifndef HIDGAMECONTROLLER_TASK_STACK_SIZE
+#ifdef HID_DEV_SINGLE_TASK
+// HidDev events and callbacks run on this stack as well
+#define HIDGAMECONTROLLER_TASK_STACK_SIZE             800
+#else
 #define HIDGAMECONTROLLER_TASK_STACK_SIZE             644
+#endif // HID_DEV_SINGLE_TASK
 #endif
 
 #define HID_STATE_CHANGE_EVT                          0x0001
+#define HID_CFG_FLUSH_EVT                             0x0002
 
 // Task Events
 #define HIDGAMECONTROLLER_ICALL_EVT                   ICALL_MSG_EVENT_ID // Event_Id_31
 #define HIDGAMECONTROLLER_QUEUE_EVT                   UTIL_QUEUE_EVENT_ID // Event_Id_30
 #define HIDGAMECONTROLLER_PERIODIC_EVT                Event_Id_00
+#define HIDGAMECONTROLLER_LINKMON_EVT                 Event_Id_01
+#define HIDGAMECONTROLLER_KEY_EVT                     Event_Id_02
+#define HIDGAMECONTROLLER_MEMMON_EVT                  Event_Id_03
+#define HIDGAMECONTROLLER_POINTER_EVT                 Event_Id_06
+#define HIDGAMECONTROLLER_DISPLAY_EVT                 Event_Id_07
+
+// Input trace drain, in the INPUT_TRACE build
+#ifdef INPUT_TRACE
+#define HIDGAMECONTROLLER_TRACE_EVT                   Event_Id_04
+#else
+#define HIDGAMECONTROLLER_TRACE_EVT                   0
+#endif // INPUT_TRACE
+
+// Profile publishing, in the PROF_PROBES build
+#ifdef PROF_PROBES
+#define HIDGAMECONTROLLER_PROF_EVT                    Event_Id_05
+#else
+#define HIDGAMECONTROLLER_PROF_EVT                    0
+#endif // PROF_PROBES
+
+// HidDev events handled by this task in the single-task build
+#ifdef HID_DEV_SINGLE_TASK
+#define HIDGAMECONTROLLER_HIDDEV_EVENTS               HID_DEV_ALL_EVENTS
+#else
+#define HIDGAMECONTROLLER_HIDDEV_EVENTS               0
+#endif // HID_DEV_SINGLE_TASK
 
 #define HIDGAMECONTROLLER_ALL_EVENTS                  (HIDGAMECONTROLLER_ICALL_EVT | \
                                                        HIDGAMECONTROLLER_QUEUE_EVT | \
-                                                       HIDGAMECONTROLLER_PERIODIC_EVT)
+                                                       HIDGAMECONTROLLER_PERIODIC_EVT | \
+                                                       HIDGAMECONTROLLER_LINKMON_EVT | \
+                                                       HIDGAMECONTROLLER_KEY_EVT | \
+                                                       HIDGAMECONTROLLER_MEMMON_EVT | \
+                                                       HIDGAMECONTROLLER_POINTER_EVT | \
+                                                       HIDGAMECONTROLLER_DISPLAY_EVT | \
+                                                       HIDGAMECONTROLLER_TRACE_EVT | \
+                                                       HIDGAMECONTROLLER_PROF_EVT | \
+                                                       HIDGAMECONTROLLER_HIDDEV_EVENTS)
 
 /*********************************************************************
  * TYPEDEFS
@@ -192,6 +369,46 @@ typedef struct
   appEvtHdr_t hdr; // Event header
 } hidGameControllerEvt_t;
 
+// Event handler, called with all the events pending
+typedef void (*hidGameControllerEvtHandler_t)(uint32_t events);
+
+// Dispatch table entry
+typedef struct
+{
+    uint32_t events;                       // Events the handler takes
+    hidGameControllerEvtHandler_t handler;
+} hidGameControllerDispatch_t;
+
+// Input report builder of a protocol mode, called with the keys held
+typedef void (*hidGameControllerRptBuilder_t)(uint8_t keys);
+
+// Key bindings, HID keyboard usages
+typedef struct
+{
+    uint8_t up;
+    uint8_t down;
+    uint8_t left;
+    uint8_t right;
+    uint8_t select;
+    uint8_t start;
+    uint8_t z;
+    uint8_t x;
+} hidGameControllerKeymap_t;
+
+// Input settings
+typedef struct
+{
+    uint16_t samplePeriod;  // Sampling and report period of active play, ms
+    uint16_t deadzone;      // Joystick dead zone, in ADC counts
+} hidGameControllerInput_t;
+
+// Modes selected by the chords, restored at power up
+typedef struct
+{
+    uint8_t pointer;        // TRUE in pointer mode
+    uint8_t tilt;           // TILT_MODE_*
+} hidGameControllerModes_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -219,13 +436,73 @@ static ICall_EntityID selfEntity;
 static ICall_SyncHandle syncEvent;
 
 // Clock instances for internal periodic events.
-Clock_Struct periodicClock;
+static Clock_Struct periodicClock;
+static Clock_Struct linkMonClock;
+static Clock_Struct memMonClock;
+static Clock_Struct pointerClock;
+#ifdef INPUT_TRACE
+static Clock_Struct traceClock;
+#endif // INPUT_TRACE
+#ifdef PROF_PROBES
+static Clock_Struct profClock;
+#endif // PROF_PROBES
+
+// Overrides of the connection parameters in effect, LINK_OVERRIDE_*, and
+// the parameters in use before the first one, requested again after the
+// last one unless a held parameter negotiation goes on instead
+static uint8_t linkOverrides = 0;
+static uint16_t linkBaseConnInterval;
+static uint16_t linkBaseSlaveLatency;
+static uint16_t linkBaseConnTimeout;
+
+// Battery scaling profile and the step in use
+static const battPolicyProfile_t *pBattPolicy;
+static uint8_t battPolicyStep = BATTPOLICY_STEP_NONE;
+static uint8_t battPolicyLevel;
 
 // Queue object used for app messages
 static Queue_Struct appMsg;
 static Queue_Handle appMsgQueue;
 
-static uint8_t buf[HID_KEYBOARD_IN_RPT_LEN];
+static uint8_t buf[HID_KEY_IN_RPT_LEN];
+
+// Keys held, from the key debounce clock
+static uint8_t keysHeld = 0;
+
+// Gamepad axes, from the last joystick read
+static int8_t joystickX = 0;
+static int8_t joystickY = 0;
+
+// Pointer mode, as selected by the keys and in use
+static uint8_t pointerModeReq = DEFAULT_POINTER_MODE;
+static uint8_t pointerMode = DEFAULT_POINTER_MODE;
+
+// Pointer motion clock running, and its period in ms
+static uint8_t pointerActive = FALSE;
+static uint16_t pointerPeriod = POINTER_MIN_PERIOD;
+
+// Mouse buttons of the last mouse report
+static uint8_t mouseButtonsSent = MOUSE_BUTTON_NONE;
+
+// Tilt mode requested by the keys and in use, and the clock tick of the
+// last accelerometer sample
+static uint8_t tiltModeReq = DEFAULT_TILT_MODE;
+static uint8_t tiltMode = DEFAULT_TILT_MODE;
+static uint32_t tiltLastTick = 0;
+
+static const char * const tiltModeNames[TILT_NUM_MODES] =
+{
+    "off", "fuse", "override"
+};
+
+// Lights sequence set by the host, and the keyboard LEDs
+static ledSeq_t lightSeq = { LEDSEQ_PATTERN_OFF };
+static uint8_t kbdLeds = 0;
+
+// Timestamp of the first key press not reported yet, for the dashboard
+// latency
+static uint32_t keyPressTime;
+static volatile uint8_t keyPressPending = FALSE;
 
 // Task configuration
 Task_Struct hidGameControllerTask;
@@ -280,6 +557,45 @@ static uint8_t advData[] =
     HI_UINT16(BATT_SERV_UUID)
 };
 
+// Connection parameter sets, most preferred first. The first one is kept
+// in the configuration store.
+static gapRoleConnParams_t connParamLadder[] =
+{
+    { DEFAULT_DESIRED_MIN_CONN_INTERVAL, DEFAULT_DESIRED_MAX_CONN_INTERVAL,
+      DEFAULT_DESIRED_SLAVE_LATENCY, DEFAULT_DESIRED_CONN_TIMEOUT },
+    { FALLBACK1_CONN_INTERVAL, FALLBACK1_CONN_INTERVAL,
+      FALLBACK1_SLAVE_LATENCY, DEFAULT_DESIRED_CONN_TIMEOUT },
+    { FALLBACK2_MIN_CONN_INTERVAL, FALLBACK2_MAX_CONN_INTERVAL,
+      FALLBACK2_SLAVE_LATENCY, DEFAULT_DESIRED_CONN_TIMEOUT },
+    { FALLBACK3_MIN_CONN_INTERVAL, FALLBACK3_MAX_CONN_INTERVAL,
+      FALLBACK3_SLAVE_LATENCY, DEFAULT_DESIRED_CONN_TIMEOUT }
+};
+
+// Key bindings, input settings and modes, loaded from the configuration
+// store over these defaults
+static hidGameControllerKeymap_t keymap =
+{
+    KEY_UP_HID_BINDING, KEY_DOWN_HID_BINDING, KEY_LEFT_HID_BINDING,
+    KEY_RIGHT_HID_BINDING, KEY_SELECT_HID_BINDING, KEY_START_HID_BINDING,
+    KEY_Z_HID_BINDING, KEY_X_HID_BINDING
+};
+
+static hidGameControllerInput_t inputCfg =
+{
+    HID_PERIODIC_EVT_PERIOD, JOYSTICK_DEADZONE
+};
+
+static hidGameControllerModes_t modesCfg =
+{
+    DEFAULT_POINTER_MODE, DEFAULT_TILT_MODE
+};
+
+// Attribute table layout the bonds were made with, 0 until stored
+static uint32_t gattLayout = 0;
+
+// Advertising parameters, the HidDev defaults until loaded
+static hidDevAdvParams_t advParams;
+
 // Device name attribute value
 static CONST uint8_t attDeviceName[GAP_DEVICE_NAME_LEN] = "HID Game Controller";
 
@@ -290,16 +606,19 @@ static hidDevCfg_t hidGameControllerCfg =
     HID_KBD_FLAGS               // HID feature flags
 };
 
-#ifdef USE_HID_MOUSE
-// TRUE if boot mouse enabled
-static uint8_t hidBootMouseEnabled = FALSE;
-#endif // USE_HID_MOUSE
-
 ADC_Handle   adchandlech0;
 ADC_Handle   adchandlech5;
 ADC_Params   paramsch0;
 ADC_Params   paramsch5;
 
+// Accelerometer X, Y and Z, sampled with the joystick in the tilt modes
+static const uint8_t accelAdcIndex[TILT_NUM_AXES] =
+{
+    EDUBP_MKII_ACCEL_X_ADC, EDUBP_MKII_ACCEL_Y_ADC, EDUBP_MKII_ACCEL_Z_ADC
+};
+
+static ADC_Handle adcHandleAccel[TILT_NUM_AXES];
+
 
 /*********************************************************************
  * LOCAL FUNCTIONS
@@ -311,27 +630,72 @@ static void HidGameController_taskFxn(UArg a0, UArg a1);
 static void HidGameController_processAppMsg(hidGameControllerEvt_t *pMsg);
 static void HidGameController_processStackMsg(ICall_Hdr *pMsg);
 static void HidGameController_processGattMsg(gattMsgEvent_t *pMsg);
-#if 0
 static uint8_t HidGameController_enqueueMsg(uint16_t event, uint8_t state);
-#endif
+static void HidGameController_processGapStateChange(void);
+static void HidGameController_linkStateCB(uint8_t newState);
+static void HidGameController_powerStateCB(uint8_t oldState, uint8_t newState);
+static void HidGameController_wakeCB(uint8_t wakeSources);
+static void HidGameController_setLinkOverrides(uint8_t overrides);
+static void HidGameController_applyBattPolicy(void);
 static void HID_GameController_clockHandler(UArg arg);
 
+// Event handlers.
+static void HidGameController_queueEvt(uint32_t events);
+static void HidGameController_periodicEvt(uint32_t events);
+static void HidGameController_keyEvt(uint32_t events);
+static void HidGameController_linkMonEvt(uint32_t events);
+static void HidGameController_memMonEvt(uint32_t events);
+static void HidGameController_pointerEvt(uint32_t events);
+static void HidGameController_displayEvt(uint32_t events);
+#ifdef INPUT_TRACE
+static void HidGameController_traceEvt(uint32_t events);
+#endif // INPUT_TRACE
+#ifdef PROF_PROBES
+static void HidGameController_profEvt(uint32_t events);
+#endif // PROF_PROBES
+
 // Key press.
 static void HidGameController_keyPressHandler(uint8_t keys);
 
 // HID reports.
 static void HidGameController_sendReport(void);
-//static void HidGameController_sendReport(uint8_t keycode);
-#ifdef USE_HID_MOUSEx
-static void HidGameController_sendMouseReport(uint8_t buttons);
-#endif // USE_HID_MOUSE
+static void HidGameController_buildReports(uint8_t keys);
+static void HidGameController_buildBootReports(uint8_t keys);
+static void HidGameController_updatePointer(uint8_t keys);
+static void HidGameController_setProtocolMode(void);
+static void HidGameController_sendMouseReport(uint8_t buttons, int8_t dx,
+                                              int8_t dy);
+static uint8_t HidGameController_mouseButtons(uint8_t keys);
+static void HidGameController_setPointerMode(uint8_t enable);
+static void HidGameController_setTiltMode(uint8_t mode);
+static void HidGameController_startPointer(void);
 static uint8_t HidGameController_receiveReport(uint8_t len, uint8_t *pData);
+static uint8_t HidGameController_receiveLightReport(uint8_t len,
+                                                   uint8_t *pData);
+static void HidGameController_applyLights(void);
+static uint8_t HidGameController_receiveEffectReport(uint8_t len,
+                                                    uint8_t *pData);
 static uint8_t HidGameController_reportCB(uint8_t id, uint8_t type, uint16_t uuid,
                                   uint8_t oper, uint16_t *pLen, uint8_t *pData);
 static void HidGameController_hidEventCB(uint8_t evt);
+static void HidGameController_dashStatusCB(dashStatus_t *pStatus);
+static void HidGameController_displayWakeCB(void);
+static void HidGameController_cfgFlushCB(void);
+static uint8_t HidGameController_keymapValid(const void *pValue);
+static uint8_t HidGameController_inputValid(const void *pValue);
+static uint8_t HidGameController_connParamsValid(const void *pValue);
+static uint8_t HidGameController_advParamsValid(const void *pValue);
+static uint8_t HidGameController_modesValid(const void *pValue);
+static void HidGameController_checkGattLayout(void);
 static void HidGameController_PeriodicEvent(void);
 static void HidJoystick_Init(void);
+static void HidJoystick_Open(void);
+static void HidJoystick_Close(void);
 static void HidJoystick_Read(void);
+static void HidJoystick_readTilt(void);
+static int8_t HidJoystick_axis(uint16_t adcValue, uint16_t center);
+static uint8_t HidJoystick_arrow(uint16_t adcValue, uint8_t keyLow,
+                                 uint8_t keyHigh);
 
 /*********************************************************************
  * PROFILE CALLBACKS
@@ -344,6 +708,65 @@ static hidDevCB_t hidGameControllerHidCBs =
   NULL
 };
 
+/*********************************************************************
+ * EVENT DISPATCH
+ */
+
+// Handlers of the task events, in the order they run
+static const hidGameControllerDispatch_t hidGameControllerDispatchTable[] =
+{
+    { HIDGAMECONTROLLER_QUEUE_EVT,    HidGameController_queueEvt },
+#ifdef HID_DEV_SINGLE_TASK
+    { HID_DEV_ALL_EVENTS,             HidDev_processEvents },
+#endif // HID_DEV_SINGLE_TASK
+    { HIDGAMECONTROLLER_PERIODIC_EVT, HidGameController_periodicEvt },
+    { HIDGAMECONTROLLER_KEY_EVT,      HidGameController_keyEvt },
+    { HIDGAMECONTROLLER_LINKMON_EVT,  HidGameController_linkMonEvt },
+    { HIDGAMECONTROLLER_MEMMON_EVT,   HidGameController_memMonEvt },
+    { HIDGAMECONTROLLER_POINTER_EVT,  HidGameController_pointerEvt },
+#ifdef INPUT_TRACE
+    { HIDGAMECONTROLLER_TRACE_EVT,    HidGameController_traceEvt },
+#endif // INPUT_TRACE
+#ifdef PROF_PROBES
+    { HIDGAMECONTROLLER_PROF_EVT,     HidGameController_profEvt },
+#endif // PROF_PROBES
+    // Last, a drawing slice waits for the input and reports
+    { HIDGAMECONTROLLER_DISPLAY_EVT,  HidGameController_displayEvt },
+};
+
+/*********************************************************************
+ * CONFIGURATION ITEMS
+ */
+
+// Settings kept in SNV, indexed by CFG_ITEM_*
+static const cfgItem_t cfgItems[] =
+{
+    { CFG_NVID_KEYMAP, CFG_KEYMAP_VERSION, sizeof(keymap), &keymap,
+      HidGameController_keymapValid },
+    { CFG_NVID_INPUT, CFG_INPUT_VERSION, sizeof(inputCfg), &inputCfg,
+      HidGameController_inputValid },
+    { CFG_NVID_CONN_PARAMS, CFG_CONN_PARAMS_VERSION,
+      sizeof(gapRoleConnParams_t), &connParamLadder[0],
+      HidGameController_connParamsValid },
+    { CFG_NVID_ADV_PARAMS, CFG_ADV_PARAMS_VERSION, sizeof(advParams),
+      &advParams, HidGameController_advParamsValid },
+    { CFG_NVID_MODES, CFG_MODES_VERSION, sizeof(modesCfg), &modesCfg,
+      HidGameController_modesValid },
+    { CFG_NVID_GATT_LAYOUT, CFG_GATT_LAYOUT_VERSION, sizeof(gattLayout),
+      &gattLayout, NULL }
+};
+
+/*********************************************************************
+ * REPORT BUILDERS
+ */
+
+// Input report builders, indexed by protocol mode
+static const hidGameControllerRptBuilder_t hidGameControllerRptBuilders[] =
+{
+    HidGameController_buildBootReports,     // HID_PROTOCOL_MODE_BOOT
+    HidGameController_buildReports          // HID_PROTOCOL_MODE_REPORT
+};
+
 /*********************************************************************
  * PUBLIC FUNCTIONS
  */
@@ -361,6 +784,29 @@ static void HidJoystick_Init(void)
 {
     ADC_init();
 
+    HidJoystick_Open();
+}
+
+/*********************************************************************
+ * @fn      HidJoystick_Open
+ *
+ * @brief   Open ADC0 and ADC5 for reading joystick analog values, and the
+ *          accelerometer channels.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void HidJoystick_Open(void)
+{
+    ADC_Params params;
+    uint8_t i;
+
+    if (adchandlech0 != NULL)
+    {
+        return;
+    }
+
     // Joystick X
     ADC_Params_init(&paramsch0);
     adchandlech0 = ADC_open(Board_ADC0, &paramsch0);
@@ -381,6 +827,47 @@ static void HidJoystick_Init(void)
         while (1);
     }
 
+    // A channel that does not open leaves the tilt modes on the joystick
+    for (i = 0; i < TILT_NUM_AXES; i++)
+    {
+        ADC_Params_init(&params);
+        adcHandleAccel[i] = ADC_open(accelAdcIndex[i], &params);
+    }
+}
+
+/*********************************************************************
+ * @fn      HidJoystick_Close
+ *
+ * @brief   Close ADC0 and ADC5 while the joystick is not sampled, so the
+ *          ADC does not keep the device out of standby.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void HidJoystick_Close(void)
+{
+    uint8_t i;
+
+    if (adchandlech0 == NULL)
+    {
+        return;
+    }
+
+    ADC_close(adchandlech0);
+    ADC_close(adchandlech5);
+
+    adchandlech0 = NULL;
+    adchandlech5 = NULL;
+
+    for (i = 0; i < TILT_NUM_AXES; i++)
+    {
+        if (adcHandleAccel[i] != NULL)
+        {
+            ADC_close(adcHandleAccel[i]);
+            adcHandleAccel[i] = NULL;
+        }
+    }
 }
 
 /*********************************************************************
@@ -397,6 +884,14 @@ static void HidJoystick_Read(void)
     int_fast16_t resch0, resch5;
     uint16_t adcValuech0, adcValuech5;
 
+    // ADC is closed while suspended
+    if (adchandlech0 == NULL)
+    {
+        return;
+    }
+
+    PROF_ENTER(JOYSTICK_READ);
+
     resch0 = ADC_convert(adchandlech0, &adcValuech0);
 
     if (resch0 != ADC_STATUS_SUCCESS)
@@ -411,45 +906,130 @@ static void HidJoystick_Read(void)
         while(1);
     }
 
-    //adcValuech0 x axis no movement 1534 - 1535
-    if ((adcValuech0 > (1534 - 20)) && (adcValuech0 < (1534 + 20)))
-    {
-        buf[2] = KEY_NONE;
-    }
-    //adcValuech0 x axis left 5
-    else if ((adcValuech0 > 0) && (adcValuech0 < 20))
+    INPUT_TRACE_ADC(Board_ADC0, adcValuech0);
+    INPUT_TRACE_ADC(Board_ADC5, adcValuech5);
+
+    // A low reading is left on the x axis and down on the y axis, HID
+    // gamepads report right and down positive
+    joystickX = HidJoystick_axis(adcValuech0, JOYSTICK_X_CENTER);
+    joystickY = -HidJoystick_axis(adcValuech5, JOYSTICK_Y_CENTER);
+
+    // The accelerometer is sampled in the same pass, in the tilt modes.
+    // The arrow keys below stay on the joystick.
+    if (tiltMode != TILT_MODE_OFF)
     {
-        buf[2] = KEY_LEFT_HID_BINDING;
+        HidJoystick_readTilt();
     }
-    //adcValuech0 x axis right 3105 - 3106
-    else if ((adcValuech0 > (3105 - 20)) && (adcValuech0 < (3106 + 20)))
+
+    // Arrow keys at full deflection only
+    buf[2] = HidJoystick_arrow(adcValuech0, keymap.left, keymap.right);
+    buf[3] = HidJoystick_arrow(adcValuech5, keymap.down, keymap.up);
+
+    PROF_EXIT(JOYSTICK_READ);
+}
+
+/*********************************************************************
+ * @fn      HidJoystick_readTilt
+ *
+ * @brief   Sample the accelerometer and combine its tilt with the
+ *          joystick axes of the tilt mode.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void HidJoystick_readTilt(void)
+{
+    uint16_t adcValue[TILT_NUM_AXES];
+    uint32_t now = Clock_getTicks();
+    uint32_t elapsedMs = (now - tiltLastTick) / (1000 / Clock_tickPeriod);
+    int8_t tiltX;
+    int8_t tiltY;
+    uint8_t i;
+
+    for (i = 0; i < TILT_NUM_AXES; i++)
     {
-        buf[2] = KEY_RIGHT_HID_BINDING;
+        if ((adcHandleAccel[i] == NULL) ||
+            (ADC_convert(adcHandleAccel[i], &adcValue[i]) !=
+             ADC_STATUS_SUCCESS))
+        {
+            return;
+        }
+
+        INPUT_TRACE_ADC(accelAdcIndex[i], adcValue[i]);
     }
-    else
+
+    tiltLastTick = now;
+
+    Tilt_update(adcValue, (elapsedMs > UINT16_MAX) ? UINT16_MAX : elapsedMs,
+                &tiltX, &tiltY);
+    Tilt_fuse(tiltMode, joystickX, joystickY, tiltX, tiltY,
+              &joystickX, &joystickY);
+}
+
+/*********************************************************************
+ * @fn      HidJoystick_axis
+ *
+ * @brief   Scale a joystick ADC reading to a gamepad axis.
+ *
+ * @param   adcValue - ADC reading
+ * @param   center - ADC reading at the rest position
+ *
+ * @return  -JOYSTICK_AXIS_MAX to JOYSTICK_AXIS_MAX, 0 in the dead zone
+ */
+static int8_t HidJoystick_axis(uint16_t adcValue, uint16_t center)
+{
+    int32_t offset = (int32_t)adcValue - center;
+    int32_t span = (offset > 0) ? (JOYSTICK_ADC_MAX - center) : center;
+    int32_t axis;
+
+    if ((offset > -(int32_t)inputCfg.deadzone) &&
+        (offset < (int32_t)inputCfg.deadzone))
     {
-        buf[2] = KEY_NONE;
+        return 0;
     }
 
-    //adcValuech5 y axis no movement 1555 - 1556
-    if ((adcValuech5 > (1555 - 20)) && (adcValuech5 < (1555 + 20)))
+    axis = offset * JOYSTICK_AXIS_MAX / span;
+
+    if (axis > JOYSTICK_AXIS_MAX)
     {
-        buf[3] = KEY_NONE;
+        axis = JOYSTICK_AXIS_MAX;
     }
-    //adcValuech5 y axis down 5
-    else if ((adcValuech5 > 0) && (adcValuech5 < 20))
+    else if (axis < -JOYSTICK_AXIS_MAX)
     {
-        buf[3] = KEY_DOWN_HID_BINDING;
+        axis = -JOYSTICK_AXIS_MAX;
     }
-    //adcValuech5 y axis up 3105 - 3106
-    else if ((adcValuech5 > (3105 - 20)) && (adcValuech5 < (3106 + 20)))
+
+    return (int8_t)axis;
+}
+
+/*********************************************************************
+ * @fn      HidJoystick_arrow
+ *
+ * @brief   Arrow key of a joystick axis. The key is pressed within the
+ *          dead zone of an end stop, the same band as around the rest
+ *          position, and released anywhere in between.
+ *
+ * @param   adcValue - ADC reading
+ * @param   keyLow - key of a low reading
+ * @param   keyHigh - key of a high reading
+ *
+ * @return  Key, KEY_NONE when the axis is not at an end stop
+ */
+static uint8_t HidJoystick_arrow(uint16_t adcValue, uint8_t keyLow,
+                                 uint8_t keyHigh)
+{
+    if (adcValue <= inputCfg.deadzone)
     {
-        buf[3] = KEY_UP_HID_BINDING;
+        return keyLow;
     }
-    else
+
+    if (adcValue >= JOYSTICK_ADC_MAX - inputCfg.deadzone)
     {
-        buf[3] = KEY_NONE;
+        return keyHigh;
     }
+
+    return KEY_NONE;
 }
 
 /*********************************************************************
@@ -503,6 +1083,12 @@ void HidGameController_init(void)
     // so that the application can send and receive messages.
     ICall_registerApp(&selfEntity, &syncEvent);
 
+#ifdef HID_DEV_SINGLE_TASK
+    // The HID service runs in this task, set it up first as its own task
+    // would have.
+    HidDev_initTask(selfEntity, syncEvent);
+#endif // HID_DEV_SINGLE_TASK
+
     // Hard code the DB Address till CC2650 board gets its own IEEE address
     //uint8 bdAddress[B_ADDR_LEN] = { 0x22, 0x22, 0x22, 0x22, 0x22, 0x5A };
     //HCI_EXT_SetBDADDRCmd(bdAddress);
@@ -513,11 +1099,57 @@ void HidGameController_init(void)
     // Create an RTOS queue for message from profile to be sent to app.
     appMsgQueue = Util_constructQueue(&appMsg);
 
+    // Load the settings before anything uses them
+    HidDev_GetParameter(HIDDEV_ADV_PARAMS, &advParams);
+    Cfg_init(cfgItems, sizeof(cfgItems) / sizeof(cfgItems[0]),
+             HidGameController_cfgFlushCB);
+    HidDev_SetParameter(HIDDEV_ADV_PARAMS, sizeof(advParams), &advParams);
+
+    pointerModeReq = pointerMode = modesCfg.pointer;
+    tiltModeReq = tiltMode = modesCfg.tilt;
+
+#ifdef INPUT_TRACE
+    // Start the trace before any input is read
+    InputTrace_init();
+#endif // INPUT_TRACE
+
+#ifdef PROF_PROBES
+    Prof_init();
+#endif // PROF_PROBES
+
     HidJoystick_Init();
+    Pointer_init();
+    Tilt_init();
+    LedSeq_init();
+    Effect_init();
+    Dash_init(HidGameController_dashStatusCB, HidGameController_displayWakeCB);
 
     // Create one-shot clocks for internal periodic events.
     Util_constructClock(&periodicClock, HID_GameController_clockHandler,
                         HID_PERIODIC_EVT_PERIOD, 0, false, HIDGAMECONTROLLER_PERIODIC_EVT);
+    Util_constructClock(&linkMonClock, HID_GameController_clockHandler,
+                        LINKMON_PERIOD, 0, false, HIDGAMECONTROLLER_LINKMON_EVT);
+    Util_constructClock(&memMonClock, HID_GameController_clockHandler,
+                        MEMMON_PERIOD, 0, false, HIDGAMECONTROLLER_MEMMON_EVT);
+    Util_constructClock(&pointerClock, HID_GameController_clockHandler,
+                        POINTER_MIN_PERIOD, 0, false,
+                        HIDGAMECONTROLLER_POINTER_EVT);
+#ifdef INPUT_TRACE
+    Util_constructClock(&traceClock, HID_GameController_clockHandler,
+                        INPUT_TRACE_DRAIN_PERIOD, 0, false,
+                        HIDGAMECONTROLLER_TRACE_EVT);
+#endif // INPUT_TRACE
+#ifdef PROF_PROBES
+    Util_constructClock(&profClock, HID_GameController_clockHandler,
+                        PROF_PERIOD, 0, false, HIDGAMECONTROLLER_PROF_EVT);
+#endif // PROF_PROBES
+
+    // The power governor owns the sampling clock from here on.
+    PowerGov_init(&periodicClock, HidGameController_powerStateCB,
+                  HidGameController_wakeCB);
+    PowerGov_setActivePeriod(inputCfg.samplePeriod);
+
+    LinkMon_init(HidGameController_linkStateCB);
 
     // Setup the GAP
     VOID GAP_SetParamValue(TGAP_CONN_PAUSE_PERIPHERAL,
@@ -533,10 +1165,10 @@ void HidGameController_init(void)
         uint16_t gapRole_AdvertOffTime = 0;
 
         uint8_t enable_update_request = DEFAULT_ENABLE_UPDATE_REQUEST;
-        uint16_t desired_min_interval = DEFAULT_DESIRED_MIN_CONN_INTERVAL;
-        uint16_t desired_max_interval = DEFAULT_DESIRED_MAX_CONN_INTERVAL;
-        uint16_t desired_slave_latency = DEFAULT_DESIRED_SLAVE_LATENCY;
-        uint16_t desired_conn_timeout = DEFAULT_DESIRED_CONN_TIMEOUT;
+        uint16_t desired_min_interval = connParamLadder[0].minConnInterval;
+        uint16_t desired_max_interval = connParamLadder[0].maxConnInterval;
+        uint16_t desired_slave_latency = connParamLadder[0].slaveLatency;
+        uint16_t desired_conn_timeout = connParamLadder[0].timeoutMultiplier;
 
         // Set the GAP Role Parameters
         GAPRole_SetParameter(GAPROLE_ADVERT_ENABLED, sizeof(uint8_t),
@@ -557,6 +1189,9 @@ void HidGameController_init(void)
                              &desired_slave_latency);
         GAPRole_SetParameter(GAPROLE_TIMEOUT_MULTIPLIER, sizeof(uint16_t),
                              &desired_conn_timeout);
+
+        GAPRole_SetParamUpdateLadder(connParamLadder,
+                                     sizeof(connParamLadder) / sizeof(connParamLadder[0]));
     }
 
     // Set the GAP Characteristics
@@ -578,7 +1213,10 @@ void HidGameController_init(void)
 
     // Setup Battery Characteristic Values
     {
-        uint8_t critical = DEFAULT_BATT_CRITICAL_LEVEL;
+        uint8_t critical;
+
+        pBattPolicy = BattPolicy_getProfile(DEFAULT_BATT_POLICY_PROFILE);
+        critical = pBattPolicy->criticalLevel;
 
         Batt_SetParameter(BATT_PARAM_CRITICAL_LEVEL, sizeof (uint8_t), &critical);
     }
@@ -586,12 +1224,18 @@ void HidGameController_init(void)
     // Set up HID keyboard service
     HidKbd_AddService();
 
+    // Set up diagnostic service
+    Diag_AddService();
+
     // Register for HID Dev callback
     HidDev_Register(&hidGameControllerCfg, &hidGameControllerHidCBs);
 
     // Start the GAP Role and Register the Bond Manager.
     HidDev_StartDevice();
 
+    // Bonds made under another attribute table get Service Changed
+    HidGameController_checkGattLayout();
+
     // Initialize keys on CC2640R2F LP.
     Board_initKeys(HidGameController_keyPressHandler);
 
@@ -629,6 +1273,7 @@ void HidGameController_taskFxn(UArg a0, UArg a1)
     for (;;)
     {
         uint32_t events;
+        uint8_t i;
 
         events = Event_pend(syncEvent, Event_Id_NONE, HIDGAMECONTROLLER_ALL_EVENTS,
                             ICALL_TIMEOUT_FOREVER);
@@ -638,6 +1283,7 @@ void HidGameController_taskFxn(UArg a0, UArg a1)
             ICall_EntityID dest;
             ICall_ServiceEnum src;
             ICall_HciExtEvt *pMsg = NULL;
+            PROF_ENTER(APP_DISPATCH);
 
             if (ICall_fetchServiceMsg(&src, &dest,
                                     (void **)&pMsg) == ICALL_ERRNO_SUCCESS)
@@ -654,366 +1300,1544 @@ void HidGameController_taskFxn(UArg a0, UArg a1)
                 }
             }
 
-            // If RTOS queue is not empty, process app message.
-            if (events & HIDGAMECONTROLLER_QUEUE_EVT)
+            for (i = 0; i < sizeof(hidGameControllerDispatchTable) /
+                            sizeof(hidGameControllerDispatchTable[0]); i++)
             {
-                while (!Queue_empty(appMsgQueue))
+                if (events & hidGameControllerDispatchTable[i].events)
                 {
-                    hidGameControllerEvt_t *pMsg = (hidGameControllerEvt_t *)Util_dequeueMsg(appMsgQueue);
-                    if (pMsg)
-                    {
-                        // Process message.
-                        HidGameController_processAppMsg(pMsg);
-
-                        // Free the space from the message.
-                        ICall_free(pMsg);
-                    }
+                    hidGameControllerDispatchTable[i].handler(events);
                 }
             }
 
-            if (events & HIDGAMECONTROLLER_PERIODIC_EVT)
-            {
-                HidGameController_PeriodicEvent();
-                Util_restartClock(&periodicClock, HID_PERIODIC_EVT_PERIOD);
-            }
+            PROF_EXIT(APP_DISPATCH);
         }
     }
 }
 
 /*********************************************************************
- * @fn      HidGameController_processStackMsg
+ * @fn      HidGameController_queueEvt
  *
- * @brief   Process an incoming stack message.
+ * @brief   Process the messages queued by the profiles.
  *
- * @param   pMsg - message to process
+ * @param   events - pending events
  *
  * @return  none
  */
-static void HidGameController_processStackMsg(ICall_Hdr *pMsg)
+static void HidGameController_queueEvt(uint32_t events)
 {
-    switch (pMsg->event)
+    while (!Queue_empty(appMsgQueue))
     {
-        case GATT_MSG_EVENT:
-            HidGameController_processGattMsg((gattMsgEvent_t *) pMsg);
-        break;
-
-        case HCI_GAP_EVENT_EVENT:
+        hidGameControllerEvt_t *pMsg = (hidGameControllerEvt_t *)Util_dequeueMsg(appMsgQueue);
+        if (pMsg)
         {
+            // Process message.
+            HidGameController_processAppMsg(pMsg);
 
-            // Process HCI message
-            switch(pMsg->status)
-            {
-                case HCI_COMMAND_COMPLETE_EVENT_CODE:
-                // Process HCI Command Complete Event
-                {
-
-#if !defined (USE_LL_CONN_PARAM_UPDATE)
-                    // This code will disable the use of the LL_CONNECTION_PARAM_REQ
-                    // control procedure (for connection parameter updates, the
-                    // L2CAP Connection Parameter Update procedure will be used
-                    // instead). To re-enable the LL_CONNECTION_PARAM_REQ control
-                    // procedures, define the symbol USE_LL_CONN_PARAM_UPDATE
-
-                    // Parse Command Complete Event for opcode and status
-                    hciEvt_CmdComplete_t* command_complete = (hciEvt_CmdComplete_t*) pMsg;
-                    uint8_t   pktStatus = command_complete->pReturnParam[0];
-
-                    //find which command this command complete is for
-                    switch (command_complete->cmdOpcode)
-                    {
-                        case HCI_LE_READ_LOCAL_SUPPORTED_FEATURES:
-                        {
-                            if (pktStatus == SUCCESS)
-                            {
-                                uint8_t featSet[8];
-
-                                // get current feature set from received event (bits 1-9 of
-                                // the returned data
-                                memcpy( featSet, &command_complete->pReturnParam[1], 8 );
-
-                                // Clear bit 1 of byte 0 of feature set to disable LL
-                                // Connection Parameter Updates
-                                CLR_FEATURE_FLAG( featSet[0], LL_FEATURE_CONN_PARAMS_REQ );
-
-                                // Update controller with modified features
-                                HCI_EXT_SetLocalSupportedFeaturesCmd( featSet );
-                            }
-                        }
-                        break;
-
-                        default:
-                        //do nothing
-                        break;
-                    }
-#endif // !defined (USE_LL_CONN_PARAM_UPDATE)
-
-                }
-                break;
-
-                default:
-                break;
-            }
+            // Free the space from the message.
+            Util_freeMsg((uint8_t *)pMsg);
         }
-        break;
-
-        default:
-        // Do nothing
-        break;
     }
 }
 
 /*********************************************************************
- * @fn      HidGameController_processGattMsg
+ * @fn      HidGameController_periodicEvt
  *
- * @brief   Process GATT messages
+ * @brief   Sample the inputs and schedule the next sample.
+ *
+ * @param   events - pending events
  *
  * @return  none
  */
-static void HidGameController_processGattMsg(gattMsgEvent_t *pMsg)
+static void HidGameController_periodicEvt(uint32_t events)
 {
-    GATT_bm_free(&pMsg->msg, pMsg->method);
+    uint32_t samplePeriod;
+
+    HidGameController_PeriodicEvent();
+
+    // Sampling rate depends on the power state
+    samplePeriod = PowerGov_getSamplePeriod();
+    if (samplePeriod > 0)
+    {
+        Util_restartClock(&periodicClock, samplePeriod);
+    }
 }
 
 /*********************************************************************
- * @fn      HidGameController_processAppMsg
+ * @fn      HidGameController_keyEvt
  *
- * @brief   Process an incoming task message.
+ * @brief   Handle a key change.
  *
- * @param   pMsg - message to process
+ * @param   events - pending events
  *
  * @return  none
  */
-static void HidGameController_processAppMsg(hidGameControllerEvt_t *pMsg)
+static void HidGameController_keyEvt(uint32_t events)
 {
-    switch (pMsg->hdr.event)
+    hidGameControllerModes_t modes;
+
+    if (PowerGov_getState() == POWERGOV_STATE_SUSPENDED)
+    {
+        if ((hidGameControllerCfg.hidFlags & HID_FLAGS_REMOTE_WAKE) &&
+            (!Util_isBufSet(&buf[4], KEY_NONE, 3) ||
+             (HidGameController_mouseButtons(keysHeld) != MOUSE_BUTTON_NONE)))
+        {
+            // Remote wake: resume and send the key right away,
+            // HidDev reconnects first if needed.
+            PowerGov_suspend(FALSE);
+            HidGameController_sendReport();
+        }
+        else
+        {
+            buf[4] = KEY_NONE;
+            buf[5] = KEY_NONE;
+            buf[6] = KEY_NONE;
+            keyPressPending = FALSE;
+        }
+    }
+    else
+    {
+        if (pointerModeReq != pointerMode)
+        {
+            HidGameController_setPointerMode(pointerModeReq);
+        }
+
+        if (tiltModeReq != tiltMode)
+        {
+            HidGameController_setTiltMode(tiltModeReq);
+        }
+
+        // Kept for the next power up, written after the play
+        modes.pointer = pointerMode;
+        modes.tilt = tiltMode;
+        VOID Cfg_set(CFG_ITEM_MODES, &modes);
+    }
+
+    PowerGov_inputActivity();
+}
+
+/*********************************************************************
+ * @fn      HidGameController_linkMonEvt
+ *
+ * @brief   Poll the link monitor.
+ *
+ * @param   events - pending events
+ *
+ * @return  none
+ */
+static void HidGameController_linkMonEvt(uint32_t events)
+{
+    LinkMon_poll();
+    Util_restartClock(&linkMonClock, LINKMON_PERIOD);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_memMonEvt
+ *
+ * @brief   Sample the memory monitor.
+ *
+ * @param   events - pending events
+ *
+ * @return  none
+ */
+static void HidGameController_memMonEvt(uint32_t events)
+{
+    MemMon_sample();
+    Util_restartClock(&memMonClock, MEMMON_PERIOD);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_pointerEvt
+ *
+ * @brief   Send the pointer motion since the last tick and run again
+ *          while the joystick is deflected.
+ *
+ * @param   events - pending events
+ *
+ * @return  none
+ */
+static void HidGameController_pointerEvt(uint32_t events)
+{
+    uint8_t keys = keysHeld;
+    int8_t dx;
+    int8_t dy;
+
+    HidJoystick_Read();
+
+    // Stop at rest, in the media chord and out of pointer mode
+    if (!pointerActive || !pointerMode || (keys & KEY_SELECT) ||
+        !Pointer_move(joystickX, joystickY, pointerPeriod, &dx, &dy))
+    {
+        Pointer_reset();
+        pointerActive = FALSE;
+        return;
+    }
+
+    // Below one count the motion waits in the remainder
+    if ((dx != 0) || (dy != 0))
+    {
+        HidGameController_sendMouseReport(HidGameController_mouseButtons(keys),
+                                          dx, dy);
+    }
+
+    Util_restartClock(&pointerClock, pointerPeriod);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_displayEvt
+ *
+ * @brief   Refresh the dashboard or run a slice of its drawing.
+ *
+ * @param   events - pending events
+ *
+ * @return  none
+ */
+static void HidGameController_displayEvt(uint32_t events)
+{
+    Dash_process();
+}
+
+#ifdef INPUT_TRACE
+/*********************************************************************
+ * @fn      HidGameController_traceEvt
+ *
+ * @brief   Drain the input trace.
+ *
+ * @param   events - pending events
+ *
+ * @return  none
+ */
+static void HidGameController_traceEvt(uint32_t events)
+{
+    InputTrace_drain();
+    Util_restartClock(&traceClock, INPUT_TRACE_DRAIN_PERIOD);
+}
+#endif // INPUT_TRACE
+
+#ifdef PROF_PROBES
+/*********************************************************************
+ * @fn      HidGameController_profEvt
+ *
+ * @brief   Publish the profiling probes.
+ *
+ * @param   events - pending events
+ *
+ * @return  none
+ */
+static void HidGameController_profEvt(uint32_t events)
+{
+    Prof_publish();
+    Util_restartClock(&profClock, PROF_PERIOD);
+}
+#endif // PROF_PROBES
+
+/*********************************************************************
+ * @fn      HidGameController_processStackMsg
+ *
+ * @brief   Process an incoming stack message.
+ *
+ * @param   pMsg - message to process
+ *
+ * @return  none
+ */
+static void HidGameController_processStackMsg(ICall_Hdr *pMsg)
+{
+    switch (pMsg->event)
+    {
+        case GATT_MSG_EVENT:
+            HidGameController_processGattMsg((gattMsgEvent_t *) pMsg);
+        break;
+
+        case HCI_GAP_EVENT_EVENT:
+        {
+            // RSSI and packet error rate results belong to the link monitor
+            if (LinkMon_processHciEvt(pMsg))
+            {
+                break;
+            }
+
+            // Process HCI message
+            switch(pMsg->status)
+            {
+                case HCI_COMMAND_COMPLETE_EVENT_CODE:
+                // Process HCI Command Complete Event
+                {
+
+#if !defined (USE_LL_CONN_PARAM_UPDATE)
+                    // This code will disable the use of the LL_CONNECTION_PARAM_REQ
+                    // control procedure (for connection parameter updates, the
+                    // L2CAP Connection Parameter Update procedure will be used
+                    // instead). To re-enable the LL_CONNECTION_PARAM_REQ control
+                    // procedures, define the symbol USE_LL_CONN_PARAM_UPDATE
+
+                    // Parse Command Complete Event for opcode and status
+                    hciEvt_CmdComplete_t* command_complete = (hciEvt_CmdComplete_t*) pMsg;
+                    uint8_t   pktStatus = command_complete->pReturnParam[0];
+
+                    //find which command this command complete is for
+                    switch (command_complete->cmdOpcode)
+                    {
+                        case HCI_LE_READ_LOCAL_SUPPORTED_FEATURES:
+                        {
+                            if (pktStatus == SUCCESS)
+                            {
+                                uint8_t featSet[8];
+
+                                // get current feature set from received event (bits 1-9 of
+                                // the returned data
+                                memcpy( featSet, &command_complete->pReturnParam[1], 8 );
+
+                                // Clear bit 1 of byte 0 of feature set to disable LL
+                                // Connection Parameter Updates
+                                CLR_FEATURE_FLAG( featSet[0], LL_FEATURE_CONN_PARAMS_REQ );
+
+                                // Update controller with modified features
+                                HCI_EXT_SetLocalSupportedFeaturesCmd( featSet );
+                            }
+                        }
+                        break;
+
+                        default:
+                        //do nothing
+                        break;
+                    }
+#endif // !defined (USE_LL_CONN_PARAM_UPDATE)
+
+                }
+                break;
+
+                default:
+                break;
+            }
+        }
+        break;
+
+        default:
+        // Do nothing
+        break;
+    }
+}
+
+/*********************************************************************
+ * @fn      HidGameController_processGattMsg
+ *
+ * @brief   Process GATT messages
+ *
+ * @return  none
+ */
+static void HidGameController_processGattMsg(gattMsgEvent_t *pMsg)
+{
+    GATT_bm_free(&pMsg->msg, pMsg->method);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_processAppMsg
+ *
+ * @brief   Process an incoming task message.
+ *
+ * @param   pMsg - message to process
+ *
+ * @return  none
+ */
+static void HidGameController_processAppMsg(hidGameControllerEvt_t *pMsg)
+{
+    switch (pMsg->hdr.event)
     {
         case HID_STATE_CHANGE_EVT:
         {
+            switch (pMsg->hdr.state)
+            {
+                case HID_DEV_SUSPEND_EVT:
+                    PowerGov_suspend(TRUE);
+                    break;
+
+                case HID_DEV_EXIT_SUSPEND_EVT:
+                    PowerGov_suspend(FALSE);
+                    break;
+
+                case HID_DEV_GAPROLE_STATE_CHANGE_EVT:
+                    HidGameController_processGapStateChange();
+                    PowerGov_linkEvent();
+                    break;
+
+                case HID_DEV_GAPBOND_STATE_CHANGE_EVT:
+                    PowerGov_linkEvent();
+                    break;
+
+                case HID_DEV_SET_BOOT_EVT:
+                case HID_DEV_SET_REPORT_EVT:
+                    HidGameController_setProtocolMode();
+                    break;
+
+                default:
+                    break;
+            }
+            break;
+        }
+
+        case HID_CFG_FLUSH_EVT:
+            Cfg_flush();
+            break;
+
+        default:
+        //Do nothing.
+        break;
+    }
+}
+
+/*********************************************************************
+ * @fn      HidKEmukbd_keyPressHandler
+ *
+ * @brief   Key event handler function.
+ *
+ * @param   a0 - ignored
+ *
+ * @return  none
+ */
+static void HidGameController_keyPressHandler(uint8_t keys)
+{
+    // Keycodes 3 z, 4 x and 5 select/start are sent once per press and
+    // cleared when sent, a release before then keeps them
+    uint8_t pressed = keys & ~keysHeld;
+
+    keysHeld = keys;
+
+    if (pressed && !keyPressPending)
+    {
+        keyPressTime = Timestamp_get32();
+        keyPressPending = TRUE;
+    }
+
+    // SELECT + X switches the pointer mode and SELECT + Z steps the tilt
+    // mode, applied by the task
+    if ((pressed & (KEY_X | KEY_Z)) && (keys & KEY_SELECT))
+    {
+        if (pressed & KEY_X)
+        {
+            pointerModeReq = !pointerModeReq;
+        }
+
+        if (pressed & KEY_Z)
+        {
+            tiltModeReq = (tiltModeReq + 1) % TILT_NUM_MODES;
+        }
+    }
+    // Z and X are the mouse buttons in pointer mode
+    else if (!pointerModeReq)
+    {
+        if (pressed & KEY_Z)
+        {
+            buf[4] = keymap.z;
+        }
+
+        if (pressed & KEY_X)
+        {
+            buf[5] = keymap.x;
+        }
+    }
+
+    if (pressed & KEY_SELECT)
+    {
+        buf[6] = keymap.select;
+    }
+
+    // START is play/pause in the media chord, there is none in boot mode
+    if ((pressed & KEY_START) &&
+        (!(keys & KEY_SELECT) || (hidProtocolMode == HID_PROTOCOL_MODE_BOOT)))
+    {
+        buf[6] = keymap.start;
+    }
+
+    // Called from the key debounce clock, let the task feed the governor
+    Event_post(syncEvent, HIDGAMECONTROLLER_KEY_EVT);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_PeriodicEvent
+ *
+ * @brief   Perform a periodic application task. This function gets called
+ *          every 80 ms (HID_PERIODIC_EVT_PERIOD) during active play and
+ *          less often while idle, see powergov.h.
+ *
+ * @param   None.
+ *
+ * @return  None.
+ */
+static void HidGameController_PeriodicEvent(void)
+{
+    HidGameController_applyBattPolicy();
+
+    HidJoystick_Read();
+
+    PowerGov_sampled(!Util_isBufSet(&buf[2], KEY_NONE, 5) ||
+                     (keysHeld != 0) || (joystickX != 0) || (joystickY != 0));
+
+    HidGameController_sendReport();
+}
+
+/*********************************************************************
+ * @fn      HidGameController_sendReport
+ *
+ * @brief   Build and send the input reports with the builder of the
+ *          protocol mode in use. The mode is read once, all the reports of
+ *          a round have the format of the same mode.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void HidGameController_sendReport(void)
+{
+    uint8_t mode = hidProtocolMode;
+
+    PROF_ENTER(SEND_REPORT);
+
+    buf[0] = 0;         // Modifier keys
+    buf[1] = 0;         // Reserved
+    buf[7] = 0;         // Keycode 6
+
+    if (mode > HID_PROTOCOL_MODE_REPORT)
+    {
+        mode = HID_PROTOCOL_MODE_REPORT;
+    }
+
+    (*hidGameControllerRptBuilders[mode])(keysHeld);
+
+    PowerGov_reportSent();
+
+    if (keyPressPending)
+    {
+        Types_FreqHz freq;
+
+        keyPressPending = FALSE;
+        Timestamp_getFreq(&freq);
+        Dash_addLatency((uint32_t)(((uint64_t)(Timestamp_get32() -
+                                               keyPressTime) * 1000000) /
+                                   freq.lo));
+    }
+
+    buf[4] = 0;         // Keycode 3 z
+    buf[5] = 0;         // Keycode 4 x
+    buf[6] = 0;         // Keycode select start
+
+    PROF_EXIT(SEND_REPORT);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_buildReports
+ *
+ * @brief   Report protocol mode builder: the HID keyboard, gamepad and
+ *          consumer control reports, and the mouse report in pointer mode.
+ *          HidDev sends only the reports that changed, all in the same
+ *          connection event.
+ *
+ * @param   keys - KEY_* held
+ *
+ * @return  none
+ */
+static void HidGameController_buildReports(uint8_t keys)
+{
+    hidGamepadInRpt_t gamepadRpt;
+    hidConsumerInRpt_t consumerRpt = { 0 };
+    uint8_t gamepadBuf[HID_GAMEPAD_IN_RPT_LEN];
+    uint8_t consumerBuf[HID_CONSUMER_IN_RPT_LEN];
+
+    // The joystick is the media control in the media chord
+    if (keys & KEY_SELECT)
+    {
+        if (buf[3] == keymap.up)
+        {
+            consumerRpt.usage = KEY_UP_CONSUMER_BINDING;
+        }
+        else if (buf[3] == keymap.down)
+        {
+            consumerRpt.usage = KEY_DOWN_CONSUMER_BINDING;
+        }
+        else if (buf[2] == keymap.left)
+        {
+            consumerRpt.usage = KEY_LEFT_CONSUMER_BINDING;
+        }
+        else if (buf[2] == keymap.right)
+        {
+            consumerRpt.usage = KEY_RIGHT_CONSUMER_BINDING;
+        }
+        else if (keys & KEY_START)
+        {
+            consumerRpt.usage = KEY_START_CONSUMER_BINDING;
+        }
+
+        buf[2] = KEY_NONE;
+        buf[3] = KEY_NONE;
+    }
+
+    gamepadRpt.buttons = 0;
+    gamepadRpt.buttons |= (keys & KEY_SELECT) ? KEY_SELECT_GAMEPAD_BINDING : 0;
+    gamepadRpt.buttons |= (keys & KEY_START) ? KEY_START_GAMEPAD_BINDING : 0;
+
+    // The joystick and Z and X belong to the mouse in pointer mode
+    if (pointerMode)
+    {
+        buf[2] = KEY_NONE;
+        buf[3] = KEY_NONE;
+        gamepadRpt.x = 0;
+        gamepadRpt.y = 0;
+    }
+    else
+    {
+        gamepadRpt.buttons |= (keys & KEY_Z) ? KEY_Z_GAMEPAD_BINDING : 0;
+        gamepadRpt.buttons |= (keys & KEY_X) ? KEY_X_GAMEPAD_BINDING : 0;
+        gamepadRpt.x = joystickX;
+        gamepadRpt.y = joystickY;
+    }
+
+    HidRpt_packGamepadIn(&gamepadRpt, gamepadBuf);
+    HidRpt_packConsumerIn(&consumerRpt, consumerBuf);
+
+    HidDev_Report(HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT,
+                  HID_KEY_IN_RPT_LEN, buf);
+
+    HidDev_Report(HID_RPT_ID_GAMEPAD_IN, HID_REPORT_TYPE_INPUT,
+                  HID_GAMEPAD_IN_RPT_LEN, gamepadBuf);
+
+    HidDev_Report(HID_RPT_ID_CONSUMER_IN, HID_REPORT_TYPE_INPUT,
+                  HID_CONSUMER_IN_RPT_LEN, consumerBuf);
+
+    if (pointerMode)
+    {
+        HidGameController_updatePointer(keys);
+    }
+}
+
+/*********************************************************************
+ * @fn      HidGameController_buildBootReports
+ *
+ * @brief   Boot protocol mode builder for BIOS-style hosts: the boot
+ *          keyboard report only, and the boot mouse report in pointer
+ *          mode. No media chord, gamepad or consumer control report.
+ *
+ * @param   keys - KEY_* held
+ *
+ * @return  none
+ */
+static void HidGameController_buildBootReports(uint8_t keys)
+{
+    if (pointerMode)
+    {
+        buf[2] = KEY_NONE;
+        buf[3] = KEY_NONE;
+    }
+
+    HidDev_Report(HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT,
+                  HID_BOOT_KEY_IN_RPT_LEN, buf);
+
+    if (pointerMode)
+    {
+        HidGameController_updatePointer(keys);
+    }
+}
+
+/*********************************************************************
+ * @fn      HidGameController_updatePointer
+ *
+ * @brief   Send the mouse buttons that changed and start the pointer
+ *          motion once the joystick is deflected, in pointer mode.
+ *
+ * @param   keys - KEY_* held
+ *
+ * @return  none
+ */
+static void HidGameController_updatePointer(uint8_t keys)
+{
+    // Motion goes out on the pointer clock, only button changes here
+    if (HidGameController_mouseButtons(keys) != mouseButtonsSent)
+    {
+        HidGameController_sendMouseReport(
+            HidGameController_mouseButtons(keys), 0, 0);
+    }
+
+    if (!pointerActive && !(keys & KEY_SELECT) &&
+        ((joystickX != 0) || (joystickY != 0)))
+    {
+        HidGameController_startPointer();
+    }
+}
+
+/*********************************************************************
+ * @fn      HidGameController_sendMouseReport
+ *
+ * @brief   Build and send a HID mouse report.
+ *
+ * @param   buttons - Mouse button code
+ * @param   dx - X motion in counts
+ * @param   dy - Y motion in counts
+ *
+ * @return  none
+ */
+static void HidGameController_sendMouseReport(uint8_t buttons, int8_t dx,
+                                              int8_t dy)
+{
+    hidMouseInRpt_t rpt = { 0 };
+    uint8_t buf[HID_MOUSE_IN_RPT_LEN];
+
+    rpt.buttons = buttons;
+    rpt.x = dx;
+    rpt.y = dy;
+
+    // The boot mouse report has the same layout, its first three bytes
+    // are the boot format
+    HidRpt_packMouseIn(&rpt, buf);
+
+    HidDev_Report(HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT,
+                  HID_MOUSE_IN_RPT_LEN, buf);
+
+    mouseButtonsSent = buttons;
+}
+
+/*********************************************************************
+ * @fn      HidGameController_mouseButtons
+ *
+ * @brief   Mouse buttons held in pointer mode.
+ *
+ * @param   keys - KEY_* held
+ *
+ * @return  Mouse button code, none out of pointer mode
+ */
+static uint8_t HidGameController_mouseButtons(uint8_t keys)
+{
+    uint8_t buttons = MOUSE_BUTTON_NONE;
+
+    if (pointerMode)
+    {
+        buttons |= (keys & KEY_Z) ? KEY_Z_MOUSE_BINDING : 0;
+
+        // X with SELECT switches the mode, it is no click
+        if (!(keys & KEY_SELECT))
+        {
+            buttons |= (keys & KEY_X) ? KEY_X_MOUSE_BINDING : 0;
+        }
+    }
+
+    return buttons;
+}
+
+/*********************************************************************
+ * @fn      HidGameController_setPointerMode
+ *
+ * @brief   Switch the pointer mode. Mouse buttons still down are
+ *          released first.
+ *
+ * @param   enable - TRUE for pointer mode
+ *
+ * @return  none
+ */
+static void HidGameController_setPointerMode(uint8_t enable)
+{
+    if (mouseButtonsSent != MOUSE_BUTTON_NONE)
+    {
+        HidGameController_sendMouseReport(MOUSE_BUTTON_NONE, 0, 0);
+    }
+
+    pointerMode = enable;
+    Pointer_reset();
+
+    Display_print1(dispHandle, 0, 0, "Pointer mode %s", enable ? "on" : "off");
+}
+
+/*********************************************************************
+ * @fn      HidGameController_setTiltMode
+ *
+ * @brief   Switch the tilt mode. The next accelerometer sample sets the
+ *          neutral pose.
+ *
+ * @param   mode - TILT_MODE_*
+ *
+ * @return  none
+ */
+static void HidGameController_setTiltMode(uint8_t mode)
+{
+    tiltMode = mode;
+    Tilt_reset();
+
+    Display_print1(dispHandle, 0, 0, "Tilt mode %s", tiltModeNames[mode]);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_setProtocolMode
+ *
+ * @brief   Start over in the protocol mode the host selected. HidDev has
+ *          dropped the reports queued and sent in the old mode, the
+ *          builder of the new mode sends the inputs held right away.
+ *
+ * @return  none
+ */
+static void HidGameController_setProtocolMode(void)
+{
+    Util_stopClock(&pointerClock);
+    pointerActive = FALSE;
+    mouseButtonsSent = MOUSE_BUTTON_NONE;
+    Pointer_reset();
+
+    Display_print1(dispHandle, 0, 0, "Protocol mode %s",
+                   (hidProtocolMode == HID_PROTOCOL_MODE_BOOT) ?
+                   "boot" : "report");
+
+    HidGameController_sendReport();
+}
+
+/*********************************************************************
+ * @fn      HidGameController_startPointer
+ *
+ * @brief   Start the pointer motion clock, one motion report per
+ *          connection event while the joystick is deflected.
+ *
+ * @return  none
+ */
+static void HidGameController_startPointer(void)
+{
+    uint16_t connInterval;
+
+    GAPRole_GetParameter(GAPROLE_CONN_INTERVAL, &connInterval);
+
+    // Connection interval in units of 1.25 ms
+    pointerPeriod = (connInterval * 5) / 4;
+
+    if (pointerPeriod < POINTER_MIN_PERIOD)
+    {
+        pointerPeriod = POINTER_MIN_PERIOD;
+    }
+
+    pointerActive = TRUE;
+    Event_post(syncEvent, HIDGAMECONTROLLER_POINTER_EVT);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_receiveReport
+ *
+ * @brief   Process an incoming HID keyboard report.
+ *
+ * @param   len - Length of report.
+ * @param   pData - Report data.
+ *
+ * @return  status
+ */
+static uint8_t HidGameController_receiveReport(uint8_t len, uint8_t *pData)
+{
+    // Verify data length
+    if (len == HID_LED_OUT_RPT_LEN)
+    {
+        kbdLeds = *pData;
+        HidGameController_applyLights();
+
+        return SUCCESS;
+    }
+    else
+    {
+        return ATT_ERR_INVALID_VALUE_SIZE;
+    }
+}
+
+/*********************************************************************
+ * @fn      HidGameController_receiveLightReport
+ *
+ * @brief   Process an incoming lights output report: the pattern, player
+ *          number, color and period of the RGB LED.
+ *
+ * @param   len - Length of report.
+ * @param   pData - Report data.
+ *
+ * @return  status
+ */
+static uint8_t HidGameController_receiveLightReport(uint8_t len,
+                                                   uint8_t *pData)
+{
+    hidLightOutRpt_t rpt;
+    ledSeq_t seq;
+
+    if (len != HID_LIGHT_OUT_RPT_LEN)
+    {
+        return ATT_ERR_INVALID_VALUE_SIZE;
+    }
+
+    HidRpt_unpackLightOut(pData, &rpt);
+
+    seq.pattern = rpt.pattern;
+    seq.player = rpt.player;
+    seq.color[LEDSEQ_RED] = rpt.red;
+    seq.color[LEDSEQ_GREEN] = rpt.green;
+    seq.color[LEDSEQ_BLUE] = rpt.blue;
+    seq.period = (rpt.period != 0) ? (rpt.period * LIGHT_PERIOD_UNIT) :
+                                     LEDSEQ_DEFAULT_PERIOD;
+
+    // Pattern off gives the LED back to the keyboard LEDs
+    if (seq.pattern == LEDSEQ_PATTERN_OFF)
+    {
+        lightSeq.pattern = LEDSEQ_PATTERN_OFF;
+        HidGameController_applyLights();
+    }
+    else if (LedSeq_start(&seq) == SUCCESS)
+    {
+        lightSeq = seq;
+    }
+    else
+    {
+        return ATT_ERR_INVALID_VALUE;
+    }
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      HidGameController_applyLights
+ *
+ * @brief   Show the lights sequence of the host on the RGB LED, or the
+ *          keyboard LEDs while there is none.
+ *
+ * @return  none
+ */
+static void HidGameController_applyLights(void)
+{
+    ledSeq_t seq = { LEDSEQ_PATTERN_SOLID };
+
+    if (lightSeq.pattern != LEDSEQ_PATTERN_OFF)
+    {
+        seq = lightSeq;
+    }
+    else
+    {
+        seq.color[LEDSEQ_RED] = (kbdLeds & LED_CAPS_LOCK) ? KBD_LED_LEVEL : 0;
+        seq.color[LEDSEQ_GREEN] = (kbdLeds & LED_SCROLL_LOCK) ? KBD_LED_LEVEL : 0;
+        seq.color[LEDSEQ_BLUE] = (kbdLeds & LED_NUM_LOCK) ? KBD_LED_LEVEL : 0;
+    }
+
+    // Starts a checked sequence or a solid one, it does not fail
+    VOID LedSeq_start(&seq);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_receiveEffectReport
+ *
+ * @brief   Process an incoming effect output report: stop the effects, or
+ *          play a tone with its frequency, duration, strength and envelope
+ *          at once or after the queued ones.
+ *
+ * @param   len - Length of report.
+ * @param   pData - Report data.
+ *
+ * @return  status
+ */
+static uint8_t HidGameController_receiveEffectReport(uint8_t len,
+                                                    uint8_t *pData)
+{
+    hidEffectOutRpt_t rpt;
+    effect_t effect;
+    uint8_t status;
+
+    if (len != HID_EFFECT_OUT_RPT_LEN)
+    {
+        return ATT_ERR_INVALID_VALUE_SIZE;
+    }
+
+    HidRpt_unpackEffectOut(pData, &rpt);
+
+    if (rpt.command == EFFECT_CMD_STOP)
+    {
+        Effect_stop();
+
+        return SUCCESS;
+    }
+    else if ((rpt.command != EFFECT_CMD_PLAY) &&
+             (rpt.command != EFFECT_CMD_QUEUE))
+    {
+        return ATT_ERR_INVALID_VALUE;
+    }
+
+    effect.freq = rpt.frequency;
+    effect.duration = rpt.duration;
+    effect.attack = rpt.attack * EFFECT_ENVELOPE_UNIT;
+    effect.fade = rpt.fade * EFFECT_ENVELOPE_UNIT;
+    effect.level = rpt.level;
+
+    status = Effect_play(&effect, (rpt.command == EFFECT_CMD_PLAY) ?
+                                  EFFECT_PLAY_NOW : EFFECT_PLAY_QUEUED);
+
+    if (status == bleNoResources)
+    {
+        return ATT_ERR_INSUFFICIENT_RESOURCES;
+    }
+    else if (status != SUCCESS)
+    {
+        return ATT_ERR_INVALID_VALUE;
+    }
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      HidGameController_reportCB
+ *
+ * @brief   HID Dev report callback.
+ *
+ * @param   id - HID report ID.
+ * @param   type - HID report type.
+ * @param   uuid - attribute uuid.
+ * @param   oper - operation:  read, write, etc.
+ * @param   len - Length of report.
+ * @param   pData - Report data.
+ *
+ * @return  GATT status code.
+ */
+static uint8_t HidGameController_reportCB(uint8_t id, uint8_t type, uint16_t uuid,
+                                  uint8_t oper, uint16_t *pLen, uint8_t *pData)
+{
+    uint8_t status = SUCCESS;
 
-            break;
+    // Write
+    if (oper == HID_DEV_OPER_WRITE)
+    {
+        // Process writes to the lights, effect and LED output reports;
+        // ignore others
+        if ((uuid == REPORT_UUID) && (type == HID_REPORT_TYPE_OUTPUT) &&
+            (id == HID_RPT_ID_LIGHT_OUT))
+        {
+            status = HidGameController_receiveLightReport(*pLen, pData);
+        }
+        else if ((uuid == REPORT_UUID) && (type == HID_REPORT_TYPE_OUTPUT) &&
+                 (id == HID_RPT_ID_EFFECT_OUT))
+        {
+            // Played from here, the tone starts in the connection event
+            // of the write
+            status = HidGameController_receiveEffectReport(*pLen, pData);
+        }
+        else if (((uuid == REPORT_UUID) && (type == HID_REPORT_TYPE_OUTPUT)) ||
+                 (uuid == BOOT_KEY_OUTPUT_UUID))
+        {
+            status = HidGameController_receiveReport(*pLen, pData);
         }
 
+        if (status == SUCCESS)
+        {
+            status = HidKbd_SetParameter(id, type, uuid, *pLen, pData);
+        }
+    }
+    // Read
+    else if (oper == HID_DEV_OPER_READ)
+    {
+        uint8_t len;
 
-        default:
-        //Do nothing.
-        break;
+        status = HidKbd_GetParameter(id, type, uuid, &len, pData);
+        if (status == SUCCESS)
+        {
+            *pLen = len;
+        }
     }
+
+    return status;
 }
 
 /*********************************************************************
- * @fn      HidKEmukbd_keyPressHandler
+ * @fn      HidGameController_hidEventCB
  *
- * @brief   Key event handler function.
+ * @brief   HID Dev event callback.
  *
- * @param   a0 - ignored
+ * @param   evt - event ID.
+ *
+ * @return  HID response code.
+ */
+static void HidGameController_hidEventCB(uint8_t evt)
+{
+    // Called from HidDev or stack context, process in the application task
+    HidGameController_enqueueMsg(HID_STATE_CHANGE_EVT, evt);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_dashStatusCB
+ *
+ * @brief   Fill in the state shown on the dashboard.
+ *
+ * @param   pStatus - state to fill in
  *
  * @return  none
  */
-static void HidGameController_keyPressHandler(uint8_t keys)
+static void HidGameController_dashStatusCB(dashStatus_t *pStatus)
 {
-    buf[4] = KEY_NONE;         // Keycode 3 z
-    buf[5] = KEY_NONE;         // Keycode 4 x
-    buf[6] = KEY_NONE;         // Keycode 5 select/start
+    hidDevReportStats_t rptStats;
+    uint8_t gapState;
+
+    HidDev_GetParameter(HIDDEV_GAPROLE_STATE, &gapState);
+    HidDev_GetParameter(HIDDEV_REPORT_STATS, &rptStats);
+    Batt_GetParameter(BATT_PARAM_LEVEL, &pStatus->battLevel);
+
+    pStatus->powerState = PowerGov_getState();
+    pStatus->connected = (gapState == GAPROLE_CONNECTED);
+    pStatus->linkState = LinkMon_getState();
+    pStatus->protocolMode = hidProtocolMode;
+    pStatus->pointerMode = pointerMode;
+    pStatus->tiltMode = tiltMode;
+    pStatus->reportsSent = rptStats.sent;
+}
 
-    if (keys & KEY_Z)
-    {
-        buf[4] = KEY_Z_HID_BINDING;
-    }
+/*********************************************************************
+ * @fn      HidGameController_displayWakeCB
+ *
+ * @brief   Run the next dashboard slice in the application task. Called
+ *          from the SPI or clock context.
+ *
+ * @return  none
+ */
+static void HidGameController_displayWakeCB(void)
+{
+    Event_post(syncEvent, HIDGAMECONTROLLER_DISPLAY_EVT);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_cfgFlushCB
+ *
+ * @brief   Write the changed settings in the application task. Called
+ *          from the clock context, or the task when the hold ends.
+ *
+ * @return  none
+ */
+static void HidGameController_cfgFlushCB(void)
+{
+    HidGameController_enqueueMsg(HID_CFG_FLUSH_EVT, 0);
+}
+
+/*********************************************************************
+ * @fn      HidGameController_keymapValid
+ *
+ * @brief   Check the key bindings: keyboard usages the report takes.
+ *          KEY_NONE is not a binding, the joystick keys compare to it.
+ *
+ * @param   pValue - hidGameControllerKeymap_t
+ *
+ * @return  TRUE if valid
+ */
+static uint8_t HidGameController_keymapValid(const void *pValue)
+{
+    const uint8_t *pKeys = pValue;
+    uint8_t i;
 
-    if (keys & KEY_X)
+    for (i = 0; i < sizeof(hidGameControllerKeymap_t); i++)
     {
-        buf[5] = KEY_X_HID_BINDING;
+        if ((pKeys[i] < HID_KEYBOARD_A) || (pKeys[i] > KEY_BINDING_MAX))
+        {
+            return FALSE;
+        }
     }
 
-    if (keys & KEY_SELECT)
+    return TRUE;
+}
+
+/*********************************************************************
+ * @fn      HidGameController_inputValid
+ *
+ * @brief   Check the input settings: a sampling period between the
+ *          fastest pointer motion and the idle period, a dead zone short
+ *          of the joystick travel.
+ *
+ * @param   pValue - hidGameControllerInput_t
+ *
+ * @return  TRUE if valid
+ */
+static uint8_t HidGameController_inputValid(const void *pValue)
+{
+    const hidGameControllerInput_t *pInput = pValue;
+
+    return ((pInput->samplePeriod >= POINTER_MIN_PERIOD) &&
+            (pInput->samplePeriod <= POWERGOV_IDLE_SAMPLE_PERIOD) &&
+            (pInput->deadzone <= JOYSTICK_DEADZONE_MAX));
+}
+
+/*********************************************************************
+ * @fn      HidGameController_connParamsValid
+ *
+ * @brief   Check the desired connection parameters against the ranges of
+ *          the specification. The supervision timeout has to outlast two
+ *          of the longest intervals the latency allows.
+ *
+ * @param   pValue - gapRoleConnParams_t
+ *
+ * @return  TRUE if valid
+ */
+static uint8_t HidGameController_connParamsValid(const void *pValue)
+{
+    const gapRoleConnParams_t *pParams = pValue;
+
+    return ((pParams->minConnInterval >= CFG_CONN_INTERVAL_MIN) &&
+            (pParams->minConnInterval <= pParams->maxConnInterval) &&
+            (pParams->maxConnInterval <= CFG_CONN_INTERVAL_MAX) &&
+            (pParams->slaveLatency <= CFG_SLAVE_LATENCY_MAX) &&
+            (pParams->timeoutMultiplier >= CFG_CONN_TIMEOUT_MIN) &&
+            (pParams->timeoutMultiplier <= CFG_CONN_TIMEOUT_MAX) &&
+            ((uint32_t)pParams->timeoutMultiplier * 4 >
+             ((uint32_t)pParams->slaveLatency + 1) *
+             pParams->maxConnInterval));
+}
+
+/*********************************************************************
+ * @fn      HidGameController_advParamsValid
+ *
+ * @brief   Check the advertising interval ranges of the three modes, as
+ *          HidDev does.
+ *
+ * @param   pValue - hidDevAdvParams_t
+ *
+ * @return  TRUE if valid
+ */
+static uint8_t HidGameController_advParamsValid(const void *pValue)
+{
+    const hidDevAdvMode_t *pMode = pValue;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(hidDevAdvParams_t) / sizeof(hidDevAdvMode_t); i++)
     {
-        buf[6] = KEY_SELECT_HID_BINDING;
+        if ((pMode[i].intMin < CFG_ADV_INTERVAL_MIN) ||
+            (pMode[i].intMin > pMode[i].intMax) ||
+            (pMode[i].intMax > CFG_ADV_INTERVAL_MAX))
+        {
+            return FALSE;
+        }
     }
 
-    if (keys & KEY_START)
+    return TRUE;
+}
+
+/*********************************************************************
+ * @fn      HidGameController_checkGattLayout
+ *
+ * @brief   Compare the attribute table layout with the one the bonds were
+ *          made with. On a change, flag Service Changed in every bond
+ *          record, the bond manager indicates it to each bonded host on
+ *          its next encrypted connection, and store the new layout.
+ *
+ * @return  none
+ */
+static void HidGameController_checkGattLayout(void)
+{
+    uint32_t layout = GATT_LAYOUT;
+
+    if (gattLayout == layout)
     {
-        buf[6] = KEY_START_HID_BINDING;
+        return;
     }
+
+    // No bond yet is fine, the layout is stored all the same
+    VOID GAPBondMgr_ServiceChangeInd(BOND_ALL_RECORDS, TRUE);
+    VOID Cfg_set(CFG_ITEM_GATT_LAYOUT, &layout);
 }
 
 /*********************************************************************
- * @fn      HidGameController_PeriodicEvent
+ * @fn      HidGameController_modesValid
  *
- * @brief   Perform a periodic application task. This function gets called
- *          every 80 ms (HID_PERIODIC_EVT_PERIOD).
+ * @brief   Check the modes.
  *
- * @param   None.
+ * @param   pValue - hidGameControllerModes_t
  *
- * @return  None.
+ * @return  TRUE if valid
  */
-static void HidGameController_PeriodicEvent(void)
+static uint8_t HidGameController_modesValid(const void *pValue)
 {
-    HidJoystick_Read();
-    HidGameController_sendReport();
+    const hidGameControllerModes_t *pModes = pValue;
+
+    return ((pModes->pointer <= TRUE) && (pModes->tilt < TILT_NUM_MODES));
 }
 
 /*********************************************************************
- * @fn      HidGameController_sendReport
+ * @fn      HidGameController_processGapStateChange
  *
- * @brief   Build and send a HID keyboard report.
- *
- * @param   keycode - HID keycode.
+ * @brief   Start or stop the link and memory monitors and the trace drain
+ *          on connection state changes.
  *
  * @return  none
  */
-
-static void HidGameController_sendReport(void)
+static void HidGameController_processGapStateChange(void)
 {
-    buf[0] = 0;         // Modifier keys
-    buf[1] = 0;         // Reserved
-    buf[7] = 0;         // Keycode 6
+    uint8_t gapState;
 
-    HidDev_Report(HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT,
-                  HID_KEYBOARD_IN_RPT_LEN, buf);
+    HidDev_GetParameter(HIDDEV_GAPROLE_STATE, &gapState);
 
-    buf[4] = 0;         // Keycode 3 z
-    buf[5] = 0;         // Keycode 4 x
-    buf[6] = 0;         // Keycode select start
+    if (gapState == GAPROLE_CONNECTED)
+    {
+        uint16_t connHandle;
+
+        GAPRole_GetParameter(GAPROLE_CONNHANDLE, &connHandle);
+
+        linkOverrides = 0;
+        LinkMon_start(connHandle);
+
+        // Apply the battery policy again on the new connection
+        battPolicyStep = BATTPOLICY_STEP_NONE;
+        Util_startClock(&linkMonClock);
+        Util_startClock(&memMonClock);
+#ifdef INPUT_TRACE
+        Util_startClock(&traceClock);
+#endif // INPUT_TRACE
+#ifdef PROF_PROBES
+        Util_startClock(&profClock);
+#endif // PROF_PROBES
+    }
+    else
+    {
+        Util_stopClock(&linkMonClock);
+        Util_stopClock(&memMonClock);
+        Util_stopClock(&pointerClock);
+        pointerActive = FALSE;
+        mouseButtonsSent = MOUSE_BUTTON_NONE;
+
+        // The next host sets its own lights
+        lightSeq.pattern = LEDSEQ_PATTERN_OFF;
+        kbdLeds = 0;
+        LedSeq_stop();
+        Effect_stop();
+#ifdef INPUT_TRACE
+        Util_stopClock(&traceClock);
+#endif // INPUT_TRACE
+#ifdef PROF_PROBES
+        Util_stopClock(&profClock);
+#endif // PROF_PROBES
+        LinkMon_stop();
+    }
 }
 
-#ifdef USE_HID_MOUSEx
 /*********************************************************************
- * @fn      HidGameController_sendMouseReport
+ * @fn      HidGameController_linkStateCB
  *
- * @brief   Build and send a HID mouse report.
+ * @brief   Link monitor state change callback. Request a lower slave
+ *          latency while the link is degraded and go back to the
+ *          previous parameters once it is good again.
  *
- * @param   buttons - Mouse button code
+ * @param   newState - LINKMON_STATE_GOOD, _MARGINAL or _DEGRADED
  *
  * @return  none
  */
-static void HidGameController_sendMouseReport(uint8_t buttons)
+static void HidGameController_linkStateCB(uint8_t newState)
 {
-    uint8_t buf[HID_MOUSE_IN_RPT_LEN];
+    if ((newState == LINKMON_STATE_DEGRADED) &&
+        !(linkOverrides & LINK_OVERRIDE_DEGRADED))
+    {
+        HidGameController_setLinkOverrides(linkOverrides |
+                                           LINK_OVERRIDE_DEGRADED);
+    }
+    else if ((newState == LINKMON_STATE_GOOD) &&
+             (linkOverrides & LINK_OVERRIDE_DEGRADED))
+    {
+        HidGameController_setLinkOverrides(linkOverrides &
+                                           ~LINK_OVERRIDE_DEGRADED);
+    }
+}
+
+/*********************************************************************
+ * @fn      HidGameController_powerStateCB
+ *
+ * @brief   Power governor state change callback. While the host has
+ *          suspended the device the link monitor is stopped and a slower
+ *          connection is requested; the governor leaves only the button
+ *          interrupts armed to wake the host.
+ *
+ * @param   oldState - previous POWERGOV_STATE_*
+ * @param   newState - new POWERGOV_STATE_*
+ *
+ * @return  none
+ */
+static void HidGameController_powerStateCB(uint8_t oldState, uint8_t newState)
+{
+    if (newState == POWERGOV_STATE_SUSPENDED)
+    {
+        Util_stopClock(&linkMonClock);
+        Util_stopClock(&memMonClock);
+        Util_stopClock(&pointerClock);
+        pointerActive = FALSE;
+#ifdef PROF_PROBES
+        Util_stopClock(&profClock);
+#endif // PROF_PROBES
+        LedSeq_stop();
+        Effect_stop();
+
+        // The link monitor starts over on resume
+        HidGameController_setLinkOverrides((linkOverrides &
+                                            ~LINK_OVERRIDE_DEGRADED) |
+                                           LINK_OVERRIDE_SUSPEND);
+    }
+    else if (oldState == POWERGOV_STATE_SUSPENDED)
+    {
+        HidGameController_applyLights();
 
-    buf[0] = buttons;   // Buttons
-    buf[1] = 0;         // X
-    buf[2] = 0;         // Y
-    buf[3] = 0;         // Wheel
-    buf[4] = 0;         // AC Pan
+        if ((newState == POWERGOV_STATE_ACTIVE) ||
+            (newState == POWERGOV_STATE_IDLE_CONNECTED))
+        {
+            HidGameController_setLinkOverrides(linkOverrides &
+                                               ~LINK_OVERRIDE_SUSPEND);
+            Util_startClock(&linkMonClock);
+            Util_startClock(&memMonClock);
+#ifdef PROF_PROBES
+            Util_startClock(&profClock);
+#endif // PROF_PROBES
+        }
+    }
+    // Settings are not written during active play
+    Cfg_setHold(newState == POWERGOV_STATE_ACTIVE);
 
-    HidDev_Report(HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT,
-                  HID_MOUSE_IN_RPT_LEN, buf);
+    // The dashboard shows the state once more and stops with the radio
+    Dash_setActive((newState != POWERGOV_STATE_SUSPENDED) &&
+                   (newState != POWERGOV_STATE_DEEP_SLEEP));
 }
-#endif // USE_HID_MOUSE
 
 /*********************************************************************
- * @fn      HidGameController_receiveReport
+ * @fn      HidGameController_wakeCB
  *
- * @brief   Process an incoming HID keyboard report.
+ * @brief   Power governor wake source callback. Arm the key interrupts
+ *          and open the joystick and accelerometer ADC channels for the
+ *          states that wake on them, close them in the others.
  *
- * @param   len - Length of report.
- * @param   pData - Report data.
+ * @param   wakeSources - POWERGOV_WAKE_* of the new state
  *
- * @return  status
+ * @return  none
  */
-static uint8_t HidGameController_receiveReport(uint8_t len, uint8_t *pData)
+static void HidGameController_wakeCB(uint8_t wakeSources)
 {
-    // Verify data length
-    if (len == HID_LED_OUT_RPT_LEN)
-    {
-        // Set keyfob LEDs
-        //HalLedSet(HAL_LED_1, ((*pData & LED_CAPS_LOCK) == LED_CAPS_LOCK));
-        //HalLedSet(HAL_LED_2, ((*pData & LED_NUM_LOCK) == LED_NUM_LOCK));
+    Board_enableKeys(wakeSources & POWERGOV_WAKE_KEYS);
 
-        return SUCCESS;
+    if (wakeSources & POWERGOV_WAKE_JOYSTICK)
+    {
+        HidJoystick_Open();
     }
     else
     {
-        return ATT_ERR_INVALID_VALUE_SIZE;
+        HidJoystick_Close();
     }
 }
 
 /*********************************************************************
- * @fn      HidGameController_reportCB
+ * @fn      HidGameController_setLinkOverrides
  *
- * @brief   HID Dev report callback.
+ * @brief   Request the connection parameters of the overrides in effect.
+ *          The degraded link lowers the slave latency and the battery
+ *          policy sets the connection interval, keeping the latency the
+ *          supervision timeout allows; the suspend parameters replace
+ *          both. The first override holds a parameter negotiation in
+ *          progress, which goes on once the last one ends; otherwise the
+ *          parameters in use before the first one are requested again.
  *
- * @param   id - HID report ID.
- * @param   type - HID report type.
- * @param   uuid - attribute uuid.
- * @param   oper - operation:  read, write, etc.
- * @param   len - Length of report.
- * @param   pData - Report data.
+ * @param   overrides - LINK_OVERRIDE_* in effect
  *
- * @return  GATT status code.
+ * @return  none
  */
-static uint8_t HidGameController_reportCB(uint8_t id, uint8_t type, uint16_t uuid,
-                                  uint8_t oper, uint16_t *pLen, uint8_t *pData)
+static void HidGameController_setLinkOverrides(uint8_t overrides)
 {
-    uint8_t status = SUCCESS;
+    const battPolicyStep_t *pStep;
+    uint16_t minConnInterval = linkBaseConnInterval;
+    uint16_t maxConnInterval = linkBaseConnInterval;
+    uint16_t slaveLatency = linkBaseSlaveLatency;
+    uint16_t connTimeout = linkBaseConnTimeout;
 
-    // Write
-    if (oper == HID_DEV_OPER_WRITE)
+    if ((overrides == 0) && (linkOverrides == 0))
     {
-        if (uuid == REPORT_UUID)
-        {
-            // Process write to LED output report; ignore others
-            if (type == HID_REPORT_TYPE_OUTPUT)
-            {
-                status = HidGameController_receiveReport(*pLen, pData);
-            }
-        }
-
-        if (status == SUCCESS)
-        {
-            status = HidKbd_SetParameter(id, type, uuid, *pLen, pData);
-        }
+        return;
     }
-    // Read
-    else if (oper == HID_DEV_OPER_READ)
+
+    if (linkOverrides == 0)
     {
-        uint8_t len;
+        GAPRole_GetParameter(GAPROLE_CONN_INTERVAL, &linkBaseConnInterval);
+        GAPRole_GetParameter(GAPROLE_CONN_LATENCY, &linkBaseSlaveLatency);
+        GAPRole_GetParameter(GAPROLE_CONN_TIMEOUT, &linkBaseConnTimeout);
 
-        status = HidKbd_GetParameter(id, type, uuid, &len, pData);
-        if (status == SUCCESS)
-        {
-            *pLen = len;
-        }
+        minConnInterval = maxConnInterval = linkBaseConnInterval;
+        slaveLatency = linkBaseSlaveLatency;
+        connTimeout = linkBaseConnTimeout;
     }
-    // Notifications enabled
-    else if (oper == HID_DEV_OPER_ENABLE)
+
+    linkOverrides = overrides;
+
+    if (overrides == 0)
     {
-        if (id == HID_RPT_ID_MOUSE_IN && type == HID_REPORT_TYPE_INPUT)
+        if (GAPRole_ResumeParamNegotiation() != SUCCESS)
         {
-#ifdef USE_HID_MOUSE
-            hidBootMouseEnabled = TRUE;
-#endif // USE_HID_MOUSE
+            GAPRole_SendUpdateParam(minConnInterval, maxConnInterval,
+                                    slaveLatency, connTimeout,
+                                    GAPROLE_NO_ACTION);
         }
+        return;
+    }
+
+    if (overrides & LINK_OVERRIDE_SUSPEND)
+    {
+        minConnInterval = SUSPEND_MIN_CONN_INTERVAL;
+        maxConnInterval = SUSPEND_MAX_CONN_INTERVAL;
+        slaveLatency = SUSPEND_SLAVE_LATENCY;
+        connTimeout = SUSPEND_CONN_TIMEOUT;
     }
-    // Notifications disabled
-    else if (oper == HID_DEV_OPER_DISABLE)
+    else
     {
-        if (id == HID_RPT_ID_MOUSE_IN && type == HID_REPORT_TYPE_INPUT)
+        if (overrides & LINK_OVERRIDE_BATT)
+        {
+            pStep = &pBattPolicy->pSteps[battPolicyStep];
+
+            minConnInterval = pStep->minConnInterval;
+            maxConnInterval = pStep->maxConnInterval;
+            slaveLatency = MIN(slaveLatency,
+                               BattPolicy_maxSlaveLatency(maxConnInterval,
+                                                          connTimeout));
+        }
+
+        if (overrides & LINK_OVERRIDE_DEGRADED)
         {
-#ifdef USE_HID_MOUSE
-            hidBootMouseEnabled = FALSE;
-#endif // USE_HID_MOUSE
+            slaveLatency = DEGRADED_LINK_SLAVE_LATENCY;
         }
     }
 
-    return status;
+    GAPRole_SendUpdateParam(minConnInterval, maxConnInterval, slaveLatency,
+                            connTimeout, GAPROLE_NO_ACTION);
 }
 
 /*********************************************************************
- * @fn      HidGameController_hidEventCB
+ * @fn      HidGameController_applyBattPolicy
  *
- * @brief   HID Dev event callback.
- *
- * @param   evt - event ID.
+ * @brief   Follow the battery level with the scaling policy. On a step
+ *          change the minimum report period, the TX power cap and the
+ *          connection interval are updated. The slave latency is kept,
+ *          limited to what the supervision timeout allows at the new
+ *          interval.
  *
- * @return  HID response code.
+ * @return  none
  */
-static void HidGameController_hidEventCB(uint8_t evt)
+static void HidGameController_applyBattPolicy(void)
 {
-    // Process enter/exit suspend or enter/exit boot mode
-    return;
-}
+    const battPolicyStep_t *pStep;
+    uint8_t level;
+    uint8_t step;
+
+    Batt_GetParameter(BATT_PARAM_LEVEL, &level);
 
+    if ((level == battPolicyLevel) && (battPolicyStep != BATTPOLICY_STEP_NONE))
+    {
+        return;
+    }
+
+    battPolicyLevel = level;
+
+    step = BattPolicy_selectStep(pBattPolicy, level, battPolicyStep);
+    if (step == battPolicyStep)
+    {
+        return;
+    }
+
+    battPolicyStep = step;
+    pStep = &pBattPolicy->pSteps[step];
+
+    Display_print2(dispHandle, 0, 0, "Battery %d%%, policy step %d", level, step);
+
+    PowerGov_setMinSamplePeriod(pStep->samplePeriod);
+    LinkMon_setMaxTxPower(pStep->maxTxPower);
+
+    if (pStep->maxConnInterval != 0)
+    {
+        HidGameController_setLinkOverrides(linkOverrides | LINK_OVERRIDE_BATT);
+    }
+    else if (linkOverrides & LINK_OVERRIDE_BATT)
+    {
+        HidGameController_setLinkOverrides(linkOverrides &
+                                           ~LINK_OVERRIDE_BATT);
+    }
+}
 
 /*********************************************************************
  * @fn      BLE_PowerBank_clockHandler
@@ -1040,13 +2864,12 @@ static void HID_GameController_clockHandler(UArg arg)
  *
  * @return  TRUE or FALSE
  */
-#if 0
 static uint8_t HidGameController_enqueueMsg(uint16_t event, uint8_t state)
 {
     hidGameControllerEvt_t *pMsg;
 
-    // Create dynamic pointer to message.
-    if (pMsg = ICall_malloc(sizeof(hidGameControllerEvt_t)))
+    // Allocate the message from the message pool.
+    if ((pMsg = UTIL_ALLOC_MSG(hidGameControllerEvt_t)))
     {
         pMsg->hdr.event = event;
         pMsg->hdr.state = state;
@@ -1057,7 +2880,6 @@ static uint8_t HidGameController_enqueueMsg(uint16_t event, uint8_t state)
 
     return FALSE;
 }
-#endif
 
 
 /*********************************************************************
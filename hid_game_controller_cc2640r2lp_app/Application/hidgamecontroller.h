@@ -80,7 +80,7 @@ extern "C"
 /*********************************************************************
  * GLOBAL VARIABLES
  */
-extern Clock_Struct periodicClock;
+
 /*
  * Task creation function for the HID Game Controller.
  */
@@ -0,0 +1,554 @@
+/******************************************************************************
+
+ @file       inputtrace.c
+
+ @brief This file contains the Input Trace for the BLE Game Controller. It
+        records the inputs of the report pipeline, the reports it builds
+        and their send outcomes, delta encoded into a RAM ring buffer, and
+        drains the buffer through the diagnostic service. Built with
+        INPUT_TRACE only.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Record the joystick samples, key edges, reports and
+                        send outcomes in a compact binary trace, drained
+                        through the diagnostic service and replayed on the
+                        host simulation (TOOLS/hostsim/trace_replay.c).
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifdef INPUT_TRACE
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include <icall.h>
+#include "util.h"
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "peripheral.h"
+#include "diagservice.h"
+#include "inputtrace.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Longest varint of 32 bits
+#define INPUT_TRACE_VAR_LEN           5
+
+// Longest record: type, time, ID, type, length, mask and the report
+#define INPUT_TRACE_REC_LEN           (4 + 3 * INPUT_TRACE_VAR_LEN + \
+                                       INPUT_TRACE_RPT_LEN)
+
+// Longest LOST record
+#define INPUT_TRACE_LOST_LEN          (2 + INPUT_TRACE_VAR_LEN)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Last report of an ID and type, for the delta encoding
+typedef struct
+{
+    uint8_t id;
+    uint8_t type;
+    uint8_t data[INPUT_TRACE_RPT_LEN];
+} inputTraceRpt_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Ring buffer, the indexes run free and wrap with the buffer size mask
+static uint8_t traceBuf[INPUT_TRACE_BUF_SIZE];
+static uint32_t traceHead;
+static uint32_t traceTail;
+
+// Records lost since the last record written
+static uint32_t traceLost;
+
+// Time of the last record written and of the record being built
+static uint32_t traceLastTick;
+static uint32_t traceRecTick;
+
+// Delta encoding state, as of the last record written
+static uint16_t traceAdc[INPUT_TRACE_NUM_ADC];
+static inputTraceRpt_t traceRpts[INPUT_TRACE_NUM_RPTS];
+static uint8_t traceNumRpts;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8_t InputTrace_putVar(uint8_t *pRec, uint8_t len, uint32_t value);
+static uint8_t InputTrace_header(uint8_t *pRec, uint8_t type);
+static void InputTrace_copyIn(const uint8_t *pRec, uint8_t len);
+static bool InputTrace_commit(const uint8_t *pRec, uint8_t len);
+static uint8_t InputTrace_findRpt(uint8_t id, uint8_t type);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      InputTrace_init
+ *
+ * @brief   Empty the trace and record the start record.
+ *
+ * @return  none
+ */
+void InputTrace_init(void)
+{
+    uint8_t rec[INPUT_TRACE_REC_LEN];
+    uint8_t len = 0;
+    UInt key = Hwi_disable();
+
+    traceHead = 0;
+    traceTail = 0;
+    traceLost = 0;
+    traceNumRpts = 0;
+    memset(traceAdc, 0, sizeof(traceAdc));
+    memset(traceRpts, 0, sizeof(traceRpts));
+
+    traceLastTick = Clock_getTicks();
+    traceRecTick = traceLastTick;
+
+    rec[len++] = INPUT_TRACE_REC_START;
+    rec[len++] = 0;
+    rec[len++] = INPUT_TRACE_VERSION;
+    len = InputTrace_putVar(rec, len, Clock_tickPeriod);
+    len = InputTrace_putVar(rec, len, traceLastTick);
+
+    InputTrace_commit(rec, len);
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      InputTrace_adc
+ *
+ * @brief   Record a joystick sample.
+ *
+ * @param   channel - Board_ADC* channel
+ * @param   value - raw ADC value
+ *
+ * @return  none
+ */
+void InputTrace_adc(uint8_t channel, uint16_t value)
+{
+    uint8_t rec[INPUT_TRACE_REC_LEN];
+    uint8_t len;
+    int32_t delta;
+    UInt key;
+
+    if (channel >= INPUT_TRACE_NUM_ADC)
+    {
+        return;
+    }
+
+    key = Hwi_disable();
+
+    delta = (int32_t)value - traceAdc[channel];
+
+    len = InputTrace_header(rec, INPUT_TRACE_REC_ADC);
+    rec[len++] = channel;
+    len = InputTrace_putVar(rec, len, ((uint32_t)delta << 1) ^
+                                      (uint32_t)(delta >> 31));
+
+    if (InputTrace_commit(rec, len))
+    {
+        traceAdc[channel] = value;
+    }
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      InputTrace_keys
+ *
+ * @brief   Record the keys read on a key edge.
+ *
+ * @param   keys - KEY_* mask
+ *
+ * @return  none
+ */
+void InputTrace_keys(uint8_t keys)
+{
+    uint8_t rec[INPUT_TRACE_REC_LEN];
+    uint8_t len;
+    UInt key = Hwi_disable();
+
+    len = InputTrace_header(rec, INPUT_TRACE_REC_KEYS);
+    rec[len++] = keys;
+
+    InputTrace_commit(rec, len);
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      InputTrace_report
+ *
+ * @brief   Record a report handed to HidDev.
+ *
+ * @param   id - HID report ID
+ * @param   type - HID report type
+ * @param   len - report length
+ * @param   pData - report
+ *
+ * @return  none
+ */
+void InputTrace_report(uint8_t id, uint8_t type, uint8_t len,
+                       const uint8_t *pData)
+{
+    static const uint8_t zeros[INPUT_TRACE_RPT_LEN];
+    uint8_t rec[INPUT_TRACE_REC_LEN];
+    uint8_t recLen;
+    const uint8_t *pPrev;
+    uint32_t mask = 0;
+    uint8_t slot;
+    uint8_t i;
+    UInt key;
+
+    if (len > INPUT_TRACE_RPT_LEN)
+    {
+        return;
+    }
+
+    key = Hwi_disable();
+
+    // A new report is compared with zeros, its slot is only taken once the
+    // record is written
+    slot = InputTrace_findRpt(id, type);
+    pPrev = (slot < traceNumRpts) ? traceRpts[slot].data : zeros;
+
+    for (i = 0; i < len; i++)
+    {
+        if (pData[i] != pPrev[i])
+        {
+            mask |= (uint32_t)1 << i;
+        }
+    }
+
+    recLen = InputTrace_header(rec, INPUT_TRACE_REC_REPORT);
+    rec[recLen++] = id;
+    rec[recLen++] = type;
+    rec[recLen++] = len;
+    recLen = InputTrace_putVar(rec, recLen, mask);
+
+    for (i = 0; i < len; i++)
+    {
+        if (mask & ((uint32_t)1 << i))
+        {
+            rec[recLen++] = pData[i];
+        }
+    }
+
+    if (InputTrace_commit(rec, recLen))
+    {
+        if (slot >= traceNumRpts)
+        {
+            if (traceNumRpts < INPUT_TRACE_NUM_RPTS)
+            {
+                traceNumRpts++;
+            }
+            slot = traceNumRpts - 1;
+        }
+
+        traceRpts[slot].id = id;
+        traceRpts[slot].type = type;
+        memcpy(traceRpts[slot].data, pData, len);
+        memset(&traceRpts[slot].data[len], 0, INPUT_TRACE_RPT_LEN - len);
+    }
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      InputTrace_sent
+ *
+ * @brief   Record the outcome of a report notification.
+ *
+ * @param   status - GATT_Notification status
+ *
+ * @return  none
+ */
+void InputTrace_sent(uint8_t status)
+{
+    uint8_t rec[INPUT_TRACE_REC_LEN];
+    uint8_t len;
+    UInt key = Hwi_disable();
+
+    len = InputTrace_header(rec, INPUT_TRACE_REC_SENT);
+    rec[len++] = status;
+
+    InputTrace_commit(rec, len);
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      InputTrace_link
+ *
+ * @brief   Record a link state change.
+ *
+ * @param   state - INPUT_TRACE_LINK_*
+ *
+ * @return  none
+ */
+void InputTrace_link(uint8_t state)
+{
+    uint8_t rec[INPUT_TRACE_REC_LEN];
+    uint8_t len;
+    uint16_t connInterval = 0;
+    uint16_t connLatency = 0;
+    uint16_t connTimeout = 0;
+    UInt key;
+
+    if (state == INPUT_TRACE_LINK_UP)
+    {
+        GAPRole_GetParameter(GAPROLE_CONN_INTERVAL, &connInterval);
+        GAPRole_GetParameter(GAPROLE_CONN_LATENCY, &connLatency);
+        GAPRole_GetParameter(GAPROLE_CONN_TIMEOUT, &connTimeout);
+    }
+
+    key = Hwi_disable();
+
+    len = InputTrace_header(rec, INPUT_TRACE_REC_LINK);
+    rec[len++] = state;
+
+    if (state == INPUT_TRACE_LINK_UP)
+    {
+        len = InputTrace_putVar(rec, len, connInterval);
+        len = InputTrace_putVar(rec, len, connLatency);
+        len = InputTrace_putVar(rec, len, connTimeout);
+    }
+
+    InputTrace_commit(rec, len);
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      InputTrace_peek
+ *
+ * @brief   Copy the oldest bytes of the trace without removing them.
+ *
+ * @param   pBuf - output
+ * @param   maxLen - size of pBuf
+ *
+ * @return  Number of bytes copied
+ */
+uint16_t InputTrace_peek(uint8_t *pBuf, uint16_t maxLen)
+{
+    uint16_t len;
+    uint16_t i;
+    UInt key = Hwi_disable();
+
+    len = (uint16_t)MIN(traceHead - traceTail, maxLen);
+
+    for (i = 0; i < len; i++)
+    {
+        pBuf[i] = traceBuf[(traceTail + i) & (INPUT_TRACE_BUF_SIZE - 1)];
+    }
+
+    Hwi_restore(key);
+
+    return len;
+}
+
+/*********************************************************************
+ * @fn      InputTrace_consume
+ *
+ * @brief   Remove the oldest bytes of the trace.
+ *
+ * @param   len - number of bytes
+ *
+ * @return  none
+ */
+void InputTrace_consume(uint16_t len)
+{
+    UInt key = Hwi_disable();
+
+    traceTail += MIN(traceHead - traceTail, len);
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      InputTrace_drain
+ *
+ * @brief   Notify pieces of the trace on the trace diagnostic
+ *          characteristic.
+ *
+ * @return  none
+ */
+void InputTrace_drain(void)
+{
+    uint8_t chunk[DIAG_TRACE_MAX_LEN];
+    uint16_t len;
+    uint8_t i;
+
+    for (i = 0; i < INPUT_TRACE_DRAIN_CHUNKS; i++)
+    {
+        len = InputTrace_peek(chunk, sizeof(chunk));
+
+        // Keep the trace until a client takes it
+        if ((len == 0) ||
+            (Diag_SetParameter(DIAG_PARAM_TRACE, len, chunk) != SUCCESS))
+        {
+            break;
+        }
+
+        InputTrace_consume(len);
+    }
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      InputTrace_putVar
+ *
+ * @brief   Append a varint to a record.
+ *
+ * @param   pRec - record
+ * @param   len - record length
+ * @param   value - number
+ *
+ * @return  New record length
+ */
+static uint8_t InputTrace_putVar(uint8_t *pRec, uint8_t len, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        pRec[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    pRec[len++] = (uint8_t)value;
+
+    return len;
+}
+
+/*********************************************************************
+ * @fn      InputTrace_header
+ *
+ * @brief   Start a record with its type and time. Called with the
+ *          interrupts disabled.
+ *
+ * @param   pRec - record
+ * @param   type - INPUT_TRACE_REC_*
+ *
+ * @return  Record length
+ */
+static uint8_t InputTrace_header(uint8_t *pRec, uint8_t type)
+{
+    traceRecTick = Clock_getTicks();
+
+    pRec[0] = type;
+
+    return InputTrace_putVar(pRec, 1, traceRecTick - traceLastTick);
+}
+
+/*********************************************************************
+ * @fn      InputTrace_copyIn
+ *
+ * @brief   Copy bytes into the ring buffer, the room was checked.
+ *
+ * @param   pRec - bytes
+ * @param   len - number of bytes
+ *
+ * @return  none
+ */
+static void InputTrace_copyIn(const uint8_t *pRec, uint8_t len)
+{
+    uint8_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        traceBuf[(traceHead + i) & (INPUT_TRACE_BUF_SIZE - 1)] = pRec[i];
+    }
+
+    traceHead += len;
+}
+
+/*********************************************************************
+ * @fn      InputTrace_commit
+ *
+ * @brief   Write a record, after a LOST record when records were lost,
+ *          or count it lost when the buffer has no room for them. Called
+ *          with the interrupts disabled.
+ *
+ * @param   pRec - record
+ * @param   len - record length
+ *
+ * @return  TRUE when the record was written
+ */
+static bool InputTrace_commit(const uint8_t *pRec, uint8_t len)
+{
+    uint8_t lost[INPUT_TRACE_LOST_LEN];
+    uint8_t lostLen = 0;
+
+    if (traceLost > 0)
+    {
+        lost[lostLen++] = INPUT_TRACE_REC_LOST;
+        lost[lostLen++] = 0;
+        lostLen = InputTrace_putVar(lost, lostLen, traceLost);
+    }
+
+    if (INPUT_TRACE_BUF_SIZE - (traceHead - traceTail) < (uint32_t)lostLen + len)
+    {
+        traceLost++;
+
+        return FALSE;
+    }
+
+    InputTrace_copyIn(lost, lostLen);
+    InputTrace_copyIn(pRec, len);
+
+    traceLost = 0;
+    traceLastTick = traceRecTick;
+
+    return TRUE;
+}
+
+/*********************************************************************
+ * @fn      InputTrace_findRpt
+ *
+ * @brief   Find the delta encoding slot of a report.
+ *
+ * @param   id - HID report ID
+ * @param   type - HID report type
+ *
+ * @return  Slot index, traceNumRpts when the report has none
+ */
+static uint8_t InputTrace_findRpt(uint8_t id, uint8_t type)
+{
+    uint8_t i;
+
+    for (i = 0; i < traceNumRpts; i++)
+    {
+        if ((traceRpts[i].id == id) && (traceRpts[i].type == type))
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+#endif // INPUT_TRACE
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,237 @@
+/******************************************************************************
+
+ @file       inputtrace.h
+
+ @brief This file contains the Input Trace definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Record the joystick samples, key edges, reports and
+                        send outcomes in a compact binary trace, drained
+                        through the diagnostic service and replayed on the
+                        host simulation (TOOLS/hostsim/trace_replay.c).
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef INPUTTRACE_H
+#define INPUTTRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+#include "hidreportmap.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Trace buffer size in bytes, a power of 2
+#ifndef INPUT_TRACE_BUF_SIZE
+#define INPUT_TRACE_BUF_SIZE          1024
+#endif
+
+// Drain period in milliseconds and trace characteristic notifications sent
+// per period, at most DIAG_TRACE_MAX_LEN bytes each
+#define INPUT_TRACE_DRAIN_PERIOD      100
+#define INPUT_TRACE_DRAIN_CHUNKS      4
+
+// Trace format version, in the start record
+#define INPUT_TRACE_VERSION           1
+
+// ADC channels traced, Board_ADC* below it
+#define INPUT_TRACE_NUM_ADC           8
+
+// Reports whose last value is kept for the delta encoding
+#define INPUT_TRACE_NUM_RPTS          4
+
+// Longest report traced, a report has a changed byte mask of 32 bits
+#define INPUT_TRACE_RPT_LEN           HID_RPT_MAX_IN_LEN
+
+// Trace format. Every record is its type, the time since the previous
+// record in Clock ticks and a payload. Multi-byte numbers are varints:
+// 7 bits per byte, least significant first, bit 7 set when more follow.
+// Signed numbers are zigzag encoded, 0, -1, 1, -2... as 0, 1, 2, 3...
+//
+//   START   version, Clock tick period in us, Clock ticks since boot;
+//           resets the delta state below
+//   ADC     channel, value minus the previous value of the channel (signed)
+//   KEYS    KEY_* mask read by the key interrupt
+//   REPORT  ID, type, length, changed byte mask, the changed bytes; bit n
+//           of the mask is set when byte n differs from the previous report
+//           of the same ID and type, or from 0 for the first one
+//   SENT    status of the notification of the last report
+//   LINK    INPUT_TRACE_LINK_*; UP adds the interval, latency and timeout
+//   LOST    number of records lost on a full buffer before this one, its
+//           time is that of the previous record
+//
+// The report slots for the delta encoding are taken in the order the reports
+// come, the last slot is reused once they are all taken.
+#define INPUT_TRACE_REC_START         0x01
+#define INPUT_TRACE_REC_ADC           0x02
+#define INPUT_TRACE_REC_KEYS          0x03
+#define INPUT_TRACE_REC_REPORT        0x04
+#define INPUT_TRACE_REC_SENT          0x05
+#define INPUT_TRACE_REC_LINK          0x06
+#define INPUT_TRACE_REC_LOST          0x07
+
+// Link states of the LINK record
+#define INPUT_TRACE_LINK_DOWN         0
+#define INPUT_TRACE_LINK_UP           1
+#define INPUT_TRACE_LINK_SECURE       2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Trace points, nothing is compiled in without INPUT_TRACE
+#ifdef INPUT_TRACE
+#define INPUT_TRACE_ADC(channel, value)   InputTrace_adc((channel), (value))
+#define INPUT_TRACE_KEYS(keys)            InputTrace_keys(keys)
+#define INPUT_TRACE_REPORT(id, type, len, pData) \
+    InputTrace_report((id), (type), (len), (pData))
+#define INPUT_TRACE_SENT(status)          InputTrace_sent(status)
+#define INPUT_TRACE_LINK(state)           InputTrace_link(state)
+#else
+#define INPUT_TRACE_ADC(channel, value)
+#define INPUT_TRACE_KEYS(keys)
+#define INPUT_TRACE_REPORT(id, type, len, pData)
+#define INPUT_TRACE_SENT(status)
+#define INPUT_TRACE_LINK(state)
+#endif // INPUT_TRACE
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      InputTrace_init
+ *
+ * @brief   Empty the trace and record the start record.
+ *
+ * @return  none
+ */
+void InputTrace_init(void);
+
+/*********************************************************************
+ * @fn      InputTrace_adc
+ *
+ * @brief   Record a joystick sample.
+ *
+ * @param   channel - Board_ADC* channel
+ * @param   value - raw ADC value
+ *
+ * @return  none
+ */
+void InputTrace_adc(uint8_t channel, uint16_t value);
+
+/*********************************************************************
+ * @fn      InputTrace_keys
+ *
+ * @brief   Record the keys read on a key edge. Safe to call from the
+ *          key interrupt.
+ *
+ * @param   keys - KEY_* mask
+ *
+ * @return  none
+ */
+void InputTrace_keys(uint8_t keys);
+
+/*********************************************************************
+ * @fn      InputTrace_report
+ *
+ * @brief   Record a report handed to HidDev.
+ *
+ * @param   id - HID report ID
+ * @param   type - HID report type
+ * @param   len - report length, reports over INPUT_TRACE_RPT_LEN are
+ *                not recorded
+ * @param   pData - report
+ *
+ * @return  none
+ */
+void InputTrace_report(uint8_t id, uint8_t type, uint8_t len,
+                       const uint8_t *pData);
+
+/*********************************************************************
+ * @fn      InputTrace_sent
+ *
+ * @brief   Record the outcome of a report notification.
+ *
+ * @param   status - GATT_Notification status
+ *
+ * @return  none
+ */
+void InputTrace_sent(uint8_t status);
+
+/*********************************************************************
+ * @fn      InputTrace_link
+ *
+ * @brief   Record a link state change.
+ *
+ * @param   state - INPUT_TRACE_LINK_*
+ *
+ * @return  none
+ */
+void InputTrace_link(uint8_t state);
+
+/*********************************************************************
+ * @fn      InputTrace_peek
+ *
+ * @brief   Copy the oldest bytes of the trace without removing them.
+ *
+ * @param   pBuf - output
+ * @param   maxLen - size of pBuf
+ *
+ * @return  Number of bytes copied
+ */
+uint16_t InputTrace_peek(uint8_t *pBuf, uint16_t maxLen);
+
+/*********************************************************************
+ * @fn      InputTrace_consume
+ *
+ * @brief   Remove the oldest bytes of the trace, after InputTrace_peek.
+ *
+ * @param   len - number of bytes
+ *
+ * @return  none
+ */
+void InputTrace_consume(uint16_t len);
+
+/*********************************************************************
+ * @fn      InputTrace_drain
+ *
+ * @brief   Notify up to INPUT_TRACE_DRAIN_CHUNKS pieces of the trace on
+ *          the trace diagnostic characteristic. The trace is kept while
+ *          no client takes the notifications. Call it every
+ *          INPUT_TRACE_DRAIN_PERIOD ms from the application task.
+ *
+ * @return  none
+ */
+void InputTrace_drain(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INPUTTRACE_H */
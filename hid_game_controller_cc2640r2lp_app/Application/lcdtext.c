@@ -0,0 +1,916 @@
+/******************************************************************************
+
+ @file       lcdtext.c
+
+ @brief This file contains the LCD Text Display for the BLE Game Controller.
+        A full frame buffer of the 128x128 LCD of the BoosterPack MKII
+        takes 32 kB, more than the RAM of the device, so the screen is
+        kept as text cells: a glyph and a color in one byte per cell.
+        Writes mark the cells that change, and a frame draws one window
+        per changed row, from its first to its last changed cell.
+
+        Pixels are rendered a line at a time into one of two line buffers
+        while the SPI DMA sends the other one. Every SPI completion wakes
+        the application task for the next slice, so a slice is one
+        transfer start and one line of rendering, and the task is free for
+        the input reports in between.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Text cell frame buffer for the 128x128 LCD of the
+                        BoosterPack MKII, drawn in dirty row spans over SPI
+                        DMA in short slices of the application task.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include <ti/sysbios/knl/Clock.h>
+#include <xdc/runtime/Timestamp.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/SPI.h>
+
+#include <icall.h>
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "util.h"
+#include "Board.h"
+#include "profprobe.h"
+#include "lcdtext.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Panel size, and the place of the panel in the ST7735S memory with the
+// orientation of LCDTEXT_MADCTL
+#define LCDTEXT_WIDTH                     128
+#define LCDTEXT_HEIGHT                    128
+#define LCDTEXT_X_OFFSET                  2
+#define LCDTEXT_Y_OFFSET                  3
+
+// Cell size and the left edge of the text, centered
+#define LCDTEXT_CELL_W                    6
+#define LCDTEXT_CELL_H                    8
+#define LCDTEXT_TEXT_X                    ((LCDTEXT_WIDTH - LCDTEXT_COLS * \
+                                            LCDTEXT_CELL_W) / 2)
+
+// Glyphs: 0x20 to 0x5F, 5 columns of 7 pixels, bit 0 at the top
+#define LCDTEXT_FIRST_CHAR                0x20
+#define LCDTEXT_NUM_GLYPHS                64
+#define LCDTEXT_GLYPH_W                   5
+
+// Cell byte: glyph in bits 5:0, color in bits 7:6
+#define LCDTEXT_GLYPH_MASK                0x3F
+#define LCDTEXT_COLOR_SHIFT               6
+
+// All columns of a row
+#define LCDTEXT_ROW_MASK                  ((1UL << LCDTEXT_COLS) - 1)
+
+// SPI clock, the ST7735S takes 66 ns write cycles
+#define LCDTEXT_SPI_BIT_RATE              12000000
+
+// ST7735S commands
+#define LCDTEXT_CMD_SWRESET               0x01
+#define LCDTEXT_CMD_SLPOUT                0x11
+#define LCDTEXT_CMD_NORON                 0x13
+#define LCDTEXT_CMD_INVOFF                0x20
+#define LCDTEXT_CMD_DISPON                0x29
+#define LCDTEXT_CMD_CASET                 0x2A
+#define LCDTEXT_CMD_RASET                 0x2B
+#define LCDTEXT_CMD_RAMWR                 0x2C
+#define LCDTEXT_CMD_MADCTL                0x36
+#define LCDTEXT_CMD_COLMOD                0x3A
+
+// Row and column order of the BoosterPack, and 16-bit pixels
+#define LCDTEXT_MADCTL                    0xC8
+#define LCDTEXT_COLMOD_16BIT              0x05
+
+// Reset pulse and time from reset to the first command, in ms
+#define LCDTEXT_RESET_PULSE               1
+#define LCDTEXT_RESET_TIME                120
+
+// Levels of the data/command pin
+#define LCDTEXT_DC_CMD                    0
+#define LCDTEXT_DC_DATA                   1
+
+// Steps of a window: CASET and its arguments, RASET and its arguments,
+// RAMWR, then the pixel lines
+#define LCDTEXT_WIN_STEPS                 5
+
+// Steps of an init command: the command, its argument, the delay
+#define LCDTEXT_CMD_STEP_CMD              0
+#define LCDTEXT_CMD_STEP_ARG              1
+#define LCDTEXT_CMD_STEP_DONE             2
+
+// Driver states
+#define LCDTEXT_STATE_CLOSED              0   // No SPI, nothing is drawn
+#define LCDTEXT_STATE_INIT                1   // Setting up the controller
+#define LCDTEXT_STATE_IDLE                2   // No frame in progress
+#define LCDTEXT_STATE_DRAW                3   // Drawing the changed rows
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Init command with up to one argument, and the time to wait after it
+typedef struct
+{
+    uint8_t cmd;
+    uint8_t argLen;
+    uint8_t arg;
+    uint8_t delay;          // ms
+} lcdTextInitCmd_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Controller set up after the hardware reset. The external flash shares
+// the bus and its select is held low, see board_key.c: it stays powered
+// down as the first byte it sees is not its wake command.
+static const lcdTextInitCmd_t lcdTextInitScript[] =
+{
+    { LCDTEXT_CMD_SWRESET, 0, 0,                    150 },
+    { LCDTEXT_CMD_SLPOUT,  0, 0,                    120 },
+    { LCDTEXT_CMD_COLMOD,  1, LCDTEXT_COLMOD_16BIT, 10 },
+    { LCDTEXT_CMD_MADCTL,  1, LCDTEXT_MADCTL,       0 },
+    { LCDTEXT_CMD_INVOFF,  0, 0,                    0 },
+    { LCDTEXT_CMD_NORON,   0, 0,                    10 },
+    { LCDTEXT_CMD_DISPON,  0, 0,                    100 },
+};
+
+// Commands of a window, each but RAMWR followed by its arguments
+static const uint8_t lcdTextWinCmds[] =
+{
+    LCDTEXT_CMD_CASET, LCDTEXT_CMD_RASET, LCDTEXT_CMD_RAMWR
+};
+
+// RGB565 of the colors
+static const uint16_t lcdTextPalette[LCDTEXT_NUM_COLORS] =
+{
+    0xFFFF, 0x07E0, 0xFFE0, 0xF800
+};
+
+// 5x7 font, 0x20 to 0x5F
+static const uint8_t lcdTextFont[LCDTEXT_NUM_GLYPHS][LCDTEXT_GLYPH_W] =
+{
+    { 0x00, 0x00, 0x00, 0x00, 0x00 },   // ' '
+    { 0x00, 0x00, 0x5F, 0x00, 0x00 },   // !
+    { 0x00, 0x07, 0x00, 0x07, 0x00 },   // "
+    { 0x14, 0x7F, 0x14, 0x7F, 0x14 },   // #
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 },   // $
+    { 0x23, 0x13, 0x08, 0x64, 0x62 },   // %
+    { 0x36, 0x49, 0x56, 0x20, 0x50 },   // &
+    { 0x00, 0x05, 0x03, 0x00, 0x00 },   // '
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 },   // (
+    { 0x00, 0x41, 0x22, 0x1C, 0x00 },   // )
+    { 0x14, 0x08, 0x3E, 0x08, 0x14 },   // *
+    { 0x08, 0x08, 0x3E, 0x08, 0x08 },   // +
+    { 0x00, 0x50, 0x30, 0x00, 0x00 },   // ,
+    { 0x08, 0x08, 0x08, 0x08, 0x08 },   // -
+    { 0x00, 0x60, 0x60, 0x00, 0x00 },   // .
+    { 0x20, 0x10, 0x08, 0x04, 0x02 },   // /
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E },   // 0
+    { 0x00, 0x42, 0x7F, 0x40, 0x00 },   // 1
+    { 0x42, 0x61, 0x51, 0x49, 0x46 },   // 2
+    { 0x21, 0x41, 0x45, 0x4B, 0x31 },   // 3
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 },   // 4
+    { 0x27, 0x45, 0x45, 0x45, 0x39 },   // 5
+    { 0x3C, 0x4A, 0x49, 0x49, 0x30 },   // 6
+    { 0x01, 0x71, 0x09, 0x05, 0x03 },   // 7
+    { 0x36, 0x49, 0x49, 0x49, 0x36 },   // 8
+    { 0x06, 0x49, 0x49, 0x29, 0x1E },   // 9
+    { 0x00, 0x36, 0x36, 0x00, 0x00 },   // :
+    { 0x00, 0x56, 0x36, 0x00, 0x00 },   // ;
+    { 0x08, 0x14, 0x22, 0x41, 0x00 },   // <
+    { 0x14, 0x14, 0x14, 0x14, 0x14 },   // =
+    { 0x00, 0x41, 0x22, 0x14, 0x08 },   // >
+    { 0x02, 0x01, 0x51, 0x09, 0x06 },   // ?
+    { 0x32, 0x49, 0x79, 0x41, 0x3E },   // @
+    { 0x7E, 0x11, 0x11, 0x11, 0x7E },   // A
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 },   // B
+    { 0x3E, 0x41, 0x41, 0x41, 0x22 },   // C
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C },   // D
+    { 0x7F, 0x49, 0x49, 0x49, 0x41 },   // E
+    { 0x7F, 0x09, 0x09, 0x09, 0x01 },   // F
+    { 0x3E, 0x41, 0x49, 0x49, 0x7A },   // G
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F },   // H
+    { 0x00, 0x41, 0x7F, 0x41, 0x00 },   // I
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 },   // J
+    { 0x7F, 0x08, 0x14, 0x22, 0x41 },   // K
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 },   // L
+    { 0x7F, 0x02, 0x0C, 0x02, 0x7F },   // M
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F },   // N
+    { 0x3E, 0x41, 0x41, 0x41, 0x3E },   // O
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 },   // P
+    { 0x3E, 0x41, 0x51, 0x21, 0x5E },   // Q
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 },   // R
+    { 0x46, 0x49, 0x49, 0x49, 0x31 },   // S
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 },   // T
+    { 0x3F, 0x40, 0x40, 0x40, 0x3F },   // U
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F },   // V
+    { 0x3F, 0x40, 0x38, 0x40, 0x3F },   // W
+    { 0x63, 0x14, 0x08, 0x14, 0x63 },   // X
+    { 0x07, 0x08, 0x70, 0x08, 0x07 },   // Y
+    { 0x61, 0x51, 0x49, 0x45, 0x43 },   // Z
+    { 0x00, 0x7F, 0x41, 0x41, 0x00 },   // [
+    { 0x02, 0x04, 0x08, 0x10, 0x20 },   // backslash
+    { 0x00, 0x41, 0x41, 0x7F, 0x00 },   // ]
+    { 0x04, 0x02, 0x01, 0x02, 0x04 },   // ^
+    { 0x40, 0x40, 0x40, 0x40, 0x40 },   // _
+};
+
+static lcdTextWakeCB_t pfnLcdTextWakeCB = NULL;
+
+static PIN_State lcdTextPinState;
+static PIN_Handle lcdTextPins = NULL;
+static SPI_Handle lcdTextSpi = NULL;
+static SPI_Transaction lcdTextTrans;
+
+// Reset and init command delays
+static Clock_Struct lcdTextClock;
+
+static PIN_Config lcdTextPinTable[] =
+{
+    EDUBP_MKII_LCD_CS  | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_PUSHPULL | PIN_DRVSTR_MIN,
+    EDUBP_MKII_LCD_RST | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_PUSHPULL | PIN_DRVSTR_MIN,
+    EDUBP_MKII_LCD_DC  | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_PUSHPULL | PIN_DRVSTR_MIN,
+    PIN_TERMINATE
+};
+
+// Text cells, and the columns of each row changed since they were drawn
+static uint8_t lcdTextCells[LCDTEXT_ROWS][LCDTEXT_COLS];
+static uint32_t lcdTextDirty[LCDTEXT_ROWS];
+
+// Pixel lines, one is rendered while the other is sent
+static uint8_t lcdTextLines[2][LCDTEXT_WIDTH * 2];
+
+static uint8_t lcdTextState = LCDTEXT_STATE_CLOSED;
+
+// TRUE while a transfer or a delay runs, the next slice waits for it
+static volatile uint8_t lcdTextBusy = FALSE;
+
+// Init progress
+static uint8_t lcdTextResetDone;
+static uint8_t lcdTextCmdIdx;
+static uint8_t lcdTextCmdStep;
+
+// Window in progress: its steps, the row or the clear of the whole panel,
+// its columns, and the pixel lines sent
+static uint8_t lcdTextWinStep;
+static uint8_t lcdTextWinClear;
+static uint8_t lcdTextWinRow;
+static uint8_t lcdTextWinCol;
+static uint8_t lcdTextWinCols;
+static uint8_t lcdTextWinLine;
+static uint8_t lcdTextWinLines;
+static uint16_t lcdTextWinBytes;
+static uint8_t lcdTextWinArgs[2][4];
+static uint8_t lcdTextNextRow;
+
+// Frame in progress, in timestamp counts
+static uint32_t lcdTextFrameStart;
+static uint32_t lcdTextFrameCpu;
+static uint16_t lcdTextFrameCells;
+
+static lcdTextStats_t lcdTextStats = { 0 };
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void LcdText_spiCallback(SPI_Handle handle, SPI_Transaction *pTrans);
+static void LcdText_clockHandler(UArg arg);
+static void LcdText_delay(uint32_t ms);
+static void LcdText_send(uint8_t dc, const uint8_t *pBuf, uint16_t len);
+static void LcdText_initStep(void);
+static void LcdText_drawStep(void);
+static void LcdText_startFrame(void);
+static void LcdText_endFrame(void);
+static uint8_t LcdText_nextWindow(void);
+static void LcdText_setWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+static void LcdText_renderLine(uint8_t *pLine, uint8_t y);
+static uint32_t LcdText_us(uint32_t counts);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      LcdText_init
+ *
+ * @brief   Open the LCD pins and SPI and start setting up the controller,
+ *          in slices like the drawing. The screen is cleared. Without the
+ *          SPI nothing is drawn, the text cells are kept all the same.
+ *
+ * @param   pfnWake - called when LcdText_process should run
+ *
+ * @return  none
+ */
+void LcdText_init(lcdTextWakeCB_t pfnWake)
+{
+    SPI_Params params;
+    uint8_t row;
+
+    pfnLcdTextWakeCB = pfnWake;
+
+    // Every cell is drawn once after the clear
+    memset(lcdTextCells, ' ' - LCDTEXT_FIRST_CHAR, sizeof(lcdTextCells));
+    for (row = 0; row < LCDTEXT_ROWS; row++)
+    {
+        lcdTextDirty[row] = LCDTEXT_ROW_MASK;
+    }
+
+    Util_constructClock(&lcdTextClock, LcdText_clockHandler,
+                        LCDTEXT_RESET_PULSE, 0, false, 0);
+
+    // The controller is held in reset from here to the first slice
+    lcdTextPins = PIN_open(&lcdTextPinState, lcdTextPinTable);
+    if (lcdTextPins == NULL)
+    {
+        return;
+    }
+
+    SPI_init();
+    SPI_Params_init(&params);
+    params.bitRate = LCDTEXT_SPI_BIT_RATE;
+    params.transferMode = SPI_MODE_CALLBACK;
+    params.transferCallbackFxn = LcdText_spiCallback;
+
+    lcdTextSpi = SPI_open(EDUBP_MKII_LCD_SPI, &params);
+    if (lcdTextSpi == NULL)
+    {
+        return;
+    }
+
+    lcdTextResetDone = FALSE;
+    lcdTextCmdIdx = 0;
+    lcdTextCmdStep = LCDTEXT_CMD_STEP_CMD;
+    lcdTextState = LCDTEXT_STATE_INIT;
+
+    LcdText_delay(LCDTEXT_RESET_PULSE);
+}
+
+/*********************************************************************
+ * @fn      LcdText_puts
+ *
+ * @brief   Write text to a row. Only the cells that change are marked
+ *          for drawing. Lower case is shown in upper case.
+ *
+ * @param   row - row, 0 to LCDTEXT_ROWS - 1
+ * @param   col - first column
+ * @param   pStr - text, cut at the end of the row
+ * @param   width - cells written, padded with spaces, 0 for the text
+ *                  length
+ * @param   color - LCDTEXT_COLOR_*
+ *
+ * @return  none
+ */
+void LcdText_puts(uint8_t row, uint8_t col, const char *pStr, uint8_t width,
+                  uint8_t color)
+{
+    uint8_t *pCells;
+    uint8_t end;
+    uint8_t cell;
+    uint8_t c;
+
+    if ((row >= LCDTEXT_ROWS) || (col >= LCDTEXT_COLS))
+    {
+        return;
+    }
+
+    if (width == 0)
+    {
+        width = (uint8_t)strlen(pStr);
+    }
+
+    end = ((uint16_t)col + width > LCDTEXT_COLS) ? LCDTEXT_COLS : col + width;
+    pCells = lcdTextCells[row];
+
+    for (; col < end; col++)
+    {
+        c = (*pStr != '\0') ? (uint8_t)*pStr++ : ' ';
+
+        if ((c >= 'a') && (c <= 'z'))
+        {
+            c -= 'a' - 'A';
+        }
+
+        if ((c < LCDTEXT_FIRST_CHAR) ||
+            (c >= LCDTEXT_FIRST_CHAR + LCDTEXT_NUM_GLYPHS))
+        {
+            c = '?';
+        }
+
+        cell = (uint8_t)(((c - LCDTEXT_FIRST_CHAR) & LCDTEXT_GLYPH_MASK) |
+                         ((color & 0x03) << LCDTEXT_COLOR_SHIFT));
+
+        if (pCells[col] != cell)
+        {
+            pCells[col] = cell;
+            lcdTextDirty[row] |= 1UL << col;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      LcdText_flush
+ *
+ * @brief   Start drawing the changed cells. Cells written while a frame is
+ *          drawn go with the next frame. While the controller is set up
+ *          the first frame takes all the changes.
+ *
+ * @return  FALSE when a frame is in progress, call again after it
+ */
+uint8_t LcdText_flush(void)
+{
+    uint8_t row;
+
+    if (lcdTextState == LCDTEXT_STATE_DRAW)
+    {
+        return FALSE;
+    }
+
+    if (lcdTextState != LCDTEXT_STATE_IDLE)
+    {
+        return TRUE;
+    }
+
+    for (row = 0; row < LCDTEXT_ROWS; row++)
+    {
+        if (lcdTextDirty[row])
+        {
+            lcdTextWinClear = FALSE;
+            LcdText_startFrame();
+            pfnLcdTextWakeCB();
+            break;
+        }
+    }
+
+    return TRUE;
+}
+
+/*********************************************************************
+ * @fn      LcdText_process
+ *
+ * @brief   Run one slice: start the next transfer and prepare the pixels
+ *          of the one after it while the DMA sends.
+ *
+ * @return  none
+ */
+void LcdText_process(void)
+{
+    uint32_t start;
+
+    if (lcdTextBusy || ((lcdTextState != LCDTEXT_STATE_INIT) &&
+                        (lcdTextState != LCDTEXT_STATE_DRAW)))
+    {
+        return;
+    }
+
+    PROF_ENTER(LCD_SLICE);
+    start = Timestamp_get32();
+
+    if (lcdTextState == LCDTEXT_STATE_INIT)
+    {
+        LcdText_initStep();
+    }
+    else
+    {
+        LcdText_drawStep();
+    }
+
+    lcdTextFrameCpu += Timestamp_get32() - start;
+    PROF_EXIT(LCD_SLICE);
+}
+
+/*********************************************************************
+ * @fn      LcdText_getStats
+ *
+ * @brief   Get the drawing statistics.
+ *
+ * @param   pStats - statistics are copied here
+ *
+ * @return  none
+ */
+void LcdText_getStats(lcdTextStats_t *pStats)
+{
+    *pStats = lcdTextStats;
+}
+
+/*********************************************************************
+ * @fn      LcdText_spiCallback
+ *
+ * @brief   SPI transfer done, in the SPI driver context.
+ *
+ * @param   handle - SPI
+ * @param   pTrans - transfer
+ *
+ * @return  none
+ */
+static void LcdText_spiCallback(SPI_Handle handle, SPI_Transaction *pTrans)
+{
+    lcdTextBusy = FALSE;
+    pfnLcdTextWakeCB();
+}
+
+/*********************************************************************
+ * @fn      LcdText_clockHandler
+ *
+ * @brief   Delay over, in the clock context.
+ *
+ * @param   arg - ignored
+ *
+ * @return  none
+ */
+static void LcdText_clockHandler(UArg arg)
+{
+    lcdTextBusy = FALSE;
+    pfnLcdTextWakeCB();
+}
+
+/*********************************************************************
+ * @fn      LcdText_delay
+ *
+ * @brief   Hold the next slice back for a time.
+ *
+ * @param   ms - delay in ms
+ *
+ * @return  none
+ */
+static void LcdText_delay(uint32_t ms)
+{
+    lcdTextBusy = TRUE;
+    Util_restartClock(&lcdTextClock, ms);
+}
+
+/*********************************************************************
+ * @fn      LcdText_send
+ *
+ * @brief   Start a transfer. A transfer the driver refuses ends the frame,
+ *          the rows not drawn stay marked for the next one.
+ *
+ * @param   dc - LCDTEXT_DC_CMD or LCDTEXT_DC_DATA
+ * @param   pBuf - bytes, kept until the transfer is done
+ * @param   len - number of bytes
+ *
+ * @return  none
+ */
+static void LcdText_send(uint8_t dc, const uint8_t *pBuf, uint16_t len)
+{
+    PIN_setOutputValue(lcdTextPins, EDUBP_MKII_LCD_DC, dc);
+
+    lcdTextTrans.count = len;
+    lcdTextTrans.txBuf = (void *)pBuf;
+    lcdTextTrans.rxBuf = NULL;
+
+    // The callback can run before the transfer call returns
+    lcdTextBusy = TRUE;
+
+    if (!SPI_transfer(lcdTextSpi, &lcdTextTrans))
+    {
+        lcdTextBusy = FALSE;
+
+        if (lcdTextState == LCDTEXT_STATE_DRAW)
+        {
+            if (!lcdTextWinClear)
+            {
+                lcdTextDirty[lcdTextWinRow] |= ((1UL << lcdTextWinCols) - 1) <<
+                                               lcdTextWinCol;
+            }
+
+            LcdText_endFrame();
+        }
+        else
+        {
+            // The controller is not set up, give up on it
+            lcdTextState = LCDTEXT_STATE_CLOSED;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      LcdText_initStep
+ *
+ * @brief   Next step of the controller set up: release the reset, send a
+ *          command or its argument, or wait after it. The panel is cleared
+ *          at the end.
+ *
+ * @return  none
+ */
+static void LcdText_initStep(void)
+{
+    const lcdTextInitCmd_t *pCmd;
+
+    if (!lcdTextResetDone)
+    {
+        PIN_setOutputValue(lcdTextPins, EDUBP_MKII_LCD_RST, 1);
+        lcdTextResetDone = TRUE;
+        LcdText_delay(LCDTEXT_RESET_TIME);
+
+        return;
+    }
+
+    while (lcdTextCmdIdx < sizeof(lcdTextInitScript) /
+                           sizeof(lcdTextInitScript[0]))
+    {
+        pCmd = &lcdTextInitScript[lcdTextCmdIdx];
+
+        switch (lcdTextCmdStep)
+        {
+            case LCDTEXT_CMD_STEP_CMD:
+                lcdTextCmdStep = (pCmd->argLen != 0) ?
+                                 LCDTEXT_CMD_STEP_ARG : LCDTEXT_CMD_STEP_DONE;
+                LcdText_send(LCDTEXT_DC_CMD, &pCmd->cmd, 1);
+                return;
+
+            case LCDTEXT_CMD_STEP_ARG:
+                lcdTextCmdStep = LCDTEXT_CMD_STEP_DONE;
+                LcdText_send(LCDTEXT_DC_DATA, &pCmd->arg, 1);
+                return;
+
+            default:
+                lcdTextCmdStep = LCDTEXT_CMD_STEP_CMD;
+                lcdTextCmdIdx++;
+
+                if (pCmd->delay != 0)
+                {
+                    LcdText_delay(pCmd->delay);
+                    return;
+                }
+                break;
+        }
+    }
+
+    // The panel memory holds noise from power up
+    lcdTextWinClear = TRUE;
+    LcdText_startFrame();
+    LcdText_drawStep();
+}
+
+/*********************************************************************
+ * @fn      LcdText_drawStep
+ *
+ * @brief   Next step of the frame: a window command or argument, or a
+ *          pixel line, rendering the line after it meanwhile. At the end
+ *          of a window the next one starts in the same slice.
+ *
+ * @return  none
+ */
+static void LcdText_drawStep(void)
+{
+    uint8_t *pLine;
+
+    if (lcdTextWinStep < LCDTEXT_WIN_STEPS)
+    {
+        if (lcdTextWinStep & 1)
+        {
+            LcdText_send(LCDTEXT_DC_DATA, lcdTextWinArgs[lcdTextWinStep >> 1],
+                         sizeof(lcdTextWinArgs[0]));
+        }
+        else
+        {
+            LcdText_send(LCDTEXT_DC_CMD, &lcdTextWinCmds[lcdTextWinStep >> 1],
+                         1);
+        }
+
+        // The first line is ready when RAMWR is done
+        if ((++lcdTextWinStep == LCDTEXT_WIN_STEPS) && !lcdTextWinClear)
+        {
+            LcdText_renderLine(lcdTextLines[0], 0);
+        }
+
+        return;
+    }
+
+    if (lcdTextWinLine < lcdTextWinLines)
+    {
+        pLine = lcdTextLines[lcdTextWinLine & 1];
+        LcdText_send(LCDTEXT_DC_DATA, pLine, lcdTextWinBytes);
+
+        if ((++lcdTextWinLine < lcdTextWinLines) && !lcdTextWinClear)
+        {
+            LcdText_renderLine(lcdTextLines[lcdTextWinLine & 1],
+                               lcdTextWinLine);
+        }
+
+        return;
+    }
+
+    if (LcdText_nextWindow())
+    {
+        LcdText_drawStep();
+    }
+    else
+    {
+        LcdText_endFrame();
+    }
+}
+
+/*********************************************************************
+ * @fn      LcdText_startFrame
+ *
+ * @brief   Start a frame with the clear of the panel or the first changed
+ *          row.
+ *
+ * @return  none
+ */
+static void LcdText_startFrame(void)
+{
+    lcdTextState = LCDTEXT_STATE_DRAW;
+    lcdTextFrameStart = Timestamp_get32();
+    lcdTextFrameCpu = 0;
+    lcdTextFrameCells = 0;
+    lcdTextNextRow = 0;
+
+    if (lcdTextWinClear)
+    {
+        memset(lcdTextLines, 0, sizeof(lcdTextLines));
+        LcdText_setWindow(0, 0, LCDTEXT_WIDTH - 1, LCDTEXT_HEIGHT - 1);
+        lcdTextWinLines = LCDTEXT_HEIGHT;
+        lcdTextWinBytes = LCDTEXT_WIDTH * 2;
+    }
+    else
+    {
+        LcdText_nextWindow();
+    }
+}
+
+/*********************************************************************
+ * @fn      LcdText_endFrame
+ *
+ * @brief   Frame done, update the statistics.
+ *
+ * @return  none
+ */
+static void LcdText_endFrame(void)
+{
+    lcdTextState = LCDTEXT_STATE_IDLE;
+    lcdTextWinClear = FALSE;
+
+    lcdTextStats.frames++;
+    lcdTextStats.lastCpuUs = LcdText_us(lcdTextFrameCpu);
+    lcdTextStats.lastFrameUs = LcdText_us(Timestamp_get32() -
+                                          lcdTextFrameStart);
+    lcdTextStats.lastCells = lcdTextFrameCells;
+
+    if (lcdTextStats.lastCpuUs > lcdTextStats.maxCpuUs)
+    {
+        lcdTextStats.maxCpuUs = lcdTextStats.lastCpuUs;
+    }
+}
+
+/*********************************************************************
+ * @fn      LcdText_nextWindow
+ *
+ * @brief   Set up the window of the next changed row: its first to its
+ *          last changed cell. The row is marked drawn, cells written from
+ *          here on mark it again.
+ *
+ * @return  TRUE if there is a changed row left in the frame
+ */
+static uint8_t LcdText_nextWindow(void)
+{
+    uint32_t dirty;
+    uint8_t first;
+    uint8_t last;
+    uint8_t x;
+    uint8_t y;
+
+    // After the clear every row is drawn
+    lcdTextWinClear = FALSE;
+
+    for (; lcdTextNextRow < LCDTEXT_ROWS; lcdTextNextRow++)
+    {
+        dirty = lcdTextDirty[lcdTextNextRow];
+        if (dirty == 0)
+        {
+            continue;
+        }
+
+        for (first = 0; !(dirty & (1UL << first)); first++)
+        {
+        }
+
+        for (last = LCDTEXT_COLS - 1; !(dirty & (1UL << last)); last--)
+        {
+        }
+
+        lcdTextDirty[lcdTextNextRow] = 0;
+        lcdTextWinRow = lcdTextNextRow++;
+        lcdTextWinCol = first;
+        lcdTextWinCols = last - first + 1;
+        lcdTextWinLines = LCDTEXT_CELL_H;
+        lcdTextWinBytes = lcdTextWinCols * LCDTEXT_CELL_W * 2;
+        lcdTextFrameCells += lcdTextWinCols;
+
+        x = LCDTEXT_TEXT_X + first * LCDTEXT_CELL_W;
+        y = lcdTextWinRow * LCDTEXT_CELL_H;
+        LcdText_setWindow(x, y, x + lcdTextWinCols * LCDTEXT_CELL_W - 1,
+                          y + LCDTEXT_CELL_H - 1);
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*********************************************************************
+ * @fn      LcdText_setWindow
+ *
+ * @brief   Set the CASET and RASET arguments of a window, in panel
+ *          pixels, and start its steps.
+ *
+ * @param   x0 - left column
+ * @param   y0 - top row
+ * @param   x1 - right column
+ * @param   y1 - bottom row
+ *
+ * @return  none
+ */
+static void LcdText_setWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
+{
+    lcdTextWinArgs[0][0] = 0;
+    lcdTextWinArgs[0][1] = x0 + LCDTEXT_X_OFFSET;
+    lcdTextWinArgs[0][2] = 0;
+    lcdTextWinArgs[0][3] = x1 + LCDTEXT_X_OFFSET;
+    lcdTextWinArgs[1][0] = 0;
+    lcdTextWinArgs[1][1] = y0 + LCDTEXT_Y_OFFSET;
+    lcdTextWinArgs[1][2] = 0;
+    lcdTextWinArgs[1][3] = y1 + LCDTEXT_Y_OFFSET;
+
+    lcdTextWinStep = 0;
+    lcdTextWinLine = 0;
+}
+
+/*********************************************************************
+ * @fn      LcdText_renderLine
+ *
+ * @brief   Render a pixel line of the window row, big endian RGB565.
+ *
+ * @param   pLine - line buffer
+ * @param   y - line in the cell, 0 at the top
+ *
+ * @return  none
+ */
+static void LcdText_renderLine(uint8_t *pLine, uint8_t y)
+{
+    const uint8_t *pCells = &lcdTextCells[lcdTextWinRow][lcdTextWinCol];
+    const uint8_t *pGlyph;
+    uint16_t fg;
+    uint8_t col;
+    uint8_t x;
+    uint8_t bits;
+
+    for (col = 0; col < lcdTextWinCols; col++)
+    {
+        pGlyph = lcdTextFont[pCells[col] & LCDTEXT_GLYPH_MASK];
+        fg = lcdTextPalette[pCells[col] >> LCDTEXT_COLOR_SHIFT];
+
+        for (x = 0; x < LCDTEXT_CELL_W; x++)
+        {
+            // The last column and line of a cell are the spacing
+            bits = (x < LCDTEXT_GLYPH_W) ? pGlyph[x] : 0;
+
+            if (bits & (1 << y))
+            {
+                *pLine++ = (uint8_t)(fg >> 8);
+                *pLine++ = (uint8_t)fg;
+            }
+            else
+            {
+                *pLine++ = 0;
+                *pLine++ = 0;
+            }
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      LcdText_us
+ *
+ * @brief   Convert timestamp counts to us.
+ *
+ * @param   counts - timestamp counts
+ *
+ * @return  us
+ */
+static uint32_t LcdText_us(uint32_t counts)
+{
+    Types_FreqHz freq;
+
+    Timestamp_getFreq(&freq);
+
+    return (uint32_t)(((uint64_t)counts * 1000000) / freq.lo);
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,145 @@
+/******************************************************************************
+
+ @file       lcdtext.h
+
+ @brief This file contains the LCD Text Display definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Text cell frame buffer for the 128x128 LCD of the
+                        BoosterPack MKII, drawn in dirty row spans over SPI
+                        DMA in short slices of the application task.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef LCDTEXT_H
+#define LCDTEXT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Text cells, 6x8 pixels each, with a 5x7 font
+#define LCDTEXT_COLS                      21
+#define LCDTEXT_ROWS                      16
+
+// Text colors, on black
+#define LCDTEXT_COLOR_WHITE               0
+#define LCDTEXT_COLOR_GREEN               1
+#define LCDTEXT_COLOR_YELLOW              2
+#define LCDTEXT_COLOR_RED                 3
+#define LCDTEXT_NUM_COLORS                4
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Called from the SPI or clock context when the next slice can run
+typedef void (*lcdTextWakeCB_t)(void);
+
+// Drawing statistics
+typedef struct
+{
+    uint32_t frames;        // Frames drawn
+    uint32_t lastCpuUs;     // Slice time of the last frame, in us
+    uint32_t maxCpuUs;      // Longest slice time of a frame, in us
+    uint32_t lastFrameUs;   // Start to end of the last frame, in us
+    uint16_t lastCells;     // Cells sent in the last frame
+} lcdTextStats_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      LcdText_init
+ *
+ * @brief   Open the LCD pins and SPI and start setting up the controller,
+ *          in slices like the drawing. The screen is cleared. Without the
+ *          SPI nothing is drawn, the text cells are kept all the same.
+ *
+ * @param   pfnWake - called when LcdText_process should run
+ *
+ * @return  none
+ */
+void LcdText_init(lcdTextWakeCB_t pfnWake);
+
+/*********************************************************************
+ * @fn      LcdText_puts
+ *
+ * @brief   Write text to a row. Only the cells that change are marked
+ *          for drawing. Lower case is shown in upper case.
+ *
+ * @param   row - row, 0 to LCDTEXT_ROWS - 1
+ * @param   col - first column
+ * @param   pStr - text, cut at the end of the row
+ * @param   width - cells written, padded with spaces, 0 for the text
+ *                  length
+ * @param   color - LCDTEXT_COLOR_*
+ *
+ * @return  none
+ */
+void LcdText_puts(uint8_t row, uint8_t col, const char *pStr, uint8_t width,
+                  uint8_t color);
+
+/*********************************************************************
+ * @fn      LcdText_flush
+ *
+ * @brief   Start drawing the changed cells. Cells written while a frame is
+ *          drawn go with the next frame. While the controller is set up
+ *          the first frame takes all the changes.
+ *
+ * @return  FALSE when a frame is in progress, call again after it
+ */
+uint8_t LcdText_flush(void);
+
+/*********************************************************************
+ * @fn      LcdText_process
+ *
+ * @brief   Run one slice: start the next transfer and prepare the pixels
+ *          of the one after it while the DMA sends.
+ *
+ * @return  none
+ */
+void LcdText_process(void);
+
+/*********************************************************************
+ * @fn      LcdText_getStats
+ *
+ * @brief   Get the drawing statistics.
+ *
+ * @param   pStats - statistics are copied here
+ *
+ * @return  none
+ */
+void LcdText_getStats(lcdTextStats_t *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LCDTEXT_H */
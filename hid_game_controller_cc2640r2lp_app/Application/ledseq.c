@@ -0,0 +1,360 @@
+/******************************************************************************
+
+ @file       ledseq.c
+
+ @brief This file contains the LED Sequencer for the BLE Game Controller.
+        It plays blink, breathe and player number patterns on the RGB LED
+        of the BoosterPack MKII. Each channel is dimmed by a PWM output of
+        a GPTimer and the pattern is stepped from a clock, so the
+        application task only starts and stops sequences.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : RGB LED patterns on the BoosterPack MKII LED, dimmed
+                        with the GPTimer PWM outputs and stepped from a
+                        clock, without blocking the application task.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/drivers/PWM.h>
+
+#include <icall.h>
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "util.h"
+#include "Board.h"
+#include "ledseq.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// PWM frequency of the channels, in Hz, well above visible flicker
+#define LEDSEQ_PWM_FREQ                   1000
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// PWM output of each channel
+static const uint8_t ledSeqPwmIndex[LEDSEQ_NUM_CHANNELS] =
+{
+    EDUBP_MKII_RLED_PWM, EDUBP_MKII_GLED_PWM, EDUBP_MKII_BLED_PWM
+};
+
+static PWM_Handle ledSeqPwm[LEDSEQ_NUM_CHANNELS];
+
+// Level last set on each channel
+static uint8_t ledSeqDuty[LEDSEQ_NUM_CHANNELS];
+
+// TRUE while the PWM outputs run
+static uint8_t ledSeqRunning = FALSE;
+
+// Sequence in play and the time into its period, in ms
+static ledSeq_t ledSeq;
+static uint16_t ledSeqPhase = 0;
+
+// Step clock
+static Clock_Struct ledSeqClock;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void LedSeq_clockHandler(UArg arg);
+static void LedSeq_step(void);
+static void LedSeq_setLevel(uint8_t level);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      LedSeq_init
+ *
+ * @brief   Open the PWM output of each channel and construct the step
+ *          clock. The LED stays dark.
+ *
+ * @return  none
+ */
+void LedSeq_init(void)
+{
+    PWM_Params params;
+    uint8_t i;
+
+    PWM_init();
+    PWM_Params_init(&params);
+    params.idleLevel = PWM_IDLE_LOW;
+    params.periodUnits = PWM_PERIOD_HZ;
+    params.periodValue = LEDSEQ_PWM_FREQ;
+    params.dutyUnits = PWM_DUTY_FRACTION;
+    params.dutyValue = 0;
+
+    // A channel that does not open stays dark
+    for (i = 0; i < LEDSEQ_NUM_CHANNELS; i++)
+    {
+        ledSeqPwm[i] = PWM_open(ledSeqPwmIndex[i], &params);
+        ledSeqDuty[i] = 0;
+    }
+
+    memset(&ledSeq, 0, sizeof(ledSeq));
+
+    Util_constructClock(&ledSeqClock, LedSeq_clockHandler,
+                        LEDSEQ_STEP_PERIOD, 0, false, 0);
+}
+
+/*********************************************************************
+ * @fn      LedSeq_start
+ *
+ * @brief   Run a sequence from the start of its pattern. The period is
+ *          clamped to the limits, and to fit the flashes of the player
+ *          number.
+ *
+ * @param   pSeq - sequence
+ *
+ * @return  SUCCESS, or INVALIDPARAMETER for an unknown pattern or player
+ */
+uint8_t LedSeq_start(const ledSeq_t *pSeq)
+{
+    uint16_t minPeriod = LEDSEQ_MIN_PERIOD;
+    uint8_t i;
+
+    if ((pSeq->pattern >= LEDSEQ_NUM_PATTERNS) ||
+        ((pSeq->pattern == LEDSEQ_PATTERN_PLAYER) &&
+         ((pSeq->player == 0) || (pSeq->player > LEDSEQ_MAX_PLAYER))))
+    {
+        return INVALIDPARAMETER;
+    }
+
+    // The clock is stopped first, the handler does not run while the
+    // sequence changes
+    Util_stopClock(&ledSeqClock);
+
+    ledSeq = *pSeq;
+    ledSeqPhase = 0;
+
+    // The flashes and a pause as long as two of them
+    if (ledSeq.pattern == LEDSEQ_PATTERN_PLAYER)
+    {
+        minPeriod = (2 * ledSeq.player + 2) * LEDSEQ_FLASH_TIME;
+    }
+
+    if (ledSeq.period < minPeriod)
+    {
+        ledSeq.period = minPeriod;
+    }
+    else if (ledSeq.period > LEDSEQ_MAX_PERIOD)
+    {
+        ledSeq.period = LEDSEQ_MAX_PERIOD;
+    }
+
+    // Dark sequences stop the PWM outputs, the GPTimers can power down
+    for (i = 0; i < LEDSEQ_NUM_CHANNELS; i++)
+    {
+        if (ledSeq.color[i] != 0)
+        {
+            break;
+        }
+    }
+
+    if ((ledSeq.pattern == LEDSEQ_PATTERN_OFF) || (i == LEDSEQ_NUM_CHANNELS))
+    {
+        LedSeq_stop();
+
+        return SUCCESS;
+    }
+
+    if (!ledSeqRunning)
+    {
+        for (i = 0; i < LEDSEQ_NUM_CHANNELS; i++)
+        {
+            if (ledSeqPwm[i] != NULL)
+            {
+                PWM_start(ledSeqPwm[i]);
+            }
+        }
+
+        ledSeqRunning = TRUE;
+    }
+
+    LedSeq_step();
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      LedSeq_stop
+ *
+ * @brief   Turn the LED off and stop the PWM outputs.
+ *
+ * @return  none
+ */
+void LedSeq_stop(void)
+{
+    uint8_t i;
+
+    Util_stopClock(&ledSeqClock);
+
+    ledSeq.pattern = LEDSEQ_PATTERN_OFF;
+    LedSeq_setLevel(0);
+
+    if (ledSeqRunning)
+    {
+        for (i = 0; i < LEDSEQ_NUM_CHANNELS; i++)
+        {
+            if (ledSeqPwm[i] != NULL)
+            {
+                PWM_stop(ledSeqPwm[i]);
+            }
+        }
+
+        ledSeqRunning = FALSE;
+    }
+}
+
+/*********************************************************************
+ * @fn      LedSeq_level
+ *
+ * @brief   Brightness of a sequence at a time of its period.
+ *
+ * @param   pSeq - sequence, with a clamped period
+ * @param   phase - time since the start of the period, in ms
+ * @param   pHold - time the brightness holds, in ms, 0 for ever
+ *
+ * @return  Brightness, 0 to LEDSEQ_LEVEL_MAX
+ */
+uint8_t LedSeq_level(const ledSeq_t *pSeq, uint16_t phase, uint16_t *pHold)
+{
+    uint16_t half = pSeq->period / 2;
+    uint16_t slot;
+    uint32_t ramp;
+
+    switch (pSeq->pattern)
+    {
+        case LEDSEQ_PATTERN_SOLID:
+            *pHold = 0;
+            return LEDSEQ_LEVEL_MAX;
+
+        case LEDSEQ_PATTERN_BLINK:
+            if (phase < half)
+            {
+                *pHold = half - phase;
+                return LEDSEQ_LEVEL_MAX;
+            }
+
+            *pHold = pSeq->period - phase;
+            return 0;
+
+        case LEDSEQ_PATTERN_BREATHE:
+            // Triangle up and down, squared so the fade looks even
+            ramp = (phase < half) ? phase : (pSeq->period - phase);
+            ramp = (ramp * LEDSEQ_LEVEL_MAX) / half;
+            if (ramp > LEDSEQ_LEVEL_MAX)
+            {
+                ramp = LEDSEQ_LEVEL_MAX;
+            }
+
+            *pHold = pSeq->period - phase;
+            if (*pHold > LEDSEQ_STEP_PERIOD)
+            {
+                *pHold = LEDSEQ_STEP_PERIOD;
+            }
+
+            return (uint8_t)((ramp * ramp) / LEDSEQ_LEVEL_MAX);
+
+        case LEDSEQ_PATTERN_PLAYER:
+            // One flash per player, then dark to the end of the period
+            slot = phase / LEDSEQ_FLASH_TIME;
+
+            if (slot < 2 * pSeq->player)
+            {
+                *pHold = LEDSEQ_FLASH_TIME - (phase % LEDSEQ_FLASH_TIME);
+                return (slot & 1) ? 0 : LEDSEQ_LEVEL_MAX;
+            }
+
+            *pHold = pSeq->period - phase;
+            return 0;
+
+        default:
+            *pHold = 0;
+            return 0;
+    }
+}
+
+/*********************************************************************
+ * @fn      LedSeq_clockHandler
+ *
+ * @brief   Step clock callback, in the clock context.
+ *
+ * @param   arg - ignored
+ *
+ * @return  none
+ */
+static void LedSeq_clockHandler(UArg arg)
+{
+    LedSeq_step();
+}
+
+/*********************************************************************
+ * @fn      LedSeq_step
+ *
+ * @brief   Set the brightness of the current time of the period and wait
+ *          for its next change.
+ *
+ * @return  none
+ */
+static void LedSeq_step(void)
+{
+    uint16_t hold;
+
+    LedSeq_setLevel(LedSeq_level(&ledSeq, ledSeqPhase, &hold));
+
+    // Steady brightness needs no clock
+    if (hold != 0)
+    {
+        ledSeqPhase = (ledSeqPhase + hold) % ledSeq.period;
+        Util_restartClock(&ledSeqClock, hold);
+    }
+}
+
+/*********************************************************************
+ * @fn      LedSeq_setLevel
+ *
+ * @brief   Dim each channel to its color at a brightness. Only channels
+ *          that change are written.
+ *
+ * @param   level - brightness, 0 to LEDSEQ_LEVEL_MAX
+ *
+ * @return  none
+ */
+static void LedSeq_setLevel(uint8_t level)
+{
+    uint8_t duty;
+    uint8_t i;
+
+    for (i = 0; i < LEDSEQ_NUM_CHANNELS; i++)
+    {
+        duty = (uint8_t)(((uint16_t)ledSeq.color[i] * level) /
+                         LEDSEQ_LEVEL_MAX);
+
+        if ((duty != ledSeqDuty[i]) && (ledSeqPwm[i] != NULL))
+        {
+            PWM_setDuty(ledSeqPwm[i],
+                        (uint32_t)(((uint64_t)PWM_DUTY_FRACTION_MAX * duty) /
+                                   LEDSEQ_LEVEL_MAX));
+            ledSeqDuty[i] = duty;
+        }
+    }
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,142 @@
+/******************************************************************************
+
+ @file       ledseq.h
+
+ @brief This file contains the LED Sequencer definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : RGB LED patterns on the BoosterPack MKII LED, dimmed
+                        with the GPTimer PWM outputs and stepped from a
+                        clock, without blocking the application task.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef LEDSEQ_H
+#define LEDSEQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Patterns
+#define LEDSEQ_PATTERN_OFF                0   // Dark
+#define LEDSEQ_PATTERN_SOLID              1   // Steady color
+#define LEDSEQ_PATTERN_BLINK              2   // On half the period
+#define LEDSEQ_PATTERN_BREATHE            3   // Fades in and out each period
+#define LEDSEQ_PATTERN_PLAYER             4   // Player number of flashes
+                                              // each period
+#define LEDSEQ_NUM_PATTERNS               5
+
+// Color channels
+#define LEDSEQ_RED                        0
+#define LEDSEQ_GREEN                      1
+#define LEDSEQ_BLUE                       2
+#define LEDSEQ_NUM_CHANNELS               3
+
+// Full brightness of a channel
+#define LEDSEQ_LEVEL_MAX                  255
+
+// Period limits and default, in ms
+#define LEDSEQ_MIN_PERIOD                 100
+#define LEDSEQ_MAX_PERIOD                 10000
+#define LEDSEQ_DEFAULT_PERIOD             1000
+
+// Breathe step, in ms
+#define LEDSEQ_STEP_PERIOD                20
+
+// Player flash on and off time, in ms, and the highest player number
+#define LEDSEQ_FLASH_TIME                 150
+#define LEDSEQ_MAX_PLAYER                 8
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Sequence
+typedef struct
+{
+    uint8_t  pattern;                       // LEDSEQ_PATTERN_*
+    uint8_t  player;                        // Player number, PLAYER only
+    uint8_t  color[LEDSEQ_NUM_CHANNELS];    // Level of each channel
+    uint16_t period;                        // Pattern period in ms
+} ledSeq_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      LedSeq_init
+ *
+ * @brief   Open the PWM output of each channel and construct the step
+ *          clock. The LED stays dark.
+ *
+ * @return  none
+ */
+void LedSeq_init(void);
+
+/*********************************************************************
+ * @fn      LedSeq_start
+ *
+ * @brief   Run a sequence from the start of its pattern. The period is
+ *          clamped to the limits, and to fit the flashes of the player
+ *          number.
+ *
+ * @param   pSeq - sequence
+ *
+ * @return  SUCCESS, or INVALIDPARAMETER for an unknown pattern or player
+ */
+uint8_t LedSeq_start(const ledSeq_t *pSeq);
+
+/*********************************************************************
+ * @fn      LedSeq_stop
+ *
+ * @brief   Turn the LED off and stop the PWM outputs.
+ *
+ * @return  none
+ */
+void LedSeq_stop(void);
+
+/*********************************************************************
+ * @fn      LedSeq_level
+ *
+ * @brief   Brightness of a sequence at a time of its period.
+ *
+ * @param   pSeq - sequence, with a clamped period
+ * @param   phase - time since the start of the period, in ms
+ * @param   pHold - time the brightness holds, in ms, 0 for ever
+ *
+ * @return  Brightness, 0 to LEDSEQ_LEVEL_MAX
+ */
+uint8_t LedSeq_level(const ledSeq_t *pSeq, uint16_t phase, uint16_t *pHold);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LEDSEQ_H */
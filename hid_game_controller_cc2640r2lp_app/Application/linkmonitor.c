@@ -0,0 +1,604 @@
+/******************************************************************************
+
+ @file       linkmonitor.c
+
+ @brief This file contains the Link Quality Monitor for the BLE Game
+        Controller.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Periodically sample connection RSSI and packet error
+                        counters, keep smoothed statistics and adapt the TX
+                        power to the measured link margin.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include <icall.h>
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "peripheral.h"
+#include "diagservice.h"
+#include "linkmonitor.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Averages are kept in Q4 fixed point and smoothed with a weight of 1/8
+#define LINKMON_FRAC_BITS             4
+#define LINKMON_AVG_SHIFT             3
+
+// Smoothed RSSI (dBm) thresholds for the link quality state
+#define LINKMON_RSSI_MARGINAL         (-75)
+#define LINKMON_RSSI_DEGRADED         (-85)
+
+// RSSI (dBm) the peer should still receive us with after lowering TX power.
+// Assumes a symmetric path and a peer transmitting at 0 dBm.
+#define LINKMON_RSSI_TARGET           (-70)
+
+// Smoothed missed connection events per 1000 events
+#define LINKMON_LOSS_MARGINAL         50
+#define LINKMON_LOSS_DEGRADED         200
+
+// Consecutive better windows needed before the state is upgraded
+#define LINKMON_RECOVER_WINDOWS       3
+
+// Consecutive good windows needed before the TX power is lowered one step
+#define LINKMON_TX_DOWN_WINDOWS       5
+
+// Jump to full TX power once the link has been silent for this fraction
+// (1/n) of the supervision timeout
+#define LINKMON_SILENCE_DIV           4
+
+// Index of the stack default TX power (0 dBm) in txPowerLevels
+#define LINKMON_TX_DEFAULT_IDX        7
+
+// Link quality characteristic layout
+#define LINKMON_STAT_RSSI_LAST        0   // int8, dBm
+#define LINKMON_STAT_RSSI_AVG         1   // int8, dBm
+#define LINKMON_STAT_TX_POWER         2   // int8, dBm
+#define LINKMON_STAT_STATE            3   // LINKMON_STATE_*
+#define LINKMON_STAT_LOSS_AVG         4   // uint16, missed events per 1000
+#define LINKMON_STAT_CRC_AVG          6   // uint16, CRC errors per 1000 packets
+#define LINKMON_STAT_MISSED_TOTAL     8   // uint16, saturating
+#define LINKMON_STAT_CRC_TOTAL        10  // uint16, saturating
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Available TX power steps, from lowest to highest
+static const uint8_t txPowerLevels[] =
+{
+    HCI_EXT_TX_POWER_MINUS_21_DBM,
+    HCI_EXT_TX_POWER_MINUS_18_DBM,
+    HCI_EXT_TX_POWER_MINUS_15_DBM,
+    HCI_EXT_TX_POWER_MINUS_12_DBM,
+    HCI_EXT_TX_POWER_MINUS_9_DBM,
+    HCI_EXT_TX_POWER_MINUS_6_DBM,
+    HCI_EXT_TX_POWER_MINUS_3_DBM,
+    HCI_EXT_TX_POWER_0_DBM,
+    HCI_EXT_TX_POWER_5_DBM
+};
+
+static const int8_t txPowerDbm[] =
+{
+    -21, -18, -15, -12, -9, -6, -3, 0, 5
+};
+
+#define LINKMON_TX_MAX_IDX            (sizeof(txPowerLevels) - 1)
+
+// Application state change callback
+static linkMonStateCB_t pfnLinkMonStateCB = NULL;
+
+// Connection being monitored
+static uint16_t linkMonConnHandle = INVALID_CONNHANDLE;
+
+// Smoothed statistics
+static int8_t rssiLast;
+static int16_t rssiAvg;
+static uint8_t rssiValid;
+static uint16_t lossAvg;
+static uint16_t crcAvg;
+
+// Controller packet error counters at the end of the previous window
+static uint16_t perPkts;
+static uint16_t perCrcErr;
+static uint16_t perEvents;
+static uint16_t perMissed;
+
+static uint16_t totalMissed;
+static uint16_t totalCrcErr;
+
+// Time in ms without a single packet received
+static uint16_t silentTime;
+
+static uint8_t linkState = LINKMON_STATE_GOOD;
+static uint8_t recoverWindows;
+
+static uint8_t txIdx = LINKMON_TX_DEFAULT_IDX;
+static uint8_t txMaxIdx = LINKMON_TX_MAX_IDX;
+static uint8_t txGoodWindows;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void LinkMon_processRssi(uint8_t status, int8_t rssi);
+static void LinkMon_processPer(uint8_t *pParam);
+static void LinkMon_updateState(void);
+static void LinkMon_updateTxPower(void);
+static void LinkMon_setTxPower(uint8_t idx);
+static void LinkMon_publish(void);
+static uint16_t LinkMon_smooth(uint16_t avg, uint16_t sample);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      LinkMon_init
+ *
+ * @brief   Initialize the link quality monitor.
+ *
+ * @param   pfnStateCB - link quality state change callback
+ *
+ * @return  none
+ */
+void LinkMon_init(linkMonStateCB_t pfnStateCB)
+{
+    pfnLinkMonStateCB = pfnStateCB;
+}
+
+/*********************************************************************
+ * @fn      LinkMon_start
+ *
+ * @brief   Start monitoring a new connection.
+ *
+ * @param   connHandle - connection handle to monitor
+ *
+ * @return  none
+ */
+void LinkMon_start(uint16_t connHandle)
+{
+    linkMonConnHandle = connHandle;
+
+    rssiLast = 0;
+    rssiAvg = 0;
+    rssiValid = FALSE;
+    lossAvg = 0;
+    crcAvg = 0;
+
+    perPkts = 0;
+    perCrcErr = 0;
+    perEvents = 0;
+    perMissed = 0;
+
+    totalMissed = 0;
+    totalCrcErr = 0;
+    silentTime = 0;
+
+    linkState = LINKMON_STATE_GOOD;
+    recoverWindows = 0;
+    txGoodWindows = 0;
+
+    HCI_EXT_PacketErrorRateCmd(connHandle, HCI_EXT_PER_RESET);
+
+    LinkMon_setTxPower(LINKMON_TX_DEFAULT_IDX);
+}
+
+/*********************************************************************
+ * @fn      LinkMon_stop
+ *
+ * @brief   Stop monitoring and restore the default TX power.
+ *
+ * @return  none
+ */
+void LinkMon_stop(void)
+{
+    if (linkMonConnHandle == INVALID_CONNHANDLE)
+    {
+        return;
+    }
+
+    linkMonConnHandle = INVALID_CONNHANDLE;
+    linkState = LINKMON_STATE_GOOD;
+
+    // Advertising uses the same TX power setting
+    LinkMon_setTxPower(LINKMON_TX_DEFAULT_IDX);
+}
+
+/*********************************************************************
+ * @fn      LinkMon_poll
+ *
+ * @brief   Issue the RSSI and packet error rate reads for one window.
+ *
+ * @return  none
+ */
+void LinkMon_poll(void)
+{
+    if (linkMonConnHandle == INVALID_CONNHANDLE)
+    {
+        return;
+    }
+
+    // The RSSI result is returned first, the window is evaluated when the
+    // packet error rate result arrives.
+    HCI_ReadRssiCmd(linkMonConnHandle);
+    HCI_EXT_PacketErrorRateCmd(linkMonConnHandle, HCI_EXT_PER_READ);
+}
+
+/*********************************************************************
+ * @fn      LinkMon_processHciEvt
+ *
+ * @brief   Process an HCI_GAP_EVENT_EVENT received by the application.
+ *
+ * @param   pMsg - HCI event message
+ *
+ * @return  TRUE if the event was consumed by the link monitor
+ */
+uint8_t LinkMon_processHciEvt(ICall_Hdr *pMsg)
+{
+    if (pMsg->status == HCI_COMMAND_COMPLETE_EVENT_CODE)
+    {
+        hciEvt_CmdComplete_t *pEvt = (hciEvt_CmdComplete_t *)pMsg;
+
+        if (pEvt->cmdOpcode == HCI_READ_RSSI)
+        {
+            // Status, connection handle (2), RSSI
+            LinkMon_processRssi(pEvt->pReturnParam[0],
+                                (int8_t)pEvt->pReturnParam[3]);
+
+            return TRUE;
+        }
+    }
+    else if (pMsg->status == HCI_VE_EVENT_CODE)
+    {
+        hciEvt_VSCmdComplete_t *pEvt = (hciEvt_VSCmdComplete_t *)pMsg;
+
+        if (pEvt->cmdOpcode == HCI_EXT_PER)
+        {
+            LinkMon_processPer(pEvt->pEventParam);
+
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*********************************************************************
+ * @fn      LinkMon_setMaxTxPower
+ *
+ * @brief   Limit the TX power the monitor may select.
+ *
+ * @param   maxDbm - TX power cap in dBm
+ *
+ * @return  none
+ */
+void LinkMon_setMaxTxPower(int8_t maxDbm)
+{
+    uint8_t idx = LINKMON_TX_MAX_IDX;
+
+    while ((idx > 0) && (txPowerDbm[idx] > maxDbm))
+    {
+        idx--;
+    }
+
+    txMaxIdx = idx;
+
+    if (txIdx > txMaxIdx)
+    {
+        LinkMon_setTxPower(txMaxIdx);
+    }
+}
+
+/*********************************************************************
+ * @fn      LinkMon_getState
+ *
+ * @brief   Get the current link quality state.
+ *
+ * @return  current state
+ */
+uint8_t LinkMon_getState(void)
+{
+    return linkState;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      LinkMon_processRssi
+ *
+ * @brief   Add an RSSI sample to the smoothed RSSI.
+ *
+ * @param   status - HCI status of the read
+ * @param   rssi - RSSI of the last received packet in dBm
+ *
+ * @return  none
+ */
+static void LinkMon_processRssi(uint8_t status, int8_t rssi)
+{
+    int16_t sample = (int16_t)rssi << LINKMON_FRAC_BITS;
+
+    if ((status != SUCCESS) || (linkMonConnHandle == INVALID_CONNHANDLE))
+    {
+        return;
+    }
+
+    rssiLast = rssi;
+
+    if (rssiValid)
+    {
+        rssiAvg += (sample - rssiAvg) / (1 << LINKMON_AVG_SHIFT);
+    }
+    else
+    {
+        rssiAvg = sample;
+        rssiValid = TRUE;
+    }
+}
+
+/*********************************************************************
+ * @fn      LinkMon_processPer
+ *
+ * @brief   Evaluate one sampling window from the packet error rate
+ *          counters.
+ *
+ * @param   pParam - vendor event parameters: event opcode (2), status,
+ *                   PER command, packets (2), CRC errors (2),
+ *                   connection events (2), missed events (2)
+ *
+ * @return  none
+ */
+static void LinkMon_processPer(uint8_t *pParam)
+{
+    uint16_t numPkts, numCrcErr, numEvents, numMissed;
+    uint16_t dPkts, dCrcErr, dEvents, dMissed;
+
+    if ((pParam[2] != SUCCESS) || (pParam[3] != HCI_EXT_PER_READ) ||
+        (linkMonConnHandle == INVALID_CONNHANDLE))
+    {
+        return;
+    }
+
+    numPkts   = BUILD_UINT16(pParam[4], pParam[5]);
+    numCrcErr = BUILD_UINT16(pParam[6], pParam[7]);
+    numEvents = BUILD_UINT16(pParam[8], pParam[9]);
+    numMissed = BUILD_UINT16(pParam[10], pParam[11]);
+
+    // Counters are cumulative since the reset on connection
+    dPkts   = numPkts - perPkts;
+    dCrcErr = numCrcErr - perCrcErr;
+    dEvents = numEvents - perEvents;
+    dMissed = numMissed - perMissed;
+
+    perPkts   = numPkts;
+    perCrcErr = numCrcErr;
+    perEvents = numEvents;
+    perMissed = numMissed;
+
+    totalMissed = (totalMissed > (0xFFFF - dMissed)) ? 0xFFFF : totalMissed + dMissed;
+    totalCrcErr = (totalCrcErr > (0xFFFF - dCrcErr)) ? 0xFFFF : totalCrcErr + dCrcErr;
+
+    if (dEvents != 0)
+    {
+        lossAvg = LinkMon_smooth(lossAvg, (uint32_t)dMissed * 1000 / dEvents);
+
+        if (dMissed == dEvents)
+        {
+            silentTime = (silentTime > (0xFFFF - LINKMON_PERIOD)) ?
+                         0xFFFF : silentTime + LINKMON_PERIOD;
+        }
+        else
+        {
+            silentTime = 0;
+        }
+    }
+
+    if (dPkts != 0)
+    {
+        crcAvg = LinkMon_smooth(crcAvg, (uint32_t)dCrcErr * 1000 / dPkts);
+    }
+
+    LinkMon_updateState();
+    LinkMon_updateTxPower();
+    LinkMon_publish();
+}
+
+/*********************************************************************
+ * @fn      LinkMon_updateState
+ *
+ * @brief   Derive the link quality state from the smoothed statistics.
+ *          Downgrades take effect immediately, upgrades only after
+ *          LINKMON_RECOVER_WINDOWS consecutive better windows.
+ *
+ * @return  none
+ */
+static void LinkMon_updateState(void)
+{
+    int8_t rssi = rssiAvg >> LINKMON_FRAC_BITS;
+    uint16_t loss = lossAvg >> LINKMON_FRAC_BITS;
+    uint8_t newState;
+
+    if ((rssiValid && (rssi < LINKMON_RSSI_DEGRADED)) ||
+        (loss >= LINKMON_LOSS_DEGRADED))
+    {
+        newState = LINKMON_STATE_DEGRADED;
+    }
+    else if ((rssiValid && (rssi < LINKMON_RSSI_MARGINAL)) ||
+             (loss >= LINKMON_LOSS_MARGINAL))
+    {
+        newState = LINKMON_STATE_MARGINAL;
+    }
+    else
+    {
+        newState = LINKMON_STATE_GOOD;
+    }
+
+    if (newState > linkState)
+    {
+        recoverWindows = 0;
+    }
+    else if (newState < linkState)
+    {
+        if (++recoverWindows < LINKMON_RECOVER_WINDOWS)
+        {
+            return;
+        }
+
+        recoverWindows = 0;
+    }
+    else
+    {
+        recoverWindows = 0;
+        return;
+    }
+
+    linkState = newState;
+
+    if (pfnLinkMonStateCB != NULL)
+    {
+        pfnLinkMonStateCB(linkState);
+    }
+}
+
+/*********************************************************************
+ * @fn      LinkMon_updateTxPower
+ *
+ * @brief   Adapt the TX power. The power is raised one step whenever the
+ *          link degrades or the estimated margin at the peer is too small,
+ *          raised to the maximum if the link has been silent for a
+ *          significant part of the supervision timeout, and lowered one
+ *          step at a time while the margin allows it.
+ *
+ * @return  none
+ */
+static void LinkMon_updateTxPower(void)
+{
+    uint16_t connTimeout = 0;
+    int8_t minTxDbm;
+
+    GAPRole_GetParameter(GAPROLE_CONN_TIMEOUT, &connTimeout);
+
+    // Supervision timeout is in units of 10 ms
+    if ((silentTime != 0) &&
+        ((uint32_t)silentTime * LINKMON_SILENCE_DIV >= (uint32_t)connTimeout * 10))
+    {
+        txGoodWindows = 0;
+        LinkMon_setTxPower(txMaxIdx);
+        return;
+    }
+
+    if (!rssiValid)
+    {
+        return;
+    }
+
+    minTxDbm = LINKMON_RSSI_TARGET - (rssiAvg >> LINKMON_FRAC_BITS);
+
+    if ((linkState == LINKMON_STATE_DEGRADED) || (txPowerDbm[txIdx] < minTxDbm))
+    {
+        txGoodWindows = 0;
+
+        if (txIdx < txMaxIdx)
+        {
+            LinkMon_setTxPower(txIdx + 1);
+        }
+    }
+    else if ((linkState == LINKMON_STATE_GOOD) && (txIdx > 0) &&
+             (txPowerDbm[txIdx - 1] >= minTxDbm))
+    {
+        if (++txGoodWindows >= LINKMON_TX_DOWN_WINDOWS)
+        {
+            txGoodWindows = 0;
+            LinkMon_setTxPower(txIdx - 1);
+        }
+    }
+    else
+    {
+        txGoodWindows = 0;
+    }
+}
+
+/*********************************************************************
+ * @fn      LinkMon_setTxPower
+ *
+ * @brief   Set the controller TX power, limited to the cap.
+ *
+ * @param   idx - index in txPowerLevels
+ *
+ * @return  none
+ */
+static void LinkMon_setTxPower(uint8_t idx)
+{
+    if (idx > txMaxIdx)
+    {
+        idx = txMaxIdx;
+    }
+
+    if (HCI_EXT_SetTxPowerCmd(txPowerLevels[idx]) == SUCCESS)
+    {
+        txIdx = idx;
+    }
+}
+
+/*********************************************************************
+ * @fn      LinkMon_publish
+ *
+ * @brief   Update the link quality diagnostic characteristic.
+ *
+ * @return  none
+ */
+static void LinkMon_publish(void)
+{
+    uint8_t stats[DIAG_LINK_QUALITY_LEN];
+    uint16_t loss = lossAvg >> LINKMON_FRAC_BITS;
+    uint16_t crc = crcAvg >> LINKMON_FRAC_BITS;
+
+    stats[LINKMON_STAT_RSSI_LAST] = (uint8_t)rssiLast;
+    stats[LINKMON_STAT_RSSI_AVG] = (uint8_t)(int8_t)(rssiAvg >> LINKMON_FRAC_BITS);
+    stats[LINKMON_STAT_TX_POWER] = (uint8_t)txPowerDbm[txIdx];
+    stats[LINKMON_STAT_STATE] = linkState;
+    stats[LINKMON_STAT_LOSS_AVG] = LO_UINT16(loss);
+    stats[LINKMON_STAT_LOSS_AVG + 1] = HI_UINT16(loss);
+    stats[LINKMON_STAT_CRC_AVG] = LO_UINT16(crc);
+    stats[LINKMON_STAT_CRC_AVG + 1] = HI_UINT16(crc);
+    stats[LINKMON_STAT_MISSED_TOTAL] = LO_UINT16(totalMissed);
+    stats[LINKMON_STAT_MISSED_TOTAL + 1] = HI_UINT16(totalMissed);
+    stats[LINKMON_STAT_CRC_TOTAL] = LO_UINT16(totalCrcErr);
+    stats[LINKMON_STAT_CRC_TOTAL + 1] = HI_UINT16(totalCrcErr);
+
+    Diag_SetParameter(DIAG_PARAM_LINK_QUALITY, DIAG_LINK_QUALITY_LEN, stats);
+}
+
+/*********************************************************************
+ * @fn      LinkMon_smooth
+ *
+ * @brief   Exponentially weighted moving average in Q4 fixed point.
+ *
+ * @param   avg - current average (Q4)
+ * @param   sample - new sample (integer)
+ *
+ * @return  new average (Q4)
+ */
+static uint16_t LinkMon_smooth(uint16_t avg, uint16_t sample)
+{
+    int32_t delta = ((int32_t)sample << LINKMON_FRAC_BITS) - avg;
+
+    return (uint16_t)(avg + delta / (1 << LINKMON_AVG_SHIFT));
+}
+
+/*********************************************************************
+*********************************************************************/
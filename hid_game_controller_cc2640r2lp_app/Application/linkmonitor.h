@@ -0,0 +1,148 @@
+/******************************************************************************
+
+ @file       linkmonitor.h
+
+ @brief This file contains the Link Quality Monitor definitions and
+        prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Periodically sample connection RSSI and packet error
+                        counters, keep smoothed statistics and adapt the TX
+                        power to the measured link margin.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef LINKMONITOR_H
+#define LINKMONITOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <icall.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Link monitor sampling period in milliseconds
+#define LINKMON_PERIOD                1000
+
+// Link quality states
+#define LINKMON_STATE_GOOD            0
+#define LINKMON_STATE_MARGINAL        1
+#define LINKMON_STATE_DEGRADED        2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Called from the application task when the link quality state changes
+typedef void (*linkMonStateCB_t)(uint8_t newState);
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      LinkMon_init
+ *
+ * @brief   Initialize the link quality monitor.
+ *
+ * @param   pfnStateCB - link quality state change callback
+ *
+ * @return  none
+ */
+void LinkMon_init(linkMonStateCB_t pfnStateCB);
+
+/*********************************************************************
+ * @fn      LinkMon_start
+ *
+ * @brief   Start monitoring a new connection. Statistics and the
+ *          controller packet error counters are reset and the TX power
+ *          is set back to its default.
+ *
+ * @param   connHandle - connection handle to monitor
+ *
+ * @return  none
+ */
+void LinkMon_start(uint16_t connHandle);
+
+/*********************************************************************
+ * @fn      LinkMon_stop
+ *
+ * @brief   Stop monitoring and restore the default TX power.
+ *
+ * @return  none
+ */
+void LinkMon_stop(void);
+
+/*********************************************************************
+ * @fn      LinkMon_poll
+ *
+ * @brief   Issue the RSSI and packet error rate reads for one sampling
+ *          window. Must be called from the application task every
+ *          LINKMON_PERIOD ms; results arrive as HCI events.
+ *
+ * @return  none
+ */
+void LinkMon_poll(void);
+
+/*********************************************************************
+ * @fn      LinkMon_processHciEvt
+ *
+ * @brief   Process an HCI_GAP_EVENT_EVENT received by the application.
+ *
+ * @param   pMsg - HCI event message
+ *
+ * @return  TRUE if the event was consumed by the link monitor
+ */
+uint8_t LinkMon_processHciEvt(ICall_Hdr *pMsg);
+
+/*********************************************************************
+ * @fn      LinkMon_setMaxTxPower
+ *
+ * @brief   Limit the TX power the monitor may select, also when the
+ *          link is about to time out. Takes effect immediately.
+ *
+ * @param   maxDbm - TX power cap in dBm, rounded down to a supported
+ *          level and never below the lowest one
+ *
+ * @return  none
+ */
+void LinkMon_setMaxTxPower(int8_t maxDbm);
+
+/*********************************************************************
+ * @fn      LinkMon_getState
+ *
+ * @brief   Get the current link quality state.
+ *
+ * @return  LINKMON_STATE_GOOD, LINKMON_STATE_MARGINAL or
+ *          LINKMON_STATE_DEGRADED
+ */
+uint8_t LinkMon_getState(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINKMONITOR_H */
@@ -0,0 +1,237 @@
+/******************************************************************************
+
+ @file       memmonitor.c
+
+ @brief This file contains the Memory Monitor for the BLE Game Controller.
+        It samples the peak usage of the task and ISR stacks and the state
+        of the heap shared by the application and the stack, and publishes
+        them through the diagnostic service and the Display.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Sample task and ISR stack peaks and heap usage at run
+                        time and publish them for sizing the RAM budgets.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <xdc/runtime/Memory.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/display/Display.h>
+
+#include <icall.h>
+#include "util.h"
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "diagservice.h"
+#include "memmonitor.h"
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+extern Display_Handle dispHandle;
+
+// Task instances of the GAP Role, HidDev and application tasks
+extern Task_Struct gapRoleTask;
+#ifndef HID_DEV_SINGLE_TASK
+extern Task_Struct hidDeviceTask;
+#endif // !HID_DEV_SINGLE_TASK
+extern Task_Struct hidGameControllerTask;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Stack usage, indexed by MEMMON_STACK_*
+static memMonStack_t memMonStacks[MEMMON_NUM_STACKS];
+
+// Lowest heap free size seen, 0xFFFF until the first sample
+static uint16_t memMonHeapMinFree = 0xFFFF;
+
+// Allocation failures reported through MemMon_outOfMemory
+static volatile uint16_t memMonOutOfMemory = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void MemMon_sampleTask(uint8_t stack, Task_Struct *pTask);
+static uint16_t MemMon_sat16(uint32_t value);
+static void MemMon_put16(uint8_t *pBuf, uint16_t value);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      MemMon_sample
+ *
+ * @brief   Sample the stack peaks and the heap and publish them.
+ *
+ * @return  none
+ */
+void MemMon_sample(void)
+{
+    uint8_t rec[DIAG_MEMORY_LEN];
+    utilMsgPoolStats_t poolStats;
+    Hwi_StackInfo hwiStack;
+    Memory_Stats heapStats;
+    uint16_t heapFree;
+    uint16_t failures;
+    uint8_t i;
+
+    // ISR stack, peak found by scanning for the fill pattern
+    Hwi_getStackInfo(&hwiStack, TRUE);
+    memMonStacks[MEMMON_STACK_ISR].size = MemMon_sat16(hwiStack.hwiStackSize);
+    memMonStacks[MEMMON_STACK_ISR].peak = MemMon_sat16(hwiStack.hwiStackPeak);
+
+    MemMon_sampleTask(MEMMON_STACK_GAPROLE, &gapRoleTask);
+#ifndef HID_DEV_SINGLE_TASK
+    MemMon_sampleTask(MEMMON_STACK_HIDDEV, &hidDeviceTask);
+#endif // !HID_DEV_SINGLE_TASK
+    MemMon_sampleTask(MEMMON_STACK_APP, &hidGameControllerTask);
+
+    // Heap shared by the application and the stack
+    Memory_getStats(NULL, &heapStats);
+    heapFree = MemMon_sat16(heapStats.totalFreeSize);
+
+    if (heapFree < memMonHeapMinFree)
+    {
+        memMonHeapMinFree = heapFree;
+    }
+
+    Util_getMsgPoolStats(&poolStats);
+    failures = MemMon_sat16((uint32_t)memMonOutOfMemory + poolStats.failures);
+
+    MemMon_put16(&rec[MEMMON_REC_HEAP_SIZE], MemMon_sat16(heapStats.totalSize));
+    MemMon_put16(&rec[MEMMON_REC_HEAP_FREE], heapFree);
+    MemMon_put16(&rec[MEMMON_REC_HEAP_MIN_FREE], memMonHeapMinFree);
+    MemMon_put16(&rec[MEMMON_REC_HEAP_LARGEST],
+                 MemMon_sat16(heapStats.largestFreeSize));
+    MemMon_put16(&rec[MEMMON_REC_ALLOC_FAILURES], failures);
+    rec[MEMMON_REC_POOL_HIGH_WATER] = (uint8_t)poolStats.highWater;
+    rec[MEMMON_REC_POOL_FALLBACKS] = (poolStats.fallbacks > 0xFF) ? 0xFF :
+                                     (uint8_t)poolStats.fallbacks;
+
+    for (i = 0; i < MEMMON_NUM_STACKS; i++)
+    {
+        // A stack of size 0 does not exist in this build
+        MemMon_put16(&rec[MEMMON_REC_STACK_MARGIN + 2 * i],
+                     (memMonStacks[i].size == 0) ? MEMMON_STACK_ABSENT :
+                     memMonStacks[i].size - memMonStacks[i].peak);
+    }
+
+    Diag_SetParameter(DIAG_PARAM_MEMORY, DIAG_MEMORY_LEN, rec);
+
+    Display_print4(dispHandle, 0, 0, "Heap free %d min %d largest %d fail %d",
+                   heapFree, memMonHeapMinFree,
+                   (uint16_t)heapStats.largestFreeSize, failures);
+
+    for (i = 0; i < MEMMON_NUM_STACKS; i++)
+    {
+        Display_print3(dispHandle, 0, 0, "Stack %d peak %d of %d", i,
+                       memMonStacks[i].peak, memMonStacks[i].size);
+    }
+}
+
+/*********************************************************************
+ * @fn      MemMon_outOfMemory
+ *
+ * @brief   Count a failed allocation.
+ *
+ * @return  none
+ */
+void MemMon_outOfMemory(void)
+{
+    UInt key = Hwi_disable();
+
+    if (memMonOutOfMemory < 0xFFFF)
+    {
+        memMonOutOfMemory++;
+    }
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      MemMon_getStack
+ *
+ * @brief   Get the usage of a stack as of the last sample.
+ *
+ * @param   stack - MEMMON_STACK_*
+ * @param   pStack - usage is copied here
+ *
+ * @return  none
+ */
+void MemMon_getStack(uint8_t stack, memMonStack_t *pStack)
+{
+    if (stack < MEMMON_NUM_STACKS)
+    {
+        *pStack = memMonStacks[stack];
+    }
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      MemMon_sampleTask
+ *
+ * @brief   Sample the stack of a task. Task_stat finds the peak by
+ *          scanning the stack for the fill pattern written at creation.
+ *
+ * @param   stack - MEMMON_STACK_*
+ * @param   pTask - task instance
+ *
+ * @return  none
+ */
+static void MemMon_sampleTask(uint8_t stack, Task_Struct *pTask)
+{
+    Task_Stat stat;
+
+    Task_stat(Task_handle(pTask), &stat);
+
+    memMonStacks[stack].size = MemMon_sat16(stat.stackSize);
+    memMonStacks[stack].peak = MemMon_sat16(stat.used);
+}
+
+/*********************************************************************
+ * @fn      MemMon_sat16
+ *
+ * @brief   Saturate a value to 16 bits.
+ *
+ * @param   value - value to saturate
+ *
+ * @return  value, at most 0xFFFF
+ */
+static uint16_t MemMon_sat16(uint32_t value)
+{
+    return (value > 0xFFFF) ? 0xFFFF : (uint16_t)value;
+}
+
+/*********************************************************************
+ * @fn      MemMon_put16
+ *
+ * @brief   Store a 16-bit value little endian.
+ *
+ * @param   pBuf - destination
+ * @param   value - value to store
+ *
+ * @return  none
+ */
+static void MemMon_put16(uint8_t *pBuf, uint16_t value)
+{
+    pBuf[0] = LO_UINT16(value);
+    pBuf[1] = HI_UINT16(value);
+}
+
+/*********************************************************************
+*********************************************************************/
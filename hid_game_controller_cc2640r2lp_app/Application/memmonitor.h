@@ -0,0 +1,123 @@
+/******************************************************************************
+
+ @file       memmonitor.h
+
+ @brief This file contains the Memory Monitor definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Sample task and ISR stack peaks and heap usage at run
+                        time and publish them for sizing the RAM budgets.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef MEMMONITOR_H
+#define MEMMONITOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Memory monitor sampling period in milliseconds
+#define MEMMON_PERIOD                 5000
+
+// Monitored stacks
+#define MEMMON_STACK_ISR              0
+#define MEMMON_STACK_GAPROLE          1
+#define MEMMON_STACK_HIDDEV           2
+#define MEMMON_STACK_APP              3
+#define MEMMON_NUM_STACKS             4
+
+// Stack margin of a stack that does not exist, e.g. the HidDev stack in the
+// HID_DEV_SINGLE_TASK build
+#define MEMMON_STACK_ABSENT           0xFFFF
+
+// Layout of the memory diagnostic record (DIAG_PARAM_MEMORY), all fields
+// little endian
+#define MEMMON_REC_HEAP_SIZE          0   // uint16, bytes
+#define MEMMON_REC_HEAP_FREE          2   // uint16, bytes
+#define MEMMON_REC_HEAP_MIN_FREE      4   // uint16, lowest free seen
+#define MEMMON_REC_HEAP_LARGEST       6   // uint16, largest free block
+#define MEMMON_REC_ALLOC_FAILURES     8   // uint16, heap and message pool
+#define MEMMON_REC_POOL_HIGH_WATER    10  // uint8, message pool blocks
+#define MEMMON_REC_POOL_FALLBACKS     11  // uint8, saturated at 255
+#define MEMMON_REC_STACK_MARGIN       12  // uint16 per stack, never used bytes
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Stack usage
+typedef struct
+{
+    uint16_t size;  // Stack size in bytes
+    uint16_t peak;  // Most bytes ever used
+} memMonStack_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      MemMon_sample
+ *
+ * @brief   Sample the stack peaks and the heap, update the memory
+ *          diagnostic characteristic and print a summary. Scans the
+ *          task stacks, call it every MEMMON_PERIOD ms from the
+ *          application task.
+ *
+ * @return  none
+ */
+void MemMon_sample(void);
+
+/*********************************************************************
+ * @fn      MemMon_outOfMemory
+ *
+ * @brief   Count a failed allocation, e.g. reported by the stack through
+ *          HAL_ASSERT_CAUSE_OUT_OF_MEMORY. Safe to call from any context.
+ *
+ * @return  none
+ */
+void MemMon_outOfMemory(void);
+
+/*********************************************************************
+ * @fn      MemMon_getStack
+ *
+ * @brief   Get the usage of a stack as of the last sample.
+ *
+ * @param   stack - MEMMON_STACK_*
+ * @param   pStack - usage is copied here
+ *
+ * @return  none
+ */
+void MemMon_getStack(uint8_t stack, memMonStack_t *pStack);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMMONITOR_H */
@@ -0,0 +1,250 @@
+/******************************************************************************
+
+ @file       pointer.c
+
+ @brief This file contains the Pointer Mode for the BLE Game Controller.
+        It turns the joystick deflection into relative mouse motion: the
+        speed follows a blend of a linear and a quadratic curve of the
+        deflection and the motion is integrated in 1/256 counts, so slow
+        movements at a short connection interval are not rounded away.
+        The conversion only depends on the C library so it can be built
+        and exercised on a host.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Joystick deflection to relative mouse motion with an
+                        acceleration curve and sub-pixel accumulation. Plain
+                        C without stack or RTOS dependencies.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stddef.h>
+
+#include "pointer.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Fraction bits of the curve and of the remainders
+#define POINTER_FRAC_BITS                 8
+#define POINTER_ONE                       (1 << POINTER_FRAC_BITS)
+
+// Longest time integrated in one call, a late call does not jump
+#define POINTER_MAX_ELAPSED               250
+
+// Largest motion of a report
+#define POINTER_MAX_COUNTS                127
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Curve in use
+static pointerCurve_t pointerCurve =
+{
+    POINTER_DEFAULT_MAX_SPEED, POINTER_DEFAULT_ACCEL
+};
+
+// Motion not reported yet, in 1/256 counts
+static int32_t pointerRemX = 0;
+static int32_t pointerRemY = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static int32_t Pointer_speed(int8_t axis);
+static int8_t Pointer_integrate(int32_t *pRem, int8_t axis,
+                                uint16_t elapsedMs);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Pointer_init
+ *
+ * @brief   Select the default curve and clear the sub-pixel remainders.
+ *
+ * @return  none
+ */
+void Pointer_init(void)
+{
+    pointerCurve.maxSpeed = POINTER_DEFAULT_MAX_SPEED;
+    pointerCurve.accel = POINTER_DEFAULT_ACCEL;
+
+    Pointer_reset();
+}
+
+/*********************************************************************
+ * @fn      Pointer_setCurve
+ *
+ * @brief   Select the acceleration curve. Values beyond the limits are
+ *          clamped.
+ *
+ * @param   pCurve - curve
+ *
+ * @return  none
+ */
+void Pointer_setCurve(const pointerCurve_t *pCurve)
+{
+    pointerCurve.maxSpeed = (pCurve->maxSpeed > POINTER_MAX_SPEED_LIMIT) ?
+                            POINTER_MAX_SPEED_LIMIT : pCurve->maxSpeed;
+    pointerCurve.accel = (pCurve->accel > POINTER_ACCEL_LIMIT) ?
+                         POINTER_ACCEL_LIMIT : pCurve->accel;
+}
+
+/*********************************************************************
+ * @fn      Pointer_getCurve
+ *
+ * @brief   Get the acceleration curve in use.
+ *
+ * @param   pCurve - curve is copied here
+ *
+ * @return  none
+ */
+void Pointer_getCurve(pointerCurve_t *pCurve)
+{
+    *pCurve = pointerCurve;
+}
+
+/*********************************************************************
+ * @fn      Pointer_reset
+ *
+ * @brief   Drop the sub-pixel remainders, call when the joystick is
+ *          back at rest or the mode changes.
+ *
+ * @return  none
+ */
+void Pointer_reset(void)
+{
+    pointerRemX = 0;
+    pointerRemY = 0;
+}
+
+/*********************************************************************
+ * @fn      Pointer_move
+ *
+ * @brief   Convert the joystick deflection over an elapsed time to
+ *          relative motion. The motion below one count is kept and added
+ *          to the next call.
+ *
+ * @param   axisX - X deflection, -POINTER_AXIS_MAX to POINTER_AXIS_MAX
+ * @param   axisY - Y deflection, -POINTER_AXIS_MAX to POINTER_AXIS_MAX
+ * @param   elapsedMs - time the deflection was held, in ms
+ * @param   pDx - X motion in counts
+ * @param   pDy - Y motion in counts
+ *
+ * @return  1 while the joystick is deflected, 0 at rest
+ */
+uint8_t Pointer_move(int8_t axisX, int8_t axisY, uint16_t elapsedMs,
+                     int8_t *pDx, int8_t *pDy)
+{
+    if ((axisX == 0) && (axisY == 0))
+    {
+        Pointer_reset();
+        *pDx = 0;
+        *pDy = 0;
+
+        return 0;
+    }
+
+    if (elapsedMs > POINTER_MAX_ELAPSED)
+    {
+        elapsedMs = POINTER_MAX_ELAPSED;
+    }
+
+    *pDx = Pointer_integrate(&pointerRemX, axisX, elapsedMs);
+    *pDy = Pointer_integrate(&pointerRemY, axisY, elapsedMs);
+
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      Pointer_speed
+ *
+ * @brief   Speed of an axis on the curve in use.
+ *
+ * @param   axis - deflection, -POINTER_AXIS_MAX to POINTER_AXIS_MAX
+ *
+ * @return  Signed speed in 1/256 counts per second
+ */
+static int32_t Pointer_speed(int8_t axis)
+{
+    int32_t mag = (axis < 0) ? -(int32_t)axis : axis;
+    int32_t lin;
+    int32_t quad;
+    int32_t frac;
+    int32_t speed;
+
+    if (mag > POINTER_AXIS_MAX)
+    {
+        mag = POINTER_AXIS_MAX;
+    }
+
+    // Deflection and its square as fractions of full deflection
+    lin = (mag << POINTER_FRAC_BITS) / POINTER_AXIS_MAX;
+    quad = (lin * lin) >> POINTER_FRAC_BITS;
+    frac = ((POINTER_ACCEL_LIMIT - pointerCurve.accel) * lin +
+            pointerCurve.accel * quad) / POINTER_ACCEL_LIMIT;
+
+    speed = (int32_t)pointerCurve.maxSpeed * frac;
+
+    return (axis < 0) ? -speed : speed;
+}
+
+/*********************************************************************
+ * @fn      Pointer_integrate
+ *
+ * @brief   Add the motion of an axis to its remainder and take the whole
+ *          counts out of it.
+ *
+ * @param   pRem - remainder of the axis, in 1/256 counts
+ * @param   axis - deflection
+ * @param   elapsedMs - time the deflection was held, in ms
+ *
+ * @return  Motion in counts
+ */
+static int8_t Pointer_integrate(int32_t *pRem, int8_t axis,
+                                uint16_t elapsedMs)
+{
+    int32_t counts;
+
+    *pRem += Pointer_speed(axis) * elapsedMs / 1000;
+
+    // Whole counts, the fraction keeps its sign
+    counts = *pRem / POINTER_ONE;
+
+    if (counts > POINTER_MAX_COUNTS)
+    {
+        counts = POINTER_MAX_COUNTS;
+    }
+    else if (counts < -POINTER_MAX_COUNTS)
+    {
+        counts = -POINTER_MAX_COUNTS;
+    }
+
+    *pRem -= counts * POINTER_ONE;
+
+    // Motion a report cannot carry is dropped, not saved up
+    if (*pRem >= POINTER_ONE)
+    {
+        *pRem = POINTER_ONE - 1;
+    }
+    else if (*pRem <= -POINTER_ONE)
+    {
+        *pRem = -(POINTER_ONE - 1);
+    }
+
+    return (int8_t)counts;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,138 @@
+/******************************************************************************
+
+ @file       pointer.h
+
+ @brief This file contains the Pointer Mode definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Joystick deflection to relative mouse motion with an
+                        acceleration curve and sub-pixel accumulation. Plain
+                        C without stack or RTOS dependencies.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef POINTER_H
+#define POINTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Full deflection of a joystick axis
+#define POINTER_AXIS_MAX                  127
+
+// Default curve: speed at full deflection in counts per second, and the
+// share of the quadratic term in percent, 0 moves linearly with the
+// deflection, 100 gives fine control near the center
+#define POINTER_DEFAULT_MAX_SPEED         1000
+#define POINTER_DEFAULT_ACCEL             60
+
+// Limits of the curve
+#define POINTER_MAX_SPEED_LIMIT           4000
+#define POINTER_ACCEL_LIMIT               100
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Acceleration curve
+typedef struct
+{
+    uint16_t maxSpeed;   // Counts per second at full deflection
+    uint8_t  accel;      // Share of the quadratic term in percent
+} pointerCurve_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Pointer_init
+ *
+ * @brief   Select the default curve and clear the sub-pixel remainders.
+ *
+ * @return  none
+ */
+void Pointer_init(void);
+
+/*********************************************************************
+ * @fn      Pointer_setCurve
+ *
+ * @brief   Select the acceleration curve. Values beyond the limits are
+ *          clamped.
+ *
+ * @param   pCurve - curve
+ *
+ * @return  none
+ */
+void Pointer_setCurve(const pointerCurve_t *pCurve);
+
+/*********************************************************************
+ * @fn      Pointer_getCurve
+ *
+ * @brief   Get the acceleration curve in use.
+ *
+ * @param   pCurve - curve is copied here
+ *
+ * @return  none
+ */
+void Pointer_getCurve(pointerCurve_t *pCurve);
+
+/*********************************************************************
+ * @fn      Pointer_reset
+ *
+ * @brief   Drop the sub-pixel remainders, call when the joystick is
+ *          back at rest or the mode changes.
+ *
+ * @return  none
+ */
+void Pointer_reset(void);
+
+/*********************************************************************
+ * @fn      Pointer_move
+ *
+ * @brief   Convert the joystick deflection over an elapsed time to
+ *          relative motion. The motion below one count is kept and added
+ *          to the next call.
+ *
+ * @param   axisX - X deflection, -POINTER_AXIS_MAX to POINTER_AXIS_MAX
+ * @param   axisY - Y deflection, -POINTER_AXIS_MAX to POINTER_AXIS_MAX
+ * @param   elapsedMs - time the deflection was held, in ms
+ * @param   pDx - X motion in counts
+ * @param   pDy - Y motion in counts
+ *
+ * @return  1 while the joystick is deflected, 0 at rest
+ */
+uint8_t Pointer_move(int8_t axisX, int8_t axisY, uint16_t elapsedMs,
+                     int8_t *pDx, int8_t *pDy);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POINTER_H */
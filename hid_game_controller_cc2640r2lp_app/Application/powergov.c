@@ -0,0 +1,494 @@
+/******************************************************************************
+
+ @file       powergov.c
+
+ @brief This file contains the Power Governor for the BLE Game Controller.
+        It is the single owner of the joystick sampling clock, the battery
+        measurement period and the wake sources, and switches them as the
+        controller moves between its power states.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Central power state machine owning the sampling
+                        clock, battery measurement rate and wake sources.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/display/Display.h>
+
+#include <icall.h>
+#include "util.h"
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "peripheral.h"
+#include "hiddev.h"
+#include "hidgamecontroller.h"
+#include "powergov.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Battery measurement periods in ms
+#define POWERGOV_ACTIVE_BATT_PERIOD       15000
+#define POWERGOV_IDLE_BATT_PERIOD         60000
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+extern Display_Handle dispHandle;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Resources used in each state, indexed by POWERGOV_STATE_*. The active
+// sampling period is configurable.
+static powerGovPolicy_t powerGovPolicy[POWERGOV_NUM_STATES] =
+{
+    // Deep sleep
+    { 0, 0, POWERGOV_WAKE_KEYS },
+    // Advertising
+    { 0, 0, POWERGOV_WAKE_KEYS },
+    // Idle-connected
+    { POWERGOV_IDLE_SAMPLE_PERIOD, POWERGOV_IDLE_BATT_PERIOD,
+      POWERGOV_WAKE_KEYS | POWERGOV_WAKE_JOYSTICK },
+    // Active play
+    { HID_PERIODIC_EVT_PERIOD, POWERGOV_ACTIVE_BATT_PERIOD,
+      POWERGOV_WAKE_KEYS | POWERGOV_WAKE_JOYSTICK },
+    // Suspended
+    { 0, 0, POWERGOV_WAKE_KEYS }
+};
+
+static Clock_Struct *pPowerGovSampleClock = NULL;
+static powerGovStateCB_t pfnPowerGovStateCB = NULL;
+static powerGovWakeCB_t pfnPowerGovWakeCB = NULL;
+
+// Wake sources armed, none before the first state is applied
+static uint8_t powerGovWakeSources = 0;
+
+static uint8_t powerGovState = POWERGOV_STATE_DEEP_SLEEP;
+
+// TRUE once the connection is encrypted and reports can be delivered
+static uint8_t powerGovLinkSecure = FALSE;
+
+// Lower bound for the sampling period, set by the battery policy
+static uint32_t powerGovMinSamplePeriod = 0;
+
+// Clock tick of the last input and of the last state change
+static uint32_t powerGovLastInput;
+static uint32_t powerGovStateEntered;
+
+// Time spent in each state
+static uint32_t powerGovResidency[POWERGOV_NUM_STATES];
+
+// Resume to first report measurement
+static uint32_t powerGovResumeStart;
+static uint8_t powerGovResumePending = FALSE;
+static uint32_t powerGovResumeLatency = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void PowerGov_setState(uint8_t newState);
+static void PowerGov_apply(void);
+static uint32_t PowerGov_elapsedMs(uint32_t since);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      PowerGov_init
+ *
+ * @brief   Initialize the power governor in the deep sleep state.
+ *
+ * @param   pSampleClock - clock driving joystick sampling and reports
+ * @param   pfnStateCB - state change callback, may be NULL
+ * @param   pfnWakeCB - wake source callback, may be NULL
+ *
+ * @return  none
+ */
+void PowerGov_init(Clock_Struct *pSampleClock, powerGovStateCB_t pfnStateCB,
+                   powerGovWakeCB_t pfnWakeCB)
+{
+    pPowerGovSampleClock = pSampleClock;
+    pfnPowerGovStateCB = pfnStateCB;
+    pfnPowerGovWakeCB = pfnWakeCB;
+    powerGovWakeSources = 0;
+
+    powerGovState = POWERGOV_STATE_DEEP_SLEEP;
+    powerGovStateEntered = Clock_getTicks();
+
+    PowerGov_apply();
+}
+
+/*********************************************************************
+ * @fn      PowerGov_linkEvent
+ *
+ * @brief   Re-evaluate the state after a HidDev GAP Role or GAP Bond
+ *          state change.
+ *
+ * @return  none
+ */
+void PowerGov_linkEvent(void)
+{
+    uint8_t gapState;
+    uint8_t bondState;
+
+    HidDev_GetParameter(HIDDEV_GAPROLE_STATE, &gapState);
+    HidDev_GetParameter(HIDDEV_GAPBOND_STATE, &bondState);
+
+    if (gapState == GAPROLE_CONNECTED)
+    {
+        uint8_t secure = (bondState == GAPBOND_PAIRING_STATE_COMPLETE) ||
+                         (bondState == GAPBOND_PAIRING_STATE_BONDED);
+
+        if ((powerGovState == POWERGOV_STATE_DEEP_SLEEP) ||
+            (powerGovState == POWERGOV_STATE_ADVERTISING))
+        {
+            powerGovLinkSecure = secure;
+            powerGovLastInput = Clock_getTicks();
+            PowerGov_setState(secure ? POWERGOV_STATE_ACTIVE :
+                                       POWERGOV_STATE_IDLE_CONNECTED);
+        }
+        else if (secure != powerGovLinkSecure)
+        {
+            powerGovLinkSecure = secure;
+
+            if (secure && (powerGovState != POWERGOV_STATE_SUSPENDED))
+            {
+                powerGovLastInput = Clock_getTicks();
+                PowerGov_setState(POWERGOV_STATE_ACTIVE);
+            }
+            else
+            {
+                PowerGov_apply();
+            }
+        }
+    }
+    else
+    {
+        powerGovLinkSecure = FALSE;
+
+        PowerGov_setState((gapState == GAPROLE_ADVERTISING) ?
+                          POWERGOV_STATE_ADVERTISING :
+                          POWERGOV_STATE_DEEP_SLEEP);
+    }
+}
+
+/*********************************************************************
+ * @fn      PowerGov_suspend
+ *
+ * @brief   Enter or leave the suspended state on a HID Control Point
+ *          command.
+ *
+ * @param   suspend - TRUE for HID_CMD_SUSPEND, FALSE for exit suspend
+ *
+ * @return  none
+ */
+void PowerGov_suspend(uint8_t suspend)
+{
+    if (suspend)
+    {
+        if ((powerGovState == POWERGOV_STATE_ACTIVE) ||
+            (powerGovState == POWERGOV_STATE_IDLE_CONNECTED))
+        {
+            PowerGov_setState(POWERGOV_STATE_SUSPENDED);
+        }
+    }
+    else if (powerGovState == POWERGOV_STATE_SUSPENDED)
+    {
+        powerGovLastInput = Clock_getTicks();
+        powerGovResumeStart = powerGovLastInput;
+        powerGovResumePending = TRUE;
+        PowerGov_setState(POWERGOV_STATE_ACTIVE);
+    }
+}
+
+/*********************************************************************
+ * @fn      PowerGov_inputActivity
+ *
+ * @brief   Report user input (key press or joystick deflection).
+ *
+ * @return  none
+ */
+void PowerGov_inputActivity(void)
+{
+    powerGovLastInput = Clock_getTicks();
+
+    switch (powerGovState)
+    {
+        case POWERGOV_STATE_DEEP_SLEEP:
+            // A key press brings the controller back to advertising, the
+            // GAP Role state change moves the governor along.
+            HidDev_StartAdvertising();
+            break;
+
+        case POWERGOV_STATE_IDLE_CONNECTED:
+            PowerGov_setState(POWERGOV_STATE_ACTIVE);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      PowerGov_sampled
+ *
+ * @brief   Report the outcome of one sampling period.
+ *
+ * @param   input - TRUE if any input was active in this sample
+ *
+ * @return  none
+ */
+void PowerGov_sampled(uint8_t input)
+{
+    if (input)
+    {
+        PowerGov_inputActivity();
+    }
+    else if ((powerGovState == POWERGOV_STATE_ACTIVE) &&
+             (PowerGov_elapsedMs(powerGovLastInput) >= POWERGOV_ACTIVE_TIMEOUT))
+    {
+        PowerGov_setState(POWERGOV_STATE_IDLE_CONNECTED);
+    }
+}
+
+/*********************************************************************
+ * @fn      PowerGov_reportSent
+ *
+ * @brief   Report that an input report was handed to HidDev.
+ *
+ * @return  none
+ */
+void PowerGov_reportSent(void)
+{
+    if (powerGovResumePending)
+    {
+        powerGovResumePending = FALSE;
+        powerGovResumeLatency = PowerGov_elapsedMs(powerGovResumeStart);
+
+        Display_print1(dispHandle, 0, 0, "Resume to first report %d ms",
+                       powerGovResumeLatency);
+    }
+}
+
+/*********************************************************************
+ * @fn      PowerGov_getResumeLatency
+ *
+ * @brief   Get the time from the last exit from suspend to the first
+ *          input report.
+ *
+ * @return  latency in ms, 0 if not measured yet
+ */
+uint32_t PowerGov_getResumeLatency(void)
+{
+    return powerGovResumeLatency;
+}
+
+/*********************************************************************
+ * @fn      PowerGov_setMinSamplePeriod
+ *
+ * @brief   Set a lower bound for the sampling period.
+ *
+ * @param   period - minimum period in ms, 0 for no bound
+ *
+ * @return  none
+ */
+void PowerGov_setMinSamplePeriod(uint32_t period)
+{
+    powerGovMinSamplePeriod = period;
+}
+
+/*********************************************************************
+ * @fn      PowerGov_setActivePeriod
+ *
+ * @brief   Set the sampling period of active play.
+ *
+ * @param   period - period in ms
+ *
+ * @return  none
+ */
+void PowerGov_setActivePeriod(uint32_t period)
+{
+    powerGovPolicy[POWERGOV_STATE_ACTIVE].samplePeriod = period;
+}
+
+/*********************************************************************
+ * @fn      PowerGov_getState
+ *
+ * @brief   Get the current power state.
+ *
+ * @return  POWERGOV_STATE_*
+ */
+uint8_t PowerGov_getState(void)
+{
+    return powerGovState;
+}
+
+/*********************************************************************
+ * @fn      PowerGov_getSamplePeriod
+ *
+ * @brief   Get the sampling period that applies right now. Nothing is
+ *          sampled before the connection is secure, as reports could
+ *          not be delivered anyway.
+ *
+ * @return  period in ms, 0 if sampling is stopped
+ */
+uint32_t PowerGov_getSamplePeriod(void)
+{
+    uint32_t period;
+
+    if (!powerGovLinkSecure)
+    {
+        return 0;
+    }
+
+    period = powerGovPolicy[powerGovState].samplePeriod;
+
+    if ((period > 0) && (period < powerGovMinSamplePeriod))
+    {
+        period = powerGovMinSamplePeriod;
+    }
+
+    return period;
+}
+
+/*********************************************************************
+ * @fn      PowerGov_getResidency
+ *
+ * @brief   Get the total time spent in a state since boot.
+ *
+ * @param   state - POWERGOV_STATE_*
+ *
+ * @return  residency in ms
+ */
+uint32_t PowerGov_getResidency(uint8_t state)
+{
+    uint32_t residency;
+
+    if (state >= POWERGOV_NUM_STATES)
+    {
+        return 0;
+    }
+
+    residency = powerGovResidency[state];
+
+    if (state == powerGovState)
+    {
+        residency += PowerGov_elapsedMs(powerGovStateEntered);
+    }
+
+    return residency;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      PowerGov_setState
+ *
+ * @brief   Move to a new state, account the residency of the old one
+ *          and apply the new policy.
+ *
+ * @param   newState - POWERGOV_STATE_*
+ *
+ * @return  none
+ */
+static void PowerGov_setState(uint8_t newState)
+{
+    uint8_t oldState = powerGovState;
+    uint32_t elapsed;
+
+    if (newState == oldState)
+    {
+        return;
+    }
+
+    elapsed = PowerGov_elapsedMs(powerGovStateEntered);
+
+    powerGovResidency[oldState] += elapsed;
+    powerGovStateEntered = Clock_getTicks();
+    powerGovState = newState;
+
+    // A resume cut short by a disconnection is not measured
+    if ((newState == POWERGOV_STATE_DEEP_SLEEP) ||
+        (newState == POWERGOV_STATE_ADVERTISING))
+    {
+        powerGovResumePending = FALSE;
+    }
+
+    Display_print3(dispHandle, 0, 0, "Power %d -> %d after %d ms",
+                   oldState, newState, elapsed);
+
+    PowerGov_apply();
+
+    if (pfnPowerGovStateCB != NULL)
+    {
+        pfnPowerGovStateCB(oldState, newState);
+    }
+}
+
+/*********************************************************************
+ * @fn      PowerGov_apply
+ *
+ * @brief   Configure the sampling clock, battery measurement and wake
+ *          sources for the current state.
+ *
+ * @return  none
+ */
+static void PowerGov_apply(void)
+{
+    uint32_t samplePeriod = PowerGov_getSamplePeriod();
+    uint32_t battPeriod = powerGovPolicy[powerGovState].battPeriod;
+    uint8_t wakeSources = powerGovPolicy[powerGovState].wakeSources;
+
+    if (pPowerGovSampleClock != NULL)
+    {
+        if (samplePeriod > 0)
+        {
+            Util_restartClock(pPowerGovSampleClock, samplePeriod);
+        }
+        else
+        {
+            Util_stopClock(pPowerGovSampleClock);
+        }
+    }
+
+    HidDev_SetParameter(HIDDEV_BATT_PERIOD, sizeof(uint32_t), &battPeriod);
+
+    if ((pfnPowerGovWakeCB != NULL) && (wakeSources != powerGovWakeSources))
+    {
+        powerGovWakeSources = wakeSources;
+        pfnPowerGovWakeCB(wakeSources);
+    }
+}
+
+/*********************************************************************
+ * @fn      PowerGov_elapsedMs
+ *
+ * @brief   Milliseconds elapsed since a clock tick count.
+ *
+ * @param   since - Clock_getTicks() value
+ *
+ * @return  elapsed time in ms
+ */
+static uint32_t PowerGov_elapsedMs(uint32_t since)
+{
+    return (Clock_getTicks() - since) / (1000 / Clock_tickPeriod);
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,222 @@
+/******************************************************************************
+
+ @file       powergov.h
+
+ @brief This file contains the Power Governor definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Central power state machine owning the sampling
+                        clock, battery measurement rate and wake sources.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef POWERGOV_H
+#define POWERGOV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ti/sysbios/knl/Clock.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Power states
+#define POWERGOV_STATE_DEEP_SLEEP         0  // Not connected, not advertising
+#define POWERGOV_STATE_ADVERTISING        1  // Waiting for a connection
+#define POWERGOV_STATE_IDLE_CONNECTED     2  // Connected, no recent input
+#define POWERGOV_STATE_ACTIVE             3  // Connected, player is active
+#define POWERGOV_STATE_SUSPENDED          4  // Host suspended (HID_CMD_SUSPEND)
+#define POWERGOV_NUM_STATES               5
+
+// Wake sources: the key interrupts, and the joystick ADC, which has no
+// interrupt and only wakes the states that sample it
+#define POWERGOV_WAKE_KEYS                0x01
+#define POWERGOV_WAKE_JOYSTICK            0x02
+
+// Time in ms without input before active play drops to idle-connected
+#define POWERGOV_ACTIVE_TIMEOUT           5000
+
+// Sampling period in ms while idle-connected
+#define POWERGOV_IDLE_SAMPLE_PERIOD       240
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Resources owned by the governor in each state
+typedef struct
+{
+    uint32_t samplePeriod;  // Joystick sampling/report period in ms, 0 = off
+    uint32_t battPeriod;    // Battery measurement period in ms, 0 = off
+    uint8_t  wakeSources;   // POWERGOV_WAKE_* that bring the state back up
+} powerGovPolicy_t;
+
+// Called from the application task after every state change
+typedef void (*powerGovStateCB_t)(uint8_t oldState, uint8_t newState);
+
+// Called from the application task to arm the POWERGOV_WAKE_* of a state
+// and disarm the others
+typedef void (*powerGovWakeCB_t)(uint8_t wakeSources);
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      PowerGov_init
+ *
+ * @brief   Initialize the power governor in the deep sleep state.
+ *
+ * @param   pSampleClock - clock driving joystick sampling and reports
+ * @param   pfnStateCB - state change callback, may be NULL
+ * @param   pfnWakeCB - wake source callback, may be NULL
+ *
+ * @return  none
+ */
+void PowerGov_init(Clock_Struct *pSampleClock, powerGovStateCB_t pfnStateCB,
+                   powerGovWakeCB_t pfnWakeCB);
+
+/*********************************************************************
+ * @fn      PowerGov_linkEvent
+ *
+ * @brief   Re-evaluate the state after a HidDev GAP Role or GAP Bond
+ *          state change.
+ *
+ * @return  none
+ */
+void PowerGov_linkEvent(void);
+
+/*********************************************************************
+ * @fn      PowerGov_suspend
+ *
+ * @brief   Enter or leave the suspended state on a HID Control Point
+ *          command.
+ *
+ * @param   suspend - TRUE for HID_CMD_SUSPEND, FALSE for exit suspend
+ *
+ * @return  none
+ */
+void PowerGov_suspend(uint8_t suspend);
+
+/*********************************************************************
+ * @fn      PowerGov_inputActivity
+ *
+ * @brief   Report user input (key press or joystick deflection).
+ *
+ * @return  none
+ */
+void PowerGov_inputActivity(void);
+
+/*********************************************************************
+ * @fn      PowerGov_sampled
+ *
+ * @brief   Report the outcome of one sampling period.
+ *
+ * @param   input - TRUE if any input was active in this sample
+ *
+ * @return  none
+ */
+void PowerGov_sampled(uint8_t input);
+
+/*********************************************************************
+ * @fn      PowerGov_reportSent
+ *
+ * @brief   Report that an input report was handed to HidDev. The first
+ *          report after leaving suspend ends the resume measurement.
+ *
+ * @return  none
+ */
+void PowerGov_reportSent(void);
+
+/*********************************************************************
+ * @fn      PowerGov_setMinSamplePeriod
+ *
+ * @brief   Set a lower bound for the sampling period of the connected
+ *          states, used to reduce the report rate on a low battery.
+ *          Applies from the next sample on.
+ *
+ * @param   period - minimum period in ms, 0 for no bound
+ *
+ * @return  none
+ */
+void PowerGov_setMinSamplePeriod(uint32_t period);
+
+/*********************************************************************
+ * @fn      PowerGov_setActivePeriod
+ *
+ * @brief   Set the sampling period of active play, the report rate.
+ *          Applies from the next sample on, the battery policy bound
+ *          still applies.
+ *
+ * @param   period - period in ms, HID_PERIODIC_EVT_PERIOD by default
+ *
+ * @return  none
+ */
+void PowerGov_setActivePeriod(uint32_t period);
+
+/*********************************************************************
+ * @fn      PowerGov_getState
+ *
+ * @brief   Get the current power state.
+ *
+ * @return  POWERGOV_STATE_*
+ */
+uint8_t PowerGov_getState(void);
+
+/*********************************************************************
+ * @fn      PowerGov_getSamplePeriod
+ *
+ * @brief   Get the sampling period that applies right now.
+ *
+ * @return  period in ms, 0 if sampling is stopped
+ */
+uint32_t PowerGov_getSamplePeriod(void);
+
+/*********************************************************************
+ * @fn      PowerGov_getResidency
+ *
+ * @brief   Get the total time spent in a state since boot.
+ *
+ * @param   state - POWERGOV_STATE_*
+ *
+ * @return  residency in ms
+ */
+uint32_t PowerGov_getResidency(uint8_t state);
+
+/*********************************************************************
+ * @fn      PowerGov_getResumeLatency
+ *
+ * @brief   Get the time from the last exit from suspend (host command
+ *          or remote wake) to the first input report.
+ *
+ * @return  latency in ms, 0 if not measured yet
+ */
+uint32_t PowerGov_getResumeLatency(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POWERGOV_H */
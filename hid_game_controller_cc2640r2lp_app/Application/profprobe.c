@@ -0,0 +1,234 @@
+/******************************************************************************
+
+ @file       profprobe.c
+
+ @brief This file contains the Profiling Probes for the BLE Game Controller.
+        It keeps the minimum, maximum and mean run time of the hot paths,
+        measured with the DWT cycle counter, and publishes them through the
+        diagnostic service and the Display. Built with PROF_PROBES only.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Cycle counts of the hot paths from the DWT cycle
+                        counter, or from the monotonic clock on the host
+                        simulation, published through the diagnostic
+                        service.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifdef PROF_PROBES
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/display/Display.h>
+
+#ifndef PROF_HOST_CLOCK
+#include <inc/hw_cpu_scs.h>
+#endif // !PROF_HOST_CLOCK
+
+#include <icall.h>
+#include "util.h"
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "diagservice.h"
+#include "profprobe.h"
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+extern Display_Handle dispHandle;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Statistics, indexed by PROF_PROBE_*
+static profStats_t profStats[PROF_NUM_PROBES];
+
+static const char * const profNames[PROF_NUM_PROBES] = PROF_PROBE_NAMES;
+
+// Next probe to publish
+static uint8_t profNext = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void Prof_put32(uint8_t *pBuf, uint32_t value);
+static uint32_t Prof_toNs(uint32_t ticks);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Prof_init
+ *
+ * @brief   Start the cycle counter and clear the statistics.
+ *
+ * @return  none
+ */
+void Prof_init(void)
+{
+    uint8_t i;
+
+#ifndef PROF_HOST_CLOCK
+    // The DWT is clocked only with the trace enabled
+    HWREG(CPU_SCS_BASE + CPU_SCS_O_DEMCR) |= CPU_SCS_DEMCR_TRCENA;
+    HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT) = 0;
+    HWREG(CPU_DWT_BASE + CPU_DWT_O_CTRL) |= CPU_DWT_CTRL_CYCCNTENA;
+#endif // !PROF_HOST_CLOCK
+
+    memset(profStats, 0, sizeof(profStats));
+
+    for (i = 0; i < PROF_NUM_PROBES; i++)
+    {
+        profStats[i].min = 0xFFFFFFFF;
+    }
+}
+
+/*********************************************************************
+ * @fn      Prof_add
+ *
+ * @brief   Add a run to the statistics of a probe. Safe to call from
+ *          any context.
+ *
+ * @param   probe - PROF_PROBE_*
+ * @param   ticks - run time in counter ticks
+ *
+ * @return  none
+ */
+void Prof_add(uint8_t probe, uint32_t ticks)
+{
+    profStats_t *pStats = &profStats[probe];
+    UInt key = Hwi_disable();
+
+    pStats->count++;
+    pStats->sum += ticks;
+
+    if (ticks < pStats->min)
+    {
+        pStats->min = ticks;
+    }
+
+    if (ticks > pStats->max)
+    {
+        pStats->max = ticks;
+    }
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      Prof_get
+ *
+ * @brief   Get the statistics of a probe.
+ *
+ * @param   probe - PROF_PROBE_*
+ * @param   pStats - statistics are copied here
+ *
+ * @return  none
+ */
+void Prof_get(uint8_t probe, profStats_t *pStats)
+{
+    UInt key = Hwi_disable();
+
+    *pStats = profStats[probe];
+
+    Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      Prof_publish
+ *
+ * @brief   Notify the record of the next probe that ran on the profile
+ *          diagnostic characteristic and print it. One record a call
+ *          keeps the notification buffers free for the input reports.
+ *          Call it every PROF_PERIOD ms from the application task.
+ *
+ * @return  none
+ */
+void Prof_publish(void)
+{
+    uint8_t rec[DIAG_PROFILE_LEN];
+    profStats_t stats;
+    uint32_t mean;
+    uint8_t n;
+    uint8_t i;
+
+    for (n = 0; n < PROF_NUM_PROBES; n++)
+    {
+        i = profNext;
+        profNext = (profNext + 1) % PROF_NUM_PROBES;
+
+        Prof_get(i, &stats);
+
+        if (stats.count == 0)
+        {
+            continue;
+        }
+
+        mean = (uint32_t)(stats.sum / stats.count);
+
+        rec[PROF_REC_PROBE] = i;
+        rec[PROF_REC_TICKS_PER_US] = LO_UINT16(PROF_TICKS_PER_US);
+        rec[PROF_REC_TICKS_PER_US + 1] = HI_UINT16(PROF_TICKS_PER_US);
+        Prof_put32(&rec[PROF_REC_COUNT], stats.count);
+        Prof_put32(&rec[PROF_REC_MIN], stats.min);
+        Prof_put32(&rec[PROF_REC_MAX], stats.max);
+        Prof_put32(&rec[PROF_REC_MEAN], mean);
+
+        Diag_SetParameter(DIAG_PARAM_PROFILE, DIAG_PROFILE_LEN, rec);
+
+        Display_print5(dispHandle, 0, 0, "Prof %s n %d min %d mean %d max %d ns",
+                       profNames[i], stats.count, Prof_toNs(stats.min),
+                       Prof_toNs(mean), Prof_toNs(stats.max));
+        break;
+    }
+}
+
+/*********************************************************************
+ * @fn      Prof_put32
+ *
+ * @brief   Store a value little endian.
+ *
+ * @param   pBuf - destination
+ * @param   value - value
+ *
+ * @return  none
+ */
+static void Prof_put32(uint8_t *pBuf, uint32_t value)
+{
+    pBuf[0] = BREAK_UINT32(value, 0);
+    pBuf[1] = BREAK_UINT32(value, 1);
+    pBuf[2] = BREAK_UINT32(value, 2);
+    pBuf[3] = BREAK_UINT32(value, 3);
+}
+
+/*********************************************************************
+ * @fn      Prof_toNs
+ *
+ * @brief   Convert counter ticks to nanoseconds.
+ *
+ * @param   ticks - counter ticks
+ *
+ * @return  Nanoseconds, saturated to 32 bits
+ */
+static uint32_t Prof_toNs(uint32_t ticks)
+{
+    uint64_t ns = (uint64_t)ticks * 1000 / PROF_TICKS_PER_US;
+
+    return (ns > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)ns;
+}
+
+#endif // PROF_PROBES
+
+/*********************************************************************
+*********************************************************************/
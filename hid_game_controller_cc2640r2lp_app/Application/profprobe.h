@@ -0,0 +1,194 @@
+/******************************************************************************
+
+ @file       profprobe.h
+
+ @brief This file contains the Profiling Probe definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Cycle counts of the hot paths from the DWT cycle
+                        counter, or from the monotonic clock on the host
+                        simulation, published through the diagnostic
+                        service.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef PROFPROBE_H
+#define PROFPROBE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+#ifdef PROF_PROBES
+#ifdef PROF_HOST_CLOCK
+#include <time.h>
+#else
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_cpu_dwt.h>
+#endif // PROF_HOST_CLOCK
+#endif // PROF_PROBES
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Publishing period in milliseconds, of one probe record
+#define PROF_PERIOD                   1000
+
+// Probes
+#define PROF_PROBE_JOYSTICK_READ      0   // HidJoystick_Read
+#define PROF_PROBE_SEND_REPORT        1   // HidGameController_sendReport
+#define PROF_PROBE_HIDDEV_REPORT      2   // HidDev_Report
+#define PROF_PROBE_HIDDEV_SEND_NOTI   3   // HidDev_sendNoti
+#define PROF_PROBE_KEY_CALLBACK       4   // Board_keyCallback
+#define PROF_PROBE_APP_DISPATCH       5   // Application task wakeup
+#define PROF_PROBE_HIDDEV_DISPATCH    6   // HidDev_processEvents
+#define PROF_PROBE_LCD_SLICE          7   // LcdText_process
+#define PROF_NUM_PROBES               8
+
+#define PROF_PROBE_NAMES              { "joystick", "sendReport", \
+                                        "hidReport", "sendNoti", "keyIsr", \
+                                        "appTask", "hidDevEvt", "lcdSlice" }
+
+// Counter ticks per microsecond: CPU cycles at 48 MHz on the target,
+// nanoseconds on the host
+#ifdef PROF_HOST_CLOCK
+#define PROF_TICKS_PER_US             1000
+#else
+#define PROF_TICKS_PER_US             48
+#endif // PROF_HOST_CLOCK
+
+// Layout of the profile diagnostic record (DIAG_PARAM_PROFILE), all fields
+// little endian, one record per probe
+#define PROF_REC_PROBE                0   // uint8, PROF_PROBE_*
+#define PROF_REC_TICKS_PER_US         1   // uint16, PROF_TICKS_PER_US
+#define PROF_REC_COUNT                3   // uint32, runs
+#define PROF_REC_MIN                  7   // uint32, counter ticks
+#define PROF_REC_MAX                  11  // uint32, counter ticks
+#define PROF_REC_MEAN                 15  // uint32, counter ticks
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Statistics of a probe, in counter ticks
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} profStats_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Probe points, nothing is compiled in without PROF_PROBES. PROF_ENTER
+// declares the start time in the enclosing block, every path out of the
+// block after it must pass PROF_EXIT.
+#ifdef PROF_PROBES
+#define PROF_ENTER(probe)   uint32_t profStart_##probe = Prof_now()
+#define PROF_EXIT(probe)    Prof_add(PROF_PROBE_##probe, \
+                                     Prof_now() - profStart_##probe)
+#else
+#define PROF_ENTER(probe)
+#define PROF_EXIT(probe)
+#endif // PROF_PROBES
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+#ifdef PROF_PROBES
+/*********************************************************************
+ * @fn      Prof_now
+ *
+ * @brief   Read the counter: DWT CYCCNT on the target, CLOCK_MONOTONIC
+ *          in nanoseconds on the host. Wraps around, only differences of
+ *          two readings count.
+ *
+ * @return  Counter ticks
+ */
+#ifdef PROF_HOST_CLOCK
+static inline uint32_t Prof_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+#else
+#define Prof_now()          HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT)
+#endif // PROF_HOST_CLOCK
+#endif // PROF_PROBES
+
+/*********************************************************************
+ * @fn      Prof_init
+ *
+ * @brief   Start the cycle counter and clear the statistics.
+ *
+ * @return  none
+ */
+void Prof_init(void);
+
+/*********************************************************************
+ * @fn      Prof_add
+ *
+ * @brief   Add a run to the statistics of a probe. Safe to call from
+ *          any context.
+ *
+ * @param   probe - PROF_PROBE_*
+ * @param   ticks - run time in counter ticks
+ *
+ * @return  none
+ */
+void Prof_add(uint8_t probe, uint32_t ticks);
+
+/*********************************************************************
+ * @fn      Prof_get
+ *
+ * @brief   Get the statistics of a probe.
+ *
+ * @param   probe - PROF_PROBE_*
+ * @param   pStats - statistics are copied here
+ *
+ * @return  none
+ */
+void Prof_get(uint8_t probe, profStats_t *pStats);
+
+/*********************************************************************
+ * @fn      Prof_publish
+ *
+ * @brief   Notify the record of the next probe that ran on the profile
+ *          diagnostic characteristic and print it. Call it every
+ *          PROF_PERIOD ms from the application task.
+ *
+ * @return  none
+ */
+void Prof_publish(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFPROBE_H */
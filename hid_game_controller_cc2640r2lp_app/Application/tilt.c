@@ -0,0 +1,329 @@
+/******************************************************************************
+
+ @file       tilt.c
+
+ @brief This file contains the Tilt Control for the BLE Game Controller.
+        It turns the accelerometer readings of the BoosterPack MKII into a
+        gamepad direction: each axis is low-pass filtered in 1/256 counts,
+        the tilt from the neutral pose is scaled to the direction and the
+        result is fused with or replaces the joystick. Every step is a
+        fixed number of integer operations, and the code only depends on
+        the C library so it can be built and exercised on a host.
+
+        The board is taken flat, X to the right and Y to the top of the
+        BoosterPack. An axis reads more as its end is raised.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Accelerometer tilt to gamepad direction with a
+                        fixed-point low-pass filter, fused with or in place
+                        of the joystick. Plain C without stack or RTOS
+                        dependencies.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stddef.h>
+
+#include "tilt.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Fraction bits of the filter state and of the scale
+#define TILT_FRAC_BITS                    8
+#define TILT_ONE                          (1 << TILT_FRAC_BITS)
+
+// Longest time filtered in one call, a late sample does not jump
+#define TILT_MAX_ELAPSED                  250
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Configuration in use
+static tiltConfig_t tiltConfig =
+{
+    TILT_DEFAULT_FULL_TILT, TILT_DEFAULT_DEADZONE, TILT_DEFAULT_TAU
+};
+
+// Dead zone in 1/256 counts, and the direction per count beyond it in
+// 1/256 axis steps
+static int32_t tiltDeadzone;
+static int32_t tiltScale;
+
+// Filtered readings and the neutral pose, in 1/256 counts
+static int32_t tiltFilt[TILT_NUM_AXES];
+static int32_t tiltNeutralX;
+static int32_t tiltNeutralY;
+
+// FALSE until the first sample after a reset
+static uint8_t tiltSeeded = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static int8_t Tilt_axis(int32_t offset, uint8_t pastLevel);
+static int8_t Tilt_blend(int8_t joy, int8_t tilt);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Tilt_init
+ *
+ * @brief   Select the default configuration. The next sample sets the
+ *          neutral pose.
+ *
+ * @return  none
+ */
+void Tilt_init(void)
+{
+    tiltConfig_t config =
+    {
+        TILT_DEFAULT_FULL_TILT, TILT_DEFAULT_DEADZONE, TILT_DEFAULT_TAU
+    };
+
+    Tilt_setConfig(&config);
+    Tilt_reset();
+}
+
+/*********************************************************************
+ * @fn      Tilt_setConfig
+ *
+ * @brief   Select the configuration. Values beyond the limits are
+ *          clamped, the dead zone to half the full tilt.
+ *
+ * @param   pConfig - configuration
+ *
+ * @return  none
+ */
+void Tilt_setConfig(const tiltConfig_t *pConfig)
+{
+    int32_t full;
+
+    tiltConfig.fullTilt = pConfig->fullTilt;
+    if (tiltConfig.fullTilt < TILT_MIN_FULL_TILT)
+    {
+        tiltConfig.fullTilt = TILT_MIN_FULL_TILT;
+    }
+    else if (tiltConfig.fullTilt > TILT_MAX_FULL_TILT)
+    {
+        tiltConfig.fullTilt = TILT_MAX_FULL_TILT;
+    }
+
+    tiltConfig.deadzone = (pConfig->deadzone > tiltConfig.fullTilt / 2) ?
+                          tiltConfig.fullTilt / 2 : pConfig->deadzone;
+    tiltConfig.tau = (pConfig->tau > TILT_MAX_TAU) ?
+                     TILT_MAX_TAU : pConfig->tau;
+
+    // The divisions are done here, not per sample
+    full = ((int32_t)tiltConfig.fullTilt * TILT_ADC_ONE_G << TILT_FRAC_BITS) /
+           1000;
+    tiltDeadzone = ((int32_t)tiltConfig.deadzone * TILT_ADC_ONE_G <<
+                    TILT_FRAC_BITS) / 1000;
+    tiltScale = ((int32_t)TILT_AXIS_MAX << (2 * TILT_FRAC_BITS)) /
+                (full - tiltDeadzone);
+}
+
+/*********************************************************************
+ * @fn      Tilt_getConfig
+ *
+ * @brief   Get the configuration in use.
+ *
+ * @param   pConfig - configuration is copied here
+ *
+ * @return  none
+ */
+void Tilt_getConfig(tiltConfig_t *pConfig)
+{
+    *pConfig = tiltConfig;
+}
+
+/*********************************************************************
+ * @fn      Tilt_reset
+ *
+ * @brief   Start over, the next sample sets the neutral pose and the
+ *          filter. Call when a tilt mode is switched on.
+ *
+ * @return  none
+ */
+void Tilt_reset(void)
+{
+    tiltSeeded = 0;
+}
+
+/*********************************************************************
+ * @fn      Tilt_update
+ *
+ * @brief   Filter a sample of the accelerometer and map the tilt from the
+ *          neutral pose to a direction. The cost does not depend on the
+ *          readings.
+ *
+ * @param   pAdc - ADC readings of the X, Y and Z axes
+ * @param   elapsedMs - time since the previous sample, in ms
+ * @param   pX - X direction, right positive
+ * @param   pY - Y direction, down positive
+ *
+ * @return  none
+ */
+void Tilt_update(const uint16_t *pAdc, uint16_t elapsedMs,
+                 int8_t *pX, int8_t *pY)
+{
+    int32_t alpha;
+    uint8_t pastLevel;
+    uint8_t i;
+
+    if (!tiltSeeded)
+    {
+        // The pose the controller is held in is neutral
+        for (i = 0; i < TILT_NUM_AXES; i++)
+        {
+            tiltFilt[i] = (int32_t)pAdc[i] << TILT_FRAC_BITS;
+        }
+
+        tiltNeutralX = tiltFilt[TILT_AXIS_X];
+        tiltNeutralY = tiltFilt[TILT_AXIS_Y];
+        tiltSeeded = 1;
+    }
+    else
+    {
+        if (elapsedMs > TILT_MAX_ELAPSED)
+        {
+            elapsedMs = TILT_MAX_ELAPSED;
+        }
+
+        // First order low-pass, the share of the new sample follows the
+        // time since the last one, so the response does not depend on
+        // the sampling period
+        alpha = ((elapsedMs + tiltConfig.tau) != 0) ?
+                ((int32_t)elapsedMs << TILT_FRAC_BITS) /
+                (elapsedMs + tiltConfig.tau) : TILT_ONE;
+
+        for (i = 0; i < TILT_NUM_AXES; i++)
+        {
+            tiltFilt[i] += ((((int32_t)pAdc[i] << TILT_FRAC_BITS) -
+                             tiltFilt[i]) * alpha) / TILT_ONE;
+        }
+    }
+
+    // Past 90 degrees X and Y read less again, Z below 0 g tells
+    pastLevel = (tiltFilt[TILT_AXIS_Z] <
+                 ((int32_t)TILT_ADC_ZERO_G << TILT_FRAC_BITS));
+
+    // Right side down lowers X, top down lowers Y, which is up
+    *pX = Tilt_axis(tiltNeutralX - tiltFilt[TILT_AXIS_X], pastLevel);
+    *pY = Tilt_axis(tiltFilt[TILT_AXIS_Y] - tiltNeutralY, pastLevel);
+}
+
+/*********************************************************************
+ * @fn      Tilt_fuse
+ *
+ * @brief   Combine the joystick and the tilt direction of a mode. In the
+ *          fuse mode the tilt fills the deflection the joystick leaves.
+ *
+ * @param   mode - TILT_MODE_*
+ * @param   joyX - joystick X, -TILT_AXIS_MAX to TILT_AXIS_MAX
+ * @param   joyY - joystick Y
+ * @param   tiltX - tilt X
+ * @param   tiltY - tilt Y
+ * @param   pX - X direction
+ * @param   pY - Y direction
+ *
+ * @return  none
+ */
+void Tilt_fuse(uint8_t mode, int8_t joyX, int8_t joyY, int8_t tiltX,
+               int8_t tiltY, int8_t *pX, int8_t *pY)
+{
+    switch (mode)
+    {
+        case TILT_MODE_FUSE:
+            *pX = Tilt_blend(joyX, tiltX);
+            *pY = Tilt_blend(joyY, tiltY);
+            break;
+
+        case TILT_MODE_OVERRIDE:
+            *pX = tiltX;
+            *pY = tiltY;
+            break;
+
+        default:
+            *pX = joyX;
+            *pY = joyY;
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      Tilt_axis
+ *
+ * @brief   Scale the tilt of an axis beyond the dead zone to a direction.
+ *
+ * @param   offset - filtered reading from the neutral pose, in 1/256
+ *                   counts
+ * @param   pastLevel - TRUE when tilted past 90 degrees, any tilt beyond
+ *                      the dead zone is full deflection
+ *
+ * @return  -TILT_AXIS_MAX to TILT_AXIS_MAX
+ */
+static int8_t Tilt_axis(int32_t offset, uint8_t pastLevel)
+{
+    int32_t mag = (offset < 0) ? -offset : offset;
+    int32_t axis;
+
+    if (mag <= tiltDeadzone)
+    {
+        return 0;
+    }
+
+    axis = pastLevel ? TILT_AXIS_MAX :
+           (((mag - tiltDeadzone) >> TILT_FRAC_BITS) * tiltScale) >>
+           TILT_FRAC_BITS;
+
+    if (axis > TILT_AXIS_MAX)
+    {
+        axis = TILT_AXIS_MAX;
+    }
+
+    return (int8_t)((offset < 0) ? -axis : axis);
+}
+
+/*********************************************************************
+ * @fn      Tilt_blend
+ *
+ * @brief   Add the tilt to a joystick axis, weighted by the deflection the
+ *          joystick leaves, so the joystick alone reaches full deflection
+ *          and the tilt alone does at rest.
+ *
+ * @param   joy - joystick axis
+ * @param   tilt - tilt axis
+ *
+ * @return  -TILT_AXIS_MAX to TILT_AXIS_MAX
+ */
+static int8_t Tilt_blend(int8_t joy, int8_t tilt)
+{
+    int32_t room = TILT_AXIS_MAX - ((joy < 0) ? -joy : joy);
+    int32_t axis = joy + ((int32_t)tilt * room) / TILT_AXIS_MAX;
+
+    if (axis > TILT_AXIS_MAX)
+    {
+        axis = TILT_AXIS_MAX;
+    }
+    else if (axis < -TILT_AXIS_MAX)
+    {
+        axis = -TILT_AXIS_MAX;
+    }
+
+    return (int8_t)axis;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,178 @@
+/******************************************************************************
+
+ @file       tilt.h
+
+ @brief This file contains the Tilt Control definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Accelerometer tilt to gamepad direction with a
+                        fixed-point low-pass filter, fused with or in place
+                        of the joystick. Plain C without stack or RTOS
+                        dependencies.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef TILT_H
+#define TILT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Direction sources
+#define TILT_MODE_OFF                     0   // Joystick only
+#define TILT_MODE_FUSE                    1   // Tilt, the joystick takes
+                                              // over as it is deflected
+#define TILT_MODE_OVERRIDE                2   // Tilt only
+#define TILT_NUM_MODES                    3
+
+// Accelerometer axes
+#define TILT_AXIS_X                       0
+#define TILT_AXIS_Y                       1
+#define TILT_AXIS_Z                       2
+#define TILT_NUM_AXES                     3
+
+// Full deflection of a direction axis
+#define TILT_AXIS_MAX                     127
+
+// Accelerometer readings in ADC counts: 0 g at half the supply, 660 mV
+// per g at 3.3 V, on the 4.3 V fixed reference of the ADC
+#define TILT_ADC_ZERO_G                   1572
+#define TILT_ADC_ONE_G                    629
+
+// Default configuration: tilt for full deflection and dead zone in mg,
+// 500 mg is about 30 degrees, and the filter time constant in ms
+#define TILT_DEFAULT_FULL_TILT            500
+#define TILT_DEFAULT_DEADZONE             60
+#define TILT_DEFAULT_TAU                  60
+
+// Limits of the configuration
+#define TILT_MIN_FULL_TILT                100
+#define TILT_MAX_FULL_TILT                1000
+#define TILT_MAX_TAU                      1000
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Configuration
+typedef struct
+{
+    uint16_t fullTilt;   // Tilt for full deflection, in mg
+    uint16_t deadzone;   // Tilt ignored around the neutral pose, in mg
+    uint16_t tau;        // Low-pass time constant in ms, 0 for none
+} tiltConfig_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Tilt_init
+ *
+ * @brief   Select the default configuration. The next sample sets the
+ *          neutral pose.
+ *
+ * @return  none
+ */
+void Tilt_init(void);
+
+/*********************************************************************
+ * @fn      Tilt_setConfig
+ *
+ * @brief   Select the configuration. Values beyond the limits are
+ *          clamped, the dead zone to half the full tilt.
+ *
+ * @param   pConfig - configuration
+ *
+ * @return  none
+ */
+void Tilt_setConfig(const tiltConfig_t *pConfig);
+
+/*********************************************************************
+ * @fn      Tilt_getConfig
+ *
+ * @brief   Get the configuration in use.
+ *
+ * @param   pConfig - configuration is copied here
+ *
+ * @return  none
+ */
+void Tilt_getConfig(tiltConfig_t *pConfig);
+
+/*********************************************************************
+ * @fn      Tilt_reset
+ *
+ * @brief   Start over, the next sample sets the neutral pose and the
+ *          filter. Call when a tilt mode is switched on.
+ *
+ * @return  none
+ */
+void Tilt_reset(void);
+
+/*********************************************************************
+ * @fn      Tilt_update
+ *
+ * @brief   Filter a sample of the accelerometer and map the tilt from the
+ *          neutral pose to a direction. The cost does not depend on the
+ *          readings.
+ *
+ * @param   pAdc - ADC readings of the X, Y and Z axes
+ * @param   elapsedMs - time since the previous sample, in ms
+ * @param   pX - X direction, right positive
+ * @param   pY - Y direction, down positive
+ *
+ * @return  none
+ */
+void Tilt_update(const uint16_t *pAdc, uint16_t elapsedMs,
+                 int8_t *pX, int8_t *pY);
+
+/*********************************************************************
+ * @fn      Tilt_fuse
+ *
+ * @brief   Combine the joystick and the tilt direction of a mode. In the
+ *          fuse mode the tilt fills the deflection the joystick leaves.
+ *
+ * @param   mode - TILT_MODE_*
+ * @param   joyX - joystick X, -TILT_AXIS_MAX to TILT_AXIS_MAX
+ * @param   joyY - joystick Y
+ * @param   tiltX - tilt X
+ * @param   tiltY - tilt Y
+ * @param   pX - X direction
+ * @param   pY - Y direction
+ *
+ * @return  none
+ */
+void Tilt_fuse(uint8_t mode, int8_t joyX, int8_t joyY, int8_t tiltX,
+               int8_t tiltY, int8_t *pX, int8_t *pY);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TILT_H */
@@ -49,6 +49,7 @@
  * INCLUDES
  */
 #include <stdbool.h>
+#include <stddef.h>
 #include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Event.h>
 #include <ti/sysbios/knl/Queue.h>
@@ -68,12 +69,34 @@
  * TYPEDEFS
  */
 
-// RTOS queue for profile/app messages.
-typedef struct _queueRec_
+// Message block for profile/app messages. The queue element is the
+// queue link while the message is queued and the free list link while
+// the block is in the pool.
+typedef struct _utilMsgBlock_
 {
   Queue_Elem _elem;          // queue element
-  uint8_t *pData;            // pointer to app data
-} queueRec_t;
+  uint8_t origin;            // UTIL_MSG_ORIGIN_*
+  uintptr_t data[(UTIL_MSG_BLOCK_SIZE + sizeof(uintptr_t) - 1) /
+                 sizeof(uintptr_t)];  // app data, pointer aligned
+} utilMsgBlock_t;
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Where a message block was allocated
+#define UTIL_MSG_ORIGIN_POOL        0
+#define UTIL_MSG_ORIGIN_HEAP        1
+
+// Size of the block header in front of the app data
+#define UTIL_MSG_HDR_SIZE           offsetof(utilMsgBlock_t, data)
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Block holding the app data pMsg
+#define UTIL_MSG_BLOCK(pMsg)        ((utilMsgBlock_t *)((pMsg) - UTIL_MSG_HDR_SIZE))
 
 /*********************************************************************
  * LOCAL FUNCTIONS
@@ -87,6 +110,14 @@ typedef struct _queueRec_
  * LOCAL VARIABLES
  */
 
+// Message pool and its free list, linked through _elem.next.
+static utilMsgBlock_t utilMsgPool[UTIL_MSG_POOL_BLOCKS];
+static utilMsgBlock_t *pUtilMsgFree = NULL;
+static bool utilMsgPoolInit = false;
+
+// Message pool statistics.
+static utilMsgPoolStats_t utilMsgPoolStats = { 0 };
+
 /*********************************************************************
  * PUBLIC FUNCTIONS
  */
@@ -276,52 +307,180 @@ Queue_Handle Util_constructQueue(Queue_Struct *pQueue)
 }
 
 /*********************************************************************
- * @fn      Util_enqueueMsg
+ * @fn      Util_allocMsg
  *
- * @brief   Creates a queue node and puts the node in RTOS queue.
+ * @brief   Allocate a message from the message pool, or from the heap
+ *          if the pool is exhausted or the message does not fit a block.
  *
- * @param   msgQueue - queue handle.
- * @param   event - thread's event processing handle that queue is
- *                associated with.
- * @param   pMsg - pointer to message to be queued
+ * @param   size - message size in bytes
  *
- * @return  TRUE if message was queued, FALSE otherwise.
+ * @return  pointer to the message, NULL if out of memory.
  */
-uint8_t Util_enqueueMsg(Queue_Handle msgQueue,
-                        Event_Handle event,
-                        uint8_t *pMsg)
+uint8_t *Util_allocMsg(uint16_t size)
 {
-  queueRec_t *pRec;
+  utilMsgBlock_t *pBlock = NULL;
+  UInt key;
+
+  if (size <= UTIL_MSG_BLOCK_SIZE)
+  {
+    key = Hwi_disable();
 
-  // Allocated space for queue node.
+    // Build the free list on first use.
+    if (!utilMsgPoolInit)
+    {
+      uint8_t i;
+
+      for (i = 0; i < UTIL_MSG_POOL_BLOCKS; i++)
+      {
+        utilMsgPool[i]._elem.next = (Queue_Elem *)pUtilMsgFree;
+        pUtilMsgFree = &utilMsgPool[i];
+      }
+
+      utilMsgPoolInit = true;
+    }
+
+    if (pUtilMsgFree != NULL)
+    {
+      pBlock = pUtilMsgFree;
+      pUtilMsgFree = (utilMsgBlock_t *)pBlock->_elem.next;
+
+      if (++utilMsgPoolStats.inUse > utilMsgPoolStats.highWater)
+      {
+        utilMsgPoolStats.highWater = utilMsgPoolStats.inUse;
+      }
+    }
+
+    Hwi_restore(key);
+
+    if (pBlock != NULL)
+    {
+      pBlock->origin = UTIL_MSG_ORIGIN_POOL;
+
+      return (uint8_t *)pBlock->data;
+    }
+  }
+
+  // Pool exhausted, fall back to the heap.
 #ifdef USE_ICALL
-  if ((pRec = ICall_malloc(sizeof(queueRec_t))))
+  pBlock = ICall_malloc(UTIL_MSG_HDR_SIZE + size);
 #else
-  if ((pRec = (queueRec_t *)malloc(sizeof(queueRec_t))))
+  pBlock = (utilMsgBlock_t *)malloc(UTIL_MSG_HDR_SIZE + size);
 #endif
+
+  key = Hwi_disable();
+
+  if (pBlock != NULL)
+  {
+    utilMsgPoolStats.fallbacks++;
+  }
+  else
   {
-    pRec->pData = pMsg;
+    utilMsgPoolStats.failures++;
+  }
 
-    // This is an atomic operation
-    Queue_put(msgQueue, &pRec->_elem);
+  Hwi_restore(key);
 
-    // Wake up the application thread event handler.
-    if (event)
-    {
-      Event_post(event, UTIL_QUEUE_EVENT_ID);
-    }
+  if (pBlock == NULL)
+  {
+    return NULL;
+  }
+
+  pBlock->origin = UTIL_MSG_ORIGIN_HEAP;
+
+  return (uint8_t *)pBlock->data;
+}
+
+/*********************************************************************
+ * @fn      Util_freeMsg
+ *
+ * @brief   Free a message allocated with Util_allocMsg.
+ *
+ * @param   pMsg - pointer to message
+ *
+ * @return  none
+ */
+void Util_freeMsg(uint8_t *pMsg)
+{
+  utilMsgBlock_t *pBlock;
 
-    return TRUE;
+  if (pMsg == NULL)
+  {
+    return;
   }
 
-  // Free the message.
+  pBlock = UTIL_MSG_BLOCK(pMsg);
+
+  if (pBlock->origin == UTIL_MSG_ORIGIN_POOL)
+  {
+    UInt key = Hwi_disable();
+
+    pBlock->_elem.next = (Queue_Elem *)pUtilMsgFree;
+    pUtilMsgFree = pBlock;
+    utilMsgPoolStats.inUse--;
+
+    Hwi_restore(key);
+  }
+  else
+  {
 #ifdef USE_ICALL
-  ICall_free(pMsg);
+    ICall_free(pBlock);
 #else
-  free(pMsg);
+    free(pBlock);
 #endif
+  }
+}
 
-  return FALSE;
+/*********************************************************************
+ * @fn      Util_getMsgPoolStats
+ *
+ * @brief   Get the message pool statistics.
+ *
+ * @param   pStats - statistics are copied here
+ *
+ * @return  none
+ */
+void Util_getMsgPoolStats(utilMsgPoolStats_t *pStats)
+{
+  UInt key = Hwi_disable();
+
+  *pStats = utilMsgPoolStats;
+
+  Hwi_restore(key);
+}
+
+/*********************************************************************
+ * @fn      Util_enqueueMsg
+ *
+ * @brief   Puts a message in RTOS queue. The message is linked through
+ *          its own block header, no queue node is allocated.
+ *
+ * @param   msgQueue - queue handle.
+ * @param   event - thread's event processing handle that queue is
+ *                associated with.
+ * @param   pMsg - pointer to message to be queued, allocated with
+ *                 Util_allocMsg
+ *
+ * @return  TRUE if message was queued, FALSE otherwise.
+ */
+uint8_t Util_enqueueMsg(Queue_Handle msgQueue,
+                        Event_Handle event,
+                        uint8_t *pMsg)
+{
+  if (pMsg == NULL)
+  {
+    return FALSE;
+  }
+
+  // This is an atomic operation
+  Queue_put(msgQueue, &UTIL_MSG_BLOCK(pMsg)->_elem);
+
+  // Wake up the application thread event handler.
+  if (event)
+  {
+    Event_post(event, UTIL_QUEUE_EVENT_ID);
+  }
+
+  return TRUE;
 }
 
 /*********************************************************************
@@ -335,21 +494,13 @@ uint8_t Util_enqueueMsg(Queue_Handle msgQueue,
  */
 uint8_t *Util_dequeueMsg(Queue_Handle msgQueue)
 {
-  queueRec_t *pRec = Queue_get(msgQueue);
+  utilMsgBlock_t *pBlock = Queue_get(msgQueue);
 
-  if (pRec != (queueRec_t *)msgQueue)
+  if (pBlock != (utilMsgBlock_t *)msgQueue)
   {
-    uint8_t *pData = pRec->pData;
-
-    // Free the queue node
-    // Note:  this does not free space allocated by data within the node.
-#ifdef USE_ICALL
-    ICall_free(pRec);
-#else
-    free(pRec);
-#endif
-
-    return pData;
+    // The block stays allocated until the message is freed with
+    // Util_freeMsg.
+    return (uint8_t *)pBlock->data;
   }
 
   return NULL;
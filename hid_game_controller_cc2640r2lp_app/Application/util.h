@@ -85,6 +85,21 @@ extern "C" {
  */
 #define UTIL_QUEUE_EVENT_ID Event_Id_30
 
+/**
+ * @brief   Util Message Pool
+ *
+ * Messages passed with Util_enqueueMsg are allocated from a fixed pool of
+ * blocks that carry their own queue link. When the pool is exhausted the
+ * block is taken from the heap instead.
+ */
+#ifndef UTIL_MSG_POOL_BLOCKS
+#define UTIL_MSG_POOL_BLOCKS  8   //!< Number of blocks in the pool
+#endif
+
+#ifndef UTIL_MSG_BLOCK_SIZE
+#define UTIL_MSG_BLOCK_SIZE   20  //!< Payload bytes per block
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -95,10 +110,24 @@ typedef struct
   uint8_t state; // Event state;
 }appEvtHdr_t;
 
+// Message pool statistics.
+typedef struct
+{
+  uint16_t inUse;      // Pool blocks allocated now.
+  uint16_t highWater;  // Most pool blocks ever allocated at once.
+  uint32_t fallbacks;  // Messages taken from the heap.
+  uint32_t failures;   // Messages that could not be allocated at all.
+} utilMsgPoolStats_t;
+
 /*********************************************************************
  * MACROS
  */
 
+/**
+ * @brief   Allocate a message of the given type for Util_enqueueMsg.
+ */
+#define UTIL_ALLOC_MSG(type)  ((type *)Util_allocMsg(sizeof(type)))
+
 /*********************************************************************
  * API FUNCTIONS
  */
@@ -173,14 +202,41 @@ extern void Util_rescheduleClock(Clock_Struct *pClock, uint32_t clockPeriod);
 extern Queue_Handle Util_constructQueue(Queue_Struct *pQueue);
 
 /**
- * @brief   Creates a queue node and puts the node in RTOS queue.
+ * @brief   Allocate a message in constant time. The message comes from
+ *          the message pool, or from the heap if the pool is exhausted
+ *          or the message is larger than UTIL_MSG_BLOCK_SIZE.
+ *
+ * @param   size - message size in bytes
+ *
+ * @return  pointer to the message, NULL if out of memory.
+ */
+extern uint8_t *Util_allocMsg(uint16_t size);
+
+/**
+ * @brief   Free a message allocated with Util_allocMsg.
+ *
+ * @param   pMsg - pointer to message
+ */
+extern void Util_freeMsg(uint8_t *pMsg);
+
+/**
+ * @brief   Get the message pool statistics.
+ *
+ * @param   pStats - statistics are copied here
+ */
+extern void Util_getMsgPoolStats(utilMsgPoolStats_t *pStats);
+
+/**
+ * @brief   Puts a message in RTOS queue, using the queue link of the
+ *          message itself.
  *
  * @param   msgQueue - queue handle.
  *
  * @param   event - the thread's event processing event that this queue is
  *                  associated with.
  *
- * @param   pMsg - pointer to message to be queued
+ * @param   pMsg - pointer to message to be queued, allocated with
+ *                 Util_allocMsg
  *
  * @return  TRUE if message was queued, FALSE otherwise.
  */
@@ -189,7 +245,8 @@ extern uint8_t Util_enqueueMsg(Queue_Handle msgQueue,
                                uint8_t *pMsg);
 
 /**
- * @brief   Dequeue the message from the RTOS queue.
+ * @brief   Dequeue the message from the RTOS queue. The message must be
+ *          freed with Util_freeMsg.
  *
  * @param   msgQueue - queue handle.
  *
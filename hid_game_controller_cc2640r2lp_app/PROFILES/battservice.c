@@ -60,6 +60,7 @@
 
 #include "hiddev.h"
 #include "battservice.h"
+#include "cccdarena.h"
 
 
 /*********************************************************************
@@ -75,6 +76,19 @@
 
 #define BATT_LEVEL_VALUE_LEN        1
 
+// Number of voltage samples in the moving average
+#define BATT_AVG_SAMPLES            8
+
+// Level hysteresis in percent. The reported level follows a falling
+// battery right away but only goes back up after a clear rise, so
+// measurement noise cannot make it toggle.
+#define BATT_LEVEL_HYST_DOWN        1
+#define BATT_LEVEL_HYST_UP          3
+
+// Number of points in the discharge curve
+#define BATT_CURVE_POINTS           (sizeof(battDischargeCurve) / \
+                                     sizeof(battDischargeCurve[0]))
+
 /**
  * GATT Characteristic Descriptions
  */
@@ -84,6 +98,13 @@
  * TYPEDEFS
  */
 
+// Discharge curve point
+typedef struct
+{
+  uint16_t mV;       // Battery voltage in mV
+  uint8_t  percent;  // Remaining capacity at that voltage
+} battCurvePoint_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -126,6 +147,29 @@ static uint16_t battMaxLevel = BATT_MAX_VOLTAGE;
 // Measurement teardown callback.
 static battServiceTeardownCB_t battServiceTeardownCB = NULL;
 
+// Discharge curve of a coin cell under the controller's load, highest
+// voltage first. The level is interpolated between points.
+static CONST battCurvePoint_t battDischargeCurve[] =
+{
+  { BATT_MAX_VOLTAGE, 100 },
+  { 3000,              90 },
+  { 2900,              70 },
+  { 2800,              50 },
+  { 2700,              30 },
+  { 2600,              15 },
+  { 2400,               5 },
+  { 2000,               0 }
+};
+
+// Moving average of the battery voltage (mV).
+static uint16_t battAvgBuf[BATT_AVG_SAMPLES];
+static uint32_t battAvgSum;
+static uint8_t battAvgIdx;
+static uint8_t battAvgSeeded = FALSE;
+
+// Filtered battery voltage (mV).
+static uint16_t battVoltage;
+
 /*********************************************************************
  * Profile Attributes - variables
  */
@@ -134,11 +178,11 @@ static battServiceTeardownCB_t battServiceTeardownCB = NULL;
 static CONST gattAttrType_t battService = { ATT_BT_UUID_SIZE, battServUUID };
 
 // Battery level characteristic.
-static uint8_t battLevelProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static CONST uint8_t battLevelProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
 static uint8_t battLevel = 100;
 
 // Characteristic Presentation Format of the Battery Level Characteristic.
-static gattCharFormat_t battLevelPresentation = {
+static CONST gattCharFormat_t battLevelPresentation = {
   GATT_FORMAT_UINT8,           /* format */
   0,                           /* exponent */
   GATT_UNIT_PERCENTAGE_UUID,   /* unit */
@@ -149,7 +193,7 @@ static gattCharFormat_t battLevelPresentation = {
 static gattCharCfg_t *battLevelClientCharCfg;
 
 // HID Report Reference characteristic descriptor, battery level.
-static uint8_t hidReportRefBattLevel[HID_REPORT_REF_LEN] =
+static CONST uint8_t hidReportRefBattLevel[HID_REPORT_REF_LEN] =
              { HID_RPT_ID_BATT_LEVEL_IN, HID_REPORT_TYPE_INPUT };
 
 /*********************************************************************
@@ -171,7 +215,7 @@ static gattAttribute_t battAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &battLevelProps
+      (uint8_t *)&battLevelProps
     },
 
       // Battery Level Value
@@ -195,7 +239,7 @@ static gattAttribute_t battAttrTbl[] =
         { ATT_BT_UUID_SIZE, reportRefUUID },
         GATT_PERMIT_READ,
         0,
-        hidReportRefBattLevel
+        (uint8_t *)hidReportRefBattLevel
       },
 
       // Characteristic Presentation format
@@ -219,7 +263,9 @@ static bStatus_t battWriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
                                  uint8 method );
 
 static void battNotify(uint16_t connHandle);
-static uint8_t battMeasure(void);
+static uint16_t battMeasure(void);
+static uint16_t battFilter(uint16_t mV);
+static uint8_t battVoltageToLevel(uint16_t mV);
 static void battNotifyLevel(void);
 
 /*********************************************************************
@@ -256,9 +302,8 @@ bStatus_t Batt_AddService(void)
 {
   uint8_t status;
 
-  // Allocate Client Characteristic Configuration table
-  battLevelClientCharCfg = (gattCharCfg_t *)ICall_malloc( sizeof(gattCharCfg_t) *
-                                                          linkDBNumConns );
+  // Take the Client Characteristic Configuration table from the arena
+  battLevelClientCharCfg = CccdArena_alloc();
   if ( battLevelClientCharCfg == NULL )
   {
     return ( bleMemAllocError );
@@ -357,6 +402,10 @@ bStatus_t Batt_GetParameter(uint8_t param, void *value)
       *((uint8*)value) = battCriticalLevel;
       break;
 
+    case BATT_PARAM_VOLTAGE:
+      *((uint16*)value) = battVoltage;
+      break;
+
     case BATT_PARAM_SERVICE_HANDLE:
       *((uint16*)value) = GATT_SERVICE_HANDLE(battAttrTbl);
       break;
@@ -384,26 +433,34 @@ bStatus_t Batt_GetParameter(uint8_t param, void *value)
 /*********************************************************************
  * @fn          Batt_MeasLevel
  *
- * @brief       Measure the battery level and update the battery
- *              level value in the service characteristics.  If
- *              the battery level-state characteristic is configured
- *              for notification and the battery level has changed
- *              since the last measurement, then a notification
- *              will be sent.
+ * @brief       Take one battery voltage sample, filter it and update
+ *              the cached battery level.  The level moves down by
+ *              BATT_LEVEL_HYST_DOWN and up by BATT_LEVEL_HYST_UP
+ *              percent at least; every change is notified.
  *
  * @return      Success
  */
 bStatus_t Batt_MeasLevel(void)
 {
-  uint16_t level;
+  uint8_t level;
+
+  // The AON battery monitor converts continuously in the background, only
+  // its last result is read here. Nothing to do if it has not updated.
+  if (battAvgSeeded && !AONBatMonNewBatteryMeasureReady())
+  {
+    return SUCCESS;
+  }
 
-  level = battMeasure();
+  battVoltage = battFilter(battMeasure());
+  level = battVoltageToLevel(battVoltage);
 
-  // If level has gone down
-  if (level < battLevel)
+  // Falling below the critical level is always reported
+  if ((level + BATT_LEVEL_HYST_DOWN <= battLevel) ||
+      (level >= battLevel + BATT_LEVEL_HYST_UP) ||
+      ((level < battCriticalLevel) && (battLevel >= battCriticalLevel)))
   {
     // Update level
-    battLevel = (uint8)(level & 0x00FF);
+    battLevel = level;
 
     // Send a notification
     battNotifyLevel();
@@ -463,20 +520,9 @@ static bStatus_t battReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
 
   uint16_t uuid = BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
 
-  // Measure battery level if reading level
+  // Return the cached level, it is kept up to date by Batt_MeasLevel
   if (uuid == BATT_LEVEL_UUID)
   {
-    uint8_t level;
-
-    level = battMeasure();
-
-    // If level has gone down
-    if (level < battLevel)
-    {
-      // Update level
-      battLevel = level;
-    }
-
     *pLen = 1;
     pValue[0] = battLevel;
   }
@@ -576,14 +622,14 @@ static void battNotify(uint16_t connHandle)
 /*********************************************************************
  * @fn      battMeasure
  *
- * @brief   Measure the battery level with the ADC and return
- *          it as a percentage 0-100%.
+ * @brief   Read the last battery voltage conversion of the AON
+ *          battery monitor.
  *
- * @return  Battery level.
+ * @return  Battery voltage in mV.
  */
-static uint8_t battMeasure(void)
+static uint16_t battMeasure(void)
 {
-  uint32_t percent;
+  uint32_t mV;
 
   // Call measurement setup callback
   if (battServiceSetupCB != NULL)
@@ -592,16 +638,14 @@ static uint8_t battMeasure(void)
   }
 
   // Read the battery voltage (V), only the first 12 bits
-  percent = AONBatMonBatteryVoltageGet();
+  mV = AONBatMonBatteryVoltageGet();
 
   // Convert to from V to mV to avoid fractions.
   // Fractional part is in the lower 8 bits thus converting is done as follows:
   // (1/256)/(1/1000) = 1000/256 = 125/32
   // This is done most effectively by multiplying by 125 and then shifting
   // 5 bits to the right.
-  percent = (percent * 125) >> 5;
-  // Convert to percentage of maximum voltage.
-  percent = ((percent* 100) / battMaxLevel);
+  mV = (mV * 125) >> 5;
 
   // Call measurement teardown callback
   if (battServiceTeardownCB != NULL)
@@ -609,7 +653,85 @@ static uint8_t battMeasure(void)
     battServiceTeardownCB();
   }
 
-  return percent;
+  return (uint16_t)mV;
+}
+
+/*********************************************************************
+ * @fn      battFilter
+ *
+ * @brief   Add a voltage sample to the moving average. The first
+ *          sample fills the whole window.
+ *
+ * @param   mV - battery voltage sample in mV
+ *
+ * @return  Averaged battery voltage in mV.
+ */
+static uint16_t battFilter(uint16_t mV)
+{
+  uint8_t i;
+
+  if (!battAvgSeeded)
+  {
+    for (i = 0; i < BATT_AVG_SAMPLES; i++)
+    {
+      battAvgBuf[i] = mV;
+    }
+
+    battAvgSum = (uint32_t)mV * BATT_AVG_SAMPLES;
+    battAvgIdx = 0;
+    battAvgSeeded = TRUE;
+  }
+  else
+  {
+    battAvgSum -= battAvgBuf[battAvgIdx];
+    battAvgSum += mV;
+    battAvgBuf[battAvgIdx] = mV;
+
+    if (++battAvgIdx == BATT_AVG_SAMPLES)
+    {
+      battAvgIdx = 0;
+    }
+  }
+
+  return (uint16_t)(battAvgSum / BATT_AVG_SAMPLES);
+}
+
+/*********************************************************************
+ * @fn      battVoltageToLevel
+ *
+ * @brief   Convert a battery voltage to a percentage 0-100% using the
+ *          discharge curve. Voltages at or above the maximum set with
+ *          Batt_Setup are 100%.
+ *
+ * @param   mV - battery voltage in mV
+ *
+ * @return  Battery level.
+ */
+static uint8_t battVoltageToLevel(uint16_t mV)
+{
+  uint8_t i;
+
+  if (mV >= battMaxLevel || mV >= battDischargeCurve[0].mV)
+  {
+    return 100;
+  }
+
+  for (i = 1; i < BATT_CURVE_POINTS; i++)
+  {
+    const battCurvePoint_t *pHi = &battDischargeCurve[i - 1];
+    const battCurvePoint_t *pLo = &battDischargeCurve[i];
+
+    if (mV >= pLo->mV)
+    {
+      // Linear interpolation between the two points
+      return pLo->percent +
+             (uint8_t)(((uint32_t)(mV - pLo->mV) *
+                        (pHi->percent - pLo->percent)) /
+                       (pHi->mV - pLo->mV));
+    }
+  }
+
+  return 0;
 }
 
 /*********************************************************************
@@ -623,6 +745,13 @@ static uint8_t battMeasure(void)
 static void battNotifyLevel(void)
 {
   uint8_t i;
+
+  // Service not added yet
+  if (battLevelClientCharCfg == NULL)
+  {
+    return;
+  }
+
   for (i = 0; i < linkDBNumConns; i++)
   {
     uint16_t connHandle = battLevelClientCharCfg[i].connHandle;
@@ -69,6 +69,7 @@ extern "C"
 #define BATT_PARAM_CRITICAL_LEVEL       1
 #define BATT_PARAM_SERVICE_HANDLE       2
 #define BATT_PARAM_BATT_LEVEL_IN_REPORT 3
+#define BATT_PARAM_VOLTAGE              4  // Filtered voltage in mV, uint16
 
 // Callback events
 #define BATT_LEVEL_NOTI_ENABLED         1
@@ -158,12 +159,12 @@ extern bStatus_t Batt_GetParameter(uint8 param, void *value);
 /*********************************************************************
  * @fn          Batt_MeasLevel
  *
- * @brief       Measure the battery level and update the battery
- *              level value in the service characteristics.  If
- *              the battery level-state characteristic is configured
- *              for notification and the battery level has changed
- *              since the last measurement, then a notification
- *              will be sent.
+ * @brief       Take one battery voltage sample and update the cached
+ *              battery level through a moving average, the discharge
+ *              curve and hysteresis.  If the battery level-state
+ *              characteristic is configured for notification and the
+ *              level has changed, then a notification will be sent.
+ *              Reads of the characteristic return the cached level.
  *
  * @return      Success or Failure
  */
@@ -0,0 +1,78 @@
+/******************************************************************************
+
+ @file       cccdarena.c
+
+ @brief This file contains the CCCD arena. The Client Characteristic
+        Configuration tables of all services are taken from one static
+        array sized by the service list in cccdarena.h, so they cost no
+        heap block headers, cannot fail at run time once the list is
+        right and do not fragment the heap shared with the stack.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Static arena for the Client Characteristic
+                        Configuration tables of all services, sized at build
+                        time instead of allocated from the heap.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <icall.h>
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "cccdarena.h"
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+// Link DB maximum number of connections, set by the GAP Role
+extern uint8 linkDBNumConns;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static gattCharCfg_t cccdArena[CCCD_ARENA_NUM_CCCDS * CCCD_ARENA_MAX_CONNS];
+
+// Entries handed out
+static uint16 cccdArenaUsed = 0;
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      CccdArena_alloc
+ *
+ * @brief   Take a CCCD table of linkDBNumConns entries from the arena.
+ *
+ * @return  pointer to the table, NULL if the arena is exhausted or
+ *          linkDBNumConns exceeds CCCD_ARENA_MAX_CONNS
+ */
+gattCharCfg_t *CccdArena_alloc(void)
+{
+  gattCharCfg_t *pTable;
+
+  if ((linkDBNumConns > CCCD_ARENA_MAX_CONNS) ||
+      ((cccdArenaUsed + linkDBNumConns) >
+       (CCCD_ARENA_NUM_CCCDS * CCCD_ARENA_MAX_CONNS)))
+  {
+    return (NULL);
+  }
+
+  pTable = &cccdArena[cccdArenaUsed];
+  cccdArenaUsed += linkDBNumConns;
+
+  return (pTable);
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,102 @@
+/******************************************************************************
+
+ @file       cccdarena.h
+
+ @brief This file contains the CCCD arena definitions and prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Static arena for the Client Characteristic
+                        Configuration tables of all services, sized at build
+                        time instead of allocated from the heap.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef CCCDARENA_H
+#define CCCDARENA_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+// Stack configuration, MAX_NUM_BLE_CONNS
+#include "ble_user_config.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// CCCDs of each service. Update the list when a service adds or removes a
+// notifying characteristic, the arena is sized from it.
+#define CCCD_ARENA_HIDKBD             6  // Key, gamepad, consumer and mouse
+                                         // input, boot key, boot mouse
+#define CCCD_ARENA_BATT               1  // Battery level
+#define CCCD_ARENA_SCANPARAM          1  // Scan refresh
+// Link quality and memory, and the input trace and the profile when built
+#ifdef INPUT_TRACE
+#define CCCD_ARENA_DIAG_TRACE         1
+#else
+#define CCCD_ARENA_DIAG_TRACE         0
+#endif // INPUT_TRACE
+#ifdef PROF_PROBES
+#define CCCD_ARENA_DIAG_PROFILE       1
+#else
+#define CCCD_ARENA_DIAG_PROFILE       0
+#endif // PROF_PROBES
+#define CCCD_ARENA_DIAG               (2 + CCCD_ARENA_DIAG_TRACE + \
+                                       CCCD_ARENA_DIAG_PROFILE)
+
+#define CCCD_ARENA_NUM_CCCDS          (CCCD_ARENA_HIDKBD    + \
+                                       CCCD_ARENA_BATT      + \
+                                       CCCD_ARENA_SCANPARAM + \
+                                       CCCD_ARENA_DIAG)
+
+// Connections each CCCD table holds, must cover linkDBNumConns
+#ifndef CCCD_ARENA_MAX_CONNS
+  #ifdef MAX_NUM_BLE_CONNS
+    #define CCCD_ARENA_MAX_CONNS      MAX_NUM_BLE_CONNS
+  #else
+    #error "MAX_NUM_BLE_CONNS undefined, define CCCD_ARENA_MAX_CONNS"
+  #endif
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      CccdArena_alloc
+ *
+ * @brief   Take a CCCD table of linkDBNumConns entries from the arena.
+ *          Tables are taken once when a service is added and never
+ *          returned.
+ *
+ * @return  pointer to the table, NULL if the arena is exhausted or
+ *          linkDBNumConns exceeds CCCD_ARENA_MAX_CONNS
+ */
+extern gattCharCfg_t *CccdArena_alloc(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CCCDARENA_H */
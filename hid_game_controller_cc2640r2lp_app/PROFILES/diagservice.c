@@ -0,0 +1,624 @@
+/******************************************************************************
+
+ @file       diagservice.c
+
+ @brief This file contains the Diagnostic service.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Vendor specific diagnostic service used to expose
+                        run-time statistics of the game controller.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include <icall.h>
+#include "util.h"
+/* This Header file contains all BLE API and icall structure definition */
+#include "icall_ble_api.h"
+
+#include "diagservice.h"
+#include "cccdarena.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Position of the characteristic values in the attribute array
+#define DIAG_LINK_QUALITY_VALUE_IDX       2
+#define DIAG_MEMORY_VALUE_IDX             5
+#define DIAG_TRACE_VALUE_IDX              8
+#ifdef INPUT_TRACE
+#define DIAG_PROFILE_VALUE_IDX            11
+#else
+#define DIAG_PROFILE_VALUE_IDX            8
+#endif // INPUT_TRACE
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+// Diagnostic service
+CONST uint8 diagServUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(DIAG_SERV_UUID), HI_UINT16(DIAG_SERV_UUID)
+};
+
+// Link quality characteristic
+CONST uint8 diagLinkQualityUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(DIAG_LINK_QUALITY_UUID), HI_UINT16(DIAG_LINK_QUALITY_UUID)
+};
+
+// Memory characteristic
+CONST uint8 diagMemoryUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(DIAG_MEMORY_UUID), HI_UINT16(DIAG_MEMORY_UUID)
+};
+
+#ifdef INPUT_TRACE
+// Input trace characteristic
+CONST uint8 diagTraceUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(DIAG_TRACE_UUID), HI_UINT16(DIAG_TRACE_UUID)
+};
+#endif // INPUT_TRACE
+
+#ifdef PROF_PROBES
+// Profile characteristic
+CONST uint8 diagProfileUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(DIAG_PROFILE_UUID), HI_UINT16(DIAG_PROFILE_UUID)
+};
+#endif // PROF_PROBES
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+/*********************************************************************
+ * Profile Attributes - variables
+ */
+
+// Diagnostic Service attribute
+static CONST gattAttrType_t diagService = { ATT_BT_UUID_SIZE, diagServUUID };
+
+// Link quality characteristic
+static CONST uint8 diagLinkQualityProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static uint8 diagLinkQuality[DIAG_LINK_QUALITY_LEN];
+static gattCharCfg_t *diagLinkQualityClientCharCfg;
+
+// Memory characteristic
+static CONST uint8 diagMemoryProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static uint8 diagMemory[DIAG_MEMORY_LEN];
+static gattCharCfg_t *diagMemoryClientCharCfg;
+
+#ifdef INPUT_TRACE
+// Input trace characteristic, the last piece notified
+static CONST uint8 diagTraceProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static uint8 diagTrace[DIAG_TRACE_MAX_LEN];
+static uint8 diagTraceLen = 0;
+static gattCharCfg_t *diagTraceClientCharCfg;
+#endif // INPUT_TRACE
+
+#ifdef PROF_PROBES
+// Profile characteristic, the last probe record notified
+static CONST uint8 diagProfileProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static uint8 diagProfile[DIAG_PROFILE_LEN];
+static gattCharCfg_t *diagProfileClientCharCfg;
+#endif // PROF_PROBES
+
+/*********************************************************************
+ * Profile Attributes - Table
+ */
+
+static gattAttribute_t diagAttrTbl[] =
+{
+  // Diagnostic Service
+  {
+    { ATT_BT_UUID_SIZE, primaryServiceUUID }, /* type */
+    GATT_PERMIT_READ,                         /* permissions */
+    0,                                        /* handle */
+    (uint8 *)&diagService                     /* pValue */
+  },
+
+    // Link Quality Declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      (uint8 *)&diagLinkQualityProps
+    },
+
+      // Link Quality Value
+      {
+        { ATT_BT_UUID_SIZE, diagLinkQualityUUID },
+        GATT_PERMIT_ENCRYPT_READ,
+        0,
+        diagLinkQuality
+      },
+
+      // Link Quality Client Characteristic Configuration
+      {
+        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        (uint8 *) &diagLinkQualityClientCharCfg
+      },
+
+    // Memory Declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      (uint8 *)&diagMemoryProps
+    },
+
+      // Memory Value
+      {
+        { ATT_BT_UUID_SIZE, diagMemoryUUID },
+        GATT_PERMIT_ENCRYPT_READ,
+        0,
+        diagMemory
+      },
+
+      // Memory Client Characteristic Configuration
+      {
+        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        (uint8 *) &diagMemoryClientCharCfg
+      },
+
+#ifdef INPUT_TRACE
+    // Trace Declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      (uint8 *)&diagTraceProps
+    },
+
+      // Trace Value
+      {
+        { ATT_BT_UUID_SIZE, diagTraceUUID },
+        GATT_PERMIT_ENCRYPT_READ,
+        0,
+        diagTrace
+      },
+
+      // Trace Client Characteristic Configuration
+      {
+        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        (uint8 *) &diagTraceClientCharCfg
+      },
+#endif // INPUT_TRACE
+
+#ifdef PROF_PROBES
+    // Profile Declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      (uint8 *)&diagProfileProps
+    },
+
+      // Profile Value
+      {
+        { ATT_BT_UUID_SIZE, diagProfileUUID },
+        GATT_PERMIT_ENCRYPT_READ,
+        0,
+        diagProfile
+      },
+
+      // Profile Client Characteristic Configuration
+      {
+        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        (uint8 *) &diagProfileClientCharCfg
+      },
+#endif // PROF_PROBES
+};
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bStatus_t diagReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                uint8_t *pValue, uint16_t *pLen,
+                                uint16_t offset, uint16_t maxLen,
+                                uint8_t method);
+static bStatus_t diagWriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                 uint8_t *pValue, uint16_t len,
+                                 uint16_t offset, uint8_t method);
+
+static uint8 diagNotifyAll(gattCharCfg_t *pCharCfg, uint8 valueIdx,
+                           uint8 *pValue, uint8 len);
+
+/*********************************************************************
+ * PROFILE CALLBACKS
+ */
+// Diagnostic Service Callbacks
+// Note: When an operation on a characteristic requires authorization and
+// pfnAuthorizeAttrCB is not defined for that characteristic's service, the
+// Stack will report a status of ATT_ERR_UNLIKELY to the client.  When an
+// operation on a characteristic requires authorization the Stack will call
+// pfnAuthorizeAttrCB to check a client's authorization prior to calling
+// pfnReadAttrCB or pfnWriteAttrCB, so no checks for authorization need to be
+// made within these functions.
+CONST gattServiceCBs_t diagCBs =
+{
+  diagReadAttrCB,  // Read callback function pointer
+  diagWriteAttrCB, // Write callback function pointer
+  NULL             // Authorization callback function pointer
+};
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Diag_AddService
+ *
+ * @brief   Initializes the Diagnostic Service by registering
+ *          GATT attributes with the GATT server.
+ *
+ * @return  Success or Failure
+ */
+bStatus_t Diag_AddService(void)
+{
+  uint8 status;
+
+  // Take the Client Characteristic Configuration tables from the arena
+  diagLinkQualityClientCharCfg = CccdArena_alloc();
+  diagMemoryClientCharCfg = CccdArena_alloc();
+
+  if ((diagLinkQualityClientCharCfg == NULL) ||
+      (diagMemoryClientCharCfg == NULL))
+  {
+    return (bleMemAllocError);
+  }
+
+#ifdef INPUT_TRACE
+  diagTraceClientCharCfg = CccdArena_alloc();
+
+  if (diagTraceClientCharCfg == NULL)
+  {
+    return (bleMemAllocError);
+  }
+
+  GATTServApp_InitCharCfg(INVALID_CONNHANDLE, diagTraceClientCharCfg);
+#endif // INPUT_TRACE
+
+#ifdef PROF_PROBES
+  diagProfileClientCharCfg = CccdArena_alloc();
+
+  if (diagProfileClientCharCfg == NULL)
+  {
+    return (bleMemAllocError);
+  }
+
+  GATTServApp_InitCharCfg(INVALID_CONNHANDLE, diagProfileClientCharCfg);
+#endif // PROF_PROBES
+
+  // Initialize Client Characteristic Configuration attributes
+  GATTServApp_InitCharCfg(INVALID_CONNHANDLE, diagLinkQualityClientCharCfg);
+  GATTServApp_InitCharCfg(INVALID_CONNHANDLE, diagMemoryClientCharCfg);
+
+  // Register GATT attribute list and CBs with GATT Server App
+  status = GATTServApp_RegisterService(diagAttrTbl,
+                                       GATT_NUM_ATTRS(diagAttrTbl),
+                                       GATT_MAX_ENCRYPT_KEY_SIZE,
+                                       &diagCBs);
+
+  return (status);
+}
+
+/*********************************************************************
+ * @fn      Diag_SetParameter
+ *
+ * @brief   Set a Diagnostic Service parameter.
+ *
+ * @param   param - Profile parameter ID
+ * @param   len - length of data to write
+ * @param   value - pointer to data to write.
+ *
+ * @return  bStatus_t
+ */
+bStatus_t Diag_SetParameter(uint8 param, uint8 len, void *value)
+{
+  bStatus_t ret = SUCCESS;
+
+  switch (param)
+  {
+    case DIAG_PARAM_LINK_QUALITY:
+      if (len == DIAG_LINK_QUALITY_LEN)
+      {
+        memcpy(diagLinkQuality, value, DIAG_LINK_QUALITY_LEN);
+
+        diagNotifyAll(diagLinkQualityClientCharCfg, DIAG_LINK_QUALITY_VALUE_IDX,
+                      diagLinkQuality, DIAG_LINK_QUALITY_LEN);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case DIAG_PARAM_MEMORY:
+      if (len == DIAG_MEMORY_LEN)
+      {
+        memcpy(diagMemory, value, DIAG_MEMORY_LEN);
+
+        diagNotifyAll(diagMemoryClientCharCfg, DIAG_MEMORY_VALUE_IDX,
+                      diagMemory, DIAG_MEMORY_LEN);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+#ifdef INPUT_TRACE
+    case DIAG_PARAM_TRACE:
+      if ((len > 0) && (len <= DIAG_TRACE_MAX_LEN))
+      {
+        memcpy(diagTrace, value, len);
+        diagTraceLen = len;
+
+        // The trace is drained, a piece no client took must be sent again
+        if (diagNotifyAll(diagTraceClientCharCfg, DIAG_TRACE_VALUE_IDX,
+                          diagTrace, len) == 0)
+        {
+          ret = bleNoResources;
+        }
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+#endif // INPUT_TRACE
+
+#ifdef PROF_PROBES
+    case DIAG_PARAM_PROFILE:
+      if (len == DIAG_PROFILE_LEN)
+      {
+        memcpy(diagProfile, value, DIAG_PROFILE_LEN);
+
+        diagNotifyAll(diagProfileClientCharCfg, DIAG_PROFILE_VALUE_IDX,
+                      diagProfile, DIAG_PROFILE_LEN);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+#endif // PROF_PROBES
+
+    default:
+      ret = INVALIDPARAMETER;
+      break;
+  }
+
+  return (ret);
+}
+
+/*********************************************************************
+ * @fn      Diag_GetParameter
+ *
+ * @brief   Get a Diagnostic Service parameter.
+ *
+ * @param   param - Profile parameter ID
+ * @param   value - pointer to data to get.
+ *
+ * @return  bStatus_t
+ */
+bStatus_t Diag_GetParameter(uint8 param, void *value)
+{
+  bStatus_t ret = SUCCESS;
+
+  switch (param)
+  {
+    case DIAG_PARAM_LINK_QUALITY:
+      memcpy(value, diagLinkQuality, DIAG_LINK_QUALITY_LEN);
+      break;
+
+    case DIAG_PARAM_MEMORY:
+      memcpy(value, diagMemory, DIAG_MEMORY_LEN);
+      break;
+
+#ifdef INPUT_TRACE
+    case DIAG_PARAM_TRACE:
+      memcpy(value, diagTrace, diagTraceLen);
+      break;
+#endif // INPUT_TRACE
+
+#ifdef PROF_PROBES
+    case DIAG_PARAM_PROFILE:
+      memcpy(value, diagProfile, DIAG_PROFILE_LEN);
+      break;
+#endif // PROF_PROBES
+
+    default:
+      ret = INVALIDPARAMETER;
+      break;
+  }
+
+  return (ret);
+}
+
+/*********************************************************************
+ * @fn          diagReadAttrCB
+ *
+ * @brief       Read an attribute.
+ *
+ * @param       connHandle - connection message was received on
+ * @param       pAttr - pointer to attribute
+ * @param       pValue - pointer to data to be read
+ * @param       pLen - length of data to be read
+ * @param       offset - offset of the first octet to be read
+ * @param       maxLen - maximum length of data to be read
+ * @param       method - type of read message
+ *
+ * @return      SUCCESS, blePending or Failure
+ */
+static bStatus_t diagReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                uint8_t *pValue, uint16_t *pLen,
+                                uint16_t offset, uint16_t maxLen,
+                                uint8_t method)
+{
+  bStatus_t status = SUCCESS;
+
+  // Make sure it's not a blob operation (no attributes in the profile are long)
+  if (offset > 0)
+  {
+    return (ATT_ERR_ATTR_NOT_LONG);
+  }
+
+  uint16_t uuid = BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
+
+  if (uuid == DIAG_LINK_QUALITY_UUID)
+  {
+    *pLen = MIN(maxLen, DIAG_LINK_QUALITY_LEN);
+    memcpy(pValue, pAttr->pValue, *pLen);
+  }
+  else if (uuid == DIAG_MEMORY_UUID)
+  {
+    *pLen = MIN(maxLen, DIAG_MEMORY_LEN);
+    memcpy(pValue, pAttr->pValue, *pLen);
+  }
+#ifdef INPUT_TRACE
+  else if (uuid == DIAG_TRACE_UUID)
+  {
+    *pLen = MIN(maxLen, diagTraceLen);
+    memcpy(pValue, pAttr->pValue, *pLen);
+  }
+#endif // INPUT_TRACE
+#ifdef PROF_PROBES
+  else if (uuid == DIAG_PROFILE_UUID)
+  {
+    *pLen = MIN(maxLen, DIAG_PROFILE_LEN);
+    memcpy(pValue, pAttr->pValue, *pLen);
+  }
+#endif // PROF_PROBES
+  else
+  {
+    status = ATT_ERR_ATTR_NOT_FOUND;
+  }
+
+  return (status);
+}
+
+/*********************************************************************
+ * @fn      diagWriteAttrCB
+ *
+ * @brief   Validate attribute data prior to a write operation
+ *
+ * @param   connHandle - connection message was received on
+ * @param   pAttr - pointer to attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ * @param   method - type of write message
+ *
+ * @return  SUCCESS, blePending or Failure
+ */
+static bStatus_t diagWriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                 uint8_t *pValue, uint16_t len,
+                                 uint16_t offset, uint8_t method)
+{
+  bStatus_t status;
+
+  uint16_t uuid = BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
+
+  if (uuid == GATT_CLIENT_CHAR_CFG_UUID)
+  {
+    status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
+                                            offset, GATT_CLIENT_CFG_NOTIFY);
+  }
+  else
+  {
+    status = ATT_ERR_ATTR_NOT_FOUND;
+  }
+
+  return (status);
+}
+
+/*********************************************************************
+ * @fn      diagNotifyAll
+ *
+ * @brief   Send a notification of a diagnostic characteristic to every
+ *          connection that enabled it.
+ *
+ * @param   pCharCfg - client characteristic configuration table
+ * @param   valueIdx - index of the characteristic value in diagAttrTbl
+ * @param   pValue   - characteristic value
+ * @param   len      - characteristic value length
+ *
+ * @return  Number of connections the notification was sent to
+ */
+static uint8 diagNotifyAll(gattCharCfg_t *pCharCfg, uint8 valueIdx,
+                           uint8 *pValue, uint8 len)
+{
+  uint8_t sent = 0;
+  uint8_t i;
+
+  for (i = 0; i < linkDBNumConns; i++)
+  {
+    uint16_t connHandle = pCharCfg[i].connHandle;
+
+    if ((connHandle != INVALID_CONNHANDLE) &&
+        (GATTServApp_ReadCharCfg(connHandle, pCharCfg) & GATT_CLIENT_CFG_NOTIFY))
+    {
+      attHandleValueNoti_t noti;
+
+      noti.pValue = GATT_bm_alloc(connHandle, ATT_HANDLE_VALUE_NOTI, len, NULL);
+      if (noti.pValue != NULL)
+      {
+        noti.handle = diagAttrTbl[valueIdx].handle;
+        noti.len = len;
+        memcpy(noti.pValue, pValue, len);
+
+        if (GATT_Notification(connHandle, &noti, FALSE) == SUCCESS)
+        {
+          sent++;
+        }
+        else
+        {
+          GATT_bm_free((gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI);
+        }
+      }
+    }
+  }
+
+  return (sent);
+}
+
+/*********************************************************************
+*********************************************************************/
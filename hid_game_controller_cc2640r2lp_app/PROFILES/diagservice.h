@@ -0,0 +1,117 @@
+/******************************************************************************
+
+ @file       diagservice.h
+
+ @brief This file contains the Diagnostic service definitions and
+        prototypes.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Vendor specific diagnostic service used to expose
+                        run-time statistics of the game controller.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef DIAGSERVICE_H
+#define DIAGSERVICE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Diagnostic Service UUIDs (vendor specific, 16-bit)
+#define DIAG_SERV_UUID                  0xFFB0
+#define DIAG_LINK_QUALITY_UUID          0xFFB1
+#define DIAG_MEMORY_UUID                0xFFB2
+#define DIAG_TRACE_UUID                 0xFFB3
+#define DIAG_PROFILE_UUID               0xFFB4
+
+// Diagnostic Service Get/Set Parameters
+#define DIAG_PARAM_LINK_QUALITY         0
+#define DIAG_PARAM_MEMORY               1
+#define DIAG_PARAM_TRACE                2   // INPUT_TRACE builds only
+#define DIAG_PARAM_PROFILE              3   // PROF_PROBES builds only
+
+// Diagnostic characteristic value lengths
+#define DIAG_LINK_QUALITY_LEN           12
+#define DIAG_MEMORY_LEN                 20
+#define DIAG_PROFILE_LEN                19
+
+// Longest trace piece, the trace characteristic has a variable length
+#define DIAG_TRACE_MAX_LEN              20
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * Profile Callbacks
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Diag_AddService
+ *
+ * @brief   Initializes the Diagnostic service by registering
+ *          GATT attributes with the GATT server.
+ *
+ * @return  Success or Failure
+ */
+extern bStatus_t Diag_AddService(void);
+
+/*********************************************************************
+ * @fn      Diag_SetParameter
+ *
+ * @brief   Set a Diagnostic Service parameter. The new value is
+ *          notified to every connected client that enabled
+ *          notifications for it.
+ *
+ * @param   param - Profile parameter ID
+ * @param   len - length of data to write
+ * @param   value - pointer to data to write.
+ *
+ * @return  bStatus_t, for DIAG_PARAM_TRACE bleNoResources when no client
+ *          took the notification
+ */
+extern bStatus_t Diag_SetParameter(uint8 param, uint8 len, void *value);
+
+/*********************************************************************
+ * @fn      Diag_GetParameter
+ *
+ * @brief   Get a Diagnostic Service parameter.
+ *
+ * @param   param - Profile parameter ID
+ * @param   value - pointer to data to get.
+ *
+ * @return  bStatus_t
+ */
+extern bStatus_t Diag_GetParameter(uint8 param, void *value);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DIAGSERVICE_H */
@@ -54,12 +54,14 @@
 
 #include <xdc/runtime/Error.h>
 #include <xdc/runtime/System.h>
+#include <xdc/runtime/Timestamp.h>
 
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Task.h>
 #include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Event.h>
 #include <ti/sysbios/knl/Queue.h>
+#include <ti/sysbios/hal/Hwi.h>
 
 #include <icall.h>
 #include "util.h"
@@ -73,7 +75,9 @@
 #include "peripheral.h"
 
 #include "hiddev.h"
-#include "hidgamecontroller.h"
+#include "hidreportmap.h"
+#include "inputtrace.h"
+#include "profprobe.h"
 
 /*********************************************************************
  * MACROS
@@ -93,6 +97,10 @@
 #define HID_LOW_ADV_INT_MIN                   1600
 #define HID_LOW_ADV_INT_MAX                   1600
 
+// Range of the advertising intervals.
+#define HID_ADV_INT_MIN                       32
+#define HID_ADV_INT_MAX                       16384
+
 // Advertising timeouts in sec.
 #define HID_INITIAL_ADV_TIMEOUT               60
 #define HID_HIGH_ADV_TIMEOUT                  5
@@ -108,7 +116,15 @@
 #define HID_BATT_SERVICE_EVT                  0x0002
 #define HID_PASSCODE_EVT                      0x0004
 #define HID_PAIR_STATE_EVT                    0x0008
-
+#define HID_PROTOCOL_MODE_EVT                 0x0010
+
+#ifdef HID_DEV_SINGLE_TASK
+// HID Service Events, posted to the event of the application task.
+#define HID_QUEUE_EVT                         HID_DEV_QUEUE_EVT
+#define HID_BATT_PERIODIC_EVT                 HID_DEV_BATT_PERIODIC_EVT
+#define HID_IDLE_EVT                          HID_DEV_IDLE_EVT
+#define HID_SEND_REPORT_EVT                   HID_DEV_SEND_REPORT_EVT
+#else
 // HID Service Task Events.
 #define HID_ICALL_EVT                         ICALL_MSG_EVENT_ID // Event_Id_31
 #define HID_QUEUE_EVT                         UTIL_QUEUE_EVENT_ID // Event_Id_30
@@ -121,20 +137,24 @@
                                                HID_BATT_PERIODIC_EVT | \
                                                HID_IDLE_EVT          | \
                                                HID_SEND_REPORT_EVT)
+#endif // HID_DEV_SINGLE_TASK
 
 #define reportQEmpty()                        (firstQIdx == lastQIdx)
 
+#ifndef HID_DEV_SINGLE_TASK
 #define HIDDEVICE_TASK_PRIORITY               2
 
 #ifndef HIDDEVICE_TASK_STACK_SIZE
 #define HIDDEVICE_TASK_STACK_SIZE             400
 #endif
+#endif // !HID_DEV_SINGLE_TASK
 
 /*********************************************************************
  * CONSTANTS
  */
 
-#define HID_DEV_DATA_LEN                      9
+// Longest input report, from the report spec
+#define HID_DEV_DATA_LEN                      HID_RPT_MAX_IN_LEN
 
 #ifdef HID_DEV_RPT_QUEUE_LEN
   #define HID_DEV_REPORT_Q_SIZE               (HID_DEV_RPT_QUEUE_LEN+1)
@@ -142,6 +162,16 @@
   #define HID_DEV_REPORT_Q_SIZE               (10+1)
 #endif
 
+#ifndef HID_DEV_RPT_COALESCE
+  #define HID_DEV_RPT_COALESCE                HID_DEV_COALESCE_NONE
+#endif
+
+// Send an input report only when it differs from the last one of its ID and
+// type the host got, TRUE or FALSE
+#ifndef HID_DEV_RPT_CHANGED_ONLY
+  #define HID_DEV_RPT_CHANGED_ONLY            TRUE
+#endif
+
 // HID Auto Sync White List configuration parameter. This parameter should be
 // set to FALSE if the HID Host (i.e., the Master device) uses a Resolvable
 // Private Address (RPA). It should be set to TRUE, otherwise.
@@ -176,6 +206,15 @@ typedef struct
  uint8_t data[HID_DEV_DATA_LEN];
 } hidDevReport_t;
 
+#if HID_DEV_RPT_CHANGED_ONLY
+// Last report the host got of an entry of the report map table
+typedef struct
+{
+  uint8_t len;                    // 0 until one is sent
+  uint8_t data[HID_DEV_DATA_LEN];
+} hidDevSentReport_t;
+#endif // HID_DEV_RPT_CHANGED_ONLY
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -201,15 +240,34 @@ static ICall_SyncHandle syncEvent;
 
 // Clock instances for internal periodic events.
 static Clock_Struct battPerClock;
+static uint32_t hidDevBattPeriod = DEFAULT_BATT_PERIOD;
 static Clock_Struct idleTimeoutClock;
 
+// Advertising intervals and timeouts
+static hidDevAdvParams_t hidDevAdvParams =
+{
+  { HID_INITIAL_ADV_INT_MIN, HID_INITIAL_ADV_INT_MAX, HID_INITIAL_ADV_TIMEOUT },
+  { HID_HIGH_ADV_INT_MIN, HID_HIGH_ADV_INT_MAX, HID_HIGH_ADV_TIMEOUT },
+  { HID_LOW_ADV_INT_MIN, HID_LOW_ADV_INT_MAX, HID_LOW_ADV_TIMEOUT }
+};
+
 // Queue object used for app messages.
 static Queue_Struct appMsg;
 static Queue_Handle appMsgQueue;
 
+#ifndef HID_DEV_SINGLE_TASK
 // Task configuration.
 Task_Struct hidDeviceTask;
 Char hidDeviceTaskStack[HIDDEVICE_TASK_STACK_SIZE];
+#endif // !HID_DEV_SINGLE_TASK
+
+// Timestamp of the oldest message waiting in the queue, valid while
+// hidDevQueuePending is set.
+static uint32_t hidDevQueueTime;
+static volatile uint8_t hidDevQueuePending = FALSE;
+
+// Worst time from queuing a message to processing it, in microseconds.
+static uint32_t hidDevDispatchLatency = 0;
 
 // GAP State
 static gaprole_States_t hidDevGapState = GAPROLE_INIT;
@@ -245,9 +303,18 @@ static uint8_t firstQIdx = 0;
 static uint8_t lastQIdx = 0;
 static hidDevReport_t hidDevReportQ[HID_DEV_REPORT_Q_SIZE];
 
+// Report path counters
+static hidDevReportStats_t hidDevReportStats = { 0 };
+
 // Last report sent out
 static hidDevReport_t lastReport = { 0 };
 
+#if HID_DEV_RPT_CHANGED_ONLY
+// Last report sent of each entry of the report map table, in the order of
+// the table, cleared at disconnection and protocol mode change
+static hidDevSentReport_t hidDevSentReports[HID_NUM_REPORTS];
+#endif // HID_DEV_RPT_CHANGED_ONLY
+
 // State when HID reports are ready to be sent out
 static volatile uint8_t hidDevReportReadyState = TRUE;
 
@@ -260,18 +327,25 @@ static Clock_Struct reportReadyClock;
 
 // Task events and processing functions.
 static void HidDev_init(void);
+#ifndef HID_DEV_SINGLE_TASK
 static void HidDev_taskFxn(UArg a0, UArg a1);
 static void HidDev_processStackMsg(ICall_Hdr *pMsg);
+#endif // !HID_DEV_SINGLE_TASK
+static void HidDev_processQueue(void);
 static void HidDev_processAppMsg(hidDevEvt_t *pMsg);
+#ifndef HID_DEV_SINGLE_TASK
 static void HidDev_processGattMsg(gattMsgEvent_t *pMsg);
+#endif // !HID_DEV_SINGLE_TASK
 static void HidDev_disconnected(void);
 static void HidDev_highAdvertising(void);
 static void HidDev_lowAdvertising(void);
 static void HidDev_initialAdvertising(void);
+static void HidDev_setAdvMode(const hidDevAdvMode_t *pMode);
+static uint8_t HidDev_advModeValid(const hidDevAdvMode_t *pMode);
 static uint8_t HidDev_bondCount(void);
 static void HidDev_clockHandler(UArg arg);
 static uint8_t HidDev_enqueueMsg(uint16_t event, uint8_t state,
-                                 uint8_t *pData);
+                                 uint8_t *pData, uint8_t len);
 
 // HID reports.
 static hidRptMap_t *HidDev_reportByHandle(uint16_t handle);
@@ -279,9 +353,18 @@ static hidRptMap_t *HidDev_reportById(uint8_t id, uint8_t type);
 static hidRptMap_t *HidDev_reportByCccdHandle(uint16_t handle);
 static void HidDev_enqueueReport(uint8_t id, uint8_t type, uint8_t len,
                                  uint8_t *pData);
-static hidDevReport_t *HidDev_dequeueReport(void);
+static uint8_t HidDev_dequeueReport(hidDevReport_t *pReport);
+#if (HID_DEV_RPT_COALESCE != HID_DEV_COALESCE_NONE)
+static uint8_t HidDev_coalesceReport(uint8_t id, uint8_t type, uint8_t len,
+                                     uint8_t *pData);
+#endif // HID_DEV_RPT_COALESCE
 static void HidDev_sendReport(uint8_t id, uint8_t type, uint8_t len,
                               uint8_t *pData);
+#if HID_DEV_RPT_CHANGED_ONLY
+static hidDevSentReport_t *HidDev_sentReport(hidRptMap_t *pRpt);
+static uint8_t HidDev_isReportUnchanged(uint8_t id, uint8_t type, uint8_t len,
+                                        uint8_t *pData);
+#endif // HID_DEV_RPT_CHANGED_ONLY
 static uint8_t HidDev_sendNoti(uint16_t handle, uint8_t len, uint8_t *pData);
 static uint8_t HidDev_isbufset(uint8_t *buf, uint8_t val, uint8_t len);
 
@@ -301,6 +384,9 @@ static void HidDev_processPasscodeEvt(uint8_t *deviceAddr,
                                       uint16_t connectionHandle,
                                       uint8_t uiInputs, uint8_t uiOutputs);
 
+// Protocol mode.
+static void HidDev_processProtocolModeEvt(uint8_t mode);
+
 // Battery events.
 static void HidDev_batteryCB(uint8_t event);
 static void HidDev_processBatteryEvt(uint8_t event);
@@ -333,6 +419,27 @@ static const gapBondCBs_t hidDevBondCB =
  * PUBLIC FUNCTIONS
  */
 
+#ifdef HID_DEV_SINGLE_TASK
+/*********************************************************************
+ * @fn      HidDev_initTask
+ *
+ * @brief   Initialize the HID service in the calling task, which then
+ *          passes HidDev's events to HidDev_processEvents.
+ *
+ * @param   entity - ICall entity of the calling task
+ * @param   event - event the calling task pends on
+ *
+ * @return  none
+ */
+void HidDev_initTask(ICall_EntityID entity, ICall_SyncHandle event)
+{
+  // Share the ICall registration of the calling task.
+  selfEntity = entity;
+  syncEvent = event;
+
+  HidDev_init();
+}
+#else
 /*********************************************************************
  * @fn      HidDev_createTask
  *
@@ -354,6 +461,7 @@ void HidDev_createTask(void)
 
   Task_construct(&hidDeviceTask, HidDev_taskFxn, &taskParams, NULL);
 }
+#endif // HID_DEV_SINGLE_TASK
 
 /*********************************************************************
  * @fn      HidDev_init
@@ -370,9 +478,11 @@ void HidDev_createTask(void)
  */
 static void HidDev_init(void)
 {
+#ifndef HID_DEV_SINGLE_TASK
   // Register the current thread as an ICall dispatcher application
   // so that the application can send and receive messages.
   ICall_registerApp(&selfEntity, &syncEvent);
+#endif // !HID_DEV_SINGLE_TASK
 
   // Create an RTOS queue for message from profile to be sent to app.
   appMsgQueue = Util_constructQueue(&appMsg);
@@ -404,14 +514,18 @@ static void HidDev_init(void)
   // Register for Battery service callback.
   Batt_Register(HidDev_batteryCB);
 
+  // First battery sample, so reads return a valid level right away.
+  Batt_MeasLevel();
+
   // Register for Scan Parameters service callback.
   ScanParam_Register(HidDev_scanParamCB);
 
   // Initialize report ready clock timer
   Util_constructClock(&reportReadyClock, HidDev_reportReadyClockCB,
-                      HID_REPORT_READY_TIME, 0, false, NULL);
+                      HID_REPORT_READY_TIME, 0, false, 0);
 }
 
+#ifndef HID_DEV_SINGLE_TASK
 /*********************************************************************
  * @fn      HidDev_taskFxn
  *
@@ -457,73 +571,81 @@ static void HidDev_taskFxn(UArg a0, UArg a1)
         }
       }
 
-      // If RTOS queue is not empty, process app message.
-      if (events & HID_QUEUE_EVT)
-      {
-        while (!Queue_empty(appMsgQueue))
-        {
-          hidDevEvt_t *pMsg = (hidDevEvt_t *)Util_dequeueMsg(appMsgQueue);
-          if (pMsg)
-          {
-            // Process message.
-            HidDev_processAppMsg(pMsg);
+      HidDev_processEvents(events);
+    }
+  }
+}
+#endif // !HID_DEV_SINGLE_TASK
 
-            // Free the space from the message.
-            ICall_free(pMsg);
-          }
-        }
-      }
+/*********************************************************************
+ * @fn      HidDev_processEvents
+ *
+ * @brief   Process the events of the HID service, other than stack
+ *          messages.
+ *
+ * @param   events - events to process, others are ignored
+ *
+ * @return  none
+ */
+void HidDev_processEvents(uint32_t events)
+{
+  PROF_ENTER(HIDDEV_DISPATCH);
 
-      // Idle timeout.
-      if (events & HID_IDLE_EVT)
+  // If RTOS queue is not empty, process app message.
+  if (events & HID_QUEUE_EVT)
+  {
+    HidDev_processQueue();
+  }
+
+  // Idle timeout.
+  if (events & HID_IDLE_EVT)
+  {
+    if (hidDevGapState == GAPROLE_CONNECTED)
+    {
+      // If pairing in progress then restart timer.
+      if (hidDevPairingStarted)
       {
-        if (hidDevGapState == GAPROLE_CONNECTED)
-        {
-          // If pairing in progress then restart timer.
-          if (hidDevPairingStarted)
-          {
-            HidDev_StartIdleTimer();
-          }
-          // Else disconnect and don't allow reports to be sent
-          else
-          {
-            hidDevReportReadyState = FALSE;
-            GAPRole_TerminateConnection();
-          }
-        }
+        HidDev_StartIdleTimer();
       }
-
-      // Battery periodic event.
-      if (events & HID_BATT_PERIODIC_EVT)
+      // Else disconnect and don't allow reports to be sent
+      else
       {
-        HidDev_battPeriodicTask();
+        hidDevReportReadyState = FALSE;
+        GAPRole_TerminateConnection();
       }
+    }
+  }
 
-      // Send HID report event.
-      if (events & HID_SEND_REPORT_EVT)
-      {
-        // If connection is secure
-        if (hidDevConnSecure && hidDevReportReadyState)
-        {
-          hidDevReport_t *pReport = HidDev_dequeueReport();
+  // Battery periodic event.
+  if (events & HID_BATT_PERIODIC_EVT)
+  {
+    HidDev_battPeriodicTask();
+  }
 
-          if (pReport != NULL)
-          {
-            // Send report.
-            HidDev_sendReport(pReport->id, pReport->type, pReport->len,
-                              pReport->data);
-          }
+  // Send HID report event.
+  if (events & HID_SEND_REPORT_EVT)
+  {
+    // If connection is secure
+    if (hidDevConnSecure && hidDevReportReadyState)
+    {
+      hidDevReport_t report;
 
-          // If there is another report in the queue
-          if (!reportQEmpty())
-          {
-            // Set another event.
-            Event_post(syncEvent, HID_SEND_REPORT_EVT);
-          }
-        }
+      if (HidDev_dequeueReport(&report))
+      {
+        // Send report.
+        HidDev_sendReport(report.id, report.type, report.len, report.data);
+      }
+
+      // If there is another report in the queue
+      if (!reportQEmpty())
+      {
+        // Set another event.
+        Event_post(syncEvent, HID_SEND_REPORT_EVT);
       }
     }
   }
+
+  PROF_EXIT(HIDDEV_DISPATCH);
 }
 
 /*********************************************************************
@@ -605,6 +727,12 @@ void HidDev_Report(uint8_t id, uint8_t type, uint8_t len, uint8_t *pData)
     return;
   }
 
+  PROF_ENTER(HIDDEV_REPORT);
+
+  INPUT_TRACE_REPORT(id, type, len, pData);
+
+  hidDevReportStats.reports++;
+
   // If connected
   if (hidDevGapState == GAPROLE_CONNECTED)
   {
@@ -614,9 +742,27 @@ void HidDev_Report(uint8_t id, uint8_t type, uint8_t len, uint8_t *pData)
       // Make sure there're no pending reports.
       if (reportQEmpty())
       {
+#if HID_DEV_RPT_CHANGED_ONLY
+        // The host has this report already
+        if (HidDev_isReportUnchanged(id, type, len, pData))
+        {
+          hidDevReportStats.unchanged++;
+
+          // A held input is still activity
+          if (HidDev_isbufset(pData, 0x00, len) == FALSE)
+          {
+            HidDev_StartIdleTimer();
+          }
+
+          PROF_EXIT(HIDDEV_REPORT);
+          return;
+        }
+#endif // HID_DEV_RPT_CHANGED_ONLY
+
         // Send report.
         HidDev_sendReport(id, type, len, pData);
 
+        PROF_EXIT(HIDDEV_REPORT);
         return;
       }
     }
@@ -629,6 +775,8 @@ void HidDev_Report(uint8_t id, uint8_t type, uint8_t len, uint8_t *pData)
 
   // HidDev task will send report when secure connection is established.
   HidDev_enqueueReport(id, type, len, pData);
+
+  PROF_EXIT(HIDDEV_REPORT);
 }
 
 /*********************************************************************
@@ -707,10 +855,52 @@ bStatus_t HidDev_SetParameter(uint8_t param, uint8_t len, void *pValue)
         }
 
         // Flush report queue.
-        firstQIdx = lastQIdx = 0;
+        {
+          UInt key = Hwi_disable();
+
+          firstQIdx = lastQIdx = 0;
+          Hwi_restore(key);
+        }
 
         // Erase bonding info.
         GAPBondMgr_SetParameter(GAPBOND_ERASE_ALLBONDS, 0, NULL);
+
+        // The parameter sets accepted by the erased bonds go with them.
+        GAPRole_ForgetBondParams(TRUE);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case HIDDEV_BATT_PERIOD:
+      if (len == sizeof(uint32_t))
+      {
+        hidDevBattPeriod = *((uint32_t*)pValue);
+
+        if (hidDevBattPeriod == 0)
+        {
+          Util_stopClock(&battPerClock);
+        }
+        else if (hidDevGapState == GAPROLE_CONNECTED)
+        {
+          Util_restartClock(&battPerClock, hidDevBattPeriod);
+        }
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case HIDDEV_ADV_PARAMS:
+      if ((len == sizeof(hidDevAdvParams_t)) &&
+          HidDev_advModeValid(&((hidDevAdvParams_t*)pValue)->initial) &&
+          HidDev_advModeValid(&((hidDevAdvParams_t*)pValue)->high) &&
+          HidDev_advModeValid(&((hidDevAdvParams_t*)pValue)->low))
+      {
+        hidDevAdvParams = *((hidDevAdvParams_t*)pValue);
       }
       else
       {
@@ -753,6 +943,24 @@ bStatus_t HidDev_GetParameter(uint8_t param, void *pValue)
       *((uint8_t*)pValue) = hidDevGapBondPairingState;
       break;
 
+    case HIDDEV_BATT_PERIOD:
+      *((uint32_t*)pValue) = hidDevBattPeriod;
+      break;
+
+    case HIDDEV_DISPATCH_LATENCY:
+      *((uint32_t*)pValue) = hidDevDispatchLatency;
+      break;
+
+    case HIDDEV_REPORT_STATS:
+      hidDevReportStats.queueDepth = (lastQIdx + HID_DEV_REPORT_Q_SIZE -
+                                      firstQIdx) % HID_DEV_REPORT_Q_SIZE;
+      *((hidDevReportStats_t*)pValue) = hidDevReportStats;
+      break;
+
+    case HIDDEV_ADV_PARAMS:
+      *((hidDevAdvParams_t*)pValue) = hidDevAdvParams;
+      break;
+
     default:
       ret = INVALIDPARAMETER;
       break;
@@ -959,11 +1167,16 @@ bStatus_t HidDev_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
       if (pValue[0] == HID_PROTOCOL_MODE_BOOT ||
           pValue[0] == HID_PROTOCOL_MODE_REPORT)
       {
-        pAttr->pValue[0] = pValue[0];
-
-        // Execute HID app event callback.
-        (*pHidDevCB->evtCB)((pValue[0] == HID_PROTOCOL_MODE_BOOT) ?
-                            HID_DEV_SET_BOOT_EVT : HID_DEV_SET_REPORT_EVT);
+        // The report queue belongs to the HidDev task, it starts over in
+        // the new mode there.
+        if (HidDev_enqueueMsg(HID_PROTOCOL_MODE_EVT, pValue[0], NULL, 0))
+        {
+          pAttr->pValue[0] = pValue[0];
+        }
+        else
+        {
+          status = ATT_ERR_INSUFFICIENT_RESOURCES;
+        }
       }
       else
       {
@@ -1065,8 +1278,6 @@ static void HidDev_processAppMsg(hidDevEvt_t *pMsg)
 
     case HID_PAIR_STATE_EVT:
       HidDev_processPairStateEvt(pMsg->hdr.state, *pMsg->pData);
-
-      ICall_free(pMsg->pData);
       break;
 
     case HID_PASSCODE_EVT:
@@ -1075,17 +1286,20 @@ static void HidDev_processAppMsg(hidDevEvt_t *pMsg)
 
         HidDev_processPasscodeEvt(pc->deviceAddr, pc->connHandle,
                                   pc->uiInputs, pc->uiOutputs);
-
-        ICall_free(pMsg->pData);
       }
       break;
 
+    case HID_PROTOCOL_MODE_EVT:
+      HidDev_processProtocolModeEvt(pMsg->hdr.state);
+      break;
+
     default:
       // Do nothing.
       break;
   }
 }
 
+#ifndef HID_DEV_SINGLE_TASK
 /*********************************************************************
  * @fn      HidDev_processStackMsg
  *
@@ -1120,6 +1334,48 @@ static void HidDev_processGattMsg(gattMsgEvent_t *pMsg)
 {
   GATT_bm_free(&pMsg->msg, pMsg->method);
 }
+#endif // !HID_DEV_SINGLE_TASK
+
+/*********************************************************************
+ * @fn      HidDev_processQueue
+ *
+ * @brief   Process the messages from the profiles and track the time
+ *          they waited in the queue.
+ *
+ * @return  none
+ */
+static void HidDev_processQueue(void)
+{
+  if (hidDevQueuePending)
+  {
+    Types_FreqHz freq;
+    uint32_t latency;
+
+    hidDevQueuePending = FALSE;
+
+    Timestamp_getFreq(&freq);
+    latency = (uint32_t)(((uint64_t)(Timestamp_get32() - hidDevQueueTime) *
+                          1000000) / freq.lo);
+
+    if (latency > hidDevDispatchLatency)
+    {
+      hidDevDispatchLatency = latency;
+    }
+  }
+
+  while (!Queue_empty(appMsgQueue))
+  {
+    hidDevEvt_t *pMsg = (hidDevEvt_t *)Util_dequeueMsg(appMsgQueue);
+    if (pMsg)
+    {
+      // Process message.
+      HidDev_processAppMsg(pMsg);
+
+      // Free the space from the message.
+      Util_freeMsg((uint8_t *)pMsg);
+    }
+  }
+}
 
 /*********************************************************************
  * @fn      HidDev_stateChangeCB
@@ -1133,7 +1389,7 @@ static void HidDev_processGattMsg(gattMsgEvent_t *pMsg)
 static void HidDev_stateChangeCB(gaprole_States_t newState)
 {
   // Enqueue the message.
-  HidDev_enqueueMsg(HID_STATE_CHANGE_EVT, newState, NULL);
+  HidDev_enqueueMsg(HID_STATE_CHANGE_EVT, newState, NULL, 0);
 }
 
 /*********************************************************************
@@ -1151,7 +1407,6 @@ static void HidDev_processStateChangeEvt(gaprole_States_t newState)
   if (newState == GAPROLE_CONNECTED)
   {
     uint8_t param = FALSE;
-    //Util_startClock(&periodicClock);
 
     // Get connection handle.
     GAPRole_GetParameter(GAPROLE_CONNHANDLE, &gapConnHandle);
@@ -1159,12 +1414,20 @@ static void HidDev_processStateChangeEvt(gaprole_States_t newState)
     // Connection not secure yet.
     hidDevConnSecure = FALSE;
 
+    INPUT_TRACE_LINK(INPUT_TRACE_LINK_UP);
+
     // Don't start advertising when connection is closed.
     GAPRole_SetParameter(GAPROLE_ADVERT_ENABLED, sizeof(uint8_t), &param);
 
     // Start idle timer.
     HidDev_StartIdleTimer();
 
+    // Sample the battery in the background while connected.
+    if (hidDevBattPeriod > 0)
+    {
+      Util_restartClock(&battPerClock, hidDevBattPeriod);
+    }
+
     // If there are reports in the queue
     if (!reportQEmpty())
     {
@@ -1175,7 +1438,8 @@ static void HidDev_processStateChangeEvt(gaprole_States_t newState)
   else if (hidDevGapState == GAPROLE_CONNECTED &&
             newState != GAPROLE_CONNECTED)
   {
-    Util_stopClock(&periodicClock);
+    INPUT_TRACE_LINK(INPUT_TRACE_LINK_DOWN);
+
     HidDev_disconnected();
 
     updateConnParams = TRUE;
@@ -1221,8 +1485,6 @@ static void HidDev_disconnected(void)
   // Stop idle timer.
   HidDev_StopIdleTimer();
 
-
-
   // Reset state variables.
   hidDevConnSecure = FALSE;
   hidProtocolMode = HID_PROTOCOL_MODE_REPORT;
@@ -1231,6 +1493,9 @@ static void HidDev_disconnected(void)
 
   // Reset last report sent out
   memset(&lastReport, 0, sizeof(hidDevReport_t));
+#if HID_DEV_RPT_CHANGED_ONLY
+  memset(hidDevSentReports, 0, sizeof(hidDevSentReports));
+#endif // HID_DEV_RPT_CHANGED_ONLY
 
   // If bonded and normally connectable start advertising.
   if ((HidDev_bondCount() > 0) &&
@@ -1257,16 +1522,8 @@ static void HidDev_disconnected(void)
 static void HidDev_pairStateCB(uint16_t connHandle, uint8_t state,
                                uint8_t status)
 {
-  uint8_t *pData;
-
-  // Allocate message data
-  if ((pData = ICall_malloc(sizeof(uint8_t))))
-  {
-    *pData = status;
-
-    // Queue the event.
-    HidDev_enqueueMsg(HID_PAIR_STATE_EVT, state, pData);
-  }
+  // Queue the event.
+  HidDev_enqueueMsg(HID_PAIR_STATE_EVT, state, &status, sizeof(uint8_t));
 }
 
 /*********************************************************************
@@ -1287,7 +1544,6 @@ static void HidDev_processPairStateEvt(uint8_t state, uint8_t status)
   }
   else if (state == GAPBOND_PAIRING_STATE_COMPLETE)
   {
-    Util_startClock(&periodicClock);
     hidDevPairingStarted = FALSE;
     pairingStatus = status;
 
@@ -1295,6 +1551,19 @@ static void HidDev_processPairStateEvt(uint8_t state, uint8_t status)
     {
       hidDevConnSecure = TRUE;
       Util_restartClock(&reportReadyClock, HID_REPORT_READY_TIME);
+
+      INPUT_TRACE_LINK(INPUT_TRACE_LINK_SECURE);
+
+      // New keys, a new bond: nothing is known about its parameters yet.
+      GAPRole_ForgetBondParams(FALSE);
+    }
+  }
+  else if (state == GAPBOND_PAIRING_STATE_BOND_SAVED)
+  {
+    // The new bond has its slot now, which may be another central's.
+    if (status == SUCCESS)
+    {
+      GAPRole_ForgetBondParams(FALSE);
     }
   }
   else if (state == GAPBOND_PAIRING_STATE_BONDED)
@@ -1304,6 +1573,8 @@ static void HidDev_processPairStateEvt(uint8_t state, uint8_t status)
       hidDevConnSecure = TRUE;
       Util_restartClock(&reportReadyClock, HID_REPORT_READY_TIME);
 
+      INPUT_TRACE_LINK(INPUT_TRACE_LINK_SECURE);
+
 #if DEFAULT_SCAN_PARAM_NOTIFY_TEST == TRUE
       ScanParam_RefreshNotify(gapConnHandle);
 #endif
@@ -1341,21 +1612,18 @@ static void HidDev_processPairStateEvt(uint8_t state, uint8_t status)
 static void HidDev_passcodeCB(uint8_t *deviceAddr, uint16_t connHandle,
                                         uint8_t uiInputs, uint8_t uiOutputs)
 {
-  hidDevPasscodeEvt_t *pcEvt;
+  hidDevPasscodeEvt_t pcEvt;
 
-  // Allocate message data.
-  if ((pcEvt = ICall_malloc(sizeof(hidDevPasscodeEvt_t))))
-  {
-    // Store the arguments.
-    memcpy(pcEvt->deviceAddr, deviceAddr, B_ADDR_LEN);
+  // Store the arguments.
+  memcpy(pcEvt.deviceAddr, deviceAddr, B_ADDR_LEN);
 
-    pcEvt->connHandle = connHandle;
-    pcEvt->uiInputs = uiInputs;
-    pcEvt->uiOutputs = uiOutputs;
+  pcEvt.connHandle = connHandle;
+  pcEvt.uiInputs = uiInputs;
+  pcEvt.uiOutputs = uiOutputs;
 
-    // Queue the event.
-    HidDev_enqueueMsg(HID_PASSCODE_EVT, 0, (uint8_t *)pcEvt);
-  }
+  // Queue the event.
+  HidDev_enqueueMsg(HID_PASSCODE_EVT, 0, (uint8_t *)&pcEvt,
+                    sizeof(hidDevPasscodeEvt_t));
 }
 
 /*********************************************************************
@@ -1389,6 +1657,34 @@ static void HidDev_processPasscodeEvt(uint8_t *deviceAddr,
   }
 }
 
+/*********************************************************************
+ * @fn      HidDev_processProtocolModeEvt
+ *
+ * @brief   Processes a protocol mode written by the host. The reports
+ *          queued in the old mode have its format and are dropped, and the
+ *          host starts over in the new mode, before the application hears
+ *          of it and sends its reports in the new format.
+ *
+ * @param   mode - new protocol mode
+ *
+ * @return  none
+ */
+static void HidDev_processProtocolModeEvt(uint8_t mode)
+{
+  UInt key = Hwi_disable();
+
+  firstQIdx = lastQIdx = 0;
+  Hwi_restore(key);
+
+#if HID_DEV_RPT_CHANGED_ONLY
+  memset(hidDevSentReports, 0, sizeof(hidDevSentReports));
+#endif // HID_DEV_RPT_CHANGED_ONLY
+
+  // Execute HID app event callback.
+  (*pHidDevCB->evtCB)((mode == HID_PROTOCOL_MODE_BOOT) ?
+                      HID_DEV_SET_BOOT_EVT : HID_DEV_SET_REPORT_EVT);
+}
+
 /*********************************************************************
  * @fn      HidDev_batteryCB
  *
@@ -1401,7 +1697,7 @@ static void HidDev_processPasscodeEvt(uint8_t *deviceAddr,
 static void HidDev_batteryCB(uint8_t event)
 {
   // Queue the event.
-  HidDev_enqueueMsg(HID_BATT_SERVICE_EVT, event, NULL);
+  HidDev_enqueueMsg(HID_BATT_SERVICE_EVT, event, NULL, 0);
 }
 
 /*********************************************************************
@@ -1415,19 +1711,9 @@ static void HidDev_batteryCB(uint8_t event)
  */
 static void HidDev_processBatteryEvt(uint8_t event)
 {
-  if (event == BATT_LEVEL_NOTI_ENABLED)
-  {
-    // If connected start periodic measurement.
-    if (hidDevGapState == GAPROLE_CONNECTED)
-    {
-      Util_startClock(&battPerClock);
-    }
-  }
-  else if (event == BATT_LEVEL_NOTI_DISABLED)
-  {
-    // Stop periodic measurement.
-    Util_stopClock(&battPerClock);
-  }
+  // Do nothing. Periodic measurement runs for the whole connection so
+  // reads of the battery level are served from the cache, and the battery
+  // service only notifies clients that enabled it.
 }
 
 /*********************************************************************
@@ -1461,7 +1747,10 @@ static void HidDev_battPeriodicTask(void)
     Batt_MeasLevel();
 
     // Restart clock.
-    Util_startClock(&battPerClock);
+    if (hidDevBattPeriod > 0)
+    {
+      Util_restartClock(&battPerClock, hidDevBattPeriod);
+    }
   }
 }
 
@@ -1541,6 +1830,58 @@ static hidRptMap_t *HidDev_reportById(uint8_t id, uint8_t type)
   return NULL;
 }
 
+#if HID_DEV_RPT_CHANGED_ONLY
+/*********************************************************************
+ * @fn      HidDev_sentReport
+ *
+ * @brief   Find the last report sent of an entry of the report map table.
+ *
+ * @param   pRpt - entry of the report map table
+ *
+ * @return  Last report sent, NULL for an entry beyond HID_NUM_REPORTS
+ */
+static hidDevSentReport_t *HidDev_sentReport(hidRptMap_t *pRpt)
+{
+  uint8_t idx = (uint8_t)(pRpt - pHidDevRptTbl);
+
+  return (idx < HID_NUM_REPORTS) ? &hidDevSentReports[idx] : NULL;
+}
+
+/*********************************************************************
+ * @fn      HidDev_isReportUnchanged
+ *
+ * @brief   Check whether a report is the last one of its ID and type the
+ *          host got.
+ *
+ * @param   id    - HID report ID.
+ * @param   type  - HID report type.
+ * @param   len   - Length of report.
+ * @param   pData - Report data.
+ *
+ * @return  TRUE if the report was sent already
+ */
+static uint8_t HidDev_isReportUnchanged(uint8_t id, uint8_t type, uint8_t len,
+                                        uint8_t *pData)
+{
+  hidRptMap_t *pRpt = HidDev_reportById(id, type);
+  hidDevSentReport_t *pSent;
+
+  if ((pRpt == NULL) || ((pSent = HidDev_sentReport(pRpt)) == NULL))
+  {
+    return FALSE;
+  }
+
+  // Motion repeated is more motion, only no motion is sent once
+  if (HID_RPT_IS_RELATIVE(id, type) &&
+      (HidDev_isbufset(pData, 0x00, len) == FALSE))
+  {
+    return FALSE;
+  }
+
+  return ((pSent->len == len) && (memcmp(pSent->data, pData, len) == 0));
+}
+#endif // HID_DEV_RPT_CHANGED_ONLY
+
 /*********************************************************************
  * @fn      HidDev_sendReport
  *
@@ -1585,12 +1926,32 @@ static void HidDev_sendReport(uint8_t id, uint8_t type, uint8_t len, uint8_t *pD
         lastReport.type = type;
         lastReport.len = len;
         memcpy(lastReport.data, pData, len);
+
+#if HID_DEV_RPT_CHANGED_ONLY
+        hidDevSentReport_t *pSent = HidDev_sentReport(pRpt);
+
+        if (pSent != NULL)
+        {
+          pSent->len = len;
+          memcpy(pSent->data, pData, len);
+        }
+#endif // HID_DEV_RPT_CHANGED_ONLY
+
+        hidDevReportStats.sent++;
+      }
+      else
+      {
+        hidDevReportStats.notiFailed++;
       }
 
       // Start idle timer.
       HidDev_StartIdleTimer();
+
+      return;
     }
   }
+
+  hidDevReportStats.discarded++;
 }
 
 /*********************************************************************
@@ -1608,6 +1969,7 @@ static uint8_t HidDev_sendNoti(uint16_t handle, uint8_t len, uint8_t *pData)
 {
   uint8_t status;
   attHandleValueNoti_t noti;
+  PROF_ENTER(HIDDEV_SEND_NOTI);
 
   noti.pValue = GATT_bm_alloc(gapConnHandle, ATT_HANDLE_VALUE_NOTI, len, NULL);
   if (noti.pValue != NULL)
@@ -1628,13 +1990,19 @@ static uint8_t HidDev_sendNoti(uint16_t handle, uint8_t len, uint8_t *pData)
     status = bleMemAllocError;
   }
 
+  INPUT_TRACE_SENT(status);
+
+  PROF_EXIT(HIDDEV_SEND_NOTI);
+
   return status;
 }
 
 /*********************************************************************
  * @fn      HidDev_enqueueReport
  *
- * @brief   Enqueue a HID report to be sent later.
+ * @brief   Enqueue a HID report to be sent later. The application task
+ *          enqueues while the HidDev task dequeues or flushes, the
+ *          indices and the entry change with interrupts disabled.
  *
  * @param   id    - HID report ID.
  * @param   type  - HID report type.
@@ -1649,6 +2017,19 @@ static void HidDev_enqueueReport(uint8_t id, uint8_t type, uint8_t len,
   // Enqueue only if bonded.
   if (HidDev_bondCount() > 0)
   {
+    uint8_t depth;
+    UInt key = Hwi_disable();
+
+#if (HID_DEV_RPT_COALESCE != HID_DEV_COALESCE_NONE)
+    if (HidDev_coalesceReport(id, type, len, pData))
+    {
+      hidDevReportStats.coalesced++;
+      Hwi_restore(key);
+
+      return;
+    }
+#endif // HID_DEV_RPT_COALESCE
+
     // Update last index.
     lastQIdx = (lastQIdx + 1) % HID_DEV_REPORT_Q_SIZE;
 
@@ -1656,6 +2037,17 @@ static void HidDev_enqueueReport(uint8_t id, uint8_t type, uint8_t len,
     {
       // Queue overflow; discard oldest report.
       firstQIdx = (firstQIdx + 1) % HID_DEV_REPORT_Q_SIZE;
+
+      hidDevReportStats.overflows++;
+    }
+
+    hidDevReportStats.queued++;
+
+    depth = (lastQIdx + HID_DEV_REPORT_Q_SIZE - firstQIdx) %
+            HID_DEV_REPORT_Q_SIZE;
+    if (depth > hidDevReportStats.queuePeak)
+    {
+      hidDevReportStats.queuePeak = depth;
     }
 
     // Save report.
@@ -1664,37 +2056,116 @@ static void HidDev_enqueueReport(uint8_t id, uint8_t type, uint8_t len,
     hidDevReportQ[lastQIdx].len = len;
     memcpy(hidDevReportQ[lastQIdx].data, pData, len);
 
+    Hwi_restore(key);
+
     if (hidDevConnSecure)
     {
       // Notify our task to send out pending reports.
       Event_post(syncEvent, HID_SEND_REPORT_EVT);
     }
   }
+  else
+  {
+    hidDevReportStats.discarded++;
+  }
 }
 
 /*********************************************************************
  * @fn      HidDev_dequeueReport
  *
- * @brief   Dequeue a HID report to be sent out.
+ * @brief   Dequeue a HID report to be sent out. The report is copied
+ *          out, an overflowing enqueue may reuse its entry.
+ *
+ * @param   pReport - Report is copied here.
+ *
+ * @return  TRUE if a report was dequeued.
+ */
+static uint8_t HidDev_dequeueReport(hidDevReport_t *pReport)
+{
+  UInt key = Hwi_disable();
+
+  if (reportQEmpty())
+  {
+    Hwi_restore(key);
+
+    return FALSE;
+  }
+
+  // Update first index.
+  firstQIdx = (firstQIdx + 1) % HID_DEV_REPORT_Q_SIZE;
+  *pReport = hidDevReportQ[firstQIdx];
+
+  Hwi_restore(key);
+
+  return TRUE;
+}
+
+#if (HID_DEV_RPT_COALESCE != HID_DEV_COALESCE_NONE)
+/*********************************************************************
+ * @fn      HidDev_coalesceReport
+ *
+ * @brief   Merge a HID report into the newest queued report of the same
+ *          ID and type, as HID_DEV_RPT_COALESCE selects.
  *
  * @param   id    - HID report ID.
  * @param   type  - HID report type.
  * @param   len   - Length of report.
  * @param   pData - Report data.
  *
- * @return  None.
+ * @return  TRUE if the report takes no queue entry.
  */
-static hidDevReport_t *HidDev_dequeueReport(void)
+static uint8_t HidDev_coalesceReport(uint8_t id, uint8_t type, uint8_t len,
+                                     uint8_t *pData)
 {
-  if (reportQEmpty())
+  hidDevReport_t *pLast = &hidDevReportQ[lastQIdx];
+
+  if (reportQEmpty() || (pLast->id != id) || (pLast->type != type))
   {
-    return NULL;
+    return FALSE;
   }
 
-  // Update first index.
-  firstQIdx = (firstQIdx + 1) % HID_DEV_REPORT_Q_SIZE;
+#if (HID_DEV_RPT_COALESCE == HID_DEV_COALESCE_SAME)
+  return ((pLast->len == len) && (memcmp(pLast->data, pData, len) == 0));
+#else
+  pLast->len = len;
+  memcpy(pLast->data, pData, len);
+
+  return TRUE;
+#endif // HID_DEV_RPT_COALESCE
+}
+#endif // HID_DEV_RPT_COALESCE
+
+/*********************************************************************
+ * @fn      HidDev_setAdvMode
+ *
+ * @brief   Set the advertising interval and timeout of a mode.
+ *
+ * @param   pMode - interval range and timeout
+ *
+ * @return  None.
+ */
+static void HidDev_setAdvMode(const hidDevAdvMode_t *pMode)
+{
+  VOID GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MIN, pMode->intMin);
+  VOID GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MAX, pMode->intMax);
+  VOID GAP_SetParamValue(TGAP_LIM_ADV_TIMEOUT, pMode->timeout);
+}
 
-  return (&(hidDevReportQ[firstQIdx]));
+/*********************************************************************
+ * @fn      HidDev_advModeValid
+ *
+ * @brief   Check an advertising interval range against the 20 ms to
+ *          10.24 s the stack takes.
+ *
+ * @param   pMode - interval range and timeout
+ *
+ * @return  TRUE if the range is valid
+ */
+static uint8_t HidDev_advModeValid(const hidDevAdvMode_t *pMode)
+{
+  return ((pMode->intMin >= HID_ADV_INT_MIN) &&
+          (pMode->intMin <= pMode->intMax) &&
+          (pMode->intMax <= HID_ADV_INT_MAX));
 }
 
 /*********************************************************************
@@ -1710,9 +2181,7 @@ static void HidDev_highAdvertising(void)
 {
   uint8_t param;
 
-  VOID GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MIN, HID_HIGH_ADV_INT_MIN);
-  VOID GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MAX, HID_HIGH_ADV_INT_MAX);
-  VOID GAP_SetParamValue(TGAP_LIM_ADV_TIMEOUT, HID_HIGH_ADV_TIMEOUT);
+  HidDev_setAdvMode(&hidDevAdvParams.high);
 
   // Setup advertising filter policy first.
   param = HID_AUTO_SYNC_WL ? GAP_FILTER_POLICY_WHITE : GAP_FILTER_POLICY_ALL;
@@ -1735,9 +2204,7 @@ static void HidDev_lowAdvertising(void)
 {
   uint8_t param;
 
-  VOID GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MIN, HID_LOW_ADV_INT_MIN);
-  VOID GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MAX, HID_LOW_ADV_INT_MAX);
-  VOID GAP_SetParamValue(TGAP_LIM_ADV_TIMEOUT, HID_LOW_ADV_TIMEOUT);
+  HidDev_setAdvMode(&hidDevAdvParams.low);
 
   // Setup advertising filter policy first.
   param = HID_AUTO_SYNC_WL ? GAP_FILTER_POLICY_WHITE : GAP_FILTER_POLICY_ALL;
@@ -1758,9 +2225,7 @@ static void HidDev_initialAdvertising(void)
 {
   uint8_t param;
 
-  VOID GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MIN, HID_INITIAL_ADV_INT_MIN);
-  VOID GAP_SetParamValue(TGAP_LIM_DISC_ADV_INT_MAX, HID_INITIAL_ADV_INT_MAX);
-  VOID GAP_SetParamValue(TGAP_LIM_ADV_TIMEOUT, HID_INITIAL_ADV_TIMEOUT);
+  HidDev_setAdvMode(&hidDevAdvParams.initial);
 
   // Setup advertising filter policy first.
   param = GAP_FILTER_POLICY_ALL;
@@ -1840,24 +2305,40 @@ static void HidDev_clockHandler(UArg arg)
 /*********************************************************************
  * @fn      HidDev_enqueueMsg
  *
- * @brief   Creates a message and puts the message in RTOS queue.
+ * @brief   Creates a message and puts the message in RTOS queue. The
+ *          message data is copied into the same message block.
  *
  * @param   event  - message event.
  * @param   state  - message state.
- * @param   pData  - message data pointer.
+ * @param   pData  - message data pointer, may be NULL.
+ * @param   len    - message data length.
  *
  * @return  TRUE or FALSE
  */
-static uint8_t HidDev_enqueueMsg(uint16_t event, uint8_t state, uint8_t *pData)
+static uint8_t HidDev_enqueueMsg(uint16_t event, uint8_t state, uint8_t *pData,
+                                 uint8_t len)
 {
   hidDevEvt_t *pMsg;
 
-  // Create dynamic pointer to message.
-  if (pMsg = ICall_malloc(sizeof(hidDevEvt_t)))
+  // Allocate the message and its data in one block.
+  if ((pMsg = (hidDevEvt_t *)Util_allocMsg(sizeof(hidDevEvt_t) + len)))
   {
     pMsg->hdr.event = event;
     pMsg->hdr.state = state;
-    pMsg->pData = pData;
+    pMsg->pData = NULL;
+
+    if (len > 0)
+    {
+      pMsg->pData = (uint8_t *)(pMsg + 1);
+      memcpy(pMsg->pData, pData, len);
+    }
+
+    // Time the wait of the first message queued since the last dispatch.
+    if (!hidDevQueuePending)
+    {
+      hidDevQueueTime = Timestamp_get32();
+      hidDevQueuePending = TRUE;
+    }
 
     // Enqueue the message.
     return Util_enqueueMsg(appMsgQueue, syncEvent, (uint8*)pMsg);
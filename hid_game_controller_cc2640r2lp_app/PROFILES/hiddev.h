@@ -58,6 +58,9 @@ extern "C"
 /*********************************************************************
  * INCLUDES
  */
+#ifdef HID_DEV_SINGLE_TASK
+#include <icall.h>
+#endif // HID_DEV_SINGLE_TASK
 
 /*********************************************************************
  * MACROS
@@ -80,6 +83,46 @@ extern "C"
                                           // the HID Dev GAP Bond Manager
                                           // Pairing State. Read Only.
                                           // Size is uint8_t.
+#define HIDDEV_BATT_PERIOD          0x03  // Battery measurement period in ms
+                                          // while connected, 0 to stop
+                                          // measuring. Read/Write.
+                                          // Size is uint32_t.
+#define HIDDEV_DISPATCH_LATENCY     0x04  // Worst time in us a profile event
+                                          // waited in the HidDev queue.
+                                          // Read Only. Size is uint32_t.
+#define HIDDEV_REPORT_STATS         0x05  // Counters of the report path.
+                                          // Read Only. Size is
+                                          // hidDevReportStats_t.
+#define HIDDEV_ADV_PARAMS           0x06  // Advertising intervals and
+                                          // timeouts, used from the next
+                                          // advertising start. Read/Write.
+                                          // Size is hidDevAdvParams_t.
+
+// Coalescing of queued reports, set HID_DEV_RPT_COALESCE to one of these.
+// Queued reports are waiting for a secure connection, a report coalesced
+// into the newest one in the queue takes no queue entry.
+#define HID_DEV_COALESCE_NONE       0     // Queue every report
+#define HID_DEV_COALESCE_SAME       1     // Drop a report equal to the newest
+                                          // queued one
+#define HID_DEV_COALESCE_LATEST     2     // Overwrite the newest queued report
+                                          // of the same ID and type. A press
+                                          // and release queued back to back
+                                          // merge into the release.
+
+#ifdef HID_DEV_SINGLE_TASK
+// HidDev events on the event of the task that called HidDev_initTask.
+// Event_Id_00 to Event_Id_07 are left to that task. The queue event is
+// shared, HidDev drains only its own queue.
+#define HID_DEV_QUEUE_EVT           UTIL_QUEUE_EVENT_ID
+#define HID_DEV_BATT_PERIODIC_EVT   Event_Id_08
+#define HID_DEV_IDLE_EVT            Event_Id_09
+#define HID_DEV_SEND_REPORT_EVT     Event_Id_10
+
+#define HID_DEV_ALL_EVENTS          (HID_DEV_QUEUE_EVT         | \
+                                     HID_DEV_BATT_PERIODIC_EVT | \
+                                     HID_DEV_IDLE_EVT          | \
+                                     HID_DEV_SEND_REPORT_EVT)
+#endif // HID_DEV_SINGLE_TASK
 
 // HID read/write operation
 #define HID_DEV_OPER_WRITE          0  // Write operation
@@ -292,6 +335,39 @@ typedef struct
 
 } hidDevCfg_t;
 
+// Advertising interval range in 625 us units and limited discoverable
+// timeout in s of an advertising mode, see HIDDEV_ADV_PARAMS
+typedef struct
+{
+  uint16_t    intMin;
+  uint16_t    intMax;
+  uint16_t    timeout;          // 0 for no timeout
+} hidDevAdvMode_t;
+
+typedef struct
+{
+  hidDevAdvMode_t initial;      // Without a bond, for the first connection
+  hidDevAdvMode_t high;         // Reconnecting, right after a disconnect
+  hidDevAdvMode_t low;          // Reconnecting, after the high duty period
+} hidDevAdvParams_t;
+
+// HID report path counters, see HIDDEV_REPORT_STATS
+typedef struct
+{
+  uint32_t    reports;          // Reports passed to HidDev_Report
+  uint32_t    sent;             // Notifications accepted by the stack
+  uint32_t    notiFailed;       // Notifications refused, report lost
+  uint32_t    discarded;        // Not queued without a bond, or not sent
+                                // with notifications disabled
+  uint32_t    queued;           // Reports put in the queue
+  uint32_t    coalesced;        // Reports merged into a queued one
+  uint32_t    overflows;        // Oldest queued reports discarded
+  uint32_t    unchanged;        // Not sent, the host has the same report
+                                // (HID_DEV_RPT_CHANGED_ONLY)
+  uint8_t     queueDepth;       // Reports in the queue
+  uint8_t     queuePeak;        // Most reports in the queue
+} hidDevReportStats_t;
+
 /*********************************************************************
  * Global Variables
  */
@@ -299,7 +375,7 @@ typedef struct
 // These variables are defined in the service source file that uses HID Dev
 
 // HID report map length
-extern uint8_t hidReportMapLen;
+extern uint16_t hidReportMapLen;
 
 // HID protocol mode
 extern uint8_t hidProtocolMode;
@@ -328,6 +404,22 @@ typedef struct
 } hidDevCB_t;
 
 
+#ifdef HID_DEV_SINGLE_TASK
+/*********************************************************************
+ * @fn      HidDev_initTask
+ *
+ * @brief   Initialize the HID service in the calling task instead of a
+ *          task of its own. Call it right after ICall_registerApp and
+ *          pass HID_DEV_ALL_EVENTS to HidDev_processEvents. Stack
+ *          messages go to the calling task.
+ *
+ * @param   entity - ICall entity of the calling task
+ * @param   event - event the calling task pends on
+ *
+ * @return  none
+ */
+extern void HidDev_initTask(ICall_EntityID entity, ICall_SyncHandle event);
+#else
 /*********************************************************************
  * @fn      HidDev_createTask
  *
@@ -338,6 +430,20 @@ typedef struct
  * @return  none
  */
 extern void HidDev_createTask(void);
+#endif // HID_DEV_SINGLE_TASK
+
+/*********************************************************************
+ * @fn      HidDev_processEvents
+ *
+ * @brief   Process the events of the HID service, other than stack
+ *          messages. Called by the HidDev task, or by the task that
+ *          called HidDev_initTask.
+ *
+ * @param   events - events to process, others are ignored
+ *
+ * @return  none
+ */
+extern void HidDev_processEvents(uint32_t events);
 
 /*********************************************************************
  * @fn      HidDev_StartDevice
@@ -47,6 +47,7 @@
 /*********************************************************************
  * INCLUDES
  */
+#include <string.h>
 #include <icall.h>
 #include "util.h"
 /* This Header file contains all BLE API and icall structure definition */
@@ -55,6 +56,7 @@
 #include "hidkbdservice.h"
 #include "hiddev.h"
 #include "battservice.h"
+#include "cccdarena.h"
 
 /*********************************************************************
  * MACROS
@@ -68,6 +70,16 @@
  * TYPEDEFS
  */
 
+// Report characteristic in the report map table, see HID_RPT_ATTRS
+typedef struct
+{
+  uint8 id;                       // Report ID
+  uint8 type;                     // Report type
+  uint8 mode;                     // Protocol mode
+  uint8 idx;                      // Index of the characteristic in hidAttrTbl
+  uint8 cccdIdx;                  // Index of its CCCD, 0 if none
+} hidRptAttr_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -145,58 +157,8 @@ static CONST uint8 hidInfo[HID_INFORMATION_LEN] =
   HID_KBD_FLAGS                                   // Flags
 };
 
-// HID Report Map characteristic value
-// Keyboard report descriptor (using format for Boot interface descriptor)
-static CONST uint8 hidReportMap[] =
-{
-  0x05, 0x01,     // Usage Pg (Generic Desktop)
-  0x09, 0x06,     // Usage (Keyboard)
-  0xA1, 0x01,     // Collection: (Application)
-                  //
-  0x05, 0x07,     // Usage Pg (Key Codes)
-  0x19, 0xE0,     // Usage Min (224)
-  0x29, 0xE7,     // Usage Max (231)
-  0x15, 0x00,     // Log Min (0)
-  0x25, 0x01,     // Log Max (1)
-                  //
-                  // Modifier byte
-  0x75, 0x01,     // Report Size (1)
-  0x95, 0x08,     // Report Count (8)
-  0x81, 0x02,     // Input: (Data, Variable, Absolute)
-                  //
-                  // Reserved byte
-  0x95, 0x01,     // Report Count (1)
-  0x75, 0x08,     // Report Size (8)
-  0x81, 0x01,     // Input: (Constant)
-                  //
-                  // LED report
-  0x95, 0x05,     // Report Count (5)
-  0x75, 0x01,     // Report Size (1)
-  0x05, 0x08,     // Usage Pg (LEDs)
-  0x19, 0x01,     // Usage Min (1)
-  0x29, 0x05,     // Usage Max (5)
-  0x91, 0x02,     // Output: (Data, Variable, Absolute)
-                  //
-                  // LED report padding
-  0x95, 0x01,     // Report Count (1)
-  0x75, 0x03,     // Report Size (3)
-  0x91, 0x01,     // Output: (Constant)
-                  //
-                  // Key arrays (6 bytes)
-  0x95, 0x06,     // Report Count (6)
-  0x75, 0x08,     // Report Size (8)
-  0x15, 0x00,     // Log Min (0)
-  0x25, 0x65,     // Log Max (101)
-  0x05, 0x07,     // Usage Pg (Key Codes)
-  0x19, 0x00,     // Usage Min (0)
-  0x29, 0x65,     // Usage Max (101)
-  0x81, 0x00,     // Input: (Data, Array)
-                  //
-  0xC0            // End Collection
-};
-
 // HID report map length
-uint8 hidReportMapLen = sizeof(hidReportMap);
+uint16 hidReportMapLen = HID_REPORT_MAP_LEN;
 
 // HID report mapping table
 static hidRptMap_t  hidRptMap[HID_NUM_REPORTS];
@@ -211,67 +173,118 @@ static CONST gattAttrType_t hidService = { ATT_BT_UUID_SIZE, hidServUUID };
 // Include attribute (Battery service)
 static uint16 include = GATT_INVALID_HANDLE;
 
+// Properties and descriptors only read by the GATT server are CONST and
+// stay in flash. The attribute table itself must be in RAM, the server
+// writes the handles into it.
+
 // HID Information characteristic
-static uint8 hidInfoProps = GATT_PROP_READ;
+static CONST uint8 hidInfoProps = GATT_PROP_READ;
 
 // HID Report Map characteristic
-static uint8 hidReportMapProps = GATT_PROP_READ;
+static CONST uint8 hidReportMapProps = GATT_PROP_READ;
 
 // HID External Report Reference Descriptor
-static uint8 hidExtReportRefDesc[ATT_BT_UUID_SIZE] =
+static CONST uint8 hidExtReportRefDesc[ATT_BT_UUID_SIZE] =
              { LO_UINT16(BATT_LEVEL_UUID), HI_UINT16(BATT_LEVEL_UUID) };
 
 // HID Control Point characteristic
-static uint8 hidControlPointProps = GATT_PROP_WRITE_NO_RSP;
+static CONST uint8 hidControlPointProps = GATT_PROP_WRITE_NO_RSP;
 static uint8 hidControlPoint;
 
 // HID Protocol Mode characteristic
-static uint8 hidProtocolModeProps = GATT_PROP_READ | GATT_PROP_WRITE_NO_RSP;
+static CONST uint8 hidProtocolModeProps = GATT_PROP_READ | GATT_PROP_WRITE_NO_RSP;
 uint8 hidProtocolMode = HID_PROTOCOL_MODE_REPORT;
 
 // HID Report characteristic, key input
-static uint8 hidReportKeyInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static CONST uint8 hidReportKeyInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
 static uint8 hidReportKeyIn;
 static gattCharCfg_t *hidReportKeyInClientCharCfg;
 
 // HID Report Reference characteristic descriptor, key input
-static uint8 hidReportRefKeyIn[HID_REPORT_REF_LEN] =
+static CONST uint8 hidReportRefKeyIn[HID_REPORT_REF_LEN] =
              { HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT };
 
 // HID Report characteristic, LED output
-static uint8 hidReportLedOutProps = GATT_PROP_READ  |
-                                    GATT_PROP_WRITE |
-                                    GATT_PROP_WRITE_NO_RSP;
+static CONST uint8 hidReportLedOutProps = GATT_PROP_READ  |
+                                          GATT_PROP_WRITE |
+                                          GATT_PROP_WRITE_NO_RSP;
 static uint8 hidReportLedOut;
 
 // HID Report Reference characteristic descriptor, LED output
-static uint8 hidReportRefLedOut[HID_REPORT_REF_LEN] =
+static CONST uint8 hidReportRefLedOut[HID_REPORT_REF_LEN] =
              { HID_RPT_ID_LED_OUT, HID_REPORT_TYPE_OUTPUT };
 
 // HID Boot Keyboard Input Report
-static uint8 hidReportBootKeyInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static CONST uint8 hidReportBootKeyInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
 static uint8 hidReportBootKeyIn;
 static gattCharCfg_t *hidReportBootKeyInClientCharCfg;
 
 // HID Boot Keyboard Output Report
-static uint8 hidReportBootKeyOutProps = GATT_PROP_READ  |
-                                        GATT_PROP_WRITE |
-                                        GATT_PROP_WRITE_NO_RSP;
+static CONST uint8 hidReportBootKeyOutProps = GATT_PROP_READ  |
+                                              GATT_PROP_WRITE |
+                                              GATT_PROP_WRITE_NO_RSP;
 static uint8 hidReportBootKeyOut;
 
 // HID Boot Mouse Input Report
-static uint8 hidReportBootMouseInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static CONST uint8 hidReportBootMouseInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
 static uint8 hidReportBootMouseIn;
 static gattCharCfg_t *hidReportBootMouseInClientCharCfg;
 
 // Feature Report
-static uint8 hidReportFeatureProps = GATT_PROP_READ | GATT_PROP_WRITE;
+static CONST uint8 hidReportFeatureProps = GATT_PROP_READ | GATT_PROP_WRITE;
 static uint8 hidReportFeature;
 
 // HID Report Reference characteristic descriptor, Feature
-static uint8 hidReportRefFeature[HID_REPORT_REF_LEN] =
+static CONST uint8 hidReportRefFeature[HID_REPORT_REF_LEN] =
              { HID_RPT_ID_FEATURE, HID_REPORT_TYPE_FEATURE };
 
+// HID Report characteristic, gamepad input
+static CONST uint8 hidReportGamepadInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static uint8 hidReportGamepadIn;
+static gattCharCfg_t *hidReportGamepadInClientCharCfg;
+
+// HID Report Reference characteristic descriptor, gamepad input
+static CONST uint8 hidReportRefGamepadIn[HID_REPORT_REF_LEN] =
+             { HID_RPT_ID_GAMEPAD_IN, HID_REPORT_TYPE_INPUT };
+
+// HID Report characteristic, consumer control input
+static CONST uint8 hidReportConsumerInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static uint8 hidReportConsumerIn;
+static gattCharCfg_t *hidReportConsumerInClientCharCfg;
+
+// HID Report Reference characteristic descriptor, consumer control input
+static CONST uint8 hidReportRefConsumerIn[HID_REPORT_REF_LEN] =
+             { HID_RPT_ID_CONSUMER_IN, HID_REPORT_TYPE_INPUT };
+
+// HID Report characteristic, mouse input
+static CONST uint8 hidReportMouseInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static uint8 hidReportMouseIn;
+static gattCharCfg_t *hidReportMouseInClientCharCfg;
+
+// HID Report Reference characteristic descriptor, mouse input
+static CONST uint8 hidReportRefMouseIn[HID_REPORT_REF_LEN] =
+             { HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT };
+
+// HID Report characteristic, lights output
+static CONST uint8 hidReportLightOutProps = GATT_PROP_READ  |
+                                            GATT_PROP_WRITE |
+                                            GATT_PROP_WRITE_NO_RSP;
+static uint8 hidReportLightOut[HID_LIGHT_OUT_RPT_LEN];
+
+// HID Report Reference characteristic descriptor, lights output
+static CONST uint8 hidReportRefLightOut[HID_REPORT_REF_LEN] =
+             { HID_RPT_ID_LIGHT_OUT, HID_REPORT_TYPE_OUTPUT };
+
+// HID Report characteristic, effect output
+static CONST uint8 hidReportEffectOutProps = GATT_PROP_READ  |
+                                             GATT_PROP_WRITE |
+                                             GATT_PROP_WRITE_NO_RSP;
+static uint8 hidReportEffectOut[HID_EFFECT_OUT_RPT_LEN];
+
+// HID Report Reference characteristic descriptor, effect output
+static CONST uint8 hidReportRefEffectOut[HID_REPORT_REF_LEN] =
+             { HID_RPT_ID_EFFECT_OUT, HID_REPORT_TYPE_OUTPUT };
+
 /*********************************************************************
  * Profile Attributes - Table
  */
@@ -299,7 +312,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidInfoProps
+      (uint8 *)&hidInfoProps
     },
 
       // HID Information characteristic
@@ -315,7 +328,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidControlPointProps
+      (uint8 *)&hidControlPointProps
     },
 
       // HID Control Point characteristic
@@ -331,7 +344,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidProtocolModeProps
+      (uint8 *)&hidProtocolModeProps
     },
 
       // HID Protocol Mode characteristic
@@ -348,7 +361,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidReportMapProps
+      (uint8 *)&hidReportMapProps
     },
 
       // HID Report Map characteristic
@@ -364,7 +377,7 @@ static gattAttribute_t hidAttrTbl[] =
         { ATT_BT_UUID_SIZE, extReportRefUUID },
         GATT_PERMIT_READ,
         0,
-        hidExtReportRefDesc
+        (uint8 *)hidExtReportRefDesc
       },
 
     // HID Report characteristic, key input declaration
@@ -372,7 +385,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidReportKeyInProps
+      (uint8 *)&hidReportKeyInProps
     },
 
       // HID Report characteristic, key input
@@ -396,7 +409,7 @@ static gattAttribute_t hidAttrTbl[] =
         { ATT_BT_UUID_SIZE, reportRefUUID },
         GATT_PERMIT_READ,
         0,
-        hidReportRefKeyIn
+        (uint8 *)hidReportRefKeyIn
       },
 
     // HID Report characteristic, LED output declaration
@@ -404,7 +417,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidReportLedOutProps
+      (uint8 *)&hidReportLedOutProps
     },
 
       // HID Report characteristic, LED output
@@ -420,7 +433,7 @@ static gattAttribute_t hidAttrTbl[] =
         { ATT_BT_UUID_SIZE, reportRefUUID },
         GATT_PERMIT_READ,
         0,
-        hidReportRefLedOut
+        (uint8 *)hidReportRefLedOut
       },
 
     // HID Boot Keyboard Input Report declaration
@@ -428,7 +441,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidReportBootKeyInProps
+      (uint8 *)&hidReportBootKeyInProps
     },
 
       // HID Boot Keyboard Input Report
@@ -452,7 +465,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidReportBootKeyOutProps
+      (uint8 *)&hidReportBootKeyOutProps
     },
 
       // HID Boot Keyboard Output Report
@@ -468,7 +481,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidReportBootMouseInProps
+      (uint8 *)&hidReportBootMouseInProps
     },
 
       // HID Boot Mouse Input Report
@@ -492,7 +505,7 @@ static gattAttribute_t hidAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &hidReportFeatureProps
+      (uint8 *)&hidReportFeatureProps
     },
 
       // Feature Report
@@ -508,7 +521,151 @@ static gattAttribute_t hidAttrTbl[] =
         { ATT_BT_UUID_SIZE, reportRefUUID },
         GATT_PERMIT_READ,
         0,
-        hidReportRefFeature
+        (uint8 *)hidReportRefFeature
+      },
+
+    // HID Report characteristic, gamepad input declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      (uint8 *)&hidReportGamepadInProps
+    },
+
+      // HID Report characteristic, gamepad input
+      {
+        { ATT_BT_UUID_SIZE, hidReportUUID },
+        GATT_PERMIT_ENCRYPT_READ,
+        0,
+        &hidReportGamepadIn
+      },
+
+      // HID Report characteristic client characteristic configuration
+      {
+        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        (uint8 *) &hidReportGamepadInClientCharCfg
+      },
+
+      // HID Report Reference characteristic descriptor, gamepad input
+      {
+        { ATT_BT_UUID_SIZE, reportRefUUID },
+        GATT_PERMIT_READ,
+        0,
+        (uint8 *)hidReportRefGamepadIn
+      },
+
+    // HID Report characteristic, consumer control input declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      (uint8 *)&hidReportConsumerInProps
+    },
+
+      // HID Report characteristic, consumer control input
+      {
+        { ATT_BT_UUID_SIZE, hidReportUUID },
+        GATT_PERMIT_ENCRYPT_READ,
+        0,
+        &hidReportConsumerIn
+      },
+
+      // HID Report characteristic client characteristic configuration
+      {
+        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        (uint8 *) &hidReportConsumerInClientCharCfg
+      },
+
+      // HID Report Reference characteristic descriptor, consumer control input
+      {
+        { ATT_BT_UUID_SIZE, reportRefUUID },
+        GATT_PERMIT_READ,
+        0,
+        (uint8 *)hidReportRefConsumerIn
+      },
+
+    // HID Report characteristic, mouse input declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      (uint8 *)&hidReportMouseInProps
+    },
+
+      // HID Report characteristic, mouse input
+      {
+        { ATT_BT_UUID_SIZE, hidReportUUID },
+        GATT_PERMIT_ENCRYPT_READ,
+        0,
+        &hidReportMouseIn
+      },
+
+      // HID Report characteristic client characteristic configuration
+      {
+        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        (uint8 *) &hidReportMouseInClientCharCfg
+      },
+
+      // HID Report Reference characteristic descriptor, mouse input
+      {
+        { ATT_BT_UUID_SIZE, reportRefUUID },
+        GATT_PERMIT_READ,
+        0,
+        (uint8 *)hidReportRefMouseIn
+      },
+
+    // HID Report characteristic, lights output declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      (uint8 *)&hidReportLightOutProps
+    },
+
+      // HID Report characteristic, lights output
+      {
+        { ATT_BT_UUID_SIZE, hidReportUUID },
+        GATT_PERMIT_ENCRYPT_READ | GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        hidReportLightOut
+      },
+
+      // HID Report Reference characteristic descriptor, lights output
+      {
+        { ATT_BT_UUID_SIZE, reportRefUUID },
+        GATT_PERMIT_READ,
+        0,
+        (uint8 *)hidReportRefLightOut
+      },
+
+    // HID Report characteristic, effect output declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      (uint8 *)&hidReportEffectOutProps
+    },
+
+      // HID Report characteristic, effect output
+      {
+        { ATT_BT_UUID_SIZE, hidReportUUID },
+        GATT_PERMIT_ENCRYPT_READ | GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        hidReportEffectOut
+      },
+
+      // HID Report Reference characteristic descriptor, effect output
+      {
+        { ATT_BT_UUID_SIZE, reportRefUUID },
+        GATT_PERMIT_READ,
+        0,
+        (uint8 *)hidReportRefEffectOut
       },
 };
 
@@ -543,7 +700,31 @@ enum
   HID_BOOT_MOUSE_IN_CCCD_IDX,     // HID Boot Mouse Input Report characteristic client characteristic configuration
   HID_FEATURE_DECL_IDX,           // Feature Report declaration
   HID_FEATURE_IDX,                // Feature Report
-  HID_REPORT_REF_FEATURE_IDX      // HID Report Reference characteristic descriptor, feature
+  HID_REPORT_REF_FEATURE_IDX,     // HID Report Reference characteristic descriptor, feature
+  HID_REPORT_GAMEPAD_IN_DECL_IDX, // HID Report characteristic, gamepad input declaration
+  HID_REPORT_GAMEPAD_IN_IDX,      // HID Report characteristic, gamepad input
+  HID_REPORT_GAMEPAD_IN_CCCD_IDX, // HID Report characteristic client characteristic configuration
+  HID_REPORT_REF_GAMEPAD_IN_IDX,  // HID Report Reference characteristic descriptor, gamepad input
+  HID_REPORT_CONSUMER_IN_DECL_IDX, // HID Report characteristic, consumer control input declaration
+  HID_REPORT_CONSUMER_IN_IDX,     // HID Report characteristic, consumer control input
+  HID_REPORT_CONSUMER_IN_CCCD_IDX, // HID Report characteristic client characteristic configuration
+  HID_REPORT_REF_CONSUMER_IN_IDX, // HID Report Reference characteristic descriptor, consumer control input
+  HID_REPORT_MOUSE_IN_DECL_IDX,   // HID Report characteristic, mouse input declaration
+  HID_REPORT_MOUSE_IN_IDX,        // HID Report characteristic, mouse input
+  HID_REPORT_MOUSE_IN_CCCD_IDX,   // HID Report characteristic client characteristic configuration
+  HID_REPORT_REF_MOUSE_IN_IDX,    // HID Report Reference characteristic descriptor, mouse input
+  HID_REPORT_LIGHT_OUT_DECL_IDX,  // HID Report characteristic, lights output declaration
+  HID_REPORT_LIGHT_OUT_IDX,       // HID Report characteristic, lights output
+  HID_REPORT_REF_LIGHT_OUT_IDX,   // HID Report Reference characteristic descriptor, lights output
+  HID_REPORT_EFFECT_OUT_DECL_IDX, // HID Report characteristic, effect output declaration
+  HID_REPORT_EFFECT_OUT_IDX,      // HID Report characteristic, effect output
+  HID_REPORT_REF_EFFECT_OUT_IDX   // HID Report Reference characteristic descriptor, effect output
+};
+
+// Report characteristics, generated from the report spec
+static CONST hidRptAttr_t hidRptAttrs[HID_NUM_RPT_ATTRS] =
+{
+  HID_RPT_ATTRS
 };
 
 /*********************************************************************
@@ -586,34 +767,23 @@ CONST gattServiceCBs_t hidKbdCBs =
 bStatus_t HidKbd_AddService(void)
 {
   uint8 status = SUCCESS;
-
-  // Allocate Client Charateristic Configuration tables.
-  hidReportKeyInClientCharCfg = (gattCharCfg_t *)ICall_malloc(sizeof(gattCharCfg_t) *
-                                                              linkDBNumConns);
-
-  if (hidReportKeyInClientCharCfg == NULL)
-  {
-    return ( bleMemAllocError );
-  }
-
-  hidReportBootKeyInClientCharCfg = (gattCharCfg_t *)ICall_malloc(sizeof(gattCharCfg_t) *
-                                                                  linkDBNumConns);
-
-  if (hidReportBootKeyInClientCharCfg == NULL)
-  {
-    ICall_free(hidReportKeyInClientCharCfg);
-
-    return ( bleMemAllocError );
-  }
-
-  hidReportBootMouseInClientCharCfg = (gattCharCfg_t *)ICall_malloc(sizeof(gattCharCfg_t) *
-                                                                    linkDBNumConns);
-  if (hidReportBootMouseInClientCharCfg == NULL)
+  uint8 i;
+
+  // Take the Client Charateristic Configuration tables from the arena.
+  hidReportKeyInClientCharCfg = CccdArena_alloc();
+  hidReportBootKeyInClientCharCfg = CccdArena_alloc();
+  hidReportBootMouseInClientCharCfg = CccdArena_alloc();
+  hidReportGamepadInClientCharCfg = CccdArena_alloc();
+  hidReportConsumerInClientCharCfg = CccdArena_alloc();
+  hidReportMouseInClientCharCfg = CccdArena_alloc();
+
+  if ((hidReportKeyInClientCharCfg == NULL) ||
+      (hidReportBootKeyInClientCharCfg == NULL) ||
+      (hidReportBootMouseInClientCharCfg == NULL) ||
+      (hidReportGamepadInClientCharCfg == NULL) ||
+      (hidReportConsumerInClientCharCfg == NULL) ||
+      (hidReportMouseInClientCharCfg == NULL))
   {
-    ICall_free(hidReportKeyInClientCharCfg);
-
-    ICall_free(hidReportBootKeyInClientCharCfg);
-
     return ( bleMemAllocError );
   }
 
@@ -622,6 +792,10 @@ bStatus_t HidKbd_AddService(void)
   GATTServApp_InitCharCfg(INVALID_CONNHANDLE, hidReportBootKeyInClientCharCfg);
   GATTServApp_InitCharCfg(INVALID_CONNHANDLE,
                           hidReportBootMouseInClientCharCfg);
+  GATTServApp_InitCharCfg(INVALID_CONNHANDLE, hidReportGamepadInClientCharCfg);
+  GATTServApp_InitCharCfg(INVALID_CONNHANDLE,
+                          hidReportConsumerInClientCharCfg);
+  GATTServApp_InitCharCfg(INVALID_CONNHANDLE, hidReportMouseInClientCharCfg);
 
   // Register GATT attribute list and CBs with GATT Server App
   status = GATTServApp_RegisterService(hidAttrTbl, GATT_NUM_ATTRS(hidAttrTbl),
@@ -632,54 +806,20 @@ bStatus_t HidKbd_AddService(void)
                     &GATT_INCLUDED_HANDLE(hidAttrTbl, HID_INCLUDED_SERVICE_IDX));
 
   // Construct map of reports to characteristic handles
-  // Each report is uniquely identified via its ID and type
-
-  // Key input report
-  hidRptMap[0].id = hidReportRefKeyIn[0];
-  hidRptMap[0].type = hidReportRefKeyIn[1];
-  hidRptMap[0].handle = hidAttrTbl[HID_REPORT_KEY_IN_IDX].handle;
-  hidRptMap[0].pCccdAttr = &hidAttrTbl[HID_REPORT_KEY_IN_CCCD_IDX];
-  hidRptMap[0].mode = HID_PROTOCOL_MODE_REPORT;
-
-  // LED output report
-  hidRptMap[1].id = hidReportRefLedOut[0];
-  hidRptMap[1].type = hidReportRefLedOut[1];
-  hidRptMap[1].handle = hidAttrTbl[HID_REPORT_LED_OUT_IDX].handle;
-  hidRptMap[1].pCccdAttr = NULL;
-  hidRptMap[1].mode = HID_PROTOCOL_MODE_REPORT;
-
-  // Boot keyboard input report
-  // Use same ID and type as key input report
-  hidRptMap[2].id = hidReportRefKeyIn[0];
-  hidRptMap[2].type = hidReportRefKeyIn[1];
-  hidRptMap[2].handle = hidAttrTbl[HID_BOOT_KEY_IN_IDX].handle;
-  hidRptMap[2].pCccdAttr = &hidAttrTbl[HID_BOOT_KEY_IN_CCCD_IDX];
-  hidRptMap[2].mode = HID_PROTOCOL_MODE_BOOT;
-
-  // Boot keyboard output report
-  // Use same ID and type as LED output report
-  hidRptMap[3].id = hidReportRefLedOut[0];
-  hidRptMap[3].type = hidReportRefLedOut[1];
-  hidRptMap[3].handle = hidAttrTbl[HID_BOOT_KEY_OUT_IDX].handle;
-  hidRptMap[3].pCccdAttr = NULL;
-  hidRptMap[3].mode = HID_PROTOCOL_MODE_BOOT;
-
-  // Boot mouse input report
-  hidRptMap[4].id = HID_RPT_ID_MOUSE_IN;
-  hidRptMap[4].type = HID_REPORT_TYPE_INPUT;
-  hidRptMap[4].handle = hidAttrTbl[HID_BOOT_MOUSE_IN_IDX].handle;
-  hidRptMap[4].pCccdAttr = &hidAttrTbl[HID_BOOT_MOUSE_IN_CCCD_IDX];
-  hidRptMap[4].mode = HID_PROTOCOL_MODE_BOOT;
-
-  // Feature report
-  hidRptMap[5].id = hidReportRefFeature[0];
-  hidRptMap[5].type = hidReportRefFeature[1];
-  hidRptMap[5].handle = hidAttrTbl[HID_FEATURE_IDX].handle;
-  hidRptMap[5].pCccdAttr = NULL;
-  hidRptMap[5].mode = HID_PROTOCOL_MODE_REPORT;
+  // Each report is uniquely identified via its ID, type and protocol mode
+  for (i = 0; i < HID_NUM_RPT_ATTRS; i++)
+  {
+    hidRptMap[i].id = hidRptAttrs[i].id;
+    hidRptMap[i].type = hidRptAttrs[i].type;
+    hidRptMap[i].handle = hidAttrTbl[hidRptAttrs[i].idx].handle;
+    hidRptMap[i].pCccdAttr = hidRptAttrs[i].cccdIdx ?
+                             &hidAttrTbl[hidRptAttrs[i].cccdIdx] : NULL;
+    hidRptMap[i].mode = hidRptAttrs[i].mode;
+  }
 
   // Battery level input report
-  VOID Batt_GetParameter(BATT_PARAM_BATT_LEVEL_IN_REPORT, &(hidRptMap[6]));
+  VOID Batt_GetParameter(BATT_PARAM_BATT_LEVEL_IN_REPORT,
+                         &(hidRptMap[HID_NUM_RPT_ATTRS]));
 
   // Setup report ID map
   HidDev_RegisterReports(HID_NUM_REPORTS, hidRptMap);
@@ -711,9 +851,32 @@ uint8 HidKbd_SetParameter(uint8 id, uint8 type, uint16 uuid, uint8 len,
   switch (uuid)
   {
     case REPORT_UUID:
-      if (type ==  HID_REPORT_TYPE_OUTPUT)
+      if ((type == HID_REPORT_TYPE_OUTPUT) && (id == HID_RPT_ID_LIGHT_OUT))
       {
-        if (len == 1)
+        if (len == HID_LIGHT_OUT_RPT_LEN)
+        {
+          memcpy(hidReportLightOut, pValue, HID_LIGHT_OUT_RPT_LEN);
+        }
+        else
+        {
+          ret = ATT_ERR_INVALID_VALUE_SIZE;
+        }
+      }
+      else if ((type == HID_REPORT_TYPE_OUTPUT) &&
+               (id == HID_RPT_ID_EFFECT_OUT))
+      {
+        if (len == HID_EFFECT_OUT_RPT_LEN)
+        {
+          memcpy(hidReportEffectOut, pValue, HID_EFFECT_OUT_RPT_LEN);
+        }
+        else
+        {
+          ret = ATT_ERR_INVALID_VALUE_SIZE;
+        }
+      }
+      else if (type ==  HID_REPORT_TYPE_OUTPUT)
+      {
+        if (len == HID_LED_OUT_RPT_LEN)
         {
           hidReportLedOut = *((uint8 *)pValue);
         }
@@ -724,7 +887,7 @@ uint8 HidKbd_SetParameter(uint8 id, uint8 type, uint16 uuid, uint8 len,
       }
       else if (type == HID_REPORT_TYPE_FEATURE)
       {
-        if (len == 1)
+        if (len == HID_FEATURE_RPT_LEN)
         {
           hidReportFeature = *((uint8 *)pValue);
         }
@@ -740,7 +903,7 @@ uint8 HidKbd_SetParameter(uint8 id, uint8 type, uint16 uuid, uint8 len,
       break;
 
     case BOOT_KEY_OUTPUT_UUID:
-      if (len == 1)
+      if (len == HID_BOOT_KEY_OUT_RPT_LEN)
       {
         hidReportBootKeyOut = *((uint8 *)pValue);
       }
@@ -780,15 +943,26 @@ uint8 HidKbd_GetParameter(uint8 id, uint8 type, uint16 uuid, uint8 *pLen,
   switch (uuid)
   {
     case REPORT_UUID:
-      if (type ==  HID_REPORT_TYPE_OUTPUT)
+      if ((type == HID_REPORT_TYPE_OUTPUT) && (id == HID_RPT_ID_LIGHT_OUT))
+      {
+        memcpy(pValue, hidReportLightOut, HID_LIGHT_OUT_RPT_LEN);
+        *pLen = HID_LIGHT_OUT_RPT_LEN;
+      }
+      else if ((type == HID_REPORT_TYPE_OUTPUT) &&
+               (id == HID_RPT_ID_EFFECT_OUT))
+      {
+        memcpy(pValue, hidReportEffectOut, HID_EFFECT_OUT_RPT_LEN);
+        *pLen = HID_EFFECT_OUT_RPT_LEN;
+      }
+      else if (type ==  HID_REPORT_TYPE_OUTPUT)
       {
         *((uint8 *)pValue) = hidReportLedOut;
-        *pLen = 1;
+        *pLen = HID_LED_OUT_RPT_LEN;
       }
       else if (type == HID_REPORT_TYPE_FEATURE)
       {
         *((uint8 *)pValue) = hidReportFeature;
-        *pLen = 1;
+        *pLen = HID_FEATURE_RPT_LEN;
       }
       else
       {
@@ -798,7 +972,7 @@ uint8 HidKbd_GetParameter(uint8 id, uint8 type, uint16 uuid, uint8 *pLen,
 
     case BOOT_KEY_OUTPUT_UUID:
       *((uint8 *)pValue) = hidReportBootKeyOut;
-      *pLen = 1;
+      *pLen = HID_BOOT_KEY_OUT_RPT_LEN;
       break;
 
     default:
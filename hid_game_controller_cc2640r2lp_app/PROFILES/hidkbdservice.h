@@ -56,19 +56,13 @@ extern "C"
  * INCLUDES
  */
 
+// Report IDs, lengths and the number of reports, from TOOLS/hidreports.py
+#include "hidreportmap.h"
+
 /*********************************************************************
  * CONSTANTS
  */
 
-// Number of HID reports defined in the service
-#define HID_NUM_REPORTS          7
-
-// HID Report IDs for the service
-#define HID_RPT_ID_KEY_IN        0  // Keyboard input report ID
-#define HID_RPT_ID_MOUSE_IN      1  // Mouse input report ID
-#define HID_RPT_ID_LED_OUT       0  // LED output report ID
-#define HID_RPT_ID_FEATURE       0  // Feature report ID
-
 // HID feature flags
 #define HID_KBD_FLAGS             HID_FLAGS_REMOTE_WAKE
 
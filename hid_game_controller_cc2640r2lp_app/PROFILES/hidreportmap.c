@@ -0,0 +1,379 @@
+/******************************************************************************
+
+ @file       hidreportmap.c
+
+ @brief This file contains the report map of the HID service and the
+        functions packing and unpacking the reports.
+
+        Generated by TOOLS/hidgen.py from TOOLS/hidreports.py, edit the
+        spec and run hidgen.py instead of editing this file.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : HID report map generated from a report spec.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hidreportmap.h"
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Report map characteristic value
+const uint8_t hidReportMap[HID_REPORT_MAP_LEN] =
+{
+                    // keyboard
+  0x05, 0x01,       // Usage Page (0x01)
+  0x09, 0x06,       // Usage (0x06)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x01,       // Report ID (1)
+                    // key_in.modifiers
+  0x05, 0x07,       // Usage Page (0x07)
+  0x19, 0xE0,       // Usage Min (224)
+  0x29, 0xE7,       // Usage Max (231)
+  0x15, 0x00,       // Logical Min (0)
+  0x25, 0x01,       // Logical Max (1)
+  0x75, 0x01,       // Report Size (1)
+  0x95, 0x08,       // Report Count (8)
+  0x81, 0x02,       // Input (Data, Variable, Absolute)
+                    // key_in.pad
+  0x75, 0x08,       // Report Size (8)
+  0x95, 0x01,       // Report Count (1)
+  0x81, 0x01,       // Input (Constant)
+                    // key_in.keys
+  0x19, 0x00,       // Usage Min (0)
+  0x29, 0x65,       // Usage Max (101)
+  0x25, 0x65,       // Logical Max (101)
+  0x95, 0x06,       // Report Count (6)
+  0x81, 0x00,       // Input (Data, Array, Absolute)
+                    // led_out.leds
+  0x05, 0x08,       // Usage Page (0x08)
+  0x19, 0x01,       // Usage Min (1)
+  0x29, 0x05,       // Usage Max (5)
+  0x25, 0x01,       // Logical Max (1)
+  0x75, 0x01,       // Report Size (1)
+  0x95, 0x05,       // Report Count (5)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // led_out.pad
+  0x75, 0x03,       // Report Size (3)
+  0x95, 0x01,       // Report Count (1)
+  0x91, 0x01,       // Output (Constant)
+                    // feature.value
+  0x06, 0x00, 0xFF, // Usage Page (0xFF00)
+  0x09, 0x01,       // Usage (0x01)
+  0x26, 0xFF, 0x00, // Logical Max (255)
+  0x75, 0x08,       // Report Size (8)
+  0xB1, 0x02,       // Feature (Data, Variable, Absolute)
+  0xC0,             // End Collection
+                    // gamepad
+  0x05, 0x01,       // Usage Page (0x01)
+  0x09, 0x05,       // Usage (0x05)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x02,       // Report ID (2)
+                    // gamepad_in.buttons
+  0x05, 0x09,       // Usage Page (0x09)
+  0x19, 0x01,       // Usage Min (1)
+  0x29, 0x08,       // Usage Max (8)
+  0x15, 0x00,       // Logical Min (0)
+  0x25, 0x01,       // Logical Max (1)
+  0x75, 0x01,       // Report Size (1)
+  0x95, 0x08,       // Report Count (8)
+  0x81, 0x02,       // Input (Data, Variable, Absolute)
+                    // gamepad_in.x
+  0x05, 0x01,       // Usage Page (0x01)
+  0x09, 0x30,       // Usage (0x30)
+  0x15, 0x81,       // Logical Min (-127)
+  0x25, 0x7F,       // Logical Max (127)
+  0x75, 0x08,       // Report Size (8)
+  0x95, 0x01,       // Report Count (1)
+  0x81, 0x02,       // Input (Data, Variable, Absolute)
+                    // gamepad_in.y
+  0x09, 0x31,       // Usage (0x31)
+  0x81, 0x02,       // Input (Data, Variable, Absolute)
+  0xC0,             // End Collection
+                    // consumer
+  0x05, 0x0C,       // Usage Page (0x0C)
+  0x09, 0x01,       // Usage (0x01)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x03,       // Report ID (3)
+                    // consumer_in.usage
+  0x19, 0x00,       // Usage Min (0)
+  0x2A, 0x9C, 0x02, // Usage Max (668)
+  0x15, 0x00,       // Logical Min (0)
+  0x26, 0x9C, 0x02, // Logical Max (668)
+  0x75, 0x10,       // Report Size (16)
+  0x95, 0x01,       // Report Count (1)
+  0x81, 0x00,       // Input (Data, Array, Absolute)
+  0xC0,             // End Collection
+                    // mouse
+  0x05, 0x01,       // Usage Page (0x01)
+  0x09, 0x02,       // Usage (0x02)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x05,       // Report ID (5)
+                    // mouse_in.buttons
+  0x05, 0x09,       // Usage Page (0x09)
+  0x19, 0x01,       // Usage Min (1)
+  0x29, 0x03,       // Usage Max (3)
+  0x15, 0x00,       // Logical Min (0)
+  0x25, 0x01,       // Logical Max (1)
+  0x75, 0x01,       // Report Size (1)
+  0x95, 0x03,       // Report Count (3)
+  0x81, 0x02,       // Input (Data, Variable, Absolute)
+                    // mouse_in.pad
+  0x75, 0x05,       // Report Size (5)
+  0x95, 0x01,       // Report Count (1)
+  0x81, 0x01,       // Input (Constant)
+                    // mouse_in.x
+  0x05, 0x01,       // Usage Page (0x01)
+  0x09, 0x30,       // Usage (0x30)
+  0x15, 0x81,       // Logical Min (-127)
+  0x25, 0x7F,       // Logical Max (127)
+  0x75, 0x08,       // Report Size (8)
+  0x81, 0x06,       // Input (Data, Variable, Relative)
+                    // mouse_in.y
+  0x09, 0x31,       // Usage (0x31)
+  0x81, 0x06,       // Input (Data, Variable, Relative)
+                    // mouse_in.wheel
+  0x09, 0x38,       // Usage (0x38)
+  0x81, 0x06,       // Input (Data, Variable, Relative)
+                    // mouse_in.pan
+  0x05, 0x0C,       // Usage Page (0x0C)
+  0x0A, 0x38, 0x02, // Usage (0x238)
+  0x81, 0x06,       // Input (Data, Variable, Relative)
+  0xC0,             // End Collection
+                    // lights
+  0x06, 0x00, 0xFF, // Usage Page (0xFF00)
+  0x09, 0x02,       // Usage (0x02)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x06,       // Report ID (6)
+                    // light_out.pattern
+  0x09, 0x10,       // Usage (0x10)
+  0x15, 0x00,       // Logical Min (0)
+  0x26, 0xFF, 0x00, // Logical Max (255)
+  0x75, 0x08,       // Report Size (8)
+  0x95, 0x01,       // Report Count (1)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // light_out.player
+  0x09, 0x11,       // Usage (0x11)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // light_out.red
+  0x09, 0x12,       // Usage (0x12)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // light_out.green
+  0x09, 0x13,       // Usage (0x13)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // light_out.blue
+  0x09, 0x14,       // Usage (0x14)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // light_out.period
+  0x09, 0x15,       // Usage (0x15)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+  0xC0,             // End Collection
+                    // effects
+  0x06, 0x00, 0xFF, // Usage Page (0xFF00)
+  0x09, 0x03,       // Usage (0x03)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x07,       // Report ID (7)
+                    // effect_out.command
+  0x09, 0x20,       // Usage (0x20)
+  0x15, 0x00,       // Logical Min (0)
+  0x26, 0xFF, 0x00, // Logical Max (255)
+  0x75, 0x08,       // Report Size (8)
+  0x95, 0x01,       // Report Count (1)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // effect_out.frequency
+  0x09, 0x21,       // Usage (0x21)
+  0x26, 0x20, 0x4E, // Logical Max (20000)
+  0x75, 0x10,       // Report Size (16)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // effect_out.duration
+  0x09, 0x22,       // Usage (0x22)
+  0x26, 0x10, 0x27, // Logical Max (10000)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // effect_out.level
+  0x09, 0x23,       // Usage (0x23)
+  0x26, 0xFF, 0x00, // Logical Max (255)
+  0x75, 0x08,       // Report Size (8)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // effect_out.attack
+  0x09, 0x24,       // Usage (0x24)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+                    // effect_out.fade
+  0x09, 0x25,       // Usage (0x25)
+  0x91, 0x02,       // Output (Data, Variable, Absolute)
+  0xC0              // End Collection
+};
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      HidRpt_packKeyIn
+ *
+ * @brief   Pack a key_in report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_KEY_IN_RPT_LEN bytes
+ *
+ * @return  none
+ */
+void HidRpt_packKeyIn(const hidKeyInRpt_t *pRpt, uint8_t *pBuf)
+{
+  pBuf[0] = (uint8_t)pRpt->modifiers;
+  pBuf[2] = (uint8_t)pRpt->keys[0];
+  pBuf[3] = (uint8_t)pRpt->keys[1];
+  pBuf[4] = (uint8_t)pRpt->keys[2];
+  pBuf[5] = (uint8_t)pRpt->keys[3];
+  pBuf[6] = (uint8_t)pRpt->keys[4];
+  pBuf[7] = (uint8_t)pRpt->keys[5];
+  pBuf[1] = 0;
+}
+
+/*********************************************************************
+ * @fn      HidRpt_unpackLedOut
+ *
+ * @brief   Unpack a led_out report.
+ *
+ * @param   pBuf - HID_LED_OUT_RPT_LEN bytes
+ * @param   pRpt - report
+ *
+ * @return  none
+ */
+void HidRpt_unpackLedOut(const uint8_t *pBuf, hidLedOutRpt_t *pRpt)
+{
+  pRpt->leds = (uint8_t)(pBuf[0] & 0x1F);
+}
+
+/*********************************************************************
+ * @fn      HidRpt_packFeature
+ *
+ * @brief   Pack a feature report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_FEATURE_RPT_LEN bytes
+ *
+ * @return  none
+ */
+void HidRpt_packFeature(const hidFeatureRpt_t *pRpt, uint8_t *pBuf)
+{
+  pBuf[0] = (uint8_t)pRpt->value;
+}
+
+/*********************************************************************
+ * @fn      HidRpt_unpackFeature
+ *
+ * @brief   Unpack a feature report.
+ *
+ * @param   pBuf - HID_FEATURE_RPT_LEN bytes
+ * @param   pRpt - report
+ *
+ * @return  none
+ */
+void HidRpt_unpackFeature(const uint8_t *pBuf, hidFeatureRpt_t *pRpt)
+{
+  pRpt->value = (uint8_t)pBuf[0];
+}
+
+/*********************************************************************
+ * @fn      HidRpt_packGamepadIn
+ *
+ * @brief   Pack a gamepad_in report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_GAMEPAD_IN_RPT_LEN bytes
+ *
+ * @return  none
+ */
+void HidRpt_packGamepadIn(const hidGamepadInRpt_t *pRpt, uint8_t *pBuf)
+{
+  pBuf[0] = (uint8_t)pRpt->buttons;
+  pBuf[1] = (uint8_t)pRpt->x;
+  pBuf[2] = (uint8_t)pRpt->y;
+}
+
+/*********************************************************************
+ * @fn      HidRpt_packConsumerIn
+ *
+ * @brief   Pack a consumer_in report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_CONSUMER_IN_RPT_LEN bytes
+ *
+ * @return  none
+ */
+void HidRpt_packConsumerIn(const hidConsumerInRpt_t *pRpt, uint8_t *pBuf)
+{
+  pBuf[0] = (uint8_t)(uint32_t)pRpt->usage;
+  pBuf[1] = (uint8_t)((uint32_t)pRpt->usage >> 8);
+}
+
+/*********************************************************************
+ * @fn      HidRpt_packMouseIn
+ *
+ * @brief   Pack a mouse_in report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_MOUSE_IN_RPT_LEN bytes
+ *
+ * @return  none
+ */
+void HidRpt_packMouseIn(const hidMouseInRpt_t *pRpt, uint8_t *pBuf)
+{
+  pBuf[0] = (uint8_t)((uint32_t)pRpt->buttons & 0x7);
+  pBuf[1] = (uint8_t)pRpt->x;
+  pBuf[2] = (uint8_t)pRpt->y;
+  pBuf[3] = (uint8_t)pRpt->wheel;
+  pBuf[4] = (uint8_t)pRpt->pan;
+}
+
+/*********************************************************************
+ * @fn      HidRpt_unpackLightOut
+ *
+ * @brief   Unpack a light_out report.
+ *
+ * @param   pBuf - HID_LIGHT_OUT_RPT_LEN bytes
+ * @param   pRpt - report
+ *
+ * @return  none
+ */
+void HidRpt_unpackLightOut(const uint8_t *pBuf, hidLightOutRpt_t *pRpt)
+{
+  pRpt->pattern = (uint8_t)pBuf[0];
+  pRpt->player = (uint8_t)pBuf[1];
+  pRpt->red = (uint8_t)pBuf[2];
+  pRpt->green = (uint8_t)pBuf[3];
+  pRpt->blue = (uint8_t)pBuf[4];
+  pRpt->period = (uint8_t)pBuf[5];
+}
+
+/*********************************************************************
+ * @fn      HidRpt_unpackEffectOut
+ *
+ * @brief   Unpack a effect_out report.
+ *
+ * @param   pBuf - HID_EFFECT_OUT_RPT_LEN bytes
+ * @param   pRpt - report
+ *
+ * @return  none
+ */
+void HidRpt_unpackEffectOut(const uint8_t *pBuf, hidEffectOutRpt_t *pRpt)
+{
+  pRpt->command = (uint8_t)pBuf[0];
+  pRpt->frequency = (uint16_t)(pBuf[1] | ((uint32_t)pBuf[2] << 8));
+  pRpt->duration = (uint16_t)(pBuf[3] | ((uint32_t)pBuf[4] << 8));
+  pRpt->level = (uint8_t)pBuf[5];
+  pRpt->attack = (uint8_t)pBuf[6];
+  pRpt->fade = (uint8_t)pBuf[7];
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,301 @@
+/******************************************************************************
+
+ @file       hidreportmap.h
+
+ @brief This file contains the report IDs and lengths of the HID service,
+        the report map table entries and the functions packing the
+        reports.
+
+        Generated by TOOLS/hidgen.py from TOOLS/hidreports.py, edit the
+        spec and run hidgen.py instead of editing this file.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : HID report map generated from a report spec.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+#ifndef HIDREPORTMAP_H
+#define HIDREPORTMAP_H
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Report IDs
+#define HID_RPT_ID_KEY_IN          1
+#define HID_RPT_ID_LED_OUT         1
+#define HID_RPT_ID_FEATURE         1
+#define HID_RPT_ID_GAMEPAD_IN      2
+#define HID_RPT_ID_CONSUMER_IN     3
+#define HID_RPT_ID_MOUSE_IN        5
+#define HID_RPT_ID_LIGHT_OUT       6
+#define HID_RPT_ID_EFFECT_OUT      7
+
+// Report lengths, without the report ID
+#define HID_KEY_IN_RPT_LEN         8
+#define HID_LED_OUT_RPT_LEN        1
+#define HID_FEATURE_RPT_LEN        1
+#define HID_GAMEPAD_IN_RPT_LEN     3
+#define HID_CONSUMER_IN_RPT_LEN    2
+#define HID_MOUSE_IN_RPT_LEN       5
+#define HID_LIGHT_OUT_RPT_LEN      6
+#define HID_EFFECT_OUT_RPT_LEN     8
+#define HID_BOOT_KEY_IN_RPT_LEN    8
+#define HID_BOOT_KEY_OUT_RPT_LEN   1
+#define HID_BOOT_MOUSE_IN_RPT_LEN  5
+
+// Longest input report
+#define HID_RPT_MAX_IN_LEN         8
+
+// Length of the report map
+#define HID_REPORT_MAP_LEN         298
+
+// CRC of the report map and of the report characteristics, a host bonded
+// under another layout has to discover the service again
+#define HID_LAYOUT_CRC             0xDDA9
+
+// Report characteristics of the HID service, and reports of other services
+// in the report map table
+#define HID_NUM_RPT_ATTRS          11
+#define HID_NUM_REPORTS            (HID_NUM_RPT_ATTRS + 1)
+
+// Report map table entries of the report characteristics: ID, type,
+// protocol mode, index of the characteristic and of its CCCD, 0 when it has
+// none, in the attribute table of the service
+#define HID_RPT_ATTRS                                                       \
+  { HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT, HID_PROTOCOL_MODE_REPORT,     \
+    HID_REPORT_KEY_IN_IDX, HID_REPORT_KEY_IN_CCCD_IDX },                    \
+  { HID_RPT_ID_LED_OUT, HID_REPORT_TYPE_OUTPUT, HID_PROTOCOL_MODE_REPORT,   \
+    HID_REPORT_LED_OUT_IDX, 0 },                                            \
+  { HID_RPT_ID_FEATURE, HID_REPORT_TYPE_FEATURE, HID_PROTOCOL_MODE_REPORT,  \
+    HID_FEATURE_IDX, 0 },                                                   \
+  { HID_RPT_ID_GAMEPAD_IN, HID_REPORT_TYPE_INPUT, HID_PROTOCOL_MODE_REPORT, \
+    HID_REPORT_GAMEPAD_IN_IDX, HID_REPORT_GAMEPAD_IN_CCCD_IDX },            \
+  { HID_RPT_ID_CONSUMER_IN, HID_REPORT_TYPE_INPUT, HID_PROTOCOL_MODE_REPORT, \
+    HID_REPORT_CONSUMER_IN_IDX, HID_REPORT_CONSUMER_IN_CCCD_IDX },          \
+  { HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT, HID_PROTOCOL_MODE_REPORT,   \
+    HID_REPORT_MOUSE_IN_IDX, HID_REPORT_MOUSE_IN_CCCD_IDX },                \
+  { HID_RPT_ID_LIGHT_OUT, HID_REPORT_TYPE_OUTPUT, HID_PROTOCOL_MODE_REPORT, \
+    HID_REPORT_LIGHT_OUT_IDX, 0 },                                          \
+  { HID_RPT_ID_EFFECT_OUT, HID_REPORT_TYPE_OUTPUT, HID_PROTOCOL_MODE_REPORT, \
+    HID_REPORT_EFFECT_OUT_IDX, 0 },                                         \
+  { HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT, HID_PROTOCOL_MODE_BOOT,       \
+    HID_BOOT_KEY_IN_IDX, HID_BOOT_KEY_IN_CCCD_IDX },                        \
+  { HID_RPT_ID_LED_OUT, HID_REPORT_TYPE_OUTPUT, HID_PROTOCOL_MODE_BOOT,     \
+    HID_BOOT_KEY_OUT_IDX, 0 },                                              \
+  { HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT, HID_PROTOCOL_MODE_BOOT,     \
+    HID_BOOT_MOUSE_IN_IDX, HID_BOOT_MOUSE_IN_CCCD_IDX }
+
+// Input reports with relative fields, sent even when equal to the last one
+#define HID_RPT_IS_RELATIVE(id, type)                                       \
+  (((type) == HID_REPORT_TYPE_INPUT) && (((id) == HID_RPT_ID_MOUSE_IN)))
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// key_in report
+typedef struct
+{
+  uint8_t   modifiers;
+  uint8_t   keys[6];
+} hidKeyInRpt_t;
+
+// led_out report
+typedef struct
+{
+  uint8_t   leds;
+} hidLedOutRpt_t;
+
+// feature report
+typedef struct
+{
+  uint8_t   value;
+} hidFeatureRpt_t;
+
+// gamepad_in report
+typedef struct
+{
+  uint8_t   buttons;
+  int8_t    x;
+  int8_t    y;
+} hidGamepadInRpt_t;
+
+// consumer_in report
+typedef struct
+{
+  uint16_t  usage;
+} hidConsumerInRpt_t;
+
+// mouse_in report
+typedef struct
+{
+  uint8_t   buttons;
+  int8_t    x;
+  int8_t    y;
+  int8_t    wheel;
+  int8_t    pan;
+} hidMouseInRpt_t;
+
+// light_out report
+typedef struct
+{
+  uint8_t   pattern;
+  uint8_t   player;
+  uint8_t   red;
+  uint8_t   green;
+  uint8_t   blue;
+  uint8_t   period;
+} hidLightOutRpt_t;
+
+// effect_out report
+typedef struct
+{
+  uint8_t   command;
+  uint16_t  frequency;
+  uint16_t  duration;
+  uint8_t   level;
+  uint8_t   attack;
+  uint8_t   fade;
+} hidEffectOutRpt_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Report map characteristic value
+extern const uint8_t hidReportMap[HID_REPORT_MAP_LEN];
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      HidRpt_packKeyIn
+ *
+ * @brief   Pack a key_in report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_KEY_IN_RPT_LEN bytes
+ *
+ * @return  none
+ */
+extern void HidRpt_packKeyIn(const hidKeyInRpt_t *pRpt, uint8_t *pBuf);
+
+/*********************************************************************
+ * @fn      HidRpt_unpackLedOut
+ *
+ * @brief   Unpack a led_out report.
+ *
+ * @param   pBuf - HID_LED_OUT_RPT_LEN bytes
+ * @param   pRpt - report
+ *
+ * @return  none
+ */
+extern void HidRpt_unpackLedOut(const uint8_t *pBuf, hidLedOutRpt_t *pRpt);
+
+/*********************************************************************
+ * @fn      HidRpt_packFeature
+ *
+ * @brief   Pack a feature report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_FEATURE_RPT_LEN bytes
+ *
+ * @return  none
+ */
+extern void HidRpt_packFeature(const hidFeatureRpt_t *pRpt, uint8_t *pBuf);
+
+/*********************************************************************
+ * @fn      HidRpt_unpackFeature
+ *
+ * @brief   Unpack a feature report.
+ *
+ * @param   pBuf - HID_FEATURE_RPT_LEN bytes
+ * @param   pRpt - report
+ *
+ * @return  none
+ */
+extern void HidRpt_unpackFeature(const uint8_t *pBuf, hidFeatureRpt_t *pRpt);
+
+/*********************************************************************
+ * @fn      HidRpt_packGamepadIn
+ *
+ * @brief   Pack a gamepad_in report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_GAMEPAD_IN_RPT_LEN bytes
+ *
+ * @return  none
+ */
+extern void HidRpt_packGamepadIn(const hidGamepadInRpt_t *pRpt, uint8_t *pBuf);
+
+/*********************************************************************
+ * @fn      HidRpt_packConsumerIn
+ *
+ * @brief   Pack a consumer_in report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_CONSUMER_IN_RPT_LEN bytes
+ *
+ * @return  none
+ */
+extern void HidRpt_packConsumerIn(const hidConsumerInRpt_t *pRpt, uint8_t *pBuf);
+
+/*********************************************************************
+ * @fn      HidRpt_packMouseIn
+ *
+ * @brief   Pack a mouse_in report.
+ *
+ * @param   pRpt - report
+ * @param   pBuf - HID_MOUSE_IN_RPT_LEN bytes
+ *
+ * @return  none
+ */
+extern void HidRpt_packMouseIn(const hidMouseInRpt_t *pRpt, uint8_t *pBuf);
+
+/*********************************************************************
+ * @fn      HidRpt_unpackLightOut
+ *
+ * @brief   Unpack a light_out report.
+ *
+ * @param   pBuf - HID_LIGHT_OUT_RPT_LEN bytes
+ * @param   pRpt - report
+ *
+ * @return  none
+ */
+extern void HidRpt_unpackLightOut(const uint8_t *pBuf, hidLightOutRpt_t *pRpt);
+
+/*********************************************************************
+ * @fn      HidRpt_unpackEffectOut
+ *
+ * @brief   Unpack a effect_out report.
+ *
+ * @param   pBuf - HID_EFFECT_OUT_RPT_LEN bytes
+ * @param   pRpt - report
+ *
+ * @return  none
+ */
+extern void HidRpt_unpackEffectOut(const uint8_t *pBuf, hidEffectOutRpt_t *pRpt);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIDREPORTMAP_H */
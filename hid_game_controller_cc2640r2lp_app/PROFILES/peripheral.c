@@ -106,6 +106,22 @@
 
 #define MAX_TIMEOUT_VALUE             0xFFFF
 
+// Connection parameter negotiation
+#define PARAM_UPDATE_RUNG_ATTEMPTS    2       // Requests per ladder rung
+#define PARAM_UPDATE_BACKOFF_MIN      1000    // First retry delay (ms)
+#define PARAM_UPDATE_BACKOFF_MAX      32000   // Longest retry delay (ms)
+#define PARAM_UPDATE_RUNG_UNKNOWN     0xFF
+#define PARAM_UPDATE_MAX_RUNGS        PARAM_UPDATE_RUNG_UNKNOWN
+
+// Negotiation modes
+#define PARAM_NEGOTIATION_IDLE        0       // No retries
+#define PARAM_NEGOTIATION_LADDER      1       // Walking the parameter ladder
+#define PARAM_NEGOTIATION_RESEND      2       // Resending an application set
+#define PARAM_NEGOTIATION_HELD        3       // Ladder walk held by an application set
+
+// NV item holding the ladder rung accepted by each bond
+#define GAPROLE_NVID_PARAM_RUNGS      BLE_NVID_CUST_START
+
 // Task configuration
 #define GAPROLE_TASK_PRIORITY         3
 
@@ -233,6 +249,18 @@ static uint8_t  gapRole_ConnTermReason = 0;
 
 static uint8_t paramUpdateNoSuccessOption = GAPROLE_NO_ACTION;
 
+// Connection parameter negotiation
+static const gapRoleConnParams_t *pGapRole_paramLadder = NULL;
+static uint8_t  gapRole_paramLadderLen = 0;
+static uint8_t  gapRole_paramNegotiation = PARAM_NEGOTIATION_IDLE;
+static uint8_t  gapRole_paramRung = 0;
+static uint8_t  gapRole_paramRungAttempts = 0;
+static uint16_t gapRole_paramBackoff = PARAM_UPDATE_BACKOFF_MIN;
+static gapRole_updateConnParams_t gapRole_paramPending;
+
+// Ladder rung accepted by each bonded central, indexed by bond
+static uint8_t  gapRole_bondParamRung[GAP_BONDINGS_MAX];
+
 // Application callbacks
 static gapRolesCBs_t *pGapRoles_AppCGs = NULL;
 static gapRolesParamUpdateCB_t *pGapRoles_ParamUpdateCB = NULL;
@@ -257,6 +285,14 @@ static void      gapRole_SetupGAP(void);
 static void      gapRole_HandleParamUpdateNoSuccess(void);
 static bStatus_t gapRole_startConnUpdate(uint8_t handleFailure,
                                        gapRole_updateConnParams_t *pConnParams);
+static void      gapRole_getRungParams(uint8_t rung,
+                                       gapRole_updateConnParams_t *pConnParams);
+static uint8_t   gapRole_bondIndex(void);
+static void      gapRole_startParamNegotiation(void);
+static void      gapRole_requestPendingParams(void);
+static void      gapRole_paramNegotiationBackoff(void);
+static void      gapRole_paramNegotiationDone(uint8_t accepted);
+static uint8_t   gapRole_paramsMatch(gapRole_updateConnParams_t *pConnParams);
 
 static void gapRole_setEvent(uint32_t event);
 
@@ -576,8 +612,24 @@ bStatus_t GAPRole_SetParameter(uint16_t param, uint8_t len, void *pValue)
             // Update Response being received.
             if (Util_isActive(&updateTimeoutClock) == FALSE)
             {
-              // Start connection update procedure
-              ret = gapRole_startConnUpdate(GAPROLE_NO_ACTION, &gapRole_updateConnParams);
+              gapRole_updateConnParams_t rungParams;
+
+              // Request the ladder rung being negotiated (or accepted) rather
+              // than a set the central already turned down.
+              gapRole_getRungParams(gapRole_paramRung, &rungParams);
+
+              if (gapRole_paramNegotiation == PARAM_NEGOTIATION_LADDER)
+              {
+                gapRole_paramPending = rungParams;
+                ret = gapRole_startConnUpdate(GAPROLE_RESEND_PARAM_UPDATE,
+                                              &gapRole_paramPending);
+              }
+              else
+              {
+                // Start connection update procedure
+                ret = gapRole_startConnUpdate(GAPROLE_NO_ACTION, &rungParams);
+              }
+
               if (ret == SUCCESS)
               {
                 // Connection update requested by app, cancel such pending procedure (if active)
@@ -865,6 +917,10 @@ static void gapRole_init(void)
   Util_constructClock(&updateTimeoutClock, gapRole_clockHandler,
                       0, 0, false, CONN_PARAM_TIMEOUT_EVT);
 
+  // Connection parameter sets accepted by bonded centrals
+  VOID memset(gapRole_bondParamRung, PARAM_UPDATE_RUNG_UNKNOWN,
+              sizeof(gapRole_bondParamRung));
+
   // Initialize the Profile Advertising and Connection Parameters
   gapRole_profileRole = GAP_PROFILE_PERIPHERAL;
   VOID memset(gapRole_IRK, 0, KEYLEN);
@@ -880,6 +936,8 @@ static void gapRole_init(void)
   VOID osal_snv_read(BLE_NVID_CSRK, KEYLEN, gapRole_SRK);
   VOID osal_snv_read(BLE_NVID_SIGNCOUNTER, sizeof(uint32_t),
                      &gapRole_signCounter);
+  VOID osal_snv_read(GAPROLE_NVID_PARAM_RUNGS, sizeof(gapRole_bondParamRung),
+                     gapRole_bondParamRung);
 }
 
 /*********************************************************************
@@ -979,8 +1037,21 @@ static void gapRole_taskFxn(UArg a0, UArg a1)
 
       if (events & START_CONN_UPDATE_EVT)
       {
-        // Start connection update procedure
-        gapRole_startConnUpdate(GAPROLE_NO_ACTION, &gapRole_updateConnParams);
+        if (gapRole_paramNegotiation == PARAM_NEGOTIATION_IDLE)
+        {
+          // Start connection update procedure
+          gapRole_startConnUpdate(GAPROLE_NO_ACTION, &gapRole_updateConnParams);
+        }
+        else if (gapRole_paramNegotiation != PARAM_NEGOTIATION_HELD)
+        {
+          // Next attempt of the connection parameter negotiation
+          if (gapRole_paramNegotiation == PARAM_NEGOTIATION_LADDER)
+          {
+            gapRole_getRungParams(gapRole_paramRung, &gapRole_paramPending);
+          }
+
+          gapRole_requestPendingParams();
+        }
       }
 
       if (events & CONN_PARAM_TIMEOUT_EVT)
@@ -1027,6 +1098,15 @@ static void gapRole_processStackMsg(ICall_Hdr *pMsg)
             // Terminate connection immediately
             GAPRole_TerminateConnection();
           }
+          else if ((pRsp->result == L2CAP_CONN_PARAMS_REJECTED) &&
+                   (paramUpdateNoSuccessOption == GAPROLE_RESEND_PARAM_UPDATE))
+          {
+            // Cancel connection param update timeout timer
+            Util_stopClock(&updateTimeoutClock);
+
+            // No need to wait for the timeout, back off right away
+            gapRole_HandleParamUpdateNoSuccess();
+          }
           else
           {
             uint16_t timeout = GAP_GetParamValue(TGAP_CONN_PARAM_TIMEOUT);
@@ -1218,6 +1298,9 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
             // peripheral can start a connection update procedure.
             uint16_t timeout = GAP_GetParamValue(TGAP_CONN_PAUSE_PERIPHERAL);
 
+            // Start with the set this central accepted last time, if known
+            gapRole_startParamNegotiation();
+
             Util_restartClock(&startUpdateClock, timeout*1000);
           }
 
@@ -1259,6 +1342,7 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
         // Cancel all connection parameter update timers (if any active)
         Util_stopClock(&startUpdateClock);
         Util_stopClock(&updateTimeoutClock);
+        gapRole_paramNegotiation = PARAM_NEGOTIATION_IDLE;
 
         notify = TRUE;
 
@@ -1292,6 +1376,9 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
       {
         gapLinkUpdateEvent_t *pPkt = (gapLinkUpdateEvent_t *)pMsg;
 
+        // Was this the outcome of our own request?
+        uint8_t updateRequested = Util_isActive(&updateTimeoutClock);
+
         // Cancel connection param update timeout timer (if active)
         Util_stopClock(&updateTimeoutClock);
 
@@ -1302,6 +1389,21 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
           gapRole_ConnSlaveLatency = pPkt->connLatency;
           gapRole_ConnTimeout = pPkt->connTimeout;
 
+          if (updateRequested &&
+              ((gapRole_paramNegotiation == PARAM_NEGOTIATION_LADDER) ||
+               (gapRole_paramNegotiation == PARAM_NEGOTIATION_RESEND)))
+          {
+            if (gapRole_paramsMatch(&gapRole_paramPending))
+            {
+              gapRole_paramNegotiationDone(TRUE);
+            }
+            else
+            {
+              // The central picked something else, treat as not accepted
+              gapRole_HandleParamUpdateNoSuccess();
+            }
+          }
+
           // Make sure there's no pending connection update procedure
           if(Util_isActive(&startUpdateClock) == FALSE)
           {
@@ -1413,6 +1515,16 @@ static void gapRole_processGAPMsg(gapEventHdr_t *pMsg)
 
         // Send application's requested parameters back.
         VOID GAP_UpdateLinkParamReqReply(&rsp);
+
+        // A negotiation waiting for its next attempt goes on once the
+        // central's update is done, no request of ours is in flight
+        if (rsp.accepted &&
+            ((gapRole_paramNegotiation == PARAM_NEGOTIATION_LADDER) ||
+             (gapRole_paramNegotiation == PARAM_NEGOTIATION_RESEND)) &&
+            !Util_isActive(&updateTimeoutClock))
+        {
+          Util_restartClock(&startUpdateClock, gapRole_paramBackoff);
+        }
       }
       break;
 
@@ -1461,11 +1573,8 @@ static void gapRole_HandleParamUpdateNoSuccess(void)
   switch (paramUpdateNoSuccessOption)
   {
     case GAPROLE_RESEND_PARAM_UPDATE:
-      GAPRole_SendUpdateParam(gapRole_updateConnParams.minConnInterval,
-                              gapRole_updateConnParams.maxConnInterval,
-                              gapRole_updateConnParams.slaveLatency,
-                              gapRole_updateConnParams.timeoutMultiplier,
-                              GAPROLE_RESEND_PARAM_UPDATE);
+      // Retry later, possibly with an easier parameter set
+      gapRole_paramNegotiationBackoff();
       break;
 
     case GAPROLE_TERMINATE_LINK:
@@ -1585,20 +1694,346 @@ bStatus_t GAPRole_SendUpdateParam(uint16_t minConnInterval,
   else
   {
     gapRole_updateConnParams_t paramUpdate;
+    bStatus_t status;
 
     paramUpdate.minConnInterval = minConnInterval;
     paramUpdate.maxConnInterval = maxConnInterval;
     paramUpdate.slaveLatency = latency;
     paramUpdate.timeoutMultiplier = connTimeout;
 
-    // Connection update requested by app, cancel such pending procedure (if active)
-    Util_stopClock(&startUpdateClock);
+    // A set resent until accepted replaces any ongoing negotiation
+    if (handleFailure == GAPROLE_RESEND_PARAM_UPDATE)
+    {
+      // Connection update requested by app, cancel such pending procedure (if active)
+      Util_stopClock(&startUpdateClock);
+
+      gapRole_paramNegotiation = PARAM_NEGOTIATION_RESEND;
+      gapRole_paramBackoff = PARAM_UPDATE_BACKOFF_MIN;
+      gapRole_paramPending = paramUpdate;
+
+      // Start connection update procedure
+      return gapRole_startConnUpdate(handleFailure, &paramUpdate);
+    }
 
     // Start connection update procedure
-    return gapRole_startConnUpdate(handleFailure, &paramUpdate);
+    status = gapRole_startConnUpdate(handleFailure, &paramUpdate);
+
+    // Once the set is requested or in use, a ladder walk in progress is held
+    // at its rung until GAPRole_ResumeParamNegotiation, a resend ends
+    if ((status == SUCCESS) || (status == bleInvalidRange))
+    {
+      Util_stopClock(&startUpdateClock);
+
+      if ((gapRole_paramNegotiation == PARAM_NEGOTIATION_LADDER) ||
+          (gapRole_paramNegotiation == PARAM_NEGOTIATION_HELD))
+      {
+        gapRole_paramNegotiation = PARAM_NEGOTIATION_HELD;
+      }
+      else
+      {
+        gapRole_paramNegotiation = PARAM_NEGOTIATION_IDLE;
+      }
+    }
+
+    return status;
   }
 }
 
+/********************************************************************
+ * @fn          GAPRole_ResumeParamNegotiation
+ *
+ * @brief       Resume the ladder walk held by GAPRole_SendUpdateParam at
+ *              the rung where it was held.
+ *
+ * @param       none
+ *
+ * @return      SUCCESS: the walk goes on.
+ *              bleIncorrectMode: no walk was held, it had ended before.
+ */
+bStatus_t GAPRole_ResumeParamNegotiation(void)
+{
+  if (gapRole_paramNegotiation != PARAM_NEGOTIATION_HELD)
+  {
+    return (bleIncorrectMode);
+  }
+
+  gapRole_paramNegotiation = PARAM_NEGOTIATION_LADDER;
+  gapRole_paramBackoff = PARAM_UPDATE_BACKOFF_MIN;
+  gapRole_getRungParams(gapRole_paramRung, &gapRole_paramPending);
+
+  if (Util_isActive(&updateTimeoutClock))
+  {
+    // Let the application's request complete first
+    Util_restartClock(&startUpdateClock, PARAM_UPDATE_BACKOFF_MIN);
+  }
+  else
+  {
+    gapRole_requestPendingParams();
+  }
+
+  return (SUCCESS);
+}
+
+/********************************************************************
+ * @fn          GAPRole_SetParamUpdateLadder
+ *
+ * @brief       Register the ladder of connection parameter sets walked by
+ *              the connection parameter negotiation.
+ *
+ * @param       pLadder - parameter sets, most preferred first
+ * @param       numRungs - number of entries in pLadder
+ *
+ * @return      SUCCESS or bleInvalidRange
+ */
+bStatus_t GAPRole_SetParamUpdateLadder(const gapRoleConnParams_t *pLadder,
+                                       uint8_t numRungs)
+{
+  if ((pLadder == NULL) || (numRungs == 0) ||
+      (numRungs > PARAM_UPDATE_MAX_RUNGS))
+  {
+    return (bleInvalidRange);
+  }
+
+  pGapRole_paramLadder = pLadder;
+  gapRole_paramLadderLen = numRungs;
+
+  return (SUCCESS);
+}
+
+/********************************************************************
+ * @fn          GAPRole_ForgetBondParams
+ *
+ * @brief       Forget the ladder rung accepted by bonded centrals: the
+ *              connected central's once it has bonded anew, which may
+ *              have reused the slot of another bond, or all of them when
+ *              the bonds are erased.
+ *
+ * @param       allBonds - TRUE for all bonds, FALSE for the connected
+ *                         central's
+ *
+ * @return      none
+ */
+void GAPRole_ForgetBondParams(uint8_t allBonds)
+{
+  uint8_t bondIdx = allBonds ? GAP_BONDINGS_MAX : gapRole_bondIndex();
+  uint8_t changed = FALSE;
+  uint8_t i;
+
+  for (i = 0; i < GAP_BONDINGS_MAX; i++)
+  {
+    if ((allBonds || (i == bondIdx)) &&
+        (gapRole_bondParamRung[i] != PARAM_UPDATE_RUNG_UNKNOWN))
+    {
+      gapRole_bondParamRung[i] = PARAM_UPDATE_RUNG_UNKNOWN;
+      changed = TRUE;
+    }
+  }
+
+  if (changed)
+  {
+    VOID osal_snv_write(GAPROLE_NVID_PARAM_RUNGS, sizeof(gapRole_bondParamRung),
+                        gapRole_bondParamRung);
+  }
+}
+
+/*********************************************************************
+ * @fn      gapRole_getRungParams
+ *
+ * @brief   Get the connection parameters of a ladder rung. Without a
+ *          registered ladder the single rung is the application's
+ *          desired parameter set.
+ *
+ * @param   rung - ladder rung
+ * @param   pConnParams - connection parameters to fill in
+ *
+ * @return  none
+ */
+static void gapRole_getRungParams(uint8_t rung,
+                                  gapRole_updateConnParams_t *pConnParams)
+{
+  if ((pGapRole_paramLadder != NULL) && (rung < gapRole_paramLadderLen))
+  {
+    pConnParams->minConnInterval = pGapRole_paramLadder[rung].minConnInterval;
+    pConnParams->maxConnInterval = pGapRole_paramLadder[rung].maxConnInterval;
+    pConnParams->slaveLatency = pGapRole_paramLadder[rung].slaveLatency;
+    pConnParams->timeoutMultiplier = pGapRole_paramLadder[rung].timeoutMultiplier;
+  }
+  else
+  {
+    *pConnParams = gapRole_updateConnParams;
+  }
+}
+
+/*********************************************************************
+ * @fn      gapRole_bondIndex
+ *
+ * @brief   Find the bond of the connected central.
+ *
+ * @param   none
+ *
+ * @return  bond index, GAP_BONDINGS_MAX if not bonded
+ */
+static uint8_t gapRole_bondIndex(void)
+{
+  uint8_t resolvedAddr[B_ADDR_LEN];
+
+  return GAPBondMgr_ResolveAddr(gapRole_ConnectedDevAddrType,
+                                gapRole_ConnectedDevAddr, resolvedAddr);
+}
+
+/*********************************************************************
+ * @fn      gapRole_startParamNegotiation
+ *
+ * @brief   Prepare the connection parameter negotiation for a new
+ *          connection. A bonded central starts at the rung it accepted
+ *          on its previous connection.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gapRole_startParamNegotiation(void)
+{
+  uint8_t bondIdx = gapRole_bondIndex();
+
+  gapRole_paramRung = 0;
+
+  if ((bondIdx < GAP_BONDINGS_MAX) &&
+      (gapRole_bondParamRung[bondIdx] < gapRole_paramLadderLen))
+  {
+    gapRole_paramRung = gapRole_bondParamRung[bondIdx];
+  }
+
+  gapRole_paramRungAttempts = 0;
+  gapRole_paramBackoff = PARAM_UPDATE_BACKOFF_MIN;
+  gapRole_paramNegotiation = PARAM_NEGOTIATION_LADDER;
+}
+
+/*********************************************************************
+ * @fn      gapRole_requestPendingParams
+ *
+ * @brief   Send one request of the connection parameter negotiation.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gapRole_requestPendingParams(void)
+{
+  bStatus_t status;
+
+  status = gapRole_startConnUpdate(GAPROLE_RESEND_PARAM_UPDATE,
+                                   &gapRole_paramPending);
+
+  if (status == bleInvalidRange)
+  {
+    // The link already uses these parameters
+    gapRole_paramNegotiationDone(TRUE);
+  }
+  else if (status != SUCCESS)
+  {
+    // Could not even send the request, try again later
+    gapRole_paramNegotiationBackoff();
+  }
+}
+
+/*********************************************************************
+ * @fn      gapRole_paramNegotiationBackoff
+ *
+ * @brief   Schedule the next attempt after an unsuccessful update. The
+ *          delay doubles after every attempt. While walking the ladder,
+ *          each rung gets PARAM_UPDATE_RUNG_ATTEMPTS attempts before the
+ *          next, easier rung is used.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gapRole_paramNegotiationBackoff(void)
+{
+  if (gapRole_paramNegotiation == PARAM_NEGOTIATION_IDLE)
+  {
+    return;
+  }
+
+  if ((gapRole_paramNegotiation == PARAM_NEGOTIATION_LADDER) &&
+      (++gapRole_paramRungAttempts >= PARAM_UPDATE_RUNG_ATTEMPTS))
+  {
+    uint8_t numRungs = (pGapRole_paramLadder != NULL) ? gapRole_paramLadderLen : 1;
+
+    gapRole_paramRungAttempts = 0;
+
+    if (++gapRole_paramRung >= numRungs)
+    {
+      // Nothing on the ladder is acceptable, keep what the central chose
+      gapRole_paramRung = 0;
+      gapRole_paramNegotiationDone(FALSE);
+      return;
+    }
+  }
+
+  Util_restartClock(&startUpdateClock, gapRole_paramBackoff);
+
+  gapRole_paramBackoff = (gapRole_paramBackoff < (PARAM_UPDATE_BACKOFF_MAX / 2)) ?
+                         (gapRole_paramBackoff * 2) : PARAM_UPDATE_BACKOFF_MAX;
+}
+
+/*********************************************************************
+ * @fn      gapRole_paramNegotiationDone
+ *
+ * @brief   End the connection parameter negotiation and remember the
+ *          outcome for a bonded central.
+ *
+ * @param   accepted - TRUE if the pending parameter set is in use
+ *
+ * @return  none
+ */
+static void gapRole_paramNegotiationDone(uint8_t accepted)
+{
+  uint8_t mode = gapRole_paramNegotiation;
+  uint8_t bondIdx;
+
+  gapRole_paramNegotiation = PARAM_NEGOTIATION_IDLE;
+  Util_stopClock(&startUpdateClock);
+
+  if (mode != PARAM_NEGOTIATION_LADDER)
+  {
+    return;
+  }
+
+  bondIdx = gapRole_bondIndex();
+
+  if (bondIdx < GAP_BONDINGS_MAX)
+  {
+    uint8_t rung = accepted ? gapRole_paramRung : PARAM_UPDATE_RUNG_UNKNOWN;
+
+    if (gapRole_bondParamRung[bondIdx] != rung)
+    {
+      gapRole_bondParamRung[bondIdx] = rung;
+
+      VOID osal_snv_write(GAPROLE_NVID_PARAM_RUNGS, sizeof(gapRole_bondParamRung),
+                          gapRole_bondParamRung);
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      gapRole_paramsMatch
+ *
+ * @brief   Check whether the current connection uses a parameter set.
+ *
+ * @param   pConnParams - requested connection parameters
+ *
+ * @return  TRUE if the connection parameters satisfy pConnParams
+ */
+static uint8_t gapRole_paramsMatch(gapRole_updateConnParams_t *pConnParams)
+{
+  return ((gapRole_ConnInterval >= pConnParams->minConnInterval) &&
+          (gapRole_ConnInterval <= pConnParams->maxConnInterval) &&
+          (gapRole_ConnSlaveLatency == pConnParams->slaveLatency) &&
+          (gapRole_ConnTimeout == pConnParams->timeoutMultiplier));
+}
+
 /*********************************************************************
  * @fn      gapRole_setEvent
  *
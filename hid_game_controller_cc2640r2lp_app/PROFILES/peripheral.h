@@ -430,7 +430,7 @@ typedef enum
  *  update is received.
  */
 #define GAPROLE_NO_ACTION                    0 //!< Take no action upon unsuccessful parameter updates
-#define GAPROLE_RESEND_PARAM_UPDATE          1 //!< Continue to resend request until successful update
+#define GAPROLE_RESEND_PARAM_UPDATE          1 //!< Resend request with exponential backoff until successful update
 #define GAPROLE_TERMINATE_LINK               2 //!< Terminate link upon unsuccessful parameter updates
 /** @} End Peripheral_Param_Update_Fail_Actions */
 
@@ -497,6 +497,17 @@ typedef struct
 
 /** @} End Peripheral_CBs */
 
+/**
+ * @brief One set of connection parameters offered to the central
+ */
+typedef struct
+{
+  uint16_t minConnInterval;   //!< Minimum connection interval (n x 1.25 ms)
+  uint16_t maxConnInterval;   //!< Maximum connection interval (n x 1.25 ms)
+  uint16_t slaveLatency;      //!< Slave latency
+  uint16_t timeoutMultiplier; //!< Supervision timeout (n x 10 ms)
+} gapRoleConnParams_t;
+
 /*-------------------------------------------------------------------
  * API FUNCTIONS
  */
@@ -593,6 +604,51 @@ extern bStatus_t GAPRole_SendUpdateParam(uint16_t minConnInterval,
  */
 extern void GAPRole_RegisterAppCBs(gapRolesParamUpdateCB_t *pParamUpdateCB);
 
+/**
+ * @brief       Register the ladder of connection parameter sets walked by
+ *              the connection parameter negotiation.
+ *
+ * When the central does not accept a request, the same set is retried
+ * with exponential backoff before moving to the next, easier set. The
+ * set accepted by a bonded central is remembered in NV and requested
+ * first on its next connection. Without a ladder only the parameters
+ * set through @ref GAPROLE_MIN_CONN_INTERVAL etc. are requested.
+ *
+ * @param       pLadder parameter sets, most preferred first. Must stay
+ *              valid while the GAPRole is running.
+ * @param       numRungs number of entries in pLadder
+ *
+ * @return      @ref SUCCESS
+ * @return      @ref bleInvalidRange : numRungs is zero or too large
+ */
+extern bStatus_t GAPRole_SetParamUpdateLadder(const gapRoleConnParams_t *pLadder,
+                                              uint8_t numRungs);
+
+/**
+ * @brief       Resume the ladder walk held by an application set.
+ *
+ * A set requested with @ref GAPRole_SendUpdateParam and
+ * @ref GAPROLE_NO_ACTION holds a ladder walk in progress at its rung
+ * instead of ending it. Once the application no longer needs its set,
+ * this goes on with the walk; if no walk was held, the application
+ * requests the parameters it wants back itself.
+ *
+ * @return      @ref SUCCESS : the walk goes on
+ * @return      @ref bleIncorrectMode : no walk was held
+ */
+extern bStatus_t GAPRole_ResumeParamNegotiation(void);
+
+/**
+ * @brief       Forget the parameter set remembered for bonded centrals.
+ *
+ * Called when the connected central has bonded anew, since the bond may
+ * reuse the slot of another central, and when the bonds are erased.
+ *
+ * @param       allBonds TRUE for all bonds, FALSE for the connected
+ *              central's
+ */
+extern void GAPRole_ForgetBondParams(uint8_t allBonds);
+
 /// @cond NODOC
 
 /*-------------------------------------------------------------------
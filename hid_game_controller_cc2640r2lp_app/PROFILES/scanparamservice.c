@@ -54,6 +54,7 @@
 #include "icall_ble_api.h"
 
 #include "scanparamservice.h"
+#include "cccdarena.h"
 
 /*********************************************************************
  * MACROS
@@ -63,6 +64,10 @@
  * CONSTANTS
  */
 
+// Range of the LE scan interval and window, in 625 us units
+#define SCAN_PARAM_MIN                    0x0004
+#define SCAN_PARAM_MAX                    0x4000
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -112,11 +117,11 @@ static scanParamServiceCB_t scanParamServiceCB;
 static CONST gattAttrType_t scanParamService = { ATT_BT_UUID_SIZE, scanParamServUUID };
 
 // Scan Interval Window characteristic
-static uint8 scanIntervalWindowProps = GATT_PROP_WRITE_NO_RSP;
+static CONST uint8 scanIntervalWindowProps = GATT_PROP_WRITE_NO_RSP;
 static uint8 scanIntervalWindow[SCAN_INTERVAL_WINDOW_CHAR_LEN];
 
 // Scan Parameter Refresh characteristic
-static uint8 scanParamRefreshProps = GATT_PROP_NOTIFY;
+static CONST uint8 scanParamRefreshProps = GATT_PROP_NOTIFY;
 static uint8 scanParamRefresh[SCAN_PARAM_REFRESH_LEN];
 static gattCharCfg_t *scanParamRefreshClientCharCfg;
 
@@ -139,7 +144,7 @@ static gattAttribute_t scanParamAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &scanIntervalWindowProps
+      (uint8 *)&scanIntervalWindowProps
     },
 
       // Scan Interval Window characteristic
@@ -155,7 +160,7 @@ static gattAttribute_t scanParamAttrTbl[] =
       { ATT_BT_UUID_SIZE, characterUUID },
       GATT_PERMIT_READ,
       0,
-      &scanParamRefreshProps
+      (uint8 *)&scanParamRefreshProps
     },
 
     // Scan Parameter Refresh characteristic
@@ -234,8 +239,8 @@ bStatus_t ScanParam_AddService(void)
 {
   uint8 status = SUCCESS;
 
-  scanParamRefreshClientCharCfg = (gattCharCfg_t *)ICall_malloc(sizeof(gattCharCfg_t) *
-                                                                linkDBNumConns);
+  // Take the Client Characteristic Configuration table from the arena
+  scanParamRefreshClientCharCfg = CccdArena_alloc();
 
   if (scanParamRefreshClientCharCfg == NULL)
   {
@@ -426,14 +431,18 @@ static bStatus_t scanParamWriteAttrCB(uint16_t connHandle, gattAttribute_t *pAtt
     if (len == SCAN_INTERVAL_WINDOW_CHAR_LEN)
     {
       uint16 interval = BUILD_UINT16(pValue[0], pValue[1]);
-      uint16 window = BUILD_UINT16(pValue[0], pValue[1]);
+      uint16 window = BUILD_UINT16(pValue[2], pValue[3]);
 
-      // Validate values
-      if (window <= interval)
+      // Validate values, the window within the interval and both in range
+      if ((interval <= SCAN_PARAM_MAX) && (window >= SCAN_PARAM_MIN) &&
+          (window <= interval))
       {
         memcpy(pAttr->pValue, pValue, len);
 
-        (*scanParamServiceCB)(SCAN_INTERVAL_WINDOW_SET);
+        if (scanParamServiceCB)
+        {
+          (*scanParamServiceCB)(SCAN_INTERVAL_WINDOW_SET);
+        }
       }
       else
       {
@@ -53,6 +53,9 @@ extern "C" {
 
 #define Board_ADC0              CC2640R2_LAUNCHXL_ADC0
 #define Board_ADC1              CC2640R2_LAUNCHXL_ADC1
+#define Board_ADC2              CC2640R2_LAUNCHXL_ADC2
+#define Board_ADC3              CC2640R2_LAUNCHXL_ADC3
+#define Board_ADC4              CC2640R2_LAUNCHXL_ADC4
 #define Board_ADC5              CC2640R2_LAUNCHXL_ADC5
 
 #define Board_ADCBUF0           CC2640R2_LAUNCHXL_ADCBUF0
@@ -135,6 +138,30 @@ extern "C" {
 #define EDUBP_MKII_RLED         Board_PIN_RLED
 #define EDUBP_MKII_BLED         CC2640R2_LAUNCHXL_DIO19
 
+// PWM outputs of the RGB LED channels. No pin is defined for the green
+// LED of the BoosterPack, the LaunchPad green LED stands in for it.
+#define EDUBP_MKII_RLED_PWM     Board_PWM0
+#define EDUBP_MKII_GLED_PWM     Board_PWM1
+#define EDUBP_MKII_BLED_PWM     Board_PWM2
+
+// PWM output of the buzzer
+#define EDUBP_MKII_BUZZER_PWM   Board_PWM3
+
+// ADC channels of the accelerometer axes, DIO25 to DIO27
+#define EDUBP_MKII_ACCEL_X_ADC  Board_ADC2
+#define EDUBP_MKII_ACCEL_Y_ADC  Board_ADC3
+#define EDUBP_MKII_ACCEL_Z_ADC  Board_ADC4
+
+// LCD: ST7735S on SPI0, CLK J1.7 (DIO10) and MOSI J2.15 (DIO9), chip
+// select J2.13, reset J2.17 and data/command J4.31. The chip select is the
+// one of the external flash: the flash is put in deep power down at start
+// up and the LCD keeps the select low, a flash in deep power down only
+// wakes on a release command as the first byte after the select falls.
+#define EDUBP_MKII_LCD_SPI      Board_SPI0
+#define EDUBP_MKII_LCD_CS       CC2640R2_LAUNCHXL_SPI_FLASH_CS
+#define EDUBP_MKII_LCD_RST      CC2640R2_LAUNCHXL_DIO1_RFSW
+#define EDUBP_MKII_LCD_DC       CC2640R2_LAUNCHXL_DIO17_TDI
+
 #define Board_UART0             CC2640R2_LAUNCHXL_UART0
 
 #define Board_WATCHDOG0         CC2640R2_LAUNCHXL_WATCHDOG0
@@ -160,8 +160,8 @@ extern const PIN_Config BoardGpioInitTable[];
 /* PWM Outputs */
 #define CC2640R2_LAUNCHXL_PWMPIN0               CC2640R2_LAUNCHXL_PIN_RLED
 #define CC2640R2_LAUNCHXL_PWMPIN1               CC2640R2_LAUNCHXL_PIN_GLED
-#define CC2640R2_LAUNCHXL_PWMPIN2               PIN_UNASSIGNED
-#define CC2640R2_LAUNCHXL_PWMPIN3               PIN_UNASSIGNED
+#define CC2640R2_LAUNCHXL_PWMPIN2               CC2640R2_LAUNCHXL_DIO19 /* BoosterPack blue LED */
+#define CC2640R2_LAUNCHXL_PWMPIN3               CC2640R2_LAUNCHXL_DIO12 /* BoosterPack buzzer */
 #define CC2640R2_LAUNCHXL_PWMPIN4               PIN_UNASSIGNED
 #define CC2640R2_LAUNCHXL_PWMPIN5               PIN_UNASSIGNED
 #define CC2640R2_LAUNCHXL_PWMPIN6               PIN_UNASSIGNED
@@ -71,6 +71,7 @@
 #include <inc/hw_memmap.h>
 #include <driverlib/vims.h>
 #include <hidgamecontroller.h>
+#include "memmonitor.h"
 
 #ifndef USE_DEFAULT_USER_CFG
 
@@ -155,8 +156,10 @@ int main()
     /* Kick off profile - Priority 3 */
     GAPRole_createTask();
 
+#ifndef HID_DEV_SINGLE_TASK
     /* Kick off HID service task - Priority 2 */
     HidDev_createTask();
+#endif // !HID_DEV_SINGLE_TASK
 
     /* Kick off application - Priority 1 */
     HidGameController_createTask();
@@ -220,6 +223,7 @@ void AssertHandler(uint8 assertCause, uint8 assertSubcause)
     switch (assertCause)
     {
         case HAL_ASSERT_CAUSE_OUT_OF_MEMORY:
+        MemMon_outOfMemory();
 #if !defined(Display_DISABLE_ALL)
         Display_print0(dispHandle, 0, 0, "***ERROR***");
         Display_print0(dispHandle, 2, 0, ">> OUT OF MEMORY!");
@@ -0,0 +1,813 @@
+#!/usr/bin/env python3
+"""
+ @file       hidgen.py
+
+ @brief Build-time generator and validator of the HID report map of the
+        BLE Game Controller.
+
+ Project: BLE Game Controller
+ Modification Details : Generate the report descriptor, the report IDs and
+                        lengths, the report map table entries and the
+                        report packing functions from one report spec.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+
+ Usage:
+   hidgen.py [--spec SPEC] [--out DIR] [--check]
+
+ SPEC, TOOLS/hidreports.py by default, declares the reports of the HID
+ service: the application collections of the report map with their
+ reports and fields, and the boot protocol reports. The spec is checked
+ and hidreportmap.h and hidreportmap.c are written to DIR, PROFILES by
+ default. With --check nothing is written, the exit status is 1 when the
+ files in DIR are not what the spec generates.
+
+ The spec is rejected, exit status 2, when:
+   - a report is not a whole number of bytes, or is longer than a
+     notification at the default MTU
+   - a logical range does not fit the field size
+   - the usages of a variable field do not match its count, or the
+     logical range of an array field does not match its usages
+   - report IDs are mixed, zero and nonzero, or an ID and type is used
+     twice in the same protocol mode
+   - an input report has no CCCD, or an output or feature report has one
+   - a boot report does not have the boot layout of its kind
+   - the report map does not fit hidReportMapLen
+"""
+
+import argparse
+import os
+import runpy
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+DEFAULT_SPEC = os.path.join(HERE, "hidreports.py")
+DEFAULT_OUT = os.path.join(HERE, "..", "PROFILES")
+
+HEADER_NAME = "hidreportmap.h"
+SOURCE_NAME = "hidreportmap.c"
+
+# Report types, HID_REPORT_TYPE_* in PROFILES/hiddev.h
+INPUT = "INPUT"
+OUTPUT = "OUTPUT"
+FEATURE = "FEATURE"
+
+# Longest report, a notification at the default MTU (ATT_MTU_SIZE - 3)
+MAX_REPORT_LEN = 20
+
+# Longest report map of the HID spec, hidReportMapLen is a uint16
+MAX_REPORT_MAP_LEN = 512
+
+# Boot layouts: report length, or minimum length for the boot mouse
+BOOT_KEY_IN_LEN = 8
+BOOT_KEY_OUT_LEN = 1
+BOOT_MOUSE_IN_MIN_LEN = 3
+
+# Item prefixes, size bits cleared
+ITEM_INPUT = 0x80
+ITEM_OUTPUT = 0x90
+ITEM_FEATURE = 0xB0
+ITEM_COLLECTION = 0xA0
+ITEM_END_COLLECTION = 0xC0
+ITEM_USAGE_PAGE = 0x04
+ITEM_LOGICAL_MIN = 0x14
+ITEM_LOGICAL_MAX = 0x24
+ITEM_REPORT_SIZE = 0x74
+ITEM_REPORT_ID = 0x84
+ITEM_REPORT_COUNT = 0x94
+ITEM_USAGE = 0x08
+ITEM_USAGE_MIN = 0x18
+ITEM_USAGE_MAX = 0x28
+
+MAIN_ITEMS = {INPUT: ITEM_INPUT, OUTPUT: ITEM_OUTPUT, FEATURE: ITEM_FEATURE}
+
+# Main item data bits
+MAIN_CONSTANT = 0x01
+MAIN_VARIABLE = 0x02
+MAIN_RELATIVE = 0x04
+
+COLLECTION_APPLICATION = 0x01
+
+
+class SpecError(Exception):
+    pass
+
+
+class Field:
+    """Field of a report: count elements of bits each."""
+
+    def __init__(self, name, bits, count=1, usage_page=None, usage=None,
+                 usages=None, usage_min=None, usage_max=None, logical=None,
+                 array=False, relative=False):
+        self.name = name
+        self.bits = bits
+        self.count = count
+        self.usage_page = usage_page
+        self.usages = list(usages) if usages else ([usage] if usage is not
+                                                    None else [])
+        self.usage_min = usage_min
+        self.usage_max = usage_max
+        self.logical = logical if logical else (0, (1 << bits) - 1)
+        self.array = array
+        self.relative = relative
+        self.constant = False
+
+    @property
+    def signed(self):
+        return self.logical[0] < 0
+
+    @property
+    def bitmask(self):
+        """Variable field of one bit elements, packed as one value."""
+        return self.bits == 1 and not self.array and not self.constant
+
+    def flags(self):
+        if self.constant:
+            return MAIN_CONSTANT
+        flags = 0 if self.array else MAIN_VARIABLE
+        return flags | (MAIN_RELATIVE if self.relative else 0)
+
+
+class Pad(Field):
+    """Constant padding bits."""
+
+    def __init__(self, bits):
+        Field.__init__(self, None, bits)
+        self.constant = True
+
+
+class Report:
+    """Report characteristic of the HID service."""
+
+    def __init__(self, name, type, id=0, attr=None, cccd=None, fields=(),
+                 same_as=None, boot=None):
+        self.name = name
+        self.type = type
+        self.id = id
+        self.attr = attr
+        self.cccd = cccd
+        self.fields = list(fields)
+        self.same_as = same_as
+        self.boot = boot
+
+    @property
+    def bits(self):
+        return sum(f.bits * f.count for f in self.fields)
+
+    @property
+    def length(self):
+        return self.bits // 8
+
+    @property
+    def macro(self):
+        return self.name.upper()
+
+    @property
+    def struct_name(self):
+        return "hid" + camel(self.name) + "Rpt_t"
+
+
+class Application:
+    """Application collection of the report map."""
+
+    def __init__(self, name, usage_page, usage, reports):
+        self.name = name
+        self.usage_page = usage_page
+        self.usage = usage
+        self.reports = list(reports)
+
+
+def camel(name):
+    return "".join(part.capitalize() for part in name.split("_"))
+
+
+def load_spec(path):
+    """Run the spec with the builder names defined, return its globals."""
+    names = dict(Field=Field, Pad=Pad, Report=Report,
+                 Application=Application, INPUT=INPUT, OUTPUT=OUTPUT,
+                 FEATURE=FEATURE)
+    spec = runpy.run_path(path, init_globals=names)
+
+    for key in ("APPLICATIONS", "BOOT_REPORTS", "EXTERNAL_REPORTS"):
+        if key not in spec:
+            raise SpecError("%s: %s is not defined" % (path, key))
+
+    return spec
+
+
+# ---------------------------------------------------------------------------
+# Validator
+# ---------------------------------------------------------------------------
+
+def check_field(report, field):
+    where = "%s.%s" % (report.name, field.name or "pad")
+
+    if field.bits < 1 or field.bits > 32 or field.count < 1:
+        raise SpecError("%s: bad size %d x %d" % (where, field.bits,
+                                                   field.count))
+    if field.constant:
+        return
+
+    lo, hi = field.logical
+    if lo > hi:
+        raise SpecError("%s: logical range %d..%d" % (where, lo, hi))
+    if lo < 0:
+        if lo < -(1 << (field.bits - 1)) or hi >= 1 << (field.bits - 1):
+            raise SpecError("%s: logical range %d..%d does not fit %d signed "
+                            "bits" % (where, lo, hi, field.bits))
+    elif hi >= 1 << field.bits:
+        raise SpecError("%s: logical max %d does not fit %d bits"
+                        % (where, hi, field.bits))
+
+    if report.boot and not report.same_as and field.usage_page is None:
+        # Boot reports have a fixed layout, no usages
+        return
+
+    if field.usage_page is None:
+        raise SpecError("%s: no usage page" % where)
+
+    if field.usage_min is not None:
+        if field.usages or field.usage_max is None or \
+                field.usage_max < field.usage_min:
+            raise SpecError("%s: bad usage range" % where)
+        num_usages = field.usage_max - field.usage_min + 1
+    else:
+        num_usages = len(field.usages)
+
+    if field.array:
+        if lo < 0 or hi - lo + 1 != num_usages:
+            raise SpecError("%s: array of %d usages has logical range %d..%d"
+                            % (where, num_usages, lo, hi))
+    elif num_usages != field.count:
+        raise SpecError("%s: %d usages for %d elements" % (where, num_usages,
+                                                           field.count))
+
+
+def check_report(report, in_map):
+    if report.type not in MAIN_ITEMS:
+        raise SpecError("%s: bad type %s" % (report.name, report.type))
+    if not 0 <= report.id <= 255:
+        raise SpecError("%s: bad report ID %d" % (report.name, report.id))
+    if not report.fields:
+        raise SpecError("%s: no fields" % report.name)
+
+    for field in report.fields:
+        check_field(report, field)
+
+    names = [f.name for f in report.fields if f.name]
+    if len(set(names)) != len(names):
+        raise SpecError("%s: field names are not unique" % report.name)
+
+    if report.bits % 8:
+        raise SpecError("%s: %d bits, not a whole number of bytes"
+                        % (report.name, report.bits))
+    if report.length > MAX_REPORT_LEN:
+        raise SpecError("%s: %d bytes, longer than %d" % (
+            report.name, report.length, MAX_REPORT_LEN))
+
+    if report.attr is None:
+        raise SpecError("%s: no attribute index" % report.name)
+    if report.type == INPUT and report.cccd is None:
+        raise SpecError("%s: input report without CCCD" % report.name)
+    if report.type != INPUT and report.cccd is not None:
+        raise SpecError("%s: %s report with CCCD" % (report.name,
+                                                     report.type.lower()))
+
+    if in_map and report.boot:
+        raise SpecError("%s: boot report in the report map" % report.name)
+
+
+def check_boot(report):
+    if report.boot == "keyboard_in":
+        ok = report.type == INPUT and report.length == BOOT_KEY_IN_LEN
+    elif report.boot == "keyboard_out":
+        ok = report.type == OUTPUT and report.length == BOOT_KEY_OUT_LEN
+    elif report.boot == "mouse_in":
+        ok = report.type == INPUT and report.length >= BOOT_MOUSE_IN_MIN_LEN
+    else:
+        raise SpecError("%s: unknown boot report %s" % (report.name,
+                                                        report.boot))
+
+    if not ok:
+        raise SpecError("%s: not the layout of a boot %s report"
+                        % (report.name, report.boot.replace("_", " ")))
+
+
+def resolve(spec):
+    """Check the spec, return the map reports and the boot reports."""
+    map_reports = []
+    for app in spec["APPLICATIONS"]:
+        for report in app.reports:
+            check_report(report, True)
+            map_reports.append(report)
+
+    by_name = dict((r.name, r) for r in map_reports)
+    boot_reports = []
+    for report in spec["BOOT_REPORTS"]:
+        if report.same_as:
+            base = by_name.get(report.same_as)
+            if base is None:
+                raise SpecError("%s: unknown report %s" % (report.name,
+                                                           report.same_as))
+            report.id = base.id
+            report.fields = base.fields
+            if report.type != base.type:
+                raise SpecError("%s: type differs from %s" % (report.name,
+                                                              base.name))
+        check_report(report, False)
+        check_boot(report)
+        boot_reports.append(report)
+
+    all_reports = map_reports + boot_reports
+    names = [r.name for r in all_reports]
+    if len(set(names)) != len(names):
+        raise SpecError("report names are not unique")
+
+    attrs = [r.attr for r in all_reports]
+    if len(set(attrs)) != len(attrs):
+        raise SpecError("attribute indexes are not unique")
+
+    ids = set(r.id for r in map_reports)
+    if 0 in ids and len(ids) > 1:
+        raise SpecError("report map mixes report ID 0 and nonzero IDs")
+
+    for reports, mode in ((map_reports, "report"), (boot_reports, "boot")):
+        keys = [(r.id, r.type) for r in reports]
+        if len(set(keys)) != len(keys):
+            raise SpecError("report ID and type used twice in %s mode" % mode)
+
+    return map_reports, boot_reports
+
+
+# ---------------------------------------------------------------------------
+# Report map
+# ---------------------------------------------------------------------------
+
+def item(prefix, value, signed=False):
+    """Encode a short item, return its bytes."""
+    for size, code in ((1, 1), (2, 2), (4, 3)):
+        if signed:
+            fits = -(1 << (8 * size - 1)) <= value < 1 << (8 * size - 1)
+        else:
+            fits = 0 <= value < 1 << (8 * size)
+        if fits:
+            data = (value & ((1 << (8 * size)) - 1)).to_bytes(size, "little")
+            return bytes([prefix | code]) + data
+
+    raise SpecError("item value %d does not fit" % value)
+
+
+def main_flags_text(flags):
+    if flags & MAIN_CONSTANT:
+        return "Constant"
+    return "Data, %s, %s" % ("Variable" if flags & MAIN_VARIABLE else "Array",
+                             "Relative" if flags & MAIN_RELATIVE
+                             else "Absolute")
+
+
+def build_report_map(spec):
+    """Return the report map as (bytes, comment) items."""
+    items = []
+
+    def emit(prefix, value, text, signed=False):
+        items.append((item(prefix, value, signed), text))
+
+    for app in spec["APPLICATIONS"]:
+        state = {}
+
+        def glob(prefix, value, text, signed=False):
+            if state.get(prefix) != value:
+                state[prefix] = value
+                emit(prefix, value, text, signed)
+
+        items.append((None, app.name))
+        glob(ITEM_USAGE_PAGE, app.usage_page,
+             "Usage Page (0x%02X)" % app.usage_page)
+        emit(ITEM_USAGE, app.usage, "Usage (0x%02X)" % app.usage)
+        emit(ITEM_COLLECTION, COLLECTION_APPLICATION,
+             "Collection (Application)")
+
+        for report in app.reports:
+            if report.id:
+                glob(ITEM_REPORT_ID, report.id, "Report ID (%d)" % report.id)
+
+            for field in report.fields:
+                items.append((None, "%s.%s" % (report.name,
+                                               field.name or "pad")))
+                if not field.constant:
+                    glob(ITEM_USAGE_PAGE, field.usage_page,
+                         "Usage Page (0x%02X)" % field.usage_page)
+                    if field.usage_min is not None:
+                        emit(ITEM_USAGE_MIN, field.usage_min,
+                             "Usage Min (%d)" % field.usage_min)
+                        emit(ITEM_USAGE_MAX, field.usage_max,
+                             "Usage Max (%d)" % field.usage_max)
+                    for usage in field.usages:
+                        emit(ITEM_USAGE, usage, "Usage (0x%02X)" % usage)
+                    glob(ITEM_LOGICAL_MIN, field.logical[0],
+                         "Logical Min (%d)" % field.logical[0], True)
+                    glob(ITEM_LOGICAL_MAX, field.logical[1],
+                         "Logical Max (%d)" % field.logical[1], True)
+                glob(ITEM_REPORT_SIZE, field.bits,
+                     "Report Size (%d)" % field.bits)
+                glob(ITEM_REPORT_COUNT, field.count,
+                     "Report Count (%d)" % field.count)
+                emit(MAIN_ITEMS[report.type], field.flags(), "%s (%s)" % (
+                    report.type.capitalize(), main_flags_text(field.flags())))
+
+        # End Collection has no data
+        items.append((bytes([ITEM_END_COLLECTION]), "End Collection"))
+
+    length = sum(len(data) for data, _ in items if data)
+    if length > MAX_REPORT_MAP_LEN:
+        raise SpecError("report map of %d bytes, longer than %d"
+                        % (length, MAX_REPORT_MAP_LEN))
+
+    return items, length
+
+
+# ---------------------------------------------------------------------------
+# Packing functions
+# ---------------------------------------------------------------------------
+
+def c_type(bits, signed):
+    for size in (8, 16, 32):
+        if bits <= size:
+            return "%sint%d_t" % ("" if signed else "u", size)
+
+
+def members(report):
+    """Return (field, C type, array length, bit position, bits) of the
+    members of the report struct."""
+    result = []
+    pos = 0
+    for field in report.fields:
+        if field.constant:
+            pass
+        elif field.bitmask:
+            result.append((field, c_type(field.count, False), 0, pos,
+                           field.count))
+        else:
+            result.append((field, c_type(field.bits, field.signed),
+                           field.count if field.count > 1 else 0, pos,
+                           field.bits))
+        pos += field.bits * field.count
+    return result
+
+
+def pack_lines(value, pos, bits, covered):
+    """Statements writing value, a uint32_t expression, at bit pos of pBuf.
+    The first write of a byte assigns it, the next ones or into it."""
+    lines = []
+    for byte in range(pos // 8, (pos + bits - 1) // 8 + 1):
+        shift = pos - byte * 8
+        if shift > 0:
+            expr = "(uint8_t)(%s << %d)" % (value, shift)
+        elif shift < 0:
+            expr = "(uint8_t)(%s >> %d)" % (value, -shift)
+        else:
+            expr = "(uint8_t)%s" % value
+        lines.append("pBuf[%d] %s %s;" % (byte, "|=" if byte in covered
+                                          else "=", expr))
+        covered.add(byte)
+    return lines
+
+
+def unpack_expr(pos, bits):
+    """Expression of the unsigned value at bit pos of pBuf."""
+    parts = []
+    for byte in range(pos // 8, (pos + bits - 1) // 8 + 1):
+        lo = max(pos, byte * 8)
+        hi = min(pos + bits, byte * 8 + 8)
+        part = "pBuf[%d]" % byte
+        if lo - byte * 8:
+            part = "(%s >> %d)" % (part, lo - byte * 8)
+        if hi - lo < 8:
+            part = "(%s & 0x%02X)" % (part, (1 << (hi - lo)) - 1)
+        if lo - pos:
+            part = "((uint32_t)%s << %d)" % (part, lo - pos)
+        parts.append(part)
+    return " | ".join(parts)
+
+
+def pack_function(report):
+    lines = []
+    covered = set()
+
+    for field, ctype, count, pos, bits in members(report):
+        for i in range(count or 1):
+            value = "pRpt->%s%s" % (field.name, "[%d]" % i if count else "")
+            if bits < int(ctype.rstrip("_t").lstrip("uint")):
+                value = "((uint32_t)%s & 0x%X)" % (value, (1 << bits) - 1)
+            elif (pos + i * bits) % 8 or bits > 8:
+                value = "(uint32_t)%s" % value
+            lines.extend(pack_lines(value, pos + i * bits, bits, covered))
+
+    # Padding
+    for byte in range(report.length):
+        if byte not in covered:
+            lines.append("pBuf[%d] = 0;" % byte)
+
+    return lines
+
+
+def unpack_function(report):
+    lines = []
+
+    for field, ctype, count, pos, bits in members(report):
+        for i in range(count or 1):
+            member = "pRpt->%s%s" % (field.name,
+                                     "[%d]" % i if count else "")
+            expr = unpack_expr(pos + i * bits, bits)
+            if ctype.startswith("int") and bits not in (8, 16, 32):
+                sign = 1 << (bits - 1)
+                expr = "(%s)(((%s) ^ 0x%X) - 0x%X)" % (ctype, expr, sign,
+                                                       sign)
+            elif " | " in expr:
+                expr = "(%s)(%s)" % (ctype, expr)
+            else:
+                expr = "(%s)%s" % (ctype, expr)
+            lines.append("%s = %s;" % (member, expr))
+
+    return lines
+
+
+# ---------------------------------------------------------------------------
+# Output
+# ---------------------------------------------------------------------------
+
+FILE_HEADER = """/******************************************************************************
+
+ @file       %s
+
+ @brief %s
+
+        Generated by TOOLS/hidgen.py from TOOLS/hidreports.py, edit the
+        spec and run hidgen.py instead of editing this file.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : HID report map generated from a report spec.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+"""
+
+BANNER = """
+/*********************************************************************
+ * %s
+ */
+"""
+
+FILE_END = """
+/*********************************************************************
+*********************************************************************/
+"""
+
+
+def fn_doc(name, brief, params, ret="none"):
+    lines = ["/*********************************************************************",
+             " * @fn      %s" % name,
+             " *",
+             " * @brief   %s" % brief,
+             " *"]
+    for param, text in params:
+        lines.append(" * @param   %s - %s" % (param, text))
+    lines += [" *", " * @return  %s" % ret, " */"]
+    return lines
+
+
+def report_functions(report):
+    """(name, prototype, doc params, body) of the functions of a report."""
+    result = []
+    if report.type in (INPUT, FEATURE):
+        result.append(("HidRpt_pack" + camel(report.name),
+                       "void HidRpt_pack%s(const %s *pRpt, uint8_t *pBuf)"
+                       % (camel(report.name), report.struct_name),
+                       "Pack a %s report." % report.name,
+                       (("pRpt", "report"),
+                        ("pBuf", "HID_%s_RPT_LEN bytes" % report.macro)),
+                       pack_function(report)))
+    if report.type in (OUTPUT, FEATURE):
+        result.append(("HidRpt_unpack" + camel(report.name),
+                       "void HidRpt_unpack%s(const uint8_t *pBuf, %s *pRpt)"
+                       % (camel(report.name), report.struct_name),
+                       "Unpack a %s report." % report.name,
+                       (("pBuf", "HID_%s_RPT_LEN bytes" % report.macro),
+                        ("pRpt", "report")),
+                       unpack_function(report)))
+    return result
+
+
+def typed_reports(map_reports, boot_reports):
+    """Reports with their own layout, in spec order."""
+    return map_reports + [r for r in boot_reports if not r.same_as]
+
+
+def layout_crc(items, reports):
+    """CRC-16/CCITT of the report map and of the report characteristics,
+    the ID, type and protocol mode of each."""
+    data = bytearray()
+    for chunk, _ in items:
+        if chunk:
+            data.extend(chunk)
+    for report in reports:
+        data.extend((report.id, MAIN_ITEMS[report.type],
+                     1 if report.boot else 0))
+
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def generate_header(spec, map_reports, boot_reports, items, map_len):
+    out = [FILE_HEADER % (HEADER_NAME,
+                          "This file contains the report IDs and lengths of "
+                          "the HID service,\n        the report map table "
+                          "entries and the functions packing the\n"
+                          "        reports.")]
+    out.append("#ifndef HIDREPORTMAP_H\n#define HIDREPORTMAP_H\n")
+    out.append("#ifdef __cplusplus\nextern \"C\"\n{\n#endif\n")
+    out.append(BANNER % "INCLUDES")
+    out.append("#include <stdint.h>\n")
+    out.append(BANNER % "CONSTANTS")
+
+    reports = map_reports + boot_reports
+    width = max(len("HID_%s_RPT_LEN" % r.macro) for r in reports) + 2
+    width = max(width, len("HID_REPORT_MAP_LEN") + 2)
+
+    def define(name, value, comment=None):
+        line = "#define %-*s%s" % (width, name, value)
+        if comment:
+            line = "%-*s// %s" % (width + 14, line, comment)
+        out.append(line + "\n")
+
+    out.append("\n// Report IDs\n")
+    for report in reports:
+        if not report.same_as:
+            define("HID_RPT_ID_%s" % report.macro, str(report.id))
+
+    out.append("\n// Report lengths, without the report ID\n")
+    for report in reports:
+        define("HID_%s_RPT_LEN" % report.macro, str(report.length))
+
+    out.append("\n// Longest input report\n")
+    define("HID_RPT_MAX_IN_LEN",
+           str(max(r.length for r in reports if r.type == INPUT)))
+
+    out.append("\n// Length of the report map\n")
+    define("HID_REPORT_MAP_LEN", str(map_len))
+
+    out.append("\n// CRC of the report map and of the report characteristics, "
+               "a host bonded\n// under another layout has to discover the "
+               "service again\n")
+    define("HID_LAYOUT_CRC", "0x%04X" % layout_crc(items, reports))
+
+    num_attrs = len(reports)
+    out.append("\n// Report characteristics of the HID service, and reports of "
+               "other services\n// in the report map table\n")
+    define("HID_NUM_RPT_ATTRS", str(num_attrs))
+    define("HID_NUM_REPORTS", "(HID_NUM_RPT_ATTRS + %d)"
+           % spec["EXTERNAL_REPORTS"])
+
+    out.append("\n// Report map table entries of the report characteristics: "
+               "ID, type,\n// protocol mode, index of the characteristic and "
+               "of its CCCD, 0 when it has\n// none, in the attribute table "
+               "of the service\n")
+    lines = ["#define HID_RPT_ATTRS"]
+    for i, report in enumerate(reports):
+        id_macro = "HID_RPT_ID_%s" % (report.same_as or report.name).upper()
+        mode = "BOOT" if report.boot else "REPORT"
+        lines.append("  { %s, HID_REPORT_TYPE_%s, HID_PROTOCOL_MODE_%s,"
+                     % (id_macro, report.type, mode))
+        lines.append("    %s, %s }%s" % (report.attr, report.cccd or "0",
+                                         "," if i < len(reports) - 1 else ""))
+    for i, line in enumerate(lines):
+        out.append(line if i == len(lines) - 1 else
+                   "%-75s \\" % line)
+        out.append("\n")
+
+    # Relative input reports carry motion, an equal report is a new one
+    relative = ["((id) == HID_RPT_ID_%s)" % r.macro for r in map_reports
+                if r.type == INPUT and any(f.relative for f in r.fields)]
+    out.append("\n// Input reports with relative fields, sent even when equal "
+               "to the last one\n")
+    if relative:
+        out.append("%-75s \\\n" % "#define HID_RPT_IS_RELATIVE(id, type)")
+        out.append("  (((type) == HID_REPORT_TYPE_INPUT) && (%s))\n"
+                   % " || ".join(relative))
+    else:
+        out.append("#define HID_RPT_IS_RELATIVE(id, type)   0\n")
+
+    out.append(BANNER % "TYPEDEFS")
+    for report in typed_reports(map_reports, boot_reports):
+        out.append("\n// %s report\ntypedef struct\n{\n" % report.name)
+        for field, ctype, count, pos, bits in members(report):
+            decl = "%s%s;" % (field.name, "[%d]" % count if count else "")
+            out.append("  %-9s %s\n" % (ctype, decl))
+        out.append("} %s;\n" % report.struct_name)
+
+    out.append(BANNER % "GLOBAL VARIABLES")
+    out.append("\n// Report map characteristic value\n"
+               "extern const uint8_t hidReportMap[HID_REPORT_MAP_LEN];\n")
+
+    out.append(BANNER % "API FUNCTIONS")
+    for report in typed_reports(map_reports, boot_reports):
+        for name, proto, brief, params, body in report_functions(report):
+            out.append("\n" + "\n".join(fn_doc(name, brief, params)) + "\n")
+            out.append("extern %s;\n" % proto)
+
+    out.append(FILE_END)
+    out.append("\n#ifdef __cplusplus\n}\n#endif\n\n#endif /* HIDREPORTMAP_H */\n")
+
+    return "".join(out)
+
+
+def generate_source(spec, map_reports, boot_reports, items):
+    out = [FILE_HEADER % (SOURCE_NAME,
+                          "This file contains the report map of the HID "
+                          "service and the\n        functions packing and "
+                          "unpacking the reports.")]
+    out.append(BANNER % "INCLUDES")
+    out.append("#include \"hidreportmap.h\"\n")
+    out.append(BANNER % "GLOBAL VARIABLES")
+    out.append("\n// Report map characteristic value\n"
+               "const uint8_t hidReportMap[HID_REPORT_MAP_LEN] =\n{\n")
+
+    last = max(i for i, (data, _) in enumerate(items) if data)
+    for i, (data, text) in enumerate(items):
+        if data is None:
+            out.append("%-20s// %s\n" % ("", text))
+            continue
+        code = ", ".join("0x%02X" % b for b in data) + ("," if i < last
+                                                        else "")
+        out.append("  %-18s// %s\n" % (code, text))
+    out.append("};\n")
+
+    out.append(BANNER % "PUBLIC FUNCTIONS")
+    for report in typed_reports(map_reports, boot_reports):
+        for name, proto, brief, params, body in report_functions(report):
+            out.append("\n" + "\n".join(fn_doc(name, brief, params)) + "\n")
+            out.append("%s\n{\n" % proto)
+            out.extend("  %s\n" % line for line in body)
+            out.append("}\n")
+
+    out.append(FILE_END)
+
+    return "".join(out)
+
+
+def generate(spec_path):
+    spec = load_spec(spec_path)
+    map_reports, boot_reports = resolve(spec)
+    items, map_len = build_report_map(spec)
+
+    return {
+        HEADER_NAME: generate_header(spec, map_reports, boot_reports,
+                                     items, map_len),
+        SOURCE_NAME: generate_source(spec, map_reports, boot_reports, items),
+    }
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="HID report map generator")
+    parser.add_argument("--spec", default=DEFAULT_SPEC)
+    parser.add_argument("--out", default=DEFAULT_OUT)
+    parser.add_argument("--check", action="store_true",
+                        help="only check that the files are up to date")
+    args = parser.parse_args(argv[1:])
+
+    try:
+        files = generate(args.spec)
+    except SpecError as err:
+        print("hidgen: %s" % err, file=sys.stderr)
+        return 2
+
+    stale = 0
+    for name, text in sorted(files.items()):
+        path = os.path.join(args.out, name)
+        if args.check:
+            try:
+                with open(path) as f:
+                    current = f.read()
+            except OSError:
+                current = None
+            if current != text:
+                print("hidgen: %s is not up to date" % path, file=sys.stderr)
+                stale += 1
+        else:
+            with open(path, "w") as f:
+                f.write(text)
+
+    return 1 if stale else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
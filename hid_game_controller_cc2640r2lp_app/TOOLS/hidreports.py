@@ -0,0 +1,211 @@
+"""
+ @file       hidreports.py
+
+ @brief Report spec of the HID service of the BLE Game Controller, the
+        input of hidgen.py.
+
+ Project: BLE Game Controller
+ Modification Details : One spec for the report map, the report IDs and
+                        lengths, the report map table and the report
+                        packing functions.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+
+ hidgen.py runs this file with Application, Report, Field, Pad, INPUT,
+ OUTPUT and FEATURE defined. After a change, run TOOLS/hidgen.py and
+ commit PROFILES/hidreportmap.h and PROFILES/hidreportmap.c with it.
+
+ Report(name, type, id, attr, cccd, fields)
+   name   HID_RPT_ID_<NAME>, HID_<NAME>_RPT_LEN, hid<Name>Rpt_t and
+          HidRpt_pack<Name> or HidRpt_unpack<Name>
+   attr   index of the report characteristic in hidAttrTbl of
+          PROFILES/hidkbdservice.c, cccd the index of its CCCD
+
+ Field(name, bits, count, usage_page, usage / usages / usage_min and
+       usage_max, logical=(min, max), array, relative)
+   Fields are packed from bit 0 of the report in order. A variable field
+   of 1 bit elements is one bitmask member of the report struct.
+
+ Boot reports are not in the report map. With same_as a boot report
+ shares the ID, type and layout of a report of the map, otherwise it
+ declares its own fields; boot names the boot layout it must follow.
+"""
+
+# Usage pages
+GENERIC_DESKTOP = 0x01
+KEYBOARD_PAGE = 0x07
+LED_PAGE = 0x08
+BUTTON_PAGE = 0x09
+CONSUMER_PAGE = 0x0C
+VENDOR_PAGE = 0xFF00
+
+# Generic Desktop usages
+MOUSE = 0x02
+GAMEPAD = 0x05
+KEYBOARD = 0x06
+X = 0x30
+Y = 0x31
+WHEEL = 0x38
+
+# Consumer usages
+CONSUMER_CONTROL = 0x01
+AC_PAN = 0x238
+
+# Vendor usages of the lights output report
+LIGHTS = 0x02
+LIGHT_PATTERN = 0x10
+LIGHT_PLAYER = 0x11
+LIGHT_RED = 0x12
+LIGHT_GREEN = 0x13
+LIGHT_BLUE = 0x14
+LIGHT_PERIOD = 0x15
+
+# Vendor usages of the effect output report
+EFFECTS = 0x03
+EFFECT_COMMAND = 0x20
+EFFECT_FREQUENCY = 0x21
+EFFECT_DURATION = 0x22
+EFFECT_LEVEL = 0x23
+EFFECT_ATTACK = 0x24
+EFFECT_FADE = 0x25
+
+# Highest key code of the keyboard
+KEY_MAX = 0x65
+
+# Highest consumer usage, AC Distribute Vertically
+CONSUMER_MAX = 0x29C
+
+# Report IDs of the composite device, keyboard for menus, gamepad for play,
+# consumer control for media, mouse for the pointer mode, the vendor lights
+# output for the player indicator and status colors and the vendor effect
+# output for the buzzer feedback. ID 4 is the battery level report of the
+# battery service.
+
+APPLICATIONS = [
+    Application("keyboard", GENERIC_DESKTOP, KEYBOARD, [
+        Report("key_in", INPUT, id=1,
+               attr="HID_REPORT_KEY_IN_IDX",
+               cccd="HID_REPORT_KEY_IN_CCCD_IDX",
+               fields=[
+                   Field("modifiers", bits=1, count=8,
+                         usage_page=KEYBOARD_PAGE, usage_min=0xE0,
+                         usage_max=0xE7, logical=(0, 1)),
+                   Pad(8),
+                   Field("keys", bits=8, count=6, usage_page=KEYBOARD_PAGE,
+                         usage_min=0, usage_max=KEY_MAX,
+                         logical=(0, KEY_MAX), array=True),
+               ]),
+
+        Report("led_out", OUTPUT, id=1,
+               attr="HID_REPORT_LED_OUT_IDX",
+               fields=[
+                   Field("leds", bits=1, count=5, usage_page=LED_PAGE,
+                         usage_min=1, usage_max=5, logical=(0, 1)),
+                   Pad(3),
+               ]),
+
+        Report("feature", FEATURE, id=1,
+               attr="HID_FEATURE_IDX",
+               fields=[
+                   Field("value", bits=8, usage_page=VENDOR_PAGE, usage=0x01,
+                         logical=(0, 255)),
+               ]),
+    ]),
+
+    Application("gamepad", GENERIC_DESKTOP, GAMEPAD, [
+        Report("gamepad_in", INPUT, id=2,
+               attr="HID_REPORT_GAMEPAD_IN_IDX",
+               cccd="HID_REPORT_GAMEPAD_IN_CCCD_IDX",
+               fields=[
+                   Field("buttons", bits=1, count=8, usage_page=BUTTON_PAGE,
+                         usage_min=1, usage_max=8, logical=(0, 1)),
+                   Field("x", bits=8, usage_page=GENERIC_DESKTOP, usage=X,
+                         logical=(-127, 127)),
+                   Field("y", bits=8, usage_page=GENERIC_DESKTOP, usage=Y,
+                         logical=(-127, 127)),
+               ]),
+    ]),
+
+    Application("consumer", CONSUMER_PAGE, CONSUMER_CONTROL, [
+        Report("consumer_in", INPUT, id=3,
+               attr="HID_REPORT_CONSUMER_IN_IDX",
+               cccd="HID_REPORT_CONSUMER_IN_CCCD_IDX",
+               fields=[
+                   Field("usage", bits=16, usage_page=CONSUMER_PAGE,
+                         usage_min=0, usage_max=CONSUMER_MAX,
+                         logical=(0, CONSUMER_MAX), array=True),
+               ]),
+    ]),
+
+    Application("mouse", GENERIC_DESKTOP, MOUSE, [
+        Report("mouse_in", INPUT, id=5,
+               attr="HID_REPORT_MOUSE_IN_IDX",
+               cccd="HID_REPORT_MOUSE_IN_CCCD_IDX",
+               fields=[
+                   Field("buttons", bits=1, count=3, usage_page=BUTTON_PAGE,
+                         usage_min=1, usage_max=3, logical=(0, 1)),
+                   Pad(5),
+                   Field("x", bits=8, usage_page=GENERIC_DESKTOP, usage=X,
+                         logical=(-127, 127), relative=True),
+                   Field("y", bits=8, usage_page=GENERIC_DESKTOP, usage=Y,
+                         logical=(-127, 127), relative=True),
+                   Field("wheel", bits=8, usage_page=GENERIC_DESKTOP,
+                         usage=WHEEL, logical=(-127, 127), relative=True),
+                   Field("pan", bits=8, usage_page=CONSUMER_PAGE, usage=AC_PAN,
+                         logical=(-127, 127), relative=True),
+               ]),
+    ]),
+
+    Application("lights", VENDOR_PAGE, LIGHTS, [
+        Report("light_out", OUTPUT, id=6,
+               attr="HID_REPORT_LIGHT_OUT_IDX",
+               fields=[
+                   Field("pattern", bits=8, usage_page=VENDOR_PAGE,
+                         usage=LIGHT_PATTERN, logical=(0, 255)),
+                   Field("player", bits=8, usage_page=VENDOR_PAGE,
+                         usage=LIGHT_PLAYER, logical=(0, 255)),
+                   Field("red", bits=8, usage_page=VENDOR_PAGE,
+                         usage=LIGHT_RED, logical=(0, 255)),
+                   Field("green", bits=8, usage_page=VENDOR_PAGE,
+                         usage=LIGHT_GREEN, logical=(0, 255)),
+                   Field("blue", bits=8, usage_page=VENDOR_PAGE,
+                         usage=LIGHT_BLUE, logical=(0, 255)),
+                   Field("period", bits=8, usage_page=VENDOR_PAGE,
+                         usage=LIGHT_PERIOD, logical=(0, 255)),
+               ]),
+    ]),
+
+    Application("effects", VENDOR_PAGE, EFFECTS, [
+        Report("effect_out", OUTPUT, id=7,
+               attr="HID_REPORT_EFFECT_OUT_IDX",
+               fields=[
+                   Field("command", bits=8, usage_page=VENDOR_PAGE,
+                         usage=EFFECT_COMMAND, logical=(0, 255)),
+                   Field("frequency", bits=16, usage_page=VENDOR_PAGE,
+                         usage=EFFECT_FREQUENCY, logical=(0, 20000)),
+                   Field("duration", bits=16, usage_page=VENDOR_PAGE,
+                         usage=EFFECT_DURATION, logical=(0, 10000)),
+                   Field("level", bits=8, usage_page=VENDOR_PAGE,
+                         usage=EFFECT_LEVEL, logical=(0, 255)),
+                   Field("attack", bits=8, usage_page=VENDOR_PAGE,
+                         usage=EFFECT_ATTACK, logical=(0, 255)),
+                   Field("fade", bits=8, usage_page=VENDOR_PAGE,
+                         usage=EFFECT_FADE, logical=(0, 255)),
+               ]),
+    ]),
+]
+
+BOOT_REPORTS = [
+    Report("boot_key_in", INPUT, same_as="key_in", boot="keyboard_in",
+           attr="HID_BOOT_KEY_IN_IDX",
+           cccd="HID_BOOT_KEY_IN_CCCD_IDX"),
+
+    Report("boot_key_out", OUTPUT, same_as="led_out", boot="keyboard_out",
+           attr="HID_BOOT_KEY_OUT_IDX"),
+
+    Report("boot_mouse_in", INPUT, same_as="mouse_in", boot="mouse_in",
+           attr="HID_BOOT_MOUSE_IN_IDX",
+           cccd="HID_BOOT_MOUSE_IN_CCCD_IDX"),
+]
+
+# Reports of other services in the report map table: battery level
+EXTERNAL_REPORTS = 1
@@ -0,0 +1,621 @@
+/******************************************************************************
+
+ @file       batt_policy.c
+
+ @brief This file contains the test of the battery scaling policy. For
+        every profile the level is walked down from full to empty and
+        back up one percent at a time: a step must be entered as soon as
+        its threshold is reached and left only once the level rises more
+        than the hysteresis above it, and a level hovering at a threshold
+        must not make the step chatter.
+
+        Then discharge curves, steady, noisy and with load sags, are fed
+        to the battery service as the voltage of the simulated battery
+        monitor, with a connected central listening to the level. The
+        step the policy selects from the level must only move down while
+        the battery drains and only up while it charges, the level must
+        be notified when it falls below the critical level of the profile,
+        and setting a critical level above the level must notify it.
+
+        Usage: batt_policy [-v]
+
+          -v  print the steps taken and the notifications
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Battery scaling policy test on simulated discharge
+                        curves on the host simulation.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "peripheral.h"
+#include "battservice.h"
+#include "battpolicy.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Voltages of a full and an empty battery on the curves, in mV
+#define BP_FULL_MV                      3300
+#define BP_EMPTY_MV                     1950
+
+// Voltage change per sample while draining and charging, in mV
+#define BP_DRAIN_MV                     2
+#define BP_CHARGE_MV                    5
+
+// Noise amplitude of the noisy curve, in mV
+#define BP_NOISE_MV                     25
+
+// Load sags: every BP_SAG_PERIOD samples the voltage drops by
+// BP_SAG_MV for BP_SAG_SAMPLES samples, e.g. rumble or a cold battery
+#define BP_SAG_PERIOD                   40
+#define BP_SAG_SAMPLES                  3
+#define BP_SAG_MV                       60
+
+// Voltage between the critical levels of the performance and economy
+// profiles, in mV
+#define BP_CRITICAL_MV                  2500
+
+// Samples at a constant voltage to settle the filter of the service
+#define BP_SETTLE_SAMPLES               16
+
+// Rounds of a level hovering at a threshold
+#define BP_HOVER_ROUNDS                 20
+
+// Shapes of the discharge curves
+#define BP_CURVE_STEADY                 0
+#define BP_CURVE_NOISY                  1
+#define BP_CURVE_SAG                    2
+#define BP_NUM_CURVES                   3
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static const char *bpProfileNames[BATTPOLICY_NUM_PROFILES] =
+{
+    "performance", "balanced", "economy"
+};
+
+static const char *bpCurveNames[BP_NUM_CURVES] =
+{
+    "steady", "noisy", "sag"
+};
+
+// Noise generator state
+static uint32_t bpSeed = 1;
+
+// Level notifications seen by the central, and the last level notified
+static uint32_t bpNotis = 0;
+static uint8_t bpNotiLevel = 100;
+
+static Task_Struct bpTask;
+static Event_Struct bpEvent;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Bp_fail
+ *
+ * @brief   Report a failed check and exit.
+ *
+ * @param   fmt - printf format
+ *
+ * @return  none
+ */
+static void Bp_fail(const char *fmt, ...)
+{
+    va_list ap;
+
+    printf("batt_policy: FAIL: ");
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    putchar('\n');
+
+    exit(1);
+}
+
+/*********************************************************************
+ * @fn      Bp_noise
+ *
+ * @brief   Pseudo random noise, the same on every run.
+ *
+ * @param   amplitude - largest deviation
+ *
+ * @return  noise in -amplitude to amplitude
+ */
+static int16_t Bp_noise(int16_t amplitude)
+{
+    bpSeed = bpSeed * 1103515245 + 12345;
+
+    return (int16_t)((bpSeed >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+/*********************************************************************
+ * @fn      Bp_notiTap
+ *
+ * @brief   Note the level notifications the central receives.
+ *
+ * @param   pNoti - notification
+ *
+ * @return  none
+ */
+static void Bp_notiTap(const simNoti_t *pNoti)
+{
+    if (pNoti->len == 1)
+    {
+        bpNotis++;
+        bpNotiLevel = pNoti->pValue[0];
+    }
+}
+
+/*********************************************************************
+ * @fn      Bp_taskFxn
+ *
+ * @brief   Application task, idle; it lets the GAPRole state changes
+ *          run in virtual time.
+ *
+ * @param   a0, a1 - not used
+ *
+ * @return  none
+ */
+static void Bp_taskFxn(UArg a0, UArg a1)
+{
+    for (;;)
+    {
+        Event_pend(&bpEvent, Event_Id_NONE, Event_Id_00, BIOS_WAIT_FOREVER);
+    }
+}
+
+/*********************************************************************
+ * @fn      Bp_walk
+ *
+ * @brief   Walk the level of a profile from full to empty and back one
+ *          percent at a time, and start from every level.
+ *
+ * @param   profile - BATTPOLICY_PROFILE_*
+ *
+ * @return  step changes
+ */
+static uint32_t Bp_walk(uint8_t profile)
+{
+    const battPolicyProfile_t *pProfile = BattPolicy_getProfile(profile);
+    const battPolicyStep_t *pSteps = pProfile->pSteps;
+    uint32_t changes = 0;
+    uint8_t expected;
+    uint8_t step;
+    uint8_t next;
+    int16_t level;
+
+    // Start: the deepest step whose threshold the level is at or below
+    for (level = 0; level <= 100; level++)
+    {
+        expected = 0;
+        while (((expected + 1) < pProfile->numSteps) &&
+               (level <= pSteps[expected + 1].level))
+        {
+            expected++;
+        }
+
+        step = BattPolicy_selectStep(pProfile, (uint8_t)level,
+                                     BATTPOLICY_STEP_NONE);
+        if (step != expected)
+        {
+            Bp_fail("%s: start at %d%% in step %u, expected %u",
+                    bpProfileNames[profile], level, step, expected);
+        }
+    }
+
+    // Draining, the next step is entered on its threshold
+    step = BattPolicy_selectStep(pProfile, 100, BATTPOLICY_STEP_NONE);
+
+    for (level = 100; level >= 0; level--)
+    {
+        expected = step;
+        if (((step + 1) < pProfile->numSteps) &&
+            (level <= pSteps[step + 1].level))
+        {
+            expected = step + 1;
+        }
+
+        next = BattPolicy_selectStep(pProfile, (uint8_t)level, step);
+        if (next != expected)
+        {
+            Bp_fail("%s: draining at %d%% from step %u to %u, expected %u",
+                    bpProfileNames[profile], level, step, next, expected);
+        }
+
+        changes += (next != step);
+        step = next;
+    }
+
+    if (step != pProfile->numSteps - 1)
+    {
+        Bp_fail("%s: empty in step %u", bpProfileNames[profile], step);
+    }
+
+    // Charging, a step is left once the level is clear of the hysteresis
+    for (level = 0; level <= 100; level++)
+    {
+        expected = step;
+        if ((step > 0) &&
+            (level > pSteps[step].level + pProfile->hysteresis))
+        {
+            expected = step - 1;
+        }
+
+        next = BattPolicy_selectStep(pProfile, (uint8_t)level, step);
+        if (next != expected)
+        {
+            Bp_fail("%s: charging at %d%% from step %u to %u, expected %u",
+                    bpProfileNames[profile], level, step, next, expected);
+        }
+
+        changes += (next != step);
+        step = next;
+    }
+
+    if (step != 0)
+    {
+        Bp_fail("%s: full in step %u", bpProfileNames[profile], step);
+    }
+
+    return changes;
+}
+
+/*********************************************************************
+ * @fn      Bp_hover
+ *
+ * @brief   Keep the level of a profile hovering at every threshold,
+ *          within the hysteresis: the step must change once going down
+ *          and once when the level clears the hysteresis.
+ *
+ * @param   profile - BATTPOLICY_PROFILE_*
+ *
+ * @return  none
+ */
+static void Bp_hover(uint8_t profile)
+{
+    const battPolicyProfile_t *pProfile = BattPolicy_getProfile(profile);
+    uint8_t changes;
+    uint8_t threshold;
+    uint8_t round;
+    uint8_t level;
+    uint8_t step;
+    uint8_t next;
+    uint8_t i;
+
+    for (i = 1; i < pProfile->numSteps; i++)
+    {
+        threshold = pProfile->pSteps[i].level;
+        step = BattPolicy_selectStep(pProfile, threshold + 1,
+                                     BATTPOLICY_STEP_NONE);
+        changes = 0;
+
+        for (round = 0; round < BP_HOVER_ROUNDS; round++)
+        {
+            // Down to the threshold and up to the top of the hysteresis
+            level = (round & 1) ? threshold + pProfile->hysteresis :
+                                  threshold + (round % pProfile->hysteresis);
+            next = BattPolicy_selectStep(pProfile, level, step);
+            changes += (next != step);
+            step = next;
+        }
+
+        if ((changes != 1) || (step != i))
+        {
+            Bp_fail("%s: hovering at %u%%, %u changes, in step %u",
+                    bpProfileNames[profile], threshold, changes, step);
+        }
+
+        step = BattPolicy_selectStep(pProfile,
+                                     threshold + pProfile->hysteresis + 1,
+                                     step);
+        if (step != i - 1)
+        {
+            Bp_fail("%s: above the hysteresis of %u%% in step %u",
+                    bpProfileNames[profile], threshold, step);
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      Bp_sample
+ *
+ * @brief   Set the battery voltage and let the service measure it.
+ *
+ * @param   mV - battery voltage
+ *
+ * @return  level measured by the service
+ */
+static uint8_t Bp_sample(int16_t mV)
+{
+    uint8_t level;
+
+    SimIo_setBattery((uint16_t)mV);
+    Batt_MeasLevel();
+    Batt_GetParameter(BATT_PARAM_LEVEL, &level);
+
+    return level;
+}
+
+/*********************************************************************
+ * @fn      Bp_settle
+ *
+ * @brief   Hold the battery voltage until the service filter settles.
+ *
+ * @param   mV - battery voltage
+ *
+ * @return  level measured by the service
+ */
+static uint8_t Bp_settle(int16_t mV)
+{
+    uint8_t level = 0;
+    uint8_t i;
+
+    for (i = 0; i < BP_SETTLE_SAMPLES; i++)
+    {
+        level = Bp_sample(mV);
+    }
+
+    return level;
+}
+
+/*********************************************************************
+ * @fn      Bp_curveMv
+ *
+ * @brief   Battery voltage of a curve at a sample.
+ *
+ * @param   curve - BP_CURVE_*
+ * @param   base - voltage of the steady curve
+ * @param   sample - sample index
+ *
+ * @return  voltage in mV
+ */
+static int16_t Bp_curveMv(uint8_t curve, int16_t base, uint32_t sample)
+{
+    switch (curve)
+    {
+        case BP_CURVE_NOISY:
+            return base + Bp_noise(BP_NOISE_MV);
+
+        case BP_CURVE_SAG:
+            return ((sample % BP_SAG_PERIOD) < BP_SAG_SAMPLES) ?
+                   base - BP_SAG_MV : base;
+
+        default:
+            return base;
+    }
+}
+
+/*********************************************************************
+ * @fn      Bp_curve
+ *
+ * @brief   Drain the battery along a curve and charge it back, running
+ *          the policy on the level the service measures as the
+ *          application does.
+ *
+ * @param   profile - BATTPOLICY_PROFILE_*
+ * @param   curve - BP_CURVE_*
+ *
+ * @return  none
+ */
+static void Bp_curve(uint8_t profile, uint8_t curve)
+{
+    const battPolicyProfile_t *pProfile = BattPolicy_getProfile(profile);
+    const char *pName = bpProfileNames[profile];
+    const char *pCurve = bpCurveNames[curve];
+    uint8_t critical = pProfile->criticalLevel;
+    uint8_t criticalNotified = FALSE;
+    uint32_t sample = 0;
+    uint32_t notis;
+    uint8_t prevLevel;
+    uint8_t level;
+    uint8_t step;
+    uint8_t next;
+    int16_t mV;
+
+    bpSeed = 1;
+    Batt_SetParameter(BATT_PARAM_CRITICAL_LEVEL, sizeof(uint8_t), &critical);
+
+    level = Bp_settle(BP_FULL_MV);
+    step = BattPolicy_selectStep(pProfile, level, BATTPOLICY_STEP_NONE);
+    if (step != 0)
+    {
+        Bp_fail("%s %s: full battery in step %u", pName, pCurve, step);
+    }
+
+    // Draining: the step only moves down, the critical level is notified
+    for (mV = BP_FULL_MV; mV >= BP_EMPTY_MV; mV -= BP_DRAIN_MV, sample++)
+    {
+        prevLevel = level;
+        notis = bpNotis;
+        level = Bp_sample(Bp_curveMv(curve, mV, sample));
+
+        if ((level < critical) && (prevLevel >= critical))
+        {
+            if ((bpNotis == notis) || (bpNotiLevel != level))
+            {
+                Bp_fail("%s %s: %u%% below the critical %u%% not notified",
+                        pName, pCurve, level, critical);
+            }
+
+            criticalNotified = TRUE;
+        }
+
+        next = BattPolicy_selectStep(pProfile, level, step);
+        if (next < step)
+        {
+            Bp_fail("%s %s: draining at %d mV, %u%%, up from step %u to %u",
+                    pName, pCurve, mV, level, step, next);
+        }
+
+        if (next != step)
+        {
+            SimRtos_log(SIM_LOG_EVENT, "%s %s: %d mV, %u%%, step %u",
+                        pName, pCurve, mV, level, next);
+        }
+
+        step = next;
+    }
+
+    if (!criticalNotified || (step != pProfile->numSteps - 1))
+    {
+        Bp_fail("%s %s: drained to %u%% in step %u", pName, pCurve, level,
+                step);
+    }
+
+    // Charging: the step only moves up
+    for (mV = BP_EMPTY_MV; mV <= BP_FULL_MV; mV += BP_CHARGE_MV, sample++)
+    {
+        level = Bp_sample(Bp_curveMv(curve, mV, sample));
+
+        next = BattPolicy_selectStep(pProfile, level, step);
+        if (next > step)
+        {
+            Bp_fail("%s %s: charging at %d mV, %u%%, down from step %u to %u",
+                    pName, pCurve, mV, level, step, next);
+        }
+
+        if (next != step)
+        {
+            SimRtos_log(SIM_LOG_EVENT, "%s %s: %d mV, %u%%, step %u",
+                        pName, pCurve, mV, level, next);
+        }
+
+        step = next;
+    }
+
+    level = Bp_settle(BP_FULL_MV);
+    step = BattPolicy_selectStep(pProfile, level, step);
+    if (step != 0)
+    {
+        Bp_fail("%s %s: charged to %u%% in step %u", pName, pCurve, level,
+                step);
+    }
+}
+
+/*********************************************************************
+ * @fn      Bp_criticalSet
+ *
+ * @brief   Set a critical level above the battery level, as a profile
+ *          change does: the level must be notified at once.
+ *
+ * @return  none
+ */
+static void Bp_criticalSet(void)
+{
+    const battPolicyProfile_t *pProfile;
+    uint8_t critical;
+    uint8_t level;
+    uint32_t notis;
+
+    pProfile = BattPolicy_getProfile(BATTPOLICY_PROFILE_PERFORMANCE);
+    critical = pProfile->criticalLevel;
+    Batt_SetParameter(BATT_PARAM_CRITICAL_LEVEL, sizeof(uint8_t), &critical);
+
+    // 2500 mV is 10%, between the critical levels of the two profiles
+    level = Bp_settle(BP_CRITICAL_MV);
+    if (level < critical)
+    {
+        Bp_fail("battery at %u%%, below the critical %u%%", level, critical);
+    }
+
+    pProfile = BattPolicy_getProfile(BATTPOLICY_PROFILE_ECONOMY);
+    critical = pProfile->criticalLevel;
+    notis = bpNotis;
+    Batt_SetParameter(BATT_PARAM_CRITICAL_LEVEL, sizeof(uint8_t), &critical);
+
+    if ((level >= critical) || (bpNotis != notis + 1) ||
+        (bpNotiLevel != level))
+    {
+        Bp_fail("critical level %u%% above %u%% not notified", critical,
+                level);
+    }
+
+    Bp_settle(BP_FULL_MV);
+}
+
+/*********************************************************************
+ * @fn      Bp_connect
+ *
+ * @brief   Add the battery service and connect a central listening to
+ *          the level.
+ *
+ * @return  none
+ */
+static void Bp_connect(void)
+{
+    Task_Params taskParams;
+    uint8_t advEnabled = TRUE;
+
+    Task_Params_init(&taskParams);
+    Task_construct(&bpTask, Bp_taskFxn, &taskParams, NULL);
+
+    Batt_AddService();
+    GAPRole_SetParameter(GAPROLE_ADVERT_ENABLED, sizeof(uint8_t), &advEnabled);
+    GAPRole_StartDevice(NULL);
+    SimRtos_run(SimRtos_now() + SIM_MS(1));
+
+    SimBle_connect(SIM_DEFAULT_CONN_INTERVAL, SIM_DEFAULT_CONN_LATENCY,
+                   SIM_DEFAULT_CONN_TIMEOUT);
+    if (SimBle_enableNotifications() == 0)
+    {
+        Bp_fail("level notifications not enabled");
+    }
+
+    SimBle_setNotiTap(Bp_notiTap);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t changes = 0;
+    uint8_t profile;
+    uint8_t curve;
+
+    simLogMask = ((argc > 1) && (strcmp(argv[1], "-v") == 0)) ?
+                 SIM_LOG_DEFAULT : 0;
+
+    for (profile = 0; profile < BATTPOLICY_NUM_PROFILES; profile++)
+    {
+        changes += Bp_walk(profile);
+        Bp_hover(profile);
+    }
+
+    Bp_connect();
+
+    for (profile = 0; profile < BATTPOLICY_NUM_PROFILES; profile++)
+    {
+        for (curve = 0; curve < BP_NUM_CURVES; curve++)
+        {
+            Bp_curve(profile, curve);
+        }
+    }
+
+    Bp_criticalSet();
+
+    printf("batt_policy: passed, %u step changes, %u level notifications\n",
+           changes, bpNotis);
+
+    return 0;
+}
+
+/*********************************************************************
+*********************************************************************/
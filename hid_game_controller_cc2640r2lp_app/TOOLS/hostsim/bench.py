@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+ @file       bench.py
+
+ @brief Report path benchmark matrix of the BLE Game Controller host
+        simulation.
+
+ Project: BLE Game Controller
+ Modification Details : Report path throughput and drop benchmark on the
+                        host simulation.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+
+ Usage:
+   bench.py [-o RESULTS] [--compare BASELINE] [--queue-lens 4,10,32]
+            [--coalesce none,same,latest]
+
+ Builds hostbench once per HidDev queue length and coalescing mode, in
+ build/bench/, and runs every build over the connection and workload
+ matrix below. Every run is one JSON line tagged with the commit, printed
+ and appended to RESULTS when given.
+
+ With --compare, the runs are matched by configuration against the runs of
+ the same matrix in BASELINE, e.g. the results of the previous commit, and
+ every metric that got worse is listed. The simulation is deterministic,
+ so any change of a count or a latency is real. The host CPU times are
+ noisy, only a change beyond CPU_TOLERANCE is listed, as a warning. The
+ exit status is 1 when a deterministic metric regressed.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+COALESCE_MODES = {"none": 0, "same": 1, "latest": 2}
+
+# Connection interval (1.25 ms), slave latency, packet loss per mille
+CONNECTIONS = (
+    (6, 0, 0),
+    (24, 0, 0),
+    (24, 4, 0),
+    (12, 0, 50),
+)
+
+# Reports per second, reports per key state, link outage in ms
+WORKLOADS = (
+    (250, 1, 0),
+    (1000, 1, 0),
+    (500, 4, 1500),
+)
+
+DURATION_MS = 5000
+
+# Members that identify a run
+CONFIG_KEYS = ("queue_len", "coalesce", "interval", "latency", "loss",
+               "rate", "repeat", "duration_ms", "outage_ms")
+
+# Deterministic metrics where more is worse, and where less is worse
+WORSE_IF_HIGHER = ("noti_failed", "discarded", "overflows", "buffer_full",
+                   "link_dropped", "inputs_lost", "latency_p50_ms",
+                   "latency_p99_ms", "latency_max_ms")
+WORSE_IF_LOWER = ("delivered", "delivered_per_s")
+
+CPU_KEYS = ("report_ns_mean", "send_evt_ns_mean")
+CPU_TOLERANCE = 0.25
+
+
+def commit():
+    """Return the short hash of HEAD, marked when the tree has changes."""
+    try:
+        rev = subprocess.check_output(["git", "rev-parse", "--short", "HEAD"],
+                                      cwd=HERE, text=True).strip()
+        dirty = subprocess.call(["git", "diff", "--quiet", "HEAD", "--", "."],
+                                cwd=os.path.join(HERE, "..", ".."))
+        return rev + ("-dirty" if dirty else "")
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def build(queue_len, coalesce):
+    """Build hostbench for a HidDev variant, return the binary path."""
+    out = os.path.join("build", "bench", "q%d-%s" % (queue_len, coalesce))
+    opts = "-DHID_DEV_RPT_QUEUE_LEN=%d -DHID_DEV_RPT_COALESCE=%d" % (
+        queue_len, COALESCE_MODES[coalesce])
+
+    subprocess.check_call(["make", "-s", "OUT=" + out,
+                           "HIDDEV_OPTS=" + opts, "hostbench"], cwd=HERE)
+
+    return os.path.join(HERE, out, "hostbench")
+
+
+def run(binary, connection, workload):
+    """Run one configuration, return its result."""
+    interval, latency, loss = connection
+    rate, repeat, outage = workload
+    args = [binary, "-r", str(rate), "-s", str(repeat),
+            "-d", str(DURATION_MS), "-i", str(interval), "-l", str(latency),
+            "-L", str(loss), "-o", str(outage)]
+
+    return json.loads(subprocess.check_output(args, text=True))
+
+
+def config_of(result):
+    return tuple(result[k] for k in CONFIG_KEYS)
+
+
+def compare(results, path):
+    """List the metrics worse than in the baseline, return the number of
+    deterministic regressions."""
+    baseline = {}
+    with open(path) as f:
+        for line in f:
+            if line.strip():
+                result = json.loads(line)
+                baseline[config_of(result)] = result
+
+    regressions = 0
+    for result in results:
+        base = baseline.get(config_of(result))
+        if base is None:
+            continue
+
+        name = " ".join("%s=%s" % (k, result[k]) for k in CONFIG_KEYS)
+        for key in WORSE_IF_HIGHER:
+            if result[key] > base[key]:
+                print("REGRESSION %s: %s %s -> %s" % (name, key, base[key],
+                                                      result[key]))
+                regressions += 1
+        for key in WORSE_IF_LOWER:
+            if result[key] < base[key]:
+                print("REGRESSION %s: %s %s -> %s" % (name, key, base[key],
+                                                      result[key]))
+                regressions += 1
+        for key in CPU_KEYS:
+            if base[key] and result[key] > base[key] * (1 + CPU_TOLERANCE):
+                print("warning %s: %s %s -> %s" % (name, key, base[key],
+                                                   result[key]))
+
+    print("%d regressions against %s (%s)" % (
+        regressions, path, next(iter(baseline.values()))["commit"]
+        if baseline else "empty"))
+
+    return regressions
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Report path benchmark")
+    parser.add_argument("-o", "--output", help="append the results here")
+    parser.add_argument("--compare", help="results of a baseline commit")
+    parser.add_argument("--queue-lens", default="4,10,32",
+                        help="HID_DEV_RPT_QUEUE_LEN values")
+    parser.add_argument("--coalesce", default="none,same,latest",
+                        help="HID_DEV_RPT_COALESCE modes")
+    args = parser.parse_args(argv[1:])
+
+    rev = commit()
+    results = []
+
+    for queue_len in (int(q) for q in args.queue_lens.split(",")):
+        for coalesce in args.coalesce.split(","):
+            binary = build(queue_len, coalesce)
+
+            for connection in CONNECTIONS:
+                for workload in WORKLOADS:
+                    result = dict(commit=rev)
+                    result.update(run(binary, connection, workload))
+                    results.append(result)
+                    print(json.dumps(result))
+
+    if args.output:
+        with open(args.output, "a") as f:
+            for result in results:
+                f.write(json.dumps(result) + "\n")
+
+    if args.compare:
+        return 1 if compare(results, args.compare) else 0
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,1112 @@
+/******************************************************************************
+
+ @file       fuzz_attr.c
+
+ @brief This file contains the fuzzing harness of the GATT attribute
+        callbacks of the HID, Battery and Scan Parameters services:
+        HidDev_ReadAttrCB, HidDev_WriteAttrCB, battReadAttrCB,
+        battWriteAttrCB and scanParamWriteAttrCB. The services register
+        their real attribute tables with the GATT server of the host
+        simulation, a connected and encrypted central is set up in virtual
+        time, then every input is a sequence of reads and writes called
+        straight into the callbacks, as the stack would after its own
+        permission checks.
+
+        Input record, repeated up to FUZZ_MAX_RECORDS times:
+
+          [0]     bit 0 write, bit 1 write command or read blob
+          [1..2]  handle, little endian, folded into the handles in use
+          [3..4]  offset, little endian
+          [5]     write: value length, read: MTU - 23
+          [6..]   write: value, cut short at the end of the input
+
+        After every input the HID task runs until it has nothing left to
+        do, then the harness checks that the protocol mode, the scan
+        parameters, the CCCDs, the read-only values and the ICall heap are
+        as valid as before. A violation aborts with a message.
+
+        Built with FUZZ_LIBFUZZER and clang -fsanitize=fuzzer it is a
+        libFuzzer target. Otherwise it has its own driver:
+
+        Usage: fuzz_attr [-r runs] [-t seconds] [-e exec/s] [-s seed]
+                         [CORPUS...]
+               fuzz_attr -m DIR
+
+          -r  mutated runs after the corpus, default 0
+          -t  mutate for this many seconds instead
+          -e  fail when the executions per second stay below this
+          -s  random seed, default 1
+          -m  write the seed corpus into DIR and exit
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Fuzzing harness of the GATT attribute callbacks on
+                        the host simulation.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "util.h"
+#include "hiddev.h"
+#include "hidkbdservice.h"
+#include "battservice.h"
+#include "scanparamservice.h"
+#include "peripheral.h"
+#include "gatt_uuid.h"
+#include "gatt_profile_uuid.h"
+
+#ifndef FUZZ_LIBFUZZER
+#include <dirent.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sanitizer/common_interface_defs.h>
+#endif // !FUZZ_LIBFUZZER
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// HidDev is set up in the task of the fuzzing harness with HidDev_initTask
+#ifndef HID_DEV_SINGLE_TASK
+#error "The fuzzing harness needs HID_DEV_SINGLE_TASK"
+#endif // !HID_DEV_SINGLE_TASK
+
+// Input records
+#define FUZZ_REC_WRITE                  0x01
+#define FUZZ_REC_ALT                    0x02
+#define FUZZ_REC_HDR_LEN                6
+#define FUZZ_MAX_RECORDS                32
+
+// Largest MTU of the stack
+#define FUZZ_MAX_MTU                    251
+
+// Event rounds the HID task gets to settle after an input
+#define FUZZ_SETTLE_ROUNDS              64
+
+// Read-only values checked after every input
+#define FUZZ_MAX_RO_VALUES              16
+
+// Scan interval and window range, in 625 us units
+#define FUZZ_SCAN_MIN                   0x0004
+#define FUZZ_SCAN_MAX                   0x4000
+
+// Setup of the connection in ms, the run ends when it is encrypted
+#define FUZZ_CONNECT_MS                 10
+#define FUZZ_PAIR_MS                    100
+#define FUZZ_SETUP_MS                   500
+
+#define FUZZ_ICALL_EVT                  ICALL_MSG_EVENT_ID
+#define FUZZ_ALL_EVENTS                 (FUZZ_ICALL_EVT | HID_DEV_ALL_EVENTS)
+
+#ifndef FUZZ_LIBFUZZER
+// Standalone driver
+#define FUZZ_MAX_INPUT                  512
+#define FUZZ_MAX_CORPUS                 1024
+#define FUZZ_TIMEOUT_S                  2
+#endif // !FUZZ_LIBFUZZER
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Value of a read-only attribute at start
+typedef struct
+{
+    gattAttribute_t *pAttr;
+    uint16_t len;
+    uint8_t *pCopy;
+} fuzzRoValue_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static ICall_EntityID selfEntity;
+static ICall_SyncHandle syncEvent;
+static Task_Struct fuzzTask;
+
+static hidDevCfg_t fuzzHidCfg =
+{
+    0,                          // No idle timeout
+    HID_KBD_FLAGS
+};
+
+static bool initialized = FALSE;
+
+// State checked after every input
+static gattAttribute_t *pScanWindowAttr = NULL;
+static fuzzRoValue_t roValues[FUZZ_MAX_RO_VALUES];
+static uint8_t numRoValues = 0;
+static uint32_t heapFree = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8_t Fuzz_reportCB(uint8_t id, uint8_t type, uint16_t uuid,
+                             uint8_t oper, uint16_t *pLen, uint8_t *pData);
+static void Fuzz_evtCB(uint8_t evt);
+
+/*********************************************************************
+ * PROFILE CALLBACKS
+ */
+
+static hidDevCB_t fuzzHidCBs =
+{
+    Fuzz_reportCB,
+    Fuzz_evtCB,
+    NULL
+};
+
+// Report callback of the application, without the LED output
+static uint8_t Fuzz_reportCB(uint8_t id, uint8_t type, uint16_t uuid,
+                             uint8_t oper, uint16_t *pLen, uint8_t *pData)
+{
+    uint8_t status = SUCCESS;
+
+    if (oper == HID_DEV_OPER_WRITE)
+    {
+        status = HidKbd_SetParameter(id, type, uuid, *pLen, pData);
+    }
+    else if (oper == HID_DEV_OPER_READ)
+    {
+        uint8_t len;
+
+        status = HidKbd_GetParameter(id, type, uuid, &len, pData);
+        if (status == SUCCESS)
+        {
+            *pLen = len;
+        }
+    }
+
+    return status;
+}
+
+static void Fuzz_evtCB(uint8_t evt)
+{
+}
+
+/*********************************************************************
+ * @fn      Fuzz_fail
+ *
+ * @brief   Report a violation and abort, the sanitizers or the driver
+ *          save the input.
+ *
+ * @param   pWhat - violation
+ * @param   handle - attribute handle
+ *
+ * @return  none
+ */
+static void Fuzz_fail(const char *pWhat, uint16_t handle)
+{
+    fprintf(stderr, "fuzz_attr: %s, handle 0x%04x\n", pWhat, handle);
+    abort();
+}
+
+/*********************************************************************
+ * @fn      Fuzz_uuid
+ *
+ * @brief   16-bit UUID of an attribute, 0 for 128-bit UUIDs.
+ */
+static uint16_t Fuzz_uuid(const gattAttribute_t *pAttr)
+{
+    if (pAttr->type.len != ATT_BT_UUID_SIZE)
+    {
+        return 0;
+    }
+
+    return BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]);
+}
+
+/*********************************************************************
+ * @fn      Fuzz_roLen
+ *
+ * @brief   Length of the value of a read-only attribute the harness
+ *          watches.
+ *
+ * @param   pAttr - attribute
+ *
+ * @return  Length, 0 when not watched
+ */
+static uint16_t Fuzz_roLen(const gattAttribute_t *pAttr)
+{
+    if (pAttr->permissions & (GATT_PERMIT_WRITE | GATT_PERMIT_ENCRYPT_WRITE |
+                              GATT_PERMIT_AUTHEN_WRITE))
+    {
+        return 0;
+    }
+
+    switch (Fuzz_uuid(pAttr))
+    {
+        case REPORT_MAP_UUID:
+            return hidReportMapLen;
+
+        case HID_INFORMATION_UUID:
+            return HID_INFORMATION_LEN;
+
+        case GATT_REPORT_REF_UUID:
+            return HID_REPORT_REF_LEN;
+
+        case GATT_EXT_REPORT_REF_UUID:
+            return HID_EXT_REPORT_REF_LEN;
+
+        default:
+            return 0;
+    }
+}
+
+/*********************************************************************
+ * @fn      Fuzz_settle
+ *
+ * @brief   Run the HID task until it has nothing left to do. A task that
+ *          keeps posting itself events is hung.
+ *
+ * @return  none
+ */
+static void Fuzz_settle(void)
+{
+    uint8_t round;
+
+    for (round = 0; round < FUZZ_SETTLE_ROUNDS; round++)
+    {
+        uint32_t events = Event_pend(syncEvent, Event_Id_NONE,
+                                     FUZZ_ALL_EVENTS, BIOS_NO_WAIT);
+        ICall_EntityID dest;
+        ICall_ServiceEnum src;
+        ICall_HciExtEvt *pMsg = NULL;
+
+        if (events == 0)
+        {
+            return;
+        }
+
+        if (ICall_fetchServiceMsg(&src, &dest,
+                                  (void **)&pMsg) == ICALL_ERRNO_SUCCESS)
+        {
+            if (pMsg)
+            {
+                ICall_freeMsg(pMsg);
+            }
+        }
+
+        HidDev_processEvents(events);
+    }
+
+    Fuzz_fail("HID task does not settle", 0);
+}
+
+/*********************************************************************
+ * @fn      Fuzz_check
+ *
+ * @brief   Check the state the callbacks may change.
+ *
+ * @return  none
+ */
+static void Fuzz_check(void)
+{
+    Memory_Stats stats;
+    uint16_t handle;
+    uint8_t i;
+
+    if ((hidProtocolMode != HID_PROTOCOL_MODE_BOOT) &&
+        (hidProtocolMode != HID_PROTOCOL_MODE_REPORT))
+    {
+        Fuzz_fail("invalid protocol mode", 0);
+    }
+
+    // Zero until the first valid write
+    if (pScanWindowAttr)
+    {
+        uint8_t *pValue = pScanWindowAttr->pValue;
+        uint16_t interval = BUILD_UINT16(pValue[0], pValue[1]);
+        uint16_t window = BUILD_UINT16(pValue[2], pValue[3]);
+
+        if (((interval != 0) || (window != 0)) &&
+            ((interval > FUZZ_SCAN_MAX) || (window < FUZZ_SCAN_MIN) ||
+             (window > interval)))
+        {
+            Fuzz_fail("invalid scan interval window", pScanWindowAttr->handle);
+        }
+    }
+
+    for (handle = GATT_MIN_HANDLE; handle <= SimBle_getLastHandle(); handle++)
+    {
+        const gattServiceCBs_t *pCBs;
+        gattAttribute_t *pAttr = SimBle_getAttr(handle, &pCBs);
+
+        if (pAttr && (Fuzz_uuid(pAttr) == GATT_CLIENT_CHAR_CFG_UUID))
+        {
+            uint16_t value = GATTServApp_ReadCharCfg(SIM_CONN_HANDLE,
+                                                     GATT_CCC_TBL(pAttr->pValue));
+
+            if ((value & ~GATT_CLIENT_CFG_NOTIFY) != 0)
+            {
+                Fuzz_fail("invalid CCCD value", handle);
+            }
+        }
+    }
+
+    for (i = 0; i < numRoValues; i++)
+    {
+        if (memcmp(roValues[i].pAttr->pValue, roValues[i].pCopy,
+                   roValues[i].len) != 0)
+        {
+            Fuzz_fail("read-only value changed", roValues[i].pAttr->handle);
+        }
+    }
+
+    Memory_getStats(NULL, &stats);
+    if (stats.totalFreeSize != heapFree)
+    {
+        Fuzz_fail("ICall heap leak", 0);
+    }
+}
+
+/*********************************************************************
+ * @fn      Fuzz_taskFxn
+ *
+ * @brief   Set up the services as the application does.
+ *
+ * @param   a0, a1 - not used.
+ *
+ * @return  none
+ */
+static void Fuzz_taskFxn(UArg a0, UArg a1)
+{
+    uint8_t advEnable = TRUE;
+
+    ICall_registerApp(&selfEntity, &syncEvent);
+    HidDev_initTask(selfEntity, syncEvent);
+
+    GAPRole_SetParameter(GAPROLE_ADVERT_ENABLED, sizeof(uint8_t), &advEnable);
+
+    HidKbd_AddService();
+    HidDev_Register(&fuzzHidCfg, &fuzzHidCBs);
+    HidDev_StartDevice();
+
+    for (;;)
+    {
+        uint32_t events = Event_pend(syncEvent, Event_Id_NONE,
+                                     FUZZ_ALL_EVENTS, ICALL_TIMEOUT_FOREVER);
+        ICall_EntityID dest;
+        ICall_ServiceEnum src;
+        ICall_HciExtEvt *pMsg = NULL;
+
+        if (ICall_fetchServiceMsg(&src, &dest,
+                                  (void **)&pMsg) == ICALL_ERRNO_SUCCESS)
+        {
+            if (pMsg)
+            {
+                ICall_freeMsg(pMsg);
+            }
+        }
+
+        HidDev_processEvents(events);
+    }
+}
+
+static void Fuzz_connect(uintptr_t arg)
+{
+    SimBle_connect(SIM_DEFAULT_CONN_INTERVAL, SIM_DEFAULT_CONN_LATENCY,
+                   SIM_DEFAULT_CONN_TIMEOUT);
+}
+
+static void Fuzz_pair(uintptr_t arg)
+{
+    SimBle_pair();
+}
+
+/*********************************************************************
+ * @fn      Fuzz_init
+ *
+ * @brief   Run the setup in virtual time up to an encrypted connection and
+ *          note the state to check.
+ *
+ * @return  none
+ */
+static void Fuzz_init(void)
+{
+    Task_Params taskParams;
+    Memory_Stats stats;
+    uint16_t handle;
+
+    simLogMask = 0;
+
+    SimRtos_defer(SIM_MS(FUZZ_CONNECT_MS), Fuzz_connect, 0);
+    SimRtos_defer(SIM_MS(FUZZ_PAIR_MS), Fuzz_pair, 0);
+
+    Task_Params_init(&taskParams);
+    Task_construct(&fuzzTask, Fuzz_taskFxn, &taskParams, NULL);
+
+    SimRtos_run(SIM_MS(FUZZ_SETUP_MS));
+
+    for (handle = GATT_MIN_HANDLE; handle <= SimBle_getLastHandle(); handle++)
+    {
+        const gattServiceCBs_t *pCBs;
+        gattAttribute_t *pAttr = SimBle_getAttr(handle, &pCBs);
+        uint16_t len;
+
+        if (pAttr == NULL)
+        {
+            continue;
+        }
+
+        if (Fuzz_uuid(pAttr) == SCAN_INTERVAL_WINDOW_UUID)
+        {
+            pScanWindowAttr = pAttr;
+        }
+
+        len = Fuzz_roLen(pAttr);
+        if (len && (numRoValues < FUZZ_MAX_RO_VALUES))
+        {
+            roValues[numRoValues].pAttr = pAttr;
+            roValues[numRoValues].len = len;
+            roValues[numRoValues].pCopy = malloc(len);
+            memcpy(roValues[numRoValues].pCopy, pAttr->pValue, len);
+            numRoValues++;
+        }
+    }
+
+    Memory_getStats(NULL, &stats);
+    heapFree = stats.totalFreeSize;
+
+    initialized = TRUE;
+}
+
+/*********************************************************************
+ * @fn      Fuzz_record
+ *
+ * @brief   Call the attribute callback of one input record, as the stack
+ *          would after its own checks.
+ *
+ * @param   pData - record
+ * @param   size - bytes left in the input
+ *
+ * @return  Length of the record
+ */
+static size_t Fuzz_record(const uint8_t *pData, size_t size)
+{
+    const gattServiceCBs_t *pCBs;
+    gattAttribute_t *pAttr;
+    uint16_t lastHandle = SimBle_getLastHandle();
+    uint16_t handle = BUILD_UINT16(pData[1], pData[2]);
+    uint16_t offset = BUILD_UINT16(pData[3], pData[4]);
+    uint16_t uuid;
+    uint8_t status;
+
+    handle = GATT_MIN_HANDLE + (handle - GATT_MIN_HANDLE) % lastHandle;
+    pAttr = SimBle_getAttr(handle, &pCBs);
+
+    if (pData[0] & FUZZ_REC_WRITE)
+    {
+        uint16_t len = MIN(pData[5], size - FUZZ_REC_HDR_LEN);
+        uint8_t *pValue;
+
+        if ((pAttr == NULL) || (pCBs->pfnWriteAttrCB == NULL) ||
+            !(pAttr->permissions & (GATT_PERMIT_WRITE |
+                                    GATT_PERMIT_ENCRYPT_WRITE |
+                                    GATT_PERMIT_AUTHEN_WRITE)))
+        {
+            return FUZZ_REC_HDR_LEN + len;
+        }
+
+        // Exactly the value, the sanitizers catch any access past it
+        pValue = malloc(len);
+        memcpy(pValue, &pData[FUZZ_REC_HDR_LEN], len);
+
+        pCBs->pfnWriteAttrCB(SIM_CONN_HANDLE, pAttr, pValue, len, offset,
+                             (pData[0] & FUZZ_REC_ALT) ? ATT_WRITE_CMD :
+                                                         ATT_WRITE_REQ);
+        free(pValue);
+
+        return FUZZ_REC_HDR_LEN + len;
+    }
+
+    uuid = pAttr ? Fuzz_uuid(pAttr) : 0;
+
+    // The stack reads the declarations and the CCCDs itself
+    if ((pAttr != NULL) && (pCBs->pfnReadAttrCB != NULL) &&
+        (uuid != GATT_PRIMARY_SERVICE_UUID) &&
+        (uuid != GATT_SECONDARY_SERVICE_UUID) &&
+        (uuid != GATT_INCLUDE_UUID) && (uuid != GATT_CHARACTER_UUID) &&
+        (uuid != GATT_CLIENT_CHAR_CFG_UUID) &&
+        (pAttr->permissions & (GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_READ |
+                               GATT_PERMIT_AUTHEN_READ)))
+    {
+        uint16_t maxLen = ATT_MTU_SIZE - 1 +
+                          pData[5] % (FUZZ_MAX_MTU - ATT_MTU_SIZE + 1);
+        uint8_t *pValue = malloc(maxLen);
+        uint16_t len = 0;
+
+        status = pCBs->pfnReadAttrCB(SIM_CONN_HANDLE, pAttr, pValue, &len,
+                                     offset, maxLen,
+                                     (pData[0] & FUZZ_REC_ALT) ?
+                                     ATT_READ_BLOB_REQ : ATT_READ_REQ);
+        free(pValue);
+
+        if ((status == SUCCESS) && (len > maxLen))
+        {
+            Fuzz_fail("read longer than the PDU", handle);
+        }
+    }
+
+    return FUZZ_REC_HDR_LEN;
+}
+
+/*********************************************************************
+ * @fn      LLVMFuzzerTestOneInput
+ *
+ * @brief   Run one input.
+ *
+ * @param   pData - input
+ * @param   size - length of the input
+ *
+ * @return  0
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *pData, size_t size)
+{
+    uint8_t numRecords = 0;
+
+    if (!initialized)
+    {
+        Fuzz_init();
+    }
+
+    while ((size >= FUZZ_REC_HDR_LEN) && (numRecords++ < FUZZ_MAX_RECORDS))
+    {
+        size_t len = Fuzz_record(pData, size);
+
+        pData += len;
+        size -= len;
+    }
+
+    Fuzz_settle();
+    Fuzz_check();
+
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+/*********************************************************************
+ * STANDALONE DRIVER
+ */
+
+// Inputs to run and mutate
+static uint8_t *corpus[FUZZ_MAX_CORPUS];
+static size_t corpusLen[FUZZ_MAX_CORPUS];
+static uint32_t corpusSize = 0;
+
+// Input being run, saved on a crash or a timeout
+static uint8_t curInput[FUZZ_MAX_INPUT];
+static size_t curLen = 0;
+
+static uint32_t randState = 1;
+
+/*********************************************************************
+ * @fn      Fuzz_rand
+ *
+ * @brief   xorshift32 random number.
+ */
+static uint32_t Fuzz_rand(void)
+{
+    randState ^= randState << 13;
+    randState ^= randState >> 17;
+    randState ^= randState << 5;
+
+    return randState;
+}
+
+/*********************************************************************
+ * @fn      Fuzz_saveInput
+ *
+ * @brief   Save the input being run to a file named after its hash.
+ *
+ * @param   pPrefix - file name prefix
+ *
+ * @return  none
+ */
+static void Fuzz_saveInput(const char *pPrefix)
+{
+    char name[64];
+    uint32_t hash = 2166136261u;
+    FILE *pFile;
+    size_t i;
+
+    for (i = 0; i < curLen; i++)
+    {
+        hash = (hash ^ curInput[i]) * 16777619u;
+    }
+
+    snprintf(name, sizeof(name), "%s-%08x", pPrefix, hash);
+    pFile = fopen(name, "wb");
+    if (pFile)
+    {
+        fwrite(curInput, 1, curLen, pFile);
+        fclose(pFile);
+        fprintf(stderr, "fuzz_attr: input saved to %s\n", name);
+    }
+}
+
+static void Fuzz_onDeath(void)
+{
+    Fuzz_saveInput("crash");
+}
+
+static void Fuzz_onSignal(int sig)
+{
+    if (sig == SIGALRM)
+    {
+        fprintf(stderr, "fuzz_attr: timeout\n");
+        Fuzz_saveInput("timeout");
+    }
+    else
+    {
+        Fuzz_saveInput("crash");
+    }
+
+    _exit(1);
+}
+
+/*********************************************************************
+ * @fn      Fuzz_run
+ *
+ * @brief   Run an input under the timeout.
+ *
+ * @param   pData - input
+ * @param   size - length of the input
+ *
+ * @return  none
+ */
+static void Fuzz_run(const uint8_t *pData, size_t size)
+{
+    curLen = MIN(size, FUZZ_MAX_INPUT);
+    memcpy(curInput, pData, curLen);
+
+    alarm(FUZZ_TIMEOUT_S);
+    LLVMFuzzerTestOneInput(curInput, curLen);
+    alarm(0);
+}
+
+/*********************************************************************
+ * @fn      Fuzz_addFile
+ *
+ * @brief   Add a file, or the files of a directory, to the corpus.
+ *
+ * @param   pPath - file or directory
+ *
+ * @return  none
+ */
+static void Fuzz_addFile(const char *pPath)
+{
+    struct stat st;
+    FILE *pFile;
+
+    if (stat(pPath, &st) != 0)
+    {
+        perror(pPath);
+        return;
+    }
+
+    if (S_ISDIR(st.st_mode))
+    {
+        DIR *pDir = opendir(pPath);
+        struct dirent *pEnt;
+        char path[512];
+
+        while (pDir && ((pEnt = readdir(pDir)) != NULL))
+        {
+            if (pEnt->d_name[0] != '.')
+            {
+                snprintf(path, sizeof(path), "%s/%s", pPath, pEnt->d_name);
+                Fuzz_addFile(path);
+            }
+        }
+
+        if (pDir)
+        {
+            closedir(pDir);
+        }
+
+        return;
+    }
+
+    if ((corpusSize == FUZZ_MAX_CORPUS) ||
+        ((pFile = fopen(pPath, "rb")) == NULL))
+    {
+        return;
+    }
+
+    corpus[corpusSize] = malloc(FUZZ_MAX_INPUT);
+    corpusLen[corpusSize] = fread(corpus[corpusSize], 1, FUZZ_MAX_INPUT,
+                                  pFile);
+    corpusSize++;
+    fclose(pFile);
+}
+
+/*********************************************************************
+ * @fn      Fuzz_mutate
+ *
+ * @brief   Mutate a copy of a corpus input into curInput.
+ *
+ * @return  Length of the mutated input
+ */
+static size_t Fuzz_mutate(uint8_t *pBuf)
+{
+    static const uint8_t interesting[] = { 0x00, 0x01, 0x02, 0x03, 0x04,
+                                           0x7F, 0x80, 0xFE, 0xFF };
+    size_t len = 0;
+    uint8_t n = 1 + Fuzz_rand() % 4;
+
+    if (corpusSize)
+    {
+        uint32_t i = Fuzz_rand() % corpusSize;
+
+        len = corpusLen[i];
+        memcpy(pBuf, corpus[i], len);
+    }
+
+    while (n--)
+    {
+        size_t pos = len ? Fuzz_rand() % len : 0;
+
+        switch (Fuzz_rand() % 6)
+        {
+            case 0:
+                if (len)
+                {
+                    pBuf[pos] ^= 1 << (Fuzz_rand() % 8);
+                }
+                break;
+
+            case 1:
+                if (len)
+                {
+                    pBuf[pos] = (uint8_t)Fuzz_rand();
+                }
+                break;
+
+            case 2:
+                if (len)
+                {
+                    pBuf[pos] = interesting[Fuzz_rand() % sizeof(interesting)];
+                }
+                break;
+
+            case 3:
+                if (len < FUZZ_MAX_INPUT)
+                {
+                    memmove(&pBuf[pos + 1], &pBuf[pos], len - pos);
+                    pBuf[pos] = (uint8_t)Fuzz_rand();
+                    len++;
+                }
+                break;
+
+            case 4:
+                if (len)
+                {
+                    memmove(&pBuf[pos], &pBuf[pos + 1], len - pos - 1);
+                    len--;
+                }
+                break;
+
+            default:
+                // Append a record of another input
+                if (corpusSize)
+                {
+                    uint32_t i = Fuzz_rand() % corpusSize;
+                    size_t add = MIN(corpusLen[i], FUZZ_MAX_INPUT - len);
+
+                    memcpy(&pBuf[len], corpus[i], add);
+                    len += add;
+                }
+                break;
+        }
+    }
+
+    return len;
+}
+
+/*********************************************************************
+ * @fn      Fuzz_writeSeed
+ *
+ * @brief   Write one seed input of a single record.
+ *
+ * @param   pDir - corpus directory
+ * @param   handle - attribute handle
+ * @param   uuid - attribute UUID, for the file name
+ * @param   flags - FUZZ_REC_* flags
+ * @param   offset - offset
+ * @param   pValue - value of a write, or NULL
+ * @param   len - value length, or MTU - 23 of a read
+ *
+ * @return  none
+ */
+static void Fuzz_writeSeed(const char *pDir, uint16_t handle, uint16_t uuid,
+                           uint8_t flags, uint16_t offset,
+                           const uint8_t *pValue, uint8_t len)
+{
+    static uint16_t seq = 0;
+    char path[512];
+    uint8_t hdr[FUZZ_REC_HDR_LEN] = { flags, LO_UINT16(handle),
+                                      HI_UINT16(handle), LO_UINT16(offset),
+                                      HI_UINT16(offset), len };
+    FILE *pFile;
+
+    snprintf(path, sizeof(path), "%s/%04x-%04x-%03u", pDir, handle, uuid,
+             seq++);
+    pFile = fopen(path, "wb");
+    if (pFile == NULL)
+    {
+        perror(path);
+        return;
+    }
+
+    fwrite(hdr, 1, sizeof(hdr), pFile);
+    if (pValue)
+    {
+        fwrite(pValue, 1, len, pFile);
+    }
+    fclose(pFile);
+}
+
+/*********************************************************************
+ * @fn      Fuzz_writeCorpus
+ *
+ * @brief   Write the seed corpus: a read of every readable attribute and
+ *          valid and invalid writes of every branch of the write
+ *          callbacks.
+ *
+ * @param   pDir - corpus directory
+ *
+ * @return  none
+ */
+static void Fuzz_writeCorpus(const char *pDir)
+{
+    static const uint8_t one[] = { 0x01 };
+    static const uint8_t two[] = { 0x02 };
+    static const uint8_t zero[] = { 0x00 };
+    static const uint8_t cccNotify[] = { 0x01, 0x00 };
+    static const uint8_t cccOff[] = { 0x00, 0x00 };
+    static const uint8_t cccIndicate[] = { 0x02, 0x00 };
+    static const uint8_t report[] = { 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+                                      0x00, 0x00 };
+    static const uint8_t scanValid[] = { 0x10, 0x00, 0x10, 0x00 };
+    static const uint8_t scanWide[] = { 0x10, 0x00, 0x20, 0x00 };
+    static const uint8_t scanZero[] = { 0x10, 0x00, 0x00, 0x00 };
+    static const uint8_t scanLong[] = { 0x01, 0x40, 0x04, 0x00 };
+    uint16_t handle;
+
+    mkdir(pDir, 0755);
+
+    for (handle = GATT_MIN_HANDLE; handle <= SimBle_getLastHandle(); handle++)
+    {
+        const gattServiceCBs_t *pCBs;
+        gattAttribute_t *pAttr = SimBle_getAttr(handle, &pCBs);
+        uint16_t uuid;
+
+        if (pAttr == NULL)
+        {
+            continue;
+        }
+
+        uuid = Fuzz_uuid(pAttr);
+
+        // Reads at the default MTU, blob reads
+        Fuzz_writeSeed(pDir, handle, uuid, 0, 0, NULL, 0);
+        Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_ALT, 1, NULL, 0);
+
+        switch (uuid)
+        {
+            case REPORT_MAP_UUID:
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_ALT,
+                               ATT_MTU_SIZE - 1, NULL, 0);
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_ALT,
+                               hidReportMapLen, NULL, 0);
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_ALT,
+                               hidReportMapLen + 1, NULL, 0xFF);
+                break;
+
+            case REPORT_UUID:
+            case BOOT_KEY_OUTPUT_UUID:
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 0, one,
+                               sizeof(one));
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, report,
+                               sizeof(report));
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 0, report,
+                               0);
+                break;
+
+            case HID_CTRL_PT_UUID:
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, zero,
+                               sizeof(zero));
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, one,
+                               sizeof(one));
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, two,
+                               sizeof(two));
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 0,
+                               cccNotify, sizeof(cccNotify));
+                break;
+
+            case PROTOCOL_MODE_UUID:
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, zero,
+                               sizeof(zero));
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, one,
+                               sizeof(one));
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, two,
+                               sizeof(two));
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 0,
+                               cccNotify, sizeof(cccNotify));
+                break;
+
+            case GATT_CLIENT_CHAR_CFG_UUID:
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 0,
+                               cccNotify, sizeof(cccNotify));
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 0,
+                               cccOff, sizeof(cccOff));
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 0,
+                               cccIndicate, sizeof(cccIndicate));
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 0, one,
+                               sizeof(one));
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 1,
+                               cccNotify, sizeof(cccNotify));
+                break;
+
+            case SCAN_INTERVAL_WINDOW_UUID:
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, scanValid,
+                               sizeof(scanValid));
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, scanWide,
+                               sizeof(scanWide));
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, scanZero,
+                               sizeof(scanZero));
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, scanLong,
+                               sizeof(scanLong));
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 0, scanValid,
+                               3);
+                Fuzz_writeSeed(pDir, handle, uuid,
+                               FUZZ_REC_WRITE | FUZZ_REC_ALT, 2, scanValid,
+                               sizeof(scanValid));
+                break;
+
+            default:
+                // Any other branch sees a plain write
+                Fuzz_writeSeed(pDir, handle, uuid, FUZZ_REC_WRITE, 0, one,
+                               sizeof(one));
+                break;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the corpus, then mutated inputs.
+ *
+ * @return  Zero on success
+ */
+int main(int argc, char *argv[])
+{
+    static uint8_t buf[FUZZ_MAX_INPUT];
+    uint32_t runs = 0;
+    uint32_t seconds = 0;
+    uint32_t minRate = 0;
+    uint64_t numExecs = 0;
+    struct timespec start, now;
+    double elapsed;
+    uint32_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:t:e:s:m:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r': runs = strtoul(optarg, NULL, 0); break;
+            case 't': seconds = strtoul(optarg, NULL, 0); break;
+            case 'e': minRate = strtoul(optarg, NULL, 0); break;
+            case 's': randState = strtoul(optarg, NULL, 0) | 1; break;
+            case 'm':
+                Fuzz_init();
+                Fuzz_writeCorpus(optarg);
+                return 0;
+            default:
+                fprintf(stderr, "usage: %s [-r runs] [-t seconds] [-e exec/s] "
+                        "[-s seed] [CORPUS...]\n       %s -m DIR\n", argv[0],
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    __sanitizer_set_death_callback(Fuzz_onDeath);
+    signal(SIGALRM, Fuzz_onSignal);
+    signal(SIGSEGV, Fuzz_onSignal);
+    signal(SIGABRT, Fuzz_onSignal);
+
+    for (; optind < argc; optind++)
+    {
+        Fuzz_addFile(argv[optind]);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0; i < corpusSize; i++)
+    {
+        Fuzz_run(corpus[i], corpusLen[i]);
+        numExecs++;
+    }
+
+    printf("fuzz_attr: %u corpus inputs passed\n", corpusSize);
+
+    for (;;)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = (now.tv_sec - start.tv_sec) +
+                  (now.tv_nsec - start.tv_nsec) / 1e9;
+
+        if (seconds ? (elapsed >= seconds) : (numExecs >= corpusSize + runs))
+        {
+            break;
+        }
+
+        Fuzz_run(buf, Fuzz_mutate(buf));
+        numExecs++;
+    }
+
+    printf("fuzz_attr: %llu executions in %.1f s, %.0f exec/s\n",
+           (unsigned long long)numExecs, elapsed,
+           elapsed > 0 ? numExecs / elapsed : 0.0);
+
+    if (minRate && (elapsed > 0) && (numExecs / elapsed < minRate))
+    {
+        printf("fuzz_attr: below the target of %u exec/s\n", minRate);
+        return 1;
+    }
+
+    return 0;
+}
+#endif // !FUZZ_LIBFUZZER
+
+/*********************************************************************
+*********************************************************************/
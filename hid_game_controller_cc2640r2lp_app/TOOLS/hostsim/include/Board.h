@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <Board.h>, see sim_io.h */
+#ifndef SIM_FWD_BOARD_H
+#define SIM_FWD_BOARD_H
+#include "sim_io.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <bcomdef.h>, see sim_stack.h */
+#ifndef SIM_FWD_BCOMDEF_H
+#define SIM_FWD_BCOMDEF_H
+#include "sim_stack.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for "ble_user_config.h", see sim_stack.h */
+#ifndef SIM_FWD_BLE_USER_CONFIG_H
+#define SIM_FWD_BLE_USER_CONFIG_H
+#include "sim_stack.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <comdef.h>, see sim_stack.h */
+#ifndef SIM_FWD_COMDEF_H
+#define SIM_FWD_COMDEF_H
+#include "sim_stack.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <devinfoservice.h>, see sim_stack.h */
+#ifndef SIM_FWD_DEVINFOSERVICE_H
+#define SIM_FWD_DEVINFOSERVICE_H
+#include "sim_stack.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <driverlib/aon_batmon.h>, see sim_io.h */
+#ifndef SIM_FWD_DRIVERLIB_AON_BATMON_H
+#define SIM_FWD_DRIVERLIB_AON_BATMON_H
+#include "sim_io.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <gap.h>, see sim_stack.h */
+#ifndef SIM_FWD_GAP_H
+#define SIM_FWD_GAP_H
+#include "sim_stack.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <gapgattserver.h>, see sim_stack.h */
+#ifndef SIM_FWD_GAPGATTSERVER_H
+#define SIM_FWD_GAPGATTSERVER_H
+#include "sim_stack.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <gatt.h>, see sim_stack.h */
+#ifndef SIM_FWD_GATT_H
+#define SIM_FWD_GATT_H
+#include "sim_stack.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <gattservapp.h>, see sim_stack.h */
+#ifndef SIM_FWD_GATTSERVAPP_H
+#define SIM_FWD_GATTSERVAPP_H
+#include "sim_stack.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <hci.h>, see sim_stack.h */
+#ifndef SIM_FWD_HCI_H
+#define SIM_FWD_HCI_H
+#include "sim_stack.h"
+#endif
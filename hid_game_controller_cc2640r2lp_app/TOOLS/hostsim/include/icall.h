@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <icall.h>, see sim_stack.h */
+#ifndef SIM_FWD_ICALL_H
+#define SIM_FWD_ICALL_H
+#include "sim_stack.h"
+#endif
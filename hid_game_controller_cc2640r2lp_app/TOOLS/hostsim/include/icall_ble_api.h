@@ -0,0 +1,8 @@
+/* Host simulation stand-in for "icall_ble_api.h", see sim_stack.h */
+#ifndef SIM_FWD_ICALL_BLE_API_H
+#define SIM_FWD_ICALL_BLE_API_H
+#include "sim_stack.h"
+#include "gatt_uuid.h"
+#include "gatt_profile_uuid.h"
+#include "gapbondmgr.h"
+#endif
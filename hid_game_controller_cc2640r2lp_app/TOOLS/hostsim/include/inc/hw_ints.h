@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <inc/hw_ints.h>, see sim_io.h */
+#ifndef SIM_FWD_INC_HW_INTS_H
+#define SIM_FWD_INC_HW_INTS_H
+#include "sim_io.h"
+#endif
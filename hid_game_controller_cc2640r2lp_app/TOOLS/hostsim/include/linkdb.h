@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <linkdb.h>, see sim_stack.h */
+#ifndef SIM_FWD_LINKDB_H
+#define SIM_FWD_LINKDB_H
+#include "sim_stack.h"
+#endif
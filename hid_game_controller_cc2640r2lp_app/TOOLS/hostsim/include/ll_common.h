@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <ll_common.h>, see sim_stack.h */
+#ifndef SIM_FWD_LL_COMMON_H
+#define SIM_FWD_LL_COMMON_H
+#include "sim_stack.h"
+#endif
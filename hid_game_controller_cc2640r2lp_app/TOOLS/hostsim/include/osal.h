@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <osal.h>, see sim_stack.h */
+#ifndef SIM_FWD_OSAL_H
+#define SIM_FWD_OSAL_H
+#include "sim_stack.h"
+#endif
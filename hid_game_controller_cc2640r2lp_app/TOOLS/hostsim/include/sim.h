@@ -0,0 +1,196 @@
+/******************************************************************************
+
+ @file       sim.h
+
+ @brief This file contains the control interface of the host simulation:
+        virtual time, the simulated peer (central) and the scripted inputs.
+        The scenario runner drives the application through it.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Linux host simulation build of the application and
+                        HID profile against a shim of the RTOS, the BLE stack
+                        and the drivers.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef SIM_H
+#define SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "sim_rtos.h"
+#include "sim_io.h"
+#include "sim_stack.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Clock ticks per millisecond
+#define SIM_TICKS_PER_MS                (1000 / Clock_tickPeriod)
+
+// Converts milliseconds to ticks
+#define SIM_MS(ms)                      ((uint64_t)(ms) * SIM_TICKS_PER_MS)
+
+// Connection interval unit in ticks (1.25 ms)
+#define SIM_CONN_INTERVAL_TICKS         125
+
+// Connection handle of the simulated link
+#define SIM_CONN_HANDLE                 0x0000
+
+// Default connection parameters of the simulated central: 30 ms interval,
+// no slave latency, 2 s supervision timeout
+#define SIM_DEFAULT_CONN_INTERVAL       24
+#define SIM_DEFAULT_CONN_LATENCY        0
+#define SIM_DEFAULT_CONN_TIMEOUT        200
+
+// Delays of the simulated central, in milliseconds
+#define SIM_PAIRING_TIME                100   // Pairing start to complete
+#define SIM_PARAM_UPDATE_TIME           50    // Update request to new params
+
+// Page of the simulated SNV
+#define SIM_SNV_PAGE_SIZE               4096
+
+// Log output classes
+#define SIM_LOG_EVENT                   0x01  // Link, pairing, script
+#define SIM_LOG_NOTI                    0x02  // Notifications and indications
+#define SIM_LOG_DISPLAY                 0x04  // Display output of the app
+#define SIM_LOG_PWM                     0x08  // PWM outputs, LEDs and buzzer
+#define SIM_LOG_LCD                     0x10  // LCD windows drawn
+#define SIM_LOG_DEFAULT                 (SIM_LOG_EVENT | SIM_LOG_NOTI)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Call scheduled in virtual time
+typedef void (*simCallFxn_t)(uintptr_t arg);
+
+// Sent notification, as seen by the central
+typedef struct
+{
+    uint64_t time;          // Tick of the GATT_Notification call
+    uint16_t handle;
+    uint16_t len;
+    const uint8_t *pValue;
+} simNoti_t;
+
+// Notification sink, returns SUCCESS when the notification is taken or
+// the status GATT_Notification returns. The default sink logs it.
+typedef uint8_t (*simNotiSink_t)(const simNoti_t *pNoti);
+
+// Notification tap, sees every notification the sink took
+typedef void (*simNotiTap_t)(const simNoti_t *pNoti);
+
+// Link observer, called on connection, parameter update and termination
+typedef void (*simLinkObserver_t)(bool connected, uint16_t interval,
+                                  uint16_t latency);
+
+// Counters of the connection timing model
+typedef struct
+{
+    uint32_t sent;          // Notifications taken into the TX buffers
+    uint32_t delivered;     // Notifications received by the central
+    uint32_t bufferFull;    // Notifications refused on full TX buffers
+    uint32_t dropped;       // Notifications in the TX buffers at disconnect
+    uint32_t retransmit;
+    uint32_t inputs;        // Inputs marked by SimConn_input
+    uint32_t reported;      // Inputs delivered by a report
+    uint32_t p50Us;         // Input to host latency percentiles
+    uint32_t p99Us;
+    uint32_t maxUs;
+    uint64_t radioOnUs;
+    uint64_t connectedUs;
+} simConnStats_t;
+
+// Counters of the simulated SNV
+typedef struct
+{
+    uint32_t writes;        // Items written completely
+    uint32_t bytes;         // Bytes programmed, with the item headers
+    uint32_t compactions;   // Page compactions, one erase each
+    uint32_t torn;          // Writes cut short by a power loss
+    uint16_t used;          // Bytes of the page in use
+} simSnvStats_t;
+
+/*********************************************************************
+ * VIRTUAL TIME (sim_rtos.c)
+ */
+
+// Log classes enabled, SIM_LOG_*
+extern uint8_t simLogMask;
+
+extern uint64_t SimRtos_now(void);
+extern void SimRtos_defer(uint64_t delay, simCallFxn_t fxn, uintptr_t arg);
+extern void SimRtos_run(uint64_t endTick);
+extern void SimRtos_log(uint8_t logClass, const char *fmt, ...);
+
+/*********************************************************************
+ * SIMULATED CENTRAL AND STACK (sim_ble.c)
+ */
+extern void SimBle_connect(uint16_t interval, uint16_t latency,
+                           uint16_t timeout);
+extern void SimBle_disconnect(void);
+extern void SimBle_pair(void);
+extern void SimBle_acceptParamUpdates(bool accept);
+extern void SimBle_setLink(int8_t rssi, uint16_t lossPermille);
+extern uint8_t SimBle_write(uint16_t handle, const uint8_t *pValue,
+                            uint16_t len);
+extern uint8_t SimBle_read(uint16_t handle, uint8_t *pValue, uint16_t *pLen);
+extern uint8_t SimBle_enableNotifications(void);
+extern void SimBle_dumpAttributes(void);
+extern void SimBle_setNotiSink(simNotiSink_t sink);
+extern void SimBle_setNotiTap(simNotiTap_t tap);
+extern void SimBle_setLinkObserver(simLinkObserver_t observer);
+extern uint16_t SimBle_getAttrUuid(uint16_t handle);
+extern gattAttribute_t *SimBle_getAttr(uint16_t handle,
+                                       const gattServiceCBs_t **ppCBs);
+extern uint16_t SimBle_getLastHandle(void);
+extern uint16_t SimBle_getLinkLoss(void);
+extern void SimBle_printStats(void);
+
+/*********************************************************************
+ * CONNECTION TIMING MODEL (sim_conn.c)
+ */
+extern void SimConn_enable(void);
+extern void SimConn_input(void);
+extern void SimConn_printStats(void);
+extern void SimConn_getStats(simConnStats_t *pStats);
+
+/*********************************************************************
+ * SCRIPTED INPUTS (sim_io.c)
+ */
+extern void SimIo_setKeys(uint8_t keys);
+extern void SimIo_setAdc(uint8_t channel, uint16_t value);
+extern void SimIo_setBattery(uint16_t mV);
+extern void SimIo_dumpLcd(uint16_t first, uint16_t last);
+extern void SimIo_printLcdStats(void);
+
+/*********************************************************************
+ * SIMULATED SNV (sim_snv.c)
+ */
+extern void SimSnv_erase(void);
+extern void SimSnv_cutAfter(uint32_t bytes);
+extern void SimSnv_powerUp(void);
+extern uint8_t SimSnv_corrupt(uint8_t id);
+extern void SimSnv_getStats(simSnvStats_t *pStats);
+extern void SimSnv_printStats(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H */
@@ -0,0 +1,305 @@
+/******************************************************************************
+
+ @file       sim_io.h
+
+ @brief This file contains the host simulation stand-ins for the PIN, ADC,
+        PWM and SPI drivers, the Display, the AON battery monitor and the
+        board definitions. Pin levels, ADC samples and the battery voltage
+        come from the scenario script, PWM output changes are logged and the
+        SPI bytes drive a model of the LCD controller.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Linux host simulation build of the application and
+                        HID profile against a shim of the RTOS, the BLE stack
+                        and the drivers.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef SIM_IO_H
+#define SIM_IO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "sim_rtos.h"
+
+/*********************************************************************
+ * PIN
+ */
+
+// Number of simulated IOs
+#define SIM_NUM_PINS                    32
+
+typedef uint8_t  PIN_Id;
+typedef uint32_t PIN_Config;
+
+typedef struct PIN_State_s
+{
+    void (*pCb)(struct PIN_State_s *hPin, PIN_Id pinId);
+} PIN_State;
+
+typedef PIN_State *PIN_Handle;
+typedef void (*PIN_IntCb)(PIN_Handle hPin, PIN_Id pinId);
+
+#define PIN_ID(x)                       ((x) & 0xFF)
+#define PIN_TERMINATE                   0xFE
+#define PIN_UNASSIGNED                  0xFF
+
+#define PIN_GPIO_OUTPUT_DIS             (0 << 8)
+#define PIN_GPIO_OUTPUT_EN              (1 << 8)
+#define PIN_GPIO_LOW                    (0 << 9)
+#define PIN_GPIO_HIGH                   (1 << 9)
+#define PIN_INPUT_EN                    (0 << 10)
+#define PIN_INPUT_DIS                   (1 << 10)
+#define PIN_NOPULL                      (0 << 11)
+#define PIN_PULLUP                      (1 << 11)
+#define PIN_PULLDOWN                    (2 << 11)
+#define PIN_PUSHPULL                    (0 << 13)
+#define PIN_DRVSTR_MIN                  (0 << 14)
+#define PIN_IRQ_DIS                     (0 << 16)
+#define PIN_IRQ_NEGEDGE                 (1 << 16)
+#define PIN_IRQ_POSEDGE                 (2 << 16)
+#define PIN_IRQ_BOTHEDGES               (3 << 16)
+
+#define PIN_BM_IRQ                      (3 << 16)
+
+#define PINCC26XX_NO_WAKEUP             (0 << 27)
+#define PINCC26XX_WAKEUP_NEGEDGE        (1 << 27)
+#define PINCC26XX_BM_WAKEUP             (3 << 27)
+
+extern PIN_Handle PIN_open(PIN_State *pState, const PIN_Config aPinList[]);
+extern int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb pCb);
+extern int PIN_setConfig(PIN_Handle handle, PIN_Config bmMask,
+                         PIN_Config pinCfg);
+extern uint32_t PIN_getInputValue(PIN_Id pinId);
+extern int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t val);
+
+/*********************************************************************
+ * ADC
+ */
+#define ADC_STATUS_SUCCESS              0
+#define ADC_STATUS_ERROR                (-1)
+
+typedef struct
+{
+    void *custom;
+    bool  isProtected;
+} ADC_Params;
+
+typedef struct ADC_Config_s *ADC_Handle;
+
+extern void ADC_init(void);
+extern void ADC_Params_init(ADC_Params *pParams);
+extern ADC_Handle ADC_open(uint_least8_t index, ADC_Params *pParams);
+extern void ADC_close(ADC_Handle handle);
+extern int_fast16_t ADC_convert(ADC_Handle handle, uint16_t *pValue);
+
+/*********************************************************************
+ * PWM
+ */
+#define PWM_STATUS_SUCCESS              0
+#define PWM_STATUS_ERROR                (-1)
+
+#define PWM_DUTY_FRACTION_MAX           0xFFFFFFFFu
+
+typedef enum
+{
+    PWM_IDLE_LOW = 0,
+    PWM_IDLE_HIGH = 1
+} PWM_IdleLevel;
+
+typedef enum
+{
+    PWM_PERIOD_US,
+    PWM_PERIOD_HZ,
+    PWM_PERIOD_COUNTS
+} PWM_Period_Units;
+
+typedef enum
+{
+    PWM_DUTY_US,
+    PWM_DUTY_FRACTION,
+    PWM_DUTY_COUNTS
+} PWM_Duty_Units;
+
+typedef struct
+{
+    PWM_Period_Units periodUnits;
+    uint32_t         periodValue;
+    PWM_Duty_Units   dutyUnits;
+    uint32_t         dutyValue;
+    PWM_IdleLevel    idleLevel;
+    void            *custom;
+} PWM_Params;
+
+typedef struct PWM_Config_s *PWM_Handle;
+
+extern void PWM_init(void);
+extern void PWM_Params_init(PWM_Params *pParams);
+extern PWM_Handle PWM_open(uint_least8_t index, PWM_Params *pParams);
+extern void PWM_close(PWM_Handle handle);
+extern int_fast16_t PWM_setDuty(PWM_Handle handle, uint32_t duty);
+extern int_fast16_t PWM_setPeriod(PWM_Handle handle, uint32_t period);
+extern void PWM_start(PWM_Handle handle);
+extern void PWM_stop(PWM_Handle handle);
+
+/*********************************************************************
+ * SPI
+ */
+typedef enum
+{
+    SPI_TRANSFER_COMPLETED = 0,
+    SPI_TRANSFER_STARTED,
+    SPI_TRANSFER_QUEUED,
+    SPI_TRANSFER_FAILED,
+    SPI_TRANSFER_CANCELED
+} SPI_Status;
+
+typedef enum
+{
+    SPI_MODE_BLOCKING,
+    SPI_MODE_CALLBACK
+} SPI_TransferMode;
+
+typedef enum
+{
+    SPI_MASTER = 0,
+    SPI_SLAVE = 1
+} SPI_Mode;
+
+typedef enum
+{
+    SPI_POL0_PHA0 = 0,
+    SPI_POL0_PHA1 = 1,
+    SPI_POL1_PHA0 = 2,
+    SPI_POL1_PHA1 = 3
+} SPI_FrameFormat;
+
+#define SPI_WAIT_FOREVER                (~(0U))
+
+typedef struct
+{
+    size_t      count;
+    void       *txBuf;
+    void       *rxBuf;
+    void       *arg;
+    SPI_Status  status;
+} SPI_Transaction;
+
+typedef struct SPI_Config_s *SPI_Handle;
+typedef void (*SPI_CallbackFxn)(SPI_Handle handle,
+                                SPI_Transaction *transaction);
+
+typedef struct
+{
+    SPI_TransferMode transferMode;
+    uint32_t         transferTimeout;
+    SPI_CallbackFxn  transferCallbackFxn;
+    SPI_Mode         mode;
+    uint32_t         bitRate;
+    uint32_t         dataSize;
+    SPI_FrameFormat  frameFormat;
+    void            *custom;
+} SPI_Params;
+
+extern void SPI_init(void);
+extern void SPI_Params_init(SPI_Params *pParams);
+extern SPI_Handle SPI_open(uint_least8_t index, SPI_Params *pParams);
+extern void SPI_close(SPI_Handle handle);
+extern bool SPI_transfer(SPI_Handle handle, SPI_Transaction *transaction);
+extern void SPI_transferCancel(SPI_Handle handle);
+
+/*********************************************************************
+ * AON BATTERY MONITOR
+ */
+
+// Battery voltage, integer part in bits 10:8, fraction in bits 7:0
+extern uint32_t AONBatMonBatteryVoltageGet(void);
+extern bool AONBatMonNewBatteryMeasureReady(void);
+
+/*********************************************************************
+ * DISPLAY
+ */
+typedef struct Display_Config_s *Display_Handle;
+
+extern void SimIo_display(const char *fmt, ...);
+
+#ifdef Display_DISABLE_ALL
+#define Display_print0(h, l, c, fmt)
+#define Display_print1(h, l, c, fmt, a0)
+#define Display_print2(h, l, c, fmt, a0, a1)
+#define Display_print3(h, l, c, fmt, a0, a1, a2)
+#define Display_print4(h, l, c, fmt, a0, a1, a2, a3)
+#define Display_print5(h, l, c, fmt, a0, a1, a2, a3, a4)
+#define Display_printf(h, l, c, ...)
+#else
+#define Display_print0(h, l, c, fmt)   SimIo_display(fmt)
+#define Display_print1(h, l, c, fmt, a0) \
+    SimIo_display(fmt, a0)
+#define Display_print2(h, l, c, fmt, a0, a1) \
+    SimIo_display(fmt, a0, a1)
+#define Display_print3(h, l, c, fmt, a0, a1, a2) \
+    SimIo_display(fmt, a0, a1, a2)
+#define Display_print4(h, l, c, fmt, a0, a1, a2, a3) \
+    SimIo_display(fmt, a0, a1, a2, a3)
+#define Display_print5(h, l, c, fmt, a0, a1, a2, a3, a4) \
+    SimIo_display(fmt, a0, a1, a2, a3, a4)
+#define Display_printf(h, l, c, ...)   SimIo_display(__VA_ARGS__)
+#endif // Display_DISABLE_ALL
+
+/*********************************************************************
+ * BOARD
+ */
+
+// IOs of the LaunchPad buttons and the BoosterPack MKII buttons
+#define Board_BTN1                      13
+#define Board_BTN2                      14
+#define EDUBP_MKII_BTN1                 15
+#define EDUBP_MKII_BTN2                 16
+#define Board_SPI_FLASH_CS              20
+
+// ADC channels of the BoosterPack MKII joystick
+#define Board_ADC0                      0
+#define Board_ADC5                      5
+#define SIM_NUM_ADC                     8
+
+// ADC channels of the BoosterPack MKII accelerometer
+#define EDUBP_MKII_ACCEL_X_ADC          2
+#define EDUBP_MKII_ACCEL_Y_ADC          3
+#define EDUBP_MKII_ACCEL_Z_ADC          4
+
+// PWM outputs of the BoosterPack MKII RGB LED
+#define EDUBP_MKII_RLED_PWM             0
+#define EDUBP_MKII_GLED_PWM             1
+#define EDUBP_MKII_BLED_PWM             2
+
+// PWM output of the BoosterPack MKII buzzer
+#define EDUBP_MKII_BUZZER_PWM           3
+#define SIM_NUM_PWM                     8
+
+// SPI and pins of the BoosterPack MKII LCD
+#define EDUBP_MKII_LCD_SPI              0
+#define EDUBP_MKII_LCD_CS               Board_SPI_FLASH_CS
+#define EDUBP_MKII_LCD_RST              1
+#define EDUBP_MKII_LCD_DC               17
+#define SIM_NUM_SPI                     2
+
+#define Board_shutDownExtFlash()
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_IO_H */
@@ -0,0 +1,273 @@
+/******************************************************************************
+
+ @file       sim_rtos.h
+
+ @brief This file contains the host simulation stand-ins for the XDC runtime
+        and TI-RTOS kernel modules used by the application: Clock, Event,
+        Queue, Task, Hwi, Timestamp and Memory. Time is virtual, it only
+        advances while every task pends.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Linux host simulation build of the application and
+                        HID profile against a shim of the RTOS, the BLE stack
+                        and the drivers.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef SIM_RTOS_H
+#define SIM_RTOS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*********************************************************************
+ * XDC TYPES
+ */
+typedef uintptr_t       UArg;
+typedef int             Int;
+typedef unsigned int    UInt;
+typedef uint8_t         UInt8;
+typedef uint16_t        UInt16;
+typedef uint32_t        UInt32;
+typedef int32_t         Int32;
+typedef char            Char;
+typedef bool            Bool;
+typedef uint32_t        Bits32;
+typedef void            Void;
+typedef void           *Ptr;
+typedef const char     *String;
+
+#ifndef TRUE
+#define TRUE            1
+#endif
+#ifndef FALSE
+#define FALSE           0
+#endif
+
+typedef struct
+{
+    Bits32 hi;
+    Bits32 lo;
+} Types_FreqHz;
+
+typedef struct Error_Block
+{
+    int unused;
+} Error_Block;
+
+#define Error_init(eb)
+#define System_printf(...)
+#define System_flush()
+
+/*********************************************************************
+ * BIOS
+ */
+#define BIOS_WAIT_FOREVER       (~(UInt32)0)
+#define BIOS_NO_WAIT            0
+
+/*********************************************************************
+ * CLOCK
+ */
+
+// Clock tick period in microseconds, as in the application configuration
+#define Clock_tickPeriod        10
+
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+typedef struct
+{
+    UArg   arg;
+    UInt32 period;
+    Bool   startFlag;
+} Clock_Params;
+
+typedef struct Clock_Struct
+{
+    struct Clock_Struct *next;   // List of all constructed clocks
+    Clock_FuncPtr fxn;
+    UArg     arg;
+    UInt32   timeout;            // Ticks from start to the first expiry
+    UInt32   period;             // Ticks between expiries, 0 for one-shot
+    uint64_t expiry;             // Absolute tick of the next expiry
+    Bool     active;
+} Clock_Struct;
+
+typedef Clock_Struct *Clock_Handle;
+
+extern void Clock_Params_init(Clock_Params *pParams);
+extern void Clock_construct(Clock_Struct *pClock, Clock_FuncPtr fxn,
+                            UInt timeout, const Clock_Params *pParams);
+extern void Clock_start(Clock_Handle handle);
+extern void Clock_stop(Clock_Handle handle);
+extern Bool Clock_isActive(Clock_Handle handle);
+extern void Clock_setTimeout(Clock_Handle handle, UInt32 timeout);
+extern void Clock_setPeriod(Clock_Handle handle, UInt32 period);
+extern UInt32 Clock_getTicks(void);
+
+#define Clock_handle(pClock)    ((Clock_Handle)(pClock))
+
+/*********************************************************************
+ * EVENT
+ */
+#define Event_Id_NONE           0
+#define Event_Id_00             (1u << 0)
+#define Event_Id_01             (1u << 1)
+#define Event_Id_02             (1u << 2)
+#define Event_Id_03             (1u << 3)
+#define Event_Id_04             (1u << 4)
+#define Event_Id_05             (1u << 5)
+#define Event_Id_06             (1u << 6)
+#define Event_Id_07             (1u << 7)
+#define Event_Id_08             (1u << 8)
+#define Event_Id_09             (1u << 9)
+#define Event_Id_10             (1u << 10)
+#define Event_Id_11             (1u << 11)
+#define Event_Id_12             (1u << 12)
+#define Event_Id_13             (1u << 13)
+#define Event_Id_14             (1u << 14)
+#define Event_Id_15             (1u << 15)
+#define Event_Id_29             (1u << 29)
+#define Event_Id_30             (1u << 30)
+#define Event_Id_31             (1u << 31)
+
+typedef struct Event_Struct
+{
+    UInt posted;
+} Event_Struct;
+
+typedef Event_Struct *Event_Handle;
+
+extern void Event_post(Event_Handle handle, UInt eventMask);
+extern UInt Event_pend(Event_Handle handle, UInt andMask, UInt orMask,
+                       UInt32 timeout);
+
+#define Event_handle(pEvent)    ((Event_Handle)(pEvent))
+
+/*********************************************************************
+ * QUEUE
+ */
+typedef struct Queue_Elem
+{
+    struct Queue_Elem *next;
+    struct Queue_Elem *prev;
+} Queue_Elem;
+
+typedef struct
+{
+    int unused;
+} Queue_Params;
+
+typedef Queue_Elem Queue_Struct;
+typedef Queue_Elem *Queue_Handle;
+
+extern void Queue_construct(Queue_Struct *pQueue, const Queue_Params *pParams);
+extern Bool Queue_empty(Queue_Handle handle);
+extern Ptr Queue_get(Queue_Handle handle);
+extern void Queue_put(Queue_Handle handle, Queue_Elem *pElem);
+
+#define Queue_handle(pQueue)    ((Queue_Handle)(pQueue))
+
+/*********************************************************************
+ * TASK
+ */
+typedef void (*Task_FuncPtr)(UArg a0, UArg a1);
+
+typedef struct
+{
+    UArg   arg0;
+    UArg   arg1;
+    Int    priority;
+    Ptr    stack;
+    size_t stackSize;
+} Task_Params;
+
+typedef struct Task_Struct
+{
+    struct Task_Struct *next;   // Constructed tasks, highest priority first
+    Task_FuncPtr fxn;
+    UArg   arg0;
+    UArg   arg1;
+    Int    priority;
+    size_t stackSize;
+    void   *pContext;           // Host context, see sim_rtos.c
+    uint8_t state;
+    Event_Struct *pPend;        // Event pended on, and its mask and deadline
+    UInt   pendMask;
+    uint64_t deadline;
+} Task_Struct;
+
+typedef Task_Struct *Task_Handle;
+
+typedef struct
+{
+    Int    priority;
+    size_t stackSize;
+    size_t used;
+} Task_Stat;
+
+extern void Task_Params_init(Task_Params *pParams);
+extern void Task_construct(Task_Struct *pTask, Task_FuncPtr fxn,
+                           const Task_Params *pParams, Error_Block *eb);
+extern void Task_stat(Task_Handle handle, Task_Stat *pStat);
+extern Task_Handle Task_self(void);
+
+#define Task_handle(pTask)      ((Task_Handle)(pTask))
+
+/*********************************************************************
+ * HWI
+ */
+typedef struct
+{
+    int unused;
+} Hwi_Struct;
+
+typedef struct
+{
+    size_t hwiStackPeak;
+    size_t hwiStackSize;
+    Ptr    hwiStackBase;
+} Hwi_StackInfo;
+
+extern UInt Hwi_disable(void);
+extern void Hwi_restore(UInt key);
+extern Bool Hwi_getStackInfo(Hwi_StackInfo *pStkInfo, Bool computeStackDepth);
+
+/*********************************************************************
+ * TIMESTAMP
+ */
+extern Bits32 Timestamp_get32(void);
+extern void Timestamp_getFreq(Types_FreqHz *pFreq);
+
+/*********************************************************************
+ * MEMORY
+ */
+typedef struct
+{
+    size_t totalSize;
+    size_t totalFreeSize;
+    size_t largestFreeSize;
+} Memory_Stats;
+
+extern void Memory_getStats(Ptr heap, Memory_Stats *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_RTOS_H */
@@ -0,0 +1,479 @@
+/******************************************************************************
+
+ @file       sim_stack.h
+
+ @brief This file contains the host simulation stand-ins for the BLE stack
+        API used by the application and the profiles: common types, ICall,
+        HCI, GAP, GATT, the GATT Server App and the GAP GATT Server. Values
+        match the CC2640R2 SDK 1.50 headers.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Linux host simulation build of the application and
+                        HID profile against a shim of the RTOS, the BLE stack
+                        and the drivers.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef SIM_STACK_H
+#define SIM_STACK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "sim_rtos.h"
+
+/*********************************************************************
+ * COMMON TYPES (comdef.h, bcomdef.h)
+ */
+typedef int8_t    int8;
+typedef uint8_t   uint8;
+typedef int16_t   int16;
+typedef uint16_t  uint16;
+typedef int32_t   int32;
+typedef uint32_t  uint32;
+typedef uint8_t   halIntState_t;
+typedef uint8_t   Status_t;
+typedef Status_t  bStatus_t;
+
+#define CONST                           const
+#define VOID                            (void)
+
+// Pointer sized integer, used to store table pointers in attribute values
+#define PTR_TYPE                        uintptr_t *
+
+#define BV(n)                           (1 << (n))
+#define LO_UINT16(a)                    ((uint8)((a) & 0xFF))
+#define HI_UINT16(a)                    ((uint8)(((a) >> 8) & 0xFF))
+#define BUILD_UINT16(loByte, hiByte) \
+    ((uint16)(((loByte) & 0x00FF) + (((hiByte) & 0x00FF) << 8)))
+#define BUILD_UINT32(b0, b1, b2, b3) \
+    ((uint32)((uint32)((b0) & 0xFF) + ((uint32)((b1) & 0xFF) << 8) + \
+              ((uint32)((b2) & 0xFF) << 16) + ((uint32)((b3) & 0xFF) << 24)))
+#define BREAK_UINT32(var, ByteNum) \
+    (uint8)((uint32)(((var) >> ((ByteNum) * 8)) & 0x00FF))
+
+#ifndef MIN
+#define MIN(n, m)                       (((n) < (m)) ? (n) : (m))
+#endif
+#ifndef MAX
+#define MAX(n, m)                       (((n) < (m)) ? (m) : (n))
+#endif
+
+// Generic status
+#define SUCCESS                         0x00
+#define FAILURE                         0x01
+#define INVALIDPARAMETER                0x02
+#define INVALID_TASK                    0x03
+#define MSG_BUFFER_NOT_AVAIL            0x04
+#define INVALID_MSG_POINTER             0x05
+#define INVALID_EVENT_ID                0x06
+#define INVALID_INTERRUPT_ID            0x07
+#define NO_TIMER_AVAIL                  0x08
+#define NV_ITEM_UNINIT                  0x09
+#define NV_OPER_FAILED                  0x0A
+#define INVALID_MEM_SIZE                0x0B
+#define NV_BAD_ITEM_LEN                 0x0C
+
+// BLE status
+#define bleNotReady                     0x10
+#define bleAlreadyInRequestedMode       0x11
+#define bleIncorrectMode                0x12
+#define bleMemAllocError                0x13
+#define bleNotConnected                 0x14
+#define bleNoResources                  0x15
+#define blePending                      0x16
+#define bleTimeout                      0x17
+#define bleInvalidRange                 0x18
+#define bleLinkEncrypted                0x19
+#define bleProcedureComplete            0x1A
+#define bleInvalidMtuSize               0x1B
+
+#define B_ADDR_LEN                      6
+#define KEYLEN                          16
+#define B_APP_DEFAULT_PASSCODE          123456
+#define INVALID_CONNHANDLE              0xFFFF
+#define LINKDB_STATUS_UPDATE_NEW        0
+#define MAX_NUM_BLE_CONNS               1
+
+/*********************************************************************
+ * OSAL
+ */
+typedef struct
+{
+    uint8 event;
+    uint8 status;
+} osal_event_hdr_t;
+
+#define osal_memcpy                     memcpy
+#define osal_memset                     memset
+#define osal_memcmp(a, b, n)            (memcmp((a), (b), (n)) == 0)
+
+/*********************************************************************
+ * OSAL SNV (sim_snv.c)
+ */
+typedef uint8 osalSnv_t;
+
+// Item IDs of the application
+#define BLE_NVID_CUST_START             0x80
+#define BLE_NVID_CUST_END               0x8F
+
+extern uint8 osal_snv_read(osalSnv_t id, osalSnv_t len, void *pBuf);
+extern uint8 osal_snv_write(osalSnv_t id, osalSnv_t len, void *pBuf);
+
+/*********************************************************************
+ * ICALL
+ */
+typedef uint8_t      ICall_EntityID;
+typedef Event_Handle ICall_SyncHandle;
+typedef uint16_t     ICall_ServiceEnum;
+typedef int_fast16_t ICall_Errno;
+
+typedef osal_event_hdr_t ICall_Hdr;
+
+typedef struct
+{
+    ICall_Hdr hdr;
+} ICall_HciExtEvt;
+
+#define ICALL_SERVICE_CLASS_BLE         0x0018
+#define ICALL_ERRNO_SUCCESS             0
+#define ICALL_ERRNO_NOMSG               (-4)
+#define ICALL_MSG_EVENT_ID              Event_Id_31
+#define ICALL_TIMEOUT_FOREVER           BIOS_WAIT_FOREVER
+
+extern ICall_Errno ICall_registerApp(ICall_EntityID *pEntity,
+                                     ICall_SyncHandle *pMsgSyncHdl);
+extern ICall_Errno ICall_fetchServiceMsg(ICall_ServiceEnum *pSrc,
+                                         ICall_EntityID *pDest, void **pMsg);
+extern void *ICall_malloc(uint_least16_t size);
+extern void ICall_free(void *pMsg);
+extern void ICall_freeMsg(void *pMsg);
+
+/*********************************************************************
+ * HCI AND LINK LAYER
+ */
+#define HCI_GAP_EVENT_EVENT             0x03
+#define HCI_COMMAND_COMPLETE_EVENT_CODE 0x0E
+#define HCI_VE_EVENT_CODE               0xFF
+
+#define HCI_READ_RSSI                   0x1405
+#define HCI_LE_READ_LOCAL_SUPPORTED_FEATURES 0x2003
+#define HCI_EXT_PER                     0xFC14
+
+#define HCI_EXT_PER_RESET               0
+#define HCI_EXT_PER_READ                1
+
+#define HCI_EXT_TX_POWER_MINUS_21_DBM   0
+#define HCI_EXT_TX_POWER_MINUS_18_DBM   1
+#define HCI_EXT_TX_POWER_MINUS_15_DBM   2
+#define HCI_EXT_TX_POWER_MINUS_12_DBM   3
+#define HCI_EXT_TX_POWER_MINUS_9_DBM    4
+#define HCI_EXT_TX_POWER_MINUS_6_DBM    5
+#define HCI_EXT_TX_POWER_MINUS_3_DBM    6
+#define HCI_EXT_TX_POWER_0_DBM          7
+#define HCI_EXT_TX_POWER_1_DBM          8
+#define HCI_EXT_TX_POWER_2_DBM          9
+#define HCI_EXT_TX_POWER_3_DBM          10
+#define HCI_EXT_TX_POWER_4_DBM          11
+#define HCI_EXT_TX_POWER_5_DBM          12
+
+#define LL_FEATURE_CONN_PARAMS_REQ      0x02
+#define LL_MIN_LINK_DATA_LEN            27
+#define LL_MIN_LINK_DATA_TIME           328
+
+#define CLR_FEATURE_FLAG(var, feature)  ((var) &= ~(feature))
+
+typedef struct
+{
+    osal_event_hdr_t hdr;
+    uint8  numHciCmdPkt;
+    uint16 cmdOpcode;
+    uint8 *pReturnParam;
+} hciEvt_CmdComplete_t;
+
+typedef struct
+{
+    osal_event_hdr_t hdr;
+    uint8  length;
+    uint16 cmdOpcode;
+    uint8 *pEventParam;
+} hciEvt_VSCmdComplete_t;
+
+extern uint8 HCI_ReadRssiCmd(uint16 connHandle);
+extern uint8 HCI_LE_ReadLocalSupportedFeaturesCmd(void);
+extern uint8 HCI_EXT_PacketErrorRateCmd(uint16 connHandle, uint8 command);
+extern uint8 HCI_EXT_SetTxPowerCmd(uint8 txPower);
+extern uint8 HCI_EXT_SetLocalSupportedFeaturesCmd(uint8 *pLocalFeatures);
+extern uint8 HCI_EXT_SetMaxDataLenCmd(uint16 txOctets, uint16 txTime,
+                                      uint16 rxOctets, uint16 rxTime);
+
+/*********************************************************************
+ * GAP
+ */
+#define GAP_MSG_EVENT                   0xD0
+
+typedef struct
+{
+    osal_event_hdr_t hdr;
+    uint8 opcode;
+} gapEventHdr_t;
+
+#define GAP_DEVICE_NAME_LEN             (20 + 1)
+
+#define GAP_ADTYPE_FLAGS                0x01
+#define GAP_ADTYPE_16BIT_MORE           0x02
+#define GAP_ADTYPE_LOCAL_NAME_COMPLETE  0x09
+#define GAP_ADTYPE_APPEARANCE           0x19
+#define GAP_ADTYPE_FLAGS_LIMITED        0x01
+#define GAP_ADTYPE_FLAGS_GENERAL        0x02
+#define GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED 0x04
+
+#define GAP_APPEARE_HID_KEYBOARD        0x03C1
+#define GAP_APPEARE_HID_MOUSE           0x03C2
+#define GAP_APPEARE_HID_GAMEPAD         0x03C4
+
+#define GAP_FILTER_POLICY_ALL           0x00
+#define GAP_FILTER_POLICY_WHITE         0x03
+
+#define TGAP_LIM_ADV_TIMEOUT            1
+#define TGAP_LIM_DISC_ADV_INT_MIN       6
+#define TGAP_LIM_DISC_ADV_INT_MAX       7
+#define TGAP_CONN_PAUSE_PERIPHERAL      35
+
+#define GGS_DEVICE_NAME_ATT             0
+#define GAP_SERVICE_UUID                0x1800
+
+extern bStatus_t GAP_SetParamValue(uint16 paramID, uint16 paramValue);
+extern void GAP_RegisterForMsgs(uint8 taskID);
+
+extern bStatus_t GGS_SetParameter(uint8 param, uint8 len, void *value);
+extern bStatus_t GGS_AddService(uint32 services);
+
+// Security Manager pairing failure reasons
+#define SMP_PAIRING_FAILED_PASSKEY_ENTRY_FAILED 0x01
+#define SMP_PAIRING_FAILED_CONFIRM_VALUE        0x04
+#define SMP_PAIRING_FAILED_UNSPECIFIED          0x08
+
+/*********************************************************************
+ * ATT AND GATT
+ */
+#define ATT_BT_UUID_SIZE                2
+#define ATT_UUID_SIZE                   16
+
+#define ATT_READ_REQ                    0x0A
+#define ATT_READ_BLOB_REQ               0x0C
+#define ATT_WRITE_REQ                   0x12
+#define ATT_WRITE_CMD                   0x52
+#define ATT_HANDLE_VALUE_NOTI           0x1B
+#define ATT_HANDLE_VALUE_IND            0x1D
+
+#define ATT_ERR_INVALID_HANDLE          0x01
+#define ATT_ERR_READ_NOT_PERMITTED      0x02
+#define ATT_ERR_WRITE_NOT_PERMITTED     0x03
+#define ATT_ERR_INVALID_PDU             0x04
+#define ATT_ERR_INSUFFICIENT_AUTHEN     0x05
+#define ATT_ERR_UNSUPPORTED_REQ         0x06
+#define ATT_ERR_INVALID_OFFSET          0x07
+#define ATT_ERR_INSUFFICIENT_AUTHOR     0x08
+#define ATT_ERR_PREPARE_QUEUE_FULL      0x09
+#define ATT_ERR_ATTR_NOT_FOUND          0x0A
+#define ATT_ERR_ATTR_NOT_LONG           0x0B
+#define ATT_ERR_INSUFFICIENT_KEY_SIZE   0x0C
+#define ATT_ERR_INVALID_VALUE_SIZE      0x0D
+#define ATT_ERR_UNLIKELY                0x0E
+#define ATT_ERR_INSUFFICIENT_ENCRYPT    0x0F
+#define ATT_ERR_UNSUPPORTED_GRP_TYPE    0x10
+#define ATT_ERR_INSUFFICIENT_RESOURCES  0x11
+#define ATT_ERR_INVALID_VALUE           0x80
+
+// Default ATT MTU, notifications carry up to ATT_MTU_SIZE - 3 bytes
+#define ATT_MTU_SIZE                    23
+
+#define GATT_MSG_EVENT                  0xB0
+
+#define GATT_PERMIT_READ                0x01
+#define GATT_PERMIT_WRITE               0x02
+#define GATT_PERMIT_AUTHEN_READ         0x04
+#define GATT_PERMIT_AUTHEN_WRITE        0x08
+#define GATT_PERMIT_AUTHOR_READ         0x10
+#define GATT_PERMIT_AUTHOR_WRITE        0x20
+#define GATT_PERMIT_ENCRYPT_READ        0x40
+#define GATT_PERMIT_ENCRYPT_WRITE       0x80
+
+#define GATT_PROP_BCAST                 0x01
+#define GATT_PROP_READ                  0x02
+#define GATT_PROP_WRITE_NO_RSP          0x04
+#define GATT_PROP_WRITE                 0x08
+#define GATT_PROP_NOTIFY                0x10
+#define GATT_PROP_INDICATE              0x20
+#define GATT_PROP_AUTHEN                0x40
+#define GATT_PROP_EXTENDED              0x80
+
+#define GATT_CFG_NO_OPERATION           0x0000
+#define GATT_CLIENT_CFG_NOTIFY          0x0001
+#define GATT_CLIENT_CFG_INDICATE        0x0002
+
+#define GATT_INVALID_HANDLE             0x0000
+#define GATT_MIN_HANDLE                 0x0001
+#define GATT_MAX_HANDLE                 0xFFFF
+#define GATT_MAX_MTU                    0xFFFF
+#define GATT_MAX_ENCRYPT_KEY_SIZE       16
+#define GATT_LOCAL_READ                 0xFF
+#define GATT_ALL_SERVICES               0xFFFFFFFF
+
+typedef struct
+{
+    uint8 len;
+    const uint8 *uuid;
+} gattAttrType_t;
+
+typedef struct attAttribute_t
+{
+    gattAttrType_t type;
+    uint8  permissions;
+    uint16 handle;
+    uint8 *pValue;
+} gattAttribute_t;
+
+typedef struct
+{
+    uint16 connHandle;
+    uint8  value;
+} gattCharCfg_t;
+
+// Characteristic Presentation Format
+#define GATT_FORMAT_BOOL                0x01
+#define GATT_FORMAT_UINT8               0x04
+#define GATT_FORMAT_UINT16              0x06
+#define GATT_NS_BT_SIG                  0x01
+
+typedef struct
+{
+    uint8  format;
+    int8   exponent;
+    uint16 unit;
+    uint8  nameSpace;
+    uint16 desc;
+} gattCharFormat_t;
+
+typedef struct
+{
+    uint16 handle;
+    uint16 len;
+    uint8 *pValue;
+} attHandleValueNoti_t;
+
+typedef attHandleValueNoti_t attHandleValueInd_t;
+
+typedef union
+{
+    attHandleValueNoti_t handleValueNoti;
+    attHandleValueInd_t  handleValueInd;
+} gattMsg_t;
+
+typedef struct
+{
+    osal_event_hdr_t hdr;
+    uint16 connHandle;
+    uint8  method;
+    gattMsg_t msg;
+} gattMsgEvent_t;
+
+typedef bStatus_t (*pfnGATTReadAttrCB_t)(uint16 connHandle,
+                                         gattAttribute_t *pAttr,
+                                         uint8 *pValue, uint16 *pLen,
+                                         uint16 offset, uint16 maxLen,
+                                         uint8 method);
+typedef bStatus_t (*pfnGATTWriteAttrCB_t)(uint16 connHandle,
+                                          gattAttribute_t *pAttr,
+                                          uint8 *pValue, uint16 len,
+                                          uint16 offset, uint8 method);
+typedef bStatus_t (*pfnGATTAuthorizeAttrCB_t)(uint16 connHandle,
+                                              gattAttribute_t *pAttr,
+                                              uint8 opcode);
+
+typedef struct
+{
+    pfnGATTReadAttrCB_t pfnReadAttrCB;
+    pfnGATTWriteAttrCB_t pfnWriteAttrCB;
+    pfnGATTAuthorizeAttrCB_t pfnAuthorizeAttrCB;
+} gattServiceCBs_t;
+
+#define GATT_NUM_ATTRS(attrs)           (sizeof(attrs) / sizeof(gattAttribute_t))
+#define GATT_SERVICE_HANDLE(attrs)      ((attrs)[0].handle)
+#define GATT_INCLUDED_HANDLE(attrs, index) \
+    (*((uint16 *)((attrs)[(index)].pValue)))
+#define GATT_CCC_TBL(pValue)            ((gattCharCfg_t *)(*((PTR_TYPE)(pValue))))
+
+extern bStatus_t GATT_Notification(uint16 connHandle,
+                                   attHandleValueNoti_t *pNoti,
+                                   uint8 authenticated);
+extern bStatus_t GATT_Indication(uint16 connHandle, attHandleValueInd_t *pInd,
+                                 uint8 authenticated, uint8 taskId);
+extern void *GATT_bm_alloc(uint16 connHandle, uint8 opcode, uint16 size,
+                           uint16 *pSizeAlloc);
+extern void GATT_bm_free(gattMsg_t *pMsg, uint8 opcode);
+
+/*********************************************************************
+ * GATT SERVER APP
+ */
+extern bStatus_t GATTServApp_RegisterService(gattAttribute_t *pAttrs,
+                                             uint16 numAttrs,
+                                             uint8 encKeySize,
+                                             CONST gattServiceCBs_t *pServiceCBs);
+extern bStatus_t GATTServApp_AddService(uint32 services);
+
+extern void GATTServApp_InitCharCfg(uint16 connHandle,
+                                    gattCharCfg_t *charCfgTbl);
+extern bStatus_t GATTServApp_ProcessCharCfg(gattCharCfg_t *charCfgTbl,
+                                            uint8 *pValue,
+                                            uint8 authenticated,
+                                            gattAttribute_t *attrTbl,
+                                            uint16 numAttrs, uint8 taskId,
+                                            pfnGATTReadAttrCB_t pfnReadAttrCB);
+extern gattAttribute_t *GATTServApp_FindAttr(gattAttribute_t *pAttrTbl,
+                                             uint16 numAttrs, uint8 *pValue);
+extern bStatus_t GATTServApp_ProcessCCCWriteReq(uint16 connHandle,
+                                                gattAttribute_t *pAttr,
+                                                uint8 *pValue, uint16 len,
+                                                uint16 offset,
+                                                uint16 validCfg);
+extern uint16 GATTServApp_ReadCharCfg(uint16 connHandle,
+                                      gattCharCfg_t *charCfgTbl);
+extern uint8 GATTServApp_WriteCharCfg(uint16 connHandle,
+                                      gattCharCfg_t *charCfgTbl,
+                                      uint16 value);
+
+/*********************************************************************
+ * LINK DATABASE
+ */
+extern uint8 linkDBNumConns;
+
+/*********************************************************************
+ * DEVICE INFORMATION SERVICE
+ */
+#define DEVINFO_SYSTEM_ID               0
+#define DEVINFO_PNP_ID                  7
+
+extern bStatus_t DevInfo_AddService(void);
+extern bStatus_t DevInfo_SetParameter(uint8 param, uint8 len, void *value);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_STACK_H */
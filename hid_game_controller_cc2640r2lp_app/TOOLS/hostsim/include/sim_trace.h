@@ -0,0 +1,76 @@
+/******************************************************************************
+
+ @file       sim_trace.h
+
+ @brief This file contains the input trace support of the host simulation:
+        capture of the trace the application drains, trace files and the
+        trace decoder. Built with INPUT_TRACE only.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Record the joystick samples, key edges, reports and
+                        send outcomes in a compact binary trace, drained
+                        through the diagnostic service and replayed on the
+                        host simulation (TOOLS/hostsim/trace_replay.c).
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "sim.h"
+#include "inputtrace.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Decoded trace record
+typedef struct
+{
+    uint64_t timeUs;        // Since the boot of the device
+    uint8_t type;           // INPUT_TRACE_REC_*
+    uint8_t channel;        // ADC channel
+    uint8_t id;             // REPORT ID
+    uint8_t rptType;        // REPORT type
+    uint8_t len;            // REPORT length
+    uint32_t value;         // ADC value, KEYS mask, SENT status, LINK
+                            // state, LOST count, START version
+    uint16_t interval;      // LINK UP connection parameters
+    uint16_t latency;
+    uint16_t timeout;
+    uint8_t data[INPUT_TRACE_RPT_LEN];  // REPORT
+} simTraceRec_t;
+
+/*********************************************************************
+ * INPUT TRACE (sim_trace.c)
+ */
+extern void SimTrace_capture(void);
+extern uint32_t SimTrace_collect(uint8_t **ppTrace);
+extern int SimTrace_load(const char *pPath, uint8_t **ppTrace,
+                         uint32_t *pLen);
+extern int SimTrace_save(const char *pPath, const uint8_t *pTrace,
+                         uint32_t len);
+extern int SimTrace_decode(const uint8_t *pTrace, uint32_t len,
+                           simTraceRec_t **ppRecs, uint32_t *pNumRecs);
+extern void SimTrace_print(FILE *pFile, const simTraceRec_t *pRec);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TRACE_H */
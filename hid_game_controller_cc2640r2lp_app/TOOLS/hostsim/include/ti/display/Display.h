@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <ti/display/Display.h>, see sim_io.h */
+#ifndef SIM_FWD_TI_DISPLAY_DISPLAY_H
+#define SIM_FWD_TI_DISPLAY_DISPLAY_H
+#include "sim_io.h"
+#endif
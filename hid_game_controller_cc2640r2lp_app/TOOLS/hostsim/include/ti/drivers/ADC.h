@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <ti/drivers/ADC.h>, see sim_io.h */
+#ifndef SIM_FWD_TI_DRIVERS_ADC_H
+#define SIM_FWD_TI_DRIVERS_ADC_H
+#include "sim_io.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <ti/drivers/PWM.h>, see sim_io.h */
+#ifndef SIM_FWD_TI_DRIVERS_PWM_H
+#define SIM_FWD_TI_DRIVERS_PWM_H
+#include "sim_io.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <ti/drivers/pin/PINCC26XX.h>, see sim_io.h */
+#ifndef SIM_FWD_TI_DRIVERS_PIN_PINCC26XX_H
+#define SIM_FWD_TI_DRIVERS_PIN_PINCC26XX_H
+#include "sim_io.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <ti/sysbios/BIOS.h>, see sim_rtos.h */
+#ifndef SIM_FWD_TI_SYSBIOS_BIOS_H
+#define SIM_FWD_TI_SYSBIOS_BIOS_H
+#include "sim_rtos.h"
+#endif
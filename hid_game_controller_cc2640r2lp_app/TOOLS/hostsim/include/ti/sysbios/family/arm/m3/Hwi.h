@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <ti/sysbios/family/arm/m3/Hwi.h>, see sim_rtos.h */
+#ifndef SIM_FWD_TI_SYSBIOS_FAMILY_ARM_M3_HWI_H
+#define SIM_FWD_TI_SYSBIOS_FAMILY_ARM_M3_HWI_H
+#include "sim_rtos.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <ti/sysbios/hal/Hwi.h>, see sim_rtos.h */
+#ifndef SIM_FWD_TI_SYSBIOS_HAL_HWI_H
+#define SIM_FWD_TI_SYSBIOS_HAL_HWI_H
+#include "sim_rtos.h"
+#endif
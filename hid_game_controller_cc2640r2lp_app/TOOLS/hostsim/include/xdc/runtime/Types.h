@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <xdc/runtime/Types.h>, see sim_rtos.h */
+#ifndef SIM_FWD_XDC_RUNTIME_TYPES_H
+#define SIM_FWD_XDC_RUNTIME_TYPES_H
+#include "sim_rtos.h"
+#endif
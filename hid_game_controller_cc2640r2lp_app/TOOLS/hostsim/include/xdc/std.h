@@ -0,0 +1,5 @@
+/* Host simulation stand-in for <xdc/std.h>, see sim_rtos.h */
+#ifndef SIM_FWD_XDC_STD_H
+#define SIM_FWD_XDC_STD_H
+#include "sim_rtos.h"
+#endif
@@ -0,0 +1,548 @@
+/******************************************************************************
+
+ @file       sim_bench.c
+
+ @brief This file contains the report path benchmark of the host
+        simulation. A minimal application task runs HidDev with the HID
+        keyboard service and feeds HidDev_Report with a storm of keyboard
+        reports at a fixed rate, while the connection timing model takes
+        the notifications. The run prints one JSON object with the
+        throughput, the queue occupancy, the reports lost at every stage,
+        the input to host latency and the host CPU time of the report path.
+
+        Usage: hostbench [-r rate] [-s repeat] [-d duration] [-i interval]
+                         [-l latency] [-L loss] [-o outage]
+
+          -r  reports per second, default 250
+          -s  reports per key state, 1 changes every report, more send
+              each state again as a sampling application does, default 1
+          -d  storm duration in ms, default 5000
+          -i  connection interval in 1.25 ms units, default 6
+          -l  slave latency, default 0
+          -L  packet loss per mille, default 0
+          -o  link outage in the middle of the storm in ms, default 0
+
+        The queue length and the coalescing mode are build options of
+        HidDev, HID_DEV_RPT_QUEUE_LEN and HID_DEV_RPT_COALESCE. bench.py
+        builds the variants and runs the matrix.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Report path throughput and drop benchmark on the
+                        host simulation.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "util.h"
+#include "hiddev.h"
+#include "hidkbdservice.h"
+#include "peripheral.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// HidDev is set up in the task of the benchmark with HidDev_initTask
+#ifndef HID_DEV_SINGLE_TASK
+#error "The benchmark needs HID_DEV_SINGLE_TASK"
+#endif // !HID_DEV_SINGLE_TASK
+
+// Build options of HidDev, as hiddev.c defaults them
+#ifndef HID_DEV_RPT_QUEUE_LEN
+#define HID_DEV_RPT_QUEUE_LEN           10
+#endif
+
+#ifndef HID_DEV_RPT_COALESCE
+#define HID_DEV_RPT_COALESCE            HID_DEV_COALESCE_NONE
+#endif
+
+// Session before the storm and drain time after it, in ms
+#define BENCH_CONNECT_MS                10
+#define BENCH_PAIR_MS                   100
+#define BENCH_ENABLE_MS                 300
+#define BENCH_STORM_MS                  1000
+#define BENCH_DRAIN_MS                  2000
+
+// Defaults of the options
+#define BENCH_DEFAULT_RATE              250
+#define BENCH_DEFAULT_REPEAT            1
+#define BENCH_DEFAULT_DURATION_MS       5000
+#define BENCH_DEFAULT_INTERVAL          6
+
+// Keyboard input report
+#define BENCH_REPORT_LEN                8
+#define BENCH_KEY_CODES                 26
+
+// Events of the bench task, Event_Id_00 to Event_Id_07 are the task's
+#define BENCH_ICALL_EVT                 ICALL_MSG_EVENT_ID
+#define BENCH_REPORT_EVT                Event_Id_00
+
+#define BENCH_ALL_EVENTS                (BENCH_ICALL_EVT | \
+                                         BENCH_REPORT_EVT | \
+                                         HID_DEV_ALL_EVENTS)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Host CPU time samples in nanoseconds
+typedef struct
+{
+    uint32_t num;
+    uint32_t size;
+    uint32_t *pNs;
+} benchCpu_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Options
+static uint32_t rate = BENCH_DEFAULT_RATE;
+static uint32_t repeat = BENCH_DEFAULT_REPEAT;
+static uint32_t durationMs = BENCH_DEFAULT_DURATION_MS;
+static uint16_t connInterval = BENCH_DEFAULT_INTERVAL;
+static uint16_t connLatency = 0;
+static uint16_t lossPermille = 0;
+static uint32_t outageMs = 0;
+
+// Task
+static ICall_EntityID selfEntity;
+static ICall_SyncHandle syncEvent;
+static Task_Struct benchTask;
+
+static hidDevCfg_t benchHidCfg =
+{
+    0,                          // No idle timeout
+    HID_KBD_FLAGS
+};
+
+// Storm
+static uint32_t numTicks = 0;               // Reports the storm asked for
+static uint32_t numReports = 0;             // Reports passed to HidDev
+static uint64_t depthSum = 0;               // Queue depth after each report
+
+// Notifications delivered by the end of the storm
+static uint32_t deliveredInStorm = 0;
+
+static benchCpu_t cpuReport;                // HidDev_Report
+static benchCpu_t cpuSendEvt;               // Queued report sent by HidDev
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8_t Bench_reportCB(uint8_t id, uint8_t type, uint16_t uuid,
+                              uint8_t oper, uint16_t *pLen, uint8_t *pData);
+static void Bench_evtCB(uint8_t evt);
+
+/*********************************************************************
+ * PROFILE CALLBACKS
+ */
+
+static hidDevCB_t benchHidCBs =
+{
+    Bench_reportCB,
+    Bench_evtCB,
+    NULL
+};
+
+static uint8_t Bench_reportCB(uint8_t id, uint8_t type, uint16_t uuid,
+                              uint8_t oper, uint16_t *pLen, uint8_t *pData)
+{
+    if (oper == HID_DEV_OPER_READ)
+    {
+        *pLen = 0;
+    }
+
+    return SUCCESS;
+}
+
+static void Bench_evtCB(uint8_t evt)
+{
+}
+
+/*********************************************************************
+ * @fn      Bench_nowNs
+ *
+ * @brief   Host monotonic time in nanoseconds.
+ */
+static uint64_t Bench_nowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*********************************************************************
+ * @fn      Bench_cpuAdd
+ *
+ * @brief   Add a CPU time sample.
+ *
+ * @param   pCpu - samples
+ * @param   ns - time in nanoseconds
+ *
+ * @return  none
+ */
+static void Bench_cpuAdd(benchCpu_t *pCpu, uint64_t ns)
+{
+    if (pCpu->num == pCpu->size)
+    {
+        pCpu->size = pCpu->size ? 2 * pCpu->size : 1024;
+        pCpu->pNs = realloc(pCpu->pNs, pCpu->size * sizeof(uint32_t));
+    }
+
+    pCpu->pNs[pCpu->num++] = (uint32_t)MIN(ns, UINT32_MAX);
+}
+
+static int Bench_compareNs(const void *pA, const void *pB)
+{
+    uint32_t a = *(const uint32_t *)pA;
+    uint32_t b = *(const uint32_t *)pB;
+
+    return (a > b) - (a < b);
+}
+
+/*********************************************************************
+ * @fn      Bench_cpuPrint
+ *
+ * @brief   Print the mean and the 99th percentile of CPU time samples as
+ *          JSON members.
+ *
+ * @param   pName - member name prefix
+ * @param   pCpu - samples
+ *
+ * @return  none
+ */
+static void Bench_cpuPrint(const char *pName, benchCpu_t *pCpu)
+{
+    uint64_t sum = 0;
+    uint32_t i;
+
+    if (pCpu->num == 0)
+    {
+        printf(", \"%s_ns_mean\": 0, \"%s_ns_p99\": 0", pName, pName);
+        return;
+    }
+
+    qsort(pCpu->pNs, pCpu->num, sizeof(uint32_t), Bench_compareNs);
+
+    for (i = 0; i < pCpu->num; i++)
+    {
+        sum += pCpu->pNs[i];
+    }
+
+    printf(", \"%s_ns_mean\": %llu, \"%s_ns_p99\": %u", pName,
+           (unsigned long long)(sum / pCpu->num), pName,
+           pCpu->pNs[((pCpu->num - 1) * 99) / 100]);
+}
+
+/*********************************************************************
+ * @fn      Bench_sendReport
+ *
+ * @brief   Pass the next storm report to HidDev. Every repeat reports the
+ *          key state alternates between a key press, rolling through the
+ *          letters, and no key.
+ *
+ * @return  none
+ */
+static void Bench_sendReport(void)
+{
+    uint8_t report[BENCH_REPORT_LEN] = { 0 };
+    uint32_t state = numReports / repeat;
+    hidDevReportStats_t stats;
+    uint64_t startNs;
+
+    if ((state & 1) == 0)
+    {
+        report[2] = HID_KEYBOARD_A + (state / 2) % BENCH_KEY_CODES;
+    }
+
+    if ((numReports % repeat) == 0)
+    {
+        SimConn_input();
+    }
+
+    startNs = Bench_nowNs();
+    HidDev_Report(HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT, sizeof(report),
+                  report);
+    Bench_cpuAdd(&cpuReport, Bench_nowNs() - startNs);
+
+    numReports++;
+
+    HidDev_GetParameter(HIDDEV_REPORT_STATS, &stats);
+    depthSum += stats.queueDepth;
+}
+
+/*********************************************************************
+ * @fn      Bench_tick
+ *
+ * @brief   Storm clock, asks the task for the next report.
+ *
+ * @param   arg - storm start tick
+ *
+ * @return  none
+ */
+static void Bench_tick(uintptr_t arg)
+{
+    uint64_t next;
+
+    numTicks++;
+    Event_post(syncEvent, BENCH_REPORT_EVT);
+
+    next = arg + ((uint64_t)numTicks * SIM_MS(1000)) / rate;
+
+    if (next < arg + SIM_MS(durationMs))
+    {
+        SimRtos_defer(next - SimRtos_now(), Bench_tick, arg);
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_stormEnd
+ *
+ * @brief   Note the notifications delivered during the storm.
+ *
+ * @return  none
+ */
+static void Bench_stormEnd(uintptr_t arg)
+{
+    simConnStats_t connStats;
+
+    SimConn_getStats(&connStats);
+    deliveredInStorm = connStats.delivered;
+}
+
+/*********************************************************************
+ * SESSION
+ */
+
+static void Bench_connect(uintptr_t arg)
+{
+    SimBle_connect(connInterval, connLatency, SIM_DEFAULT_CONN_TIMEOUT);
+}
+
+static void Bench_disconnect(uintptr_t arg)
+{
+    SimBle_disconnect();
+}
+
+static void Bench_pair(uintptr_t arg)
+{
+    SimBle_pair();
+}
+
+static void Bench_enable(uintptr_t arg)
+{
+    SimBle_enableNotifications();
+}
+
+/*********************************************************************
+ * @fn      Bench_taskFxn
+ *
+ * @brief   Bench application task: HidDev with the HID keyboard service,
+ *          set up as the application does, and the storm reports.
+ *
+ * @param   a0, a1 - not used.
+ *
+ * @return  none
+ */
+static void Bench_taskFxn(UArg a0, UArg a1)
+{
+    uint8_t advEnable = TRUE;
+
+    ICall_registerApp(&selfEntity, &syncEvent);
+    HidDev_initTask(selfEntity, syncEvent);
+
+    GAPRole_SetParameter(GAPROLE_ADVERT_ENABLED, sizeof(uint8_t), &advEnable);
+
+    HidKbd_AddService();
+    HidDev_Register(&benchHidCfg, &benchHidCBs);
+    HidDev_StartDevice();
+
+    for (;;)
+    {
+        uint32_t events = Event_pend(syncEvent, Event_Id_NONE,
+                                     BENCH_ALL_EVENTS, ICALL_TIMEOUT_FOREVER);
+        ICall_EntityID dest;
+        ICall_ServiceEnum src;
+        ICall_HciExtEvt *pMsg = NULL;
+
+        if (ICall_fetchServiceMsg(&src, &dest,
+                                  (void **)&pMsg) == ICALL_ERRNO_SUCCESS)
+        {
+            if (pMsg)
+            {
+                ICall_freeMsg(pMsg);
+            }
+        }
+
+        if (events & BENCH_REPORT_EVT)
+        {
+            while (numReports < numTicks)
+            {
+                Bench_sendReport();
+            }
+        }
+
+        if (events & HID_DEV_SEND_REPORT_EVT)
+        {
+            uint64_t startNs = Bench_nowNs();
+
+            HidDev_processEvents(HID_DEV_SEND_REPORT_EVT);
+            Bench_cpuAdd(&cpuSendEvt, Bench_nowNs() - startNs);
+        }
+
+        HidDev_processEvents(events & ~HID_DEV_SEND_REPORT_EVT);
+    }
+}
+
+/*********************************************************************
+ * @fn      Bench_print
+ *
+ * @brief   Print the result of the run as one JSON object.
+ *
+ * @return  none
+ */
+static void Bench_print(void)
+{
+    static const char *coalesceNames[] = { "none", "same", "latest" };
+    hidDevReportStats_t stats;
+    simConnStats_t connStats;
+
+    HidDev_GetParameter(HIDDEV_REPORT_STATS, &stats);
+    SimConn_getStats(&connStats);
+
+    printf("{\"queue_len\": %u, \"coalesce\": \"%s\", \"interval\": %u, "
+           "\"latency\": %u, \"loss\": %u, \"rate\": %u, \"repeat\": %u, "
+           "\"duration_ms\": %u, \"outage_ms\": %u",
+           HID_DEV_RPT_QUEUE_LEN, coalesceNames[HID_DEV_RPT_COALESCE],
+           connInterval, connLatency, lossPermille, rate, repeat, durationMs,
+           outageMs);
+
+    // Throughput
+    printf(", \"reports\": %u, \"delivered\": %u, \"offered_per_s\": %.1f, "
+           "\"delivered_per_s\": %.1f", stats.reports, connStats.delivered,
+           stats.reports * 1000.0 / durationMs,
+           deliveredInStorm * 1000.0 / durationMs);
+
+    // HidDev
+    printf(", \"sent\": %u, \"noti_failed\": %u, \"discarded\": %u, "
+           "\"queued\": %u, \"coalesced\": %u, \"overflows\": %u, "
+           "\"unchanged\": %u, \"queue_peak\": %u, \"queue_mean\": %.2f",
+           stats.sent, stats.notiFailed, stats.discarded, stats.queued,
+           stats.coalesced, stats.overflows, stats.unchanged, stats.queuePeak,
+           numReports ? (double)depthSum / numReports : 0.0);
+
+    // Link
+    printf(", \"buffer_full\": %u, \"link_dropped\": %u, \"retransmit\": %u, "
+           "\"duty_cycle_pct\": %.3f", connStats.bufferFull,
+           connStats.dropped, connStats.retransmit,
+           connStats.connectedUs ?
+           (100.0 * connStats.radioOnUs) / connStats.connectedUs : 0.0);
+
+    // Inputs
+    printf(", \"inputs\": %u, \"inputs_lost\": %u, \"latency_p50_ms\": %.2f, "
+           "\"latency_p99_ms\": %.2f, \"latency_max_ms\": %.2f",
+           connStats.inputs, connStats.inputs - connStats.reported,
+           connStats.p50Us / 1000.0, connStats.p99Us / 1000.0,
+           connStats.maxUs / 1000.0);
+
+    // Host CPU time
+    Bench_cpuPrint("report", &cpuReport);
+    Bench_cpuPrint("send_evt", &cpuSendEvt);
+
+    printf("}\n");
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the benchmark.
+ *
+ * @return  Zero on success
+ */
+int main(int argc, char *argv[])
+{
+    Task_Params taskParams;
+    uint32_t stormEndMs;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:s:d:i:l:L:o:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r': rate = strtoul(optarg, NULL, 0); break;
+            case 's': repeat = strtoul(optarg, NULL, 0); break;
+            case 'd': durationMs = strtoul(optarg, NULL, 0); break;
+            case 'i': connInterval = strtoul(optarg, NULL, 0); break;
+            case 'l': connLatency = strtoul(optarg, NULL, 0); break;
+            case 'L': lossPermille = strtoul(optarg, NULL, 0); break;
+            case 'o': outageMs = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-r rate] [-s repeat] "
+                        "[-d duration] [-i interval] [-l latency] [-L loss] "
+                        "[-o outage]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if ((rate == 0) || (repeat == 0) || (durationMs == 0) ||
+        (connInterval == 0) || (outageMs >= durationMs))
+    {
+        fprintf(stderr, "%s: bad option value\n", argv[0]);
+        return 2;
+    }
+
+    simLogMask = 0;
+    SimConn_enable();
+    SimBle_acceptParamUpdates(FALSE);
+    SimBle_setLink(-60, lossPermille);
+
+    // Session: connect, pair, enable the reports, then the storm
+    SimRtos_defer(SIM_MS(BENCH_CONNECT_MS), Bench_connect, 0);
+    SimRtos_defer(SIM_MS(BENCH_PAIR_MS), Bench_pair, 0);
+    SimRtos_defer(SIM_MS(BENCH_ENABLE_MS), Bench_enable, 0);
+    SimRtos_defer(SIM_MS(BENCH_STORM_MS), Bench_tick, SIM_MS(BENCH_STORM_MS));
+
+    stormEndMs = BENCH_STORM_MS + durationMs;
+    SimRtos_defer(SIM_MS(stormEndMs), Bench_stormEnd, 0);
+
+    // The bonded central comes back after the outage and encrypts
+    if (outageMs)
+    {
+        uint32_t downMs = BENCH_STORM_MS + (durationMs - outageMs) / 2;
+
+        SimRtos_defer(SIM_MS(downMs), Bench_disconnect, 0);
+        SimRtos_defer(SIM_MS(downMs + outageMs), Bench_connect, 0);
+        SimRtos_defer(SIM_MS(downMs + outageMs + BENCH_PAIR_MS), Bench_pair,
+                      0);
+    }
+
+    Task_Params_init(&taskParams);
+    Task_construct(&benchTask, Bench_taskFxn, &taskParams, NULL);
+
+    SimRtos_run(SIM_MS(stormEndMs + BENCH_DRAIN_MS));
+
+    Bench_print();
+
+    return 0;
+}
+
+/*********************************************************************
+*********************************************************************/
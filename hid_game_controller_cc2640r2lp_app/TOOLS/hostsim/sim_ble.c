@@ -0,0 +1,1454 @@
+/******************************************************************************
+
+ @file       sim_ble.c
+
+ @brief This file contains the BLE stack side of the host simulation:
+        ICall messaging and heap, the HCI commands used by the application,
+        a GATT server over the registered attribute tables, the Peripheral
+        GAPRole and the GAP Bond Manager, together with the central they
+        are connected to. The central is driven by the scenario script.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Linux host simulation build of the application and
+                        HID profile against a shim of the RTOS, the BLE stack
+                        and the drivers.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+#include "gatt_uuid.h"
+#include "gapbondmgr.h"
+#include "peripheral.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// ICall heap size, as configured for the application
+#ifndef SIM_HEAP_SIZE
+#define SIM_HEAP_SIZE                   6144
+#endif
+
+// Maximum number of ICall entities and registered services
+#define SIM_MAX_ENTITIES                2
+#define SIM_MAX_SERVICES                12
+
+// Handles taken by the services the stack adds itself
+#define SIM_GGS_NUM_ATTRS               7
+#define SIM_GATT_NUM_ATTRS              4
+#define SIM_DEVINFO_NUM_ATTRS           19
+
+// Notification counters kept per handle
+#define SIM_MAX_NOTI_HANDLES            16
+
+// Disconnect reason of a local host termination
+#define SIM_TERM_LOCAL_HOST             0x16
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// ICall heap block header
+typedef struct
+{
+    size_t size;
+    uint64_t align;
+} simHeapHdr_t;
+
+// Stack message on its way to an entity
+typedef struct simMsg_s
+{
+    struct simMsg_s *next;
+    ICall_EntityID dest;
+    void *pMsg;
+} simMsg_t;
+
+// Registered GATT service
+typedef struct
+{
+    gattAttribute_t *pAttrs;
+    uint16 numAttrs;
+    CONST gattServiceCBs_t *pCBs;
+} simService_t;
+
+// Notification counter
+typedef struct
+{
+    uint16 handle;
+    uint32 count;
+} simNotiCount_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Maximum number of connections, sizes the CCCD tables
+uint8 linkDBNumConns = MAX_NUM_BLE_CONNS;
+
+// Stack task, only sampled by the memory monitor
+Task_Struct gapRoleTask;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// ICall
+static uint8 numEntities = 0;
+static Event_Struct entityEvent[SIM_MAX_ENTITIES];
+static Task_Handle entityTask[SIM_MAX_ENTITIES];
+
+// Stack messages of each entity
+static simMsg_t *msgHead[SIM_MAX_ENTITIES];
+static simMsg_t *msgTail[SIM_MAX_ENTITIES];
+
+// ICall heap accounting
+static size_t heapUsed = 0;
+static size_t heapPeak = 0;
+static uint32 heapFailures = 0;
+
+// GATT server
+static simService_t services[SIM_MAX_SERVICES];
+static uint8 numServices = 0;
+static uint16 nextHandle = GATT_MIN_HANDLE;
+
+// Notifications
+static uint8_t SimBle_logNoti(const simNoti_t *pNoti);
+static simNotiSink_t notiSink = SimBle_logNoti;
+static simNotiTap_t notiTap = NULL;
+static simNotiCount_t notiCount[SIM_MAX_NOTI_HANDLES];
+static uint32 notiRejected = 0;
+static simLinkObserver_t linkObserver = NULL;
+
+// GAPRole
+static gapRolesCBs_t *pGapRoleCBs = NULL;
+static gaprole_States_t gapState = GAPROLE_INIT;
+static uint8 advEnabled = FALSE;
+static uint8 advFilterPolicy = GAP_FILTER_POLICY_ALL;
+static uint8 paramUpdateEnable = FALSE;
+static gapRoleConnParams_t desiredParams;
+static const gapRoleConnParams_t *pLadder = NULL;
+static uint8 termReason = 0;
+
+// Ladder negotiation until the central accepts a ladder request, and held
+// by an application set
+static bool ladderActive = FALSE;
+static bool ladderHeld = FALSE;
+static bool ladderPending = FALSE;
+
+// Link to the central
+static bool connected = FALSE;
+static bool encrypted = FALSE;
+static uint16 connHandle = INVALID_CONNHANDLE;
+static uint16 connInterval = 0;
+static uint16 connLatency = 0;
+static uint16 connTimeout = 0;
+static uint64_t connStart = 0;
+static bool acceptUpdates = TRUE;
+static gapRoleConnParams_t pendingParams;
+
+// Link quality and packet error rate counters
+static int8 linkRssi = -60;
+static uint16 linkLossPermille = 0;
+static uint64_t perStart = 0;
+
+// Bond manager
+static gapBondCBs_t *pBondCBs = NULL;
+static uint8 bondCount = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 SimBle_entity(void);
+static void SimBle_sendMsg(void *pMsg);
+static void SimBle_setState(gaprole_States_t newState);
+static void SimBle_deferState(uintptr_t arg);
+static void SimBle_requestUpdate(uint16 minInterval, uint16 latency,
+                                 uint16 timeout);
+static void SimBle_requestLadder(void);
+static void SimBle_applyUpdate(uintptr_t arg);
+static void SimBle_pairDone(uintptr_t arg);
+static void SimBle_terminate(uintptr_t arg);
+static gattAttribute_t *SimBle_findAttr(uint16 handle, simService_t **ppService);
+static uint16 SimBle_uuid(const gattAttrType_t *pType);
+
+/*********************************************************************
+ * ICALL
+ */
+
+ICall_Errno ICall_registerApp(ICall_EntityID *pEntity,
+                              ICall_SyncHandle *pMsgSyncHdl)
+{
+    *pEntity = numEntities;
+    *pMsgSyncHdl = &entityEvent[numEntities];
+    entityTask[numEntities] = Task_self();
+    numEntities++;
+
+    return ICALL_ERRNO_SUCCESS;
+}
+
+ICall_Errno ICall_fetchServiceMsg(ICall_ServiceEnum *pSrc,
+                                  ICall_EntityID *pDest, void **pMsg)
+{
+    uint8 entity = SimBle_entity();
+    simMsg_t *pEntry = msgHead[entity];
+
+    if (pEntry == NULL)
+    {
+        return ICALL_ERRNO_NOMSG;
+    }
+
+    msgHead[entity] = pEntry->next;
+    if (msgHead[entity] == NULL)
+    {
+        msgTail[entity] = NULL;
+    }
+    else
+    {
+        // One message per wakeup, come back for the next one
+        Event_post(&entityEvent[entity], ICALL_MSG_EVENT_ID);
+    }
+
+    *pSrc = ICALL_SERVICE_CLASS_BLE;
+    *pDest = pEntry->dest;
+    *pMsg = pEntry->pMsg;
+    free(pEntry);
+
+    return ICALL_ERRNO_SUCCESS;
+}
+
+void *ICall_malloc(uint_least16_t size)
+{
+    simHeapHdr_t *pHdr;
+
+    if (heapUsed + size + sizeof(simHeapHdr_t) > SIM_HEAP_SIZE)
+    {
+        heapFailures++;
+
+        return NULL;
+    }
+
+    pHdr = malloc(sizeof(simHeapHdr_t) + size);
+    pHdr->size = size + sizeof(simHeapHdr_t);
+
+    heapUsed += pHdr->size;
+    heapPeak = MAX(heapPeak, heapUsed);
+
+    return (pHdr + 1);
+}
+
+void ICall_free(void *pMsg)
+{
+    if (pMsg != NULL)
+    {
+        simHeapHdr_t *pHdr = (simHeapHdr_t *)pMsg - 1;
+
+        heapUsed -= pHdr->size;
+        free(pHdr);
+    }
+}
+
+void ICall_freeMsg(void *pMsg)
+{
+    ICall_free(pMsg);
+}
+
+void Memory_getStats(Ptr heap, Memory_Stats *pStats)
+{
+    pStats->totalSize = SIM_HEAP_SIZE;
+    pStats->totalFreeSize = SIM_HEAP_SIZE - heapUsed;
+    pStats->largestFreeSize = SIM_HEAP_SIZE - heapUsed;
+}
+
+/*********************************************************************
+ * @fn      SimBle_entity
+ *
+ * @brief   ICall entity of the running task. Tasks sharing an entity,
+ *          and calls made outside the tasks, take the first one.
+ *
+ * @return  entity
+ */
+static uint8 SimBle_entity(void)
+{
+    Task_Handle self = Task_self();
+    uint8 i;
+
+    for (i = 0; i < numEntities; i++)
+    {
+        if (entityTask[i] == self)
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      SimBle_sendMsg
+ *
+ * @brief   Queue a stack message for the application entity.
+ *
+ * @param   pMsg - message allocated with ICall_malloc
+ *
+ * @return  none
+ */
+static void SimBle_sendMsg(void *pMsg)
+{
+    simMsg_t *pEntry = malloc(sizeof(simMsg_t));
+    uint8 dest = SimBle_entity();
+
+    // Command events go to the entity of the task that sent the command
+    pEntry->next = NULL;
+    pEntry->dest = dest;
+    pEntry->pMsg = pMsg;
+
+    if (msgTail[dest] == NULL)
+    {
+        msgHead[dest] = pEntry;
+    }
+    else
+    {
+        msgTail[dest]->next = pEntry;
+    }
+    msgTail[dest] = pEntry;
+
+    Event_post(&entityEvent[dest], ICALL_MSG_EVENT_ID);
+}
+
+/*********************************************************************
+ * HCI
+ */
+
+// Command complete event with its return parameters in the same block
+static void SimBle_cmdComplete(uint16 opcode, const uint8 *pParam, uint8 len)
+{
+    hciEvt_CmdComplete_t *pEvt = ICall_malloc(sizeof(hciEvt_CmdComplete_t) +
+                                              len);
+
+    if (pEvt != NULL)
+    {
+        pEvt->hdr.event = HCI_GAP_EVENT_EVENT;
+        pEvt->hdr.status = HCI_COMMAND_COMPLETE_EVENT_CODE;
+        pEvt->numHciCmdPkt = 1;
+        pEvt->cmdOpcode = opcode;
+        pEvt->pReturnParam = (uint8 *)(pEvt + 1);
+        memcpy(pEvt->pReturnParam, pParam, len);
+
+        SimBle_sendMsg(pEvt);
+    }
+}
+
+uint8 HCI_ReadRssiCmd(uint16 handle)
+{
+    uint8 param[4];
+
+    param[0] = connected ? SUCCESS : 0x02;     // Unknown connection id
+    param[1] = LO_UINT16(handle);
+    param[2] = HI_UINT16(handle);
+    param[3] = (uint8)linkRssi;
+
+    SimBle_cmdComplete(HCI_READ_RSSI, param, sizeof(param));
+
+    return SUCCESS;
+}
+
+uint8 HCI_LE_ReadLocalSupportedFeaturesCmd(void)
+{
+    // Encryption, connection parameters request, extended reject
+    // indication, slave-initiated features exchange, LE ping
+    uint8 param[9] = { SUCCESS, 0x1F, 0, 0, 0, 0, 0, 0, 0 };
+
+    SimBle_cmdComplete(HCI_LE_READ_LOCAL_SUPPORTED_FEATURES, param,
+                       sizeof(param));
+
+    return SUCCESS;
+}
+
+uint8 HCI_EXT_PacketErrorRateCmd(uint16 handle, uint8 command)
+{
+    hciEvt_VSCmdComplete_t *pEvt;
+    uint16 numEvents = 0;
+    uint16 numMissed;
+    uint8 *p;
+
+    if (command == HCI_EXT_PER_RESET)
+    {
+        perStart = SimRtos_now();
+    }
+    else if (connected)
+    {
+        numEvents = (uint16)((SimRtos_now() - MAX(perStart, connStart)) /
+                             (connInterval * SIM_CONN_INTERVAL_TICKS));
+    }
+
+    numMissed = (uint16)(((uint32)numEvents * linkLossPermille) / 1000);
+
+    pEvt = ICall_malloc(sizeof(hciEvt_VSCmdComplete_t) + 12);
+    if (pEvt != NULL)
+    {
+        pEvt->hdr.event = HCI_GAP_EVENT_EVENT;
+        pEvt->hdr.status = HCI_VE_EVENT_CODE;
+        pEvt->length = 12;
+        pEvt->cmdOpcode = HCI_EXT_PER;
+        pEvt->pEventParam = p = (uint8 *)(pEvt + 1);
+
+        // Opcode, status, command, packets, CRC errors, events, missed
+        p[0] = LO_UINT16(HCI_EXT_PER);
+        p[1] = HI_UINT16(HCI_EXT_PER);
+        p[2] = connected ? SUCCESS : 0x02;
+        p[3] = command;
+        p[4] = LO_UINT16(numEvents - numMissed);
+        p[5] = HI_UINT16(numEvents - numMissed);
+        p[6] = LO_UINT16(numMissed / 2);
+        p[7] = HI_UINT16(numMissed / 2);
+        p[8] = LO_UINT16(numEvents);
+        p[9] = HI_UINT16(numEvents);
+        p[10] = LO_UINT16(numMissed);
+        p[11] = HI_UINT16(numMissed);
+
+        SimBle_sendMsg(pEvt);
+    }
+
+    return SUCCESS;
+}
+
+uint8 HCI_EXT_SetTxPowerCmd(uint8 txPower)
+{
+    SimRtos_log(SIM_LOG_EVENT, "hci   tx power index %u", txPower);
+
+    return SUCCESS;
+}
+
+uint8 HCI_EXT_SetLocalSupportedFeaturesCmd(uint8 *pLocalFeatures)
+{
+    SimRtos_log(SIM_LOG_EVENT, "hci   local features 0x%02x",
+                pLocalFeatures[0]);
+
+    return SUCCESS;
+}
+
+uint8 HCI_EXT_SetMaxDataLenCmd(uint16 txOctets, uint16 txTime,
+                               uint16 rxOctets, uint16 rxTime)
+{
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * GAP, GAP GATT SERVER, DEVICE INFORMATION
+ */
+
+bStatus_t GAP_SetParamValue(uint16 paramID, uint16 paramValue)
+{
+    return SUCCESS;
+}
+
+void GAP_RegisterForMsgs(uint8 taskID)
+{
+}
+
+bStatus_t GGS_SetParameter(uint8 param, uint8 len, void *value)
+{
+    return SUCCESS;
+}
+
+bStatus_t GGS_AddService(uint32 services)
+{
+    nextHandle += SIM_GGS_NUM_ATTRS;
+
+    return SUCCESS;
+}
+
+bStatus_t DevInfo_AddService(void)
+{
+    nextHandle += SIM_DEVINFO_NUM_ATTRS;
+
+    return SUCCESS;
+}
+
+bStatus_t DevInfo_SetParameter(uint8 param, uint8 len, void *value)
+{
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * GATT SERVER
+ */
+
+bStatus_t GATTServApp_AddService(uint32 services)
+{
+    nextHandle += SIM_GATT_NUM_ATTRS;
+
+    return SUCCESS;
+}
+
+bStatus_t GATTServApp_RegisterService(gattAttribute_t *pAttrs, uint16 numAttrs,
+                                      uint8 encKeySize,
+                                      CONST gattServiceCBs_t *pServiceCBs)
+{
+    uint16 i;
+
+    if (numServices == SIM_MAX_SERVICES)
+    {
+        return bleNoResources;
+    }
+
+    for (i = 0; i < numAttrs; i++)
+    {
+        pAttrs[i].handle = nextHandle++;
+    }
+
+    services[numServices].pAttrs = pAttrs;
+    services[numServices].numAttrs = numAttrs;
+    services[numServices].pCBs = pServiceCBs;
+    numServices++;
+
+    return SUCCESS;
+}
+
+void *GATT_bm_alloc(uint16 handle, uint8 opcode, uint16 size,
+                    uint16 *pSizeAlloc)
+{
+    void *pBuf;
+
+    // Notifications and indications carry up to ATT_MTU_SIZE - 3 octets
+    size = MIN(size, ATT_MTU_SIZE - 3);
+
+    pBuf = ICall_malloc(size);
+    if ((pBuf != NULL) && (pSizeAlloc != NULL))
+    {
+        *pSizeAlloc = size;
+    }
+
+    return pBuf;
+}
+
+void GATT_bm_free(gattMsg_t *pMsg, uint8 opcode)
+{
+    ICall_free(pMsg->handleValueNoti.pValue);
+    pMsg->handleValueNoti.pValue = NULL;
+}
+
+// Hand a notification or indication to the sink
+static bStatus_t SimBle_notify(uint16 handle, attHandleValueNoti_t *pNoti)
+{
+    simNoti_t noti;
+    uint8_t status;
+    uint8 i;
+
+    if (!connected || (handle != connHandle))
+    {
+        return bleNotConnected;
+    }
+
+    noti.time = SimRtos_now();
+    noti.handle = pNoti->handle;
+    noti.len = pNoti->len;
+    noti.pValue = pNoti->pValue;
+
+    status = notiSink(&noti);
+    if (status != SUCCESS)
+    {
+        notiRejected++;
+
+        return status;
+    }
+
+    if (notiTap != NULL)
+    {
+        notiTap(&noti);
+    }
+
+    for (i = 0; i < SIM_MAX_NOTI_HANDLES; i++)
+    {
+        if ((notiCount[i].handle == pNoti->handle) || (notiCount[i].count == 0))
+        {
+            notiCount[i].handle = pNoti->handle;
+            notiCount[i].count++;
+            break;
+        }
+    }
+
+    // The stack owns the buffer once the call succeeds
+    ICall_free(pNoti->pValue);
+
+    return SUCCESS;
+}
+
+bStatus_t GATT_Notification(uint16 handle, attHandleValueNoti_t *pNoti,
+                            uint8 authenticated)
+{
+    return SimBle_notify(handle, pNoti);
+}
+
+bStatus_t GATT_Indication(uint16 handle, attHandleValueInd_t *pInd,
+                          uint8 authenticated, uint8 taskId)
+{
+    return SimBle_notify(handle, pInd);
+}
+
+/*********************************************************************
+ * @fn      SimBle_logNoti
+ *
+ * @brief   Default notification sink, logs the notification.
+ *
+ * @param   pNoti - notification
+ *
+ * @return  SUCCESS
+ */
+static uint8_t SimBle_logNoti(const simNoti_t *pNoti)
+{
+    char hex[3 * (ATT_MTU_SIZE - 3) + 1];
+    uint16 i;
+
+    for (i = 0; i < pNoti->len; i++)
+    {
+        sprintf(&hex[3 * i], " %02x", pNoti->pValue[i]);
+    }
+    hex[3 * i] = '\0';
+
+    SimRtos_log(SIM_LOG_NOTI, "noti  0x%04x%s", pNoti->handle, hex);
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      SimBle_findAttr
+ *
+ * @brief   Find an attribute by handle.
+ *
+ * @param   handle - attribute handle
+ * @param   ppService - service owning the attribute
+ *
+ * @return  Attribute, NULL if not found
+ */
+static gattAttribute_t *SimBle_findAttr(uint16 handle, simService_t **ppService)
+{
+    uint8 i;
+
+    for (i = 0; i < numServices; i++)
+    {
+        simService_t *pService = &services[i];
+
+        if ((handle >= pService->pAttrs[0].handle) &&
+            (handle < pService->pAttrs[0].handle + pService->numAttrs))
+        {
+            *ppService = pService;
+
+            return &pService->pAttrs[handle - pService->pAttrs[0].handle];
+        }
+    }
+
+    return NULL;
+}
+
+// 16-bit UUID of an attribute type, 0 for 128-bit UUIDs
+static uint16 SimBle_uuid(const gattAttrType_t *pType)
+{
+    if (pType->len == ATT_BT_UUID_SIZE)
+    {
+        return BUILD_UINT16(pType->uuid[0], pType->uuid[1]);
+    }
+
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      SimBle_read
+ *
+ * @brief   Read an attribute as the central would with a Read Request.
+ *
+ * @param   handle - attribute handle
+ * @param   pValue - buffer of ATT_MTU_SIZE - 1 octets
+ * @param   pLen - length read
+ *
+ * @return  SUCCESS or the ATT error code
+ */
+uint8_t SimBle_read(uint16_t handle, uint8_t *pValue, uint16_t *pLen)
+{
+    simService_t *pService;
+    gattAttribute_t *pAttr = SimBle_findAttr(handle, &pService);
+    uint16 uuid;
+
+    if (pAttr == NULL)
+    {
+        return ATT_ERR_INVALID_HANDLE;
+    }
+
+    uuid = SimBle_uuid(&pAttr->type);
+
+    // Declarations are read by the stack itself
+    if (uuid == GATT_PRIMARY_SERVICE_UUID)
+    {
+        const gattAttrType_t *pSvc = (const gattAttrType_t *)pAttr->pValue;
+
+        memcpy(pValue, pSvc->uuid, pSvc->len);
+        *pLen = pSvc->len;
+
+        return SUCCESS;
+    }
+    else if (uuid == GATT_CHARACTER_UUID)
+    {
+        gattAttribute_t *pChar = pAttr + 1;
+
+        pValue[0] = *pAttr->pValue;
+        pValue[1] = LO_UINT16(pChar->handle);
+        pValue[2] = HI_UINT16(pChar->handle);
+        memcpy(&pValue[3], pChar->type.uuid, pChar->type.len);
+        *pLen = 3 + pChar->type.len;
+
+        return SUCCESS;
+    }
+
+    if (!(pAttr->permissions & (GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_READ |
+                                GATT_PERMIT_AUTHEN_READ)))
+    {
+        return ATT_ERR_READ_NOT_PERMITTED;
+    }
+
+    if ((pAttr->permissions & (GATT_PERMIT_ENCRYPT_READ |
+                               GATT_PERMIT_AUTHEN_READ)) && !encrypted)
+    {
+        return ATT_ERR_INSUFFICIENT_AUTHEN;
+    }
+
+    *pLen = 0;
+
+    return pService->pCBs->pfnReadAttrCB(connHandle, pAttr, pValue, pLen, 0,
+                                         ATT_MTU_SIZE - 1, ATT_READ_REQ);
+}
+
+/*********************************************************************
+ * @fn      SimBle_write
+ *
+ * @brief   Write an attribute as the central would with a Write Request.
+ *
+ * @param   handle - attribute handle
+ * @param   pValue - value to write
+ * @param   len - length of the value
+ *
+ * @return  SUCCESS or the ATT error code
+ */
+uint8_t SimBle_write(uint16_t handle, const uint8_t *pValue, uint16_t len)
+{
+    simService_t *pService;
+    gattAttribute_t *pAttr = SimBle_findAttr(handle, &pService);
+    uint8 value[ATT_MTU_SIZE];
+
+    if (pAttr == NULL)
+    {
+        return ATT_ERR_INVALID_HANDLE;
+    }
+
+    if (!(pAttr->permissions & (GATT_PERMIT_WRITE | GATT_PERMIT_ENCRYPT_WRITE |
+                                GATT_PERMIT_AUTHEN_WRITE)))
+    {
+        return ATT_ERR_WRITE_NOT_PERMITTED;
+    }
+
+    if ((pAttr->permissions & (GATT_PERMIT_ENCRYPT_WRITE |
+                               GATT_PERMIT_AUTHEN_WRITE)) && !encrypted)
+    {
+        return ATT_ERR_INSUFFICIENT_AUTHEN;
+    }
+
+    if (len > ATT_MTU_SIZE - 3)
+    {
+        return ATT_ERR_INVALID_VALUE_SIZE;
+    }
+
+    // The stack passes its own copy of the PDU
+    memcpy(value, pValue, len);
+
+    return pService->pCBs->pfnWriteAttrCB(connHandle, pAttr, value, len, 0,
+                                          ATT_WRITE_REQ);
+}
+
+/*********************************************************************
+ * @fn      SimBle_enableNotifications
+ *
+ * @brief   Write every Client Characteristic Configuration descriptor, with
+ *          notifications or indications as the characteristic supports.
+ *
+ * @return  Number of descriptors enabled
+ */
+uint8_t SimBle_enableNotifications(void)
+{
+    uint8 count = 0;
+    uint8 i;
+
+    for (i = 0; i < numServices; i++)
+    {
+        simService_t *pService = &services[i];
+        uint8 props = 0;
+        uint16 j;
+
+        for (j = 0; j < pService->numAttrs; j++)
+        {
+            gattAttribute_t *pAttr = &pService->pAttrs[j];
+            uint16 uuid = SimBle_uuid(&pAttr->type);
+
+            if (uuid == GATT_CHARACTER_UUID)
+            {
+                props = *pAttr->pValue;
+            }
+            else if (uuid == GATT_CLIENT_CHAR_CFG_UUID)
+            {
+                uint8 cfg[2];
+
+                cfg[0] = (props & GATT_PROP_NOTIFY) ? GATT_CLIENT_CFG_NOTIFY :
+                                                      GATT_CLIENT_CFG_INDICATE;
+                cfg[1] = 0;
+
+                if (SimBle_write(pAttr->handle, cfg, sizeof(cfg)) == SUCCESS)
+                {
+                    count++;
+                }
+            }
+        }
+    }
+
+    SimRtos_log(SIM_LOG_EVENT, "gatt  %u CCCDs enabled", count);
+
+    return count;
+}
+
+/*********************************************************************
+ * @fn      SimBle_dumpAttributes
+ *
+ * @brief   Print the attribute tables registered by the services.
+ *
+ * @return  none
+ */
+void SimBle_dumpAttributes(void)
+{
+    uint8 i;
+
+    for (i = 0; i < numServices; i++)
+    {
+        simService_t *pService = &services[i];
+        uint16 j;
+
+        for (j = 0; j < pService->numAttrs; j++)
+        {
+            gattAttribute_t *pAttr = &pService->pAttrs[j];
+            uint16 uuid = SimBle_uuid(&pAttr->type);
+
+            if (uuid != 0)
+            {
+                printf("0x%04x  uuid 0x%04x  perm 0x%02x\n", pAttr->handle,
+                       uuid, pAttr->permissions);
+            }
+            else
+            {
+                printf("0x%04x  uuid 128-bit  perm 0x%02x\n", pAttr->handle,
+                       pAttr->permissions);
+            }
+        }
+    }
+}
+
+void SimBle_setNotiSink(simNotiSink_t sink)
+{
+    notiSink = (sink != NULL) ? sink : SimBle_logNoti;
+}
+
+void SimBle_setNotiTap(simNotiTap_t tap)
+{
+    notiTap = tap;
+}
+
+void SimBle_setLinkObserver(simLinkObserver_t observer)
+{
+    linkObserver = observer;
+}
+
+/*********************************************************************
+ * @fn      SimBle_getAttrUuid
+ *
+ * @brief   16-bit UUID of an attribute.
+ *
+ * @param   handle - attribute handle
+ *
+ * @return  UUID, 0 for unknown handles and 128-bit UUIDs
+ */
+uint16_t SimBle_getAttrUuid(uint16_t handle)
+{
+    simService_t *pService;
+    gattAttribute_t *pAttr = SimBle_findAttr(handle, &pService);
+
+    return pAttr ? SimBle_uuid(&pAttr->type) : 0;
+}
+
+/*********************************************************************
+ * @fn      SimBle_getAttr
+ *
+ * @brief   Attribute of a handle and the callbacks of its service, for
+ *          calling the callbacks directly.
+ *
+ * @param   handle - attribute handle
+ * @param   ppCBs - callbacks of the service
+ *
+ * @return  Attribute, NULL if not found
+ */
+gattAttribute_t *SimBle_getAttr(uint16_t handle, const gattServiceCBs_t **ppCBs)
+{
+    simService_t *pService;
+    gattAttribute_t *pAttr = SimBle_findAttr(handle, &pService);
+
+    if (pAttr)
+    {
+        *ppCBs = pService->pCBs;
+    }
+
+    return pAttr;
+}
+
+// Last handle in use
+uint16_t SimBle_getLastHandle(void)
+{
+    return nextHandle - 1;
+}
+
+uint16_t SimBle_getLinkLoss(void)
+{
+    return linkLossPermille;
+}
+
+/*********************************************************************
+ * @fn      SimBle_printStats
+ *
+ * @brief   Print the notification counts per handle and the heap usage.
+ *
+ * @return  none
+ */
+void SimBle_printStats(void)
+{
+    uint8 i;
+
+    for (i = 0; (i < SIM_MAX_NOTI_HANDLES) && (notiCount[i].count > 0); i++)
+    {
+        printf("notifications 0x%04x: %u\n", notiCount[i].handle,
+               notiCount[i].count);
+    }
+
+    printf("notifications rejected: %u\n", notiRejected);
+    printf("heap: peak %zu of %u, %u failed allocations\n", heapPeak,
+           SIM_HEAP_SIZE, heapFailures);
+}
+
+/*********************************************************************
+ * GAPROLE
+ */
+
+/*********************************************************************
+ * @fn      SimBle_setState
+ *
+ * @brief   Change the GAPRole state and tell the profile.
+ *
+ * @param   newState - new state
+ *
+ * @return  none
+ */
+static void SimBle_setState(gaprole_States_t newState)
+{
+    static const char *const stateNames[] =
+    {
+        "init", "started", "advertising", "advertising nonconn", "waiting",
+        "waiting after timeout", "connected", "connected advertising"
+    };
+
+    gapState = newState;
+    SimRtos_log(SIM_LOG_EVENT, "gap   %s", stateNames[newState]);
+
+    if (pGapRoleCBs && pGapRoleCBs->pfnStateChange)
+    {
+        pGapRoleCBs->pfnStateChange(newState);
+    }
+}
+
+// Deferred state change of the GAPRole task
+static void SimBle_deferState(uintptr_t arg)
+{
+    gaprole_States_t newState = (gaprole_States_t)arg;
+
+    if (newState == GAPROLE_ADVERTISING)
+    {
+        // Advertising may have been disabled or a link established since
+        if (!advEnabled || connected || (gapState == GAPROLE_ADVERTISING))
+        {
+            return;
+        }
+    }
+    else if ((newState == GAPROLE_WAITING) && (gapState != GAPROLE_ADVERTISING))
+    {
+        return;
+    }
+
+    SimBle_setState(newState);
+}
+
+bStatus_t GAPRole_StartDevice(gapRolesCBs_t *pAppCallbacks)
+{
+    if (gapState != GAPROLE_INIT)
+    {
+        return bleAlreadyInRequestedMode;
+    }
+
+    pGapRoleCBs = pAppCallbacks;
+
+    SimRtos_defer(0, SimBle_deferState, GAPROLE_STARTED);
+    SimRtos_defer(0, SimBle_deferState, GAPROLE_ADVERTISING);
+
+    return SUCCESS;
+}
+
+bStatus_t GAPRole_SetParameter(uint16_t param, uint8_t len, void *pValue)
+{
+    switch (param)
+    {
+        case GAPROLE_ADVERT_ENABLED:
+            advEnabled = *(uint8 *)pValue;
+
+            if (gapState != GAPROLE_INIT)
+            {
+                SimRtos_defer(0, SimBle_deferState, advEnabled ?
+                              GAPROLE_ADVERTISING : GAPROLE_WAITING);
+            }
+        break;
+
+        case GAPROLE_ADV_FILTER_POLICY:
+            advFilterPolicy = *(uint8 *)pValue;
+        break;
+
+        case GAPROLE_PARAM_UPDATE_ENABLE:
+            paramUpdateEnable = *(uint8 *)pValue;
+        break;
+
+        case GAPROLE_MIN_CONN_INTERVAL:
+            desiredParams.minConnInterval = *(uint16 *)pValue;
+        break;
+
+        case GAPROLE_MAX_CONN_INTERVAL:
+            desiredParams.maxConnInterval = *(uint16 *)pValue;
+        break;
+
+        case GAPROLE_SLAVE_LATENCY:
+            desiredParams.slaveLatency = *(uint16 *)pValue;
+        break;
+
+        case GAPROLE_TIMEOUT_MULTIPLIER:
+            desiredParams.timeoutMultiplier = *(uint16 *)pValue;
+        break;
+
+        case GAPROLE_PARAM_UPDATE_REQ:
+            if (!connected)
+            {
+                return bleNotConnected;
+            }
+            else
+            {
+                ladderActive = TRUE;
+                SimBle_requestLadder();
+            }
+        break;
+
+        default:
+            // Advertising data and timing have no effect on the simulation
+        break;
+    }
+
+    return SUCCESS;
+}
+
+bStatus_t GAPRole_GetParameter(uint16_t param, void *pValue)
+{
+    switch (param)
+    {
+        case GAPROLE_ADVERT_ENABLED:
+            *(uint8 *)pValue = advEnabled;
+        break;
+
+        case GAPROLE_ADV_FILTER_POLICY:
+            *(uint8 *)pValue = advFilterPolicy;
+        break;
+
+        case GAPROLE_CONNHANDLE:
+            *(uint16 *)pValue = connHandle;
+        break;
+
+        case GAPROLE_CONN_INTERVAL:
+            *(uint16 *)pValue = connInterval;
+        break;
+
+        case GAPROLE_CONN_LATENCY:
+            *(uint16 *)pValue = connLatency;
+        break;
+
+        case GAPROLE_CONN_TIMEOUT:
+            *(uint16 *)pValue = connTimeout;
+        break;
+
+        case GAPROLE_STATE:
+            *(uint8 *)pValue = gapState;
+        break;
+
+        case GAPROLE_CONN_TERM_REASON:
+            *(uint8 *)pValue = termReason;
+        break;
+
+        default:
+            return INVALIDPARAMETER;
+    }
+
+    return SUCCESS;
+}
+
+bStatus_t GAPRole_TerminateConnection(void)
+{
+    if (!connected)
+    {
+        return bleIncorrectMode;
+    }
+
+    SimRtos_defer(0, SimBle_terminate, SIM_TERM_LOCAL_HOST);
+
+    return SUCCESS;
+}
+
+bStatus_t GAPRole_SendUpdateParam(uint16_t minConnInterval,
+                                  uint16_t maxConnInterval,
+                                  uint16_t latency, uint16_t connTimeout,
+                                  uint8_t handleFailure)
+{
+    if (!connected)
+    {
+        return bleNotConnected;
+    }
+
+    // An application set holds the ladder negotiation
+    ladderHeld = ladderActive;
+    ladderPending = FALSE;
+
+    SimBle_requestUpdate(minConnInterval, latency, connTimeout);
+
+    return SUCCESS;
+}
+
+bStatus_t GAPRole_ResumeParamNegotiation(void)
+{
+    if (!connected || !ladderHeld)
+    {
+        return bleIncorrectMode;
+    }
+
+    ladderHeld = FALSE;
+    SimBle_requestLadder();
+
+    return SUCCESS;
+}
+
+void GAPRole_ForgetBondParams(uint8_t allBonds)
+{
+    // Every connection starts the negotiation at the first rung
+    SimRtos_log(SIM_LOG_EVENT, "gap   forget params of %s",
+                allBonds ? "all bonds" : "the bond");
+}
+
+bStatus_t GAPRole_SetParamUpdateLadder(const gapRoleConnParams_t *pParams,
+                                       uint8_t numRungs)
+{
+    if (numRungs == 0)
+    {
+        return bleInvalidRange;
+    }
+
+    // The simulated central accepts or refuses every request, so only
+    // the first rung is ever requested
+    pLadder = pParams;
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      SimBle_requestLadder
+ *
+ * @brief   Request the first ladder rung, or the desired parameters
+ *          without a ladder. The negotiation ends once it is accepted.
+ *
+ * @return  none
+ */
+static void SimBle_requestLadder(void)
+{
+    // The ladder replaces the single set of desired parameters
+    const gapRoleConnParams_t *pParams = pLadder ? pLadder : &desiredParams;
+
+    SimBle_requestUpdate(pParams->minConnInterval, pParams->slaveLatency,
+                         pParams->timeoutMultiplier);
+    ladderPending = acceptUpdates;
+}
+
+/*********************************************************************
+ * @fn      SimBle_requestUpdate
+ *
+ * @brief   Connection parameter update request sent to the central.
+ *
+ * @param   minInterval - connection interval granted when accepted
+ * @param   latency - slave latency
+ * @param   timeout - supervision timeout
+ *
+ * @return  none
+ */
+static void SimBle_requestUpdate(uint16 minInterval, uint16 latency,
+                                 uint16 timeout)
+{
+    SimRtos_log(SIM_LOG_EVENT, "gap   update request interval %u latency %u "
+                "timeout %u%s", minInterval, latency, timeout,
+                acceptUpdates ? "" : " refused");
+
+    if (acceptUpdates)
+    {
+        pendingParams.minConnInterval = minInterval;
+        pendingParams.slaveLatency = latency;
+        pendingParams.timeoutMultiplier = timeout;
+
+        SimRtos_defer(SIM_MS(SIM_PARAM_UPDATE_TIME), SimBle_applyUpdate, 0);
+    }
+}
+
+// The central applies the requested parameters
+static void SimBle_applyUpdate(uintptr_t arg)
+{
+    if (connected)
+    {
+        connInterval = pendingParams.minConnInterval;
+        connLatency = pendingParams.slaveLatency;
+        connTimeout = pendingParams.timeoutMultiplier;
+
+        if (ladderPending)
+        {
+            ladderActive = FALSE;
+            ladderPending = FALSE;
+        }
+
+        SimRtos_log(SIM_LOG_EVENT, "gap   params interval %u latency %u "
+                    "timeout %u", connInterval, connLatency, connTimeout);
+
+        if (linkObserver)
+        {
+            linkObserver(TRUE, connInterval, connLatency);
+        }
+    }
+}
+
+/*********************************************************************
+ * SIMULATED CENTRAL
+ */
+
+/*********************************************************************
+ * @fn      SimBle_connect
+ *
+ * @brief   Connect the central, the device has to be advertising.
+ *
+ * @param   interval - connection interval in 1.25 ms units
+ * @param   latency - slave latency
+ * @param   timeout - supervision timeout in 10 ms units
+ *
+ * @return  none
+ */
+void SimBle_connect(uint16_t interval, uint16_t latency, uint16_t timeout)
+{
+    if (gapState != GAPROLE_ADVERTISING)
+    {
+        SimRtos_log(SIM_LOG_EVENT, "sim   not advertising, connect ignored");
+
+        return;
+    }
+
+    connected = TRUE;
+    encrypted = FALSE;
+    connHandle = SIM_CONN_HANDLE;
+    connInterval = interval;
+    connLatency = latency;
+    connTimeout = timeout;
+    connStart = SimRtos_now();
+
+    if (linkObserver)
+    {
+        linkObserver(TRUE, connInterval, connLatency);
+    }
+
+    SimBle_setState(GAPROLE_CONNECTED);
+}
+
+/*********************************************************************
+ * @fn      SimBle_disconnect
+ *
+ * @brief   Drop the link, as on a supervision timeout.
+ *
+ * @return  none
+ */
+void SimBle_disconnect(void)
+{
+    SimBle_terminate(0x08);
+}
+
+// Link terminated with the given reason
+static void SimBle_terminate(uintptr_t arg)
+{
+    if (!connected)
+    {
+        return;
+    }
+
+    connected = FALSE;
+    encrypted = FALSE;
+    connHandle = INVALID_CONNHANDLE;
+    connInterval = 0;
+    connLatency = 0;
+    connTimeout = 0;
+    termReason = (uint8)arg;
+    ladderActive = FALSE;
+    ladderHeld = FALSE;
+    ladderPending = FALSE;
+
+    if (linkObserver)
+    {
+        linkObserver(FALSE, 0, 0);
+    }
+
+    SimBle_setState(GAPROLE_WAITING);
+
+    // Advertising resumes when still enabled
+    SimRtos_defer(0, SimBle_deferState, GAPROLE_ADVERTISING);
+}
+
+/*********************************************************************
+ * @fn      SimBle_pair
+ *
+ * @brief   Pair with the connected central. The first pairing creates a
+ *          bond, later ones only encrypt the link with it.
+ *
+ * @return  none
+ */
+void SimBle_pair(void)
+{
+    if (!connected || (pBondCBs == NULL))
+    {
+        return;
+    }
+
+    if (pBondCBs->pairStateCB)
+    {
+        pBondCBs->pairStateCB(connHandle, GAPBOND_PAIRING_STATE_STARTED,
+                              SUCCESS);
+    }
+
+    SimRtos_defer(SIM_MS(SIM_PAIRING_TIME), SimBle_pairDone, 0);
+}
+
+// Pairing complete or link encrypted with the bond
+static void SimBle_pairDone(uintptr_t arg)
+{
+    uint8 state;
+
+    if (!connected)
+    {
+        return;
+    }
+
+    encrypted = TRUE;
+
+    if (bondCount > 0)
+    {
+        state = GAPBOND_PAIRING_STATE_BONDED;
+    }
+    else
+    {
+        bondCount = 1;
+        state = GAPBOND_PAIRING_STATE_COMPLETE;
+    }
+
+    SimRtos_log(SIM_LOG_EVENT, "bond  %s", (state == GAPBOND_PAIRING_STATE_BONDED) ?
+                "bonded" : "paired");
+
+    if (pBondCBs->pairStateCB)
+    {
+        pBondCBs->pairStateCB(connHandle, state, SUCCESS);
+    }
+}
+
+void SimBle_acceptParamUpdates(bool accept)
+{
+    acceptUpdates = accept;
+}
+
+void SimBle_setLink(int8_t rssi, uint16_t lossPermille)
+{
+    linkRssi = rssi;
+    linkLossPermille = MIN(lossPermille, 1000);
+}
+
+/*********************************************************************
+ * GAP BOND MANAGER
+ */
+
+void GAPBondMgr_Register(gapBondCBs_t *pCB)
+{
+    pBondCBs = pCB;
+}
+
+bStatus_t GAPBondMgr_SetParameter(uint16 param, uint8 len, void *pValue)
+{
+    if (param == GAPBOND_ERASE_ALLBONDS)
+    {
+        bondCount = 0;
+        SimRtos_log(SIM_LOG_EVENT, "bond  erased");
+    }
+
+    return SUCCESS;
+}
+
+bStatus_t GAPBondMgr_GetParameter(uint16 param, void *pValue)
+{
+    if (param == GAPBOND_BOND_COUNT)
+    {
+        *(uint8 *)pValue = bondCount;
+
+        return SUCCESS;
+    }
+
+    return INVALIDPARAMETER;
+}
+
+bStatus_t GAPBondMgr_ServiceChangeInd(uint16 connectionHandle, uint8 setParam)
+{
+    if (bondCount == 0)
+    {
+        return bleNoResources;
+    }
+
+    SimRtos_log(SIM_LOG_EVENT, "bond  service changed %s",
+                setParam ? "set" : "cleared");
+
+    return SUCCESS;
+}
+
+bStatus_t GAPBondMgr_PasscodeRsp(uint16 connectionHandle, uint8 status,
+                                 uint32 passcode)
+{
+    return SUCCESS;
+}
+
+/*********************************************************************
+*********************************************************************/
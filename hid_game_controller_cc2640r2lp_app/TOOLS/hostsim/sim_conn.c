@@ -0,0 +1,633 @@
+/******************************************************************************
+
+ @file       sim_conn.c
+
+ @brief This file contains the connection timing model of the host
+        simulation. Notifications accepted by GATT_Notification wait in the
+        link layer TX buffers for the next connection event the peripheral
+        attends. Events are skipped as slave latency allows while nothing
+        is pending, a lost packet is sent again at the next event.
+
+        Every input from the script is timed from its change to the
+        notification call and to the delivery at the central of the first
+        changed HID report that follows it. The radio-on time of the
+        attended events gives the duty cycle.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Connection event timing model with latency and
+                        radio duty cycle statistics for the host simulation.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+#include "gatt_profile_uuid.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Link layer TX data buffers
+#ifndef SIM_CONN_TX_BUFS
+#define SIM_CONN_TX_BUFS                5
+#endif
+
+// Packets the peripheral sends per connection event
+#ifndef SIM_CONN_MAX_PKTS
+#define SIM_CONN_MAX_PKTS               4
+#endif
+
+// Radio-on time of an event besides the packets: ramp-up, synthesizer
+// calibration and receive window widening
+#ifndef SIM_CONN_EVENT_OVERHEAD_US
+#define SIM_CONN_EVENT_OVERHEAD_US      400
+#endif
+
+// Seed of the packet loss generator
+#ifndef SIM_CONN_SEED
+#define SIM_CONN_SEED                   0x2640
+#endif
+
+// 1M PHY: 8 us per octet, 150 us between packets
+#define SIM_LL_US_PER_OCTET             8
+#define SIM_LL_T_IFS_US                 150
+
+// Preamble, access address, header and CRC of every packet
+#define SIM_LL_EMPTY_OCTETS             10
+
+// L2CAP header and ATT opcode and handle in front of the value
+#define SIM_LL_NOTI_OCTETS              (4 + 3)
+
+// Inputs timed at the same time
+#define SIM_CONN_MAX_INPUTS             16
+
+// Handles whose last notified value is remembered
+#define SIM_CONN_MAX_HANDLES            8
+
+// Value octets of a notification
+#define SIM_CONN_MAX_LEN                (ATT_MTU_SIZE - 3)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Notification waiting in the TX buffers
+typedef struct
+{
+    uint64_t sentUs;                         // GATT_Notification call
+    uint16_t handle;
+    uint8_t len;
+    uint8_t value[SIM_CONN_MAX_LEN];
+    uint8_t numInputs;                       // Inputs this report carries
+    uint64_t inputUs[SIM_CONN_MAX_INPUTS];
+} simConnPkt_t;
+
+// Last value notified on a handle
+typedef struct
+{
+    uint16_t handle;
+    uint8_t len;
+    uint8_t value[SIM_CONN_MAX_LEN];
+} simConnLast_t;
+
+// Latency samples in microseconds
+typedef struct
+{
+    const char *pName;
+    uint32_t num;
+    uint32_t size;
+    uint32_t *pUs;
+} simConnStat_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static bool enabled = FALSE;
+
+// Link
+static bool connected = FALSE;
+static uint16_t interval = 0;
+static uint16_t latency = 0;
+static uintptr_t generation = 0;   // Invalidates the scheduled events
+static uint16_t eventsSkipped = 0;
+static uint32_t lossState = SIM_CONN_SEED;
+
+// TX buffers
+static simConnPkt_t txBuf[SIM_CONN_TX_BUFS];
+static uint8_t txHead = 0;
+static uint8_t txCount = 0;
+
+// Inputs not yet carried by a report
+static uint64_t pendingUs[SIM_CONN_MAX_INPUTS];
+static uint8_t numPending = 0;
+
+static simConnLast_t lastValue[SIM_CONN_MAX_HANDLES];
+
+// Statistics
+static simConnStat_t statApp = { "input to notification" };
+static simConnStat_t statLink = { "notification to host" };
+static simConnStat_t statTotal = { "input to host" };
+static uint32_t numSent = 0;
+static uint32_t numDelivered = 0;
+static uint32_t numBufferFull = 0;
+static uint32_t numDropped = 0;
+static uint32_t numRetransmit = 0;
+static uint32_t numInputs = 0;
+static uint32_t numEvents = 0;
+static uint32_t numAttended = 0;
+static uint64_t radioOnUs = 0;
+static uint64_t connectedUs = 0;
+static uint64_t connectedSince = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8_t SimConn_sink(const simNoti_t *pNoti);
+static void SimConn_linkChange(bool isConnected, uint16_t connInterval,
+                               uint16_t connLatency);
+static void SimConn_event(uintptr_t arg);
+
+/*********************************************************************
+ * @fn      SimConn_nowUs
+ *
+ * @brief   Current virtual time in microseconds.
+ */
+static uint64_t SimConn_nowUs(void)
+{
+    return SimRtos_now() * Clock_tickPeriod;
+}
+
+/*********************************************************************
+ * @fn      SimConn_statAdd
+ *
+ * @brief   Add a latency sample.
+ *
+ * @param   pStat - statistic
+ * @param   us - latency in microseconds
+ *
+ * @return  none
+ */
+static void SimConn_statAdd(simConnStat_t *pStat, uint64_t us)
+{
+    if (pStat->num == pStat->size)
+    {
+        pStat->size = pStat->size ? 2 * pStat->size : 256;
+        pStat->pUs = realloc(pStat->pUs, pStat->size * sizeof(uint32_t));
+    }
+
+    pStat->pUs[pStat->num++] = (uint32_t)us;
+}
+
+static int SimConn_compareUs(const void *pA, const void *pB)
+{
+    uint32_t a = *(const uint32_t *)pA;
+    uint32_t b = *(const uint32_t *)pB;
+
+    return (a > b) - (a < b);
+}
+
+/*********************************************************************
+ * @fn      SimConn_statPct
+ *
+ * @brief   Percentile of a latency statistic.
+ *
+ * @param   pStat - statistic
+ * @param   pct - percentile, 0 to 100
+ *
+ * @return  Latency in microseconds, 0 without samples
+ */
+static uint32_t SimConn_statPct(simConnStat_t *pStat, uint8_t pct)
+{
+    if (pStat->num == 0)
+    {
+        return 0;
+    }
+
+    qsort(pStat->pUs, pStat->num, sizeof(uint32_t), SimConn_compareUs);
+
+    return pStat->pUs[((pStat->num - 1) * pct) / 100];
+}
+
+/*********************************************************************
+ * @fn      SimConn_statPrint
+ *
+ * @brief   Print the distribution of a latency statistic in ms.
+ *
+ * @param   pStat - statistic
+ *
+ * @return  none
+ */
+static void SimConn_statPrint(simConnStat_t *pStat)
+{
+    uint64_t sum = 0;
+    uint32_t i;
+
+    if (pStat->num == 0)
+    {
+        printf("%-22s  n 0\n", pStat->pName);
+        return;
+    }
+
+    qsort(pStat->pUs, pStat->num, sizeof(uint32_t), SimConn_compareUs);
+
+    for (i = 0; i < pStat->num; i++)
+    {
+        sum += pStat->pUs[i];
+    }
+
+#define SIM_PCT(q)  (pStat->pUs[((pStat->num - 1) * (q)) / 100] / 1000.0)
+
+    printf("%-22s  n %u  min %.2f  mean %.2f  p50 %.2f  p90 %.2f  "
+           "p99 %.2f  max %.2f ms\n", pStat->pName, pStat->num,
+           pStat->pUs[0] / 1000.0, (double)sum / pStat->num / 1000.0,
+           SIM_PCT(50), SIM_PCT(90), SIM_PCT(99),
+           pStat->pUs[pStat->num - 1] / 1000.0);
+
+#undef SIM_PCT
+}
+
+/*********************************************************************
+ * @fn      SimConn_enable
+ *
+ * @brief   Put the timing model between GATT_Notification and the central.
+ *
+ * @return  none
+ */
+void SimConn_enable(void)
+{
+    enabled = TRUE;
+
+    SimBle_setNotiSink(SimConn_sink);
+    SimBle_setLinkObserver(SimConn_linkChange);
+}
+
+/*********************************************************************
+ * @fn      SimConn_input
+ *
+ * @brief   Mark an input change, timed until a report carries it.
+ *
+ * @return  none
+ */
+void SimConn_input(void)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    numInputs++;
+
+    if (numPending == SIM_CONN_MAX_INPUTS)
+    {
+        // Drop the oldest, it is not going to be reported anymore
+        memmove(&pendingUs[0], &pendingUs[1],
+                (SIM_CONN_MAX_INPUTS - 1) * sizeof(uint64_t));
+        numPending--;
+    }
+
+    pendingUs[numPending++] = SimConn_nowUs();
+}
+
+/*********************************************************************
+ * @fn      SimConn_isNewReport
+ *
+ * @brief   Check whether a notification is a HID input report with a
+ *          value different from the last one on its handle.
+ *
+ * @param   pNoti - notification
+ *
+ * @return  TRUE for a changed input report
+ */
+static bool SimConn_isNewReport(const simNoti_t *pNoti)
+{
+    uint16_t uuid = SimBle_getAttrUuid(pNoti->handle);
+    simConnLast_t *pLast = NULL;
+    uint8_t i;
+
+    if ((uuid != REPORT_UUID) && (uuid != BOOT_KEY_INPUT_UUID) &&
+        (uuid != BOOT_MOUSE_INPUT_UUID))
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < SIM_CONN_MAX_HANDLES; i++)
+    {
+        if ((lastValue[i].handle == pNoti->handle) || (lastValue[i].handle == 0))
+        {
+            pLast = &lastValue[i];
+            break;
+        }
+    }
+
+    if ((pLast == NULL) || ((pLast->handle == pNoti->handle) &&
+                            (pLast->len == pNoti->len) &&
+                            (memcmp(pLast->value, pNoti->pValue, pNoti->len) == 0)))
+    {
+        return FALSE;
+    }
+
+    pLast->handle = pNoti->handle;
+    pLast->len = (uint8_t)pNoti->len;
+    memcpy(pLast->value, pNoti->pValue, pNoti->len);
+
+    return TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimConn_sink
+ *
+ * @brief   Take a notification into the TX buffers.
+ *
+ * @param   pNoti - notification
+ *
+ * @return  SUCCESS, MSG_BUFFER_NOT_AVAIL when the buffers are full
+ */
+static uint8_t SimConn_sink(const simNoti_t *pNoti)
+{
+    simConnPkt_t *pPkt;
+    uint64_t nowUs = SimConn_nowUs();
+    uint8_t i;
+
+    if (txCount == SIM_CONN_TX_BUFS)
+    {
+        numBufferFull++;
+        SimRtos_log(SIM_LOG_NOTI, "noti  0x%04x buffers full", pNoti->handle);
+
+        return MSG_BUFFER_NOT_AVAIL;
+    }
+
+    pPkt = &txBuf[(txHead + txCount) % SIM_CONN_TX_BUFS];
+    txCount++;
+    numSent++;
+
+    pPkt->sentUs = nowUs;
+    pPkt->handle = pNoti->handle;
+    pPkt->len = (uint8_t)MIN(pNoti->len, SIM_CONN_MAX_LEN);
+    memcpy(pPkt->value, pNoti->pValue, pPkt->len);
+    pPkt->numInputs = 0;
+
+    // The report carries every input changed since the last one
+    if ((numPending > 0) && SimConn_isNewReport(pNoti))
+    {
+        for (i = 0; i < numPending; i++)
+        {
+            SimConn_statAdd(&statApp, nowUs - pendingUs[i]);
+            pPkt->inputUs[i] = pendingUs[i];
+        }
+
+        pPkt->numInputs = numPending;
+        numPending = 0;
+    }
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      SimConn_deliver
+ *
+ * @brief   The central received the packet at the head of the buffers.
+ *
+ * @param   atUs - time of the reception
+ *
+ * @return  none
+ */
+static void SimConn_deliver(uint64_t atUs)
+{
+    simConnPkt_t *pPkt = &txBuf[txHead];
+    char hex[3 * SIM_CONN_MAX_LEN + 1];
+    uint8_t i;
+
+    for (i = 0; i < pPkt->len; i++)
+    {
+        sprintf(&hex[3 * i], " %02x", pPkt->value[i]);
+    }
+    hex[3 * i] = '\0';
+
+    SimRtos_log(SIM_LOG_NOTI, "host  0x%04x%s  +%.2f ms", pPkt->handle, hex,
+                (atUs - pPkt->sentUs) / 1000.0);
+
+    SimConn_statAdd(&statLink, atUs - pPkt->sentUs);
+
+    for (i = 0; i < pPkt->numInputs; i++)
+    {
+        SimConn_statAdd(&statTotal, atUs - pPkt->inputUs[i]);
+    }
+
+    numDelivered++;
+    txHead = (txHead + 1) % SIM_CONN_TX_BUFS;
+    txCount--;
+}
+
+/*********************************************************************
+ * @fn      SimConn_lost
+ *
+ * @brief   Draw whether the next packet is lost, at the link loss rate
+ *          set by the script.
+ *
+ * @return  TRUE when lost
+ */
+static bool SimConn_lost(void)
+{
+    // xorshift32, the same sequence on every run
+    lossState ^= lossState << 13;
+    lossState ^= lossState >> 17;
+    lossState ^= lossState << 5;
+
+    return ((lossState % 1000) < SimBle_getLinkLoss());
+}
+
+/*********************************************************************
+ * @fn      SimConn_event
+ *
+ * @brief   Connection event. The peripheral attends it when it has data
+ *          or has skipped as many events as the slave latency allows.
+ *
+ * @param   arg - generation the event was scheduled in
+ *
+ * @return  none
+ */
+static void SimConn_event(uintptr_t arg)
+{
+    uint64_t anchorUs = SimConn_nowUs();
+    uint32_t offsetUs;
+    uint8_t numPkts = 0;
+
+    if (arg != generation)
+    {
+        return;
+    }
+
+    numEvents++;
+
+    if ((txCount > 0) || (eventsSkipped >= latency))
+    {
+        numAttended++;
+        eventsSkipped = 0;
+        offsetUs = SIM_CONN_EVENT_OVERHEAD_US;
+
+        for (;;)
+        {
+            uint16_t slaveOctets = SIM_LL_EMPTY_OCTETS;
+
+            if (txCount > 0)
+            {
+                slaveOctets += SIM_LL_NOTI_OCTETS + txBuf[txHead].len;
+            }
+
+            // Empty packet of the central, then the peripheral's answer
+            offsetUs += (SIM_LL_EMPTY_OCTETS + slaveOctets) *
+                        SIM_LL_US_PER_OCTET + 2 * SIM_LL_T_IFS_US;
+
+            if (txCount == 0)
+            {
+                break;
+            }
+
+            // The event closes on a lost packet, it goes again next event
+            if (SimConn_lost())
+            {
+                numRetransmit++;
+                break;
+            }
+
+            SimConn_deliver(anchorUs + offsetUs);
+
+            if ((++numPkts == SIM_CONN_MAX_PKTS) || (txCount == 0))
+            {
+                break;
+            }
+        }
+
+        radioOnUs += offsetUs;
+    }
+    else
+    {
+        eventsSkipped++;
+    }
+
+    SimRtos_defer((uint64_t)interval * SIM_CONN_INTERVAL_TICKS, SimConn_event, generation);
+}
+
+/*********************************************************************
+ * @fn      SimConn_linkChange
+ *
+ * @brief   Restart the connection events on connection and parameter
+ *          update, drop the TX buffers on termination.
+ *
+ * @param   isConnected - link up
+ * @param   connInterval - connection interval in 1.25 ms units
+ * @param   connLatency - slave latency
+ *
+ * @return  none
+ */
+static void SimConn_linkChange(bool isConnected, uint16_t connInterval,
+                               uint16_t connLatency)
+{
+    generation++;
+
+    if (isConnected)
+    {
+        if (!connected)
+        {
+            connectedSince = SimConn_nowUs();
+        }
+
+        connected = TRUE;
+        interval = connInterval;
+        latency = connLatency;
+        eventsSkipped = 0;
+
+        SimRtos_defer((uint64_t)interval * SIM_CONN_INTERVAL_TICKS, SimConn_event, generation);
+    }
+    else if (connected)
+    {
+        connected = FALSE;
+        connectedUs += SimConn_nowUs() - connectedSince;
+
+        // Inputs carried by the dropped reports are never reported
+        numDropped += txCount;
+        txCount = 0;
+        memset(lastValue, 0, sizeof(lastValue));
+    }
+}
+
+/*********************************************************************
+ * @fn      SimConn_printStats
+ *
+ * @brief   Print the latency distributions, the link counters and the
+ *          radio duty cycle.
+ *
+ * @return  none
+ */
+void SimConn_printStats(void)
+{
+    uint64_t totalUs = connectedUs;
+
+    if (!enabled)
+    {
+        return;
+    }
+
+    if (connected)
+    {
+        totalUs += SimConn_nowUs() - connectedSince;
+    }
+
+    SimConn_statPrint(&statApp);
+    SimConn_statPrint(&statLink);
+    SimConn_statPrint(&statTotal);
+
+    printf("link: %u sent, %u delivered, %u buffers full, %u dropped at "
+           "disconnect, %u retransmissions\n", numSent, numDelivered,
+           numBufferFull, numDropped, numRetransmit);
+    printf("inputs: %u, %u reported, %u not reported\n", numInputs,
+           statTotal.num, numInputs - statTotal.num);
+    printf("radio: %u events, %u attended, on %.2f ms in %.2f ms connected, "
+           "duty cycle %.3f %%\n", numEvents, numAttended, radioOnUs / 1000.0,
+           totalUs / 1000.0, totalUs ? (100.0 * radioOnUs) / totalUs : 0.0);
+}
+
+/*********************************************************************
+ * @fn      SimConn_getStats
+ *
+ * @brief   Get the link counters, the input to host latency and the radio
+ *          time for a machine readable report.
+ *
+ * @param   pStats - counters
+ *
+ * @return  none
+ */
+void SimConn_getStats(simConnStats_t *pStats)
+{
+    pStats->sent = numSent;
+    pStats->delivered = numDelivered;
+    pStats->bufferFull = numBufferFull;
+    pStats->dropped = numDropped;
+    pStats->retransmit = numRetransmit;
+    pStats->inputs = numInputs;
+    pStats->reported = statTotal.num;
+    pStats->p50Us = SimConn_statPct(&statTotal, 50);
+    pStats->p99Us = SimConn_statPct(&statTotal, 99);
+    pStats->maxUs = SimConn_statPct(&statTotal, 100);
+    pStats->radioOnUs = radioOnUs;
+    pStats->connectedUs = connectedUs;
+
+    if (connected)
+    {
+        pStats->connectedUs += SimConn_nowUs() - connectedSince;
+    }
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,838 @@
+/******************************************************************************
+
+ @file       sim_io.c
+
+ @brief This file contains the driver side of the host simulation: PIN
+        levels and edge interrupts, ADC samples, PWM outputs, SPI transfers
+        into a model of the ST7735S LCD controller, the battery voltage and
+        the Display output. The scenario script sets the inputs.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Linux host simulation build of the application and
+                        HID profile against a shim of the RTOS, the BLE stack
+                        and the drivers.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sim.h"
+#include "board_key.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Joystick samples at rest
+#define SIM_ADC_X_CENTER                1534
+#define SIM_ADC_Y_CENTER                1555
+
+// Accelerometer samples lying flat, 0 g on X and Y and 1 g on Z
+#define SIM_ADC_ACCEL_ZERO_G            1572
+#define SIM_ADC_ACCEL_ONE_G             2201
+
+// Battery voltage at start
+#define SIM_BATTERY_DEFAULT_MV          3000
+
+// LCD panel, and its origin in the controller memory
+#define SIM_LCD_WIDTH                   128
+#define SIM_LCD_HEIGHT                  128
+#define SIM_LCD_X_OFFSET                2
+#define SIM_LCD_Y_OFFSET                3
+
+// ST7735S commands of the model, the others are taken and ignored
+#define SIM_LCD_CMD_SWRESET             0x01
+#define SIM_LCD_CMD_SLPOUT              0x11
+#define SIM_LCD_CMD_DISPOFF             0x28
+#define SIM_LCD_CMD_DISPON              0x29
+#define SIM_LCD_CMD_CASET               0x2A
+#define SIM_LCD_CMD_RASET               0x2B
+#define SIM_LCD_CMD_RAMWR               0x2C
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+struct ADC_Config_s
+{
+    uint8_t channel;
+};
+
+struct PWM_Config_s
+{
+    uint8_t index;
+    bool open;
+    bool running;
+    uint32_t duty;          // Duty of the running output, fraction
+    uint32_t period;        // Period, in Hz
+};
+
+struct SPI_Config_s
+{
+    uint8_t index;
+    bool open;
+    bool busy;
+    uint32_t bitRate;
+    SPI_CallbackFxn pfnCallback;
+    SPI_Transaction *pTrans;
+};
+
+// ST7735S controller: window, write position and the panel glass
+typedef struct
+{
+    bool awake;             // Out of sleep
+    bool on;                // Display on
+    uint8_t cmd;            // Last command
+    uint8_t argIdx;         // Argument bytes taken
+    uint8_t args[4];
+    uint16_t xs, xe, ys, ye;
+    uint16_t x, y;
+    uint8_t pixHi;          // First byte of a pixel
+    bool pixHalf;           // Waiting for the second byte
+    uint16_t glass[SIM_LCD_HEIGHT][SIM_LCD_WIDTH];
+
+    uint32_t transfers;     // SPI transfers to the LCD
+    uint32_t refused;       // Transfers refused, one in progress
+    uint32_t bytes;
+    uint32_t windows;       // RAMWR commands
+} simLcd_t;
+
+// Key to button pin mapping, the buttons are active low
+typedef struct
+{
+    uint8_t key;
+    PIN_Id pin;
+} simKeyPin_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// PIN
+static uint8_t pinLevel[SIM_NUM_PINS];
+static PIN_Config pinIrq[SIM_NUM_PINS];
+static PIN_State *pinOwner[SIM_NUM_PINS];
+
+static const simKeyPin_t keyPins[] =
+{
+    { KEY_SELECT, Board_BTN1 },
+    { KEY_START,  Board_BTN2 },
+    { KEY_Z,      EDUBP_MKII_BTN1 },
+    { KEY_X,      EDUBP_MKII_BTN2 },
+};
+
+// ADC
+static struct ADC_Config_s adcConfig[SIM_NUM_ADC];
+static bool adcOpen[SIM_NUM_ADC];
+static uint16_t adcValue[SIM_NUM_ADC];
+static bool ioInitialized = FALSE;
+
+// PWM
+static struct PWM_Config_s pwmConfig[SIM_NUM_PWM];
+
+// SPI
+static struct SPI_Config_s spiConfig[SIM_NUM_SPI];
+
+// LCD
+static simLcd_t lcd;
+
+// Battery
+static uint16_t batteryMv = SIM_BATTERY_DEFAULT_MV;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void SimIo_init(void);
+static void SimIo_setPin(PIN_Id pinId, uint8_t level);
+static void SimIo_logPwm(PWM_Handle handle);
+static void SimIo_spiDone(uintptr_t arg);
+static void SimIo_lcdReset(void);
+static void SimIo_lcdByte(uint8_t dc, uint8_t byte);
+
+/*********************************************************************
+ * @fn      SimIo_init
+ *
+ * @brief   Put the inputs in their rest state.
+ *
+ * @return  none
+ */
+static void SimIo_init(void)
+{
+    uint8_t i;
+
+    if (ioInitialized)
+    {
+        return;
+    }
+
+    for (i = 0; i < SIM_NUM_PINS; i++)
+    {
+        pinLevel[i] = 1;
+    }
+
+    for (i = 0; i < SIM_NUM_ADC; i++)
+    {
+        adcConfig[i].channel = i;
+    }
+
+    adcValue[Board_ADC0] = SIM_ADC_X_CENTER;
+    adcValue[Board_ADC5] = SIM_ADC_Y_CENTER;
+    adcValue[EDUBP_MKII_ACCEL_X_ADC] = SIM_ADC_ACCEL_ZERO_G;
+    adcValue[EDUBP_MKII_ACCEL_Y_ADC] = SIM_ADC_ACCEL_ZERO_G;
+    adcValue[EDUBP_MKII_ACCEL_Z_ADC] = SIM_ADC_ACCEL_ONE_G;
+
+    ioInitialized = TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimIo_setPin
+ *
+ * @brief   Drive an input pin, running its interrupt callback when the
+ *          change matches the configured edge.
+ *
+ * @param   pinId - pin
+ * @param   level - new level
+ *
+ * @return  none
+ */
+static void SimIo_setPin(PIN_Id pinId, uint8_t level)
+{
+    PIN_Config edge;
+
+    SimIo_init();
+
+    if (pinLevel[pinId] == level)
+    {
+        return;
+    }
+
+    pinLevel[pinId] = level;
+    edge = level ? PIN_IRQ_POSEDGE : PIN_IRQ_NEGEDGE;
+
+    if ((pinIrq[pinId] & edge) && pinOwner[pinId] && pinOwner[pinId]->pCb)
+    {
+        pinOwner[pinId]->pCb(pinOwner[pinId], pinId);
+    }
+}
+
+/*********************************************************************
+ * @fn      SimIo_setKeys
+ *
+ * @brief   Press the given keys and release the others.
+ *
+ * @param   keys - KEY_* mask of pressed keys
+ *
+ * @return  none
+ */
+void SimIo_setKeys(uint8_t keys)
+{
+    uint8_t i;
+
+    for (i = 0; i < sizeof(keyPins) / sizeof(keyPins[0]); i++)
+    {
+        SimIo_setPin(keyPins[i].pin, (keys & keyPins[i].key) ? 0 : 1);
+    }
+}
+
+void SimIo_setAdc(uint8_t channel, uint16_t value)
+{
+    SimIo_init();
+
+    if (channel < SIM_NUM_ADC)
+    {
+        adcValue[channel] = value;
+    }
+}
+
+void SimIo_setBattery(uint16_t mV)
+{
+    batteryMv = mV;
+}
+
+/*********************************************************************
+ * @fn      SimIo_display
+ *
+ * @brief   Display output of the application.
+ *
+ * @param   fmt - printf format
+ *
+ * @return  none
+ */
+void SimIo_display(const char *fmt, ...)
+{
+    char line[96];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+
+    SimRtos_log(SIM_LOG_DISPLAY, "disp  %s", line);
+}
+
+/*********************************************************************
+ * PIN
+ */
+
+PIN_Handle PIN_open(PIN_State *pState, const PIN_Config aPinList[])
+{
+    uint8_t i;
+
+    SimIo_init();
+
+    pState->pCb = NULL;
+
+    for (i = 0; PIN_ID(aPinList[i]) != PIN_TERMINATE; i++)
+    {
+        PIN_Id pinId = PIN_ID(aPinList[i]);
+
+        pinOwner[pinId] = pState;
+        pinIrq[pinId] = aPinList[i] & PIN_BM_IRQ;
+
+        if (aPinList[i] & PIN_GPIO_OUTPUT_EN)
+        {
+            PIN_setOutputValue(pState, pinId,
+                               (aPinList[i] & PIN_GPIO_HIGH) ? 1 : 0);
+        }
+    }
+
+    return pState;
+}
+
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb pCb)
+{
+    handle->pCb = pCb;
+
+    return 0;
+}
+
+int PIN_setConfig(PIN_Handle handle, PIN_Config bmMask, PIN_Config pinCfg)
+{
+    PIN_Id pinId = PIN_ID(pinCfg);
+
+    if (bmMask & PIN_BM_IRQ)
+    {
+        pinIrq[pinId] = pinCfg & PIN_BM_IRQ;
+    }
+
+    return 0;
+}
+
+uint32_t PIN_getInputValue(PIN_Id pinId)
+{
+    SimIo_init();
+
+    return pinLevel[pinId];
+}
+
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t val)
+{
+    SimIo_init();
+
+    pinLevel[pinId] = val ? 1 : 0;
+
+    // The LCD controller is held in reset while its pin is low
+    if ((pinId == EDUBP_MKII_LCD_RST) && !val)
+    {
+        SimIo_lcdReset();
+    }
+
+    return 0;
+}
+
+/*********************************************************************
+ * ADC
+ */
+
+void ADC_init(void)
+{
+    SimIo_init();
+}
+
+void ADC_Params_init(ADC_Params *pParams)
+{
+    pParams->custom = NULL;
+    pParams->isProtected = TRUE;
+}
+
+ADC_Handle ADC_open(uint_least8_t index, ADC_Params *pParams)
+{
+    if ((index >= SIM_NUM_ADC) || adcOpen[index])
+    {
+        return NULL;
+    }
+
+    adcOpen[index] = TRUE;
+
+    return &adcConfig[index];
+}
+
+void ADC_close(ADC_Handle handle)
+{
+    adcOpen[handle->channel] = FALSE;
+}
+
+int_fast16_t ADC_convert(ADC_Handle handle, uint16_t *pValue)
+{
+    *pValue = adcValue[handle->channel];
+
+    return ADC_STATUS_SUCCESS;
+}
+
+/*********************************************************************
+ * PWM
+ */
+
+/*********************************************************************
+ * @fn      SimIo_logPwm
+ *
+ * @brief   Log the duty of a PWM output, in percent, zero while stopped.
+ *
+ * @param   handle - PWM output
+ *
+ * @return  none
+ */
+static void SimIo_logPwm(PWM_Handle handle)
+{
+    uint32_t permille = handle->running ?
+        (uint32_t)(((uint64_t)handle->duty * 1000 + PWM_DUTY_FRACTION_MAX / 2) /
+                   PWM_DUTY_FRACTION_MAX) : 0;
+
+    SimRtos_log(SIM_LOG_PWM, "pwm   %u duty %u.%u %%", handle->index,
+                permille / 10, permille % 10);
+}
+
+void PWM_init(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < SIM_NUM_PWM; i++)
+    {
+        pwmConfig[i].index = i;
+    }
+}
+
+void PWM_Params_init(PWM_Params *pParams)
+{
+    pParams->periodUnits = PWM_PERIOD_HZ;
+    pParams->periodValue = 1000000;
+    pParams->dutyUnits = PWM_DUTY_FRACTION;
+    pParams->dutyValue = 0;
+    pParams->idleLevel = PWM_IDLE_LOW;
+    pParams->custom = NULL;
+}
+
+PWM_Handle PWM_open(uint_least8_t index, PWM_Params *pParams)
+{
+    if ((index >= SIM_NUM_PWM) || pwmConfig[index].open ||
+        (pParams->periodUnits != PWM_PERIOD_HZ) ||
+        (pParams->dutyUnits != PWM_DUTY_FRACTION))
+    {
+        return NULL;
+    }
+
+    pwmConfig[index].open = TRUE;
+    pwmConfig[index].running = FALSE;
+    pwmConfig[index].duty = pParams->dutyValue;
+    pwmConfig[index].period = pParams->periodValue;
+
+    return &pwmConfig[index];
+}
+
+void PWM_close(PWM_Handle handle)
+{
+    handle->open = FALSE;
+    handle->running = FALSE;
+}
+
+int_fast16_t PWM_setDuty(PWM_Handle handle, uint32_t duty)
+{
+    handle->duty = duty;
+
+    if (handle->running)
+    {
+        SimIo_logPwm(handle);
+    }
+
+    return PWM_STATUS_SUCCESS;
+}
+
+int_fast16_t PWM_setPeriod(PWM_Handle handle, uint32_t period)
+{
+    if (period != handle->period)
+    {
+        handle->period = period;
+        SimRtos_log(SIM_LOG_PWM, "pwm   %u period %u Hz", handle->index,
+                    (unsigned)period);
+    }
+
+    return PWM_STATUS_SUCCESS;
+}
+
+void PWM_start(PWM_Handle handle)
+{
+    handle->running = TRUE;
+    SimIo_logPwm(handle);
+}
+
+void PWM_stop(PWM_Handle handle)
+{
+    handle->running = FALSE;
+    SimIo_logPwm(handle);
+}
+
+/*********************************************************************
+ * SPI
+ */
+
+/*********************************************************************
+ * @fn      SimIo_spiDone
+ *
+ * @brief   End of a transfer, the driver callback runs like its hwi.
+ *
+ * @param   arg - SPI index
+ *
+ * @return  none
+ */
+static void SimIo_spiDone(uintptr_t arg)
+{
+    SPI_Handle handle = &spiConfig[arg];
+    SPI_Transaction *pTrans = handle->pTrans;
+
+    handle->busy = FALSE;
+    handle->pTrans = NULL;
+    pTrans->status = SPI_TRANSFER_COMPLETED;
+
+    if (handle->open)
+    {
+        handle->pfnCallback(handle, pTrans);
+    }
+}
+
+void SPI_init(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < SIM_NUM_SPI; i++)
+    {
+        spiConfig[i].index = i;
+    }
+}
+
+void SPI_Params_init(SPI_Params *pParams)
+{
+    pParams->transferMode = SPI_MODE_BLOCKING;
+    pParams->transferTimeout = SPI_WAIT_FOREVER;
+    pParams->transferCallbackFxn = NULL;
+    pParams->mode = SPI_MASTER;
+    pParams->bitRate = 1000000;
+    pParams->dataSize = 8;
+    pParams->frameFormat = SPI_POL0_PHA0;
+    pParams->custom = NULL;
+}
+
+SPI_Handle SPI_open(uint_least8_t index, SPI_Params *pParams)
+{
+    // Only the callback mode, a blocking transfer would stop virtual time
+    if ((index >= SIM_NUM_SPI) || spiConfig[index].open ||
+        (pParams->transferMode != SPI_MODE_CALLBACK) ||
+        (pParams->transferCallbackFxn == NULL) || (pParams->bitRate == 0))
+    {
+        return NULL;
+    }
+
+    spiConfig[index].open = TRUE;
+    spiConfig[index].bitRate = pParams->bitRate;
+    spiConfig[index].pfnCallback = pParams->transferCallbackFxn;
+
+    return &spiConfig[index];
+}
+
+void SPI_close(SPI_Handle handle)
+{
+    handle->open = FALSE;
+}
+
+bool SPI_transfer(SPI_Handle handle, SPI_Transaction *transaction)
+{
+    const uint8_t *pTx = transaction->txBuf;
+    uint64_t ticks;
+    size_t i;
+
+    if (handle->index == EDUBP_MKII_LCD_SPI)
+    {
+        lcd.transfers++;
+    }
+
+    if (!handle->open || handle->busy || (transaction->count == 0))
+    {
+        if (handle->index == EDUBP_MKII_LCD_SPI)
+        {
+            lcd.refused++;
+        }
+
+        transaction->status = SPI_TRANSFER_FAILED;
+
+        return FALSE;
+    }
+
+    // The controller takes the bytes while selected and out of reset
+    if ((handle->index == EDUBP_MKII_LCD_SPI) && (pTx != NULL) &&
+        !pinLevel[EDUBP_MKII_LCD_CS] && pinLevel[EDUBP_MKII_LCD_RST])
+    {
+        for (i = 0; i < transaction->count; i++)
+        {
+            SimIo_lcdByte(pinLevel[EDUBP_MKII_LCD_DC], pTx[i]);
+        }
+
+        lcd.bytes += transaction->count;
+    }
+
+    handle->busy = TRUE;
+    handle->pTrans = transaction;
+    transaction->status = SPI_TRANSFER_STARTED;
+
+    // Time on the wire, at least one tick
+    ticks = ((uint64_t)transaction->count * 8 * SIM_MS(1000) +
+             handle->bitRate - 1) / handle->bitRate;
+    SimRtos_defer(ticks ? ticks : 1, SimIo_spiDone, handle->index);
+
+    return TRUE;
+}
+
+void SPI_transferCancel(SPI_Handle handle)
+{
+}
+
+/*********************************************************************
+ * LCD
+ */
+
+/*********************************************************************
+ * @fn      SimIo_lcdReset
+ *
+ * @brief   Controller reset: asleep, display off. The glass keeps its
+ *          pixels, they are shown again after the next DISPON.
+ *
+ * @return  none
+ */
+static void SimIo_lcdReset(void)
+{
+    lcd.awake = FALSE;
+    lcd.on = FALSE;
+    lcd.cmd = 0;
+    lcd.pixHalf = FALSE;
+}
+
+/*********************************************************************
+ * @fn      SimIo_lcdByte
+ *
+ * @brief   Byte to the LCD controller: a command, or its argument or
+ *          pixel data. The controller memory is taken as the glass, with
+ *          the panel offsets, in the orientation the BoosterPack mounting
+ *          gives with its MADCTL.
+ *
+ * @param   dc - level of the data/command pin
+ * @param   byte - byte
+ *
+ * @return  none
+ */
+static void SimIo_lcdByte(uint8_t dc, uint8_t byte)
+{
+    if (!dc)
+    {
+        lcd.cmd = byte;
+        lcd.argIdx = 0;
+        lcd.pixHalf = FALSE;
+
+        switch (byte)
+        {
+            case SIM_LCD_CMD_SWRESET:
+                SimIo_lcdReset();
+                break;
+
+            case SIM_LCD_CMD_SLPOUT:
+                lcd.awake = TRUE;
+                break;
+
+            case SIM_LCD_CMD_DISPOFF:
+                lcd.on = FALSE;
+                break;
+
+            case SIM_LCD_CMD_DISPON:
+                lcd.on = TRUE;
+                break;
+
+            case SIM_LCD_CMD_RAMWR:
+                lcd.x = lcd.xs;
+                lcd.y = lcd.ys;
+                lcd.windows++;
+                SimRtos_log(SIM_LOG_LCD, "lcd   window x %u-%u y %u-%u",
+                            lcd.xs - SIM_LCD_X_OFFSET,
+                            lcd.xe - SIM_LCD_X_OFFSET,
+                            lcd.ys - SIM_LCD_Y_OFFSET,
+                            lcd.ye - SIM_LCD_Y_OFFSET);
+                break;
+
+            default:
+                break;
+        }
+
+        return;
+    }
+
+    switch (lcd.cmd)
+    {
+        case SIM_LCD_CMD_CASET:
+        case SIM_LCD_CMD_RASET:
+            if (lcd.argIdx < sizeof(lcd.args))
+            {
+                lcd.args[lcd.argIdx++] = byte;
+            }
+
+            if (lcd.argIdx == sizeof(lcd.args))
+            {
+                uint16_t start = ((uint16_t)lcd.args[0] << 8) | lcd.args[1];
+                uint16_t end = ((uint16_t)lcd.args[2] << 8) | lcd.args[3];
+
+                if (lcd.cmd == SIM_LCD_CMD_CASET)
+                {
+                    lcd.xs = start;
+                    lcd.xe = end;
+                }
+                else
+                {
+                    lcd.ys = start;
+                    lcd.ye = end;
+                }
+            }
+            break;
+
+        case SIM_LCD_CMD_RAMWR:
+            if (!lcd.pixHalf)
+            {
+                lcd.pixHi = byte;
+                lcd.pixHalf = TRUE;
+            }
+            else
+            {
+                int gx = (int)lcd.x - SIM_LCD_X_OFFSET;
+                int gy = (int)lcd.y - SIM_LCD_Y_OFFSET;
+
+                lcd.pixHalf = FALSE;
+
+                if ((gx >= 0) && (gx < SIM_LCD_WIDTH) &&
+                    (gy >= 0) && (gy < SIM_LCD_HEIGHT))
+                {
+                    lcd.glass[gy][gx] = ((uint16_t)lcd.pixHi << 8) | byte;
+                }
+
+                // Left to right, top to bottom, wrapping in the window
+                if (lcd.x++ >= lcd.xe)
+                {
+                    lcd.x = lcd.xs;
+                    if (lcd.y++ >= lcd.ye)
+                    {
+                        lcd.y = lcd.ys;
+                    }
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      SimIo_dumpLcd
+ *
+ * @brief   Print lines of the LCD glass: space for black, # for white,
+ *          g, y and r for green, yellow and red, + for other colors.
+ *
+ * @param   first - first line
+ * @param   last - last line
+ *
+ * @return  none
+ */
+void SimIo_dumpLcd(uint16_t first, uint16_t last)
+{
+    char line[SIM_LCD_WIDTH + 1];
+    uint16_t x, y;
+
+    if (!lcd.awake || !lcd.on)
+    {
+        printf("lcd   off\n");
+        return;
+    }
+
+    for (y = first; (y <= last) && (y < SIM_LCD_HEIGHT); y++)
+    {
+        for (x = 0; x < SIM_LCD_WIDTH; x++)
+        {
+            switch (lcd.glass[y][x])
+            {
+                case 0x0000: line[x] = ' '; break;
+                case 0xFFFF: line[x] = '#'; break;
+                case 0x07E0: line[x] = 'g'; break;
+                case 0xFFE0: line[x] = 'y'; break;
+                case 0xF800: line[x] = 'r'; break;
+                default:     line[x] = '+'; break;
+            }
+        }
+
+        // Trailing black is not printed
+        while ((x > 0) && (line[x - 1] == ' '))
+        {
+            x--;
+        }
+        line[x] = '\0';
+
+        printf("lcd %3u|%s\n", y, line);
+    }
+}
+
+/*********************************************************************
+ * @fn      SimIo_printLcdStats
+ *
+ * @brief   Print the LCD transfer counters, when the LCD was used.
+ *
+ * @return  none
+ */
+void SimIo_printLcdStats(void)
+{
+    if (lcd.transfers == 0)
+    {
+        return;
+    }
+
+    printf("lcd: %u transfers, %u refused, %u bytes, %u windows\n",
+           lcd.transfers, lcd.refused, lcd.bytes, lcd.windows);
+}
+
+/*********************************************************************
+ * AON BATTERY MONITOR
+ */
+
+uint32_t AONBatMonBatteryVoltageGet(void)
+{
+    return (((uint32_t)batteryMv << 8) / 1000) & 0x7FF;
+}
+
+bool AONBatMonNewBatteryMeasureReady(void)
+{
+    return TRUE;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,481 @@
+/******************************************************************************
+
+ @file       sim_main.c
+
+ @brief This file contains the scenario runner of the host simulation. It
+        reads a script of timed commands for the central and the inputs,
+        starts the application task as main() does on the target and runs
+        it in virtual time to the end of the script.
+
+        Usage: hostsim [-v] [-q] [-l] [-d] [-t] SCENARIO
+
+          -v  also print the Display output of the application
+          -q  do not print the notifications
+          -l  also print the PWM outputs of the LEDs and the buzzer
+          -d  also print the LCD windows drawn
+          -t  deliver the notifications through the connection timing
+              model and print the latency and duty cycle statistics
+          -T  write the input trace of the run to a file, in the
+              INPUT_TRACE build (make tracereplay)
+
+        The PROF_PROBES build (make profile) prints the profiling probes,
+        timed on the host clock, at the end of the run.
+
+        Every script line is "<time ms> <command> [arguments]", # starts a
+        comment. Commands:
+
+          connect [interval latency timeout]  central connects (1.25 ms,
+                                              events, 10 ms units)
+          disconnect                          link lost
+          pair                                pair, or encrypt with the bond
+          enable                              enable all CCCDs
+          updates on|off                      accept parameter updates
+          key <mask>                          pressed keys, KEY_* mask
+          taps <mask> <n> <period> <hold>     n presses of the keys, every
+                                              period ms, held for hold ms
+          adc <channel> <value>               joystick sample
+          batt <mV>                           battery voltage
+          link <rssi> <loss per mille>        link quality
+          write <handle> <hex bytes>          write request
+          read <handle>                       read request
+          attrs                               print the attribute table
+          lcd [first last]                    print the LCD glass, or lines
+                                              first to last of it
+          end                                 end of the run
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Linux host simulation build of the application and
+                        HID profile against a shim of the RTOS, the BLE stack
+                        and the drivers.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "hidgamecontroller.h"
+#include "hiddev.h"
+#ifdef INPUT_TRACE
+#include "sim_trace.h"
+#endif // INPUT_TRACE
+#ifdef PROF_PROBES
+#include "profprobe.h"
+#endif // PROF_PROBES
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Run time past the last command when the script has no end command
+#define SIM_DEFAULT_TAIL_MS             1000
+
+#define SIM_MAX_LINE                    128
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Script command
+typedef struct
+{
+    unsigned lineNum;
+    char text[SIM_MAX_LINE];
+} simCmd_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static const char *scriptName;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+#ifdef PROF_PROBES
+/*********************************************************************
+ * @fn      SimMain_printProfile
+ *
+ * @brief   Print the statistics of the profiling probes, in the layout of
+ *          ../profreport.py.
+ *
+ * @return  none
+ */
+static void SimMain_printProfile(void)
+{
+    static const char * const names[PROF_NUM_PROBES] = PROF_PROBE_NAMES;
+    profStats_t stats;
+    uint8_t i;
+
+    printf("%-12s %10s %10s %10s %10s\n", "probe", "runs", "min us",
+           "mean us", "max us");
+
+    for (i = 0; i < PROF_NUM_PROBES; i++)
+    {
+        Prof_get(i, &stats);
+
+        if (stats.count == 0)
+        {
+            continue;
+        }
+
+        printf("%-12s %10u %10.3f %10.3f %10.3f\n", names[i], stats.count,
+               (double)stats.min / PROF_TICKS_PER_US,
+               (double)stats.sum / stats.count / PROF_TICKS_PER_US,
+               (double)stats.max / PROF_TICKS_PER_US);
+    }
+}
+#endif // PROF_PROBES
+
+/*********************************************************************
+ * @fn      SimMain_parseHex
+ *
+ * @brief   Parse hex bytes separated by spaces, colons or nothing.
+ *
+ * @param   pStr - text
+ * @param   pBuf - output
+ * @param   maxLen - size of pBuf
+ *
+ * @return  Number of bytes parsed
+ */
+static uint16_t SimMain_parseHex(const char *pStr, uint8_t *pBuf,
+                                 uint16_t maxLen)
+{
+    uint16_t len = 0;
+    unsigned byte;
+
+    while ((len < maxLen) && *pStr)
+    {
+        if ((*pStr == ' ') || (*pStr == ':') || (*pStr == '\t'))
+        {
+            pStr++;
+        }
+        else if (sscanf(pStr, "%2x", &byte) == 1)
+        {
+            pBuf[len++] = (uint8_t)byte;
+            pStr += (pStr[1] && (pStr[1] != ' ') && (pStr[1] != ':')) ? 2 : 1;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return len;
+}
+
+/*********************************************************************
+ * @fn      SimMain_setKeys
+ *
+ * @brief   Set the pressed keys and time the change.
+ *
+ * @param   keys - KEY_* mask
+ *
+ * @return  none
+ */
+static void SimMain_setKeys(uintptr_t keys)
+{
+    SimRtos_log(SIM_LOG_EVENT, "sim   keys 0x%02x", (unsigned)keys);
+    SimConn_input();
+    SimIo_setKeys((uint8_t)keys);
+}
+
+/*********************************************************************
+ * @fn      SimMain_runCmd
+ *
+ * @brief   Run a script command at its time.
+ *
+ * @param   arg - simCmd_t of the command
+ *
+ * @return  none
+ */
+static void SimMain_runCmd(uintptr_t arg)
+{
+    simCmd_t *pCmd = (simCmd_t *)arg;
+    char name[16] = "";
+    unsigned a0, a1, a2;
+    int i0;
+    int n = 0;
+    int m = 0;
+
+    sscanf(pCmd->text, "%15s %n", name, &n);
+
+    if (strcmp(name, "connect") == 0)
+    {
+        a0 = SIM_DEFAULT_CONN_INTERVAL;
+        a1 = SIM_DEFAULT_CONN_LATENCY;
+        a2 = SIM_DEFAULT_CONN_TIMEOUT;
+        sscanf(pCmd->text + n, "%u %u %u", &a0, &a1, &a2);
+
+        SimRtos_log(SIM_LOG_EVENT, "sim   connect interval %u latency %u "
+                    "timeout %u", a0, a1, a2);
+        SimBle_connect(a0, a1, a2);
+    }
+    else if (strcmp(name, "disconnect") == 0)
+    {
+        SimRtos_log(SIM_LOG_EVENT, "sim   disconnect");
+        SimBle_disconnect();
+    }
+    else if (strcmp(name, "pair") == 0)
+    {
+        SimRtos_log(SIM_LOG_EVENT, "sim   pair");
+        SimBle_pair();
+    }
+    else if (strcmp(name, "enable") == 0)
+    {
+        SimBle_enableNotifications();
+    }
+    else if (strcmp(name, "updates") == 0)
+    {
+        SimBle_acceptParamUpdates(strncmp(pCmd->text + n, "off", 3) != 0);
+    }
+    else if ((strcmp(name, "key") == 0) &&
+             (sscanf(pCmd->text + n, "%i", &i0) == 1))
+    {
+        SimMain_setKeys((uint8_t)i0);
+    }
+    else if ((strcmp(name, "taps") == 0) &&
+             (sscanf(pCmd->text + n, "%i %u %u %u", &i0, &a0, &a1, &a2) == 4))
+    {
+        unsigned i;
+
+        for (i = 0; i < a0; i++)
+        {
+            SimRtos_defer(SIM_MS(i * a1), SimMain_setKeys, (uint8_t)i0);
+            SimRtos_defer(SIM_MS(i * a1 + a2), SimMain_setKeys, 0);
+        }
+    }
+    else if ((strcmp(name, "adc") == 0) &&
+             (sscanf(pCmd->text + n, "%u %u", &a0, &a1) == 2))
+    {
+        SimConn_input();
+        SimIo_setAdc((uint8_t)a0, (uint16_t)a1);
+    }
+    else if ((strcmp(name, "batt") == 0) &&
+             (sscanf(pCmd->text + n, "%u", &a0) == 1))
+    {
+        SimIo_setBattery((uint16_t)a0);
+    }
+    else if ((strcmp(name, "link") == 0) &&
+             (sscanf(pCmd->text + n, "%i %u", &i0, &a0) == 2))
+    {
+        SimBle_setLink((int8_t)i0, (uint16_t)a0);
+    }
+    else if ((strcmp(name, "write") == 0) &&
+             (sscanf(pCmd->text + n, "%i %n", &i0, &m) >= 1))
+    {
+        uint8_t value[ATT_MTU_SIZE];
+        uint16_t len = SimMain_parseHex(pCmd->text + n + m, value,
+                                        sizeof(value));
+
+        SimRtos_log(SIM_LOG_EVENT, "sim   write 0x%04x status 0x%02x", i0,
+                    SimBle_write((uint16_t)i0, value, len));
+    }
+    else if ((strcmp(name, "read") == 0) &&
+             (sscanf(pCmd->text + n, "%i", &i0) == 1))
+    {
+        uint8_t value[ATT_MTU_SIZE];
+        char hex[3 * ATT_MTU_SIZE + 1] = "";
+        uint16_t len = 0;
+        uint8_t status = SimBle_read((uint16_t)i0, value, &len);
+        uint16_t i;
+
+        for (i = 0; (status == SUCCESS) && (i < len); i++)
+        {
+            sprintf(&hex[3 * i], " %02x", value[i]);
+        }
+
+        SimRtos_log(SIM_LOG_EVENT, "sim   read 0x%04x status 0x%02x%s", i0,
+                    status, hex);
+    }
+    else if (strcmp(name, "attrs") == 0)
+    {
+        SimBle_dumpAttributes();
+    }
+    else if (strcmp(name, "lcd") == 0)
+    {
+        a0 = 0;
+        a1 = UINT16_MAX;
+        sscanf(pCmd->text + n, "%u %u", &a0, &a1);
+
+        SimIo_dumpLcd((uint16_t)a0, (uint16_t)a1);
+    }
+    else if (strcmp(name, "end") != 0)
+    {
+        fprintf(stderr, "%s:%u: bad command: %s\n", scriptName, pCmd->lineNum,
+                pCmd->text);
+    }
+
+    free(pCmd);
+}
+
+/*********************************************************************
+ * @fn      SimMain_loadScript
+ *
+ * @brief   Schedule the commands of a scenario script.
+ *
+ * @param   pFile - script
+ *
+ * @return  Time of the end of the run in ms
+ */
+static uint32_t SimMain_loadScript(FILE *pFile)
+{
+    char line[SIM_MAX_LINE];
+    unsigned lineNum = 0;
+    uint32_t lastMs = 0;
+    uint32_t endMs = 0;
+
+    while (fgets(line, sizeof(line), pFile))
+    {
+        char *pComment = strchr(line, '#');
+        simCmd_t *pCmd;
+        unsigned ms;
+        int n;
+
+        lineNum++;
+
+        if (pComment)
+        {
+            *pComment = '\0';
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (sscanf(line, "%u %n", &ms, &n) != 1)
+        {
+            if (line[strspn(line, " \t")] != '\0')
+            {
+                fprintf(stderr, "%s:%u: missing time\n", scriptName, lineNum);
+            }
+            continue;
+        }
+
+        pCmd = malloc(sizeof(simCmd_t));
+        pCmd->lineNum = lineNum;
+        snprintf(pCmd->text, sizeof(pCmd->text), "%s", line + n);
+
+        if (strncmp(pCmd->text, "end", 3) == 0)
+        {
+            endMs = ms;
+        }
+
+        lastMs = MAX(lastMs, ms);
+        SimRtos_defer(SIM_MS(ms), SimMain_runCmd, (uintptr_t)pCmd);
+    }
+
+    return endMs ? endMs : lastMs + SIM_DEFAULT_TAIL_MS;
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run a scenario.
+ *
+ * @return  Zero on success
+ */
+int main(int argc, char *argv[])
+{
+    FILE *pFile;
+    uint32_t endMs;
+#ifdef INPUT_TRACE
+    const char *traceName = NULL;
+#endif // INPUT_TRACE
+    int i;
+
+    for (i = 1; (i < argc) && (argv[i][0] == '-'); i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            simLogMask |= SIM_LOG_DISPLAY;
+        }
+        else if (strcmp(argv[i], "-q") == 0)
+        {
+            simLogMask &= ~SIM_LOG_NOTI;
+        }
+        else if (strcmp(argv[i], "-l") == 0)
+        {
+            simLogMask |= SIM_LOG_PWM;
+        }
+        else if (strcmp(argv[i], "-d") == 0)
+        {
+            simLogMask |= SIM_LOG_LCD;
+        }
+        else if (strcmp(argv[i], "-t") == 0)
+        {
+            SimConn_enable();
+        }
+#ifdef INPUT_TRACE
+        else if ((strcmp(argv[i], "-T") == 0) && (i + 1 < argc))
+        {
+            traceName = argv[++i];
+            SimTrace_capture();
+        }
+#endif // INPUT_TRACE
+        else
+        {
+            break;
+        }
+    }
+
+    if (i != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-v] [-q] [-l] [-d] [-t] [-T trace] "
+                "SCENARIO\n", argv[0]);
+        return 2;
+    }
+
+    scriptName = argv[i];
+    pFile = fopen(scriptName, "r");
+    if (pFile == NULL)
+    {
+        perror(scriptName);
+        return 1;
+    }
+
+    endMs = SimMain_loadScript(pFile);
+    fclose(pFile);
+
+    // As main() on the target, HidDev runs in the application task or in
+    // a task of its own
+#ifndef HID_DEV_SINGLE_TASK
+    HidDev_createTask();
+#endif // !HID_DEV_SINGLE_TASK
+    HidGameController_createTask();
+
+    SimRtos_run(SIM_MS(endMs));
+
+    printf("end of run at %u ms\n", endMs);
+    SimBle_printStats();
+    SimConn_printStats();
+    SimIo_printLcdStats();
+    SimSnv_printStats();
+#ifdef PROF_PROBES
+    SimMain_printProfile();
+#endif // PROF_PROBES
+
+#ifdef INPUT_TRACE
+    if (traceName != NULL)
+    {
+        uint8_t *pTrace;
+        uint32_t len = SimTrace_collect(&pTrace);
+
+        if (SimTrace_save(traceName, pTrace, len))
+        {
+            return 1;
+        }
+    }
+#endif // INPUT_TRACE
+
+    return 0;
+}
+
+/*********************************************************************
+*********************************************************************/
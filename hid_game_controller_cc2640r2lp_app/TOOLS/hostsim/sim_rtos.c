@@ -0,0 +1,658 @@
+/******************************************************************************
+
+ @file       sim_rtos.c
+
+ @brief This file contains the virtual time kernel of the host simulation.
+        Each task runs on a host context of its own, one at a time: the
+        highest priority task that is ready runs, and a post that readies
+        a task of a higher priority than the running one switches to it
+        at once, as the kernel preempts on the target. Whenever every task
+        pends on an event that has not been posted, time jumps to the next
+        clock expiry or scheduled call, which run as the clock Swi and the
+        interrupts would on the target.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Linux host simulation build of the application and
+                        HID profile against a shim of the RTOS, the BLE stack
+                        and the drivers.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <ucontext.h>
+
+#include "sim.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Host stack of a task, the target stack sizes are far too small for
+// the host code and the sanitizers
+#define SIM_TASK_STACK_SIZE             (1024 * 1024)
+
+// Task states
+#define SIM_TASK_NEW                    0  // Not started yet
+#define SIM_TASK_READY                  1  // Preempted, or running
+#define SIM_TASK_PENDING                2  // Pending on pPend
+#define SIM_TASK_DONE                   3  // Task function returned
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Host context of a task
+typedef struct
+{
+    ucontext_t context;
+    uint8_t stack[SIM_TASK_STACK_SIZE];
+} simTaskContext_t;
+
+// Scheduled call
+typedef struct simCall_s
+{
+    struct simCall_s *next;
+    uint64_t time;
+    simCallFxn_t fxn;
+    uintptr_t arg;
+} simCall_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Log classes enabled
+uint8_t simLogMask = SIM_LOG_DEFAULT;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Current virtual time in ticks
+static uint64_t simNow = 0;
+
+// End of the run
+static uint64_t simEnd = 0;
+
+// All constructed clocks
+static Clock_Struct *clockList = NULL;
+
+// Scheduled calls, sorted by time, FIFO among equal times
+static simCall_t *callList = NULL;
+
+// Constructed tasks, highest priority first, and the running one
+static Task_Struct *taskList = NULL;
+static Task_Struct *pRunning = NULL;
+
+// Context of the scheduler, the host thread
+static ucontext_t schedContext;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bool SimRtos_advance(void);
+static bool SimRtos_isReady(Task_Struct *pTask);
+static void SimRtos_switchTo(Task_Struct *pTask);
+static void SimRtos_yield(void);
+static void SimRtos_taskEntry(void);
+
+/*********************************************************************
+ * @fn      SimRtos_now
+ *
+ * @brief   Current virtual time.
+ *
+ * @return  Ticks since the start of the simulation
+ */
+uint64_t SimRtos_now(void)
+{
+    return simNow;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_defer
+ *
+ * @brief   Schedule a call in virtual time. The call runs outside the
+ *          application task, like an interrupt or the stack would.
+ *
+ * @param   delay - ticks from now
+ * @param   fxn - function to call
+ * @param   arg - argument of fxn
+ *
+ * @return  none
+ */
+void SimRtos_defer(uint64_t delay, simCallFxn_t fxn, uintptr_t arg)
+{
+    simCall_t *pCall = malloc(sizeof(simCall_t));
+    simCall_t **ppPrev = &callList;
+
+    pCall->time = simNow + delay;
+    pCall->fxn = fxn;
+    pCall->arg = arg;
+
+    while ((*ppPrev != NULL) && ((*ppPrev)->time <= pCall->time))
+    {
+        ppPrev = &(*ppPrev)->next;
+    }
+
+    pCall->next = *ppPrev;
+    *ppPrev = pCall;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_run
+ *
+ * @brief   Run the tasks until the given time. Returns when every task
+ *          pends and nothing is left to do before endTick; the tasks go
+ *          on from there on the next run.
+ *
+ * @param   endTick - end of the run
+ *
+ * @return  none
+ */
+void SimRtos_run(uint64_t endTick)
+{
+    Task_Struct *pTask;
+
+    simEnd = endTick;
+
+    for (;;)
+    {
+        for (pTask = taskList; pTask != NULL; pTask = pTask->next)
+        {
+            if (SimRtos_isReady(pTask))
+            {
+                break;
+            }
+        }
+
+        if (pTask != NULL)
+        {
+            SimRtos_switchTo(pTask);
+        }
+        else if (!SimRtos_advance())
+        {
+            break;
+        }
+    }
+
+    simNow = MAX(simNow, simEnd);
+}
+
+/*********************************************************************
+ * @fn      SimRtos_log
+ *
+ * @brief   Print a line prefixed with the virtual time in milliseconds.
+ *
+ * @param   logClass - SIM_LOG_* class of the line
+ * @param   fmt - printf format
+ *
+ * @return  none
+ */
+void SimRtos_log(uint8_t logClass, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (simLogMask & logClass)
+    {
+        printf("%6llu.%02llu ", (unsigned long long)(simNow / SIM_TICKS_PER_MS),
+               (unsigned long long)(simNow % SIM_TICKS_PER_MS));
+
+        va_start(ap, fmt);
+        vprintf(fmt, ap);
+        va_end(ap);
+
+        putchar('\n');
+    }
+}
+
+/*********************************************************************
+ * @fn      SimRtos_advance
+ *
+ * @brief   Jump to the next clock expiry or scheduled call and run
+ *          everything due at that time.
+ *
+ * @return  FALSE when nothing is due before the end of the run
+ */
+static bool SimRtos_advance(void)
+{
+    Clock_Struct *pClock;
+    Task_Struct *pTask;
+    uint64_t next = UINT64_MAX;
+
+    for (pClock = clockList; pClock != NULL; pClock = pClock->next)
+    {
+        if (pClock->active && (pClock->expiry < next))
+        {
+            next = pClock->expiry;
+        }
+    }
+
+    // Pend timeouts
+    for (pTask = taskList; pTask != NULL; pTask = pTask->next)
+    {
+        if ((pTask->state == SIM_TASK_PENDING) && (pTask->deadline < next))
+        {
+            next = pTask->deadline;
+        }
+    }
+
+    if ((callList != NULL) && (callList->time < next))
+    {
+        next = callList->time;
+    }
+
+    if ((next == UINT64_MAX) || (next > simEnd))
+    {
+        return FALSE;
+    }
+
+    simNow = next;
+
+    // Clock functions first, as the clock Swi preempts everything else
+    for (pClock = clockList; pClock != NULL; pClock = pClock->next)
+    {
+        if (pClock->active && (pClock->expiry == simNow))
+        {
+            if (pClock->period)
+            {
+                pClock->expiry += pClock->period;
+            }
+            else
+            {
+                pClock->active = FALSE;
+            }
+
+            pClock->fxn(pClock->arg);
+        }
+    }
+
+    while ((callList != NULL) && (callList->time <= simNow))
+    {
+        simCall_t *pCall = callList;
+
+        callList = pCall->next;
+        pCall->fxn(pCall->arg);
+        free(pCall);
+    }
+
+    return TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_isReady
+ *
+ * @brief   Check whether a task can run.
+ *
+ * @param   pTask - task
+ *
+ * @return  TRUE if new, preempted, or its pend is satisfied or timed out
+ */
+static bool SimRtos_isReady(Task_Struct *pTask)
+{
+    switch (pTask->state)
+    {
+        case SIM_TASK_NEW:
+        case SIM_TASK_READY:
+            return TRUE;
+
+        case SIM_TASK_PENDING:
+            return ((pTask->pPend->posted & pTask->pendMask) ||
+                    (simNow >= pTask->deadline));
+
+        default:
+            return FALSE;
+    }
+}
+
+/*********************************************************************
+ * @fn      SimRtos_switchTo
+ *
+ * @brief   Run a task from the scheduler until it pends, is preempted
+ *          or returns. A new task gets its host context first.
+ *
+ * @param   pTask - task
+ *
+ * @return  none
+ */
+static void SimRtos_switchTo(Task_Struct *pTask)
+{
+    simTaskContext_t *pContext = pTask->pContext;
+
+    if (pTask->state == SIM_TASK_NEW)
+    {
+        if (pContext == NULL)
+        {
+            pContext = malloc(sizeof(simTaskContext_t));
+            pTask->pContext = pContext;
+        }
+
+        getcontext(&pContext->context);
+        pContext->context.uc_stack.ss_sp = pContext->stack;
+        pContext->context.uc_stack.ss_size = sizeof(pContext->stack);
+        pContext->context.uc_link = &schedContext;
+        makecontext(&pContext->context, SimRtos_taskEntry, 0);
+    }
+
+    pTask->state = SIM_TASK_READY;
+    pRunning = pTask;
+    swapcontext(&schedContext, &pContext->context);
+    pRunning = NULL;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_yield
+ *
+ * @brief   Give the host thread back to the scheduler from the running
+ *          task, which goes on when it is picked again.
+ *
+ * @return  none
+ */
+static void SimRtos_yield(void)
+{
+    simTaskContext_t *pContext = pRunning->pContext;
+
+    swapcontext(&pContext->context, &schedContext);
+}
+
+/*********************************************************************
+ * @fn      SimRtos_taskEntry
+ *
+ * @brief   Entry of the host context of a task.
+ *
+ * @return  none
+ */
+static void SimRtos_taskEntry(void)
+{
+    Task_Struct *pTask = pRunning;
+
+    pTask->fxn(pTask->arg0, pTask->arg1);
+
+    // Back to the scheduler through uc_link
+    pTask->state = SIM_TASK_DONE;
+}
+
+/*********************************************************************
+ * CLOCK
+ */
+
+void Clock_Params_init(Clock_Params *pParams)
+{
+    pParams->arg = 0;
+    pParams->period = 0;
+    pParams->startFlag = FALSE;
+}
+
+void Clock_construct(Clock_Struct *pClock, Clock_FuncPtr fxn, UInt timeout,
+                     const Clock_Params *pParams)
+{
+    Clock_Struct *pEntry;
+
+    pClock->fxn = fxn;
+    pClock->arg = pParams->arg;
+    pClock->timeout = timeout;
+    pClock->period = pParams->period;
+    pClock->active = FALSE;
+
+    // Constructed again after a simulated reset, it is listed once
+    for (pEntry = clockList; pEntry != NULL; pEntry = pEntry->next)
+    {
+        if (pEntry == pClock)
+        {
+            break;
+        }
+    }
+
+    if (pEntry == NULL)
+    {
+        pClock->next = clockList;
+        clockList = pClock;
+    }
+
+    if (pParams->startFlag)
+    {
+        Clock_start(pClock);
+    }
+}
+
+void Clock_start(Clock_Handle handle)
+{
+    // A timeout of zero expires on the next tick
+    handle->expiry = simNow + MAX(handle->timeout, 1);
+    handle->active = TRUE;
+}
+
+void Clock_stop(Clock_Handle handle)
+{
+    handle->active = FALSE;
+}
+
+Bool Clock_isActive(Clock_Handle handle)
+{
+    return handle->active;
+}
+
+void Clock_setTimeout(Clock_Handle handle, UInt32 timeout)
+{
+    handle->timeout = timeout;
+}
+
+void Clock_setPeriod(Clock_Handle handle, UInt32 period)
+{
+    handle->period = period;
+}
+
+UInt32 Clock_getTicks(void)
+{
+    return (UInt32)simNow;
+}
+
+/*********************************************************************
+ * EVENT
+ */
+
+void Event_post(Event_Handle handle, UInt eventMask)
+{
+    Task_Struct *pTask;
+
+    handle->posted |= eventMask;
+
+    // Posted by a task, switch to a higher priority task it readies
+    if (pRunning == NULL)
+    {
+        return;
+    }
+
+    for (pTask = taskList; (pTask != NULL) &&
+         (pTask->priority > pRunning->priority); pTask = pTask->next)
+    {
+        if ((pTask->state == SIM_TASK_PENDING) && SimRtos_isReady(pTask))
+        {
+            SimRtos_yield();
+            break;
+        }
+    }
+}
+
+UInt Event_pend(Event_Handle handle, UInt andMask, UInt orMask, UInt32 timeout)
+{
+    uint64_t deadline = (timeout == BIOS_WAIT_FOREVER) ?
+                        UINT64_MAX : simNow + timeout;
+
+    for (;;)
+    {
+        UInt events = handle->posted & orMask;
+
+        if (events)
+        {
+            handle->posted &= ~events;
+
+            return events;
+        }
+
+        if (simNow >= deadline)
+        {
+            return 0;
+        }
+
+        // Outside the tasks, as in a test harness, time runs here
+        if (pRunning == NULL)
+        {
+            if (!SimRtos_advance())
+            {
+                return 0;
+            }
+
+            continue;
+        }
+
+        pRunning->state = SIM_TASK_PENDING;
+        pRunning->pPend = handle;
+        pRunning->pendMask = orMask;
+        pRunning->deadline = deadline;
+
+        SimRtos_yield();
+    }
+}
+
+/*********************************************************************
+ * QUEUE
+ */
+
+void Queue_construct(Queue_Struct *pQueue, const Queue_Params *pParams)
+{
+    pQueue->next = pQueue;
+    pQueue->prev = pQueue;
+}
+
+Bool Queue_empty(Queue_Handle handle)
+{
+    return (handle->next == handle);
+}
+
+Ptr Queue_get(Queue_Handle handle)
+{
+    Queue_Elem *pElem = handle->next;
+
+    // As on the target, an empty queue returns its own head
+    handle->next = pElem->next;
+    pElem->next->prev = handle;
+
+    return pElem;
+}
+
+void Queue_put(Queue_Handle handle, Queue_Elem *pElem)
+{
+    pElem->next = handle;
+    pElem->prev = handle->prev;
+    handle->prev->next = pElem;
+    handle->prev = pElem;
+}
+
+/*********************************************************************
+ * TASK
+ */
+
+void Task_Params_init(Task_Params *pParams)
+{
+    pParams->arg0 = 0;
+    pParams->arg1 = 0;
+    pParams->priority = 1;
+    pParams->stack = NULL;
+    pParams->stackSize = 0;
+}
+
+void Task_construct(Task_Struct *pTask, Task_FuncPtr fxn,
+                    const Task_Params *pParams, Error_Block *eb)
+{
+    Task_Struct **ppPrev;
+
+    // Constructed again after a simulated reset, it starts over
+    for (ppPrev = &taskList; *ppPrev != NULL; ppPrev = &(*ppPrev)->next)
+    {
+        if (*ppPrev == pTask)
+        {
+            *ppPrev = pTask->next;
+            break;
+        }
+    }
+
+    pTask->fxn = fxn;
+    pTask->arg0 = pParams->arg0;
+    pTask->arg1 = pParams->arg1;
+    pTask->priority = pParams->priority;
+    pTask->stackSize = pParams->stackSize;
+    pTask->state = SIM_TASK_NEW;
+    pTask->pPend = NULL;
+
+    // After the tasks of the same priority, which run first
+    for (ppPrev = &taskList; (*ppPrev != NULL) &&
+         ((*ppPrev)->priority >= pTask->priority); ppPrev = &(*ppPrev)->next)
+    {
+    }
+
+    pTask->next = *ppPrev;
+    *ppPrev = pTask;
+}
+
+Task_Handle Task_self(void)
+{
+    return pRunning;
+}
+
+void Task_stat(Task_Handle handle, Task_Stat *pStat)
+{
+    pStat->priority = handle->priority;
+    pStat->stackSize = handle->stackSize;
+    pStat->used = 0;
+}
+
+/*********************************************************************
+ * HWI
+ */
+
+UInt Hwi_disable(void)
+{
+    return 0;
+}
+
+void Hwi_restore(UInt key)
+{
+}
+
+Bool Hwi_getStackInfo(Hwi_StackInfo *pStkInfo, Bool computeStackDepth)
+{
+    pStkInfo->hwiStackPeak = 0;
+    pStkInfo->hwiStackSize = 0;
+    pStkInfo->hwiStackBase = NULL;
+
+    return FALSE;
+}
+
+/*********************************************************************
+ * TIMESTAMP
+ */
+
+// Virtual time at 1 MHz
+Bits32 Timestamp_get32(void)
+{
+    return (Bits32)(simNow * Clock_tickPeriod);
+}
+
+void Timestamp_getFreq(Types_FreqHz *pFreq)
+{
+    pFreq->hi = 0;
+    pFreq->lo = 1000000;
+}
+
+/*********************************************************************
+*********************************************************************/
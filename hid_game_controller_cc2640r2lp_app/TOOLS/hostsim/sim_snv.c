@@ -0,0 +1,454 @@
+/******************************************************************************
+
+ @file       sim_snv.c
+
+ @brief This file contains the simulated SNV of the host simulation, the
+        osal_snv_read and osal_snv_write of the stack. Like NV on one
+        flash page, items are appended to a page of erased bytes and the
+        last complete copy of an item is the one read. An item is
+        programmed byte by byte, ID and length first and a commit byte
+        last, so one cut short by a power loss is ignored and the copy
+        before it is read again. When the page is full the latest copies
+        are compacted into a fresh page, which costs one erase; the
+        compaction is taken as atomic, as the compaction page of the
+        stack makes it.
+
+        Item layout: [ID] [length] [value] [commit]
+
+        For the power loss tests SimSnv_cutAfter stops the programming
+        after a number of bytes, as a reset would, and SimSnv_powerUp
+        scans the page again as the stack does at boot.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Simulated SNV page with power loss and bit error
+                        injection for the host simulation.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+
+#include "sim.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Item header and trailer bytes
+#define SIM_SNV_ITEM_OVERHEAD           3
+
+// Erased and committed values
+#define SIM_SNV_ERASED                  0xFF
+#define SIM_SNV_COMMITTED               0x00
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8_t snvPage[SIM_SNV_PAGE_SIZE];
+static bool snvInit = FALSE;
+
+// First erased byte, as scanned at power up
+static uint16_t snvFree = 0;
+
+// Power loss after snvCutBudget more bytes, and the loss happened
+static bool snvCutArmed = FALSE;
+static uint32_t snvCutBudget = 0;
+static bool snvPowerLost = FALSE;
+
+static simSnvStats_t snvStats;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void SimSnv_check(void);
+static void SimSnv_scan(void);
+static int32_t SimSnv_find(uint8_t id);
+static bool SimSnv_program(uint16_t offset, uint8_t value);
+static bool SimSnv_compact(void);
+
+/*********************************************************************
+ * OSAL SNV
+ */
+
+uint8 osal_snv_read(osalSnv_t id, osalSnv_t len, void *pBuf)
+{
+    int32_t offset;
+    uint8_t itemLen;
+
+    SimSnv_check();
+
+    offset = SimSnv_find(id);
+    if (offset < 0)
+    {
+        return NV_OPER_FAILED;
+    }
+
+    // A longer read goes on into the flash past the item, taken as erased
+    itemLen = snvPage[offset + 1];
+    memset(pBuf, SIM_SNV_ERASED, len);
+    memcpy(pBuf, &snvPage[offset + 2], MIN(len, itemLen));
+
+    return SUCCESS;
+}
+
+uint8 osal_snv_write(osalSnv_t id, osalSnv_t len, void *pBuf)
+{
+    const uint8_t *pValue = pBuf;
+    uint16_t offset;
+    uint16_t i;
+
+    SimSnv_check();
+
+    if (snvPowerLost)
+    {
+        return NV_OPER_FAILED;
+    }
+
+    if ((len == 0) || (len == SIM_SNV_ERASED) || (id == SIM_SNV_ERASED))
+    {
+        return NV_BAD_ITEM_LEN;
+    }
+
+    if ((snvFree + len + SIM_SNV_ITEM_OVERHEAD > SIM_SNV_PAGE_SIZE) &&
+        (!SimSnv_compact() ||
+         (snvFree + len + SIM_SNV_ITEM_OVERHEAD > SIM_SNV_PAGE_SIZE)))
+    {
+        return NV_OPER_FAILED;
+    }
+
+    offset = snvFree;
+    snvFree += len + SIM_SNV_ITEM_OVERHEAD;
+
+    if (!SimSnv_program(offset, id) || !SimSnv_program(offset + 1, len))
+    {
+        snvStats.torn++;
+
+        return NV_OPER_FAILED;
+    }
+
+    for (i = 0; i < len; i++)
+    {
+        if (!SimSnv_program(offset + 2 + i, pValue[i]))
+        {
+            snvStats.torn++;
+
+            return NV_OPER_FAILED;
+        }
+    }
+
+    if (!SimSnv_program(offset + 2 + len, SIM_SNV_COMMITTED))
+    {
+        snvStats.torn++;
+
+        return NV_OPER_FAILED;
+    }
+
+    snvStats.writes++;
+    SimRtos_log(SIM_LOG_EVENT, "snv   write id 0x%02x len %u", id, len);
+
+    return SUCCESS;
+}
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimSnv_erase
+ *
+ * @brief   Erase the page and clear the counters, as a new device.
+ *
+ * @return  none
+ */
+void SimSnv_erase(void)
+{
+    memset(snvPage, SIM_SNV_ERASED, sizeof(snvPage));
+    memset(&snvStats, 0, sizeof(snvStats));
+    snvFree = 0;
+    snvCutArmed = FALSE;
+    snvPowerLost = FALSE;
+    snvInit = TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimSnv_cutAfter
+ *
+ * @brief   Lose the power after programming this many more bytes. No
+ *          byte is programmed after, until SimSnv_powerUp.
+ *
+ * @param   bytes - bytes programmed before the loss
+ *
+ * @return  none
+ */
+void SimSnv_cutAfter(uint32_t bytes)
+{
+    SimSnv_check();
+
+    snvCutArmed = TRUE;
+    snvCutBudget = bytes;
+}
+
+/*********************************************************************
+ * @fn      SimSnv_powerUp
+ *
+ * @brief   Power up again: scan the page for the end of the items.
+ *
+ * @return  none
+ */
+void SimSnv_powerUp(void)
+{
+    SimSnv_check();
+
+    snvCutArmed = FALSE;
+    snvPowerLost = FALSE;
+    SimSnv_scan();
+}
+
+/*********************************************************************
+ * @fn      SimSnv_corrupt
+ *
+ * @brief   Flip a bit in the value of an item, as a retention error.
+ *          The item stays complete.
+ *
+ * @param   id - item ID
+ *
+ * @return  TRUE if the item was found
+ */
+uint8_t SimSnv_corrupt(uint8_t id)
+{
+    int32_t offset;
+
+    SimSnv_check();
+
+    offset = SimSnv_find(id);
+    if (offset < 0)
+    {
+        return FALSE;
+    }
+
+    snvPage[offset + 2] ^= 0x01;
+
+    return TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimSnv_getStats
+ *
+ * @brief   Get the SNV counters.
+ *
+ * @param   pStats - counters are copied here
+ *
+ * @return  none
+ */
+void SimSnv_getStats(simSnvStats_t *pStats)
+{
+    *pStats = snvStats;
+    pStats->used = snvFree;
+}
+
+/*********************************************************************
+ * @fn      SimSnv_printStats
+ *
+ * @brief   Print the SNV counters, when anything was written.
+ *
+ * @return  none
+ */
+void SimSnv_printStats(void)
+{
+    if ((snvStats.writes == 0) && (snvStats.torn == 0))
+    {
+        return;
+    }
+
+    printf("snv: %u writes, %u bytes, %u compactions, %u of %u bytes used\n",
+           snvStats.writes, snvStats.bytes, snvStats.compactions, snvFree,
+           SIM_SNV_PAGE_SIZE);
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimSnv_check
+ *
+ * @brief   Erase the page on first use.
+ *
+ * @return  none
+ */
+static void SimSnv_check(void)
+{
+    if (!snvInit)
+    {
+        SimSnv_erase();
+    }
+}
+
+/*********************************************************************
+ * @fn      SimSnv_scan
+ *
+ * @brief   Find the first erased byte. A header cut short leaves the
+ *          length of its item unknown, the page is then taken as full
+ *          and the next write compacts it.
+ *
+ * @return  none
+ */
+static void SimSnv_scan(void)
+{
+    uint16_t offset = 0;
+    uint8_t len;
+
+    while ((offset < SIM_SNV_PAGE_SIZE) &&
+           (snvPage[offset] != SIM_SNV_ERASED))
+    {
+        len = (offset + 1 < SIM_SNV_PAGE_SIZE) ? snvPage[offset + 1] :
+                                                 SIM_SNV_ERASED;
+
+        if ((len == SIM_SNV_ERASED) ||
+            (offset + len + SIM_SNV_ITEM_OVERHEAD > SIM_SNV_PAGE_SIZE))
+        {
+            offset = SIM_SNV_PAGE_SIZE;
+            break;
+        }
+
+        offset += len + SIM_SNV_ITEM_OVERHEAD;
+    }
+
+    snvFree = offset;
+}
+
+/*********************************************************************
+ * @fn      SimSnv_find
+ *
+ * @brief   Find the last complete copy of an item.
+ *
+ * @param   id - item ID
+ *
+ * @return  Offset of the item, -1 if there is none
+ */
+static int32_t SimSnv_find(uint8_t id)
+{
+    int32_t found = -1;
+    uint16_t offset = 0;
+    uint8_t len;
+
+    while ((offset + 1 < snvFree) && (snvPage[offset] != SIM_SNV_ERASED))
+    {
+        len = snvPage[offset + 1];
+
+        if ((len == SIM_SNV_ERASED) ||
+            (offset + len + SIM_SNV_ITEM_OVERHEAD > snvFree))
+        {
+            break;
+        }
+
+        if ((snvPage[offset] == id) &&
+            (snvPage[offset + 2 + len] == SIM_SNV_COMMITTED))
+        {
+            found = offset;
+        }
+
+        offset += len + SIM_SNV_ITEM_OVERHEAD;
+    }
+
+    return found;
+}
+
+/*********************************************************************
+ * @fn      SimSnv_program
+ *
+ * @brief   Program a byte, flash only clears bits. Nothing is programmed
+ *          once the power is lost.
+ *
+ * @param   offset - offset in the page
+ * @param   value - byte
+ *
+ * @return  FALSE if the power was lost
+ */
+static bool SimSnv_program(uint16_t offset, uint8_t value)
+{
+    if (snvPowerLost)
+    {
+        return FALSE;
+    }
+
+    if (snvCutArmed)
+    {
+        if (snvCutBudget == 0)
+        {
+            snvPowerLost = TRUE;
+
+            return FALSE;
+        }
+
+        snvCutBudget--;
+    }
+
+    snvPage[offset] &= value;
+    snvStats.bytes++;
+
+    return TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimSnv_compact
+ *
+ * @brief   Copy the last complete copy of every item into a fresh page.
+ *          A power loss before the copy is complete leaves the old page.
+ *
+ * @return  FALSE if the power was lost
+ */
+static bool SimSnv_compact(void)
+{
+    static uint8_t newPage[SIM_SNV_PAGE_SIZE];
+    uint16_t newFree = 0;
+    uint16_t id;
+    int32_t offset;
+    uint16_t size;
+
+    memset(newPage, SIM_SNV_ERASED, sizeof(newPage));
+
+    for (id = 0; id < SIM_SNV_ERASED; id++)
+    {
+        offset = SimSnv_find((uint8_t)id);
+
+        if (offset >= 0)
+        {
+            size = snvPage[offset + 1] + SIM_SNV_ITEM_OVERHEAD;
+            memcpy(&newPage[newFree], &snvPage[offset], size);
+            newFree += size;
+        }
+    }
+
+    if (snvCutArmed)
+    {
+        if (snvCutBudget < newFree)
+        {
+            snvCutBudget = 0;
+            snvPowerLost = TRUE;
+
+            return FALSE;
+        }
+
+        snvCutBudget -= newFree;
+    }
+
+    memcpy(snvPage, newPage, sizeof(snvPage));
+    snvFree = newFree;
+    snvStats.bytes += newFree;
+    snvStats.compactions++;
+    SimRtos_log(SIM_LOG_EVENT, "snv   compact %u bytes", newFree);
+
+    return TRUE;
+}
+
+/*********************************************************************
+*********************************************************************/
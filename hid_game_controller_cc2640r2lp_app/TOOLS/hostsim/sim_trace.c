@@ -0,0 +1,592 @@
+/******************************************************************************
+
+ @file       sim_trace.c
+
+ @brief This file contains the input trace support of the host simulation.
+        It captures the trace the application notifies on the trace
+        diagnostic characteristic, reads and writes trace files and
+        decodes the trace format of Application/inputtrace.h.
+
+        A trace file is the binary trace, or the hex dump of the trace
+        notifications as a BLE client logs them, one notification per
+        line, # starts a comment. A binary trace starts with the start
+        record type, 0x01, a hex dump with a digit.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Record the joystick samples, key edges, reports and
+                        send outcomes in a compact binary trace, drained
+                        through the diagnostic service and replayed on the
+                        host simulation (TOOLS/hostsim/trace_replay.c).
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_trace.h"
+#include "diagservice.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Capture buffer growth
+#define SIM_TRACE_CHUNK                 4096
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Trace notified by the application
+static uint8_t *pCapture = NULL;
+static uint32_t captureLen = 0;
+static uint32_t captureSize = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimTrace_append
+ *
+ * @brief   Append bytes to the capture buffer.
+ *
+ * @param   pData - bytes
+ * @param   len - number of bytes
+ *
+ * @return  none
+ */
+static void SimTrace_append(const uint8_t *pData, uint32_t len)
+{
+    if (captureLen + len > captureSize)
+    {
+        captureSize = captureLen + len + SIM_TRACE_CHUNK;
+        pCapture = realloc(pCapture, captureSize);
+    }
+
+    memcpy(&pCapture[captureLen], pData, len);
+    captureLen += len;
+}
+
+/*********************************************************************
+ * @fn      SimTrace_tap
+ *
+ * @brief   Notification tap, keeps the trace notifications.
+ *
+ * @param   pNoti - notification taken by the central
+ *
+ * @return  none
+ */
+static void SimTrace_tap(const simNoti_t *pNoti)
+{
+    if (SimBle_getAttrUuid(pNoti->handle) == DIAG_TRACE_UUID)
+    {
+        SimTrace_append(pNoti->pValue, pNoti->len);
+    }
+}
+
+/*********************************************************************
+ * @fn      SimTrace_getVar
+ *
+ * @brief   Read a varint.
+ *
+ * @param   pTrace - trace
+ * @param   len - trace length
+ * @param   pPos - position, moved past the varint
+ * @param   pValue - number
+ *
+ * @return  0, or -1 when the trace ends in the varint
+ */
+static int SimTrace_getVar(const uint8_t *pTrace, uint32_t len,
+                           uint32_t *pPos, uint32_t *pValue)
+{
+    uint32_t value = 0;
+    uint8_t shift = 0;
+    uint8_t byte;
+
+    do
+    {
+        if ((*pPos >= len) || (shift > 28))
+        {
+            return -1;
+        }
+
+        byte = pTrace[(*pPos)++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    *pValue = value;
+
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      SimTrace_getByte
+ *
+ * @brief   Read a byte.
+ *
+ * @param   pTrace - trace
+ * @param   len - trace length
+ * @param   pPos - position, moved past the byte
+ * @param   pValue - byte
+ *
+ * @return  0, or -1 at the end of the trace
+ */
+static int SimTrace_getByte(const uint8_t *pTrace, uint32_t len,
+                            uint32_t *pPos, uint8_t *pValue)
+{
+    if (*pPos >= len)
+    {
+        return -1;
+    }
+
+    *pValue = pTrace[(*pPos)++];
+
+    return 0;
+}
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimTrace_capture
+ *
+ * @brief   Keep the trace the application notifies from here on.
+ *
+ * @return  none
+ */
+void SimTrace_capture(void)
+{
+    SimBle_setNotiTap(SimTrace_tap);
+}
+
+/*********************************************************************
+ * @fn      SimTrace_collect
+ *
+ * @brief   Get the trace of the run: the trace notified so far and the
+ *          rest of the trace buffer of the application.
+ *
+ * @param   ppTrace - trace, owned by the capture
+ *
+ * @return  Trace length
+ */
+uint32_t SimTrace_collect(uint8_t **ppTrace)
+{
+    uint8_t chunk[DIAG_TRACE_MAX_LEN];
+    uint16_t len;
+
+    while ((len = InputTrace_peek(chunk, sizeof(chunk))) > 0)
+    {
+        SimTrace_append(chunk, len);
+        InputTrace_consume(len);
+    }
+
+    *ppTrace = pCapture;
+
+    return captureLen;
+}
+
+/*********************************************************************
+ * @fn      SimTrace_load
+ *
+ * @brief   Read a trace file, binary or hex dump.
+ *
+ * @param   pPath - file
+ * @param   ppTrace - trace, allocated
+ * @param   pLen - trace length
+ *
+ * @return  0, or -1 when the file can not be read
+ */
+int SimTrace_load(const char *pPath, uint8_t **ppTrace, uint32_t *pLen)
+{
+    FILE *pFile = fopen(pPath, "rb");
+    uint8_t *pTrace = NULL;
+    uint32_t len = 0;
+    uint32_t size = 0;
+    int c;
+
+    if (pFile == NULL)
+    {
+        perror(pPath);
+        return -1;
+    }
+
+    c = fgetc(pFile);
+
+    if (c == INPUT_TRACE_REC_START)
+    {
+        // Binary
+        while (c != EOF)
+        {
+            if (len == size)
+            {
+                size += SIM_TRACE_CHUNK;
+                pTrace = realloc(pTrace, size);
+            }
+
+            pTrace[len++] = (uint8_t)c;
+            c = fgetc(pFile);
+        }
+    }
+    else
+    {
+        char line[512];
+        unsigned lineNum = 0;
+
+        // Hex dump
+        ungetc(c, pFile);
+
+        while (fgets(line, sizeof(line), pFile))
+        {
+            char *p = line;
+            unsigned byte;
+            int n;
+
+            lineNum++;
+            line[strcspn(line, "#\r\n")] = '\0';
+
+            while (*p)
+            {
+                if (isspace((unsigned char)*p) || (*p == ':'))
+                {
+                    p++;
+                }
+                else if (isxdigit((unsigned char)p[0]) &&
+                         isxdigit((unsigned char)p[1]) &&
+                         (sscanf(p, "%2x%n", &byte, &n) == 1))
+                {
+                    if (len == size)
+                    {
+                        size += SIM_TRACE_CHUNK;
+                        pTrace = realloc(pTrace, size);
+                    }
+
+                    pTrace[len++] = (uint8_t)byte;
+                    p += n;
+                }
+                else
+                {
+                    fprintf(stderr, "%s:%u: not a hex byte: %s\n", pPath,
+                            lineNum, p);
+                    fclose(pFile);
+                    free(pTrace);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    fclose(pFile);
+
+    *ppTrace = pTrace;
+    *pLen = len;
+
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      SimTrace_save
+ *
+ * @brief   Write a binary trace file.
+ *
+ * @param   pPath - file
+ * @param   pTrace - trace
+ * @param   len - trace length
+ *
+ * @return  0, or -1 when the file can not be written
+ */
+int SimTrace_save(const char *pPath, const uint8_t *pTrace, uint32_t len)
+{
+    FILE *pFile = fopen(pPath, "wb");
+
+    if ((pFile == NULL) || (fwrite(pTrace, 1, len, pFile) != len) ||
+        (fclose(pFile) != 0))
+    {
+        perror(pPath);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      SimTrace_decode
+ *
+ * @brief   Decode a trace. A trace that does not start with a start
+ *          record, or is cut in a record, is decoded up to there.
+ *
+ * @param   pTrace - trace
+ * @param   len - trace length
+ * @param   ppRecs - records, allocated
+ * @param   pNumRecs - number of records
+ *
+ * @return  0, or -1 when the trace is not valid
+ */
+int SimTrace_decode(const uint8_t *pTrace, uint32_t len,
+                    simTraceRec_t **ppRecs, uint32_t *pNumRecs)
+{
+    simTraceRec_t *pRecs = NULL;
+    uint32_t numRecs = 0;
+    uint32_t size = 0;
+    uint32_t pos = 0;
+    uint64_t ticks = 0;
+    uint32_t tickUs = Clock_tickPeriod;
+    uint16_t adc[INPUT_TRACE_NUM_ADC];
+    simTraceRec_t rpts[INPUT_TRACE_NUM_RPTS];
+    uint8_t numRpts = 0;
+    int status = 0;
+
+    memset(adc, 0, sizeof(adc));
+    memset(rpts, 0, sizeof(rpts));
+
+    while (pos < len)
+    {
+        uint32_t start = pos;
+        simTraceRec_t rec;
+        uint32_t delta;
+        uint32_t value;
+        uint32_t mask;
+        uint8_t slot;
+        uint8_t i;
+
+        memset(&rec, 0, sizeof(rec));
+        rec.type = pTrace[pos++];
+
+        if (((numRecs == 0) && (rec.type != INPUT_TRACE_REC_START)) ||
+            SimTrace_getVar(pTrace, len, &pos, &delta))
+        {
+            status = -1;
+            break;
+        }
+
+        ticks += delta;
+
+        switch (rec.type)
+        {
+            case INPUT_TRACE_REC_START:
+                if (SimTrace_getByte(pTrace, len, &pos, &i) ||
+                    SimTrace_getVar(pTrace, len, &pos, &tickUs) ||
+                    SimTrace_getVar(pTrace, len, &pos, &value) ||
+                    (i != INPUT_TRACE_VERSION) || (tickUs == 0))
+                {
+                    status = -1;
+                    break;
+                }
+
+                rec.value = i;
+                ticks = value;
+                numRpts = 0;
+                memset(adc, 0, sizeof(adc));
+                memset(rpts, 0, sizeof(rpts));
+                break;
+
+            case INPUT_TRACE_REC_ADC:
+                if (SimTrace_getByte(pTrace, len, &pos, &rec.channel) ||
+                    SimTrace_getVar(pTrace, len, &pos, &value) ||
+                    (rec.channel >= INPUT_TRACE_NUM_ADC))
+                {
+                    status = -1;
+                    break;
+                }
+
+                adc[rec.channel] += (uint16_t)((value >> 1) ^ -(value & 1));
+                rec.value = adc[rec.channel];
+                break;
+
+            case INPUT_TRACE_REC_KEYS:
+            case INPUT_TRACE_REC_SENT:
+                if (SimTrace_getByte(pTrace, len, &pos, &i))
+                {
+                    status = -1;
+                    break;
+                }
+
+                rec.value = i;
+                break;
+
+            case INPUT_TRACE_REC_REPORT:
+                if (SimTrace_getByte(pTrace, len, &pos, &rec.id) ||
+                    SimTrace_getByte(pTrace, len, &pos, &rec.rptType) ||
+                    SimTrace_getByte(pTrace, len, &pos, &rec.len) ||
+                    SimTrace_getVar(pTrace, len, &pos, &mask) ||
+                    (rec.len > INPUT_TRACE_RPT_LEN))
+                {
+                    status = -1;
+                    break;
+                }
+
+                // Same slots as InputTrace_report
+                for (slot = 0; slot < numRpts; slot++)
+                {
+                    if ((rpts[slot].id == rec.id) &&
+                        (rpts[slot].rptType == rec.rptType))
+                    {
+                        memcpy(rec.data, rpts[slot].data, rec.len);
+                        break;
+                    }
+                }
+
+                for (i = 0; (i < rec.len) && (status == 0); i++)
+                {
+                    if ((mask & ((uint32_t)1 << i)) &&
+                        SimTrace_getByte(pTrace, len, &pos, &rec.data[i]))
+                    {
+                        status = -1;
+                    }
+                }
+
+                if (status != 0)
+                {
+                    break;
+                }
+
+                if (slot >= numRpts)
+                {
+                    if (numRpts < INPUT_TRACE_NUM_RPTS)
+                    {
+                        numRpts++;
+                    }
+                    slot = numRpts - 1;
+                }
+
+                rpts[slot] = rec;
+                break;
+
+            case INPUT_TRACE_REC_LINK:
+                if (SimTrace_getByte(pTrace, len, &pos, &i))
+                {
+                    status = -1;
+                    break;
+                }
+
+                rec.value = i;
+
+                if (i == INPUT_TRACE_LINK_UP)
+                {
+                    uint32_t interval, latency, timeout;
+
+                    if (SimTrace_getVar(pTrace, len, &pos, &interval) ||
+                        SimTrace_getVar(pTrace, len, &pos, &latency) ||
+                        SimTrace_getVar(pTrace, len, &pos, &timeout))
+                    {
+                        status = -1;
+                        break;
+                    }
+
+                    rec.interval = (uint16_t)interval;
+                    rec.latency = (uint16_t)latency;
+                    rec.timeout = (uint16_t)timeout;
+                }
+                break;
+
+            case INPUT_TRACE_REC_LOST:
+                if (SimTrace_getVar(pTrace, len, &pos, &rec.value))
+                {
+                    status = -1;
+                }
+                break;
+
+            default:
+                status = -1;
+                break;
+        }
+
+        if (status != 0)
+        {
+            fprintf(stderr, "bad trace record 0x%02x at byte %u\n", rec.type,
+                    start);
+            break;
+        }
+
+        rec.timeUs = ticks * tickUs;
+
+        if (numRecs == size)
+        {
+            size += SIM_TRACE_CHUNK;
+            pRecs = realloc(pRecs, size * sizeof(simTraceRec_t));
+        }
+
+        pRecs[numRecs++] = rec;
+    }
+
+    *ppRecs = pRecs;
+    *pNumRecs = numRecs;
+
+    return status;
+}
+
+/*********************************************************************
+ * @fn      SimTrace_print
+ *
+ * @brief   Print a record.
+ *
+ * @param   pFile - output
+ * @param   pRec - record
+ *
+ * @return  none
+ */
+void SimTrace_print(FILE *pFile, const simTraceRec_t *pRec)
+{
+    static const char *linkStates[] = { "down", "up", "secure" };
+    uint8_t i;
+
+    fprintf(pFile, "%10.3f  ", pRec->timeUs / 1000.0);
+
+    switch (pRec->type)
+    {
+        case INPUT_TRACE_REC_START:
+            fprintf(pFile, "start   version %u\n", pRec->value);
+            break;
+
+        case INPUT_TRACE_REC_ADC:
+            fprintf(pFile, "adc     %u %u\n", pRec->channel, pRec->value);
+            break;
+
+        case INPUT_TRACE_REC_KEYS:
+            fprintf(pFile, "keys    0x%02x\n", pRec->value);
+            break;
+
+        case INPUT_TRACE_REC_REPORT:
+            fprintf(pFile, "report  id %u type %u:", pRec->id, pRec->rptType);
+            for (i = 0; i < pRec->len; i++)
+            {
+                fprintf(pFile, " %02x", pRec->data[i]);
+            }
+            fprintf(pFile, "\n");
+            break;
+
+        case INPUT_TRACE_REC_SENT:
+            fprintf(pFile, "sent    status 0x%02x\n", pRec->value);
+            break;
+
+        case INPUT_TRACE_REC_LINK:
+            fprintf(pFile, "link    %s", (pRec->value <= INPUT_TRACE_LINK_SECURE) ?
+                    linkStates[pRec->value] : "?");
+            if (pRec->value == INPUT_TRACE_LINK_UP)
+            {
+                fprintf(pFile, " interval %u latency %u timeout %u",
+                        pRec->interval, pRec->latency, pRec->timeout);
+            }
+            fprintf(pFile, "\n");
+            break;
+
+        case INPUT_TRACE_REC_LOST:
+            fprintf(pFile, "lost    %u records\n", pRec->value);
+            break;
+    }
+}
+
+/*********************************************************************
+*********************************************************************/
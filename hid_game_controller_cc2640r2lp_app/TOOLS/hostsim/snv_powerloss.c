@@ -0,0 +1,644 @@
+/******************************************************************************
+
+ @file       snv_powerloss.c
+
+ @brief This file contains the power loss test of the configuration store
+        on the simulated SNV. Items of the sizes the application stores
+        are flushed from an old value to a new one, and the power is cut
+        after every byte the flush programs, with the page empty and with
+        the page so full that the flush compacts it. After the power up
+        every item must load as its old or its new value, never a mix or
+        its default, and the items before the cut must have the new one.
+
+        Then a flipped bit, a record of another layout version and a
+        value the check rejects must load as the default; changes made
+        within the flush delay must cost one flush and one record each,
+        a value switched back none at all, and no flush may run while it
+        is held. The wear of changes made in bursts is printed.
+
+        Usage: snv_powerloss [-v]
+
+          -v  print the SNV writes and compactions
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Power loss test of the configuration store on the
+                        host simulation.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "util.h"
+#include "cfgstore.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Items: key bindings, input settings, connection parameters,
+// advertising parameters and modes of the application
+#define PL_NUM_ITEMS                    5
+#define PL_NVID_FIRST                   (BLE_NVID_CUST_START + 1)
+#define PL_VERSION                      1
+
+// Other item filling the page before the flush
+#define PL_NVID_FILL                    BLE_NVID_CUST_END
+#define PL_FILL_LEN                     32
+
+// Values: defaults, the old and the new one
+#define PL_GEN_DEFAULT                  0
+#define PL_GEN_OLD                      1
+#define PL_GEN_NEW                      2
+
+// First byte of a value the check rejects in strict mode
+#define PL_REJECTED                     0xEE
+
+#define PL_FLUSH_EVT                    Event_Id_00
+
+// Wear runs: bursts of changes, changes per burst and the pause after
+// one in ms
+#define PL_WEAR_BURSTS                  1000
+#define PL_WEAR_CHANGES                 8
+#define PL_WEAR_PAUSE                   (CFG_FLUSH_DELAY + 1000)
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static const uint8_t plItemLen[PL_NUM_ITEMS] = { 8, 4, 8, 18, 2 };
+
+static uint8_t plValue[PL_NUM_ITEMS][CFG_MAX_ITEM_LEN];
+static cfgItem_t plItems[PL_NUM_ITEMS];
+
+// Values with PL_REJECTED fail the check
+static bool plStrict = FALSE;
+
+// Flush requests of the store, and the task running the flushes
+static uint32_t plFlushRequests = 0;
+static Event_Struct plEvent;
+static Task_Struct plTask;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Pl_fail
+ *
+ * @brief   Report a failed check and exit.
+ *
+ * @param   fmt - printf format
+ *
+ * @return  none
+ */
+static void Pl_fail(const char *fmt, ...)
+{
+    va_list ap;
+
+    printf("snv_powerloss: FAIL: ");
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    putchar('\n');
+
+    exit(1);
+}
+
+/*********************************************************************
+ * @fn      Pl_pattern
+ *
+ * @brief   Fill in a value of an item.
+ *
+ * @param   item - item index
+ * @param   gen - PL_GEN_*
+ * @param   pValue - value
+ *
+ * @return  none
+ */
+static void Pl_pattern(uint8_t item, uint8_t gen, uint8_t *pValue)
+{
+    uint8_t i;
+
+    for (i = 0; i < plItemLen[item]; i++)
+    {
+        pValue[i] = (uint8_t)(gen * 0x35 + item * 0x11 + i);
+    }
+}
+
+/*********************************************************************
+ * @fn      Pl_is
+ *
+ * @brief   Check the value of an item in RAM.
+ *
+ * @param   item - item index
+ * @param   gen - PL_GEN_*
+ *
+ * @return  TRUE if the item has the value
+ */
+static bool Pl_is(uint8_t item, uint8_t gen)
+{
+    uint8_t value[CFG_MAX_ITEM_LEN];
+
+    Pl_pattern(item, gen, value);
+
+    return (memcmp(plValue[item], value, plItemLen[item]) == 0);
+}
+
+/*********************************************************************
+ * @fn      Pl_set
+ *
+ * @brief   Change an item through the store.
+ *
+ * @param   item - item index
+ * @param   gen - PL_GEN_*
+ *
+ * @return  none
+ */
+static void Pl_set(uint8_t item, uint8_t gen)
+{
+    uint8_t value[CFG_MAX_ITEM_LEN];
+
+    Pl_pattern(item, gen, value);
+
+    if (Cfg_set(item, value) != SUCCESS)
+    {
+        Pl_fail("item %u refused", item);
+    }
+}
+
+/*********************************************************************
+ * @fn      Pl_setAll
+ *
+ * @brief   Change all the items.
+ *
+ * @param   gen - PL_GEN_*
+ *
+ * @return  none
+ */
+static void Pl_setAll(uint8_t gen)
+{
+    uint8_t i;
+
+    for (i = 0; i < PL_NUM_ITEMS; i++)
+    {
+        Pl_set(i, gen);
+    }
+}
+
+/*********************************************************************
+ * @fn      Pl_valid
+ *
+ * @brief   Value check of the items.
+ *
+ * @param   pValue - value
+ *
+ * @return  TRUE if valid
+ */
+static uint8_t Pl_valid(const void *pValue)
+{
+    return (!plStrict || (*(const uint8_t *)pValue != PL_REJECTED));
+}
+
+/*********************************************************************
+ * @fn      Pl_flushCB
+ *
+ * @brief   Run the flush in the task, as the application does.
+ *
+ * @return  none
+ */
+static void Pl_flushCB(void)
+{
+    plFlushRequests++;
+    Event_post(&plEvent, PL_FLUSH_EVT);
+}
+
+/*********************************************************************
+ * @fn      Pl_taskFxn
+ *
+ * @brief   Task running the flushes.
+ *
+ * @param   a0, a1 - not used
+ *
+ * @return  none
+ */
+static void Pl_taskFxn(UArg a0, UArg a1)
+{
+    for (;;)
+    {
+        Event_pend(&plEvent, Event_Id_NONE, PL_FLUSH_EVT, BIOS_WAIT_FOREVER);
+        Cfg_flush();
+    }
+}
+
+/*********************************************************************
+ * @fn      Pl_boot
+ *
+ * @brief   Power up: defaults in RAM, then the store loads the items.
+ *
+ * @param   version - layout version of the items
+ * @param   pStats - store statistics after the load, may be NULL
+ *
+ * @return  none
+ */
+static void Pl_boot(uint8_t version, cfgStats_t *pStats)
+{
+    uint8_t i;
+
+    SimSnv_powerUp();
+
+    for (i = 0; i < PL_NUM_ITEMS; i++)
+    {
+        Pl_pattern(i, PL_GEN_DEFAULT, plValue[i]);
+
+        plItems[i].nvId = PL_NVID_FIRST + i;
+        plItems[i].version = version;
+        plItems[i].len = plItemLen[i];
+        plItems[i].pValue = plValue[i];
+        plItems[i].pfnValid = Pl_valid;
+    }
+
+    plEvent.posted = 0;
+    Cfg_init(plItems, PL_NUM_ITEMS, Pl_flushCB);
+
+    if (pStats != NULL)
+    {
+        Cfg_getStats(pStats);
+    }
+}
+
+/*********************************************************************
+ * @fn      Pl_fill
+ *
+ * @brief   Write copies of another item until the page holds this many
+ *          bytes. The last copy is checked after the power loss.
+ *
+ * @param   used - bytes of the page in use
+ *
+ * @return  Value of the last copy, its first byte
+ */
+static uint8_t Pl_fill(uint16_t used)
+{
+    uint8_t value[PL_FILL_LEN];
+    simSnvStats_t snv;
+    uint8_t n = 0;
+
+    for (;;)
+    {
+        SimSnv_getStats(&snv);
+
+        if (snv.used + PL_FILL_LEN + 3 > used)
+        {
+            return n;
+        }
+
+        memset(value, ++n, sizeof(value));
+        osal_snv_write(PL_NVID_FILL, sizeof(value), value);
+    }
+}
+
+/*********************************************************************
+ * @fn      Pl_flushBytes
+ *
+ * @brief   Measure the bytes a flush of the new values programs.
+ *
+ * @param   used - bytes in use before the old values are flushed
+ * @param   pCompactions - compactions of the flush
+ *
+ * @return  bytes
+ */
+static uint32_t Pl_flushBytes(uint16_t used, uint32_t *pCompactions)
+{
+    simSnvStats_t before, after;
+
+    SimSnv_erase();
+    Pl_fill(used);
+    Pl_boot(PL_VERSION, NULL);
+    Pl_setAll(PL_GEN_OLD);
+    Cfg_flush();
+
+    SimSnv_getStats(&before);
+    Pl_setAll(PL_GEN_NEW);
+    Cfg_flush();
+    SimSnv_getStats(&after);
+
+    *pCompactions = after.compactions - before.compactions;
+
+    return after.bytes - before.bytes;
+}
+
+/*********************************************************************
+ * @fn      Pl_powerLoss
+ *
+ * @brief   Cut the power after every byte of a flush from the old values
+ *          to the new ones and check the items after the power up.
+ *
+ * @param   used - bytes in use before the old values are flushed
+ *
+ * @return  Cut points tested
+ */
+static uint32_t Pl_powerLoss(uint16_t used)
+{
+    uint32_t compactions;
+    uint32_t bytes = Pl_flushBytes(used, &compactions);
+    uint8_t fill[PL_FILL_LEN];
+    uint8_t fillValue;
+    uint32_t cut;
+    uint8_t i;
+    bool old;
+
+    for (cut = 0; cut <= bytes; cut++)
+    {
+        SimSnv_erase();
+        fillValue = Pl_fill(used);
+        Pl_boot(PL_VERSION, NULL);
+        Pl_setAll(PL_GEN_OLD);
+        Cfg_flush();
+
+        SimSnv_cutAfter(cut);
+        Pl_setAll(PL_GEN_NEW);
+        Cfg_flush();
+
+        Pl_boot(PL_VERSION, NULL);
+
+        // The items are written in order, the new values end at the cut
+        old = FALSE;
+        for (i = 0; i < PL_NUM_ITEMS; i++)
+        {
+            if (Pl_is(i, PL_GEN_OLD))
+            {
+                old = TRUE;
+            }
+            else if (!Pl_is(i, PL_GEN_NEW) || old)
+            {
+                Pl_fail("page %u cut after %u of %u bytes: item %u neither "
+                        "old nor new, or new after an old one", used, cut,
+                        bytes, i);
+            }
+        }
+
+        if ((cut == bytes) && old)
+        {
+            Pl_fail("page %u: flush of %u bytes not complete", used, bytes);
+        }
+
+        if (fillValue &&
+            ((osal_snv_read(PL_NVID_FILL, sizeof(fill), fill) != SUCCESS) ||
+             (fill[0] != fillValue) || (fill[PL_FILL_LEN - 1] != fillValue)))
+        {
+            Pl_fail("page %u cut after %u bytes: other item lost", used, cut);
+        }
+    }
+
+    printf("snv_powerloss: page %4u bytes used, flush of %u bytes with %u "
+           "compactions, %u cut points passed\n", used, bytes, compactions,
+           bytes + 1);
+
+    return bytes + 1;
+}
+
+/*********************************************************************
+ * @fn      Pl_defaults
+ *
+ * @brief   Check that a flipped bit, another layout version and a value
+ *          the check rejects load as the default.
+ *
+ * @return  none
+ */
+static void Pl_defaults(void)
+{
+    uint8_t value[CFG_MAX_ITEM_LEN];
+    cfgStats_t stats;
+    uint8_t i;
+
+    // Flipped bit in item 0
+    SimSnv_erase();
+    Pl_boot(PL_VERSION, NULL);
+    Pl_setAll(PL_GEN_OLD);
+    Cfg_flush();
+    SimSnv_corrupt(PL_NVID_FIRST);
+    Pl_boot(PL_VERSION, &stats);
+
+    if (!Pl_is(0, PL_GEN_DEFAULT) || (stats.rejected != 1) ||
+        (stats.loaded != PL_NUM_ITEMS - 1))
+    {
+        Pl_fail("corrupted record loaded");
+    }
+
+    for (i = 1; i < PL_NUM_ITEMS; i++)
+    {
+        if (!Pl_is(i, PL_GEN_OLD))
+        {
+            Pl_fail("item %u lost with the corrupted one", i);
+        }
+    }
+
+    // Layout version stepped
+    Pl_boot(PL_VERSION + 1, &stats);
+
+    for (i = 0; i < PL_NUM_ITEMS; i++)
+    {
+        if (!Pl_is(i, PL_GEN_DEFAULT))
+        {
+            Pl_fail("item %u of another version loaded", i);
+        }
+    }
+
+    // Value stored before the check got stricter
+    SimSnv_erase();
+    Pl_boot(PL_VERSION, NULL);
+    Pl_pattern(0, PL_GEN_OLD, value);
+    value[0] = PL_REJECTED;
+    Cfg_set(0, value);
+    Cfg_flush();
+    plStrict = TRUE;
+    Pl_boot(PL_VERSION, &stats);
+    plStrict = FALSE;
+
+    if (!Pl_is(0, PL_GEN_DEFAULT) || (stats.rejected != 1))
+    {
+        Pl_fail("rejected value loaded");
+    }
+
+    printf("snv_powerloss: corrupted, old version and rejected records load "
+           "the defaults\n");
+}
+
+/*********************************************************************
+ * @fn      Pl_coalesce
+ *
+ * @brief   Check that changes within the flush delay make one flush, a
+ *          value switched back no write and the hold keeps the flush
+ *          back.
+ *
+ * @return  none
+ */
+static void Pl_coalesce(void)
+{
+    cfgStats_t stats;
+    uint32_t requests;
+    uint8_t i;
+
+    SimSnv_erase();
+    Pl_boot(PL_VERSION, NULL);
+    plFlushRequests = 0;
+
+    // A mode switched 20 times and a binding changed: one flush, two
+    // records
+    for (i = 0; i < 20; i++)
+    {
+        Pl_set(4, (i & 1) ? PL_GEN_NEW : PL_GEN_OLD);
+    }
+    Pl_set(0, PL_GEN_NEW);
+
+    SimRtos_run(SimRtos_now() + SIM_MS(CFG_FLUSH_DELAY + 100));
+    Cfg_getStats(&stats);
+
+    if ((plFlushRequests != 1) || (stats.flushes != 1) ||
+        (stats.writes != 2))
+    {
+        Pl_fail("%u requests, %u flushes, %u writes for one burst",
+                plFlushRequests, stats.flushes, stats.writes);
+    }
+
+    // Switched back and forth: nothing written
+    Pl_set(4, PL_GEN_OLD);
+    Pl_set(4, PL_GEN_NEW);
+    Pl_set(0, PL_GEN_OLD);
+    Pl_set(0, PL_GEN_NEW);
+    SimRtos_run(SimRtos_now() + SIM_MS(CFG_FLUSH_DELAY + 100));
+    Cfg_getStats(&stats);
+
+    if ((stats.writes != 2) || (stats.unchanged != 2))
+    {
+        Pl_fail("%u writes, %u unchanged after switching back",
+                stats.writes, stats.unchanged);
+    }
+
+    // Held: the flush waits for the end of the hold
+    Cfg_setHold(TRUE);
+    Pl_set(1, PL_GEN_NEW);
+    requests = plFlushRequests;
+    SimRtos_run(SimRtos_now() + SIM_MS(3 * CFG_FLUSH_DELAY));
+
+    if (plFlushRequests != requests)
+    {
+        Pl_fail("flush requested while held");
+    }
+
+    Cfg_setHold(FALSE);
+    SimRtos_run(SimRtos_now() + SIM_MS(1));
+    Cfg_getStats(&stats);
+
+    if ((plFlushRequests != requests + 1) || (stats.writes != 3))
+    {
+        Pl_fail("held flush not run at the end of the hold");
+    }
+
+    printf("snv_powerloss: %u changes in %u flushes, %u records written, "
+           "%u coalesced, %u unchanged\n", stats.changes, stats.flushes,
+           stats.writes, stats.coalesced, stats.unchanged);
+}
+
+/*********************************************************************
+ * @fn      Pl_wear
+ *
+ * @brief   Print the SNV wear of bursts of mode changes, written with
+ *          the flush delay and as each change is made.
+ *
+ * @return  none
+ */
+static void Pl_wear(void)
+{
+    simSnvStats_t deferred, direct;
+    uint32_t burst;
+    uint8_t i;
+
+    SimSnv_erase();
+    Pl_boot(PL_VERSION, NULL);
+
+    for (burst = 0; burst < PL_WEAR_BURSTS; burst++)
+    {
+        for (i = 0; i < PL_WEAR_CHANGES; i++)
+        {
+            Pl_set(4, ((burst + i) & 1) ? PL_GEN_NEW : PL_GEN_OLD);
+        }
+        SimRtos_run(SimRtos_now() + SIM_MS(PL_WEAR_PAUSE));
+    }
+
+    SimSnv_getStats(&deferred);
+
+    SimSnv_erase();
+    Pl_boot(PL_VERSION, NULL);
+
+    for (burst = 0; burst < PL_WEAR_BURSTS; burst++)
+    {
+        for (i = 0; i < PL_WEAR_CHANGES; i++)
+        {
+            Pl_set(4, ((burst + i) & 1) ? PL_GEN_NEW : PL_GEN_OLD);
+            Cfg_flush();
+        }
+    }
+
+    SimSnv_getStats(&direct);
+
+    printf("snv_powerloss: %u bursts of %u changes: deferred %u writes, "
+           "%u bytes, %u erases; each change %u writes, %u bytes, "
+           "%u erases\n", PL_WEAR_BURSTS, PL_WEAR_CHANGES, deferred.writes,
+           deferred.bytes, deferred.compactions, direct.writes, direct.bytes,
+           direct.compactions);
+
+    if (deferred.writes > PL_WEAR_BURSTS)
+    {
+        Pl_fail("more than one write per burst");
+    }
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the tests.
+ *
+ * @return  Zero when all pass
+ */
+int main(int argc, char *argv[])
+{
+    Task_Params taskParams;
+    uint32_t compactions;
+    uint32_t bytes;
+    uint32_t cuts = 0;
+
+    simLogMask = ((argc > 1) && (strcmp(argv[1], "-v") == 0)) ?
+                 SIM_LOG_EVENT : 0;
+
+    Task_Params_init(&taskParams);
+    Task_construct(&plTask, Pl_taskFxn, &taskParams, NULL);
+
+    // Empty page, then a page the old values fit in and the new ones do
+    // not, the flush compacts it half way
+    cuts += Pl_powerLoss(0);
+    bytes = Pl_flushBytes(0, &compactions);
+    cuts += Pl_powerLoss(SIM_SNV_PAGE_SIZE - bytes - bytes / 2);
+
+    Pl_defaults();
+    Pl_coalesce();
+    Pl_wear();
+
+    printf("snv_powerloss: passed, %u power loss points\n", cuts);
+
+    return 0;
+}
+
+/*********************************************************************
+*********************************************************************/
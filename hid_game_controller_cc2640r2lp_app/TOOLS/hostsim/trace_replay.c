@@ -0,0 +1,598 @@
+/******************************************************************************
+
+ @file       trace_replay.c
+
+ @brief This file contains the input trace replay of the host simulation.
+        It feeds the joystick samples, key edges and link changes of a
+        trace recorded on the device to the application, runs it in
+        virtual time as the scenario runner does, and compares the
+        reports the application builds with the reports of the trace.
+
+        Usage: tracereplay [-v] [-p] [-t tolerance] [-o replay] TRACE
+
+          -v  print the simulation log
+          -p  print the records of TRACE and exit
+          -t  time difference in ms allowed between a report of the trace
+              and its replay, default 50
+          -o  write the trace of the replay to the file replay
+
+        TRACE is a binary trace or a hex dump of the trace notifications,
+        see sim_trace.c, and may end in the middle of a record. The exit
+        status is 0 when every report of the trace was built again with
+        the same content within the time tolerance, 1 when not, 2 when
+        TRACE can not be read.
+
+        Every joystick sample is set right after the previous sample of
+        its channel, so the application reads it even when its sampling
+        drifts. Only the first session of the trace, up to a restart of the
+        device, is replayed.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+
+ Project: BLE Game Controller
+ Modification Details : Record the joystick samples, key edges, reports and
+                        send outcomes in a compact binary trace, drained
+                        through the diagnostic service and replayed on the
+                        host simulation (TOOLS/hostsim/trace_replay.c).
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_trace.h"
+#include "hidgamecontroller.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Default time tolerance of the reports in ms
+#define REPLAY_DEFAULT_TOLERANCE_MS     50
+
+// Differences printed
+#define REPLAY_MAX_PRINTED              20
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Sends of a trace
+typedef struct
+{
+    uint32_t ok;
+    uint32_t failed;
+} replaySends_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Keys the replay holds pressed
+static uint8_t replayKeys = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      Replay_ticks
+ *
+ * @brief   Convert a time of the trace to virtual time.
+ *
+ * @param   timeUs - time since the start record
+ *
+ * @return  Ticks
+ */
+static uint64_t Replay_ticks(uint64_t timeUs)
+{
+    return timeUs / Clock_tickPeriod;
+}
+
+/*********************************************************************
+ * @fn      Replay_adc
+ *
+ * @brief   Set a joystick sample.
+ *
+ * @param   arg - simTraceRec_t of the sample
+ *
+ * @return  none
+ */
+static void Replay_adc(uintptr_t arg)
+{
+    const simTraceRec_t *pRec = (const simTraceRec_t *)arg;
+
+    SimIo_setAdc(pRec->channel, (uint16_t)pRec->value);
+}
+
+/*********************************************************************
+ * @fn      Replay_keys
+ *
+ * @brief   Make the key edges of a key record. The keys not in the
+ *          record are released first; when that leaves no key to press,
+ *          all keys are released so the interrupt sees an edge again.
+ *
+ * @param   arg - KEY_* mask of the record
+ *
+ * @return  none
+ */
+static void Replay_keys(uintptr_t arg)
+{
+    uint8_t keys = (uint8_t)arg;
+    uint8_t held = replayKeys & keys;
+
+    SimRtos_log(SIM_LOG_EVENT, "sim   keys 0x%02x", keys);
+
+    SimIo_setKeys((keys & ~held) ? held : 0);
+    SimIo_setKeys(keys);
+    replayKeys = keys;
+}
+
+/*********************************************************************
+ * @fn      Replay_connect
+ *
+ * @brief   Connect with the parameters of a LINK UP record.
+ *
+ * @param   arg - simTraceRec_t of the record
+ *
+ * @return  none
+ */
+static void Replay_connect(uintptr_t arg)
+{
+    const simTraceRec_t *pRec = (const simTraceRec_t *)arg;
+
+    SimRtos_log(SIM_LOG_EVENT, "sim   connect interval %u latency %u "
+                "timeout %u", pRec->interval, pRec->latency, pRec->timeout);
+    SimBle_connect(pRec->interval ? pRec->interval : SIM_DEFAULT_CONN_INTERVAL,
+                   pRec->latency,
+                   pRec->timeout ? pRec->timeout : SIM_DEFAULT_CONN_TIMEOUT);
+}
+
+static void Replay_pair(uintptr_t arg)
+{
+    SimRtos_log(SIM_LOG_EVENT, "sim   pair");
+    SimBle_pair();
+}
+
+static void Replay_enable(uintptr_t arg)
+{
+    SimBle_enableNotifications();
+}
+
+static void Replay_disconnect(uintptr_t arg)
+{
+    SimRtos_log(SIM_LOG_EVENT, "sim   disconnect");
+    SimBle_disconnect();
+}
+
+/*********************************************************************
+ * @fn      Replay_schedule
+ *
+ * @brief   Schedule the inputs of the first session of a trace.
+ *
+ * @param   pRecs - records
+ * @param   numRecs - number of records
+ *
+ * @return  Number of records of the first session
+ */
+static uint32_t Replay_schedule(const simTraceRec_t *pRecs, uint32_t numRecs)
+{
+    uint64_t adcTime[INPUT_TRACE_NUM_ADC];
+    uint64_t upTime = 0;
+    uint8_t secure = FALSE;
+    uint64_t t0 = pRecs[0].timeUs;
+    uint32_t i;
+
+    memset(adcTime, 0, sizeof(adcTime));
+
+    for (i = 1; i < numRecs; i++)
+    {
+        const simTraceRec_t *pRec = &pRecs[i];
+        uint64_t t = Replay_ticks(pRec->timeUs - t0);
+
+        if (pRec->type == INPUT_TRACE_REC_START)
+        {
+            break;
+        }
+
+        switch (pRec->type)
+        {
+            case INPUT_TRACE_REC_ADC:
+                SimRtos_defer(adcTime[pRec->channel], Replay_adc,
+                              (uintptr_t)pRec);
+                adcTime[pRec->channel] = t + 1;
+                break;
+
+            case INPUT_TRACE_REC_KEYS:
+                SimRtos_defer(t, Replay_keys, pRec->value);
+                break;
+
+            case INPUT_TRACE_REC_LINK:
+                if (pRec->value == INPUT_TRACE_LINK_UP)
+                {
+                    SimRtos_defer(t, Replay_connect, (uintptr_t)pRec);
+                    upTime = t;
+                    secure = FALSE;
+                }
+                else if ((pRec->value == INPUT_TRACE_LINK_SECURE) && !secure)
+                {
+                    // Pair so that the link is encrypted at the time of
+                    // the record, then enable the reports
+                    uint64_t pairTime = (t > upTime + SIM_MS(SIM_PAIRING_TIME)) ?
+                                        t - SIM_MS(SIM_PAIRING_TIME) :
+                                        upTime + 1;
+
+                    SimRtos_defer(pairTime, Replay_pair, 0);
+                    SimRtos_defer(pairTime + SIM_MS(SIM_PAIRING_TIME) + 1,
+                                  Replay_enable, 0);
+                    secure = TRUE;
+                }
+                else if (pRec->value == INPUT_TRACE_LINK_DOWN)
+                {
+                    SimRtos_defer(t, Replay_disconnect, 0);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return i;
+}
+
+/*********************************************************************
+ * @fn      Replay_reports
+ *
+ * @brief   Collect the reports of the first session of a trace and count
+ *          its sends and lost records.
+ *
+ * @param   pRecs - records
+ * @param   numRecs - number of records
+ * @param   endUs - time of the last report taken, since the start record
+ * @param   ppRpts - reports, allocated, times since the start record
+ * @param   pSends - sends
+ * @param   pLost - lost records
+ *
+ * @return  Number of reports
+ */
+static uint32_t Replay_reports(const simTraceRec_t *pRecs, uint32_t numRecs,
+                               uint64_t endUs, simTraceRec_t **ppRpts,
+                               replaySends_t *pSends, uint32_t *pLost)
+{
+    simTraceRec_t *pRpts = malloc((numRecs + 1) * sizeof(simTraceRec_t));
+    uint32_t numRpts = 0;
+    uint32_t i;
+
+    memset(pSends, 0, sizeof(replaySends_t));
+    *pLost = 0;
+
+    for (i = 1; (i < numRecs) && (pRecs[i].type != INPUT_TRACE_REC_START); i++)
+    {
+        simTraceRec_t rec = pRecs[i];
+
+        rec.timeUs -= pRecs[0].timeUs;
+
+        if (rec.timeUs > endUs)
+        {
+            break;
+        }
+
+        if (rec.type == INPUT_TRACE_REC_REPORT)
+        {
+            pRpts[numRpts++] = rec;
+        }
+        else if (rec.type == INPUT_TRACE_REC_SENT)
+        {
+            if (rec.value == SUCCESS)
+            {
+                pSends->ok++;
+            }
+            else
+            {
+                pSends->failed++;
+            }
+        }
+        else if (rec.type == INPUT_TRACE_REC_LOST)
+        {
+            *pLost += rec.value;
+        }
+    }
+
+    *ppRpts = pRpts;
+
+    return numRpts;
+}
+
+/*********************************************************************
+ * @fn      Replay_same
+ *
+ * @brief   Compare the content of two reports.
+ *
+ * @return  TRUE when they are the same
+ */
+static bool Replay_same(const simTraceRec_t *pA, const simTraceRec_t *pB)
+{
+    return (pA->id == pB->id) && (pA->rptType == pB->rptType) &&
+           (pA->len == pB->len) && (memcmp(pA->data, pB->data, pA->len) == 0);
+}
+
+/*********************************************************************
+ * @fn      Replay_printDiff
+ *
+ * @brief   Print a difference.
+ *
+ * @param   pWhat - kind of difference
+ * @param   pExpected - report of the trace, or NULL
+ * @param   pReplayed - report of the replay, or NULL
+ *
+ * @return  none
+ */
+static void Replay_printDiff(const char *pWhat,
+                             const simTraceRec_t *pExpected,
+                             const simTraceRec_t *pReplayed)
+{
+    printf("%s\n", pWhat);
+
+    if (pExpected)
+    {
+        printf("  trace  ");
+        SimTrace_print(stdout, pExpected);
+    }
+
+    if (pReplayed)
+    {
+        printf("  replay ");
+        SimTrace_print(stdout, pReplayed);
+    }
+}
+
+/*********************************************************************
+ * @fn      Replay_compare
+ *
+ * @brief   Compare the reports of the trace with those of the replay.
+ *          Both are walked in time order: reports within the tolerance of
+ *          each other are paired, and differ when their content does; a
+ *          report with no counterpart within the tolerance is missing
+ *          from the replay, or extra in it.
+ *
+ * @param   pExp - reports of the trace
+ * @param   numExp - number of reports of the trace
+ * @param   pGot - reports of the replay
+ * @param   numGot - number of reports of the replay
+ * @param   toleranceUs - time tolerance
+ *
+ * @return  Number of differences
+ */
+static uint32_t Replay_compare(const simTraceRec_t *pExp, uint32_t numExp,
+                               const simTraceRec_t *pGot, uint32_t numGot,
+                               uint64_t toleranceUs)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t matched = 0;
+    uint32_t differ = 0;
+    uint32_t missing = 0;
+    uint32_t extra = 0;
+    uint32_t printed = 0;
+    uint64_t maxSkewUs = 0;
+
+    while ((i < numExp) || (j < numGot))
+    {
+        if ((j == numGot) ||
+            ((i < numExp) && (pExp[i].timeUs + toleranceUs < pGot[j].timeUs)))
+        {
+            missing++;
+            if (printed++ < REPLAY_MAX_PRINTED)
+            {
+                Replay_printDiff("missing", &pExp[i], NULL);
+            }
+            i++;
+        }
+        else if ((i == numExp) ||
+                 (pGot[j].timeUs + toleranceUs < pExp[i].timeUs))
+        {
+            extra++;
+            if (printed++ < REPLAY_MAX_PRINTED)
+            {
+                Replay_printDiff("extra", NULL, &pGot[j]);
+            }
+            j++;
+        }
+        else
+        {
+            uint64_t skewUs = (pExp[i].timeUs > pGot[j].timeUs) ?
+                              pExp[i].timeUs - pGot[j].timeUs :
+                              pGot[j].timeUs - pExp[i].timeUs;
+
+            maxSkewUs = MAX(maxSkewUs, skewUs);
+
+            if (Replay_same(&pExp[i], &pGot[j]))
+            {
+                matched++;
+            }
+            else
+            {
+                differ++;
+                if (printed++ < REPLAY_MAX_PRINTED)
+                {
+                    Replay_printDiff("differs", &pExp[i], &pGot[j]);
+                }
+            }
+            i++;
+            j++;
+        }
+    }
+
+    if (printed > REPLAY_MAX_PRINTED)
+    {
+        printf("... %u more differences\n", printed - REPLAY_MAX_PRINTED);
+    }
+
+    printf("reports: trace %u replay %u matched %u differ %u missing %u "
+           "extra %u max skew %.3f ms\n", numExp, numGot, matched, differ,
+           missing, extra, maxSkewUs / 1000.0);
+
+    return differ + missing + extra;
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Replay a trace.
+ *
+ * @return  0 when the reports match, 1 when not, 2 on a bad trace
+ */
+int main(int argc, char *argv[])
+{
+    const char *pOutName = NULL;
+    uint64_t toleranceUs = REPLAY_DEFAULT_TOLERANCE_MS * 1000;
+    bool printOnly = false;
+    uint8_t *pTrace;
+    uint32_t len;
+    simTraceRec_t *pRecs;
+    uint32_t numRecs;
+    simTraceRec_t *pGotRecs;
+    uint32_t numGotRecs;
+    simTraceRec_t *pExp;
+    simTraceRec_t *pGot;
+    uint32_t numExp;
+    uint32_t numGot;
+    uint32_t numSession;
+    replaySends_t expSends;
+    replaySends_t gotSends;
+    uint32_t expLost;
+    uint32_t gotLost;
+    uint64_t endUs;
+    uint32_t diffs;
+    int i;
+
+    simLogMask = 0;
+
+    for (i = 1; (i < argc) && (argv[i][0] == '-'); i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            simLogMask = SIM_LOG_DEFAULT | SIM_LOG_DISPLAY;
+        }
+        else if (strcmp(argv[i], "-p") == 0)
+        {
+            printOnly = true;
+        }
+        else if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc))
+        {
+            toleranceUs = strtoull(argv[++i], NULL, 0) * 1000;
+        }
+        else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc))
+        {
+            pOutName = argv[++i];
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (i != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-v] [-p] [-t tolerance] [-o replay] "
+                "TRACE\n", argv[0]);
+        return 2;
+    }
+
+    if (SimTrace_load(argv[i], &pTrace, &len))
+    {
+        return 2;
+    }
+
+    // A capture may end in the middle of a record, replay up to it
+    if (SimTrace_decode(pTrace, len, &pRecs, &numRecs) && (numRecs > 0))
+    {
+        printf("warning: trace cut after %.3f ms\n",
+               pRecs[numRecs - 1].timeUs / 1000.0);
+    }
+
+    if (numRecs == 0)
+    {
+        fprintf(stderr, "%s: not a valid trace\n", argv[i]);
+        return 2;
+    }
+
+    if (printOnly)
+    {
+        uint32_t r;
+
+        for (r = 0; r < numRecs; r++)
+        {
+            SimTrace_print(stdout, &pRecs[r]);
+        }
+
+        return 0;
+    }
+
+    numSession = Replay_schedule(pRecs, numRecs);
+    if (numSession < numRecs)
+    {
+        printf("device restarted at %.3f ms, replaying up to there\n",
+               pRecs[numSession].timeUs / 1000.0);
+    }
+
+    // Replay up to the last record of the session, and the reports up to
+    // the tolerance after it
+    endUs = pRecs[numSession - 1].timeUs - pRecs[0].timeUs;
+
+    SimTrace_capture();
+
+    // As main() on the target, HidDev runs in the application task
+    HidGameController_createTask();
+
+    SimRtos_run(Replay_ticks(endUs + toleranceUs));
+
+    len = SimTrace_collect(&pTrace);
+
+    if (pOutName && SimTrace_save(pOutName, pTrace, len))
+    {
+        return 2;
+    }
+
+    if (SimTrace_decode(pTrace, len, &pGotRecs, &numGotRecs) ||
+        (numGotRecs == 0))
+    {
+        fprintf(stderr, "replay trace not valid\n");
+        return 2;
+    }
+
+    numExp = Replay_reports(pRecs, numSession, endUs, &pExp, &expSends,
+                            &expLost);
+    numGot = Replay_reports(pGotRecs, numGotRecs, endUs + toleranceUs, &pGot,
+                            &gotSends, &gotLost);
+
+    if (expLost > 0)
+    {
+        printf("warning: %u records lost in the trace, the replay may "
+               "differ\n", expLost);
+    }
+
+    if (gotLost > 0)
+    {
+        printf("warning: %u records lost in the replay, raise "
+               "INPUT_TRACE_BUF_SIZE\n", gotLost);
+    }
+
+    diffs = Replay_compare(pExp, numExp, pGot, numGot, toleranceUs);
+
+    printf("sends: trace ok %u failed %u, replay ok %u failed %u\n",
+           expSends.ok, expSends.failed, gotSends.ok, gotSends.failed);
+
+    return (diffs > 0) ? 1 : 0;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+ @file       memreport.py
+
+ @brief Host-side report for the memory diagnostic characteristic (0xFFB2)
+        of the BLE Game Controller.
+
+ Project: BLE Game Controller
+ Modification Details : Decode memory monitor records captured from the
+                        diagnostic service and summarize the RAM margins.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+
+ Usage:
+   memreport.py [LOGFILE]
+
+ Every input line that holds 20 hex bytes (as copied from a BLE client or a
+ sniffer log, separated by spaces, colons or dashes, with or without 0x) is
+ one record. Lines that do not parse are ignored. The report shows the last
+ record and the worst values seen across all records.
+"""
+
+import re
+import struct
+import sys
+
+# Layout of the record, see MEMMON_REC_* in Application/memmonitor.h
+RECORD_LEN = 20
+RECORD_FMT = "<HHHHHBB4H"
+STACK_NAMES = ("ISR", "GAPRole", "HidDev", "App")
+
+# Margin of a stack that does not exist (MEMMON_STACK_ABSENT), e.g. the
+# HidDev stack in the single-task build
+STACK_ABSENT = 0xFFFF
+
+# Margins below these values are flagged
+STACK_MARGIN_WARN = 64
+HEAP_MIN_FREE_WARN = 512
+
+
+def parse_record(line):
+    """Return the decoded record of a line, or None."""
+    tokens = re.findall(r"(?:0x)?([0-9a-fA-F]{2})(?![0-9a-fA-F])", line)
+    if len(tokens) < RECORD_LEN:
+        return None
+
+    data = bytes(int(t, 16) for t in tokens[-RECORD_LEN:])
+    fields = struct.unpack(RECORD_FMT, data)
+
+    return {
+        "heap_size": fields[0],
+        "heap_free": fields[1],
+        "heap_min_free": fields[2],
+        "heap_largest": fields[3],
+        "alloc_failures": fields[4],
+        "pool_high_water": fields[5],
+        "pool_fallbacks": fields[6],
+        "stack_margin": fields[7:11],
+    }
+
+
+def report(records):
+    last = records[-1]
+    min_free = min(r["heap_min_free"] for r in records)
+    min_largest = min(r["heap_largest"] for r in records)
+    failures = max(r["alloc_failures"] for r in records)
+    pool_high = max(r["pool_high_water"] for r in records)
+    fallbacks = max(r["pool_fallbacks"] for r in records)
+    margins = [min(r["stack_margin"][i] for r in records)
+               for i in range(len(STACK_NAMES))]
+
+    print("Records:               %d" % len(records))
+    print("Heap size:             %d" % last["heap_size"])
+    print("Heap free (last):      %d" % last["heap_free"])
+    print("Heap free (lowest):    %d" % min_free)
+    print("Largest block (worst): %d" % min_largest)
+    print("Allocation failures:   %d" % failures)
+    print("Message pool peak:     %d blocks, %d heap fallbacks"
+          % (pool_high, fallbacks))
+    print()
+    print("%-8s %12s" % ("Stack", "Unused bytes"))
+    for name, margin in zip(STACK_NAMES, margins):
+        if margin == STACK_ABSENT:
+            print("%-8s %12s" % (name, "-"))
+            continue
+        flag = "  LOW" if margin < STACK_MARGIN_WARN else ""
+        print("%-8s %12d%s" % (name, margin, flag))
+    print()
+
+    warnings = []
+    if failures:
+        warnings.append("allocations failed, the heap is too small")
+    if min_free < HEAP_MIN_FREE_WARN:
+        warnings.append("heap low-water mark below %d bytes" % HEAP_MIN_FREE_WARN)
+    if min_free and min_largest * 2 < min_free:
+        warnings.append("free heap is fragmented (largest block < half free)")
+    if fallbacks:
+        warnings.append("message pool exhausted, raise UTIL_MSG_POOL_BLOCKS")
+
+    for w in warnings:
+        print("WARNING: " + w)
+
+    # Stack sizes can shrink by the unused bytes less a safety margin,
+    # rounded down to the 8 byte multiple the task stacks need
+    for name, margin in zip(STACK_NAMES, margins):
+        spare = (margin - STACK_MARGIN_WARN) // 8 * 8
+        if spare > 0 and margin != STACK_ABSENT:
+            print("%s stack can shrink by up to %d bytes" % (name, spare))
+
+    return 1 if warnings else 0
+
+
+def main(argv):
+    stream = open(argv[1]) if len(argv) > 1 else sys.stdin
+    records = [r for r in (parse_record(l) for l in stream) if r is not None]
+
+    if not records:
+        print("No memory records found")
+        return 2
+
+    return report(records)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
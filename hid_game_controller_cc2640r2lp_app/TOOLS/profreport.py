@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""
+ @file       profreport.py
+
+ @brief Host-side report for the profile diagnostic characteristic (0xFFB4)
+        of the BLE Game Controller.
+
+ Project: BLE Game Controller
+ Modification Details : Decode profiling probe records captured from the
+                        diagnostic service and tabulate the run times of the
+                        hot paths.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+
+ Usage:
+   profreport.py [LOGFILE]
+
+ Every input line that holds 19 hex bytes (as copied from a BLE client or a
+ sniffer log, separated by spaces, colons or dashes, with or without 0x) is
+ one record. Lines that do not parse are ignored. The statistics of a probe
+ are cumulative, the last record of each probe is reported, in the layout
+ the host simulation prints at the end of a PROF_PROBES run
+ (make -C hostsim profile).
+"""
+
+import re
+import struct
+import sys
+
+# Layout of the record, see PROF_REC_* in Application/profprobe.h
+RECORD_LEN = 19
+RECORD_FMT = "<BHIIII"
+PROBE_NAMES = ("joystick", "sendReport", "hidReport", "sendNoti", "keyIsr",
+               "appTask", "hidDevEvt", "lcdSlice")
+
+
+def parse_record(line):
+    """Return the decoded record of a line, or None."""
+    tokens = re.findall(r"(?:0x)?([0-9a-fA-F]{2})(?![0-9a-fA-F])", line)
+    if len(tokens) < RECORD_LEN:
+        return None
+
+    data = bytes(int(t, 16) for t in tokens[-RECORD_LEN:])
+    fields = struct.unpack(RECORD_FMT, data)
+
+    record = {
+        "probe": fields[0],
+        "ticks_per_us": fields[1],
+        "count": fields[2],
+        "min": fields[3],
+        "max": fields[4],
+        "mean": fields[5],
+    }
+
+    # Other diagnostic records can hold as many bytes, keep the consistent
+    if (record["probe"] >= len(PROBE_NAMES) or record["ticks_per_us"] == 0
+            or record["count"] == 0
+            or not record["min"] <= record["mean"] <= record["max"]):
+        return None
+
+    return record
+
+
+def report(records):
+    last = {}
+    for r in records:
+        last[r["probe"]] = r
+
+    print("Records: %d" % len(records))
+    print()
+    print("%-12s %10s %10s %10s %10s" % ("probe", "runs", "min us", "mean us",
+                                         "max us"))
+    for probe in sorted(last):
+        r = last[probe]
+        scale = float(r["ticks_per_us"])
+        print("%-12s %10d %10.3f %10.3f %10.3f"
+              % (PROBE_NAMES[probe], r["count"], r["min"] / scale,
+                 r["mean"] / scale, r["max"] / scale))
+
+    return 0
+
+
+def main(argv):
+    stream = open(argv[1]) if len(argv) > 1 else sys.stdin
+    records = [r for r in (parse_record(l) for l in stream) if r is not None]
+
+    if not records:
+        print("No profile records found")
+        return 2
+
+    return report(records)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
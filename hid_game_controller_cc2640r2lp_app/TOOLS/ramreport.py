@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+ @file       ramreport.py
+
+ @brief Build-time RAM report for the GATT services of the BLE Game
+        Controller.
+
+ Project: BLE Game Controller
+ Modification Details : Report the RAM each service uses and reclaims with
+                        the CCCD arena and the flash-resident attribute
+                        values, from the linker map of a build.
+ Device Setup: TI CC2640R2F Launchpad + Educational BoosterPack MKII
+
+ Usage:
+   ramreport.py MAPFILE [BASELINE_MAPFILE] [--conns N]
+
+ MAPFILE is the TI linker map of the build, e.g.
+ FlashROM_StackLibrary/hid_game_controller_cc2640r2lp_app.map. With a
+ BASELINE_MAPFILE from a build before a change, the static RAM (rw data)
+ difference of each service is reported as well. N is the number of
+ connections the CCCD tables hold, MAX_NUM_BLE_CONNS of the stack
+ (default 1).
+
+ CCCD tables used to be allocated from the heap; the heap cost of each
+ table is estimated from HEAP_BLOCK_OVERHEAD and HEAP_ALIGN below.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# Service module, CCCD count macro in PROFILES/cccdarena.h
+SERVICES = (
+    ("hidkbdservice", "CCCD_ARENA_HIDKBD"),
+    ("battservice", "CCCD_ARENA_BATT"),
+    ("scanparamservice", "CCCD_ARENA_SCANPARAM"),
+    ("diagservice", "CCCD_ARENA_DIAG"),
+)
+ARENA_MODULE = "cccdarena"
+
+# sizeof(gattCharCfg_t): connection handle and value
+CCCD_ENTRY_SIZE = 4
+
+# Heap block header and alignment of ICall_malloc
+HEAP_BLOCK_OVERHEAD = 8
+HEAP_ALIGN = 8
+
+ARENA_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                            os.pardir, "PROFILES", "cccdarena.h")
+
+MODULE_LINE = re.compile(r"^\s+(\S+)\.obj\s+(\d+)\s+(\d+)\s+(\d+)\s*$")
+
+
+def read_map(path):
+    """Return {module: rw data bytes} from the MODULE SUMMARY of a map."""
+    modules = {}
+    in_summary = False
+
+    with open(path) as f:
+        for line in f:
+            if line.startswith("MODULE SUMMARY"):
+                in_summary = True
+                continue
+            if not in_summary:
+                continue
+            if line.startswith("GLOBAL SYMBOLS") or \
+               line.startswith("SEGMENT ALLOCATION MAP"):
+                break
+            m = MODULE_LINE.match(line)
+            if m:
+                modules[m.group(1)] = int(m.group(4))
+
+    return modules
+
+
+def read_cccd_counts(path):
+    """Return {macro: count} of the service list in cccdarena.h."""
+    counts = {}
+
+    with open(path) as f:
+        for line in f:
+            m = re.match(r"#define\s+(CCCD_ARENA_\w+)\s+(\d+)\b", line)
+            if m:
+                counts[m.group(1)] = int(m.group(2))
+
+    return counts
+
+
+def heap_block(size):
+    """Heap bytes taken by an allocation of size bytes."""
+    size += HEAP_BLOCK_OVERHEAD
+    return (size + HEAP_ALIGN - 1) // HEAP_ALIGN * HEAP_ALIGN
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Service RAM report")
+    parser.add_argument("mapfile")
+    parser.add_argument("baseline", nargs="?")
+    parser.add_argument("--conns", type=int, default=1)
+    args = parser.parse_args(argv[1:])
+
+    conns = args.conns
+    current = read_map(args.mapfile)
+    baseline = read_map(args.baseline) if args.baseline else None
+    counts = read_cccd_counts(ARENA_HEADER)
+
+    table = CCCD_ENTRY_SIZE * conns
+
+    print("%-18s %6s %6s %8s %8s %8s" % ("Service", "RW", "CCCDs",
+                                         "Heap", "Static", "Saved"))
+
+    total = 0
+    for module, macro in SERVICES:
+        rw = current.get(module)
+        if rw is None:
+            continue
+
+        cccds = counts.get(macro, 0)
+        heap_avoided = cccds * heap_block(table)
+        arena_share = cccds * table
+        saved = heap_avoided - arena_share
+
+        # Static RAM change, e.g. attribute values moved to flash
+        static = "-"
+        if baseline is not None and module in baseline:
+            static = baseline[module] - rw
+            saved += static
+
+        total += saved
+        print("%-18s %6d %6d %8d %8s %8d" % (module, rw, cccds, heap_avoided,
+                                             static, saved))
+
+    arena = current.get(ARENA_MODULE)
+    if arena is not None:
+        print("%-18s %6d" % (ARENA_MODULE, arena))
+
+    print()
+    print("RW: static RAM of the module. CCCDs: tables in the arena.")
+    print("Heap: heap no longer allocated for them. Static: static RAM")
+    print("saved against the baseline. Saved: total RAM reclaimed.")
+    print()
+    print("Total reclaimed: %d bytes (%d connection%s)"
+          % (total, conns, "" if conns == 1 else "s"))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))